@@ -107,6 +107,8 @@ if(UNIX)
 	check_symbol_exists("strerrorname_np" "string.h" HAVE_STRERRORNAME_NP)
 	check_symbol_exists("strptime"      "time.h"     HAVE_STRPTIME)
 	check_symbol_exists("vasprintf"     "stdio.h"    HAVE_VASPRINTF)
+	check_symbol_exists("pwritev"       "sys/uio.h"  HAVE_PWRITEV)
+	check_symbol_exists("memfd_create"  "sys/mman.h" HAVE_MEMFD_CREATE)
 	cmake_pop_check_state()
 endif()
 
@@ -145,18 +145,7 @@ static gboolean cap_file_hashes    = TRUE;  /* Calculate file hashes */
 #define HASH_SIZE_SHA1   20
 
 #define HASH_STR_SIZE (65) /* Max hash size * 2 + '\0' */
-#define HASH_BUF_SIZE (1024 * 1024)
-
-
-static gchar file_sha256[HASH_STR_SIZE];
-static gchar file_sha1[HASH_STR_SIZE];
-
-static char  *hash_buf = NULL;
-static gcry_md_hd_t hd = NULL;
-
-static guint num_ipv4_addresses;
-static guint num_ipv6_addresses;
-static guint num_decryption_secrets;
+#define HASH_BUF_SIZE (4 * 1024 * 1024)
 
 /*
  * If we have at least two packets with time stamps, and they're not in
@@ -217,8 +206,47 @@ typedef struct _capture_info {
     GArray               *interface_packet_counts;  /* array of per_packet interface_id counts; one entry per file IDB */
     guint32               pkt_interface_id_unknown; /* counts if packet interface_id didn't match a known one */
     GArray               *idb_info_strings;         /* array of IDB info strings */
+
+    gchar                 file_sha256[HASH_STR_SIZE];
+    gchar                 file_sha1[HASH_STR_SIZE];
+
+    guint                 num_ipv4_addresses;
+    guint                 num_ipv6_addresses;
+    guint                 num_decryption_secrets;
+
+    GString              *errors;                   /* messages held until the file is printed */
 } capture_info;
 
+/*
+ * Files are processed in a pool of threads. The wiretap callbacks that
+ * count addresses and secrets don't take a user pointer, so each thread
+ * keeps the file it's working on here.
+ */
+static GPrivate current_cf_info = G_PRIVATE_INIT(NULL);
+
+/*
+ * A file being processed. Files are printed in command line order as
+ * soon as each one and all the files before it are done.
+ */
+typedef struct _capinfos_job {
+    const char   *filename;
+    capture_info  cf_info;
+    int           status;
+    gboolean      done;
+} capinfos_job;
+
+static GMutex jobs_mutex;
+static GCond  jobs_cond;
+
+/*
+ * Opening a file goes through the open routine table and some readers'
+ * open routines keep state in static variables, and wtap_strerror()
+ * formats unknown errors into a static buffer, so only one thread at a
+ * time opens a file or reports a wiretap error. Reading the records
+ * of different files isn't covered by it.
+ */
+static GMutex wtap_mutex;
+
 static char *decimal_point;
 
 static void
@@ -591,8 +619,8 @@ print_stats(const gchar *filename, capture_info *cf_info)
         }
     }
     if (cap_file_hashes) {
-        printf     ("SHA256:              %s\n", file_sha256);
-        printf     ("SHA1:                %s\n", file_sha1);
+        printf     ("SHA256:              %s\n", cf_info->file_sha256);
+        printf     ("SHA1:                %s\n", cf_info->file_sha1);
     }
     if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
 
@@ -656,14 +684,14 @@ print_stats(const gchar *filename, capture_info *cf_info)
         }
 
         if (cap_file_nrb) {
-            if (num_ipv4_addresses != 0)
-                printf   ("Number of resolved IPv4 addresses in file: %u\n", num_ipv4_addresses);
-            if (num_ipv6_addresses != 0)
-                printf   ("Number of resolved IPv6 addresses in file: %u\n", num_ipv6_addresses);
+            if (cf_info->num_ipv4_addresses != 0)
+                printf   ("Number of resolved IPv4 addresses in file: %u\n", cf_info->num_ipv4_addresses);
+            if (cf_info->num_ipv6_addresses != 0)
+                printf   ("Number of resolved IPv6 addresses in file: %u\n", cf_info->num_ipv6_addresses);
         }
         if (cap_file_dsb) {
-            if (num_decryption_secrets != 0)
-                printf   ("Number of decryption secrets in file: %u\n", num_decryption_secrets);
+            if (cf_info->num_decryption_secrets != 0)
+                printf   ("Number of decryption secrets in file: %u\n", cf_info->num_decryption_secrets);
         }
     }
 }
@@ -896,12 +924,12 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     if (cap_file_hashes) {
         putsep();
         putquote();
-        printf("%s", file_sha256);
+        printf("%s", cf_info->file_sha256);
         putquote();
 
         putsep();
         putquote();
-        printf("%s", file_sha1);
+        printf("%s", cf_info->file_sha1);
         putquote();
     }
 
@@ -1024,21 +1052,24 @@ cleanup_capture_info(capture_info *cf_info)
 static void
 count_ipv4_address(const guint addr _U_, const gchar *name _U_, const gboolean static_entry _U_)
 {
-    num_ipv4_addresses++;
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
+    cf_info->num_ipv4_addresses++;
 }
 
 static void
 count_ipv6_address(const void *addrp _U_, const gchar *name _U_, const gboolean static_entry _U_)
 {
-    num_ipv6_addresses++;
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
+    cf_info->num_ipv6_addresses++;
 }
 
 static void
 count_decryption_secret(guint32 secrets_type _U_, const void *secrets _U_, guint size _U_)
 {
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
     /* XXX - count them based on the secrets type (which is an opaque code,
        not a small integer)? */
-    num_decryption_secrets++;
+    cf_info->num_decryption_secrets++;
 }
 
 static void
@@ -1051,32 +1082,121 @@ hash_to_str(const unsigned char *hash, size_t length, char *str)
     }
 }
 
+/*
+ * Hashes of the raw file. They're fed the bytes wiretap reads for the
+ * infos, so the file is only read once; whatever wiretap doesn't read
+ * in order (what it read while opening the file, anything it seeks
+ * past, data after the last record) is read from our own handle.
+ */
+typedef struct {
+    const char   *filename;
+    gcry_md_hd_t  hd;
+    gint64        hashed;   /* Length of the prefix hashed so far */
+    FILE         *fh;
+    gboolean      failed;
+} hash_state_t;
+
+static void
+hash_file_up_to(hash_state_t *hs, gint64 end)
+{
+    char   *hash_buf;
+    size_t  to_read;
+    size_t  hash_bytes;
+
+    if (hs->failed)
+        return;
+    if (!hs->fh && (hs->fh = ws_fopen(hs->filename, "rb")) == NULL) {
+        hs->failed = TRUE;
+        return;
+    }
+    if (ws_fseek64(hs->fh, hs->hashed, SEEK_SET) != 0) {
+        hs->failed = TRUE;
+        return;
+    }
+    hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
+    while (end < 0 || hs->hashed < end) {
+        to_read = HASH_BUF_SIZE;
+        if (end >= 0 && end - hs->hashed < (gint64)to_read)
+            to_read = (size_t)(end - hs->hashed);
+        hash_bytes = fread(hash_buf, 1, to_read, hs->fh);
+        if (hash_bytes == 0) {
+            if (ferror(hs->fh))
+                hs->failed = TRUE;
+            break;
+        }
+        gcry_md_write(hs->hd, hash_buf, hash_bytes);
+        hs->hashed += hash_bytes;
+    }
+    g_free(hash_buf);
+}
+
 static void
-calculate_hashes(const char *filename)
+hash_raw_data(gint64 offset, const guint8 *data, size_t len, void *user_data)
 {
-    FILE  *fh;
-    size_t hash_bytes;
+    hash_state_t *hs = (hash_state_t *)user_data;
+    size_t        skip;
+
+    if (hs->hashed < offset)
+        hash_file_up_to(hs, offset);
+    if (hs->failed || hs->hashed < offset)
+        return;
+    if (offset + (gint64)len <= hs->hashed)
+        return;     /* Read again after a seek back */
+    skip = (size_t)(hs->hashed - offset);
+    gcry_md_write(hs->hd, data + skip, len - skip);
+    hs->hashed = offset + (gint64)len;
+}
 
-    (void) g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    (void) g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
+/*
+ * Hash what's left after the last record and fill in the hashes.
+ */
+static void
+finish_hashes(hash_state_t *hs, capture_info *cf_info)
+{
+    hash_file_up_to(hs, -1);
+    if (!hs->failed) {
+        gcry_md_final(hs->hd);
+        hash_to_str(gcry_md_read(hs->hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, cf_info->file_sha256);
+        hash_to_str(gcry_md_read(hs->hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, cf_info->file_sha1);
+    }
+    gcry_md_close(hs->hd);
+    if (hs->fh) fclose(hs->fh);
+}
 
-    if (cap_file_hashes) {
-        fh = ws_fopen(filename, "rb");
-        if (fh && hd) {
-            while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
-                gcry_md_write(hd, hash_buf, hash_bytes);
-            }
-            gcry_md_final(hd);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
-        }
-        if (fh) fclose(fh);
-        if (hd) gcry_md_reset(hd);
+/*
+ * Hold a message for the file being processed until its infos are
+ * printed.
+ */
+static void G_GNUC_PRINTF(2, 3)
+file_error(capture_info *cf_info, const char *msg_format, ...)
+{
+    va_list ap;
+
+    va_start(ap, msg_format);
+    g_string_append_vprintf(cf_info->errors, msg_format, ap);
+    va_end(ap);
+}
+
+/*
+ * Write out the messages held for a file, in command line order.
+ */
+static void
+flush_file_errors(capture_info *cf_info)
+{
+    if (cf_info->errors) {
+        fputs(cf_info->errors->str, stderr);
+        g_string_free(cf_info->errors, TRUE);
+        cf_info->errors = NULL;
     }
 }
 
+/*
+ * Gather the infos for a file. On success (or a short read) the file is
+ * left open for print_cap_file(). Takes wtap_mutex only around the
+ * calls that need it.
+ */
 static int
-process_cap_file(const char *filename, gboolean need_separator)
+process_cap_file(const char *filename, capture_info *cf_info)
 {
     int                   status = 0;
     int                   err;
@@ -1090,7 +1210,8 @@ process_cap_file(const char *filename, gboolean need_separator)
     guint32               snaplen_max_inferred =          0;
     wtap_rec              rec;
     Buffer                buf;
-    capture_info          cf_info;
+    hash_state_t          hash_state;
+    gboolean              hashing = FALSE;
     gboolean              have_times = TRUE;
     nstime_t              start_time;
     int                   start_time_tsprec;
@@ -1105,21 +1226,35 @@ process_cap_file(const char *filename, gboolean need_separator)
 
     pkt_cmt *pc = NULL, *prev = NULL;
 
-    cf_info.wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
-    if (!cf_info.wth) {
+    memset(cf_info, 0, sizeof *cf_info);
+    cf_info->filename = filename;
+    cf_info->errors = g_string_new(NULL);
+    g_private_set(&current_cf_info, cf_info);
+
+    g_mutex_lock(&wtap_mutex);
+    cf_info->wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+    if (!cf_info->wth) {
         cfile_open_failure_message(filename, err, err_info);
+        g_mutex_unlock(&wtap_mutex);
         return 2;
     }
+    g_mutex_unlock(&wtap_mutex);
 
     /*
      * Calculate the checksums. Do this after wtap_open_offline, so we don't
      * bother calculating them for files that are not known capture types
      * where we wouldn't print them anyway.
      */
-    calculate_hashes(filename);
-
-    if (need_separator && long_report) {
-        printf("\n");
+    (void) g_strlcpy(cf_info->file_sha256, "<unknown>", HASH_STR_SIZE);
+    (void) g_strlcpy(cf_info->file_sha1, "<unknown>", HASH_STR_SIZE);
+    if (cap_file_hashes) {
+        memset(&hash_state, 0, sizeof hash_state);
+        hash_state.filename = filename;
+        if (gcry_md_open(&hash_state.hd, GCRY_MD_SHA256, 0) == 0) {
+            gcry_md_enable(hash_state.hd, GCRY_MD_SHA1);
+            wtap_set_cb_raw_data(cf_info->wth, hash_raw_data, &hash_state);
+            hashing = TRUE;
+        }
     }
 
     nstime_set_zero(&start_time);
@@ -1129,36 +1264,31 @@ process_cap_file(const char *filename, gboolean need_separator)
     nstime_set_zero(&cur_time);
     nstime_set_zero(&prev_time);
 
-    cf_info.encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+    cf_info->encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
 
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
     ws_assert(idb_info->interface_data != NULL);
 
-    cf_info.pkt_cmts = NULL;
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    cf_info.interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info.num_interfaces);
-    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-    cf_info.pkt_interface_id_unknown = 0;
+    cf_info->pkt_cmts = NULL;
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    cf_info->interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info->num_interfaces);
+    g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
+    cf_info->pkt_interface_id_unknown = 0;
 
     g_free(idb_info);
     idb_info = NULL;
 
     /* Register callbacks for new name<->address maps from the file and
        decryption secrets from the file. */
-    wtap_set_cb_new_ipv4(cf_info.wth, count_ipv4_address);
-    wtap_set_cb_new_ipv6(cf_info.wth, count_ipv6_address);
-    wtap_set_cb_new_secrets(cf_info.wth, count_decryption_secret);
-
-    /* Zero out the counters for the callbacks. */
-    num_ipv4_addresses = 0;
-    num_ipv6_addresses = 0;
-    num_decryption_secrets = 0;
+    wtap_set_cb_new_ipv4(cf_info->wth, count_ipv4_address);
+    wtap_set_cb_new_ipv6(cf_info->wth, count_ipv6_address);
+    wtap_set_cb_new_secrets(cf_info->wth, count_decryption_secret);
 
     /* Tally up data that we need to parse through the file to find */
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
-    while (wtap_read(cf_info.wth, &rec, &buf, &err, &err_info, &data_offset))  {
+    while (wtap_read(cf_info->wth, &rec, &buf, &err, &err_info, &data_offset))  {
         if (rec.presence_flags & WTAP_HAS_TS) {
             prev_time = cur_time;
             cur_time = rec.ts;
@@ -1200,7 +1330,7 @@ process_cap_file(const char *filename, gboolean need_separator)
                 pc->next = NULL;
 
                 if (prev == NULL)
-                  cf_info.pkt_cmts = pc;
+                  cf_info->pkt_cmts = pc;
                 else
                   prev->next = pc;
 
@@ -1221,45 +1351,45 @@ process_cap_file(const char *filename, gboolean need_separator)
 
             if ((rec.rec_header.packet_header.pkt_encap > 0) &&
                     (rec.rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-                cf_info.encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
+                cf_info->encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
             } else {
-                fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
+                file_error(cf_info, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
                         rec.rec_header.packet_header.pkt_encap, packet, filename);
             }
 
             /* Packet interface_id info */
             if (rec.presence_flags & WTAP_HAS_INTERFACE_ID) {
-                /* cf_info.num_interfaces is size, not index, so it's one more than max index */
-                if (rec.rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
+                /* cf_info->num_interfaces is size, not index, so it's one more than max index */
+                if (rec.rec_header.packet_header.interface_id >= cf_info->num_interfaces) {
                     /*
                      * OK, re-fetch the number of interfaces, as there might have
                      * been an interface that was in the middle of packets, and
                      * grow the array to be big enough for the new number of
                      * interfaces.
                      */
-                    idb_info = wtap_file_get_idb_info(cf_info.wth);
+                    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-                    cf_info.num_interfaces = idb_info->interface_data->len;
-                    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
+                    cf_info->num_interfaces = idb_info->interface_data->len;
+                    g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
 
                     g_free(idb_info);
                     idb_info = NULL;
                 }
-                if (rec.rec_header.packet_header.interface_id < cf_info.num_interfaces) {
-                    g_array_index(cf_info.interface_packet_counts, guint32,
+                if (rec.rec_header.packet_header.interface_id < cf_info->num_interfaces) {
+                    g_array_index(cf_info->interface_packet_counts, guint32,
                             rec.rec_header.packet_header.interface_id) += 1;
                 }
                 else {
-                    cf_info.pkt_interface_id_unknown += 1;
+                    cf_info->pkt_interface_id_unknown += 1;
                 }
             }
             else {
                 /* it's for interface_id 0 */
-                if (cf_info.num_interfaces != 0) {
-                    g_array_index(cf_info.interface_packet_counts, guint32, 0) += 1;
+                if (cf_info->num_interfaces != 0) {
+                    g_array_index(cf_info->interface_packet_counts, guint32, 0) += 1;
                 }
                 else {
-                    cf_info.pkt_interface_id_unknown += 1;
+                    cf_info->pkt_interface_id_unknown += 1;
                 }
             }
         }
@@ -1269,6 +1399,11 @@ process_cap_file(const char *filename, gboolean need_separator)
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
 
+    if (hashing) {
+        wtap_set_cb_raw_data(cf_info->wth, NULL, NULL);
+        finish_hashes(&hash_state, cf_info);
+    }
+
     /*
      * Get IDB info strings.
      * We do this at the end, so we can get information for all IDBs in
@@ -1276,118 +1411,147 @@ process_cap_file(const char *filename, gboolean need_separator)
      * we get, for example, a count of the number of statistics entries
      * for each interface as of the *end* of the file.
      */
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-    cf_info.idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info.num_interfaces);
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    for (i = 0; i < cf_info.num_interfaces; i++) {
+    cf_info->idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info->num_interfaces);
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    for (i = 0; i < cf_info->num_interfaces; i++) {
         const wtap_block_t if_descr = g_array_index(idb_info->interface_data, wtap_block_t, i);
         gchar *s = wtap_get_debug_if_descr(if_descr, 21, "\n");
-        g_array_append_val(cf_info.idb_info_strings, s);
+        g_array_append_val(cf_info->idb_info_strings, s);
     }
 
     g_free(idb_info);
     idb_info = NULL;
 
     if (err != 0) {
-        fprintf(stderr,
+        file_error(cf_info,
                 "capinfos: An error occurred after reading %u packets from \"%s\".\n",
                 packet, filename);
+        g_mutex_lock(&wtap_mutex);
         cfile_read_failure_message(filename, err, err_info);
+        g_mutex_unlock(&wtap_mutex);
         if (err == WTAP_ERR_SHORT_READ) {
             /* Don't give up completely with this one. */
             status = 1;
-            fprintf(stderr,
+            file_error(cf_info,
                     "  (will continue anyway, checksums might be incorrect)\n");
         } else {
-            cleanup_capture_info(&cf_info);
-            wtap_close(cf_info.wth);
+            cleanup_capture_info(cf_info);
+            wtap_close(cf_info->wth);
             return 2;
         }
     }
 
     /* File size */
-    size = wtap_file_size(cf_info.wth, &err);
+    size = wtap_file_size(cf_info->wth, &err);
     if (size == -1) {
-        fprintf(stderr,
+        file_error(cf_info,
                 "capinfos: Can't get size of \"%s\": %s.\n",
                 filename, g_strerror(err));
-        cleanup_capture_info(&cf_info);
-        wtap_close(cf_info.wth);
+        cleanup_capture_info(cf_info);
+        wtap_close(cf_info->wth);
         return 2;
     }
 
-    cf_info.filesize = size;
+    cf_info->filesize = size;
 
     /* File Type */
-    cf_info.file_type = wtap_file_type_subtype(cf_info.wth);
-    cf_info.compression_type = wtap_get_compression_type(cf_info.wth);
+    cf_info->file_type = wtap_file_type_subtype(cf_info->wth);
+    cf_info->compression_type = wtap_get_compression_type(cf_info->wth);
 
     /* File Encapsulation */
-    cf_info.file_encap = wtap_file_encap(cf_info.wth);
+    cf_info->file_encap = wtap_file_encap(cf_info->wth);
 
-    cf_info.file_tsprec = wtap_file_tsprec(cf_info.wth);
+    cf_info->file_tsprec = wtap_file_tsprec(cf_info->wth);
 
     /* Packet size limit (snaplen) */
-    cf_info.snaplen = wtap_snapshot_length(cf_info.wth);
-    if (cf_info.snaplen > 0)
-        cf_info.snap_set = TRUE;
+    cf_info->snaplen = wtap_snapshot_length(cf_info->wth);
+    if (cf_info->snaplen > 0)
+        cf_info->snap_set = TRUE;
     else
-        cf_info.snap_set = FALSE;
+        cf_info->snap_set = FALSE;
 
-    cf_info.snaplen_min_inferred = snaplen_min_inferred;
-    cf_info.snaplen_max_inferred = snaplen_max_inferred;
+    cf_info->snaplen_min_inferred = snaplen_min_inferred;
+    cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
     /* # of packets */
-    cf_info.packet_count = packet;
+    cf_info->packet_count = packet;
 
     /* File Times */
-    cf_info.times_known = have_times;
-    cf_info.start_time = start_time;
-    cf_info.start_time_tsprec = start_time_tsprec;
-    cf_info.stop_time = stop_time;
-    cf_info.stop_time_tsprec = stop_time_tsprec;
-    nstime_delta(&cf_info.duration, &stop_time, &start_time);
+    cf_info->times_known = have_times;
+    cf_info->start_time = start_time;
+    cf_info->start_time_tsprec = start_time_tsprec;
+    cf_info->stop_time = stop_time;
+    cf_info->stop_time_tsprec = stop_time_tsprec;
+    nstime_delta(&cf_info->duration, &stop_time, &start_time);
     /* Duration precision is the higher of the start and stop time precisions. */
-    if (cf_info.stop_time_tsprec > cf_info.start_time_tsprec)
-        cf_info.duration_tsprec = cf_info.stop_time_tsprec;
+    if (cf_info->stop_time_tsprec > cf_info->start_time_tsprec)
+        cf_info->duration_tsprec = cf_info->stop_time_tsprec;
     else
-        cf_info.duration_tsprec = cf_info.start_time_tsprec;
-    cf_info.know_order = know_order;
-    cf_info.order = order;
+        cf_info->duration_tsprec = cf_info->start_time_tsprec;
+    cf_info->know_order = know_order;
+    cf_info->order = order;
 
     /* Number of packet bytes */
-    cf_info.packet_bytes = bytes;
+    cf_info->packet_bytes = bytes;
 
-    cf_info.data_rate   = 0.0;
-    cf_info.packet_rate = 0.0;
-    cf_info.packet_size = 0.0;
+    cf_info->data_rate   = 0.0;
+    cf_info->packet_rate = 0.0;
+    cf_info->packet_size = 0.0;
 
     if (packet > 0) {
         double delta_time = nstime_to_sec(&stop_time) - nstime_to_sec(&start_time);
         if (delta_time > 0.0) {
-            cf_info.data_rate   = (double)bytes  / delta_time; /* Data rate per second */
-            cf_info.packet_rate = (double)packet / delta_time; /* packet rate per second */
+            cf_info->data_rate   = (double)bytes  / delta_time; /* Data rate per second */
+            cf_info->packet_rate = (double)packet / delta_time; /* packet rate per second */
         }
-        cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+        cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
+    }
+
+    return status;
+}
+
+static void
+print_cap_file(capture_info *cf_info, gboolean need_separator)
+{
+    if (need_separator && long_report) {
+        printf("\n");
     }
 
     if (!long_report && table_report_header) {
-      print_stats_table_header(&cf_info);
+      print_stats_table_header(cf_info);
     }
 
     if (long_report) {
-        print_stats(filename, &cf_info);
+        print_stats(cf_info->filename, cf_info);
     } else {
-        print_stats_table(filename, &cf_info);
+        print_stats_table(cf_info->filename, cf_info);
     }
+    /* Report each file as soon as it's done */
+    fflush(stdout);
 
-    cleanup_capture_info(&cf_info);
-    wtap_close(cf_info.wth);
+    cleanup_capture_info(cf_info);
+    wtap_close(cf_info->wth);
+}
 
-    return status;
+static void
+process_cap_file_job(gpointer data, gpointer user_data _U_)
+{
+    capinfos_job *job = (capinfos_job *)data;
+    int status;
+
+    status = process_cap_file(job->filename, &job->cf_info);
+    g_private_set(&current_cf_info, NULL);
+
+    g_mutex_lock(&jobs_mutex);
+    job->status = status;
+    job->done = TRUE;
+    g_cond_broadcast(&jobs_cond);
+    g_mutex_unlock(&jobs_mutex);
 }
 
+
 static void
 print_usage(FILE *output)
 {
@@ -1464,6 +1628,15 @@ print_usage(FILE *output)
 static void
 capinfos_cmdarg_err(const char *msg_format, va_list ap)
 {
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
+
+    if (cf_info) {
+        /* Failures reading a file are held until it's printed */
+        g_string_append(cf_info->errors, "capinfos: ");
+        g_string_append_vprintf(cf_info->errors, msg_format, ap);
+        g_string_append_c(cf_info->errors, '\n');
+        return;
+    }
     fprintf(stderr, "capinfos: ");
     vfprintf(stderr, msg_format, ap);
     fprintf(stderr, "\n");
@@ -1475,6 +1648,13 @@ capinfos_cmdarg_err(const char *msg_format, va_list ap)
 static void
 capinfos_cmdarg_err_cont(const char *msg_format, va_list ap)
 {
+    capture_info *cf_info = (capture_info *)g_private_get(&current_cf_info);
+
+    if (cf_info) {
+        g_string_append_vprintf(cf_info->errors, msg_format, ap);
+        g_string_append_c(cf_info->errors, '\n');
+        return;
+    }
     vfprintf(stderr, msg_format, ap);
     fprintf(stderr, "\n");
 }
@@ -1497,6 +1677,12 @@ main(int argc, char *argv[])
     };
     gboolean need_separator = FALSE;
     int    opt;
+    int    num_files;
+    int    num_threads;
+    int    num_queued = 0;
+    int    file_idx;
+    capinfos_job *jobs;
+    GThreadPool *pool = NULL;
     int    overall_error_status = EXIT_SUCCESS;
     static const struct ws_option long_options[] = {
         {"help", ws_no_argument, NULL, 'h'},
@@ -1758,37 +1944,71 @@ main(int argc, char *argv[])
 
     if (cap_file_hashes) {
         gcry_check_version(NULL);
-        gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-        if (hd)
-            gcry_md_enable(hd, GCRY_MD_SHA1);
-
-        hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
     }
 
     overall_error_status = 0;
 
-    for (opt = ws_optind; opt < argc; opt++) {
+    num_files = argc - ws_optind;
+    jobs = g_new0(capinfos_job, num_files);
+    num_threads = MIN((int) g_get_num_processors(), num_files);
+    if (num_threads > 1) {
+        pool = g_thread_pool_new(process_cap_file_job, NULL, num_threads, TRUE, NULL);
+    }
 
-        status = process_cap_file(argv[opt], need_separator);
+    for (file_idx = 0; file_idx < num_files; file_idx++) {
+        /* Limit how many finished files are held open waiting to be printed. */
+        for (; num_queued < num_files && num_queued < file_idx + 2 * num_threads; num_queued++) {
+            jobs[num_queued].filename = argv[ws_optind + num_queued];
+            if (pool) {
+                g_thread_pool_push(pool, &jobs[num_queued], NULL);
+            }
+        }
+
+        if (pool) {
+            g_mutex_lock(&jobs_mutex);
+            while (!jobs[file_idx].done) {
+                g_cond_wait(&jobs_cond, &jobs_mutex);
+            }
+            g_mutex_unlock(&jobs_mutex);
+        } else {
+            process_cap_file_job(&jobs[file_idx], NULL);
+        }
+
+        status = jobs[file_idx].status;
+        flush_file_errors(&jobs[file_idx].cf_info);
+        if (status != 2) {
+            /* Either it succeeded or it got a "short read" but has
+               information to print anyway.  Note that we need a blank line
+               before the next file's information, to separate it from the
+               previous file. */
+            print_cap_file(&jobs[file_idx].cf_info, need_separator);
+            need_separator = TRUE;
+        }
         if (status) {
             /* Something failed.  It's been reported; remember that processing
                one file failed and, if -C was specified, stop. */
             overall_error_status = status;
             if (stop_after_failure)
-                goto exit;
+                break;
         }
-        if (status != 2) {
-            /* Either it succeeded or it got a "short read" but printed
-               information anyway.  Note that we need a blank line before
-               the next file's information, to separate it from the
-               previous file. */
-            need_separator = TRUE;
+    }
+
+    if (pool) {
+        /* Drop the files that haven't been started and wait for the rest */
+        g_thread_pool_free(pool, TRUE, TRUE);
+        for (file_idx++; file_idx < num_queued; file_idx++) {
+            if (jobs[file_idx].done && jobs[file_idx].status != 2) {
+                cleanup_capture_info(&jobs[file_idx].cf_info);
+                wtap_close(jobs[file_idx].cf_info.wth);
+            }
+            if (jobs[file_idx].cf_info.errors) {
+                g_string_free(jobs[file_idx].cf_info.errors, TRUE);
+            }
         }
     }
+    g_free(jobs);
 
 exit:
-    g_free(hash_buf);
-    gcry_md_close(hd);
     wtap_cleanup();
     free_progdirs();
     return overall_error_status;
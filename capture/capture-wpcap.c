@@ -60,6 +60,8 @@ static pcap_t* (*p_pcap_open_live) (const char *, int, int, int, char *);
 static int     (*p_pcap_loop) (pcap_t *, int, pcap_handler, unsigned char *);
 static pcap_t* (*p_pcap_open_dead) (int, int);
 static void    (*p_pcap_freecode) (struct bpf_program *);
+static int     (*p_pcap_offline_filter) (const struct bpf_program *,
+			const struct pcap_pkthdr *, const u_char *);
 static int     (*p_pcap_findalldevs) (pcap_if_t **, char *);
 static void    (*p_pcap_freealldevs) (pcap_if_t *);
 static int (*p_pcap_datalink_name_to_val) (const char *);
@@ -149,6 +151,7 @@ load_wpcap(void)
 #endif
 		SYM(pcap_loop, false),
 		SYM(pcap_freecode, false),
+		SYM(pcap_offline_filter, false),
 		SYM(pcap_findalldevs, false),
 		SYM(pcap_freealldevs, false),
 		SYM(pcap_datalink_name_to_val, false),
@@ -470,6 +473,14 @@ pcap_freecode(struct bpf_program *a)
 	p_pcap_freecode(a);
 }
 
+int
+pcap_offline_filter(const struct bpf_program *a, const struct pcap_pkthdr *b,
+    const u_char *c)
+{
+	ws_assert(has_wpcap);
+	return p_pcap_offline_filter(a, b, c);
+}
+
 int
 pcap_findalldevs(pcap_if_t **a, char *errbuf)
 {
@@ -18,6 +18,7 @@
 #endif
 
 #include "capture_opts.h"
+#include "capture/capture_shm.h"
 
 #include <epan/fifo_string_cache.h>
 #include <wsutil/processes.h>
@@ -107,6 +108,7 @@ struct _capture_session {
     Buffer buf;                           /**< Buffer we're reading packet data into */
     struct wtap *wtap;                    /**< current wtap file */
     struct _info_data *cap_data_info;     /**< stats for this capture */
+    capture_shm_t *shm;                   /**< if not NULL, ring through which the child hands over packets */
 
     // If the user wants to ignore duplicate frames, we need these.
     fifo_string_cache_t frame_dup_cache;
@@ -0,0 +1,327 @@
+/* capture_shm.c
+ * Shared-memory ring through which dumpcap hands captured packets to
+ * its parent
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#define _GNU_SOURCE     /* memfd_create() */
+#include <config.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <wireshark.h>
+
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <wsutil/file_util.h>
+
+#include "capture/capture_shm.h"
+
+/*
+ * The shared memory starts with a header, followed by the ring itself.
+ *
+ * The ring is a single-producer, single-consumer queue. head and tail
+ * count bytes consumed and produced since the ring was created, and wrap
+ * around at 2^32; their difference is the number of bytes in use. Only
+ * dumpcap writes tail, only the parent writes head, and each is written
+ * after the entries it covers, with a barrier, so neither side ever
+ * locks. They're on separate cache lines so that the two processes
+ * don't fight over one.
+ *
+ * Each packet is an entry header followed by the packet data, padded to
+ * a multiple of 8 bytes. An entry never straddles the end of the ring;
+ * when one doesn't fit there, a padding entry fills the rest of the
+ * ring and the packet goes at the start.
+ */
+#define SHM_MAGIC           0x57534852  /* "WSHR" */
+#define SHM_VERSION         1
+#define SHM_CACHE_LINE      64
+#define SHM_HEADER_SIZE     (4 * SHM_CACHE_LINE)
+#define SHM_MIN_SIZE        (1024 * 1024)
+#define SHM_MAX_SIZE        (1024 * 1024 * 1024)
+
+/* Values of producing */
+#define SHM_PRODUCING_UNKNOWN   0
+#define SHM_PRODUCING_YES       1
+#define SHM_PRODUCING_NO        2
+
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    guint32 size;           /* Size of the ring, a power of 2 */
+    gint    producing;      /* Set by dumpcap */
+    gint    stop_reading;   /* Set by the parent */
+    guint8  pad0[SHM_CACHE_LINE - 5 * sizeof(guint32)];
+    gint    tail;           /* Written by dumpcap */
+    guint8  pad1[SHM_CACHE_LINE - sizeof(gint)];
+    gint    head;           /* Written by the parent */
+} shm_header_t;
+
+#define ENTRY_PACKET        1
+#define ENTRY_PAD           2
+
+typedef struct {
+    guint32 entry_len;      /* Bytes to the next entry */
+    guint32 type;
+    capture_shm_packet_t pkt;
+} shm_entry_t;
+
+#define ENTRY_ALIGN(n)      (((n) + 7) & ~(guint32)7)
+
+struct capture_shm {
+    int           fd;
+    guint8       *map;
+    gsize         map_size;
+    shm_header_t *hdr;
+    guint8       *ring;
+    guint32       size;
+    guint32       tail;         /* Producer's copy */
+    guint32       head;         /* Consumer's copy */
+    guint32       peeked_len;   /* Length of the entry capture_shm_peek() returned */
+};
+
+#ifdef HAVE_MEMFD_CREATE
+static capture_shm_t *
+shm_map(int fd, gsize map_size, char **err_str)
+{
+    capture_shm_t *shm;
+    void *map;
+
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        *err_str = ws_strdup_printf("Couldn't map the capture shared memory: %s",
+                                    g_strerror(errno));
+        return NULL;
+    }
+    shm = g_new0(capture_shm_t, 1);
+    shm->fd = fd;
+    shm->map = (guint8 *)map;
+    shm->map_size = map_size;
+    shm->hdr = (shm_header_t *)map;
+    shm->ring = shm->map + SHM_HEADER_SIZE;
+    return shm;
+}
+#endif
+
+capture_shm_t *
+capture_shm_create(gsize size, char **err_str)
+{
+#ifdef HAVE_MEMFD_CREATE
+    capture_shm_t *shm;
+    gsize ring_size = SHM_MIN_SIZE;
+    int fd;
+
+    G_STATIC_ASSERT(sizeof(shm_header_t) <= SHM_HEADER_SIZE);
+
+    while (ring_size < size && ring_size < SHM_MAX_SIZE)
+        ring_size *= 2;
+
+    fd = memfd_create("wireshark-capture", MFD_CLOEXEC);
+    if (fd == -1) {
+        *err_str = ws_strdup_printf("Couldn't create the capture shared memory: %s",
+                                    g_strerror(errno));
+        return NULL;
+    }
+    if (ftruncate(fd, SHM_HEADER_SIZE + ring_size) == -1) {
+        *err_str = ws_strdup_printf("Couldn't size the capture shared memory: %s",
+                                    g_strerror(errno));
+        ws_close(fd);
+        return NULL;
+    }
+    shm = shm_map(fd, SHM_HEADER_SIZE + ring_size, err_str);
+    if (shm == NULL) {
+        ws_close(fd);
+        return NULL;
+    }
+    /* The file starts out zeroed. */
+    shm->hdr->magic = SHM_MAGIC;
+    shm->hdr->version = SHM_VERSION;
+    shm->hdr->size = (guint32)ring_size;
+    shm->size = (guint32)ring_size;
+    return shm;
+#else
+    (void)size;
+    *err_str = g_strdup("Handing packets over in shared memory isn't supported on this platform.");
+    return NULL;
+#endif
+}
+
+capture_shm_t *
+capture_shm_attach(int fd, char **err_str)
+{
+#ifdef HAVE_MEMFD_CREATE
+    capture_shm_t *shm;
+    ws_statb64 statb;
+    guint32 size;
+
+    if (ws_fstat64(fd, &statb) == -1) {
+        *err_str = ws_strdup_printf("Couldn't get the size of the capture shared memory: %s",
+                                    g_strerror(errno));
+        return NULL;
+    }
+    if (statb.st_size < SHM_HEADER_SIZE + SHM_MIN_SIZE) {
+        *err_str = g_strdup("The capture shared memory is too small.");
+        return NULL;
+    }
+    shm = shm_map(fd, (gsize)statb.st_size, err_str);
+    if (shm == NULL)
+        return NULL;
+    size = shm->hdr->size;
+    if (shm->hdr->magic != SHM_MAGIC || shm->hdr->version != SHM_VERSION ||
+        size < SHM_MIN_SIZE || (size & (size - 1)) != 0 ||
+        SHM_HEADER_SIZE + (gsize)size > shm->map_size) {
+        *err_str = g_strdup("The capture shared memory isn't in a format we understand.");
+        munmap(shm->map, shm->map_size);
+        g_free(shm);
+        return NULL;
+    }
+    shm->size = size;
+    shm->tail = (guint32)g_atomic_int_get(&shm->hdr->tail);
+    return shm;
+#else
+    (void)fd;
+    *err_str = g_strdup("Handing packets over in shared memory isn't supported on this platform.");
+    return NULL;
+#endif
+}
+
+int
+capture_shm_fd(const capture_shm_t *shm)
+{
+    return shm->fd;
+}
+
+void
+capture_shm_free(capture_shm_t *shm)
+{
+    if (shm == NULL)
+        return;
+#ifdef HAVE_MEMFD_CREATE
+    munmap(shm->map, shm->map_size);
+    ws_close(shm->fd);
+#endif
+    g_free(shm);
+}
+
+void
+capture_shm_set_producing(capture_shm_t *shm, gboolean producing)
+{
+    g_atomic_int_set(&shm->hdr->producing,
+                     producing ? SHM_PRODUCING_YES : SHM_PRODUCING_NO);
+}
+
+gboolean
+capture_shm_put(capture_shm_t *shm, const capture_shm_packet_t *pkt,
+                const guint8 *data)
+{
+    guint32 head = (guint32)g_atomic_int_get(&shm->hdr->head);
+    guint32 avail = shm->size - (shm->tail - head);
+    guint32 pos = shm->tail & (shm->size - 1);
+    guint32 to_end = shm->size - pos;
+    guint32 entry_len;
+    shm_entry_t *entry;
+
+    if (pkt->caplen > shm->size - sizeof(shm_entry_t))
+        return FALSE;
+    entry_len = ENTRY_ALIGN((guint32)sizeof(shm_entry_t) + pkt->caplen);
+
+    if (to_end < entry_len) {
+        /* Skip the rest of the ring and start over at the front. */
+        if (avail < to_end + entry_len)
+            return FALSE;
+        entry = (shm_entry_t *)(void *)(shm->ring + pos);
+        entry->entry_len = to_end;
+        entry->type = ENTRY_PAD;
+        shm->tail += to_end;
+        pos = 0;
+    } else if (avail < entry_len) {
+        return FALSE;
+    }
+
+    entry = (shm_entry_t *)(void *)(shm->ring + pos);
+    entry->entry_len = entry_len;
+    entry->type = ENTRY_PACKET;
+    entry->pkt = *pkt;
+    memcpy(entry + 1, data, pkt->caplen);
+    shm->tail += entry_len;
+
+    /* Publish the entries only once they're complete. */
+    g_atomic_int_set(&shm->hdr->tail, (gint)shm->tail);
+    return TRUE;
+}
+
+gboolean
+capture_shm_consumer_reading(const capture_shm_t *shm)
+{
+    return !g_atomic_int_get(&shm->hdr->stop_reading);
+}
+
+gboolean
+capture_shm_producing(const capture_shm_t *shm)
+{
+    return g_atomic_int_get(&shm->hdr->producing) == SHM_PRODUCING_YES;
+}
+
+void
+capture_shm_stop_reading(capture_shm_t *shm)
+{
+    g_atomic_int_set(&shm->hdr->stop_reading, TRUE);
+}
+
+const guint8 *
+capture_shm_peek(capture_shm_t *shm, capture_shm_packet_t *pkt)
+{
+    guint32 tail = (guint32)g_atomic_int_get(&shm->hdr->tail);
+    shm_entry_t *entry;
+
+    for (;;) {
+        if (shm->head == tail)
+            return NULL;
+        entry = (shm_entry_t *)(void *)(shm->ring + (shm->head & (shm->size - 1)));
+        if (entry->entry_len == 0 || (entry->entry_len & 7) != 0 ||
+            entry->entry_len > tail - shm->head ||
+            (entry->type == ENTRY_PACKET &&
+             entry->pkt.caplen > entry->entry_len - sizeof(shm_entry_t))) {
+            /* Corrupt; don't go any further. */
+            return NULL;
+        }
+        if (entry->type == ENTRY_PACKET)
+            break;
+        shm->head += entry->entry_len;
+        g_atomic_int_set(&shm->hdr->head, (gint)shm->head);
+    }
+    *pkt = entry->pkt;
+    shm->peeked_len = entry->entry_len;
+    return (const guint8 *)(entry + 1);
+}
+
+void
+capture_shm_release(capture_shm_t *shm)
+{
+    shm->head += shm->peeked_len;
+    shm->peeked_len = 0;
+    g_atomic_int_set(&shm->hdr->head, (gint)shm->head);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,118 @@
+/** @file
+ *
+ * Definitions for the shared-memory ring through which dumpcap hands
+ * captured packets to its parent
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_SHM_H__
+#define __CAPTURE_SHM_H__
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** The default size of the ring, in kB. */
+#define CAPTURE_SHM_DEFAULT_SIZE_KB     32768
+
+/** How long dumpcap waits for room in a full ring before it gives up on a packet, in milliseconds. */
+#define CAPTURE_SHM_WAIT_MS             1000
+
+typedef struct capture_shm capture_shm_t;
+
+/** A packet in the ring. */
+typedef struct {
+    guint64 file_offset;    /**< Offset of the packet's record in the capture file */
+    gint64  ts_sec;         /**< Time stamp, seconds since the Epoch */
+    guint32 ts_nsec;        /**< Time stamp, nanoseconds */
+    guint32 interface_id;   /**< The packet's interface in the capture file */
+    guint32 caplen;         /**< Bytes of packet data */
+    guint32 len;            /**< Length of the packet on the wire */
+} capture_shm_packet_t;
+
+/**
+ * Create a ring in anonymous shared memory, for a capture parent to hand
+ * to dumpcap. The file descriptor is closed on exec; the caller has to
+ * let dumpcap inherit it.
+ *
+ * @param size The size of the ring, rounded up to a power of 2.
+ * @param err_str Set to an error message, to be freed with g_free(), on
+ * failure.
+ * @return The ring, or NULL on failure, including on platforms without
+ * anonymous shared memory files.
+ */
+capture_shm_t *capture_shm_create(gsize size, char **err_str);
+
+/**
+ * Map a ring created by capture_shm_create(), in dumpcap.
+ *
+ * @param fd The ring's file descriptor, which the ring then owns.
+ * @param err_str Set to an error message, to be freed with g_free(), on
+ * failure.
+ * @return The ring, or NULL on failure.
+ */
+capture_shm_t *capture_shm_attach(int fd, char **err_str);
+
+/** The ring's file descriptor. */
+int capture_shm_fd(const capture_shm_t *shm);
+
+/** Unmap a ring and close its file descriptor. */
+void capture_shm_free(capture_shm_t *shm);
+
+/* Producer side, in dumpcap */
+
+/**
+ * Say whether packets will be put into the ring. dumpcap does this once,
+ * before it reports its first capture file; until then, the parent
+ * can't tell whether to read packets from the ring or from the file.
+ */
+void capture_shm_set_producing(capture_shm_t *shm, gboolean producing);
+
+/**
+ * Add a packet.
+ *
+ * @return FALSE, with nothing added, if there isn't room for it.
+ */
+gboolean capture_shm_put(capture_shm_t *shm, const capture_shm_packet_t *pkt,
+                         const guint8 *data);
+
+/** TRUE unless the parent has said it won't read from the ring. */
+gboolean capture_shm_consumer_reading(const capture_shm_t *shm);
+
+/* Consumer side, in the capture parent */
+
+/**
+ * Whether dumpcap said it's putting packets into the ring, FALSE if it
+ * hasn't said yet.
+ */
+gboolean capture_shm_producing(const capture_shm_t *shm);
+
+/**
+ * Tell dumpcap that packets won't be read from the ring, so that it
+ * stops putting them there.
+ */
+void capture_shm_stop_reading(capture_shm_t *shm);
+
+/**
+ * Get the oldest packet without removing it. The data stays valid, and
+ * in place, until capture_shm_release() is called.
+ *
+ * @return The packet data, or NULL if the ring is empty.
+ */
+const guint8 *capture_shm_peek(capture_shm_t *shm, capture_shm_packet_t *pkt);
+
+/** Remove the packet returned by capture_shm_peek(). */
+void capture_shm_release(capture_shm_t *shm);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __CAPTURE_SHM_H__ */
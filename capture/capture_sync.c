@@ -30,6 +30,7 @@
 #include <wsutil/ws_pipe.h>
 #else
 #include <glib-unix.h>
+#include <fcntl.h>
 #endif
 
 #ifdef HAVE_SYS_WAIT_H
@@ -138,6 +139,7 @@ capture_session_init(capture_session *cap_session, capture_file *cf,
     cap_session->count                           = 0;
     cap_session->count_pending                   = 0;
     cap_session->session_will_restart            = false;
+    cap_session->shm                             = NULL;
 
     cap_session->new_file                        = new_file;
     cap_session->new_packets                     = new_packets;
@@ -882,6 +884,15 @@ sync_pipe_start(capture_options *capture_opts, GPtrArray *capture_comments,
         argv = sync_pipe_add_arg(argv, &argc, "--compress-type");
         argv = sync_pipe_add_arg(argv, &argc, capture_opts->compress_type);
     }
+#ifndef _WIN32
+    if (cap_session->shm) {
+        char sshm_fd[ARGV_NUMBER_LEN];
+
+        snprintf(sshm_fd, ARGV_NUMBER_LEN, "%d", capture_shm_fd(cap_session->shm));
+        argv = sync_pipe_add_arg(argv, &argc, "--shm-fd");
+        argv = sync_pipe_add_arg(argv, &argc, sshm_fd);
+    }
+#endif
 
     int ret;
     char* msg;
@@ -889,8 +900,15 @@ sync_pipe_start(capture_options *capture_opts, GPtrArray *capture_comments,
     ret = sync_pipe_open_command(argv, NULL, &sync_pipe_read_io, &cap_session->signal_pipe_write_fd,
                                  &cap_session->fork_child, capture_opts->ifaces, &msg, update_cb);
 #else
+    /* Let dumpcap, and only dumpcap, inherit the shared memory. */
+    if (cap_session->shm) {
+        fcntl(capture_shm_fd(cap_session->shm), F_SETFD, 0);
+    }
     ret = sync_pipe_open_command(argv, NULL, &sync_pipe_read_io, NULL,
                                  &cap_session->fork_child, NULL, &msg, update_cb);
+    if (cap_session->shm) {
+        fcntl(capture_shm_fd(cap_session->shm), F_SETFD, FD_CLOEXEC);
+    }
 #endif
 
     if (ret == -1) {
@@ -2135,7 +2153,40 @@ signal_pipe_capquit_to_child(capture_session *cap_session)
         ws_warning("%d header: error %s", cap_session->signal_pipe_write_fd, win32strerror(GetLastError()));
     }
 }
+
+/* tell the child through the signal pipe to fire its trigger */
+static void
+signal_pipe_trigger_to_child(capture_session *cap_session)
+{
+    /* A message with no body */
+    const char trigger_msg[4] = { SP_TRIGGER, 0, 0, 0 };
+    int ret;
+
+    ws_debug("signal_pipe_trigger_to_child");
+
+    ret = ws_write(cap_session->signal_pipe_write_fd, trigger_msg, sizeof trigger_msg);
+    if(ret == -1) {
+        ws_warning("%d header: error %s", cap_session->signal_pipe_write_fd, win32strerror(GetLastError()));
+    }
+}
+#endif
+
+
+/* user wants the capture child to write out the packets it's keeping */
+void
+sync_pipe_trigger(capture_session *cap_session)
+{
+    if (cap_session->fork_child != WS_INVALID_PID) {
+#ifndef _WIN32
+        int sts = kill(cap_session->fork_child, SIGUSR1);
+        if (sts != 0) {
+            ws_warning("Sending SIGUSR1 to child failed: %s\n", g_strerror(errno));
+        }
+#else
+        signal_pipe_trigger_to_child(cap_session);
 #endif
+    }
+}
 
 
 /* user wants to stop the capture run */
@@ -47,6 +47,14 @@ sync_pipe_start(capture_options *capture_opts, GPtrArray *capture_comments,
                 capture_session *cap_session, struct _info_data* cap_data,
                 void(*update_cb)(void));
 
+/**
+ * User wants the capture child to write out the packets it's keeping
+ * before a trigger, as if the trigger had fired. A child started
+ * without --pre-trigger ignores this.
+ */
+extern void
+sync_pipe_trigger(capture_session *cap_session);
+
 /** User wants to stop capturing, gracefully close the capture child */
 extern void
 sync_pipe_stop(capture_session *cap_session);
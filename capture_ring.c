@@ -0,0 +1,220 @@
+/* capture_ring.c
+ * In-memory ring of captured packets kept by dumpcap until a trigger
+ * fires
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <glib.h>
+
+#include "capture_ring.h"
+
+/*
+ * Records are stored back to back, each one after an entry header and
+ * padded to a multiple of 8 bytes so that the headers, and the pcap and
+ * pcapng headers at the start of the records, are aligned. A record
+ * never straddles the end of the buffer; when one doesn't fit there,
+ * it goes at the start, and the space left at the end is skipped.
+ *
+ * The records run from head to tail, or, when the ring has wrapped,
+ * from head to wrap and then from the start of the buffer to tail.
+ */
+typedef struct {
+    guint64 ts;
+    guint32 tag;
+    guint32 len;
+} ring_entry_t;
+
+#define ENTRY_ALIGN(n)  (((n) + 7) & ~(gsize)7)
+#define ENTRY_SIZE(len) ENTRY_ALIGN(sizeof(ring_entry_t) + (gsize)(len))
+
+struct capture_ring {
+    guint8   *buf;
+    gsize     size;
+    gsize     head;
+    gsize     tail;
+    gsize     wrap;
+    gboolean  wrapped;
+    guint32   count;
+    gsize     used;
+    capture_ring_discard_cb discard;
+    void     *user_data;
+};
+
+capture_ring_t *
+capture_ring_new(gsize size, capture_ring_discard_cb discard, void *user_data)
+{
+    capture_ring_t *ring;
+
+    size &= ~(gsize)7;
+    if (size < ENTRY_SIZE(0))
+        return NULL;
+
+    ring = g_new0(capture_ring_t, 1);
+    ring->buf = (guint8 *)g_try_malloc(size);
+    if (ring->buf == NULL) {
+        g_free(ring);
+        return NULL;
+    }
+    /* Fault every page in now, rather than while capturing. */
+    memset(ring->buf, 0, size);
+    ring->size = size;
+    ring->discard = discard;
+    ring->user_data = user_data;
+    return ring;
+}
+
+void
+capture_ring_free(capture_ring_t *ring)
+{
+    if (ring == NULL)
+        return;
+    g_free(ring->buf);
+    g_free(ring);
+}
+
+static inline ring_entry_t *
+ring_oldest(const capture_ring_t *ring)
+{
+    return (ring_entry_t *)(void *)(ring->buf + ring->head);
+}
+
+/* Remove the oldest record; the ring must not be empty. */
+static void
+ring_pop(capture_ring_t *ring)
+{
+    gsize entry_size = ENTRY_SIZE(ring_oldest(ring)->len);
+
+    ring->head += entry_size;
+    ring->used -= entry_size;
+    ring->count--;
+    if (ring->count == 0) {
+        ring->head = ring->tail = 0;
+        ring->wrapped = FALSE;
+    } else if (ring->wrapped && ring->head == ring->wrap) {
+        ring->head = 0;
+        ring->wrapped = FALSE;
+    }
+}
+
+static void
+ring_discard_oldest(capture_ring_t *ring)
+{
+    guint32 tag = ring_oldest(ring)->tag;
+
+    ring_pop(ring);
+    if (ring->discard)
+        ring->discard(tag, ring->user_data);
+}
+
+gboolean
+capture_ring_put(capture_ring_t *ring, guint32 tag, guint64 ts,
+                 const void *hdr, guint32 hdr_len,
+                 const void *data, guint32 data_len)
+{
+    gsize entry_size;
+    guint8 *dst;
+    ring_entry_t *entry;
+
+    if ((guint64)hdr_len + data_len > G_MAXUINT32)
+        return FALSE;
+    entry_size = ENTRY_SIZE(hdr_len + data_len);
+    if (entry_size > ring->size)
+        return FALSE;
+
+    for (;;) {
+        if (ring->wrapped) {
+            if (ring->head - ring->tail >= entry_size)
+                break;
+        } else if (ring->size - ring->tail >= entry_size) {
+            break;
+        } else if (ring->head >= entry_size) {
+            /* Skip the rest of the buffer and start over at the front. */
+            ring->wrap = ring->tail;
+            ring->tail = 0;
+            ring->wrapped = TRUE;
+            break;
+        }
+        ring_discard_oldest(ring);
+    }
+
+    dst = ring->buf + ring->tail;
+    entry = (ring_entry_t *)(void *)dst;
+    entry->ts = ts;
+    entry->tag = tag;
+    entry->len = hdr_len + data_len;
+    dst += sizeof(ring_entry_t);
+    if (hdr_len)
+        memcpy(dst, hdr, hdr_len);
+    if (data_len)
+        memcpy(dst + hdr_len, data, data_len);
+
+    ring->tail += entry_size;
+    ring->used += entry_size;
+    ring->count++;
+    return TRUE;
+}
+
+void
+capture_ring_expire(capture_ring_t *ring, guint64 oldest_ts)
+{
+    while (ring->count > 0 && ring_oldest(ring)->ts < oldest_ts)
+        ring_discard_oldest(ring);
+}
+
+gboolean
+capture_ring_drain(capture_ring_t *ring, capture_ring_drain_cb cb, void *user_data)
+{
+    ring_entry_t *entry;
+    gboolean ok;
+
+    while (ring->count > 0) {
+        entry = ring_oldest(ring);
+        ok = cb(entry->tag, (const guint8 *)(entry + 1), entry->len, user_data);
+        ring_pop(ring);
+        if (!ok) {
+            capture_ring_clear(ring);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+void
+capture_ring_clear(capture_ring_t *ring)
+{
+    while (ring->count > 0)
+        ring_discard_oldest(ring);
+}
+
+guint32
+capture_ring_count(const capture_ring_t *ring)
+{
+    return ring->count;
+}
+
+gsize
+capture_ring_used(const capture_ring_t *ring)
+{
+    return ring->used;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,79 @@
+/** @file
+ *
+ * Definitions for the in-memory ring of captured packets kept by
+ * dumpcap until a trigger fires
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __CAPTURE_RING_H__
+#define __CAPTURE_RING_H__
+
+#include <glib.h>
+
+typedef struct capture_ring capture_ring_t;
+
+/**
+ * Called for each record that's dropped from the ring without being
+ * drained, either to make room for a newer one or because it's too old.
+ */
+typedef void (*capture_ring_discard_cb)(guint32 tag, void *user_data);
+
+/**
+ * Called for each record by capture_ring_drain(), oldest first. Return
+ * FALSE to stop; the records not yet drained are then discarded.
+ */
+typedef gboolean (*capture_ring_drain_cb)(guint32 tag, const guint8 *data,
+                                          guint32 len, void *user_data);
+
+/**
+ * Allocate a ring holding up to size bytes of records, including a few
+ * bytes of overhead for each one. All of the memory is allocated and
+ * touched here, so that keeping records never has to allocate.
+ *
+ * @return The ring, or NULL if the memory couldn't be allocated.
+ */
+capture_ring_t *capture_ring_new(gsize size, capture_ring_discard_cb discard,
+                                 void *user_data);
+
+void capture_ring_free(capture_ring_t *ring);
+
+/**
+ * Add a record made of a header followed by data, discarding the oldest
+ * records until there's room for it.
+ *
+ * @param ring The ring.
+ * @param tag Identifies the record's source to the callbacks.
+ * @param ts The record's time stamp, in nanoseconds.
+ * @return FALSE, with nothing discarded, if the record is larger than
+ * the whole ring.
+ */
+gboolean capture_ring_put(capture_ring_t *ring, guint32 tag, guint64 ts,
+                          const void *hdr, guint32 hdr_len,
+                          const void *data, guint32 data_len);
+
+/** Discard the records, oldest first, up to the first one stamped at or after oldest_ts. */
+void capture_ring_expire(capture_ring_t *ring, guint64 oldest_ts);
+
+/**
+ * Remove every record, oldest first, handing each to a callback.
+ *
+ * @return FALSE if the callback stopped early.
+ */
+gboolean capture_ring_drain(capture_ring_t *ring, capture_ring_drain_cb cb,
+                            void *user_data);
+
+/** Discard every record. */
+void capture_ring_clear(capture_ring_t *ring);
+
+/** The number of records in the ring. */
+guint32 capture_ring_count(const capture_ring_t *ring);
+
+/** The number of bytes the records in the ring take up. */
+gsize capture_ring_used(const capture_ring_t *ring);
+
+#endif /* __CAPTURE_RING_H__ */
@@ -15,6 +15,7 @@
 #include <epan/epan.h>
 #include <epan/column-info.h>
 #include <epan/dfilter/dfilter.h>
+#include <epan/field_index.h>
 #include <epan/frame_data.h>
 #include <epan/frame_data_sequence.h>
 #include <wiretap/wtap.h>
@@ -92,6 +93,9 @@ typedef struct _capture_file {
     dfilter_t                  *rfcode;               /* Compiled read filter program */
     dfilter_t                  *dfcode;               /* Compiled display filter program */
     gchar                      *dfilter;              /* Display filter string */
+    field_index_t              *field_index;          /* Index of field values for display filtering */
+    gchar                      *filter_frames_dfilter; /* Display filter that only filter_frames can match */
+    GArray                     *filter_frames;        /* Ascending frame numbers for the next refiltering */
     gboolean                    redissecting;         /* TRUE if currently redissecting (cf_redissect_packets) */
     gboolean                    read_lock;            /* TRUE if currently processing a file (cf_read) */
     rescan_type                 redissection_queued;  /* Queued redissection type. */
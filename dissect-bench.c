@@ -0,0 +1,958 @@
+/* dissect-bench.c
+ * Measures dissection throughput, for comparing builds.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+#define WS_LOG_DOMAIN  LOG_DOMAIN_MAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+#include <ws_exit_codes.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/timestamp.h>
+#include <epan/prefs.h>
+#include <epan/proto.h>
+#include <epan/tvbuff.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef HAVE_PLUGINS
+#include <wsutil/plugins.h>
+#endif
+#include <wsutil/clopts_common.h>
+#include <wsutil/filesystem.h>
+#include <wsutil/json_dumper.h>
+#include <wsutil/privileges.h>
+#include <wsutil/report_message.h>
+#include <wsutil/time_util.h>
+#include <wsutil/wmem/wmem.h>
+#include <wsutil/wslog.h>
+#include <wsutil/ws_getopt.h>
+
+#include <wiretap/wtap.h>
+
+#include "ui/failure_message.h"
+#include "wsutil/cmdarg_err.h"
+#include "wsutil/version_info.h"
+
+typedef enum {
+    BENCH_NOTREE,       /* One pass without a tree, like "tshark -r" */
+    BENCH_TREE,         /* One pass with a visible tree, like "tshark -V" */
+    BENCH_TWOPASS,      /* A pass without a tree, then one with a tree, like "tshark -2 -V" */
+    BENCH_FILTER,       /* One pass with a display filter, like "tshark -Y" */
+    BENCH_DFILTER,      /* Only the evaluation of the display filter */
+    BENCH_NUM_MODES
+} bench_mode;
+
+static const char *bench_mode_names[BENCH_NUM_MODES] = {
+    "notree",
+    "tree",
+    "twopass",
+    "filter",
+    "dfilter"
+};
+
+/* Times the filter is applied to each packet in the "dfilter" mode, to
+ * get well above the resolution of the clock */
+#define DFILTER_REPEAT 16
+
+/* A packet held in memory, with its frame_data for the current run */
+typedef struct {
+    wtap_rec    rec;    /* The packet header, without the block */
+    guint8     *data;
+    frame_data  fd;
+} bench_frame;
+
+/* A capture file held in memory */
+typedef struct {
+    char       *filename;
+    int         file_type_subtype;
+    guint8     *data;
+    bench_frame *frames;
+    guint32     count;
+    guint64     bytes;
+} bench_capture;
+
+struct packet_provider_data {
+    bench_capture *cap;
+};
+
+/* Frame state carried from one packet to the next within a pass */
+typedef struct {
+    nstime_t          elapsed_time;
+    const frame_data *frame_ref;
+    const frame_data *prev_dis;
+    guint32           cum_bytes;
+} bench_pass;
+
+typedef struct {
+    int     proto_id;
+    guint64 packets;
+    guint64 ns;
+    guint64 allocs;
+    guint64 alloc_bytes;
+} bench_proto_stats;
+
+typedef struct {
+    bench_mode  mode;
+    guint64     packets;        /* Dissections per iteration */
+    guint64     matched;        /* Packets that matched the filter, per iteration */
+    guint64     best_ns;
+    guint64     total_ns;
+    guint64     allocs;         /* Over all iterations */
+    guint64     alloc_bytes;
+    guint64     process_peak_memory; /* Since the process started, not just this mode */
+    GHashTable *protos;         /* proto_id -> bench_proto_stats */
+} bench_result;
+
+static guint opt_iterations = 3;
+static gboolean opt_modes[BENCH_NUM_MODES] = { TRUE, TRUE, TRUE, TRUE, TRUE };
+static const char *opt_filter = "ip";
+static gboolean opt_optimize = TRUE;
+static gboolean opt_json = FALSE;
+
+/*
+ * Report an error in command-line arguments.
+ */
+static void
+bench_cmdarg_err(const char *fmt, va_list ap)
+{
+    fprintf(stderr, "dissect-bench: ");
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+}
+
+/*
+ * Report additional information for an error in command-line arguments.
+ */
+static void
+bench_cmdarg_err_cont(const char *fmt, va_list ap)
+{
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+}
+
+static void
+print_usage(FILE *fp)
+{
+    fprintf(fp, "\n");
+    fprintf(fp, "Usage: dissect-bench [options] <infile|directory> ...\n");
+    fprintf(fp, "\n");
+    fprintf(fp, "Loads each capture file into memory and measures how fast it is dissected.\n");
+    fprintf(fp, "\n");
+    fprintf(fp, "Options:\n");
+    fprintf(fp, "  -n <count>               number of times to run each mode (default: 3)\n");
+    fprintf(fp, "  -m <mode>[,<mode>...]    modes to run: notree, tree, twopass, filter,\n");
+    fprintf(fp, "                           dfilter (default: all)\n");
+    fprintf(fp, "  -Y <display filter>      filter for the \"filter\" and \"dfilter\" modes\n");
+    fprintf(fp, "                           (default: \"ip\")\n");
+    fprintf(fp, "  -0                       don't optimize the display filter\n");
+    fprintf(fp, "  -o <name>:<value> ...    override preference setting\n");
+    fprintf(fp, "  -T text|json             output format (default: text)\n");
+    fprintf(fp, "  -h, --help               display this help and exit\n");
+    fprintf(fp, "  -v, --version            print version information and exit\n");
+}
+
+static gboolean
+parse_modes(const char *arg)
+{
+    gchar **names = g_strsplit(arg, ",", -1);
+    gboolean ok = TRUE;
+    int mode;
+    guint i;
+
+    for (mode = 0; mode < BENCH_NUM_MODES; mode++)
+        opt_modes[mode] = FALSE;
+
+    for (i = 0; names[i]; i++) {
+        for (mode = 0; mode < BENCH_NUM_MODES; mode++) {
+            if (strcmp(names[i], bench_mode_names[mode]) == 0) {
+                opt_modes[mode] = TRUE;
+                break;
+            }
+        }
+        if (mode == BENCH_NUM_MODES) {
+            cmdarg_err("\"%s\" isn't a mode; use notree, tree, twopass, filter or dfilter", names[i]);
+            ok = FALSE;
+        }
+    }
+    g_strfreev(names);
+    return ok;
+}
+
+static const nstime_t *
+bench_get_frame_ts(struct packet_provider_data *prov, guint32 frame_num)
+{
+    if (frame_num == 0 || frame_num > prov->cap->count)
+        return NULL;
+    return &prov->cap->frames[frame_num - 1].fd.abs_ts;
+}
+
+/*
+ * Read all packets of a capture file into memory, so that the benchmark
+ * measures dissection and not file reading.
+ */
+static bench_capture *
+load_capture(const char *filename)
+{
+    bench_capture *cap;
+    wtap *wth;
+    wtap_rec rec;
+    Buffer buf;
+    GByteArray *data;
+    GArray *frames;
+    GArray *offsets;
+    int err;
+    gchar *err_info;
+    gint64 data_offset;
+    guint i;
+
+    wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+    if (!wth) {
+        cfile_open_failure_message(filename, err, err_info);
+        return NULL;
+    }
+
+    data = g_byte_array_new();
+    frames = g_array_new(FALSE, TRUE, sizeof(bench_frame));
+    offsets = g_array_new(FALSE, FALSE, sizeof(guint));
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+
+    while (wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset)) {
+        bench_frame frame;
+        guint offset = data->len;
+
+        if (rec.rec_type != REC_TYPE_PACKET) {
+            wtap_rec_reset(&rec);
+            continue;
+        }
+
+        memset(&frame, 0, sizeof frame);
+        frame.rec.rec_type = rec.rec_type;
+        frame.rec.presence_flags = rec.presence_flags;
+        frame.rec.section_number = rec.section_number;
+        frame.rec.ts = rec.ts;
+        frame.rec.tsprec = rec.tsprec;
+        frame.rec.rec_header.packet_header = rec.rec_header.packet_header;
+        g_byte_array_append(data, ws_buffer_start_ptr(&buf), rec.rec_header.packet_header.caplen);
+        g_array_append_val(frames, frame);
+        g_array_append_val(offsets, offset);
+        wtap_rec_reset(&rec);
+    }
+    if (err != 0) {
+        cfile_read_failure_message(filename, err, err_info);
+    }
+
+    cap = g_new0(bench_capture, 1);
+    cap->filename = g_strdup(filename);
+    cap->file_type_subtype = wtap_file_type_subtype(wth);
+    cap->count = frames->len;
+    cap->bytes = data->len;
+    cap->data = g_byte_array_free(data, FALSE);
+    cap->frames = (bench_frame *)(void *)g_array_free(frames, FALSE);
+    for (i = 0; i < cap->count; i++)
+        cap->frames[i].data = cap->data + g_array_index(offsets, guint, i);
+
+    g_array_free(offsets, TRUE);
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+    wtap_close(wth);
+
+    return cap;
+}
+
+static void
+free_capture(bench_capture *cap)
+{
+    g_free(cap->filename);
+    g_free(cap->data);
+    g_free(cap->frames);
+    g_free(cap);
+}
+
+static void
+bench_pass_init(bench_pass *pass)
+{
+    nstime_set_zero(&pass->elapsed_time);
+    pass->frame_ref = NULL;
+    pass->prev_dis = NULL;
+    pass->cum_bytes = 0;
+}
+
+/* The highest layer found in the packet, such as "dns" or "tcp" */
+static int
+top_level_protocol(packet_info *pinfo)
+{
+    wmem_list_frame_t *tail;
+
+    if (!pinfo->layers)
+        return -1;
+    tail = wmem_list_tail(pinfo->layers);
+    if (!tail)
+        return -1;
+    return GPOINTER_TO_INT(wmem_list_frame_data(tail));
+}
+
+static bench_proto_stats *
+get_proto_stats(bench_result *result, int proto_id)
+{
+    bench_proto_stats *stats;
+
+    stats = (bench_proto_stats *)g_hash_table_lookup(result->protos, GINT_TO_POINTER(proto_id));
+    if (!stats) {
+        stats = g_new0(bench_proto_stats, 1);
+        stats->proto_id = proto_id;
+        g_hash_table_insert(result->protos, GINT_TO_POINTER(proto_id), stats);
+    }
+    return stats;
+}
+
+static void
+dissect_frame(bench_capture *cap, epan_dissect_t *edt, bench_frame *frame,
+        bench_pass *pass, dfilter_t *dfcode, bench_result *result)
+{
+    bench_proto_stats *stats;
+    uint64_t pool_count, pool_bytes, file_count, file_bytes;
+    uint64_t count, bytes, end_count, end_bytes;
+    uint64_t start, elapsed;
+    guint32 caplen = frame->rec.rec_header.packet_header.caplen;
+    gboolean passed = TRUE;
+    int proto_id;
+
+    wmem_get_allocation_stats(edt->pi.pool, &pool_count, &pool_bytes);
+    wmem_get_allocation_stats(wmem_file_scope(), &file_count, &file_bytes);
+    start = ws_clock_get_monotonic_ns();
+
+    if (dfcode)
+        epan_dissect_prime_with_dfilter(edt, dfcode);
+    frame_data_set_before_dissect(&frame->fd, &pass->elapsed_time,
+            &pass->frame_ref, pass->prev_dis);
+    epan_dissect_run(edt, cap->file_type_subtype, &frame->rec,
+            tvb_new_real_data(frame->data, caplen, caplen), &frame->fd, NULL);
+    if (dfcode)
+        passed = dfilter_apply_edt(dfcode, edt);
+    frame_data_set_after_dissect(&frame->fd, &pass->cum_bytes);
+    pass->prev_dis = &frame->fd;
+    proto_id = top_level_protocol(&edt->pi);
+    epan_dissect_reset(edt);
+
+    elapsed = ws_clock_get_monotonic_ns() - start;
+    wmem_get_allocation_stats(edt->pi.pool, &end_count, &end_bytes);
+    count = end_count - pool_count;
+    bytes = end_bytes - pool_bytes;
+    wmem_get_allocation_stats(wmem_file_scope(), &end_count, &end_bytes);
+    count += end_count - file_count;
+    bytes += end_bytes - file_bytes;
+
+    if (passed)
+        result->matched++;
+    result->allocs += count;
+    result->alloc_bytes += bytes;
+
+    stats = get_proto_stats(result, proto_id);
+    stats->packets++;
+    stats->ns += elapsed;
+    stats->allocs += count;
+    stats->alloc_bytes += bytes;
+}
+
+/* Dissect every frame once, untimed, and time only the evaluation of
+ * the filter. Returns the time spent in the filter. */
+static guint64
+run_filter_pass(bench_capture *cap, epan_dissect_t *edt, dfilter_t *dfcode, bench_result *result)
+{
+    bench_proto_stats *stats;
+    bench_pass pass;
+    guint64 total = 0;
+    guint32 i;
+
+    bench_pass_init(&pass);
+    for (i = 0; i < cap->count; i++) {
+        bench_frame *frame = &cap->frames[i];
+        guint32 caplen = frame->rec.rec_header.packet_header.caplen;
+        uint64_t count, bytes, end_count, end_bytes;
+        uint64_t start, elapsed;
+        gboolean passed = FALSE;
+        int n;
+
+        epan_dissect_prime_with_dfilter(edt, dfcode);
+        frame_data_set_before_dissect(&frame->fd, &pass.elapsed_time,
+                &pass.frame_ref, pass.prev_dis);
+        epan_dissect_run(edt, cap->file_type_subtype, &frame->rec,
+                tvb_new_real_data(frame->data, caplen, caplen), &frame->fd, NULL);
+
+        wmem_get_allocation_stats(edt->pi.pool, &count, &bytes);
+        start = ws_clock_get_monotonic_ns();
+        for (n = 0; n < DFILTER_REPEAT; n++)
+            passed = dfilter_apply_edt(dfcode, edt);
+        elapsed = ws_clock_get_monotonic_ns() - start;
+        wmem_get_allocation_stats(edt->pi.pool, &end_count, &end_bytes);
+
+        frame_data_set_after_dissect(&frame->fd, &pass.cum_bytes);
+        pass.prev_dis = &frame->fd;
+
+        if (passed)
+            result->matched++;
+        result->allocs += end_count - count;
+        result->alloc_bytes += end_bytes - bytes;
+
+        stats = get_proto_stats(result, top_level_protocol(&edt->pi));
+        stats->packets += DFILTER_REPEAT;
+        stats->ns += elapsed;
+        stats->allocs += end_count - count;
+        stats->alloc_bytes += end_bytes - bytes;
+
+        epan_dissect_reset(edt);
+        total += elapsed;
+    }
+    return total;
+}
+
+/* Dissect every frame once, in a new session */
+static void
+run_pass(bench_capture *cap, epan_dissect_t *edt, dfilter_t *dfcode, bench_result *result)
+{
+    bench_pass pass;
+    guint32 i;
+
+    bench_pass_init(&pass);
+    for (i = 0; i < cap->count; i++)
+        dissect_frame(cap, edt, &cap->frames[i], &pass, dfcode, result);
+}
+
+static guint64
+run_iteration(bench_capture *cap, bench_mode mode, dfilter_t *dfcode, bench_result *result)
+{
+    static const struct packet_provider_funcs funcs = {
+        bench_get_frame_ts,
+        NULL,
+        NULL,
+        NULL
+    };
+    struct packet_provider_data prov;
+    epan_t *session;
+    epan_dissect_t *edt;
+    guint64 start, elapsed, filter_ns = 0;
+    guint32 i;
+
+    for (i = 0; i < cap->count; i++)
+        frame_data_init(&cap->frames[i].fd, i + 1, &cap->frames[i].rec, 0, 0);
+
+    prov.cap = cap;
+    session = epan_new(&prov, &funcs);
+    result->matched = 0;
+
+    start = ws_clock_get_monotonic_ns();
+    switch (mode) {
+    case BENCH_NOTREE:
+        edt = epan_dissect_new(session, FALSE, FALSE);
+        run_pass(cap, edt, NULL, result);
+        break;
+    case BENCH_TREE:
+        edt = epan_dissect_new(session, TRUE, TRUE);
+        run_pass(cap, edt, NULL, result);
+        break;
+    case BENCH_TWOPASS:
+        edt = epan_dissect_new(session, FALSE, FALSE);
+        run_pass(cap, edt, NULL, result);
+        epan_dissect_free(edt);
+        edt = epan_dissect_new(session, TRUE, TRUE);
+        run_pass(cap, edt, NULL, result);
+        break;
+    case BENCH_DFILTER:
+        edt = epan_dissect_new(session, TRUE, FALSE);
+        filter_ns = run_filter_pass(cap, edt, dfcode, result);
+        break;
+    default:
+        edt = epan_dissect_new(session, TRUE, FALSE);
+        run_pass(cap, edt, dfcode, result);
+        break;
+    }
+    elapsed = mode == BENCH_DFILTER ? filter_ns : ws_clock_get_monotonic_ns() - start;
+
+    epan_dissect_free(edt);
+    epan_free(session);
+    for (i = 0; i < cap->count; i++)
+        frame_data_destroy(&cap->frames[i].fd);
+
+    return elapsed;
+}
+
+static bench_result *
+run_mode(bench_capture *cap, bench_mode mode, dfilter_t *dfcode)
+{
+    bench_result *result = g_new0(bench_result, 1);
+    guint n;
+
+    result->mode = mode;
+    if (mode == BENCH_TWOPASS)
+        result->packets = 2 * (guint64)cap->count;
+    else if (mode == BENCH_DFILTER)
+        result->packets = DFILTER_REPEAT * (guint64)cap->count;
+    else
+        result->packets = cap->count;
+    result->protos = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+    for (n = 0; n < opt_iterations; n++) {
+        guint64 elapsed = run_iteration(cap, mode, dfcode, result);
+
+        if (n == 0 || elapsed < result->best_ns)
+            result->best_ns = elapsed;
+        result->total_ns += elapsed;
+    }
+    /* The peak RSS only ever grows, so this covers every capture and
+     * mode run so far, not this one alone. */
+    result->process_peak_memory = get_peak_memory_usage();
+
+    return result;
+}
+
+static void
+free_result(bench_result *result)
+{
+    g_hash_table_destroy(result->protos);
+    g_free(result);
+}
+
+static gint
+compare_proto_stats(gconstpointer a, gconstpointer b)
+{
+    const bench_proto_stats *sa = *(const bench_proto_stats * const *)a;
+    const bench_proto_stats *sb = *(const bench_proto_stats * const *)b;
+
+    /* Most expensive first */
+    if (sa->ns != sb->ns)
+        return sa->ns > sb->ns ? -1 : 1;
+    return sa->proto_id - sb->proto_id;
+}
+
+static GPtrArray *
+sorted_protos(bench_result *result)
+{
+    GPtrArray *protos = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer value;
+
+    g_hash_table_iter_init(&iter, result->protos);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        g_ptr_array_add(protos, value);
+    g_ptr_array_sort(protos, compare_proto_stats);
+    return protos;
+}
+
+static const char *
+proto_name(int proto_id)
+{
+    return proto_id < 0 ? "none" : proto_get_protocol_filter_name(proto_id);
+}
+
+static double
+per_packet(guint64 value, guint64 packets)
+{
+    return packets ? (double)value / (double)packets : 0.0;
+}
+
+static void
+print_result_text(bench_capture *cap, bench_result *result)
+{
+    guint64 dissections = result->packets * opt_iterations;
+    GPtrArray *protos;
+    guint i;
+
+    printf("  %-8s %12.0f pkt/s %10.1f ns/pkt (mean %.1f) %8.1f allocs/pkt %10.1f bytes/pkt  process peak %" G_GUINT64_FORMAT " KiB",
+            bench_mode_names[result->mode],
+            result->best_ns ? (double)result->packets * 1e9 / (double)result->best_ns : 0.0,
+            per_packet(result->best_ns, result->packets),
+            per_packet(result->total_ns, dissections),
+            per_packet(result->allocs, dissections),
+            per_packet(result->alloc_bytes, dissections),
+            result->process_peak_memory / 1024);
+    if (result->mode == BENCH_FILTER || result->mode == BENCH_DFILTER)
+        printf("  matched %" G_GUINT64_FORMAT "/%u", result->matched, cap->count);
+    printf("\n");
+
+    protos = sorted_protos(result);
+    for (i = 0; i < protos->len; i++) {
+        bench_proto_stats *stats = (bench_proto_stats *)protos->pdata[i];
+
+        printf("    %-20s %10" G_GUINT64_FORMAT " pkts %10.1f ns/pkt %8.1f allocs/pkt %5.1f%%\n",
+                proto_name(stats->proto_id),
+                stats->packets / opt_iterations,
+                per_packet(stats->ns, stats->packets),
+                per_packet(stats->allocs, stats->packets),
+                result->total_ns ? 100.0 * (double)stats->ns / (double)result->total_ns : 0.0);
+    }
+    g_ptr_array_free(protos, TRUE);
+}
+
+static void
+json_member_double(json_dumper *dumper, const char *name, double value)
+{
+    json_dumper_set_member_name(dumper, name);
+    json_dumper_value_double(dumper, value);
+}
+
+static void
+json_member_uint64(json_dumper *dumper, const char *name, guint64 value)
+{
+    json_dumper_set_member_name(dumper, name);
+    json_dumper_value_anyf(dumper, "%" G_GUINT64_FORMAT, value);
+}
+
+static void
+print_result_json(json_dumper *dumper, bench_result *result)
+{
+    guint64 dissections = result->packets * opt_iterations;
+    GPtrArray *protos;
+    guint i;
+
+    json_dumper_begin_object(dumper);
+    json_dumper_set_member_name(dumper, "mode");
+    json_dumper_value_string(dumper, bench_mode_names[result->mode]);
+    json_member_uint64(dumper, "dissections", result->packets);
+    json_member_double(dumper, "packets_per_second",
+            result->best_ns ? (double)result->packets * 1e9 / (double)result->best_ns : 0.0);
+    json_member_double(dumper, "ns_per_packet", per_packet(result->best_ns, result->packets));
+    json_member_double(dumper, "ns_per_packet_mean", per_packet(result->total_ns, dissections));
+    json_member_double(dumper, "allocs_per_packet", per_packet(result->allocs, dissections));
+    json_member_double(dumper, "alloc_bytes_per_packet", per_packet(result->alloc_bytes, dissections));
+    json_member_uint64(dumper, "process_peak_memory", result->process_peak_memory);
+    if (result->mode == BENCH_FILTER || result->mode == BENCH_DFILTER)
+        json_member_uint64(dumper, "matched", result->matched);
+
+    json_dumper_set_member_name(dumper, "protocols");
+    json_dumper_begin_array(dumper);
+    protos = sorted_protos(result);
+    for (i = 0; i < protos->len; i++) {
+        bench_proto_stats *stats = (bench_proto_stats *)protos->pdata[i];
+
+        json_dumper_begin_object(dumper);
+        json_dumper_set_member_name(dumper, "protocol");
+        json_dumper_value_string(dumper, proto_name(stats->proto_id));
+        json_member_uint64(dumper, "packets", stats->packets / opt_iterations);
+        json_member_double(dumper, "ns_per_packet", per_packet(stats->ns, stats->packets));
+        json_member_double(dumper, "allocs_per_packet", per_packet(stats->allocs, stats->packets));
+        json_member_double(dumper, "alloc_bytes_per_packet", per_packet(stats->alloc_bytes, stats->packets));
+        json_dumper_end_object(dumper);
+    }
+    g_ptr_array_free(protos, TRUE);
+    json_dumper_end_array(dumper);
+
+    json_dumper_end_object(dumper);
+}
+
+static void
+bench_capture_file(const char *filename, dfilter_t *dfcode, json_dumper *dumper)
+{
+    bench_capture *cap;
+    int mode;
+
+    cap = load_capture(filename);
+    if (!cap)
+        return;
+
+    if (dumper) {
+        json_dumper_begin_object(dumper);
+        json_dumper_set_member_name(dumper, "file");
+        json_dumper_value_string(dumper, filename);
+        json_member_uint64(dumper, "packets", cap->count);
+        json_member_uint64(dumper, "bytes", cap->bytes);
+        json_dumper_set_member_name(dumper, "modes");
+        json_dumper_begin_array(dumper);
+    } else {
+        printf("%s: %u packets, %" G_GUINT64_FORMAT " bytes\n", filename, cap->count, cap->bytes);
+    }
+
+    for (mode = 0; mode < BENCH_NUM_MODES; mode++) {
+        bench_result *result;
+
+        if (!opt_modes[mode])
+            continue;
+        result = run_mode(cap, (bench_mode)mode, dfcode);
+        if (dumper)
+            print_result_json(dumper, result);
+        else
+            print_result_text(cap, result);
+        free_result(result);
+    }
+
+    if (dumper) {
+        json_dumper_end_array(dumper);
+        json_dumper_end_object(dumper);
+    }
+    fflush(stdout);
+    free_capture(cap);
+}
+
+static gint
+compare_filenames(gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0(*(const char * const *)a, *(const char * const *)b);
+}
+
+/* Add a file, or the files in a directory in name order */
+static void
+add_input(GPtrArray *files, const char *path)
+{
+    GDir *dir;
+    GPtrArray *names;
+    const char *name;
+    guint i;
+
+    if (!g_file_test(path, G_FILE_TEST_IS_DIR)) {
+        g_ptr_array_add(files, g_strdup(path));
+        return;
+    }
+
+    dir = g_dir_open(path, 0, NULL);
+    if (!dir) {
+        cmdarg_err("Can't open directory \"%s\"", path);
+        return;
+    }
+    names = g_ptr_array_new();
+    while ((name = g_dir_read_name(dir)) != NULL)
+        g_ptr_array_add(names, g_build_filename(path, name, NULL));
+    g_dir_close(dir);
+
+    g_ptr_array_sort(names, compare_filenames);
+    for (i = 0; i < names->len; i++) {
+        char *filename = (char *)names->pdata[i];
+
+        if (g_file_test(filename, G_FILE_TEST_IS_REGULAR))
+            g_ptr_array_add(files, filename);
+        else
+            g_free(filename);
+    }
+    g_ptr_array_free(names, TRUE);
+}
+
+int
+main(int argc, char **argv)
+{
+    char        *configuration_init_error;
+    char        *err_msg;
+    dfilter_t   *dfcode = NULL;
+    df_error_t  *df_err = NULL;
+    GPtrArray   *files;
+    json_dumper  dumper = {
+        .output_file = stdout,
+        .flags = JSON_DUMPER_FLAGS_PRETTY_PRINT,
+    };
+    int          exit_status = EXIT_SUCCESS;
+    int          opt;
+    guint        i;
+
+    static const struct ws_option long_options[] = {
+        {"help", ws_no_argument, 0, 'h'},
+        {"version", ws_no_argument, 0, 'v'},
+        {0, 0, 0, 0}
+    };
+
+    cmdarg_err_init(bench_cmdarg_err, bench_cmdarg_err_cont);
+
+    /* Initialize log handler early so we can have proper logging during startup. */
+    ws_log_init("dissect-bench", vcmdarg_err);
+
+    /* Early logging command-line initialization. */
+    ws_log_parse_args(&argc, argv, vcmdarg_err, 1);
+
+    ws_noisy("Finished log init and parsing command line log arguments");
+
+    ws_init_version_info("Dissect-bench", epan_gather_compile_info, epan_gather_runtime_info);
+
+    /*
+     * Get credential information for later use.
+     */
+    init_process_policies();
+
+    /*
+     * Attempt to get the pathname of the directory containing the
+     * executable file.
+     */
+    configuration_init_error = configuration_init(argv[0], NULL);
+    if (configuration_init_error != NULL) {
+        fprintf(stderr, "dissect-bench: Can't get pathname of directory containing "
+                        "the dissect-bench program: %s.\n",
+            configuration_init_error);
+        g_free(configuration_init_error);
+    }
+
+    static const struct report_message_routines bench_report_routines = {
+        failure_message,
+        failure_message,
+        open_failure_message,
+        read_failure_message,
+        write_failure_message,
+        cfile_open_failure_message,
+        cfile_dump_open_failure_message,
+        cfile_read_failure_message,
+        cfile_write_failure_message,
+        cfile_close_failure_message
+    };
+
+    init_report_message("dissect-bench", &bench_report_routines);
+
+    timestamp_set_type(TS_RELATIVE);
+    timestamp_set_seconds_type(TS_SECONDS_DEFAULT);
+
+    /*
+     * Libwiretap must be initialized before libwireshark is, so that
+     * dissection-time handlers for file-type-dependent blocks can
+     * register using the file type/subtype value for the file type.
+     */
+    wtap_init(TRUE);
+
+    /* Register all dissectors. */
+    if (!epan_init(NULL, NULL, TRUE)) {
+        exit_status = WS_EXIT_INIT_FAILED;
+        goto clean_exit;
+    }
+
+    /* Load libwireshark settings from the current profile. */
+    epan_load_settings();
+
+    while ((opt = ws_getopt_long(argc, argv, "0hm:n:o:T:vY:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case '0':
+                opt_optimize = FALSE;
+                break;
+            case 'h':
+                show_help_header(NULL);
+                print_usage(stdout);
+                goto clean_exit;
+            case 'm':
+                if (!parse_modes(ws_optarg)) {
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+            case 'n':
+                opt_iterations = (guint)get_positive_int(ws_optarg, "iteration count");
+                break;
+            case 'o':
+                err_msg = NULL;
+                switch (prefs_set_pref(ws_optarg, &err_msg)) {
+                    case PREFS_SET_OK:
+                        break;
+                    case PREFS_SET_SYNTAX_ERR:
+                        cmdarg_err("Invalid -o flag \"%s\"%s%s", ws_optarg,
+                                err_msg ? ": " : "", err_msg ? err_msg : "");
+                        g_free(err_msg);
+                        exit_status = WS_EXIT_INVALID_OPTION;
+                        goto clean_exit;
+                    case PREFS_SET_NO_SUCH_PREF:
+                    case PREFS_SET_OBSOLETE:
+                        cmdarg_err("-o flag \"%s\" specifies unknown preference", ws_optarg);
+                        exit_status = WS_EXIT_INVALID_OPTION;
+                        goto clean_exit;
+                }
+                break;
+            case 'T':
+                if (strcmp(ws_optarg, "json") == 0) {
+                    opt_json = TRUE;
+                } else if (strcmp(ws_optarg, "text") == 0) {
+                    opt_json = FALSE;
+                } else {
+                    cmdarg_err("Invalid -T parameter \"%s\"; use text or json", ws_optarg);
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+            case 'v':
+                show_version();
+                goto clean_exit;
+            case 'Y':
+                opt_filter = ws_optarg;
+                break;
+            default: /* wrong option */
+                print_usage(stderr);
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+        }
+    }
+
+    if (argc == ws_optind) {
+        print_usage(stderr);
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+    }
+
+    /* Notify all registered modules that have had any of their preferences changed. */
+    prefs_apply_all();
+
+    if (opt_modes[BENCH_FILTER] || opt_modes[BENCH_DFILTER]) {
+        unsigned df_flags = DF_EXPAND_MACROS;
+
+        if (opt_optimize)
+            df_flags |= DF_OPTIMIZE;
+        if (!dfilter_compile_full(opt_filter, &dfcode, &df_err, df_flags, "dissect-bench")) {
+            cmdarg_err("%s", df_err->msg);
+            df_error_free(&df_err);
+            exit_status = WS_EXIT_INVALID_FILTER;
+            goto clean_exit;
+        }
+    }
+
+    files = g_ptr_array_new_with_free_func(g_free);
+    for (i = ws_optind; i < (guint)argc; i++)
+        add_input(files, argv[i]);
+
+    if (opt_json) {
+        json_dumper_begin_object(&dumper);
+        json_dumper_set_member_name(&dumper, "version");
+        json_dumper_value_string(&dumper, get_ws_vcs_version_info());
+        json_member_uint64(&dumper, "iterations", opt_iterations);
+        json_dumper_set_member_name(&dumper, "filter");
+        json_dumper_value_string(&dumper, opt_filter);
+        json_dumper_set_member_name(&dumper, "optimize");
+        json_dumper_value_anyf(&dumper, "%s", opt_optimize ? "true" : "false");
+        json_dumper_set_member_name(&dumper, "captures");
+        json_dumper_begin_array(&dumper);
+    } else {
+        printf("%s, %u iterations\n", get_ws_vcs_version_info(), opt_iterations);
+    }
+
+    for (i = 0; i < files->len; i++)
+        bench_capture_file((const char *)files->pdata[i], dfcode, opt_json ? &dumper : NULL);
+
+    if (opt_json) {
+        json_dumper_end_array(&dumper);
+        json_dumper_end_object(&dumper);
+        json_dumper_finish(&dumper);
+    }
+
+    g_ptr_array_free(files, TRUE);
+    dfilter_free(dfcode);
+
+clean_exit:
+    epan_cleanup();
+    wtap_cleanup();
+    free_progdirs();
+    return exit_status;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
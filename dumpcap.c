@@ -46,10 +46,12 @@
 #endif
 
 #include "ringbuffer.h"
+#include "capture_ring.h"
 
 #include "capture/capture_ifinfo.h"
 #include "capture/capture-pcap-util.h"
 #include "capture/capture-pcap-util-int.h"
+#include "capture/capture_shm.h"
 #ifdef _WIN32
 #include "capture/capture-wpcap.h"
 #endif /* _WIN32 */
@@ -123,6 +125,12 @@ static gint64 pcap_queue_packets;
 static gint64 pcap_queue_byte_limit = 0;
 static gint64 pcap_queue_packet_limit = 0;
 
+static guint output_flush_latency = PCAPIO_WRITER_DEFAULT_FLUSH_LATENCY_MS;
+static guint output_flags = 0;
+
+/* Ring through which we hand packets to our parent, if it gave us one */
+static capture_shm_t *capture_shm = NULL;
+
 static gboolean capture_child = FALSE; /* FALSE: standalone call, TRUE: this is an Wireshark capture child */
 static const char *report_capture_filename = NULL; /* capture child file name */
 #ifdef _WIN32
@@ -270,6 +278,8 @@ typedef struct _capture_src {
     guint32                      received;
     guint32                      dropped;
     guint32                      flushed;
+    guint32                      discarded;              /**< Packets kept for a trigger that didn't come */
+    guint32                      shm_dropped;            /**< Packets written but not handed to the parent in shared memory */
     pcap_t                      *pcap_h;
 #ifdef MUST_DO_SELECT
     int                          pcap_fd;                /**< pcap file descriptor */
@@ -340,9 +350,8 @@ typedef struct _loop_data {
     GArray   *saved_idbs;          /**< Array of saved_idb_t, written when we have a new section or output file. */
     GRWLock   saved_shb_idb_lock;  /**< Saved IDB RW mutex */
     /* output file(s) */
-    FILE     *pdh;
+    pcapio_writer_t *pdh;
     int       save_file_fd;
-    char     *io_buffer;           /**< Our IO buffer if we increase the size from the standard size */
     guint64   bytes_written;       /**< Bytes written for the current file. */
     /* autostop conditions */
     int       packets_written;     /**< Packets written for the current file. */
@@ -351,6 +360,15 @@ typedef struct _loop_data {
     GTimer  *file_duration_timer;
     time_t   next_interval_time;
     int      interval_s;
+    /* pre-trigger buffering */
+    capture_ring_t *trigger_ring;  /**< Packets kept until a trigger fires, or NULL */
+    gboolean  triggered;           /**< TRUE while writing the packets that follow a trigger */
+    guint64   post_trigger_end;    /**< Time stamp, in ns, of the last packet to write after a trigger */
+    guint64   last_ts;             /**< Time stamp, in ns, of the newest packet */
+    guint     kept_reported;       /**< Packets kept as of the last report of them */
+    /* handing packets to the parent in shared memory */
+    capture_shm_t *shm;            /**< Ring the packets written go into, or NULL */
+    gboolean  shm_stalled;         /**< TRUE if the parent didn't make room in time for the last packet */
 } loop_data;
 
 typedef struct _pcap_queue_element {
@@ -417,12 +435,36 @@ static gboolean quiet = FALSE;
 static gboolean use_threads = FALSE;
 static guint64 start_time;
 
+/*
+ * Pre-trigger buffering: packets are kept in an in-memory ring rather
+ * than written, and the ring is only written out when a trigger fires,
+ * followed by the packets of the post-trigger period.
+ */
+typedef struct {
+    gboolean    enabled;
+    guint32     ring_size;          /**< Size of the ring, in kB */
+    gboolean    has_duration;
+    gdouble     duration;           /**< Seconds of packets to keep */
+    gdouble     post_duration;      /**< Seconds of packets to write after a trigger */
+    GPtrArray  *filters;            /**< Capture filters that fire the trigger */
+    GPtrArray  *patterns;           /**< GByteArrays that fire the trigger */
+    GHashTable *programs;           /**< Link-layer type -> GArray of compiled filters */
+} trigger_options_t;
+
+#define DEFAULT_PRETRIGGER_RING_SIZE (64*1000)   /* kB */
+
+static trigger_options_t trigger_opts;
+static volatile sig_atomic_t trigger_requested = 0;   /* Set by SIGUSR1 or the signal pipe */
+
 static void capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                          const u_char *pd);
 static void capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
                                          const u_char *pd);
 static void capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd);
 static void capture_loop_queue_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd);
+static GArray *trigger_programs(int linktype, char **err_str);
+static void trigger_ring_discarded(guint32 tag, void *user_data);
+static void capture_loop_fire_trigger(void);
 static void capture_loop_get_errmsg(char *errmsg, size_t errmsglen,
                                     char *secondary_errmsg,
                                     size_t secondary_errmsglen,
@@ -434,6 +476,7 @@ WS_NORETURN static void exit_main(int err);
 static void report_new_capture_file(const char *filename);
 static void report_packet_count(unsigned int packet_count);
 static void report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32 flushed, guint32 ps_ifdrop, gchar *name);
+static void report_packets_discarded(guint32 discarded, gchar *name);
 static void report_capture_error(const char *error_msg, const char *secondary_error_msg);
 static void report_cfilter_error(capture_options *capture_opts, guint i, const char *errmsg);
 
@@ -523,6 +566,26 @@ print_usage(FILE *output)
     fprintf(output, "                           (only for pcapng)\n");
     fprintf(output, "  --temp-dir <directory>   write temporary files to this directory\n");
     fprintf(output, "                           (default: %s)\n", g_get_tmp_dir());
+    fprintf(output, "  --flush-latency <ms>     write packets out at most <ms> milliseconds after\n");
+    fprintf(output, "                           they're captured (def: %u)\n", PCAPIO_WRITER_DEFAULT_FLUSH_LATENCY_MS);
+#ifdef __linux__
+    fprintf(output, "  --direct-io              write output files with O_DIRECT, bypassing the\n");
+    fprintf(output, "                           page cache\n");
+#endif
+    fprintf(output, "\n");
+    fprintf(output, "Pre-trigger buffering:\n");
+    fprintf(output, "  --pre-trigger <cond> ... keep packets in memory and write them only when\n");
+    fprintf(output, "                           a trigger fires\n");
+    fprintf(output, "                           duration:NUM - keep the last NUM secs of packets\n");
+    fprintf(output, "                               size:NUM - keep at most NUM kB (def: %u)\n", DEFAULT_PRETRIGGER_RING_SIZE);
+    fprintf(output, "  --trigger <cond> ...     fire the trigger on a packet that matches\n");
+    fprintf(output, "                             filter:FILTER - a capture filter\n");
+    fprintf(output, "                                pattern:HEX - a sequence of bytes\n");
+#ifndef _WIN32
+    fprintf(output, "                           or on SIGUSR1\n");
+#endif
+    fprintf(output, "  --post-trigger <secs>    after a trigger, also write the packets of the\n");
+    fprintf(output, "                           next <secs> seconds (def: 0)\n");
     fprintf(output, "\n");
 
     ws_log_print_usage(output);
@@ -1274,6 +1337,15 @@ report_counts_siginfo(int signum _U_)
 }
 #endif /* SIGINFO */
 
+#ifndef _WIN32
+static void
+trigger_usr1_handler(int signum _U_)
+{
+    /* The capture loop fires the trigger; it's not safe to do here. */
+    trigger_requested = 1;
+}
+#endif
+
 static void
 exit_main(int status)
 {
@@ -3560,27 +3632,10 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
 
     /* Set up to write to the capture file. */
     if (capture_opts->multi_files_on) {
-        ld->pdh = ringbuf_init_libpcap_fdopen(&err);
+        ld->pdh = ringbuf_init_libpcap_fdopen(output_flush_latency, output_flags, &err);
     } else {
-        ld->pdh = ws_fdopen(ld->save_file_fd, "wb");
-        if (ld->pdh == NULL) {
-            err = errno;
-        } else {
-            size_t buffsize = IO_BUF_SIZE;
-#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
-            ws_statb64 statb;
-
-            if (ws_fstat64(ld->save_file_fd, &statb) == 0) {
-                if (statb.st_blksize > IO_BUF_SIZE) {
-                    buffsize = statb.st_blksize;
-                }
-            }
-#endif
-            /* Increase the size of the IO buffer */
-            ld->io_buffer = (char *)g_malloc(buffsize);
-            setvbuf(ld->pdh, ld->io_buffer, _IOFBF, buffsize);
-            ws_debug("capture_loop_init_output: buffsize %zu", buffsize);
-        }
+        ld->pdh = pcapio_writer_fdopen(ld->save_file_fd, 0, output_flush_latency,
+                                       output_flags, &err);
     }
     if (ld->pdh) {
         gboolean successful;
@@ -3598,10 +3653,8 @@ capture_loop_init_output(capture_options *capture_opts, loop_data *ld, char *err
                                                 pcap_src->ts_nsec, &ld->bytes_written, &err);
         }
         if (!successful) {
-            fclose(ld->pdh);
+            pcapio_writer_close(ld->pdh, NULL);
             ld->pdh = NULL;
-            g_free(ld->io_buffer);
-            ld->io_buffer = NULL;
         }
     }
 
@@ -3665,16 +3718,8 @@ capture_loop_close_output(capture_options *capture_opts, loop_data *ld, int *err
                 }
             }
         }
-        if (fclose(ld->pdh) == EOF) {
-            if (err_close != NULL) {
-                *err_close = errno;
-            }
-            success = FALSE;
-        } else {
-            success = TRUE;
-        }
-        g_free(ld->io_buffer);
-        ld->io_buffer = NULL;
+        success = pcapio_writer_close(ld->pdh, err_close);
+        ld->pdh = NULL;
         return success;
     }
 }
@@ -4123,11 +4168,9 @@ do_file_switch_or_stop(capture_options *capture_opts)
             }
 
             if (!successful) {
-                fclose(global_ld.pdh);
+                pcapio_writer_close(global_ld.pdh, NULL);
                 global_ld.pdh = NULL;
                 global_ld.go = FALSE;
-                g_free(global_ld.io_buffer);
-                global_ld.io_buffer = NULL;
                 return FALSE;
             }
             if (global_ld.file_duration_timer) {
@@ -4136,7 +4179,7 @@ do_file_switch_or_stop(capture_options *capture_opts)
             if (global_ld.next_interval_time) {
                 global_ld.next_interval_time = get_next_time_interval(global_ld.interval_s);
             }
-            fflush(global_ld.pdh);
+            pcapio_writer_flush(global_ld.pdh, NULL);
             if (global_ld.inpkts_to_sync_pipe) {
                 if (!quiet)
                     report_packet_count(global_ld.inpkts_to_sync_pipe);
@@ -4281,11 +4324,13 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
     global_ld.err                 = 0;  /* no error seen yet */
     global_ld.pdh                 = NULL;
     global_ld.save_file_fd        = -1;
-    global_ld.io_buffer           = NULL;
     global_ld.file_count          = 0;
     global_ld.file_duration_timer = NULL;
     global_ld.next_interval_time  = 0;
     global_ld.interval_s          = 0;
+    global_ld.trigger_ring        = NULL;
+    global_ld.shm                 = NULL;
+    global_ld.shm_stalled         = FALSE;
 
     /* We haven't yet gotten the capture statistics. */
     *stats_known      = FALSE;
@@ -4328,6 +4373,54 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         }
     }
 
+    if (trigger_opts.enabled) {
+        /* Allocate the pre-trigger ring up front, so that it's never
+           short of memory while capturing. */
+        global_ld.trigger_ring = capture_ring_new((gsize)trigger_opts.ring_size * 1000,
+                                                  trigger_ring_discarded, NULL);
+        if (global_ld.trigger_ring == NULL) {
+            snprintf(errmsg, sizeof(errmsg),
+                     "Couldn't allocate a %u kB pre-trigger buffer.", trigger_opts.ring_size);
+            goto error;
+        }
+        global_ld.triggered = FALSE;
+        global_ld.post_trigger_end = 0;
+        global_ld.last_ts = 0;
+
+        /* Check the trigger filters now for the link-layer types we
+           know; those of pcapng sources are only known later. */
+        for (i = 0; i < global_ld.pcaps->len && trigger_opts.filters != NULL; i++) {
+            char *err_str;
+
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            if (pcap_src->from_pcapng)
+                continue;
+            trigger_programs(pcap_src->linktype, &err_str);
+            if (err_str != NULL) {
+                snprintf(errmsg, sizeof(errmsg), "%s", err_str);
+                g_free(err_str);
+                goto error;
+            }
+        }
+    }
+
+    /* Tell our parent, before it opens the first capture file, whether
+       it'll get the packets in shared memory. The interfaces of pcapng
+       sources are only described by blocks in the file, so it has to
+       read their packets from the file. */
+    if (capture_shm != NULL) {
+        gboolean producing = capture_opts->saving_to_file;
+
+        for (i = 0; i < global_ld.pcaps->len; i++) {
+            pcap_src = g_array_index(global_ld.pcaps, capture_src *, i);
+            if (pcap_src->from_pcapng)
+                producing = FALSE;
+        }
+        capture_shm_set_producing(capture_shm, producing);
+        if (producing)
+            global_ld.shm = capture_shm;
+    }
+
     /* If we're supposed to write to a capture file, open it for output
        (temporary/specified name/ringbuffer) */
     if (capture_opts->saving_to_file) {
@@ -4355,7 +4448,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
            message to our parent so that they'll open the capture file and
            update its windows to indicate that we have a live capture in
            progress. */
-        fflush(global_ld.pdh);
+        pcapio_writer_flush(global_ld.pdh, NULL);
         report_new_capture_file(capture_opts->save_file);
     }
 
@@ -4446,11 +4539,19 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
         }
 #endif
 
-        if (inpkts > 0) {
-            if (capture_opts->output_to_pipe) {
-                fflush(global_ld.pdh);
+        /* Were we asked to fire the trigger? */
+        if (trigger_requested) {
+            trigger_requested = 0;
+            if (global_ld.trigger_ring != NULL && global_ld.go) {
+                capture_loop_fire_trigger();
             }
-        } /* inpkts */
+        }
+
+        /* Write out what's been waiting for too long, whether or not
+           we got any packets this time. */
+        if (global_ld.pdh != NULL) {
+            pcapio_writer_flush_if_due(global_ld.pdh, NULL);
+        }
 
         /* Only update after an interval so as not to overload slow displays.
          * This also prevents too much context-switching between the dumpcap
@@ -4478,7 +4579,7 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             /* Let the parent process know. */
             if (global_ld.inpkts_to_sync_pipe) {
                 /* do sync here */
-                fflush(global_ld.pdh);
+                pcapio_writer_flush(global_ld.pdh, NULL);
 
                 /* Send our parent a message saying we've written out
                    "global_ld.inpkts_to_sync_pipe" packets to the capture file. */
@@ -4488,6 +4589,14 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 global_ld.inpkts_to_sync_pipe = 0;
             }
 
+            /* Say how many packets are waiting for a trigger, if that's
+               changed. */
+            if (global_ld.trigger_ring != NULL &&
+                capture_ring_count(global_ld.trigger_ring) != global_ld.kept_reported) {
+                global_ld.kept_reported = capture_ring_count(global_ld.trigger_ring);
+                ws_info("%u packets kept before a trigger.", global_ld.kept_reported);
+            }
+
             /* check capture duration condition */
             if (autostop_duration_timer != NULL && g_timer_elapsed(autostop_duration_timer, NULL) >= capture_opts->autostop_duration) {
                 /* The maximum capture time has elapsed; stop the capture. */
@@ -4525,12 +4634,16 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
             if (!dequeued) {
                 break;
             }
-            if (capture_opts->output_to_pipe) {
-                fflush(global_ld.pdh);
+            if (global_ld.pdh != NULL) {
+                pcapio_writer_flush_if_due(global_ld.pdh, NULL);
             }
         }
     }
 
+    /* The trigger never fired for whatever is still being kept. */
+    if (global_ld.trigger_ring != NULL) {
+        capture_ring_clear(global_ld.trigger_ring);
+    }
 
     /* delete stop conditions */
     if (global_ld.file_duration_timer != NULL)
@@ -4718,8 +4831,15 @@ capture_loop_start(capture_options *capture_opts, gboolean *stats_known, struct
                 report_capture_error(errmsg, please_report_bug());
             }
         }
-        report_packet_drops(received, pcap_dropped, pcap_src->dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->display_name);
+        /* Packets our parent didn't get in shared memory are dropped as
+           far as it's concerned, although they're in the file. */
+        report_packet_drops(received, pcap_dropped, pcap_src->dropped + pcap_src->shm_dropped, pcap_src->flushed, stats->ps_ifdrop, interface_opts->display_name);
+        if (global_ld.trigger_ring != NULL) {
+            report_packets_discarded(pcap_src->discarded, interface_opts->display_name);
+        }
     }
+    capture_ring_free(global_ld.trigger_ring);
+    global_ld.trigger_ring = NULL;
 
     /* close the input file (pcap or capture pipe) */
     capture_loop_close_input(&global_ld);
@@ -4751,6 +4871,9 @@ error:
     else
         report_capture_error(errmsg, secondary_errmsg);
 
+    capture_ring_free(global_ld.trigger_ring);
+    global_ld.trigger_ring = NULL;
+
     /* close the input file (pcap or cap_pipe) */
     capture_loop_close_input(&global_ld);
 
@@ -4844,13 +4967,13 @@ capture_loop_wrote_one_packet(capture_src *pcap_src) {
 
     /* check -c NUM */
     if (global_capture_opts.has_autostop_packets && global_ld.packets_captured >= global_capture_opts.autostop_packets) {
-        fflush(global_ld.pdh);
+        pcapio_writer_flush(global_ld.pdh, NULL);
         global_ld.go = FALSE;
         return;
     }
     /* check -a packets:NUM (treat like -c NUM) */
     if (global_capture_opts.has_autostop_written_packets && global_ld.packets_captured >= global_capture_opts.autostop_written_packets) {
-        fflush(global_ld.pdh);
+        pcapio_writer_flush(global_ld.pdh, NULL);
         global_ld.go = FALSE;
         return;
     }
@@ -4869,40 +4992,12 @@ capture_loop_wrote_one_packet(capture_src *pcap_src) {
     }
 }
 
-/* one pcapng block was captured, process it */
+/* Write one pcapng block to the output file. */
 static void
-capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd)
+capture_loop_write_pcapng_block(capture_src *pcap_src, const pcapng_block_header_t *bh, const u_char *pd)
 {
     int          err;
 
-    /*
-     * This should never be called if we're not writing pcapng.
-     */
-    ws_assert(global_capture_opts.use_pcapng);
-
-    /* We may be called multiple times from pcap_dispatch(); if we've set
-       the "stop capturing" flag, ignore this packet, as we're not
-       supposed to be saving any more packets. */
-    if (!global_ld.go) {
-        pcap_src->flushed++;
-        return;
-    }
-
-    if (!pcapng_adjust_block(pcap_src, bh, pd)) {
-        ws_info("%s failed to adjust pcapng block.", G_STRFUNC);
-        ws_assert_not_reached();
-        return;
-    }
-
-    if (bh->block_type == BLOCK_TYPE_SHB && !global_ld.pcapng_passthrough) {
-        /*
-         * capture_loop_init_pcapng_output should've handled this. We need
-         * to write ISBs when they're initially read so we shouldn't skip
-         * them here.
-         */
-        return;
-    }
-
     if (global_ld.pdh) {
         gboolean successful;
 
@@ -4914,7 +5009,6 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
                                        bh->block_total_length,
                                        &global_ld.bytes_written, &err);
 
-        fflush(global_ld.pdh);
         if (!successful) {
             global_ld.go = FALSE;
             global_ld.err = err;
@@ -4931,31 +5025,75 @@ capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t
             ws_info("Sending SP_FILE on first SHB");
 #endif
             /* SHB is now ready for capture parent to read on SP_FILE message */
+            pcapio_writer_flush(global_ld.pdh, NULL);
             sync_pipe_write_string_msg(2, SP_FILE, report_capture_filename);
             report_capture_filename = NULL;
         }
     }
 }
 
-/* one pcap packet was captured, process it */
+/*
+ * Hand a packet that's been written to our parent in shared memory. If
+ * the parent is behind, tell it about the packets written so far, so
+ * that it reads them, and wait a while for it to make room; if it
+ * doesn't, give up on the packet, which is still in the file, and don't
+ * wait again until there's room.
+ */
 static void
-capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
-                             const u_char *pd)
+capture_loop_publish_packet(capture_src *pcap_src, const struct pcap_pkthdr *phdr,
+                            const u_char *pd, guint64 file_offset)
 {
-    capture_src *pcap_src = (capture_src *) (void *) pcap_src_p;
-    int          err;
-    guint        ts_mul    = pcap_src->ts_nsec ? 1000000000 : 1000000;
+    capture_shm_packet_t pkt;
+    gint64 deadline;
 
-    ws_debug("capture_loop_write_packet_cb");
+    if (!capture_shm_consumer_reading(global_ld.shm)) {
+        /* Our parent is reading the file instead. */
+        global_ld.shm = NULL;
+        return;
+    }
 
-    /* We may be called multiple times from pcap_dispatch(); if we've set
-       the "stop capturing" flag, ignore this packet, as we're not
-       supposed to be saving any more packets. */
-    if (!global_ld.go) {
-        pcap_src->flushed++;
+    pkt.file_offset = file_offset;
+    pkt.ts_sec = phdr->ts.tv_sec;
+    pkt.ts_nsec = (guint32)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000);
+    pkt.interface_id = global_capture_opts.use_pcapng ? pcap_src->idb_id : 0;
+    pkt.caplen = phdr->caplen;
+    pkt.len = phdr->len;
+    if (capture_shm_put(global_ld.shm, &pkt, pd)) {
+        global_ld.shm_stalled = FALSE;
+        return;
+    }
+    if (global_ld.shm_stalled) {
+        pcap_src->shm_dropped++;
         return;
     }
 
+    if (global_ld.inpkts_to_sync_pipe) {
+        pcapio_writer_flush(global_ld.pdh, NULL);
+        if (!quiet)
+            report_packet_count(global_ld.inpkts_to_sync_pipe);
+        global_ld.inpkts_to_sync_pipe = 0;
+    }
+    deadline = g_get_monotonic_time() + CAPTURE_SHM_WAIT_MS * 1000;
+    do {
+        g_usleep(1000);
+        if (capture_shm_put(global_ld.shm, &pkt, pd))
+            return;
+    } while (g_get_monotonic_time() < deadline &&
+             capture_shm_consumer_reading(global_ld.shm));
+    ws_info("Parent didn't make room in shared memory; packets are only in the file.");
+    global_ld.shm_stalled = TRUE;
+    pcap_src->shm_dropped++;
+}
+
+/* Write one pcap packet to the output file. */
+static void
+capture_loop_write_pcap_packet(capture_src *pcap_src, const struct pcap_pkthdr *phdr,
+                               const u_char *pd)
+{
+    int          err;
+    guint        ts_mul    = pcap_src->ts_nsec ? 1000000000 : 1000000;
+    guint64      file_offset = global_ld.bytes_written;
+
     if (global_ld.pdh) {
         gboolean successful;
 
@@ -4987,11 +5125,412 @@ capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
             ws_info("Wrote a pcap packet of length %d captured on interface %u.",
                    phdr->caplen, pcap_src->interface_id);
 #endif
+            if (global_ld.shm != NULL)
+                capture_loop_publish_packet(pcap_src, phdr, pd, file_offset);
             capture_loop_wrote_one_packet(pcap_src);
         }
     }
 }
 
+/*
+ * Compile the trigger filters for a link-layer type, the first time a
+ * packet of that type is seen. A filter that can't be compiled for it
+ * never matches; *err_str describes the first of those.
+ */
+static GArray *
+trigger_programs(int linktype, char **err_str)
+{
+    GArray *programs;
+    pcap_t *pcap_h;
+    struct bpf_program fcode;
+
+    *err_str = NULL;
+    programs = (GArray *)g_hash_table_lookup(trigger_opts.programs, GINT_TO_POINTER(linktype));
+    if (programs != NULL)
+        return programs;
+
+    programs = g_array_new(FALSE, TRUE, sizeof(struct bpf_program));
+    /*
+     * LINKTYPE_ and DLT_ values only differ for a few link-layer types,
+     * none of which a trigger filter is likely to be used with.
+     */
+    pcap_h = pcap_open_dead(linktype, WTAP_MAX_PACKET_SIZE_STANDARD);
+    for (guint i = 0; i < trigger_opts.filters->len; i++) {
+        const char *filter = (const char *)g_ptr_array_index(trigger_opts.filters, i);
+        int ret = -1;
+
+        memset(&fcode, 0, sizeof(fcode));
+        if (pcap_h != NULL) {
+            /* The netmask is only used by filters for IP broadcasts;
+               we don't know it, as in compile_capture_filter(). */
+DIAG_OFF(cast-qual)
+            ret = pcap_compile(pcap_h, &fcode, (char *)filter, 1, 0);
+DIAG_ON(cast-qual)
+        }
+        if (ret < 0) {
+            if (*err_str == NULL) {
+                *err_str = ws_strdup_printf("The trigger filter \"%s\" can't be used with link-layer type %d%s%s.",
+                                            filter, linktype,
+                                            pcap_h ? ": " : "", pcap_h ? pcap_geterr(pcap_h) : "");
+            }
+            memset(&fcode, 0, sizeof(fcode));
+        }
+        g_array_append_val(programs, fcode);
+    }
+    if (pcap_h != NULL)
+        pcap_close(pcap_h);
+
+    g_hash_table_insert(trigger_opts.programs, GINT_TO_POINTER(linktype), programs);
+    return programs;
+}
+
+static void
+trigger_programs_free(gpointer data)
+{
+    GArray *programs = (GArray *)data;
+
+    for (guint i = 0; i < programs->len; i++) {
+        struct bpf_program *fcode = &g_array_index(programs, struct bpf_program, i);
+        if (fcode->bf_insns != NULL)
+            pcap_freecode(fcode);
+    }
+    g_array_free(programs, TRUE);
+}
+
+/* Does a packet fire the trigger? */
+static gboolean
+trigger_matches(int linktype, const guint8 *pd, guint32 caplen, guint32 len)
+{
+    GArray *programs;
+    char *err_str;
+    struct pcap_pkthdr phdr;
+
+    for (guint i = 0; trigger_opts.patterns != NULL && i < trigger_opts.patterns->len; i++) {
+        GByteArray *pattern = (GByteArray *)g_ptr_array_index(trigger_opts.patterns, i);
+        const guint8 *p = pd, *end = pd + caplen;
+
+        while ((gsize)(end - p) >= pattern->len &&
+               (p = (const guint8 *)memchr(p, pattern->data[0], (end - p) - pattern->len + 1)) != NULL) {
+            if (memcmp(p, pattern->data, pattern->len) == 0)
+                return TRUE;
+            p++;
+        }
+    }
+
+    if (trigger_opts.filters == NULL || linktype < 0)
+        return FALSE;
+    programs = trigger_programs(linktype, &err_str);
+    if (err_str != NULL) {
+        ws_warning("%s", err_str);
+        g_free(err_str);
+    }
+    memset(&phdr, 0, sizeof(phdr));
+    phdr.caplen = caplen;
+    phdr.len = len;
+    for (guint i = 0; i < programs->len; i++) {
+        struct bpf_program *fcode = &g_array_index(programs, struct bpf_program, i);
+        if (fcode->bf_insns != NULL && pcap_offline_filter(fcode, &phdr, pd))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* A packet kept for a trigger was discarded without being written. */
+static void
+trigger_ring_discarded(guint32 tag, void *user_data _U_)
+{
+    capture_src *pcap_src = g_array_index(global_ld.pcaps, capture_src *, tag);
+
+    pcap_src->discarded++;
+    /* Written packets are counted as received in capture_loop_wrote_one_packet(). */
+    if (!use_threads) {
+        pcap_src->received++;
+    }
+}
+
+static gboolean
+trigger_ring_write(guint32 tag, const guint8 *data, guint32 len _U_, void *user_data _U_)
+{
+    capture_src *pcap_src = g_array_index(global_ld.pcaps, capture_src *, tag);
+
+    if (pcap_src->from_pcapng) {
+        pcapng_block_header_t bh;
+
+        memcpy(&bh, data, sizeof(bh));
+        capture_loop_write_pcapng_block(pcap_src, &bh, data);
+    } else {
+        struct pcap_pkthdr phdr;
+
+        memcpy(&phdr, data, sizeof(phdr));
+        capture_loop_write_pcap_packet(pcap_src, &phdr, data + sizeof(phdr));
+    }
+    /* Stop if that was the last packet to write, or writing failed. */
+    return global_ld.go;
+}
+
+/*
+ * Fire the trigger: write out the packets kept so far, and those of the
+ * post-trigger period as they arrive.
+ */
+static void
+capture_loop_fire_trigger(void)
+{
+    guint64 now = global_ld.last_ts;
+
+    if (now == 0) {
+        /* No packets yet; the post-trigger period starts now. */
+        now = (guint64)g_get_real_time() * 1000;
+    }
+    ws_info("Trigger fired, writing %u packets kept before it.",
+            capture_ring_count(global_ld.trigger_ring));
+    global_ld.triggered = TRUE;
+    global_ld.post_trigger_end = now + (guint64)(trigger_opts.post_duration * 1000000000.0);
+    if (global_ld.pdh != NULL)
+        capture_ring_drain(global_ld.trigger_ring, trigger_ring_write, NULL);
+    else
+        capture_ring_clear(global_ld.trigger_ring);
+}
+
+/*
+ * Pre-trigger handling of a packet, with its time stamp in nanoseconds
+ * or 0 if it has none: keep it in the ring, unless a trigger fired
+ * recently enough that it's to be written now, in which case return TRUE.
+ */
+static gboolean
+capture_loop_trigger_packet(capture_src *pcap_src, guint64 ts, gboolean matched,
+                            const void *hdr, guint32 hdr_len,
+                            const u_char *pd, guint32 pd_len)
+{
+    guint64 duration;
+
+    if (ts != 0)
+        global_ld.last_ts = ts;
+    else
+        ts = global_ld.last_ts;
+
+    if (global_ld.triggered) {
+        if (matched) {
+            global_ld.post_trigger_end = ts + (guint64)(trigger_opts.post_duration * 1000000000.0);
+        }
+        if (ts <= global_ld.post_trigger_end)
+            return TRUE;
+        /* The post-trigger period is over; keep packets again. */
+        ws_info("Post-trigger period over, keeping packets again.");
+        global_ld.triggered = FALSE;
+    }
+
+    if (capture_ring_put(global_ld.trigger_ring, pcap_src->interface_id, ts,
+                         hdr, hdr_len, pd, pd_len)) {
+        if (trigger_opts.has_duration) {
+            duration = (guint64)(trigger_opts.duration * 1000000000.0);
+            if (ts > duration)
+                capture_ring_expire(global_ld.trigger_ring, ts - duration);
+        }
+    } else {
+        /* It's bigger than the whole ring. */
+        pcap_src->dropped++;
+    }
+
+    if (matched)
+        capture_loop_fire_trigger();
+    return FALSE;
+}
+
+/*
+ * Get the link-layer type and time stamp resolution, in units per
+ * second, of a pcapng interface.
+ */
+static gboolean
+capture_loop_saved_idb_info(guint32 iface_id, int *linktype, guint64 *ts_units)
+{
+    gboolean found = FALSE;
+
+    g_rw_lock_reader_lock(&global_ld.saved_shb_idb_lock);
+    if (iface_id < global_ld.saved_idbs->len) {
+        saved_idb_t *idb_source = &g_array_index(global_ld.saved_idbs, saved_idb_t, iface_id);
+        pcapng_interface_description_block_t idb;
+        const guint8 *opt, *end;
+        guint16 opt_code, opt_len;
+
+        if (idb_source->idb != NULL &&
+            idb_source->idb_len >= sizeof(pcapng_block_header_t) + sizeof(idb) + 4) {
+            memcpy(&idb, idb_source->idb + sizeof(pcapng_block_header_t), sizeof(idb));
+            *linktype = idb.linktype;
+            *ts_units = 1000000;
+
+            opt = idb_source->idb + sizeof(pcapng_block_header_t) + sizeof(idb);
+            end = idb_source->idb + idb_source->idb_len - 4;
+            while (end - opt >= 4) {
+                memcpy(&opt_code, opt, 2);
+                memcpy(&opt_len, opt + 2, 2);
+                if (opt_code == OPT_EOFOPT)
+                    break;
+                if (opt_code == OPT_IDB_TSRESOL && opt_len >= 1 && end - opt > 4) {
+                    guint8 resol = opt[4];
+                    guint exponent = resol & 0x7f;
+
+                    if (resol & 0x80) {
+                        /* A power of 2 */
+                        if (exponent < 64)
+                            *ts_units = G_GUINT64_CONSTANT(1) << exponent;
+                    } else if (exponent <= 19) {
+                        /* A power of 10 */
+                        *ts_units = 1;
+                        while (exponent-- > 0)
+                            *ts_units *= 10;
+                    }
+                    break;
+                }
+                opt += 4 + ((opt_len + 3) & ~3);
+            }
+            found = TRUE;
+        }
+    }
+    g_rw_lock_reader_unlock(&global_ld.saved_shb_idb_lock);
+    return found;
+}
+
+/*
+ * Pre-trigger handling of a pcapng block. Returns TRUE if the block is
+ * to be written now; blocks other than packets always are.
+ */
+static gboolean
+capture_loop_trigger_pcapng_block(capture_src *pcap_src, const pcapng_block_header_t *bh, const u_char *pd)
+{
+    const u_char *body = pd + sizeof(pcapng_block_header_t);
+    guint32 body_len = bh->block_total_length - (guint32)sizeof(pcapng_block_header_t) - 4;
+    guint32 fields[5], caplen;
+    guint64 ts = 0, ts_units;
+    int linktype;
+    gboolean matched = FALSE;
+
+    switch (bh->block_type) {
+
+    case BLOCK_TYPE_SHB:
+        if (global_ld.pcapng_passthrough) {
+            /* The interface IDs of the packets kept so far don't
+               mean anything in the new section. */
+            capture_ring_clear(global_ld.trigger_ring);
+        }
+        return TRUE;
+
+    case BLOCK_TYPE_EPB:
+        /* Interface ID, time stamp (high and low), captured length
+           and original length, followed by the packet data. */
+        if (body_len < sizeof(fields))
+            break;
+        memcpy(fields, body, sizeof(fields));
+        caplen = MIN(fields[3], body_len - (guint32)sizeof(fields));
+        if (capture_loop_saved_idb_info(fields[0], &linktype, &ts_units)) {
+            guint64 raw_ts = ((guint64)fields[1] << 32) | fields[2];
+
+            ts = raw_ts / ts_units * 1000000000 +
+                 (guint64)((double)(raw_ts % ts_units) * 1000000000.0 / (double)ts_units);
+        } else {
+            linktype = -1;
+        }
+        matched = trigger_matches(linktype, body + sizeof(fields), caplen, fields[4]);
+        break;
+
+    case BLOCK_TYPE_SPB:
+        /* Original length, followed by the packet data, which is
+           from the first interface. */
+        if (body_len < sizeof(fields[0]))
+            break;
+        memcpy(fields, body, sizeof(fields[0]));
+        caplen = MIN(fields[0], body_len - (guint32)sizeof(fields[0]));
+        if (!capture_loop_saved_idb_info(0, &linktype, &ts_units))
+            linktype = -1;
+        matched = trigger_matches(linktype, body + sizeof(fields[0]), caplen, fields[0]);
+        break;
+
+    case BLOCK_TYPE_SYSTEMD_JOURNAL_EXPORT:
+    case BLOCK_TYPE_SYSDIG_EVENT:
+    case BLOCK_TYPE_SYSDIG_EVENT_V2:
+    case BLOCK_TYPE_SYSDIG_EVENT_V2_LARGE:
+        /* Kept and written like packets, but not matched. */
+        break;
+
+    default:
+        return TRUE;
+    }
+
+    return capture_loop_trigger_packet(pcap_src, ts, matched, NULL, 0,
+                                       pd, bh->block_total_length);
+}
+
+/* one pcapng block was captured, process it */
+static void
+capture_loop_write_pcapng_cb(capture_src *pcap_src, const pcapng_block_header_t *bh, u_char *pd)
+{
+    /*
+     * This should never be called if we're not writing pcapng.
+     */
+    ws_assert(global_capture_opts.use_pcapng);
+
+    /* We may be called multiple times from pcap_dispatch(); if we've set
+       the "stop capturing" flag, ignore this packet, as we're not
+       supposed to be saving any more packets. */
+    if (!global_ld.go) {
+        pcap_src->flushed++;
+        return;
+    }
+
+    if (!pcapng_adjust_block(pcap_src, bh, pd)) {
+        ws_info("%s failed to adjust pcapng block.", G_STRFUNC);
+        ws_assert_not_reached();
+        return;
+    }
+
+    if (bh->block_type == BLOCK_TYPE_SHB && !global_ld.pcapng_passthrough) {
+        /*
+         * capture_loop_init_pcapng_output should've handled this. We need
+         * to write ISBs when they're initially read so we shouldn't skip
+         * them here.
+         */
+        return;
+    }
+
+    if (global_ld.trigger_ring != NULL &&
+        !capture_loop_trigger_pcapng_block(pcap_src, bh, pd)) {
+        return;
+    }
+
+    capture_loop_write_pcapng_block(pcap_src, bh, pd);
+}
+
+/* one pcap packet was captured, process it */
+static void
+capture_loop_write_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
+                             const u_char *pd)
+{
+    capture_src *pcap_src = (capture_src *) (void *) pcap_src_p;
+
+    ws_debug("capture_loop_write_packet_cb");
+
+    /* We may be called multiple times from pcap_dispatch(); if we've set
+       the "stop capturing" flag, ignore this packet, as we're not
+       supposed to be saving any more packets. */
+    if (!global_ld.go) {
+        pcap_src->flushed++;
+        return;
+    }
+
+    if (global_ld.trigger_ring != NULL) {
+        guint64 ts = (guint64)phdr->ts.tv_sec * 1000000000 +
+                     (guint64)phdr->ts.tv_usec * (pcap_src->ts_nsec ? 1 : 1000);
+        gboolean matched = trigger_matches(pcap_src->linktype, pd, phdr->caplen, phdr->len);
+
+        if (!capture_loop_trigger_packet(pcap_src, ts, matched,
+                                         phdr, (guint32)sizeof(*phdr),
+                                         pd, phdr->caplen)) {
+            return;
+        }
+    }
+
+    capture_loop_write_pcap_packet(pcap_src, phdr, pd);
+}
+
 /* one packet was captured, queue it */
 static void
 capture_loop_queue_packet_cb(u_char *pcap_src_p, const struct pcap_pkthdr *phdr,
@@ -5181,9 +5720,93 @@ gather_dumpcap_runtime_info(feature_list l)
     gather_caplibs_runtime_info(l);
 }
 
+/* Turn on pre-trigger buffering, the first time an option for it is given. */
+static void
+trigger_opts_enable(void)
+{
+    if (!trigger_opts.enabled) {
+        trigger_opts.enabled = TRUE;
+        trigger_opts.ring_size = DEFAULT_PRETRIGGER_RING_SIZE;
+        trigger_opts.programs = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                                      NULL, trigger_programs_free);
+    }
+}
+
+/* Handle a --pre-trigger argument, "duration:NUM" or "size:NUM". */
+static gboolean
+set_pre_trigger_option(const char *optarg_str_p)
+{
+    const char *p = strchr(optarg_str_p, ':');
+
+    if (p == NULL)
+        return FALSE;
+    trigger_opts_enable();
+    p++;
+    if (strncmp(optarg_str_p, "duration:", 9) == 0) {
+        trigger_opts.has_duration = TRUE;
+        trigger_opts.duration = get_positive_double(p, "pre-trigger duration");
+    } else if (strncmp(optarg_str_p, "size:", 5) == 0) {
+        trigger_opts.ring_size = get_nonzero_guint32(p, "pre-trigger ring size");
+    } else {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Handle a --trigger argument, "filter:FILTER" or "pattern:HEX". */
+static gboolean
+set_trigger_option(const char *optarg_str_p)
+{
+    if (strncmp(optarg_str_p, "filter:", 7) == 0) {
+        trigger_opts_enable();
+        if (trigger_opts.filters == NULL)
+            trigger_opts.filters = g_ptr_array_new_with_free_func(g_free);
+        g_ptr_array_add(trigger_opts.filters, g_strdup(optarg_str_p + 7));
+    } else if (strncmp(optarg_str_p, "pattern:", 8) == 0) {
+        GByteArray *pattern = g_byte_array_new();
+        const char *p = optarg_str_p + 8;
+        int hi, lo;
+        guint8 byte;
+
+        /* Hex digits in pairs, optionally separated. */
+        while (*p != '\0') {
+            if (*p == ':' || *p == '-' || *p == '.' || *p == ' ') {
+                p++;
+                continue;
+            }
+            hi = g_ascii_xdigit_value(p[0]);
+            lo = hi < 0 ? -1 : g_ascii_xdigit_value(p[1]);
+            if (lo < 0) {
+                g_byte_array_free(pattern, TRUE);
+                return FALSE;
+            }
+            byte = (guint8)(hi << 4 | lo);
+            g_byte_array_append(pattern, &byte, 1);
+            p += 2;
+        }
+        if (pattern->len == 0) {
+            g_byte_array_free(pattern, TRUE);
+            return FALSE;
+        }
+        trigger_opts_enable();
+        if (trigger_opts.patterns == NULL)
+            trigger_opts.patterns = g_ptr_array_new_with_free_func((GDestroyNotify)g_byte_array_unref);
+        g_ptr_array_add(trigger_opts.patterns, pattern);
+    } else {
+        return FALSE;
+    }
+    return TRUE;
+}
+
 #define LONGOPT_IFNAME             LONGOPT_BASE_APPLICATION+1
 #define LONGOPT_IFDESCR            LONGOPT_BASE_APPLICATION+2
 #define LONGOPT_CAPTURE_COMMENT    LONGOPT_BASE_APPLICATION+3
+#define LONGOPT_PRE_TRIGGER        LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_TRIGGER            LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_POST_TRIGGER       LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_FLUSH_LATENCY      LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_DIRECT_IO          LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_SHM_FD             LONGOPT_BASE_APPLICATION+9
 
 /* And now our feature presentation... [ fade to music ] */
 int
@@ -5198,6 +5821,12 @@ main(int argc, char *argv[])
         {"ifname", ws_required_argument, NULL, LONGOPT_IFNAME},
         {"ifdescr", ws_required_argument, NULL, LONGOPT_IFDESCR},
         {"capture-comment", ws_required_argument, NULL, LONGOPT_CAPTURE_COMMENT},
+        {"pre-trigger", ws_required_argument, NULL, LONGOPT_PRE_TRIGGER},
+        {"trigger", ws_required_argument, NULL, LONGOPT_TRIGGER},
+        {"post-trigger", ws_required_argument, NULL, LONGOPT_POST_TRIGGER},
+        {"flush-latency", ws_required_argument, NULL, LONGOPT_FLUSH_LATENCY},
+        {"direct-io", ws_no_argument, NULL, LONGOPT_DIRECT_IO},
+        {"shm-fd", ws_required_argument, NULL, LONGOPT_SHM_FD},
         {0, 0, 0, 0 }
     };
 
@@ -5572,6 +6201,40 @@ main(int argc, char *argv[])
             }
             g_ptr_array_add(capture_comments, g_strdup(ws_optarg));
             break;
+        case LONGOPT_PRE_TRIGGER:
+            if (!set_pre_trigger_option(ws_optarg)) {
+                cmdarg_err("Invalid or unknown --pre-trigger condition: %s", ws_optarg);
+                exit_main(1);
+            }
+            break;
+        case LONGOPT_TRIGGER:
+            if (!set_trigger_option(ws_optarg)) {
+                cmdarg_err("Invalid or unknown --trigger condition: %s", ws_optarg);
+                exit_main(1);
+            }
+            break;
+        case LONGOPT_POST_TRIGGER:
+            trigger_opts_enable();
+            trigger_opts.post_duration = get_positive_double(ws_optarg, "post-trigger duration");
+            break;
+        case LONGOPT_FLUSH_LATENCY:
+            output_flush_latency = get_natural_int(ws_optarg, "flush latency");
+            break;
+        case LONGOPT_DIRECT_IO:
+            output_flags |= PCAPIO_WRITER_DIRECT;
+            break;
+        case LONGOPT_SHM_FD:        /* hidden option, like -Z */
+        {
+            char *err_str;
+
+            capture_shm = capture_shm_attach(get_natural_int(ws_optarg, "shared memory descriptor"), &err_str);
+            if (capture_shm == NULL) {
+                cmdarg_err("%s", err_str);
+                g_free(err_str);
+                arg_error = TRUE;
+            }
+            break;
+        }
         case 'Z':
             capture_child = TRUE;
 #ifdef _WIN32
@@ -5946,6 +6609,16 @@ main(int argc, char *argv[])
     /* We're supposed to do a capture.  Process the ring buffer arguments. */
     capture_opts_trim_ring_num_files(&global_capture_opts);
 
+#ifndef _WIN32
+    /* Catch SIGUSR1 and, if we get it, fire the trigger; without
+       pre-trigger buffering there's nothing to fire, so don't let it
+       kill us. */
+    action.sa_handler = trigger_opts.enabled ? trigger_usr1_handler : SIG_IGN;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, NULL);
+#endif
+
     /* flush stderr prior to starting the main capture loop */
     fflush(stderr);
 
@@ -6131,6 +6804,22 @@ report_packet_drops(guint32 received, guint32 pcap_drops, guint32 drops, guint32
     }
 }
 
+/* Report the packets kept for a trigger that never fired */
+static void
+report_packets_discarded(guint32 discarded, gchar *name)
+{
+    if (capture_child) {
+        ws_debug("Packets discarded without a trigger on interface '%s': %u",
+            name, discarded);
+    } else {
+        fprintf(stderr,
+            "Packets discarded without a trigger on interface '%s': %u\n",
+            name, discarded);
+        /* stderr could be line buffered */
+        fflush(stderr);
+    }
+}
+
 
 /************************************************************************************************/
 /* signal_pipe handling */
@@ -6163,6 +6852,21 @@ signal_pipe_check_running(void)
 
     result = PeekNamedPipe(sig_pipe_handle, NULL, 0, NULL, &avail, NULL);
 
+    if (result && avail >= 4) {
+        /* Anything other than a trigger message stops the capture. */
+        guchar header[4];
+        DWORD  got = 0;
+
+        if (PeekNamedPipe(sig_pipe_handle, header, sizeof header, &got, NULL, NULL) &&
+            got == sizeof header && header[0] == SP_TRIGGER &&
+            header[1] == 0 && header[2] == 0 && header[3] == 0 &&
+            ReadFile(sig_pipe_handle, header, sizeof header, &got, NULL)) {
+            ws_info("Signal pipe: Fire trigger: %s", sig_pipe_name);
+            trigger_requested = 1;
+            return TRUE;
+        }
+    }
+
     if (!result || avail > 0) {
         /* peek failed or some bytes really available */
         /* (if not piping from stdin this would fail) */
@@ -17,6 +17,7 @@
 #include <epan/wmem_scopes.h>
 
 #include <wsutil/pint.h>
+#include <wsutil/str_scan.h>
 #include <wsutil/unicode-utils.h>
 
 #include "charsets.h"
@@ -83,28 +84,23 @@ guint8 *
 get_ascii_string(wmem_allocator_t *scope, const guint8 *ptr, gint length)
 {
     wmem_strbuf_t *str;
-    const guint8 *prev = ptr;
-    size_t valid_bytes = 0;
+    size_t valid_bytes;
 
     str = wmem_strbuf_new_sized(scope, length+1);
 
     while (length > 0) {
-        guint8 ch = *ptr++;
-
-        if (ch < 0x80) {
-            valid_bytes++;
-        } else {
-            if (valid_bytes) {
-                wmem_strbuf_append_len(str, prev, valid_bytes);
-                valid_bytes = 0;
-            }
-            prev = ptr;
+        valid_bytes = ws_ascii_span(ptr, length);
+        if (valid_bytes) {
+            wmem_strbuf_append_len(str, ptr, valid_bytes);
+            ptr += valid_bytes;
+            length -= (gint)valid_bytes;
+        }
+        if (length > 0) {
+            /* An octet with the high-order bit set */
             wmem_strbuf_append_unichar_repl(str);
+            ptr++;
+            length--;
         }
-        length--;
-    }
-    if (valid_bytes) {
-        wmem_strbuf_append_len(str, prev, valid_bytes);
     }
 
     return (guint8 *) wmem_strbuf_finalize(str);
@@ -766,6 +762,8 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
     gunichar2      uchar2, lead_surrogate;
     gunichar       uchar;
     gint           i = 0;       /* Byte counter for string */
+    guint8         ascii[128];
+    size_t         ascii_len;
 
     strbuf = wmem_strbuf_new_sized(scope, length+1);
 
@@ -782,6 +780,19 @@ get_utf_16_string(wmem_allocator_t *scope, const guint8 *ptr, gint length, guint
     encoding = encoding & ENC_LITTLE_ENDIAN;
 
     for(; i + 1 < length; i += 2) {
+        /*
+         * Copy any run of ASCII characters a vector at a time.
+         */
+        ascii_len = ws_utf16_ascii_span(ascii, ptr + i,
+                MIN((size_t)(length - i) / 2, sizeof ascii),
+                encoding == ENC_BIG_ENDIAN);
+        if (ascii_len) {
+            wmem_strbuf_append_len(strbuf, (const char *)ascii, ascii_len);
+            i += (gint)ascii_len * 2;
+            if (i + 1 >= length)
+                break;
+        }
+
         if (encoding == ENC_BIG_ENDIAN)
             uchar2 = pntoh16(ptr + i);
         else
@@ -56,6 +56,43 @@ static gboolean filters_enabled = TRUE;
  */
 static gboolean tmp_colors_set = FALSE;
 
+/* The enabled filters of 'color_filter_list', in order, and the same
+ * filters combined so that they can be applied together. Built when
+ * the first packet is colorized after the list changes. */
+static GPtrArray *color_multi_list = NULL;
+static dfilter_multi_t *color_multi = NULL;
+
+static void
+color_filters_multi_reset(void)
+{
+    dfilter_multi_free(color_multi);
+    color_multi = NULL;
+    if (color_multi_list) {
+        g_ptr_array_free(color_multi_list, TRUE);
+        color_multi_list = NULL;
+    }
+}
+
+static void
+color_filters_multi_build(void)
+{
+    GSList         *curr;
+    color_filter_t *colorf;
+    GPtrArray      *filters;
+
+    color_multi_list = g_ptr_array_new();
+    filters = g_ptr_array_new();
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if (!colorf->disabled && colorf->c_colorfilter != NULL) {
+            g_ptr_array_add(color_multi_list, colorf);
+            g_ptr_array_add(filters, colorf->c_colorfilter);
+        }
+    }
+    color_multi = dfilter_multi_new((dfilter_t * const *)filters->pdata, filters->len);
+    g_ptr_array_free(filters, TRUE);
+}
+
 /* Create a new filter */
 color_filter_t *
 color_filter_new(const gchar *name,          /* The name of the filter to create */
@@ -159,6 +196,9 @@ color_filters_set_tmp(guint8 filt_nr, const gchar *filter, gboolean disabled, gc
     dfilter_t      *compiled_filter;
     guint8         i;
     df_error_t     *df_err = NULL;
+
+    color_filters_multi_reset();
+
     /* Go through the temporary filters and look for the same filter string.
      * If found, clear it so that a filter can be "moved" up and down the list
      */
@@ -351,6 +391,7 @@ gboolean
 color_filters_init(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
     /* delete all currently existing filters */
+    color_filters_multi_reset();
     color_filter_list_delete(&color_filter_list);
 
     /* now try to construct the filters list */
@@ -362,6 +403,7 @@ color_filters_reload(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
+    color_filters_multi_reset();
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
 
@@ -460,6 +502,7 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, gchar** err_msg)
 
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
+    color_filters_multi_reset();
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
     color_filter_list = NULL;
 
@@ -569,21 +612,22 @@ color_filters_use_proto(int proto_id)
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
 {
-    GSList         *curr;
-    color_filter_t *colorf;
+    const guint64  *matched;
+    guint           i;
 
-    /* If we have color filters, "search" for the matching one. */
+    /* If we have color filters, "search" for the matching one. The
+     * filters are applied together, so that a field which several of
+     * them test is only read once, and the first one that matches wins. */
     if ((edt->tree != NULL) && (color_filters_used())) {
-        curr = color_filter_list;
-
-        while(curr != NULL) {
-            colorf = (color_filter_t *)curr->data;
-            if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
-                return colorf;
+        if (color_multi == NULL) {
+            color_filters_multi_build();
+        }
+
+        matched = dfilter_multi_apply_edt(color_multi, edt, NULL, DF_MULTI_FIRST_MATCH);
+        for (i = 0; i < color_multi_list->len; i++) {
+            if (DF_MULTI_MASK_TEST(matched, i)) {
+                return (const color_filter_t *)g_ptr_array_index(color_multi_list, i);
             }
-            curr = g_slist_next(curr);
         }
     }
 
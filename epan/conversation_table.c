@@ -629,23 +629,19 @@ add_conversation_table_data(conv_hash_t *ch, const address *src, const address *
     add_conversation_table_data_with_conv_id(ch, src, dst, src_port, dst_port, CONV_ID_UNSET, num_frames, num_bytes, ts, abs_ts, ct_info, ctype);
 }
 
-void
-add_conversation_table_data_with_conv_id(
-    conv_hash_t *ch,
-    const address *src,
-    const address *dst,
-    guint32 src_port,
-    guint32 dst_port,
-    conv_id_t conv_id,
-    int num_frames,
-    int num_bytes,
-    nstime_t *ts,
-    nstime_t *abs_ts,
-    ct_dissector_info_t *ct_info,
-    conversation_type ctype)
+/*
+ * Find the conversation between two address/port pairs in either direction,
+ * or append a new one with no packets if there isn't one yet.
+ */
+static conv_item_t *
+get_conversation_table_item(conv_hash_t *ch, const address *src, const address *dst, guint32 src_port,
+    guint32 dst_port, conv_id_t conv_id, nstime_t *ts, nstime_t *abs_ts, ct_dissector_info_t *ct_info,
+    conversation_type ctype, gboolean *is_new, gboolean *is_fwd_direction)
 {
     conv_item_t *conv_item = NULL;
-    gboolean is_fwd_direction = FALSE; /* direction of any conversation found */
+
+    *is_new = FALSE;
+    *is_fwd_direction = FALSE; /* direction of any conversation found */
 
     /* if we don't have any entries at all yet */
     if (ch->conv_array == NULL) {
@@ -680,7 +676,7 @@ add_conversation_table_data_with_conv_id(
             }
         } else {
             /* a conversation was found in this same fwd direction */
-            is_fwd_direction = TRUE;
+            *is_fwd_direction = TRUE;
         }
     }
 
@@ -706,6 +702,7 @@ add_conversation_table_data_with_conv_id(
         new_conv_item.tx_frames_total = 0;
         new_conv_item.rx_bytes_total = 0;
         new_conv_item.tx_bytes_total = 0;
+        new_conv_item.filtered = TRUE;
 
         if (ts) {
             memcpy(&new_conv_item.start_time, ts, sizeof(new_conv_item.start_time));
@@ -729,10 +726,38 @@ add_conversation_table_data_with_conv_id(
         new_key->conv_id = conv_id;
         g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
 
+        *is_new = TRUE;
+    }
+
+    return conv_item;
+}
+
+void
+add_conversation_table_data_with_conv_id(
+    conv_hash_t *ch,
+    const address *src,
+    const address *dst,
+    guint32 src_port,
+    guint32 dst_port,
+    conv_id_t conv_id,
+    int num_frames,
+    int num_bytes,
+    nstime_t *ts,
+    nstime_t *abs_ts,
+    ct_dissector_info_t *ct_info,
+    conversation_type ctype)
+{
+    conv_item_t *conv_item;
+    gboolean is_new;
+    gboolean is_fwd_direction;
+
+    conv_item = get_conversation_table_item(ch, src, dst, src_port, dst_port, conv_id, ts, abs_ts,
+                                            ct_info, ctype, &is_new, &is_fwd_direction);
+
+    if (is_new) {
         /* update the conversation struct */
         conv_item->tx_frames_total += num_frames;
         conv_item->tx_bytes_total += num_bytes;
-        conv_item->filtered = TRUE;
         if (! (ch->flags & TL_DISPLAY_FILTER_IGNORED)) {
             conv_item->tx_frames += num_frames;
             conv_item->tx_bytes += num_bytes;
@@ -772,6 +797,81 @@ add_conversation_table_data_with_conv_id(
     }
 }
 
+void *
+clone_conversation_table_hash(void *tapdata)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    conv_hash_t *clone = g_new0(conv_hash_t, 1);
+
+    clone->user_data = ch->user_data;
+    clone->flags = ch->flags;
+    return clone;
+}
+
+void
+merge_conversation_table_data(void *tapdata, void *shard)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    conv_hash_t *src = (conv_hash_t *)shard;
+    conv_item_t *item, *conv_item;
+    gboolean is_new;
+    gboolean is_fwd_direction;
+    gboolean have_ts;
+    guint i;
+
+    for (i = 0; src->conv_array != NULL && i < src->conv_array->len; i++) {
+        item = &g_array_index(src->conv_array, conv_item_t, i);
+        have_ts = !nstime_is_unset(&item->start_time);
+
+        conv_item = get_conversation_table_item(ch, &item->src_address, &item->dst_address,
+                                                item->src_port, item->dst_port, item->conv_id,
+                                                have_ts ? &item->start_time : NULL,
+                                                have_ts ? &item->start_abs_time : NULL,
+                                                item->dissector_info, item->ctype,
+                                                &is_new, &is_fwd_direction);
+
+        /* The other instance may have seen the conversation start from the
+         * other end first. */
+        if (is_new || is_fwd_direction) {
+            conv_item->tx_frames += item->tx_frames;
+            conv_item->tx_bytes += item->tx_bytes;
+            conv_item->rx_frames += item->rx_frames;
+            conv_item->rx_bytes += item->rx_bytes;
+            conv_item->tx_frames_total += item->tx_frames_total;
+            conv_item->tx_bytes_total += item->tx_bytes_total;
+            conv_item->rx_frames_total += item->rx_frames_total;
+            conv_item->rx_bytes_total += item->rx_bytes_total;
+        } else {
+            conv_item->tx_frames += item->rx_frames;
+            conv_item->tx_bytes += item->rx_bytes;
+            conv_item->rx_frames += item->tx_frames;
+            conv_item->rx_bytes += item->tx_bytes;
+            conv_item->tx_frames_total += item->rx_frames_total;
+            conv_item->tx_bytes_total += item->rx_bytes_total;
+            conv_item->rx_frames_total += item->tx_frames_total;
+            conv_item->rx_bytes_total += item->tx_bytes_total;
+        }
+        conv_item->filtered = conv_item->filtered && item->filtered;
+
+        if (have_ts && !is_new) {
+            if (nstime_is_unset(&conv_item->start_time) ||
+                    nstime_cmp(&item->start_time, &conv_item->start_time) < 0) {
+                conv_item->start_time = item->start_time;
+                conv_item->start_abs_time = item->start_abs_time;
+            }
+            if (nstime_is_unset(&conv_item->stop_time) ||
+                    nstime_cmp(&item->stop_time, &conv_item->stop_time) > 0) {
+                conv_item->stop_time = item->stop_time;
+            }
+        } else if (have_ts) {
+            conv_item->stop_time = item->stop_time;
+        }
+    }
+
+    reset_conversation_table_data(src);
+    g_free(src);
+}
+
 /*
  * Compute the hash value for a given address/port pair if the match
  * is to be exact.
@@ -807,8 +907,12 @@ endpoint_match(gconstpointer v, gconstpointer w)
     return 0;
 }
 
-void
-add_endpoint_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboolean sender, int num_frames, int num_bytes, et_dissector_info_t *et_info, endpoint_type etype)
+/*
+ * Find the endpoint for an address/port pair, or append a new one with no
+ * packets if there isn't one yet.
+ */
+static endpoint_item_t *
+get_endpoint_table_item(conv_hash_t *ch, const address *addr, guint32 port, et_dissector_info_t *et_info, endpoint_type etype)
 {
     endpoint_item_t *endpoint_item = NULL;
 
@@ -868,6 +972,16 @@ add_endpoint_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboo
         g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(endpoint_idx));
     }
 
+    return endpoint_item;
+}
+
+void
+add_endpoint_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboolean sender, int num_frames, int num_bytes, et_dissector_info_t *et_info, endpoint_type etype)
+{
+    endpoint_item_t *endpoint_item;
+
+    endpoint_item = get_endpoint_table_item(ch, addr, port, et_info, etype);
+
     /* if this is a new endpoint we need to initialize the struct */
     endpoint_item->modified = TRUE;
 
@@ -892,6 +1006,35 @@ add_endpoint_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboo
     }
 }
 
+void
+merge_endpoint_table_data(void *tapdata, void *shard)
+{
+    conv_hash_t *ch = (conv_hash_t *)tapdata;
+    conv_hash_t *src = (conv_hash_t *)shard;
+    endpoint_item_t *item, *endpoint_item;
+    guint i;
+
+    for (i = 0; src->conv_array != NULL && i < src->conv_array->len; i++) {
+        item = &g_array_index(src->conv_array, endpoint_item_t, i);
+
+        endpoint_item = get_endpoint_table_item(ch, &item->myaddress, item->port,
+                                                item->dissector_info, item->etype);
+        endpoint_item->modified = TRUE;
+        endpoint_item->tx_frames += item->tx_frames;
+        endpoint_item->tx_bytes += item->tx_bytes;
+        endpoint_item->rx_frames += item->rx_frames;
+        endpoint_item->rx_bytes += item->rx_bytes;
+        endpoint_item->tx_frames_total += item->tx_frames_total;
+        endpoint_item->tx_bytes_total += item->tx_bytes_total;
+        endpoint_item->rx_frames_total += item->rx_frames_total;
+        endpoint_item->rx_bytes_total += item->rx_bytes_total;
+        endpoint_item->filtered = endpoint_item->filtered && item->filtered;
+    }
+
+    reset_endpoint_table_data(src);
+    g_free(src);
+}
+
 /* For backwards source and binary compatibility */
 void
 add_hostlist_table_data(conv_hash_t *ch, const address *addr, guint32 port, gboolean sender, int num_frames, int num_bytes, et_dissector_info_t *et_info, endpoint_type etype)
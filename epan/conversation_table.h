@@ -389,6 +389,28 @@ add_conversation_table_data_with_conv_id(conv_hash_t *ch, const address *src, co
 WS_DLL_PUBLIC void add_endpoint_table_data(conv_hash_t *ch, const address *addr,
     guint32 port, gboolean sender, int num_frames, int num_bytes, et_dissector_info_t *et_info, endpoint_type etype);
 
+/** Create an empty conversation or endpoint table with the same settings
+ * as another one. Used as the tap_clone_cb of mergeable tap listeners.
+ *
+ * @param tapdata the conv_hash_t to copy the settings from
+ * @return a new conv_hash_t, freed by the merge function
+ */
+WS_DLL_PUBLIC void *clone_conversation_table_hash(void *tapdata);
+
+/** Add the conversations of a cloned table to a table and free the clone.
+ *
+ * @param tapdata the conv_hash_t to merge into
+ * @param shard the conv_hash_t returned by clone_conversation_table_hash()
+ */
+WS_DLL_PUBLIC void merge_conversation_table_data(void *tapdata, void *shard);
+
+/** Add the endpoints of a cloned table to a table and free the clone.
+ *
+ * @param tapdata the conv_hash_t to merge into
+ * @param shard the conv_hash_t returned by clone_conversation_table_hash()
+ */
+WS_DLL_PUBLIC void merge_endpoint_table_data(void *tapdata, void *shard);
+
 /* For backwards source and binary compatibility */
 G_DEPRECATED_FOR(add_endpoint_table_data)
 WS_DLL_PUBLIC void add_hostlist_table_data(conv_hash_t *ch, const address *addr,
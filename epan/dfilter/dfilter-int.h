@@ -80,6 +80,7 @@ typedef struct {
 	GPtrArray	*insns;
 	GHashTable	*loaded_fields;
 	GHashTable	*loaded_raw_fields;
+	GHashTable	*loaded_ranged_fields; /* "[@]abbrev#[range]" -> reg+1 */
 	GHashTable	*interesting_fields;
 	int		next_insn_id;
 	int		next_register;
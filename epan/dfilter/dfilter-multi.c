@@ -0,0 +1,287 @@
+/* dfilter-multi.c
+ * Applying several display filters to each packet together
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 2001 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#define WS_LOG_DOMAIN LOG_DOMAIN_DFILTER
+
+#include <string.h>
+
+#include "dfilter-int.h"
+#include "dfvm.h"
+#include <epan/epan_dissect.h>
+#include <wsutil/ws_assert.h>
+
+struct epan_dfilter_multi {
+	unsigned	count;
+	dfilter_t	**filters;
+	unsigned	*program;	/* First filter with the same text */
+	dfvm_shared_t	*shared;	/* Per filter */
+	df_cell_t	*fields;
+	unsigned	num_fields;
+	int8_t		*results;
+	unsigned	num_results;
+	int8_t		*passed;	/* Per filter, -1 until applied */
+	uint64_t	*matched;
+};
+
+static bool
+is_field_cmp(dfvm_opcode_t op)
+{
+	return op >= DFVM_FIELD_ALL_EQ && op <= DFVM_FIELD_ANY_LE;
+}
+
+/* Identifies the values that an instruction reads into its register,
+ * or NULL if it doesn't read a field. */
+static char *
+field_key(const dfvm_insn_t *insn)
+{
+	const header_field_info *hfinfo;
+	const char *raw;
+	char *range_str, *key;
+
+	if (insn->op != DFVM_READ_TREE && insn->op != DFVM_READ_TREE_R &&
+			!is_field_cmp(insn->op))
+		return NULL;
+
+	hfinfo = insn->arg1->value.hfinfo;
+	raw = insn->arg1->type == RAW_HFINFO ? "@" : "";
+	if (insn->op != DFVM_READ_TREE_R)
+		return ws_strdup_printf("%s%s", raw, hfinfo->abbrev);
+
+	range_str = drange_tostr(insn->arg3->value.drange);
+	key = ws_strdup_printf("%s%s#[%s]", raw, hfinfo->abbrev, range_str);
+	g_free(range_str);
+	return key;
+}
+
+/* Identifies a test whose result depends only on the packet,
+ * or NULL if the instruction isn't one. */
+static char *
+test_key(const dfvm_insn_t *insn)
+{
+	const header_field_info *hfinfo;
+	const dfvm_scalar_t *sc;
+	char *str, *key;
+
+	if (insn->op == DFVM_CHECK_EXISTS) {
+		hfinfo = insn->arg1->value.hfinfo;
+		return ws_strdup_printf("%s %s", dfvm_opcode_tostr(insn->op), hfinfo->abbrev);
+	}
+	if (insn->op == DFVM_CHECK_EXISTS_R) {
+		hfinfo = insn->arg1->value.hfinfo;
+		str = drange_tostr(insn->arg2->value.drange);
+		key = ws_strdup_printf("%s %s#[%s]", dfvm_opcode_tostr(insn->op),
+					hfinfo->abbrev, str);
+		g_free(str);
+		return key;
+	}
+	if (is_field_cmp(insn->op)) {
+		hfinfo = insn->arg1->value.hfinfo;
+		sc = insn->arg3->value.scalar;
+		str = fvalue_to_debug_repr(NULL, sc->fv);
+		key = ws_strdup_printf("%s %s %s <%s>", dfvm_opcode_tostr(insn->op),
+					hfinfo->abbrev, str, fvalue_type_name(sc->fv));
+		g_free(str);
+		return key;
+	}
+	return NULL;
+}
+
+static void
+count_key(GHashTable *uses, char *key)
+{
+	unsigned count;
+
+	if (key == NULL)
+		return;
+	count = GPOINTER_TO_UINT(g_hash_table_lookup(uses, key));
+	g_hash_table_insert(uses, key, GUINT_TO_POINTER(count + 1));
+}
+
+/* Give a slot to every key used more than once, stored as slot+1 so that
+ * the other keys map to 0. Returns the number of slots. */
+static unsigned
+assign_slots(GHashTable *uses)
+{
+	GHashTableIter iter;
+	void *value;
+	unsigned slots = 0;
+
+	g_hash_table_iter_init(&iter, uses);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		if (GPOINTER_TO_UINT(value) > 1)
+			g_hash_table_iter_replace(&iter, GUINT_TO_POINTER(++slots));
+		else
+			g_hash_table_iter_replace(&iter, GUINT_TO_POINTER(0));
+	}
+	return slots;
+}
+
+static int
+lookup_slot(GHashTable *slots, char *key)
+{
+	int slot;
+
+	slot = GPOINTER_TO_INT(g_hash_table_lookup(slots, key)) - 1;
+	g_free(key);
+	return slot;
+}
+
+static bool
+has_references(const dfilter_t *df)
+{
+	return g_hash_table_size(df->references) > 0 ||
+		g_hash_table_size(df->raw_references) > 0;
+}
+
+dfilter_multi_t *
+dfilter_multi_new(dfilter_t * const *filters, unsigned count)
+{
+	dfilter_multi_t *mf;
+	GHashTable	*programs, *field_uses, *test_uses;
+	dfilter_t	*df;
+	dfvm_insn_t	*insn;
+	void		*first;
+	int		*reg_slot, *insn_slot;
+	unsigned	i, id;
+	char		*key;
+
+	mf = g_new0(dfilter_multi_t, 1);
+	mf->count = count;
+	mf->filters = g_memdup2(filters, count * sizeof(dfilter_t *));
+	mf->program = g_new(unsigned, count);
+	mf->shared = g_new0(dfvm_shared_t, count);
+	mf->passed = g_new(int8_t, count);
+	mf->matched = g_new0(uint64_t, DF_MULTI_MASK_WORDS(count));
+
+	programs = g_hash_table_new(g_str_hash, g_str_equal);
+	field_uses = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	test_uses = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	/* Field references are loaded into each filter separately, so
+	 * filters that use them are never merged. */
+	for (i = 0; i < count; i++) {
+		mf->program[i] = i;
+		df = filters[i];
+		if (df == NULL)
+			continue;
+		if (!has_references(df)) {
+			first = g_hash_table_lookup(programs, df->expanded_text);
+			if (first != NULL) {
+				mf->program[i] = GPOINTER_TO_UINT(first) - 1;
+				continue;
+			}
+			g_hash_table_insert(programs, df->expanded_text, GUINT_TO_POINTER(i + 1));
+		}
+		for (id = 0; id < df->insns->len; id++) {
+			insn = g_ptr_array_index(df->insns, id);
+			count_key(field_uses, field_key(insn));
+			count_key(test_uses, test_key(insn));
+		}
+	}
+
+	mf->num_fields = assign_slots(field_uses);
+	mf->num_results = assign_slots(test_uses);
+	mf->fields = g_new0(df_cell_t, mf->num_fields);
+	mf->results = g_new(int8_t, mf->num_results);
+
+	for (i = 0; i < count; i++) {
+		df = filters[i];
+		if (df == NULL || mf->program[i] != i)
+			continue;
+		reg_slot = g_new(int, df->num_registers);
+		for (id = 0; id < df->num_registers; id++)
+			reg_slot[id] = -1;
+		insn_slot = g_new(int, df->insns->len);
+		for (id = 0; id < df->insns->len; id++) {
+			insn = g_ptr_array_index(df->insns, id);
+			insn_slot[id] = -1;
+			if ((key = field_key(insn)) != NULL)
+				reg_slot[insn->arg2->value.numeric] = lookup_slot(field_uses, key);
+			if ((key = test_key(insn)) != NULL)
+				insn_slot[id] = lookup_slot(test_uses, key);
+		}
+		mf->shared[i].reg_slot = reg_slot;
+		mf->shared[i].insn_slot = insn_slot;
+		mf->shared[i].fields = mf->fields;
+		mf->shared[i].results = mf->results;
+	}
+
+	g_hash_table_destroy(programs);
+	g_hash_table_destroy(field_uses);
+	g_hash_table_destroy(test_uses);
+	return mf;
+}
+
+void
+dfilter_multi_free(dfilter_multi_t *mf)
+{
+	if (!mf)
+		return;
+
+	for (unsigned i = 0; i < mf->count; i++) {
+		g_free((int *)mf->shared[i].reg_slot);
+		g_free((int *)mf->shared[i].insn_slot);
+	}
+	g_free(mf->filters);
+	g_free(mf->program);
+	g_free(mf->shared);
+	g_free(mf->fields);
+	g_free(mf->results);
+	g_free(mf->passed);
+	g_free(mf->matched);
+	g_free(mf);
+}
+
+const uint64_t *
+dfilter_multi_apply_edt(dfilter_multi_t *mf, epan_dissect_t *edt,
+			const uint64_t *wanted, unsigned flags)
+{
+	unsigned	i, p;
+
+	memset(mf->matched, 0, DF_MULTI_MASK_WORDS(mf->count) * sizeof(uint64_t));
+	memset(mf->passed, -1, mf->count);
+	memset(mf->results, -1, mf->num_results);
+
+	for (i = 0; i < mf->count; i++) {
+		if (wanted != NULL && !DF_MULTI_MASK_TEST(wanted, i))
+			continue;
+		p = mf->program[i];
+		if (mf->passed[p] < 0) {
+			if (mf->filters[p] == NULL)
+				mf->passed[p] = true;
+			else
+				mf->passed[p] = dfvm_apply_shared(mf->filters[p], edt->tree, &mf->shared[p]);
+		}
+		if (mf->passed[p]) {
+			DF_MULTI_MASK_SET(mf->matched, i);
+			if (flags & DF_MULTI_FIRST_MATCH)
+				break;
+		}
+	}
+
+	for (i = 0; i < mf->num_fields; i++)
+		df_cell_clear(&mf->fields[i]);
+
+	return mf->matched;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
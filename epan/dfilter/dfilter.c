@@ -270,6 +270,10 @@ dfwork_free(dfwork_t *dfw)
 		g_hash_table_destroy(dfw->loaded_raw_fields);
 	}
 
+	if (dfw->loaded_ranged_fields) {
+		g_hash_table_destroy(dfw->loaded_ranged_fields);
+	}
+
 	if (dfw->interesting_fields) {
 		g_hash_table_destroy(dfw->interesting_fields);
 	}
@@ -656,6 +660,56 @@ dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 	return dfvm_apply(df, edt->tree);
 }
 
+bool
+dfilter_can_apply_field_source(const dfilter_t *df,
+			dfilter_field_available_cb available, void *user_data)
+{
+	dfvm_insn_t *insn;
+
+	for (unsigned i = 0; i < df->insns->len; i++) {
+		insn = g_ptr_array_index(df->insns, i);
+		switch (insn->op) {
+			case DFVM_CHECK_EXISTS:
+				if (!available(insn->arg1->value.hfinfo, false, user_data))
+					return false;
+				break;
+			case DFVM_READ_TREE:
+			case DFVM_FIELD_ALL_EQ:
+			case DFVM_FIELD_ANY_EQ:
+			case DFVM_FIELD_ALL_NE:
+			case DFVM_FIELD_ANY_NE:
+			case DFVM_FIELD_ALL_GT:
+			case DFVM_FIELD_ANY_GT:
+			case DFVM_FIELD_ALL_GE:
+			case DFVM_FIELD_ANY_GE:
+			case DFVM_FIELD_ALL_LT:
+			case DFVM_FIELD_ANY_LT:
+			case DFVM_FIELD_ALL_LE:
+			case DFVM_FIELD_ANY_LE:
+				if (insn->arg1->type == RAW_HFINFO)
+					return false;
+				if (!available(insn->arg1->value.hfinfo, true, user_data))
+					return false;
+				break;
+			case DFVM_CHECK_EXISTS_R:
+			case DFVM_READ_TREE_R:
+			case DFVM_READ_REFERENCE:
+			case DFVM_READ_REFERENCE_R:
+				return false;
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+bool
+dfilter_apply_field_source(dfilter_t *df,
+			dfilter_field_source_cb source, void *user_data)
+{
+	return dfvm_apply_field_source(df, source, user_data);
+}
+
 
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree)
@@ -673,6 +727,13 @@ dfilter_has_interesting_fields(const dfilter_t *df)
 	return (df->num_interesting_fields > 0);
 }
 
+const int *
+dfilter_get_interesting_fields(const dfilter_t *df, int *num_fields)
+{
+	*num_fields = df->num_interesting_fields;
+	return df->interesting_fields;
+}
+
 bool
 dfilter_interested_in_field(const dfilter_t *df, int hfid)
 {
@@ -114,6 +114,68 @@ dfilter_apply_edt(dfilter_t *df, struct epan_dissect *edt);
 bool
 dfilter_apply(dfilter_t *df, proto_tree *tree);
 
+/* Callback used to supply field values to a dfilter without a protocol
+ * tree. "hfinfo" is the first field registered with a given name.
+ * If "values" is NULL only the presence of the field is wanted, otherwise
+ * the callback appends the field's values to it. The fvalue_t pointers
+ * are borrowed and must stay valid until the filter returns.
+ * Returns true if the field is present. */
+typedef bool (*dfilter_field_source_cb)(const header_field_info *hfinfo,
+			GPtrArray *values, void *user_data);
+
+/* Returns true if a field source can provide "hfinfo". "need_values" is
+ * false if the filter only tests the field for existence. */
+typedef bool (*dfilter_field_available_cb)(const header_field_info *hfinfo,
+			bool need_values, void *user_data);
+
+/* Check if every field read by the dfilter can be provided by a field
+ * source. Filters that use layer operators, raw fields or field
+ * references always require a protocol tree. */
+WS_DLL_PUBLIC
+bool
+dfilter_can_apply_field_source(const dfilter_t *df,
+			dfilter_field_available_cb available, void *user_data);
+
+/* Apply compiled dfilter using a field source instead of a protocol
+ * tree. The caller must have checked dfilter_can_apply_field_source(). */
+WS_DLL_PUBLIC
+bool
+dfilter_apply_field_source(dfilter_t *df,
+			dfilter_field_source_cb source, void *user_data);
+
+/* Several filters that are applied to every packet, such as the coloring
+ * rules or the filters of tap listeners, evaluated together. Fields that
+ * more than one of them reads are read once per packet, tests of a field
+ * that more than one of them makes are made once, and filters with the
+ * same text are applied once. */
+typedef struct epan_dfilter_multi dfilter_multi_t;
+
+/* Combine "count" filters. They are not copied and must not be freed
+ * before the combined filter. A NULL filter matches every packet. */
+WS_DLL_PUBLIC
+dfilter_multi_t *
+dfilter_multi_new(dfilter_t * const *filters, unsigned count);
+
+WS_DLL_PUBLIC
+void
+dfilter_multi_free(dfilter_multi_t *mf);
+
+/* Stop at the first filter that matches. */
+#define DF_MULTI_FIRST_MATCH	(1U << 0)
+
+/* A mask has a bit for each filter, in 64-bit words. */
+#define DF_MULTI_MASK_WORDS(count)	(((count) + 63) / 64)
+#define DF_MULTI_MASK_TEST(mask, i)	(((mask)[(i) / 64] >> ((i) % 64)) & 1)
+#define DF_MULTI_MASK_SET(mask, i)	((mask)[(i) / 64] |= UINT64_C(1) << ((i) % 64))
+
+/* Apply the filters, in order, to a dissected packet. If "wanted" is not
+ * NULL only the filters whose bits are set in it are applied. Returns the
+ * mask of the filters that matched, which is valid until the next call. */
+WS_DLL_PUBLIC
+const uint64_t *
+dfilter_multi_apply_edt(dfilter_multi_t *mf, struct epan_dissect *edt,
+			const uint64_t *wanted, unsigned flags);
+
 /* Prime a proto_tree using the fields/protocols used in a dfilter. */
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
@@ -132,6 +194,16 @@ dfilter_load_field_references_edt(const dfilter_t *df, struct epan_dissect *edt)
 bool
 dfilter_has_interesting_fields(const dfilter_t *df);
 
+/* Get the fields, including field references, read by a dfilter.
+ *
+ * @param df The dfilter
+ * @param num_fields Set to the number of fields
+ * @return The header field info IDs, owned by the dfilter
+ */
+WS_DLL_PUBLIC
+const int *
+dfilter_get_interesting_fields(const dfilter_t *df, int *num_fields);
+
 /* Check if dfilter is interested in a given field
  *
  * @param df The dfilter
@@ -69,6 +69,18 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 		case DFVM_STACK_PUSH:		return "STACK_PUSH";
 		case DFVM_STACK_POP:		return "STACK_POP";
 		case DFVM_NOT_ALL_ZERO:		return "NOT_ALL_ZERO";
+		case DFVM_FIELD_ALL_EQ:		return "FIELD_ALL_EQ";
+		case DFVM_FIELD_ANY_EQ:		return "FIELD_ANY_EQ";
+		case DFVM_FIELD_ALL_NE:		return "FIELD_ALL_NE";
+		case DFVM_FIELD_ANY_NE:		return "FIELD_ANY_NE";
+		case DFVM_FIELD_ALL_GT:		return "FIELD_ALL_GT";
+		case DFVM_FIELD_ANY_GT:		return "FIELD_ANY_GT";
+		case DFVM_FIELD_ALL_GE:		return "FIELD_ALL_GE";
+		case DFVM_FIELD_ANY_GE:		return "FIELD_ANY_GE";
+		case DFVM_FIELD_ALL_LT:		return "FIELD_ALL_LT";
+		case DFVM_FIELD_ANY_LT:		return "FIELD_ANY_LT";
+		case DFVM_FIELD_ALL_LE:		return "FIELD_ALL_LE";
+		case DFVM_FIELD_ANY_LE:		return "FIELD_ANY_LE";
 	}
 	return "(fix-opcode-string)";
 }
@@ -99,6 +111,10 @@ dfvm_value_free(dfvm_value_t *v)
 		case PCRE:
 			ws_regex_free(v->value.pcre);
 			break;
+		case SCALAR:
+			fvalue_free(v->value.scalar->fv);
+			g_free(v->value.scalar);
+			break;
 		case EMPTY:
 		case HFINFO:
 		case RAW_HFINFO:
@@ -219,6 +235,92 @@ dfvm_value_new_guint(unsigned num)
 	return v;
 }
 
+/* The field types whose compare function can be replaced by a
+ * comparison of the decoded values. */
+static bool
+scalar_kind(ftenum_t ftype, dfvm_scalar_kind_t *kind)
+{
+	switch (ftype) {
+		case FT_CHAR:
+		case FT_UINT8:
+		case FT_UINT16:
+		case FT_UINT24:
+		case FT_UINT32:
+		case FT_UINT40:
+		case FT_UINT48:
+		case FT_UINT56:
+		case FT_UINT64:
+		case FT_IPXNET:
+		case FT_FRAMENUM:
+		case FT_EUI64:
+			*kind = DFVM_SCALAR_UNSIGNED;
+			return true;
+		case FT_INT8:
+		case FT_INT16:
+		case FT_INT24:
+		case FT_INT32:
+		case FT_INT40:
+		case FT_INT48:
+		case FT_INT56:
+		case FT_INT64:
+			*kind = DFVM_SCALAR_SIGNED;
+			return true;
+		case FT_IPv4:
+			*kind = DFVM_SCALAR_IPV4;
+			return true;
+		case FT_ETHER:
+			*kind = DFVM_SCALAR_ETHER;
+			return true;
+		default:
+			return false;
+	}
+}
+
+dfvm_value_t*
+dfvm_value_new_scalar(const fvalue_t *fv)
+{
+	dfvm_scalar_t	*sc;
+	dfvm_scalar_kind_t kind;
+	fvalue_t	*copy;
+	dfvm_value_t	*v;
+
+	if (!scalar_kind(fvalue_type_ftenum((fvalue_t *)fv), &kind))
+		return NULL;
+
+	copy = fvalue_dup(fv);
+	sc = g_new0(dfvm_scalar_t, 1);
+	sc->kind = kind;
+	sc->fv = copy;
+
+	switch (kind) {
+		case DFVM_SCALAR_UNSIGNED:
+			if (fvalue_to_uinteger64(copy, &sc->value.uinteger64) != FT_OK)
+				goto fail;
+			break;
+		case DFVM_SCALAR_SIGNED:
+			if (fvalue_to_sinteger64(copy, &sc->value.sinteger64) != FT_OK)
+				goto fail;
+			break;
+		case DFVM_SCALAR_IPV4:
+			sc->value.ipv4 = *fvalue_get_ipv4(copy);
+			break;
+		case DFVM_SCALAR_ETHER:
+			if (fvalue_get_bytes_size(copy) != FT_ETHER_LEN)
+				goto fail;
+			memcpy(sc->value.ether, fvalue_get_bytes_data(copy), FT_ETHER_LEN);
+			break;
+	}
+
+	v = dfvm_value_new(SCALAR);
+	v->value.scalar = sc;
+	return v;
+
+fail:
+	fvalue_free(copy);
+	g_free(sc);
+	return NULL;
+}
+
 static char *
 dfvm_value_tostr(dfvm_value_t *v)
 {
@@ -243,6 +345,9 @@ dfvm_value_tostr(dfvm_value_t *v)
 		case PCRE:
 			s = ws_strdup(ws_regex_pattern(v->value.pcre));
 			break;
+		case SCALAR:
+			s = fvalue_to_debug_repr(NULL, v->value.scalar->fv);
+			break;
 		case REGISTER:
 			s = ws_strdup_printf("R%"G_GUINT32_FORMAT, v->value.numeric);
 			break;
@@ -280,6 +385,9 @@ value_type_tostr(dfvm_value_t *v, bool show_ftype)
 		case FVALUE:
 			s = fvalue_type_name(dfvm_value_get_fvalue(v));
 			break;
+		case SCALAR:
+			s = fvalue_type_name(v->value.scalar->fv);
+			break;
 		default:
 			return ws_strdup("");
 			break;
@@ -343,6 +451,27 @@ append_to_register(wmem_strbuf_t *buf, const char *reg)
 	wmem_strbuf_append_printf(buf, " -> %s", reg);
 }
 
+static const char *
+field_cmp_tostr(dfvm_opcode_t op)
+{
+	switch (op) {
+		case DFVM_FIELD_ALL_EQ:	return "===";
+		case DFVM_FIELD_ANY_EQ:	return "==";
+		case DFVM_FIELD_ALL_NE:	return "!=";
+		case DFVM_FIELD_ANY_NE:	return "!==";
+		case DFVM_FIELD_ALL_GT:
+		case DFVM_FIELD_ANY_GT:	return ">";
+		case DFVM_FIELD_ALL_GE:
+		case DFVM_FIELD_ANY_GE:	return ">=";
+		case DFVM_FIELD_ALL_LT:
+		case DFVM_FIELD_ANY_LT:	return "<";
+		case DFVM_FIELD_ALL_LE:
+		case DFVM_FIELD_ANY_LE:	return "<=";
+		default:
+			ws_assert_not_reached();
+	}
+}
+
 static void
 append_op_args(wmem_strbuf_t *buf, dfvm_insn_t *insn, GSList **stack_print,
 							uint16_t flags)
@@ -496,6 +625,26 @@ append_op_args(wmem_strbuf_t *buf, dfvm_insn_t *insn, GSList **stack_print,
 						arg1_str, arg1_str_type);
 			break;
 
+		case DFVM_FIELD_ALL_EQ:
+		case DFVM_FIELD_ANY_EQ:
+		case DFVM_FIELD_ALL_NE:
+		case DFVM_FIELD_ANY_NE:
+		case DFVM_FIELD_ALL_GT:
+		case DFVM_FIELD_ANY_GT:
+		case DFVM_FIELD_ALL_GE:
+		case DFVM_FIELD_ANY_GE:
+		case DFVM_FIELD_ALL_LT:
+		case DFVM_FIELD_ANY_LT:
+		case DFVM_FIELD_ALL_LE:
+		case DFVM_FIELD_ANY_LE:
+			wmem_strbuf_append_printf(buf, "%s%s %s %s%s",
+						arg1_str, arg1_str_type,
+						field_cmp_tostr(insn->op),
+						arg3_str, arg3_str_type);
+			indent2(buf, col_start);
+			append_to_register(buf, arg2_str);
+			break;
+
 		case DFVM_ALL_CONTAINS:
 		case DFVM_ANY_CONTAINS:
 			wmem_strbuf_append_printf(buf, "%s%s contains %s%s",
@@ -840,16 +989,26 @@ read_tree_finfos(df_cell_t *rp, proto_tree *tree,
 	return true;
 }
 
+/* Where the field values come from: either a proto_tree or a
+ * caller-supplied field source (see dfilter_apply_field_source()),
+ * and what is shared with other filters (see dfilter_multi_new()). */
+typedef struct {
+	proto_tree		*tree;
+	dfilter_field_source_cb	source;
+	void			*source_data;
+	const dfvm_shared_t	*shared;
+} dfvm_input_t;
+
 /* Reads a field from the proto_tree and loads the fvalues into a register,
  * if that field has not already been read. */
 static bool
-read_tree(dfilter_t *df, proto_tree *tree,
+read_tree(dfilter_t *df, const dfvm_input_t *input,
 				dfvm_value_t *arg1, dfvm_value_t *arg2,
 				dfvm_value_t *arg3)
 {
 	drange_t	*range = NULL;
 	bool		raw;
-	df_cell_t	*rp;
+	df_cell_t	*rp, *shared = NULL;
 
 	header_field_info *hfinfo = arg1->value.hfinfo;
 	raw = arg1->type == RAW_HFINFO;
@@ -867,6 +1026,22 @@ read_tree(dfilter_t *df, proto_tree *tree,
 		return !df_cell_is_empty(rp);
 	}
 
+	/* Or by another filter applied to this packet? */
+	if (input->shared && input->shared->reg_slot[reg] >= 0) {
+		shared = &input->shared->fields[input->shared->reg_slot[reg]];
+		if (!df_cell_is_null(shared)) {
+			rp->array = df_cell_ref(shared);
+			return !df_cell_is_empty(rp);
+		}
+	}
+
+	if (input->source) {
+		/* Field source values are borrowed, never raw or ranged. */
+		df_cell_init(rp, false);
+		input->source(hfinfo, df_cell_ptr(rp), input->source_data);
+		return !df_cell_is_empty(rp);
+	}
+
 	if (raw) {
 		df_cell_init(rp, true);
 	}
@@ -876,10 +1051,14 @@ read_tree(dfilter_t *df, proto_tree *tree,
 	}
 
 	while (hfinfo) {
-		read_tree_finfos(rp, tree, hfinfo, range, raw);
+		read_tree_finfos(rp, input->tree, hfinfo, range, raw);
 		hfinfo = hfinfo->same_name_next;
 	}
 
+	if (shared) {
+		shared->array = df_cell_ref(rp);
+	}
+
 	return !df_cell_is_empty(rp);
 }
 
@@ -1066,6 +1245,136 @@ all_test(dfilter_t *df, DFVMCompareFunc cmp,
 	return cmp_test(df, cmp, arg1, arg2, MATCH_ALL);
 }
 
+/* Compares a field value with the decoded constant. Returns false if the
+ * value is not of the same kind, in which case the ftype compare function
+ * must be used. */
+static bool
+scalar_cmp(const dfvm_scalar_t *sc, fvalue_t *fv, int *cmp)
+{
+	dfvm_scalar_kind_t kind;
+
+	if (!scalar_kind(fvalue_type_ftenum(fv), &kind) || kind != sc->kind)
+		return false;
+
+	switch (kind) {
+		case DFVM_SCALAR_UNSIGNED: {
+			uint64_t val;
+
+			if (fvalue_to_uinteger64(fv, &val) != FT_OK)
+				return false;
+			if (val == sc->value.uinteger64)
+				*cmp = 0;
+			else
+				*cmp = val < sc->value.uinteger64 ? -1 : 1;
+			return true;
+		}
+		case DFVM_SCALAR_SIGNED: {
+			int64_t val;
+
+			if (fvalue_to_sinteger64(fv, &val) != FT_OK)
+				return false;
+			if (val == sc->value.sinteger64)
+				*cmp = 0;
+			else
+				*cmp = val < sc->value.sinteger64 ? -1 : 1;
+			return true;
+		}
+		case DFVM_SCALAR_IPV4: {
+			const ipv4_addr_and_mask *ipv4 = fvalue_get_ipv4(fv);
+			uint32_t nmask = MIN(ipv4->nmask, sc->value.ipv4.nmask);
+			uint32_t addr_a = ipv4->addr & nmask;
+			uint32_t addr_b = sc->value.ipv4.addr & nmask;
+
+			if (addr_a == addr_b)
+				*cmp = 0;
+			else
+				*cmp = addr_a < addr_b ? -1 : 1;
+			return true;
+		}
+		case DFVM_SCALAR_ETHER: {
+			GBytes *bytes = fvalue_get_bytes(fv);
+			size_t size;
+			const uint8_t *data = g_bytes_get_data(bytes, &size);
+			bool ok = false;
+
+			if (size == FT_ETHER_LEN) {
+				*cmp = memcmp(data, sc->value.ether, FT_ETHER_LEN);
+				ok = true;
+			}
+			g_bytes_unref(bytes);
+			return ok;
+		}
+	}
+	ws_assert_not_reached();
+}
+
+static ft_bool_t
+field_cmp_match(dfvm_opcode_t op, DFVMCompareFunc cmp_func,
+			const dfvm_scalar_t *sc, fvalue_t *fv)
+{
+	int cmp;
+
+	if (!scalar_cmp(sc, fv, &cmp))
+		return cmp_func(fv, sc->fv);
+
+	switch (op) {
+		case DFVM_FIELD_ALL_EQ:
+		case DFVM_FIELD_ANY_EQ:
+			return cmp == 0 ? FT_TRUE : FT_FALSE;
+		case DFVM_FIELD_ALL_NE:
+		case DFVM_FIELD_ANY_NE:
+			return cmp != 0 ? FT_TRUE : FT_FALSE;
+		case DFVM_FIELD_ALL_GT:
+		case DFVM_FIELD_ANY_GT:
+			return cmp > 0 ? FT_TRUE : FT_FALSE;
+		case DFVM_FIELD_ALL_GE:
+		case DFVM_FIELD_ANY_GE:
+			return cmp >= 0 ? FT_TRUE : FT_FALSE;
+		case DFVM_FIELD_ALL_LT:
+		case DFVM_FIELD_ANY_LT:
+			return cmp < 0 ? FT_TRUE : FT_FALSE;
+		case DFVM_FIELD_ALL_LE:
+		case DFVM_FIELD_ANY_LE:
+			return cmp <= 0 ? FT_TRUE : FT_FALSE;
+		default:
+			ws_assert_not_reached();
+	}
+}
+
+/* Reads the field into its register, like READ_TREE, and compares the
+ * values with a constant, with the same semantics as cmp_test(). */
+static bool
+field_cmp_test(dfilter_t *df, const dfvm_input_t *input, dfvm_insn_t *insn,
+			DFVMCompareFunc cmp_func, enum match_how how)
+{
+	bool want_all = (how == MATCH_ALL);
+	bool want_any = (how == MATCH_ANY);
+	const dfvm_scalar_t *sc = insn->arg3->value.scalar;
+	df_cell_t *rp;
+	fvalue_t **fv_ptr;
+	size_t fv_count;
+	ft_bool_t have_match;
+
+	if (!read_tree(df, input, insn->arg1, insn->arg2, NULL))
+		return false;
+
+	rp = &df->registers[insn->arg2->value.numeric];
+	fv_ptr = (fvalue_t **)df_cell_array(rp);
+	fv_count = df_cell_size(rp);
+
+	for (size_t idx = 0; idx < fv_count; idx++) {
+		have_match = field_cmp_match(insn->op, cmp_func, sc, fv_ptr[idx]);
+		if (want_all && have_match == FT_FALSE) {
+			return false;
+		}
+		else if (want_any && have_match == FT_TRUE) {
+			return true;
+		}
+	}
+	/* want_all || !want_any */
+	return want_all;
+}
+
 static bool
 any_matches(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
 {
@@ -1568,7 +1877,7 @@ check_exists_finfos(proto_tree *tree, header_field_info *hfinfo, drange_t *range
 }
 
 static bool
-check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
+check_exists(const dfvm_input_t *input, dfvm_value_t *arg1, dfvm_value_t *arg2)
 {
 	header_field_info	*hfinfo;
 	drange_t		*range = NULL;
@@ -1577,8 +1886,12 @@ check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 	if (arg2)
 		range = arg2->value.drange;
 
+	if (input->source) {
+		return input->source(hfinfo, NULL, input->source_data);
+	}
+
 	while (hfinfo) {
-		if (check_exists_finfos(tree, hfinfo, range)) {
+		if (check_exists_finfos(input->tree, hfinfo, range)) {
 			return true;
 		}
 		hfinfo = hfinfo->same_name_next;
@@ -1587,8 +1900,8 @@ check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 	return false;
 }
 
-bool
-dfvm_apply(dfilter_t *df, proto_tree *tree)
+static bool
+dfvm_apply_input(dfilter_t *df, const dfvm_input_t *input)
 {
 	int		id, length;
 	bool	accum = true;
@@ -1596,8 +1909,7 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 	dfvm_value_t	*arg1;
 	dfvm_value_t	*arg2;
 	dfvm_value_t	*arg3 = NULL;
-
-	ws_assert(tree);
+	const dfvm_shared_t *shared = input->shared;
 
 	length = df->insns->len;
 
@@ -1609,21 +1921,28 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 		arg2 = insn->arg2;
 		arg3 = insn->arg3;
 
+		/* A test that another filter already made for this packet */
+		if (shared && shared->insn_slot[id] >= 0 &&
+				shared->results[shared->insn_slot[id]] >= 0) {
+			accum = shared->results[shared->insn_slot[id]];
+			continue;
+		}
+
 		switch (insn->op) {
 			case DFVM_CHECK_EXISTS:
-				accum = check_exists(tree, arg1, NULL);
+				accum = check_exists(input, arg1, NULL);
 				break;
 
 			case DFVM_CHECK_EXISTS_R:
-				accum = check_exists(tree, arg1, arg2);
+				accum = check_exists(input, arg1, arg2);
 				break;
 
 			case DFVM_READ_TREE:
-				accum = read_tree(df, tree, arg1, arg2, NULL);
+				accum = read_tree(df, input, arg1, arg2, NULL);
 				break;
 
 			case DFVM_READ_TREE_R:
-				accum = read_tree(df, tree, arg1, arg2, arg3);
+				accum = read_tree(df, input, arg1, arg2, arg3);
 				break;
 
 			case DFVM_READ_REFERENCE:
@@ -1738,6 +2057,54 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				accum = !all_test_unary(df, fvalue_is_zero, arg1);
 				break;
 
+			case DFVM_FIELD_ALL_EQ:
+				accum = field_cmp_test(df, input, insn, fvalue_eq, MATCH_ALL);
+				break;
+
+			case DFVM_FIELD_ANY_EQ:
+				accum = field_cmp_test(df, input, insn, fvalue_eq, MATCH_ANY);
+				break;
+
+			case DFVM_FIELD_ALL_NE:
+				accum = field_cmp_test(df, input, insn, fvalue_ne, MATCH_ALL);
+				break;
+
+			case DFVM_FIELD_ANY_NE:
+				accum = field_cmp_test(df, input, insn, fvalue_ne, MATCH_ANY);
+				break;
+
+			case DFVM_FIELD_ALL_GT:
+				accum = field_cmp_test(df, input, insn, fvalue_gt, MATCH_ALL);
+				break;
+
+			case DFVM_FIELD_ANY_GT:
+				accum = field_cmp_test(df, input, insn, fvalue_gt, MATCH_ANY);
+				break;
+
+			case DFVM_FIELD_ALL_GE:
+				accum = field_cmp_test(df, input, insn, fvalue_ge, MATCH_ALL);
+				break;
+
+			case DFVM_FIELD_ANY_GE:
+				accum = field_cmp_test(df, input, insn, fvalue_ge, MATCH_ANY);
+				break;
+
+			case DFVM_FIELD_ALL_LT:
+				accum = field_cmp_test(df, input, insn, fvalue_lt, MATCH_ALL);
+				break;
+
+			case DFVM_FIELD_ANY_LT:
+				accum = field_cmp_test(df, input, insn, fvalue_lt, MATCH_ANY);
+				break;
+
+			case DFVM_FIELD_ALL_LE:
+				accum = field_cmp_test(df, input, insn, fvalue_le, MATCH_ALL);
+				break;
+
+			case DFVM_FIELD_ANY_LE:
+				accum = field_cmp_test(df, input, insn, fvalue_le, MATCH_ANY);
+				break;
+
 			case DFVM_ALL_CONTAINS:
 				accum = all_test(df, fvalue_contains, arg1, arg2);
 				break;
@@ -1808,11 +2175,46 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				}
 				break;
 		}
+
+		if (shared && shared->insn_slot[id] >= 0) {
+			shared->results[shared->insn_slot[id]] = accum;
+		}
 	}
 
 	ws_assert_not_reached();
 }
 
+bool
+dfvm_apply(dfilter_t *df, proto_tree *tree)
+{
+	dfvm_input_t input = { .tree = tree };
+
+	ws_assert(tree);
+
+	return dfvm_apply_input(df, &input);
+}
+
+bool
+dfvm_apply_field_source(dfilter_t *df, dfilter_field_source_cb source,
+				void *source_data)
+{
+	dfvm_input_t input = { .source = source, .source_data = source_data };
+
+	ws_assert(source);
+
+	return dfvm_apply_input(df, &input);
+}
+
+bool
+dfvm_apply_shared(dfilter_t *df, proto_tree *tree, const dfvm_shared_t *shared)
+{
+	dfvm_input_t input = { .tree = tree, .shared = shared };
+
+	ws_assert(tree);
+
+	return dfvm_apply_input(df, &input);
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
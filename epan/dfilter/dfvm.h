@@ -28,8 +28,30 @@ typedef enum {
 	DRANGE,
 	FUNCTION_DEF,
 	PCRE,
+	SCALAR,
 } dfvm_value_type_t;
 
+typedef enum {
+	DFVM_SCALAR_UNSIGNED,
+	DFVM_SCALAR_SIGNED,
+	DFVM_SCALAR_IPV4,
+	DFVM_SCALAR_ETHER,
+} dfvm_scalar_kind_t;
+
+/* A constant operand of a fused field comparison, decoded at compile
+ * time so that field values of the same kind can be compared without
+ * going through the ftype compare function. */
+typedef struct {
+	dfvm_scalar_kind_t	kind;
+	union {
+		uint64_t		uinteger64;
+		int64_t			sinteger64;
+		ipv4_addr_and_mask	ipv4;
+		uint8_t			ether[FT_ETHER_LEN];
+	} value;
+	fvalue_t		*fv;
+} dfvm_scalar_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -40,6 +62,7 @@ typedef struct {
 		header_field_info	*hfinfo;
 		df_func_def_t		*funcdef;
 		ws_regex_t		*pcre;
+		dfvm_scalar_t		*scalar;
 	} value;
 
 	int ref_count;
@@ -97,6 +120,20 @@ typedef enum {
 	DFVM_STACK_PUSH,
 	DFVM_STACK_POP,
 	DFVM_NOT_ALL_ZERO,
+	/* Superinstructions generated by the optimizer: READ_TREE,
+	 * IF_FALSE_GOTO and a comparison with a constant, fused. */
+	DFVM_FIELD_ALL_EQ,
+	DFVM_FIELD_ANY_EQ,
+	DFVM_FIELD_ALL_NE,
+	DFVM_FIELD_ANY_NE,
+	DFVM_FIELD_ALL_GT,
+	DFVM_FIELD_ANY_GT,
+	DFVM_FIELD_ALL_GE,
+	DFVM_FIELD_ANY_GE,
+	DFVM_FIELD_ALL_LT,
+	DFVM_FIELD_ANY_LT,
+	DFVM_FIELD_ALL_LE,
+	DFVM_FIELD_ANY_LE,
 } dfvm_opcode_t;
 
 const char *
@@ -146,6 +183,10 @@ dfvm_value_new_pcre(ws_regex_t *re);
 dfvm_value_t*
 dfvm_value_new_guint(unsigned num);
 
+/* Returns NULL if the constant is not of a kind that has a fast path. */
+dfvm_value_t*
+dfvm_value_new_scalar(const fvalue_t *fv);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df, uint16_t flags);
 
@@ -155,6 +196,21 @@ dfvm_dump_str(wmem_allocator_t *alloc, dfilter_t *df,  uint16_t flags);
 bool
 dfvm_apply(dfilter_t *df, proto_tree *tree);
 
+bool
+dfvm_apply_field_source(dfilter_t *df, dfilter_field_source_cb source,
+				void *source_data);
+
+/* What one filter of a dfilter_multi_t shares with the others. */
+typedef struct {
+	const int	*reg_slot;	/* register -> shared field read, or -1 */
+	const int	*insn_slot;	/* instruction -> shared test result, or -1 */
+	df_cell_t	*fields;	/* Cleared after each packet */
+	int8_t		*results;	/* -1 until evaluated for the packet */
+} dfvm_shared_t;
+
+bool
+dfvm_apply_shared(dfilter_t *df, proto_tree *tree, const dfvm_shared_t *shared);
+
 fvalue_t *
 dfvm_get_raw_fvalue(const field_info *fi);
 
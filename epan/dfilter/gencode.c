@@ -152,11 +152,11 @@ dfw_append_read_tree(dfwork_t *dfw, header_field_info *hfinfo,
 
 	/* Keep track of which registers
 	 * were used for which hfinfo's so that we
-	 * can re-use registers. */
-	/* Re-use only if we are not using a range (layer filter). */
-	loaded_key = g_hash_table_lookup(loaded_fields, hfinfo);
-	if (loaded_key != NULL) {
-		if (range == NULL) {
+	 * can re-use registers. A read with a range (layer filter)
+	 * loads different values, so it is keyed by the range too. */
+	if (range == NULL) {
+		loaded_key = g_hash_table_lookup(loaded_fields, hfinfo);
+		if (loaded_key != NULL) {
 			/*
 			 * Reg's are stored in has as reg+1, so
 			 * that the non-existence of a hfinfo in
@@ -167,14 +167,30 @@ dfw_append_read_tree(dfwork_t *dfw, header_field_info *hfinfo,
 		}
 		else {
 			reg = dfw->next_register++;
+			g_hash_table_insert(loaded_fields,
+				hfinfo, GINT_TO_POINTER(reg + 1));
+
+			added_new_hfinfo = true;
 		}
 	}
 	else {
-		reg = dfw->next_register++;
-		g_hash_table_insert(loaded_fields,
-			hfinfo, GINT_TO_POINTER(reg + 1));
+		char *range_str = drange_tostr(range);
+		char *ranged_key = ws_strdup_printf("%s%s#[%s]",
+					raw ? "@" : "", hfinfo->abbrev, range_str);
+		g_free(range_str);
+
+		loaded_key = g_hash_table_lookup(dfw->loaded_ranged_fields, ranged_key);
+		if (loaded_key != NULL) {
+			reg = GPOINTER_TO_INT(loaded_key) - 1;
+			g_free(ranged_key);
+		}
+		else {
+			reg = dfw->next_register++;
+			g_hash_table_insert(dfw->loaded_ranged_fields,
+				ranged_key, GINT_TO_POINTER(reg + 1));
 
-		added_new_hfinfo = true;
+			added_new_hfinfo = true;
+		}
 	}
 
 	val1 = dfvm_value_new_hfinfo(hfinfo, raw);
@@ -492,6 +508,42 @@ gen_relation_in(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 	jumps = NULL;
 }
 
+/* If both operands are constants compute the result now, instead of
+ * on every run of the filter. Returns NULL if that is not possible;
+ * errors such as division by zero are left to be reported at run time. */
+static dfvm_value_t *
+fold_arithmetic(dfvm_opcode_t op, dfvm_value_t *val1, dfvm_value_t *val2)
+{
+	fvalue_t *(*func)(const fvalue_t *, const fvalue_t *, char **);
+	fvalue_t	*result;
+	char		*err_msg = NULL;
+
+	if (val1->type != FVALUE || val2->type != FVALUE)
+		return NULL;
+
+	switch (op) {
+		case DFVM_ADD:		func = fvalue_add; break;
+		case DFVM_SUBTRACT:	func = fvalue_subtract; break;
+		case DFVM_MULTIPLY:	func = fvalue_multiply; break;
+		case DFVM_DIVIDE:	func = fvalue_divide; break;
+		case DFVM_MODULO:	func = fvalue_modulo; break;
+		case DFVM_BITWISE_AND:	func = fvalue_bitwise_and; break;
+		default:
+			return NULL;
+	}
+
+	result = func(dfvm_value_get_fvalue(val1), dfvm_value_get_fvalue(val2), &err_msg);
+	if (result == NULL) {
+		g_free(err_msg);
+		return NULL;
+	}
+
+	/* The operands are not referenced by any instruction. */
+	dfvm_value_unref(val1);
+	dfvm_value_unref(val2);
+	return dfvm_value_new_fvalue(result);
+}
+
 static dfvm_value_t *
 gen_arithmetic(dfwork_t *dfw, stnode_t *st_arg, GSList **jumps_ptr)
 {
@@ -536,6 +588,11 @@ gen_arithmetic(dfwork_t *dfw, stnode_t *st_arg, GSList **jumps_ptr)
 	}
 
 	val2 = gen_entity(dfw, right, jumps_ptr);
+	if (dfw->flags & DF_OPTIMIZE) {
+		reg_val = fold_arithmetic(op, val1, val2);
+		if (reg_val != NULL)
+			return reg_val;
+	}
 	reg_val = dfvm_value_new_register(dfw->next_register++);
 	gen_relation_insn(dfw, op, val1, val2, reg_val);
 	return reg_val;
@@ -814,6 +871,98 @@ gencode(dfwork_t *dfw, stnode_t *st_node)
 }
 
 
+/* Returns the superinstruction for READ_TREE, IF_FALSE_GOTO and a
+ * comparison of the field with a constant, starting at id, or NULL. */
+static dfvm_insn_t *
+fuse_field_cmp(GPtrArray *insns, int id)
+{
+	dfvm_insn_t	*read, *jump, *cmp, *insn;
+	dfvm_value_t	*scalar;
+
+	if (id + 2 >= (int)insns->len)
+		return NULL;
+
+	read = g_ptr_array_index(insns, id);
+	jump = g_ptr_array_index(insns, id + 1);
+	cmp = g_ptr_array_index(insns, id + 2);
+
+	if (read->op != DFVM_READ_TREE || read->arg1->type != HFINFO)
+		return NULL;
+	if (jump->op != DFVM_IF_FALSE_GOTO || jump->arg1->value.numeric != (uint32_t)id + 3)
+		return NULL;
+	if (cmp->op < DFVM_ALL_EQ || cmp->op > DFVM_ANY_LE)
+		return NULL;
+	if (cmp->arg1->type != REGISTER || cmp->arg1->value.numeric != read->arg2->value.numeric)
+		return NULL;
+	if (cmp->arg2->type != FVALUE)
+		return NULL;
+
+	scalar = dfvm_value_new_scalar(dfvm_value_get_fvalue(cmp->arg2));
+	if (scalar == NULL)
+		return NULL;
+
+	/* The opcodes are in the same order. */
+	insn = dfvm_insn_new(DFVM_FIELD_ALL_EQ + (cmp->op - DFVM_ALL_EQ));
+	insn->arg1 = dfvm_value_ref(read->arg1);
+	insn->arg2 = dfvm_value_ref(read->arg2);
+	insn->arg3 = dfvm_value_ref(scalar);
+	return insn;
+}
+
+/* Replace field comparisons with a constant by superinstructions and
+ * renumber the jumps. The instructions in the middle of a sequence must
+ * not be jump targets. */
+static void
+fuse_insns(dfwork_t *dfw)
+{
+	GPtrArray	*insns;
+	dfvm_insn_t	*insn, *fused;
+	bool		*is_target;
+	int		*new_id;
+	int		id, length;
+
+	length = dfw->insns->len;
+	is_target = g_new0(bool, length + 2);
+	new_id = g_new(int, length + 2);
+
+	for (id = 0; id < length; id++) {
+		insn = g_ptr_array_index(dfw->insns, id);
+		if (insn->op == DFVM_IF_TRUE_GOTO || insn->op == DFVM_IF_FALSE_GOTO) {
+			is_target[insn->arg1->value.numeric] = true;
+		}
+	}
+
+	insns = g_ptr_array_sized_new(length);
+	for (id = 0; id < length; id++) {
+		new_id[id] = insns->len;
+		insn = g_ptr_array_index(dfw->insns, id);
+		if (!is_target[id + 1] && !is_target[id + 2] &&
+				(fused = fuse_field_cmp(dfw->insns, id)) != NULL) {
+			new_id[id + 1] = new_id[id + 2] = insns->len;
+			dfvm_insn_free(insn);
+			dfvm_insn_free(g_ptr_array_index(dfw->insns, id + 1));
+			dfvm_insn_free(g_ptr_array_index(dfw->insns, id + 2));
+			insn = fused;
+			id += 2;
+		}
+		insn->id = insns->len;
+		g_ptr_array_add(insns, insn);
+	}
+
+	for (id = 0; id < (int)insns->len; id++) {
+		insn = g_ptr_array_index(insns, id);
+		if (insn->op == DFVM_IF_TRUE_GOTO || insn->op == DFVM_IF_FALSE_GOTO) {
+			insn->arg1->value.numeric = new_id[insn->arg1->value.numeric];
+		}
+	}
+
+	g_ptr_array_free(dfw->insns, true);
+	dfw->insns = insns;
+	dfw->next_insn_id = insns->len;
+	g_free(is_target);
+	g_free(new_id);
+}
+
 static void
 optimize(dfwork_t *dfw)
 {
@@ -821,6 +970,8 @@ optimize(dfwork_t *dfw)
 	dfvm_insn_t	*insn, *insn1, *prev;
 	dfvm_value_t	*arg1;
 
+	fuse_insns(dfw);
+
 	length = dfw->insns->len;
 
 	for (id = 0, prev = NULL; id < length; prev = insn, id++) {
@@ -866,6 +1017,7 @@ dfw_gencode(dfwork_t *dfw)
 	dfw->insns = g_ptr_array_new();
 	dfw->loaded_fields = g_hash_table_new(g_direct_hash, g_direct_equal);
 	dfw->loaded_raw_fields = g_hash_table_new(g_direct_hash, g_direct_equal);
+	dfw->loaded_ranged_fields = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	dfw->interesting_fields = g_hash_table_new(g_int_hash, g_int_equal);
 	gencode(dfw, dfw->st_root);
 	dfw_append_insn(dfw, dfvm_insn_new(DFVM_RETURN));
@@ -0,0 +1,338 @@
+/* dfilter_multi_test.c
+ * Tests for applying several display filters together
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#undef G_DISABLE_ASSERT
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/epan_dissect.h>
+#include <epan/packet.h>
+#include <epan/proto.h>
+#include <epan/dfilter/dfilter.h>
+#include <wiretap/wtap.h>
+#include <wsutil/filesystem.h>
+
+#define NUM_PACKETS 24
+#define PACKET_LEN  7
+
+static int proto_multitest = -1;
+
+static int hf_multitest_a = -1;
+static int hf_multitest_b = -1;
+static int hf_multitest_c = -1;
+static int hf_multitest_d = -1;
+
+static gint ett_multitest = -1;
+
+static epan_t *session;
+
+/*
+ * Several filters read the same fields, make the same fused comparisons
+ * and existence checks, read different ranges of the same field, and
+ * some have the same text.
+ */
+static const char *filter_texts[] = {
+    "multitest.a == 1 && multitest.b > 300",
+    "multitest.c",
+    "multitest.b > 300",
+    "multitest.a == 1",
+    "multitest.a == 2 || multitest.c",
+    "!multitest.c && multitest.b > 300",
+    "multitest.a != 1",
+    "multitest.a === 1",
+    "multitest.d[0] == 00",
+    "multitest.d[1] == 64",
+    "multitest.d",
+    "@multitest.b == 00:64",
+    "multitest.a in {2 3} && multitest.b < 600",
+    "multitest.a == 1",
+    "multitest.c && multitest.b > 300",
+    "multitest.a == 3",
+};
+
+static void
+register_test_protocol(void)
+{
+    static hf_register_info hf[] = {
+        { &hf_multitest_a,
+          { "A", "multitest.a", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_multitest_b,
+          { "B", "multitest.b", FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_multitest_c,
+          { "C", "multitest.c", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_multitest_d,
+          { "D", "multitest.d", FT_BYTES, BASE_NONE, NULL, 0x0, NULL, HFILL }},
+    };
+    static gint *ett[] = {
+        &ett_multitest,
+    };
+
+    proto_multitest = proto_register_protocol("Multiple Filter Test", "MULTITEST", "multitest");
+    proto_register_field_array(proto_multitest, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+}
+
+static dfilter_t *
+compile(const char *text)
+{
+    dfilter_t *df = NULL;
+    df_error_t *err = NULL;
+
+    if (!dfilter_compile(text, &df, &err)) {
+        fprintf(stderr, "%s: %s\n", text, err->msg);
+        df_error_free(&err);
+    }
+    g_assert_nonnull(df);
+    return df;
+}
+
+/*
+ * Build the tree of packet "num". The fields vary from packet to packet,
+ * so that stale values shared from the previous packet would show up.
+ */
+static epan_dissect_t *
+dissect_packet(guint num, frame_data *fd, guint8 *data, dfilter_t * const *filters, guint count)
+{
+    epan_dissect_t *edt;
+    proto_item *ti;
+    proto_tree *tree;
+    guint16 b = (guint16) (100 * (num % 8));
+    guint i;
+
+    data[0] = (guint8) (num % 3 + 1);
+    data[1] = b >> 8;
+    data[2] = b & 0xff;
+    data[3] = (guint8) num;
+    data[4] = data[1];
+    data[5] = data[2];
+    /* A second occurrence of multitest.a */
+    data[6] = (guint8) (num / 4 % 3 + 1);
+
+    memset(fd, 0, sizeof(*fd));
+    fd->num = num + 1;
+    fd->pkt_len = PACKET_LEN;
+    fd->cap_len = PACKET_LEN;
+
+    edt = epan_dissect_new(session, TRUE, FALSE);
+    for (i = 0; i < count; i++) {
+        if (filters[i] != NULL)
+            epan_dissect_prime_with_dfilter(edt, filters[i]);
+    }
+    edt->pi.fd = fd;
+    edt->tvb = tvb_new_real_data(data, PACKET_LEN, PACKET_LEN);
+
+    ti = proto_tree_add_item(edt->tree, proto_multitest, edt->tvb, 0, -1, ENC_NA);
+    tree = proto_item_add_subtree(ti, ett_multitest);
+    proto_tree_add_item(tree, hf_multitest_a, edt->tvb, 0, 1, ENC_NA);
+    proto_tree_add_item(tree, hf_multitest_b, edt->tvb, 1, 2, ENC_BIG_ENDIAN);
+    if (num % 2) {
+        proto_tree_add_item(tree, hf_multitest_c, edt->tvb, 3, 1, ENC_NA);
+    }
+    if (num % 3 != 2) {
+        proto_tree_add_item(tree, hf_multitest_d, edt->tvb, 4, 2, ENC_NA);
+    }
+    if (num % 4 == 0) {
+        proto_tree_add_item(tree, hf_multitest_a, edt->tvb, 6, 1, ENC_NA);
+    }
+
+    return edt;
+}
+
+/*
+ * Apply the filters together and one at a time to every packet and
+ * compare the results.
+ */
+static void
+check_filters(dfilter_t * const *filters, guint count, const guint64 *wanted)
+{
+    dfilter_multi_t *mf = dfilter_multi_new(filters, count);
+    guint8 data[PACKET_LEN];
+    frame_data fd;
+    guint num, i;
+    guint num_matched = 0;
+
+    for (num = 0; num < NUM_PACKETS; num++) {
+        epan_dissect_t *edt = dissect_packet(num, &fd, data, filters, count);
+        gboolean *expected = g_new0(gboolean, count);
+        const guint64 *mask;
+        gint first = -1;
+
+        for (i = 0; i < count; i++) {
+            if (wanted != NULL && !DF_MULTI_MASK_TEST(wanted, i))
+                continue;
+            expected[i] = filters[i] == NULL || dfilter_apply_edt(filters[i], edt);
+            if (expected[i]) {
+                num_matched++;
+                if (first < 0)
+                    first = i;
+            }
+        }
+
+        mask = dfilter_multi_apply_edt(mf, edt, wanted, 0);
+        for (i = 0; i < count; i++) {
+            if ((gboolean) DF_MULTI_MASK_TEST(mask, i) != expected[i]) {
+                g_test_message("packet %u, filter %u \"%s\"", num, i,
+                               filters[i] ? dfilter_text(filters[i]) : "(none)");
+            }
+            g_assert_cmpint(DF_MULTI_MASK_TEST(mask, i), ==, expected[i]);
+        }
+
+        /* Applying them again to the same tree gives the same result. */
+        mask = dfilter_multi_apply_edt(mf, edt, wanted, 0);
+        for (i = 0; i < count; i++) {
+            g_assert_cmpint(DF_MULTI_MASK_TEST(mask, i), ==, expected[i]);
+        }
+
+        mask = dfilter_multi_apply_edt(mf, edt, wanted, DF_MULTI_FIRST_MATCH);
+        for (i = 0; i < count; i++) {
+            g_assert_cmpint(DF_MULTI_MASK_TEST(mask, i), ==, (gint) i == first);
+        }
+
+        g_free(expected);
+        epan_dissect_free(edt);
+    }
+
+    /* Make sure the packets exercised both outcomes. */
+    g_assert_cmpuint(num_matched, >, 0);
+    g_assert_cmpuint(num_matched, <, NUM_PACKETS * count);
+
+    dfilter_multi_free(mf);
+}
+
+static dfilter_t **
+compile_all(guint count)
+{
+    dfilter_t **filters = g_new(dfilter_t *, count);
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        filters[i] = compile(filter_texts[i % G_N_ELEMENTS(filter_texts)]);
+    }
+    return filters;
+}
+
+static void
+free_all(dfilter_t **filters, guint count)
+{
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        dfilter_free(filters[i]);
+    }
+    g_free(filters);
+}
+
+static void
+test_multi_masks(void)
+{
+    guint count = G_N_ELEMENTS(filter_texts);
+    dfilter_t **filters = compile_all(count);
+
+    check_filters(filters, count, NULL);
+    free_all(filters, count);
+}
+
+static void
+test_multi_null_filter(void)
+{
+    guint count = G_N_ELEMENTS(filter_texts);
+    dfilter_t **filters = compile_all(count);
+    dfilter_t *first = filters[0];
+
+    /* A missing filter matches every packet, so it's always the first match. */
+    filters[0] = NULL;
+    check_filters(filters, count, NULL);
+    filters[0] = first;
+    free_all(filters, count);
+}
+
+static void
+test_multi_wanted(void)
+{
+    guint count = G_N_ELEMENTS(filter_texts);
+    dfilter_t **filters = compile_all(count);
+    guint64 wanted[DF_MULTI_MASK_WORDS(G_N_ELEMENTS(filter_texts))];
+    guint i;
+
+    /* Leave out the first of the two "multitest.a == 1" filters and some
+     * of the filters that share fields with the rest. */
+    memset(wanted, 0, sizeof(wanted));
+    for (i = 0; i < count; i++) {
+        if (i != 3 && i % 4 != 2)
+            DF_MULTI_MASK_SET(wanted, i);
+    }
+    check_filters(filters, count, wanted);
+    free_all(filters, count);
+}
+
+static void
+test_multi_many(void)
+{
+    /* More filters than fit in one word of the mask, most of them
+     * duplicates of earlier ones. */
+    guint count = 150;
+    dfilter_t **filters = compile_all(count);
+
+    check_filters(filters, count, NULL);
+    free_all(filters, count);
+}
+
+int
+main(int argc, char **argv)
+{
+    static const struct packet_provider_funcs funcs = {
+        NULL, NULL, NULL, NULL
+    };
+    int result;
+    char *err;
+
+    g_test_init(&argc, &argv, NULL);
+
+    err = configuration_init(argv[0], NULL);
+    if (err != NULL) {
+        fprintf(stderr, "Can't get pathname of directory containing the test program: %s.\n", err);
+        g_free(err);
+    }
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    register_test_protocol();
+    session = epan_new(NULL, &funcs);
+
+    g_test_add_func("/dfilter_multi/masks", test_multi_masks);
+    g_test_add_func("/dfilter_multi/null_filter", test_multi_null_filter);
+    g_test_add_func("/dfilter_multi/wanted", test_multi_wanted);
+    g_test_add_func("/dfilter_multi/many", test_multi_many);
+
+    result = g_test_run();
+
+    epan_free(session);
+    epan_cleanup();
+    wtap_cleanup();
+
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,224 @@
+/* dissector_table_test.c
+ * Dissector table tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#undef G_DISABLE_ASSERT
+
+#include <stdio.h>
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/packet.h>
+#include <epan/proto.h>
+#include <wiretap/wtap.h>
+#include <wsutil/filesystem.h>
+
+static int proto_data = -1;
+
+static int
+test_dissector(tvbuff_t *tvb _U_, packet_info *pinfo _U_, proto_tree *tree _U_, void *data _U_)
+{
+    return 0;
+}
+
+static void
+check_patterns(dissector_table_t table, const guint32 *patterns, size_t count,
+               dissector_handle_t handle)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        g_assert_true(dissector_get_uint_handle(table, patterns[i]) == handle);
+    }
+}
+
+static void
+test_dissector_table_uint(const char *name, ftenum_t type)
+{
+    /* The last pattern doesn't fit in 16 bits, but tables don't check that. */
+    static const guint32 patterns[] = { 0, 1, 0xFF, 0x100, 0x1234, 0xFFFF, 0x10000 };
+    dissector_table_t table;
+    dissector_handle_t handle, other;
+    size_t i;
+
+    table = register_dissector_table(name, "Test table", -1, type, BASE_DEC);
+    handle = create_dissector_handle(test_dissector, proto_data);
+    other = create_dissector_handle(test_dissector, proto_data);
+
+    check_patterns(table, patterns, G_N_ELEMENTS(patterns), NULL);
+    for (i = 0; i < G_N_ELEMENTS(patterns); i++) {
+        dissector_add_uint(name, patterns[i], handle);
+    }
+    check_patterns(table, patterns, G_N_ELEMENTS(patterns), handle);
+    g_assert_null(dissector_get_uint_handle(table, 2));
+    g_assert_null(dissector_get_uint_handle(table, 0x1235));
+
+    /* Changing and resetting an existing entry. */
+    dissector_change_uint(name, 0x1234, other);
+    g_assert_true(dissector_get_uint_handle(table, 0x1234) == other);
+    g_assert_true(dissector_is_uint_changed(table, 0x1234));
+    dissector_reset_uint(name, 0x1234);
+    g_assert_true(dissector_get_uint_handle(table, 0x1234) == handle);
+
+    /* Entries that only exist because of a change disappear on reset. */
+    dissector_change_uint(name, 0x4321, other);
+    g_assert_true(dissector_get_uint_handle(table, 0x4321) == other);
+    dissector_reset_uint(name, 0x4321);
+    g_assert_null(dissector_get_uint_handle(table, 0x4321));
+
+    /* Adding over an existing entry replaces it. */
+    dissector_add_uint(name, 1, other);
+    g_assert_true(dissector_get_uint_handle(table, 1) == other);
+
+    dissector_delete_uint(name, 0xFF, handle);
+    g_assert_null(dissector_get_uint_handle(table, 0xFF));
+    g_assert_true(dissector_get_uint_handle(table, 0x100) == handle);
+
+    dissector_delete_all(name, handle);
+    check_patterns(table, patterns, G_N_ELEMENTS(patterns), NULL);
+}
+
+static void
+test_dissector_table_uint8(void)
+{
+    test_dissector_table_uint("test.uint8", FT_UINT8);
+}
+
+static void
+test_dissector_table_uint16(void)
+{
+    test_dissector_table_uint("test.uint16", FT_UINT16);
+}
+
+static void
+test_dissector_table_uint32(void)
+{
+    test_dissector_table_uint("test.uint32", FT_UINT32);
+}
+
+/*
+ * Time the table lookups made for a mix of Ethernet frames, mostly
+ * IPv4/UDP/DNS, the way the Ethernet, IP and UDP dissectors do them.
+ */
+#define DISPATCH_ITERATIONS 2000000
+
+typedef struct {
+    guint32 ethertype;
+    guint32 ip_proto;
+    guint32 src_port;
+    guint32 dst_port;
+} dispatch_packet_t;
+
+static const dispatch_packet_t dispatch_mix[] = {
+    { 0x0800, 17, 49152, 53 },
+    { 0x0800, 17, 53, 49152 },
+    { 0x86dd, 17, 51000, 53 },
+    { 0x86dd, 17, 53, 51000 },
+    { 0x0800, 17, 5353, 5353 },
+    { 0x0800, 17, 40000, 123 },
+    { 0x0800, 6, 49153, 443 },
+    { 0x0800, 1, 0, 0 },
+    { 0x0806, 0, 0, 0 },
+    { 0x0800, 17, 33434, 33435 },
+};
+
+static guint
+dispatch_chain(dissector_table_t ethertype, dissector_table_t ip_proto,
+               dissector_table_t udp_port, const dispatch_packet_t *pkt)
+{
+    guint found = 0;
+
+    if (dissector_get_uint_handle(ethertype, pkt->ethertype))
+        found++;
+    if (pkt->ethertype == 0x0806 || !dissector_get_uint_handle(ip_proto, pkt->ip_proto))
+        return found;
+    found++;
+    if (pkt->ip_proto != 17)
+        return found;
+    /* UDP tries the lower port first. */
+    if (dissector_get_uint_handle(udp_port, MIN(pkt->src_port, pkt->dst_port)) ||
+            dissector_get_uint_handle(udp_port, MAX(pkt->src_port, pkt->dst_port)))
+        found++;
+    return found;
+}
+
+static void
+test_dissector_table_dispatch_perf(void)
+{
+    dissector_table_t ethertype = find_dissector_table("ethertype");
+    dissector_table_t ip_proto = find_dissector_table("ip.proto");
+    dissector_table_t udp_port = find_dissector_table("udp.port");
+    guint64 found = 0;
+    gdouble elapsed;
+    guint i;
+
+    g_assert_nonnull(ethertype);
+    g_assert_nonnull(ip_proto);
+    g_assert_nonnull(udp_port);
+
+    g_test_timer_start();
+    for (i = 0; i < DISPATCH_ITERATIONS; i++) {
+        found += dispatch_chain(ethertype, ip_proto, udp_port,
+                                &dispatch_mix[i % G_N_ELEMENTS(dispatch_mix)]);
+    }
+    elapsed = g_test_timer_elapsed();
+
+    g_assert_cmpuint(found, >, 0);
+    g_test_minimized_result(elapsed * 1e9 / DISPATCH_ITERATIONS,
+                            "dispatch chain: %.1f ns per packet",
+                            elapsed * 1e9 / DISPATCH_ITERATIONS);
+}
+
+int
+main(int argc, char **argv)
+{
+    int result;
+    char *err;
+
+    g_test_init(&argc, &argv, NULL);
+
+    err = configuration_init(argv[0], NULL);
+    if (err != NULL) {
+        fprintf(stderr, "Can't get pathname of directory containing the test program: %s.\n", err);
+        g_free(err);
+    }
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    proto_data = proto_get_id_by_filter_name("data");
+
+    g_test_add_func("/dissector_table/uint8", test_dissector_table_uint8);
+    g_test_add_func("/dissector_table/uint16", test_dissector_table_uint16);
+    g_test_add_func("/dissector_table/uint32", test_dissector_table_uint32);
+
+    if (g_test_perf()) {
+        g_test_add_func("/dissector_table/dispatch_perf", test_dissector_table_dispatch_perf);
+    }
+
+    result = g_test_run();
+
+    epan_cleanup();
+    wtap_cleanup();
+
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -8903,11 +8903,15 @@ proto_register_artnet(void) {
 
 void
 proto_reg_handoff_artnet(void) {
+  static const guint8 artnet_id[] = "Art-Net";
+  static const heur_signature_t artnet_signature = { 8, 0, 8, artnet_id, NULL };
+
   dissector_add_for_decode_as_with_preference("udp.port", artnet_handle);
   rdm_handle      = find_dissector_add_dependency("rdm", proto_artnet);
   dmx_chan_handle = find_dissector_add_dependency("dmx-chan", proto_artnet);
 
   heur_dissector_add("udp", dissect_artnet_heur, "ARTNET over UDP", "artnet_udp", proto_artnet, HEURISTIC_ENABLE);
+  heur_dissector_set_signature("artnet_udp", &artnet_signature);
 }
 
 /*
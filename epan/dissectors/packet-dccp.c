@@ -1168,6 +1168,7 @@ dissect_dccp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void *data _U_
     * to tap listeners.
     */
     dccph->stream = dccpd->stream;
+    follow_stream_index_add_frame(pinfo, proto_dccp, dccpd->stream);
 
     dccph->data_offset = tvb_get_guint8(tvb, offset);
     advertised_dccp_header_len = dccph->data_offset * 4;
@@ -371,17 +371,11 @@ dissect_eth_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *parent_tree,
   eth_hdr           *ehdr;
   gboolean          is_802_2;
   proto_tree        *fh_tree = NULL;
-  static eth_hdr    ehdrs[4];
-  static int        ehdr_num=0;
   proto_tree        *tree;
   ethertype_data_t  ethertype_data;
   heur_dtbl_entry_t *hdtbl_entry = NULL;
 
-  ehdr_num++;
-  if(ehdr_num>=4){
-     ehdr_num=0;
-  }
-  ehdr=&ehdrs[ehdr_num];
+  ehdr=wmem_new0(pinfo->pool, eth_hdr);
 
   tree=parent_tree;
 
@@ -312,15 +312,9 @@ dissect_fddi(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
   guchar          *src = (guchar*)wmem_alloc(pinfo->pool, 6), *dst = (guchar*)wmem_alloc(pinfo->pool, 6);
   guchar           src_swapped[6], dst_swapped[6];
   tvbuff_t        *next_tvb;
-  static fddi_hdr  fddihdrs[4];
-  static int       fddihdr_num = 0;
   fddi_hdr        *fddihdr;
 
-  fddihdr_num++;
-  if (fddihdr_num >= 4) {
-     fddihdr_num = 0;
-  }
-  fddihdr = &fddihdrs[fddihdr_num];
+  fddihdr = wmem_new0(pinfo->pool, fddi_hdr);
 
   col_set_str(pinfo->cinfo, COL_PROTOCOL, "FDDI");
 
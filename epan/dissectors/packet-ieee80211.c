@@ -40335,7 +40335,6 @@ dissect_ieee80211_common(tvbuff_t *tvb, packet_info *pinfo,
   gboolean         isDMG = (phdr->phy == PHDR_802_11_PHY_11AD);
   gboolean         isS1G = (phdr->phy == PHDR_802_11_PHY_11AH);
   guint16          fcf;
-  static wlan_hdr_t whdrs[4];
   wlan_hdr_t *whdr;
 
   /* Update these so the info is available down the line */
@@ -40346,8 +40345,7 @@ dissect_ieee80211_common(tvbuff_t *tvb, packet_info *pinfo,
 
   p_add_proto_data(wmem_file_scope(), pinfo, proto_wlan, IS_DMG_KEY, GINT_TO_POINTER(isDMG));
 
-  memset(&whdrs[0], 0, sizeof(wlan_hdr_t) * 4);
-  whdr= &whdrs[0];
+  whdr = wmem_new0(pinfo->pool, wlan_hdr_t);
 
   p_add_proto_data(wmem_file_scope(), pinfo, proto_wlan, IS_S1G_KEY, GINT_TO_POINTER(isS1G));
 
@@ -290,15 +290,9 @@ dissect_ipx(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
 	char 		*str;
 	guint16		first_socket, second_socket;
 	guint32		ipx_snet, ipx_dnet;
-	static ipxhdr_t ipxh_arr[4];
-	static int ipx_current=0;
 	ipxhdr_t *ipxh;
 
-	ipx_current++;
-	if(ipx_current==4){
-		ipx_current=0;
-	}
-	ipxh=&ipxh_arr[ipx_current];
+	ipxh=wmem_new0(pinfo->pool, ipxhdr_t);
 
 
 	col_set_str(pinfo->cinfo, COL_PROTOCOL, "IPX");
@@ -1855,7 +1855,11 @@ proto_register_mp2t(void)
 void
 proto_reg_handoff_mp2t(void)
 {
+    static const guint8 mp2t_sync[] = { MP2T_SYNC_BYTE };
+    static const heur_signature_t mp2t_signature = { MP2T_PACKET_SIZE, 0, 1, mp2t_sync, NULL };
+
     heur_dissector_add("udp", heur_dissect_mp2t, "MP2T over UDP", "mp2t_udp", proto_mp2t, HEURISTIC_ENABLE);
+    heur_dissector_set_signature("mp2t_udp", &mp2t_signature);
 
     dissector_add_uint("rtp.pt", PT_MP2T, mp2t_handle);
     dissector_add_for_decode_as_with_preference("tcp.port", mp2t_handle);
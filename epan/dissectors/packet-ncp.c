@@ -129,8 +129,6 @@ static expert_field ei_ncp_new_server_session = EI_INIT;
 static expert_field ei_ncp_type = EI_INIT;
 
 static struct novell_tap ncp_tap;
-static struct ncp_common_header     header;
-static struct ncp_common_header    *ncp_hdr;
 
 dissector_handle_t nds_data_handle;
 
@@ -837,11 +835,14 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     guint16               missing_fraglist_count = 0;
     mncp_rhash_value      *request_value = NULL;
     conversation_t        *conversation;
+    struct ncp_common_header *header;
 
     col_set_str(pinfo->cinfo, COL_PROTOCOL, "NCP");
     col_clear(pinfo->cinfo, COL_INFO);
 
-    ncp_hdr = &header;
+    /* Handed to the tap, whose listeners can run after the next packet
+       has been dissected. */
+    header = wmem_new(pinfo->pool, struct ncp_common_header);
 
     ti = proto_tree_add_item(tree, proto_ncp, tvb, 0, -1, ENC_NA);
     ncp_tree = proto_item_add_subtree(ti, ett_ncp);
@@ -875,13 +876,13 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
         memset(&ncpiph, 0, sizeof(ncpiph));
     }
 
-    header.type         = tvb_get_ntohs(tvb, commhdr);
-    header.sequence     = tvb_get_guint8(tvb, commhdr+2);
-    header.conn_low     = tvb_get_guint8(tvb, commhdr+3);
-    header.task         = tvb_get_guint8(tvb, commhdr+4);
-    header.conn_high    = tvb_get_guint8(tvb, commhdr+5);
-    proto_tree_add_uint(ncp_tree, hf_ncp_type, tvb, commhdr, 2, header.type);
-    nw_connection = (header.conn_high*256)+header.conn_low;
+    header->type         = tvb_get_ntohs(tvb, commhdr);
+    header->sequence     = tvb_get_guint8(tvb, commhdr+2);
+    header->conn_low     = tvb_get_guint8(tvb, commhdr+3);
+    header->task         = tvb_get_guint8(tvb, commhdr+4);
+    header->conn_high    = tvb_get_guint8(tvb, commhdr+5);
+    proto_tree_add_uint(ncp_tree, hf_ncp_type, tvb, commhdr, 2, header->type);
+    nw_connection = (header->conn_high*256)+header->conn_low;
 
     /* Ok, we need to track the conversation so that we can
      * determine if a new server session is occurring for this
@@ -900,12 +901,12 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
                  * request made that caused this
                  * reply
                  */
-                request_value = mncp_hash_lookup(conversation, nw_connection, header.task);
+                request_value = mncp_hash_lookup(conversation, nw_connection, header->task);
                 /* if for some reason we have no
                  * conversation in our hash, create
                  * one */
                 if (request_value == NULL) {
-                    mncp_hash_insert(conversation, nw_connection, header.task, pinfo);
+                    mncp_hash_insert(conversation, nw_connection, header->task, pinfo);
                 }
             } else {
                 /* It's not part of any conversation
@@ -913,7 +914,7 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
                  */
                 conversation = conversation_new(pinfo->num, &pinfo->src,
                     &pinfo->dst, CONVERSATION_NCP, (guint32) pinfo->srcport, (guint32) pinfo->destport, 0);
-                mncp_hash_insert(conversation, nw_connection, header.task, pinfo);
+                mncp_hash_insert(conversation, nw_connection, header->task, pinfo);
             }
             /* If this is a request packet then we
              * might have a new task
@@ -924,14 +925,14 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
                  * request packet, so look up the
                  * request value and check the task number
                  */
-                /*request_value = mncp_hash_lookup(conversation, nw_connection, header.task);*/
+                /*request_value = mncp_hash_lookup(conversation, nw_connection, header->task);*/
             }
         } else {
             /* Get request value data */
-            request_value = mncp_hash_lookup(conversation, nw_connection, header.task);
+            request_value = mncp_hash_lookup(conversation, nw_connection, header->task);
             if (request_value) {
                 if ((request_value->session_start_packet_num == pinfo->num) && ncp_echo_conn) {
-                    expert_add_info_format(pinfo, NULL, &ei_ncp_new_server_session, "Detected New Server Session. Connection %d, Task %d", nw_connection, header.task);
+                    expert_add_info_format(pinfo, NULL, &ei_ncp_new_server_session, "Detected New Server Session. Connection %d, Task %d", nw_connection, header->task);
                 }
             }
         }
@@ -942,12 +943,12 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
                  * request made that caused this
                  * reply
                  */
-                request_value = mncp_hash_lookup(conversation, nw_connection, header.task);
+                request_value = mncp_hash_lookup(conversation, nw_connection, header->task);
                 /* if for some reason we have no
                  * conversation in our hash, create
                  * one */
                 if (request_value == NULL) {
-                    mncp_hash_insert(conversation, nw_connection, header.task, pinfo);
+                    mncp_hash_insert(conversation, nw_connection, header->task, pinfo);
                 }
             } else {
                 /* It's not part of any conversation
@@ -955,33 +956,33 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
                  */
                 conversation = conversation_new(pinfo->num, &pinfo->src,
                     &pinfo->dst, CONVERSATION_NCP, (guint32) pinfo->srcport, (guint32) pinfo->destport, 0);
-                mncp_hash_insert(conversation, nw_connection, header.task, pinfo);
+                mncp_hash_insert(conversation, nw_connection, header->task, pinfo);
             }
             /* find the record telling us the request
              * made that caused this reply
              */
         } else {
-            request_value = mncp_hash_lookup(conversation, nw_connection, header.task);
+            request_value = mncp_hash_lookup(conversation, nw_connection, header->task);
             if (request_value) {
                 if ((request_value->session_start_packet_num == pinfo->num) && ncp_echo_conn) {
-                    expert_add_info_format(pinfo, NULL, &ei_ncp_new_server_session, "Detected New Server Session. Connection %d, Task %d", nw_connection, header.task);
+                    expert_add_info_format(pinfo, NULL, &ei_ncp_new_server_session, "Detected New Server Session. Connection %d, Task %d", nw_connection, header->task);
                 }
             }
         }
     }
 
-    tap_queue_packet(ncp_tap.hdr, pinfo, ncp_hdr);
+    tap_queue_packet(ncp_tap.hdr, pinfo, header);
 
     col_add_str(pinfo->cinfo, COL_INFO,
-        val_to_str(header.type, ncp_type_vals, "Unknown type (0x%04x)"));
+        val_to_str(header->type, ncp_type_vals, "Unknown type (0x%04x)"));
 
     /*
-     * Process the packet-type-specific header.
+     * Process the packet-type-specific header->
      */
-    switch (header.type) {
+    switch (header->type) {
 
     case NCP_BROADCAST_SLOT:    /* Server Broadcast */
-        proto_tree_add_uint(ncp_tree, hf_ncp_seq, tvb, commhdr + 2, 1, header.sequence);
+        proto_tree_add_uint(ncp_tree, hf_ncp_seq, tvb, commhdr + 2, 1, header->sequence);
         proto_tree_add_uint(ncp_tree, hf_ncp_connection,tvb, commhdr + 3, 3, nw_connection);
         proto_tree_add_item(ncp_tree, hf_ncp_task, tvb, commhdr + 4, 1, ENC_BIG_ENDIAN);
         proto_tree_add_item(ncp_tree, hf_ncp_oplock_flag, tvb, commhdr + 9, 1, ENC_BIG_ENDIAN);
@@ -1003,7 +1004,7 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
         /*
          * XXX - we should keep track of whether there's a burst
          * outstanding on a connection and, if not, treat the
-         * beginning of the data as a burst header.
+         * beginning of the data as a burst header->
          *
          * The burst header contains:
          *
@@ -1185,7 +1186,7 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     case NCP_WATCHDOG:        /* Watchdog Packet */
     case NCP_DEALLOCATE_SLOT:    /* Deallocate Slot Request */
     default:
-        proto_tree_add_uint(ncp_tree, hf_ncp_seq, tvb, commhdr + 2, 1, header.sequence);
+        proto_tree_add_uint(ncp_tree, hf_ncp_seq, tvb, commhdr + 2, 1, header->sequence);
         /* XXX - what's at commhdr + 3 in a LIP Echo packet?
            commhdr + 4 on is the LIP echo magic number and data. */
         if (!is_lip_echo_allocate_slot) {
@@ -1198,7 +1199,7 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     /*
      * Process the packet body.
      */
-    switch (header.type) {
+    switch (header->type) {
 
     case NCP_ALLOCATE_SLOT:        /* Allocate Slot Request */
         if (is_lip_echo_allocate_slot) {
@@ -1209,13 +1210,13 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
         }
         next_tvb = tvb_new_subset_remaining(tvb, commhdr);
         dissect_ncp_request(next_tvb, pinfo, nw_connection,
-            header.sequence, header.type, is_lip_echo_allocate_slot, ncp_tree);
+            header->sequence, header->type, is_lip_echo_allocate_slot, ncp_tree);
         break;
 
     case NCP_DEALLOCATE_SLOT:    /* Deallocate Slot Request */
         next_tvb = tvb_new_subset_remaining(tvb, commhdr);
         dissect_ncp_request(next_tvb, pinfo, nw_connection,
-            header.sequence, header.type, FALSE, ncp_tree);
+            header->sequence, header->type, FALSE, ncp_tree);
         break;
 
     case NCP_SERVICE_REQUEST:    /* Server NCP Request */
@@ -1227,32 +1228,32 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
 
             case 0x02:    /* NDS Frag Packet to decode */
                 dissect_nds_request(next_tvb, pinfo,
-                    nw_connection, header.sequence,
-                    header.type, ncp_tree);
+                    nw_connection, header->sequence,
+                    header->type, ncp_tree);
                 break;
 
             case 0x01:    /* NDS Ping */
                 dissect_ping_req(next_tvb, pinfo,
-                    nw_connection, header.sequence,
-                    header.type, ncp_tree);
+                    nw_connection, header->sequence,
+                    header->type, ncp_tree);
                 break;
 
             default:
                 dissect_ncp_request(next_tvb, pinfo,
-                    nw_connection, header.sequence,
-                    header.type, FALSE, ncp_tree);
+                    nw_connection, header->sequence,
+                    header->type, FALSE, ncp_tree);
                 break;
              }
         } else {
             dissect_ncp_request(next_tvb, pinfo, nw_connection,
-                header.sequence, header.type, FALSE, ncp_tree);
+                header->sequence, header->type, FALSE, ncp_tree);
         }
         break;
 
     case NCP_SERVICE_REPLY:        /* Server NCP Reply */
         next_tvb = tvb_new_subset_remaining(tvb, commhdr);
-        nds_defrag(next_tvb, pinfo, nw_connection, header.sequence,
-            header.type, ncp_tree, &ncp_tap);
+        nds_defrag(next_tvb, pinfo, nw_connection, header->sequence,
+            header->type, ncp_tree, &ncp_tap);
         break;
 
     case NCP_POSITIVE_ACK:        /* Positive Acknowledgement */
@@ -1263,7 +1264,7 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
          */
         next_tvb = tvb_new_subset_remaining(tvb, commhdr);
         dissect_ncp_reply(next_tvb, pinfo, nw_connection,
-            header.sequence, header.type, ncp_tree, &ncp_tap);
+            header->sequence, header->type, ncp_tree, &ncp_tap);
         break;
 
     case NCP_WATCHDOG:        /* Watchdog Packet */
@@ -1331,7 +1332,7 @@ dissect_ncp_common(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree,
     default:
         proto_tree_add_expert_format(ncp_tree, pinfo, &ei_ncp_type, tvb, commhdr + 6, -1,
             "%s packets not supported yet",
-            val_to_str(header.type, ncp_type_vals,
+            val_to_str(header->type, ncp_type_vals,
                 "Unknown type (0x%04x)"));
         break;
     }
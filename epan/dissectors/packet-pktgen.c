@@ -171,8 +171,12 @@ void proto_register_pktgen(void)
 
 void proto_reg_handoff_pktgen(void)
 {
+    static const guint8 pktgen_magic[] = { 0xbe, 0x9b, 0xe9, 0x55 };
+    static const heur_signature_t pktgen_signature = { 16, 0, 4, pktgen_magic, NULL };
+
     /* Register as a heuristic UDP dissector */
     heur_dissector_add("udp", dissect_pktgen, "Linux Kernel Packet Generator over UDP", "pktgen_udp", proto_pktgen, HEURISTIC_ENABLE);
+    heur_dissector_set_signature("pktgen_udp", &pktgen_signature);
 }
 
 
@@ -17254,8 +17254,13 @@ prefs_register_bool_preference(rtps_module, "enable_rtps_checksum_check",
 }
 
 void proto_reg_handoff_rtps(void) {
+  /* "RTPS" or "RTPX", followed by at least a 12 byte header */
+  static const guint8 rtps_magic[] = { 'R', 'T', 'P' };
+  static const heur_signature_t rtps_signature = { 16, 0, 3, rtps_magic, NULL };
+
   heur_dissector_add("rtitcp", dissect_rtps_rtitcp, "RTPS over RTITCP", "rtps_rtitcp", proto_rtps, HEURISTIC_ENABLE);
   heur_dissector_add("udp", dissect_rtps_udp, "RTPS over UDP", "rtps_udp", proto_rtps, HEURISTIC_ENABLE);
+  heur_dissector_set_signature("rtps_udp", &rtps_signature);
   heur_dissector_add("tcp", dissect_rtps_tcp, "RTPS over TCP", "rtps_tcp", proto_rtps, HEURISTIC_ENABLE);
 }
 
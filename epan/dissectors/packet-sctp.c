@@ -4871,7 +4871,7 @@ dissect_sctp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_
 
   dissect_sctp_packet(tvb, pinfo, tree, FALSE);
   if (!pinfo->flags.in_error_pkt && sctp_info.number_of_tvbs > 0)
-    tap_queue_packet(sctp_tap, pinfo, &sctp_info);
+    tap_queue_packet(sctp_tap, pinfo, wmem_memdup(pinfo->pool, &sctp_info, sizeof(sctp_info)));
 
   return tvb_captured_length(tvb);
 }
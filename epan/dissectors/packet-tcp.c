@@ -3845,7 +3845,7 @@ split_msp(packet_info *pinfo, struct tcp_multisegment_pdu *msp, struct tcp_analy
                 frag_offset = split_offset;
                 frag_len -= (split_offset - fd_i->offset);
             }
-            fragment_add_out_of_order(&tcp_reassembly_table, fd_head->tvb_data,
+            fragment_add_out_of_order(&tcp_reassembly_table, fragment_get_reassembled_data(fd_head, pinfo),
                          frag_offset, pinfo, first_frame, newmsp,
                          frag_offset - split_offset, frag_len, TRUE, fd_i->frame);
         }
@@ -4526,7 +4526,7 @@ again:
             tvbuff_t *next_tvb;
 
             /* create a new TVB structure for desegmented data */
-            next_tvb = tvb_new_chain(tvb, ipfd_head->tvb_data);
+            next_tvb = tvb_new_chain(tvb, fragment_get_reassembled_data(ipfd_head, pinfo));
 
             /* add desegmented data to the data source list */
             add_new_data_source(pinfo, next_tvb, "Reassembled TCP");
@@ -7867,6 +7867,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
          * to tap listeners.
          */
         tcph->th_stream = tcpd->stream;
+        follow_stream_index_add_frame(pinfo, proto_tcp, tcpd->stream);
 
         /* initialize the SACK blocks seen to 0 */
         if(tcp_analyze_seq && tcpd->fwd->tcp_analyze_seq_info) {
@@ -8603,7 +8604,7 @@ dissect_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
                     /* create a new TVB structure for desegmented data
                      * datalen-1 to strip the dummy FIN byte off
                      */
-                    next_tvb = tvb_new_chain(tvb, ipfd_head->tvb_data);
+                    next_tvb = tvb_new_chain(tvb, fragment_get_reassembled_data(ipfd_head, pinfo));
 
                     /* add desegmented data to the data source list */
                     add_new_data_source(pinfo, next_tvb, "Reassembled TCP");
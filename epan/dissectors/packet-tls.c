@@ -4837,6 +4837,7 @@ proto_register_tls(void)
 
     register_follow_stream(proto_tls, "tls", tcp_follow_conv_filter, tcp_follow_index_filter, tcp_follow_address_filter,
                             tcp_port_to_display, ssl_follow_tap_listener, get_tcp_stream_count, NULL);
+    set_follow_stream_index(proto_tls, "tcp");
     secrets_register_type(SECRETS_TYPE_TLS, tls_secrets_block_callback);
 }
 
@@ -378,8 +378,6 @@ dissect_tr(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
 	volatile guint16	first2_sr;
 	tvbuff_t		*volatile tr_tvb;
 
-	static tr_hdr trh_arr[4];
-	static int trh_current=0;
 	tr_hdr *volatile trh;
 
 	/* non-source-routed version of source addr */
@@ -390,11 +388,7 @@ dissect_tr(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
 	static const char *fc[] = { "MAC", "LLC", "Reserved", "Unknown" };
 
 
-	trh_current++;
-	if(trh_current==4){
-		trh_current=0;
-	}
-	trh=&trh_arr[trh_current];
+	trh=wmem_new0(pinfo->pool, tr_hdr);
 
 	col_set_str(pinfo->cinfo, COL_PROTOCOL, "TR");
 
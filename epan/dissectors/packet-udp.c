@@ -1201,6 +1201,7 @@ dissect(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, guint32 ip_proto)
         * to tap listeners.
         */
         udph->uh_stream = udpd->stream;
+        follow_stream_index_add_frame(pinfo, proto_udp, udpd->stream);
     }
 
     tap_queue_packet(udp_tap, pinfo, udph);
@@ -1022,6 +1022,7 @@ proto_register_websocket(void)
   register_follow_stream(proto_websocket, "websocket_follow", tcp_follow_conv_filter, tcp_follow_index_filter,
                          tcp_follow_address_filter,	tcp_port_to_display, follow_tvb_tap_listener,
                          get_tcp_stream_count, NULL);
+  set_follow_stream_index(proto_websocket, "tcp");
 
   proto_register_field_array(proto_websocket, hf, array_length(hf));
   proto_register_subtree_array(ett, array_length(ett));
@@ -586,8 +586,6 @@ epan_dissect_reset(epan_dissect_t *edt)
 
 	wtap_block_unref(edt->pi.rec->block);
 
-	g_slist_free(edt->pi.proto_data);
-
 	/* Free the data sources list. */
 	free_data_sources(&edt->pi);
 
@@ -633,6 +631,8 @@ epan_dissect_run(epan_dissect_t *edt, int file_type_subtype,
 #ifdef HAVE_LUA
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
+	/* Parallel tap listeners may still hold the packet scope. */
+	tap_parallel_sync();
 	wmem_enter_packet_scope();
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
 
@@ -647,13 +647,17 @@ epan_dissect_run_with_taps(epan_dissect_t *edt, int file_type_subtype,
 	wtap_rec *rec, tvbuff_t *tvb, frame_data *fd,
 	column_info *cinfo)
 {
-	wmem_enter_packet_scope();
+	/* During a parallel retap the packet scope stays open until the
+	   tap listeners are done with it; see tap_parallel_sync(). */
+	if (!tap_parallel_active() || !wmem_in_scope(wmem_packet_scope()))
+		wmem_enter_packet_scope();
 	tap_queue_init(edt);
 	dissect_record(edt, file_type_subtype, rec, tvb, fd, cinfo);
 	tap_push_tapped_queue(edt);
 
 	/* free all memory allocated */
-	wmem_leave_packet_scope();
+	if (!tap_parallel_hold_packet_scope())
+		wmem_leave_packet_scope();
 	wtap_block_unref(rec->block);
 	rec->block = NULL;
 }
@@ -665,6 +669,8 @@ epan_dissect_file_run(epan_dissect_t *edt, wtap_rec *rec,
 #ifdef HAVE_LUA
 	wslua_prime_dfilter(edt); /* done before entering wmem scope */
 #endif
+	/* Parallel tap listeners may still hold the packet scope. */
+	tap_parallel_sync();
 	wmem_enter_packet_scope();
 	dissect_file(edt, rec, tvb, fd, cinfo);
 
@@ -678,13 +684,17 @@ void
 epan_dissect_file_run_with_taps(epan_dissect_t *edt, wtap_rec *rec,
 	tvbuff_t *tvb, frame_data *fd, column_info *cinfo)
 {
-	wmem_enter_packet_scope();
+	/* During a parallel retap the packet scope stays open until the
+	   tap listeners are done with it; see tap_parallel_sync(). */
+	if (!tap_parallel_active() || !wmem_in_scope(wmem_packet_scope()))
+		wmem_enter_packet_scope();
 	tap_queue_init(edt);
 	dissect_file(edt, rec, tvb, fd, cinfo);
 	tap_push_tapped_queue(edt);
 
 	/* free all memory allocated */
-	wmem_leave_packet_scope();
+	if (!tap_parallel_hold_packet_scope())
+		wmem_leave_packet_scope();
 	wtap_block_unref(rec->block);
 	rec->block = NULL;
 }
@@ -696,8 +706,6 @@ epan_dissect_cleanup(epan_dissect_t* edt)
 
 	g_slist_foreach(epan_plugins, epan_plugin_dissect_cleanup, edt);
 
-	g_slist_free(edt->pi.proto_data);
-
 	/* Free the data sources list. */
 	free_data_sources(&edt->pi);
 
@@ -749,6 +757,62 @@ epan_dissect_prime_with_hfid_array(epan_dissect_t *edt, GArray *hfids)
 	}
 }
 
+static void
+epan_append_dfilter_fields(GArray *wanted, const dfilter_t *dfcode)
+{
+	const int *fields;
+	int num_fields;
+
+	if (dfcode == NULL)
+		return;
+
+	fields = dfilter_get_interesting_fields(dfcode, &num_fields);
+	g_array_append_vals(wanted, fields, num_fields);
+}
+
+gboolean
+epan_limit_dissection(const dfilter_t *rfcode, const dfilter_t *dfcode, GArray *hfids)
+{
+	GArray *wanted;
+	gboolean limited;
+	int hf_frame_protocols;
+	guint i;
+
+	epan_clear_dissection_limit();
+
+	if (!prefs.limit_dissection_to_filter)
+		return FALSE;
+
+	if (dfilter_requires_columns(rfcode) || dfilter_requires_columns(dfcode) ||
+	    tap_listeners_require_dissection() || postdissectors_want_hfids())
+		return FALSE;
+
+	wanted = g_array_new(FALSE, FALSE, sizeof(int));
+	epan_append_dfilter_fields(wanted, rfcode);
+	epan_append_dfilter_fields(wanted, dfcode);
+	if (hfids != NULL)
+		g_array_append_vals(wanted, hfids->data, hfids->len);
+
+	/* frame.protocols lists every layer, so it needs them all. */
+	hf_frame_protocols = proto_registrar_get_id_byname("frame.protocols");
+	for (i = 0; i < wanted->len; i++) {
+		if (g_array_index(wanted, int, i) == hf_frame_protocols)
+			break;
+	}
+
+	limited = i == wanted->len &&
+	    dissector_limit_to_fields((const int *)(void *)wanted->data, wanted->len);
+	g_array_free(wanted, TRUE);
+
+	return limited;
+}
+
+void
+epan_clear_dissection_limit(void)
+{
+	dissector_limit_clear();
+}
+
 /* ----------------------- */
 const gchar *
 epan_custom_set(epan_dissect_t *edt, GSList *field_ids,
@@ -243,6 +243,28 @@ WS_DLL_PUBLIC
 void
 epan_dissect_prime_with_hfid_array(epan_dissect_t *edt, GArray *hfids);
 
+/**
+ * If the "protocols.limit_dissection_to_filter" preference is set, limit
+ * dissection to the protocols that can add one of the fields read by the
+ * filters or given in hfids; see dissector_limit_to_fields(). Dissection
+ * isn't limited if a filter uses columns or if a tap listener or a
+ * postdissector needs the packets dissected.
+ *
+ * @param rfcode A read filter, or NULL
+ * @param dfcode A display filter, or NULL
+ * @param hfids Other wanted fields, or NULL
+ * @return TRUE if dissection was limited
+ */
+WS_DLL_PUBLIC
+gboolean
+epan_limit_dissection(const struct epan_dfilter *rfcode,
+        const struct epan_dfilter *dfcode, GArray *hfids);
+
+/** Undo epan_limit_dissection(). */
+WS_DLL_PUBLIC
+void
+epan_clear_dissection_limit(void);
+
 /** fill the dissect run output into the packet list columns */
 WS_DLL_PUBLIC
 void
@@ -0,0 +1,567 @@
+/* field_index.c
+ * Per-capture columnar index of selected field values, used to re-apply
+ * display filters without re-dissecting frames.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/field_index.h>
+#include <epan/prefs.h>
+#include <epan/proto.h>
+#include <epan/ipv6.h>
+#include <wsutil/wslog.h>
+#include <wsutil/ws_assert.h>
+
+typedef enum {
+    FIELD_INDEX_PRESENCE,   /* FT_NONE and FT_PROTOCOL: occurrences only */
+    FIELD_INDEX_UNSIGNED,
+    FIELD_INDEX_SIGNED,
+    FIELD_INDEX_IPv4,
+    FIELD_INDEX_IPv6,
+    FIELD_INDEX_STRING
+} field_index_kind_t;
+
+typedef struct {
+    header_field_info  *hfinfo;         /* First field registered with this name */
+    field_index_kind_t  kind;
+    unsigned            width;          /* Bytes per value in "values" */
+    GArray             *offsets;        /* guint32; frame N is [offsets[N-1], offsets[N]) */
+    GByteArray         *values;
+    /* String dictionary. */
+    GHashTable         *dict;           /* GBytes -> id + 1 */
+    GPtrArray          *dict_strings;   /* id -> GBytes */
+    GPtrArray          *dict_fvalues;   /* id -> fvalue_t, created on demand */
+    /* fvalue_t's lent to the filter engine while evaluating one frame. */
+    GPtrArray          *scratch;
+} field_column_t;
+
+struct field_index {
+    GPtrArray  *columns;                /* field_column_t */
+    GHashTable *columns_by_hfid;        /* hfinfo->id -> field_column_t */
+    uint32_t    num_frames;
+    uint64_t    num_values;
+    int64_t     build_time;
+    uint64_t    frames_filtered;
+    /* Frame being evaluated by field_index_filter_frame(). */
+    uint32_t    cur_frame;
+};
+
+static unsigned
+value_width(ftenum_t ftype)
+{
+    switch (ftype) {
+        case FT_CHAR:
+        case FT_UINT8:
+        case FT_INT8:
+            return 1;
+        case FT_UINT16:
+        case FT_INT16:
+            return 2;
+        case FT_UINT24:
+        case FT_UINT32:
+        case FT_INT24:
+        case FT_INT32:
+        case FT_FRAMENUM:
+        case FT_IPv4:
+            return 4;
+        case FT_IPv6:
+            return FT_IPv6_LEN;
+        default:
+            if (FT_IS_STRING(ftype))
+                return sizeof(guint32);
+            return 8;
+    }
+}
+
+static bool
+column_kind(ftenum_t ftype, field_index_kind_t *kind)
+{
+    if (ftype == FT_NONE || ftype == FT_PROTOCOL) {
+        *kind = FIELD_INDEX_PRESENCE;
+    } else if (FT_IS_UINT(ftype) || ftype == FT_BOOLEAN) {
+        *kind = FIELD_INDEX_UNSIGNED;
+    } else if (FT_IS_INT(ftype)) {
+        *kind = FIELD_INDEX_SIGNED;
+    } else if (ftype == FT_IPv4) {
+        *kind = FIELD_INDEX_IPv4;
+    } else if (ftype == FT_IPv6) {
+        *kind = FIELD_INDEX_IPv6;
+    } else if (FT_IS_STRING(ftype)) {
+        *kind = FIELD_INDEX_STRING;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void
+column_free(gpointer data)
+{
+    field_column_t *col = (field_column_t *)data;
+
+    g_array_free(col->offsets, TRUE);
+    g_byte_array_free(col->values, TRUE);
+    if (col->dict) {
+        g_hash_table_destroy(col->dict);
+        g_ptr_array_free(col->dict_strings, TRUE);
+        g_ptr_array_free(col->dict_fvalues, TRUE);
+    }
+    g_ptr_array_free(col->scratch, TRUE);
+    g_free(col);
+}
+
+static void
+column_clear(field_column_t *col)
+{
+    guint32 zero = 0;
+
+    g_array_set_size(col->offsets, 0);
+    g_array_append_val(col->offsets, zero);
+    g_byte_array_set_size(col->values, 0);
+    if (col->dict) {
+        g_hash_table_remove_all(col->dict);
+        g_ptr_array_set_size(col->dict_strings, 0);
+        g_ptr_array_set_size(col->dict_fvalues, 0);
+    }
+}
+
+static field_column_t *
+column_new(header_field_info *hfinfo, field_index_kind_t kind)
+{
+    field_column_t *col = g_new0(field_column_t, 1);
+
+    col->hfinfo = hfinfo;
+    col->kind = kind;
+    col->width = kind == FIELD_INDEX_PRESENCE ? 0 : value_width(hfinfo->type);
+    col->offsets = g_array_new(FALSE, FALSE, sizeof(guint32));
+    col->values = g_byte_array_new();
+    if (kind == FIELD_INDEX_STRING) {
+        col->dict = g_hash_table_new(g_bytes_hash, g_bytes_equal);
+        col->dict_strings = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+        col->dict_fvalues = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+    }
+    col->scratch = g_ptr_array_new_with_free_func((GDestroyNotify)fvalue_free);
+    column_clear(col);
+    return col;
+}
+
+field_index_t *
+field_index_new(const char *fields, char **err_msg)
+{
+    field_index_t *idx;
+    char **names;
+    header_field_info *hfinfo;
+    field_index_kind_t kind;
+    int proto_cols;
+
+    if (fields == NULL)
+        return NULL;
+
+    idx = g_new0(field_index_t, 1);
+    idx->columns = g_ptr_array_new_with_free_func(column_free);
+    idx->columns_by_hfid = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    proto_cols = proto_get_id_by_filter_name("_ws.col");
+
+    names = g_strsplit_set(fields, ", \t", -1);
+    for (char **name = names; *name != NULL; name++) {
+        if (**name == '\0')
+            continue;
+
+        hfinfo = proto_registrar_get_byname(*name);
+        if (hfinfo == NULL) {
+            *err_msg = ws_strdup_printf("\"%s\" isn't a valid field name", *name);
+            goto fail;
+        }
+        /* The display filter engine always starts with the first field
+         * registered with a given name, so do the same. */
+        while (hfinfo->same_name_prev_id != -1) {
+            hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+        }
+        if (g_hash_table_contains(idx->columns_by_hfid, GINT_TO_POINTER(hfinfo->id)))
+            continue;
+
+        /* Column fields are only present when columns are constructed,
+         * which we can't guarantee on the first pass. */
+        if (hfinfo->id == proto_cols ||
+                (hfinfo->parent != -1 && hfinfo->parent == proto_cols)) {
+            *err_msg = ws_strdup_printf("Column field \"%s\" can't be indexed", *name);
+            goto fail;
+        }
+
+        if (!column_kind(hfinfo->type, &kind)) {
+            *err_msg = ws_strdup_printf("Fields of type %s (\"%s\") can't be indexed",
+                    ftype_pretty_name(hfinfo->type), *name);
+            goto fail;
+        }
+        /* Every field with the same name must fit in the same column. */
+        for (header_field_info *hf = hfinfo->same_name_next; hf; hf = hf->same_name_next) {
+            field_index_kind_t same_kind;
+            if (!column_kind(hf->type, &same_kind) || same_kind != kind ||
+                    value_width(hf->type) != value_width(hfinfo->type)) {
+                *err_msg = ws_strdup_printf("\"%s\" is registered with incompatible types", *name);
+                goto fail;
+            }
+        }
+
+        field_column_t *col = column_new(hfinfo, kind);
+        g_ptr_array_add(idx->columns, col);
+        g_hash_table_insert(idx->columns_by_hfid, GINT_TO_POINTER(hfinfo->id), col);
+    }
+    g_strfreev(names);
+
+    if (idx->columns->len == 0) {
+        field_index_free(idx);
+        return NULL;
+    }
+    return idx;
+
+fail:
+    g_strfreev(names);
+    field_index_free(idx);
+    return NULL;
+}
+
+field_index_t *
+field_index_new_from_prefs(void)
+{
+    field_index_t *idx;
+    char *err_msg = NULL;
+
+    if (prefs.field_index_fields == NULL || *prefs.field_index_fields == '\0')
+        return NULL;
+
+    idx = field_index_new(prefs.field_index_fields, &err_msg);
+    if (err_msg) {
+        ws_warning("Field index disabled: %s", err_msg);
+        g_free(err_msg);
+    }
+    return idx;
+}
+
+void
+field_index_free(field_index_t *idx)
+{
+    if (idx == NULL)
+        return;
+
+    g_hash_table_destroy(idx->columns_by_hfid);
+    g_ptr_array_free(idx->columns, TRUE);
+    g_free(idx);
+}
+
+void
+field_index_reset(field_index_t *idx)
+{
+    for (unsigned i = 0; i < idx->columns->len; i++) {
+        column_clear((field_column_t *)g_ptr_array_index(idx->columns, i));
+    }
+    idx->num_frames = 0;
+    idx->num_values = 0;
+    idx->build_time = 0;
+    idx->frames_filtered = 0;
+}
+
+void
+field_index_prime_edt(field_index_t *idx, epan_dissect_t *edt)
+{
+    for (unsigned i = 0; i < idx->columns->len; i++) {
+        field_column_t *col = (field_column_t *)g_ptr_array_index(idx->columns, i);
+        for (header_field_info *hf = col->hfinfo; hf; hf = hf->same_name_next) {
+            epan_dissect_prime_with_hfid(edt, hf->id);
+        }
+    }
+}
+
+static guint32
+column_string_id(field_column_t *col, const wmem_strbuf_t *strbuf)
+{
+    GBytes *key;
+    gpointer value;
+    guint32 id;
+
+    key = g_bytes_new(wmem_strbuf_get_str(strbuf), wmem_strbuf_get_len(strbuf));
+    value = g_hash_table_lookup(col->dict, key);
+    if (value != NULL) {
+        g_bytes_unref(key);
+        return GPOINTER_TO_UINT(value) - 1;
+    }
+
+    id = col->dict_strings->len;
+    g_ptr_array_add(col->dict_strings, key);
+    g_ptr_array_add(col->dict_fvalues, NULL);
+    g_hash_table_insert(col->dict, key, GUINT_TO_POINTER(id + 1));
+    return id;
+}
+
+static void
+column_append_value(field_column_t *col, fvalue_t *fv)
+{
+    union {
+        guint8  u8;
+        guint16 u16;
+        guint32 u32;
+        guint64 u64;
+    } v;
+    ftenum_t ftype = fvalue_type_ftenum(fv);
+
+    switch (col->kind) {
+        case FIELD_INDEX_UNSIGNED:
+        case FIELD_INDEX_IPv4:
+            v.u64 = FT_IS_UINT32(ftype) || ftype == FT_IPv4 ?
+                    fvalue_get_uinteger(fv) : fvalue_get_uinteger64(fv);
+            break;
+        case FIELD_INDEX_SIGNED:
+            v.u64 = (guint64)(FT_IS_INT32(ftype) ?
+                    fvalue_get_sinteger(fv) : fvalue_get_sinteger64(fv));
+            break;
+        case FIELD_INDEX_IPv6:
+            g_byte_array_append(col->values, (const guint8 *)&fvalue_get_ipv6(fv)->addr, FT_IPv6_LEN);
+            return;
+        case FIELD_INDEX_STRING:
+            v.u32 = column_string_id(col, fvalue_get_strbuf(fv));
+            g_byte_array_append(col->values, (const guint8 *)&v.u32, sizeof v.u32);
+            return;
+        default:
+            ws_assert_not_reached();
+    }
+
+    switch (col->width) {
+        case 1:
+            v.u8 = (guint8)v.u64;
+            g_byte_array_append(col->values, &v.u8, 1);
+            break;
+        case 2:
+            v.u16 = (guint16)v.u64;
+            g_byte_array_append(col->values, (const guint8 *)&v.u16, 2);
+            break;
+        case 4:
+            v.u32 = (guint32)v.u64;
+            g_byte_array_append(col->values, (const guint8 *)&v.u32, 4);
+            break;
+        default:
+            g_byte_array_append(col->values, (const guint8 *)&v.u64, 8);
+            break;
+    }
+}
+
+void
+field_index_add_frame(field_index_t *idx, uint32_t framenum, proto_tree *tree)
+{
+    gint64 start_time;
+    GPtrArray *finfos;
+    guint32 count;
+
+    if (tree == NULL || framenum != idx->num_frames + 1) {
+        /* Either already indexed or there's a gap that would make the
+         * frame numbers ambiguous; such frames are dissected instead. */
+        return;
+    }
+
+    start_time = g_get_monotonic_time();
+    for (unsigned i = 0; i < idx->columns->len; i++) {
+        field_column_t *col = (field_column_t *)g_ptr_array_index(idx->columns, i);
+
+        count = g_array_index(col->offsets, guint32, col->offsets->len - 1);
+        for (header_field_info *hf = col->hfinfo; hf; hf = hf->same_name_next) {
+            finfos = proto_get_finfo_ptr_array(tree, hf->id);
+            if (finfos == NULL)
+                continue;
+            for (unsigned j = 0; j < finfos->len; j++) {
+                field_info *fi = (field_info *)g_ptr_array_index(finfos, j);
+                if (col->kind != FIELD_INDEX_PRESENCE)
+                    column_append_value(col, fi->value);
+                count++;
+            }
+            idx->num_values += finfos->len;
+        }
+        g_array_append_val(col->offsets, count);
+    }
+    idx->num_frames++;
+    idx->build_time += g_get_monotonic_time() - start_time;
+}
+
+uint32_t
+field_index_num_frames(const field_index_t *idx)
+{
+    return idx->num_frames;
+}
+
+static bool
+field_available(const header_field_info *hfinfo, bool need_values, void *user_data)
+{
+    field_index_t *idx = (field_index_t *)user_data;
+    field_column_t *col;
+
+    col = (field_column_t *)g_hash_table_lookup(idx->columns_by_hfid, GINT_TO_POINTER(hfinfo->id));
+    if (col == NULL)
+        return false;
+    return !need_values || col->kind != FIELD_INDEX_PRESENCE;
+}
+
+bool
+field_index_can_filter(field_index_t *idx, const dfilter_t *df)
+{
+    if (idx == NULL || df == NULL)
+        return false;
+    if (dfilter_requires_columns(df))
+        return false;
+    return dfilter_can_apply_field_source(df, field_available, idx);
+}
+
+static fvalue_t *
+column_scratch_fvalue(field_column_t *col, unsigned n)
+{
+    while (col->scratch->len <= n) {
+        g_ptr_array_add(col->scratch, fvalue_new(col->hfinfo->type));
+    }
+    return (fvalue_t *)g_ptr_array_index(col->scratch, n);
+}
+
+static fvalue_t *
+column_get_fvalue(field_column_t *col, guint32 pos, unsigned n)
+{
+    const guint8 *p = col->values->data + (size_t)pos * col->width;
+    fvalue_t *fv;
+    guint64 u64 = 0;
+    guint32 u32;
+    guint16 u16;
+
+    if (col->kind == FIELD_INDEX_STRING) {
+        /* Dictionary strings are shared by every frame. */
+        memcpy(&u32, p, sizeof u32);
+        fv = (fvalue_t *)g_ptr_array_index(col->dict_fvalues, u32);
+        if (fv == NULL) {
+            gsize len;
+            const char *str = (const char *)g_bytes_get_data(
+                    (GBytes *)g_ptr_array_index(col->dict_strings, u32), &len);
+            fv = fvalue_new(col->hfinfo->type);
+            fvalue_set_strbuf(fv, wmem_strbuf_new_len(NULL, str, len));
+            col->dict_fvalues->pdata[u32] = fv;
+        }
+        return fv;
+    }
+
+    fv = column_scratch_fvalue(col, n);
+    if (col->kind == FIELD_INDEX_IPv6) {
+        ipv6_addr_and_prefix ipv6;
+        memcpy(&ipv6.addr, p, FT_IPv6_LEN);
+        ipv6.prefix = 128;
+        fvalue_set_ipv6(fv, &ipv6);
+        return fv;
+    }
+
+    switch (col->width) {
+        case 1:
+            u64 = col->kind == FIELD_INDEX_SIGNED ? (guint64)(gint8)p[0] : p[0];
+            break;
+        case 2:
+            memcpy(&u16, p, 2);
+            u64 = col->kind == FIELD_INDEX_SIGNED ? (guint64)(gint16)u16 : u16;
+            break;
+        case 4:
+            memcpy(&u32, p, 4);
+            u64 = col->kind == FIELD_INDEX_SIGNED ? (guint64)(gint32)u32 : u32;
+            break;
+        default:
+            memcpy(&u64, p, 8);
+            break;
+    }
+
+    ftenum_t ftype = col->hfinfo->type;
+    if (col->kind == FIELD_INDEX_SIGNED) {
+        if (FT_IS_INT32(ftype))
+            fvalue_set_sinteger(fv, (gint32)u64);
+        else
+            fvalue_set_sinteger64(fv, (gint64)u64);
+    } else if (FT_IS_UINT32(ftype) || ftype == FT_IPv4) {
+        fvalue_set_uinteger(fv, (guint32)u64);
+    } else {
+        fvalue_set_uinteger64(fv, u64);
+    }
+    return fv;
+}
+
+static bool
+field_source(const header_field_info *hfinfo, GPtrArray *values, void *user_data)
+{
+    field_index_t *idx = (field_index_t *)user_data;
+    field_column_t *col;
+    guint32 start, end;
+
+    col = (field_column_t *)g_hash_table_lookup(idx->columns_by_hfid, GINT_TO_POINTER(hfinfo->id));
+    ws_assert(col);
+
+    start = g_array_index(col->offsets, guint32, idx->cur_frame - 1);
+    end = g_array_index(col->offsets, guint32, idx->cur_frame);
+    if (values != NULL) {
+        for (guint32 pos = start; pos < end; pos++) {
+            g_ptr_array_add(values, column_get_fvalue(col, pos, pos - start));
+        }
+    }
+    return end > start;
+}
+
+bool
+field_index_filter_frame(field_index_t *idx, dfilter_t *df, uint32_t framenum,
+        bool *passed)
+{
+    if (framenum == 0 || framenum > idx->num_frames)
+        return false;
+
+    idx->cur_frame = framenum;
+    *passed = dfilter_apply_field_source(df, field_source, idx);
+    idx->frames_filtered++;
+    return true;
+}
+
+void
+field_index_get_stats(const field_index_t *idx, field_index_stats_t *stats)
+{
+    memset(stats, 0, sizeof *stats);
+    if (idx == NULL)
+        return;
+
+    stats->num_fields = idx->columns->len;
+    stats->num_frames = idx->num_frames;
+    stats->num_values = idx->num_values;
+    stats->build_time = idx->build_time;
+    stats->frames_filtered = idx->frames_filtered;
+    stats->memory_used = sizeof *idx;
+    for (unsigned i = 0; i < idx->columns->len; i++) {
+        field_column_t *col = (field_column_t *)g_ptr_array_index(idx->columns, i);
+        stats->memory_used += sizeof *col;
+        stats->memory_used += col->offsets->len * sizeof(guint32);
+        stats->memory_used += col->values->len;
+        if (col->dict) {
+            stats->num_strings += col->dict_strings->len;
+            for (unsigned j = 0; j < col->dict_strings->len; j++) {
+                stats->memory_used += g_bytes_get_size((GBytes *)g_ptr_array_index(col->dict_strings, j));
+            }
+            stats->memory_used += col->dict_strings->len * 2 * sizeof(gpointer);
+        }
+    }
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,124 @@
+/* field_index.h
+ * Per-capture columnar index of selected field values, used to re-apply
+ * display filters without re-dissecting frames.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FIELD_INDEX_H__
+#define __FIELD_INDEX_H__
+
+#include <epan/epan_dissect.h>
+#include <epan/dfilter/dfilter.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @file
+ * The field index records the values of a user-selected set of fields
+ * for every frame during the first pass. Integer and address fields are
+ * stored in arrays sized for their field type, string fields are
+ * dictionary encoded, and protocols and FT_NONE fields only record how
+ * often they occur. A display filter that reads nothing but indexed
+ * fields can then be evaluated against the index instead of the protocol
+ * tree.
+ */
+
+typedef struct field_index field_index_t;
+
+typedef struct {
+    unsigned num_fields;        /**< Number of indexed fields */
+    uint32_t num_frames;        /**< Number of frames in the index */
+    uint64_t num_values;        /**< Number of recorded field occurrences */
+    unsigned num_strings;       /**< Number of distinct dictionary strings */
+    size_t   memory_used;       /**< Approximate memory used, in bytes */
+    int64_t  build_time;        /**< Time spent recording frames, in microseconds */
+    uint64_t frames_filtered;   /**< Frames filtered using the index */
+} field_index_stats_t;
+
+/**
+ * Create an index for a comma or whitespace separated list of field
+ * names. Fields whose type can't be indexed are rejected.
+ *
+ * @param fields The field names.
+ * @param err_msg Set to an error message (free with g_free) on failure.
+ * @return The new index, or NULL on failure or if "fields" is empty.
+ */
+WS_DLL_PUBLIC field_index_t *
+field_index_new(const char *fields, char **err_msg);
+
+/**
+ * Create an index for the fields listed in the "protocols.field_index"
+ * preference.
+ *
+ * @return The new index, or NULL if the preference is empty or invalid.
+ */
+WS_DLL_PUBLIC field_index_t *
+field_index_new_from_prefs(void);
+
+WS_DLL_PUBLIC void
+field_index_free(field_index_t *idx);
+
+/** Drop all recorded frames, e.g. before a redissection. */
+WS_DLL_PUBLIC void
+field_index_reset(field_index_t *idx);
+
+/** Make sure the indexed fields are present in the next dissection. */
+WS_DLL_PUBLIC void
+field_index_prime_edt(field_index_t *idx, epan_dissect_t *edt);
+
+/**
+ * Record the indexed fields of a dissected frame. Frames must be added in
+ * order starting with frame 1; out of sequence frames are not indexed.
+ */
+WS_DLL_PUBLIC void
+field_index_add_frame(field_index_t *idx, uint32_t framenum, proto_tree *tree);
+
+/** Returns the number of frames recorded so far. */
+WS_DLL_PUBLIC uint32_t
+field_index_num_frames(const field_index_t *idx);
+
+/** Returns true if every field read by "df" is in the index. */
+WS_DLL_PUBLIC bool
+field_index_can_filter(field_index_t *idx, const dfilter_t *df);
+
+/**
+ * Evaluate a display filter against the index.
+ *
+ * @param idx The index.
+ * @param df A filter for which field_index_can_filter() returned true.
+ * @param framenum The frame number.
+ * @param passed Set to the result of the filter.
+ * @return false if the frame isn't in the index, in which case the
+ * frame must be dissected.
+ */
+WS_DLL_PUBLIC bool
+field_index_filter_frame(field_index_t *idx, dfilter_t *df, uint32_t framenum,
+        bool *passed);
+
+WS_DLL_PUBLIC void
+field_index_get_stats(const field_index_t *idx, field_index_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FIELD_INDEX_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -30,10 +30,15 @@ struct register_follow {
     tap_packet_cb tap_handler; /* tap listener handler */
     follow_stream_count_func stream_count; /* maximum stream count, used for UI */
     follow_sub_stream_id_func sub_stream_id; /* sub-stream id, used for UI */
+    const char *stream_index_proto; /* protocol whose stream index is used, NULL for proto_id */
 };
 
 static wmem_tree_t *registered_followers = NULL;
 
+/* Frames of each stream, recorded on the first pass: protocol id ->
+   (stream -> wmem_array_t of frame numbers). */
+static wmem_map_t *stream_indexes = NULL;
+
 void register_follow_stream(const int proto_id, const char* tap_listener,
                             follow_conv_filter_func conv_filter, follow_index_filter_func index_filter, follow_address_filter_func address_filter,
                             follow_port_to_display_func port_to_display, tap_packet_cb tap_handler,
@@ -58,6 +63,7 @@ void register_follow_stream(const int proto_id, const char* tap_listener,
   follower->tap_handler    = tap_handler;
   follower->stream_count   = stream_count;
   follower->sub_stream_id  = sub_stream_id;
+  follower->stream_index_proto = NULL;
 
   if (registered_followers == NULL)
     registered_followers = wmem_tree_new(wmem_epan_scope());
@@ -65,6 +71,14 @@ void register_follow_stream(const int proto_id, const char* tap_listener,
   wmem_tree_insert_string(registered_followers, proto_get_protocol_short_name(find_protocol_by_id(proto_id)), follower, 0);
 }
 
+void set_follow_stream_index(const int proto_id, const char *index_proto_name)
+{
+  register_follow_t *follower = get_follow_by_proto_id(proto_id);
+  DISSECTOR_ASSERT(follower);
+
+  follower->stream_index_proto = index_proto_name;
+}
+
 int get_follow_proto_id(register_follow_t* follower)
 {
   if (follower == NULL)
@@ -143,6 +157,68 @@ gchar* follow_get_stat_tap_string(register_follow_t* follower)
     return g_string_free(cmd_str, FALSE);
 }
 
+void follow_stream_index_add_frame(packet_info *pinfo, const int proto_id, guint stream)
+{
+  wmem_map_t *streams;
+  wmem_array_t *frames;
+  guint num_frames;
+
+  if (PINFO_FD_VISITED(pinfo))
+    return;
+
+  if (stream_indexes == NULL)
+    stream_indexes = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), g_direct_hash, g_direct_equal);
+
+  streams = (wmem_map_t *)wmem_map_lookup(stream_indexes, GINT_TO_POINTER(proto_id));
+  if (streams == NULL) {
+    streams = wmem_map_new(wmem_file_scope(), g_direct_hash, g_direct_equal);
+    wmem_map_insert(stream_indexes, GINT_TO_POINTER(proto_id), streams);
+  }
+
+  frames = (wmem_array_t *)wmem_map_lookup(streams, GUINT_TO_POINTER(stream));
+  if (frames == NULL) {
+    frames = wmem_array_new(wmem_file_scope(), sizeof(guint32));
+    wmem_map_insert(streams, GUINT_TO_POINTER(stream), frames);
+  }
+
+  /* A frame can carry the same stream more than once, e.g. several
+     PDUs or a tunnel; it only needs to be listed once. */
+  num_frames = wmem_array_get_count(frames);
+  if (num_frames > 0 && *(guint32 *)wmem_array_index(frames, num_frames - 1) == pinfo->num)
+    return;
+
+  wmem_array_append_one(frames, pinfo->num);
+}
+
+const guint32 *follow_get_stream_frames(register_follow_t* follower, guint stream, guint *num_frames)
+{
+  wmem_map_t *streams;
+  wmem_array_t *frames;
+  int index_proto_id = follower->proto_id;
+
+  *num_frames = 0;
+
+  if (stream_indexes == NULL)
+    return NULL;
+
+  if (follower->stream_index_proto != NULL) {
+    index_proto_id = proto_get_id_by_filter_name(follower->stream_index_proto);
+    if (index_proto_id == -1)
+      return NULL;
+  }
+
+  streams = (wmem_map_t *)wmem_map_lookup(stream_indexes, GINT_TO_POINTER(index_proto_id));
+  if (streams == NULL)
+    return NULL;
+
+  frames = (wmem_array_t *)wmem_map_lookup(streams, GUINT_TO_POINTER(stream));
+  if (frames == NULL || wmem_array_get_count(frames) == 0)
+    return NULL;
+
+  *num_frames = wmem_array_get_count(frames);
+  return (const guint32 *)wmem_array_get_raw(frames);
+}
+
 /* here we are going to try and reconstruct the data portion of a TCP
    session. We will try and handle duplicates, TCP fragments, and out
    of order packets in a smart way. */
@@ -88,6 +88,16 @@ void register_follow_stream(const int proto_id, const char* tap_listener,
                             follow_port_to_display_func port_to_display, tap_packet_cb tap_handler,
                             follow_stream_count_func stream_count, follow_sub_stream_id_func sub_stream_id);
 
+/** Use another protocol's stream index for a follower.
+ * By default a follower's streams are numbered by its own protocol; followers
+ * layered on another protocol's streams, e.g. HTTP over TCP, use that
+ * protocol's index instead.
+ *
+ * @param proto_id Protocol Id of the registered follower
+ * @param index_proto_name Filter name of the protocol that numbers the streams
+ */
+WS_DLL_PUBLIC void set_follow_stream_index(const int proto_id, const char *index_proto_name);
+
 /** Get protocol ID from registered follower
  *
  * @param follower Registered follower
@@ -193,6 +203,30 @@ WS_DLL_PUBLIC void follow_iterate_followers(wmem_foreach_func func, gpointer use
  */
 WS_DLL_PUBLIC gchar* follow_get_stat_tap_string(register_follow_t* follower);
 
+/** Record that the current frame is part of a stream.
+ * Dissectors that number their streams call this for every frame, so
+ * following a stream later only has to dissect the stream's frames. Only
+ * the first pass is recorded; the index is discarded with the file.
+ *
+ * @param pinfo [in] Packet info of the current frame
+ * @param proto_id [in] Protocol that numbers the streams
+ * @param stream [in] Stream index of the frame
+ */
+WS_DLL_PUBLIC void follow_stream_index_add_frame(packet_info *pinfo, const int proto_id, guint stream);
+
+/** Get the frames that are part of a stream, in ascending order.
+ * Substreams, e.g. HTTP/2 streams, aren't indexed separately; the frames
+ * of the stream that carries them are returned.
+ *
+ * @param follower [in] Registered follower
+ * @param stream [in] Stream index
+ * @param num_frames [out] Number of frames returned
+ * @return The frame numbers, or NULL if the follower's streams aren't indexed
+ * or the stream has no frames. The array is valid until the file is closed
+ * or redissected.
+ */
+WS_DLL_PUBLIC const guint32 *follow_get_stream_frames(register_follow_t* follower, guint stream, guint *num_frames);
+
 /** Clear counters, addresses and ports of follow_info_t
  *
  * @param info [in] follower info
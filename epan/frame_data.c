@@ -310,10 +310,8 @@ frame_data_reset(frame_data *fdata)
   fdata->visited = 0;
   fdata->subnum = 0;
 
-  if (fdata->pfd) {
-    g_slist_free(fdata->pfd);
-    fdata->pfd = NULL;
-  }
+  /* The proto data is allocated from the file scope. */
+  fdata->pfd = NULL;
 
   if (fdata->dependent_frames) {
     g_hash_table_destroy(fdata->dependent_frames);
@@ -324,10 +322,8 @@ frame_data_reset(frame_data *fdata)
 void
 frame_data_destroy(frame_data *fdata)
 {
-  if (fdata->pfd) {
-    g_slist_free(fdata->pfd);
-    fdata->pfd = NULL;
-  }
+  /* The proto data is allocated from the file scope. */
+  fdata->pfd = NULL;
 
   if (fdata->dependent_frames) {
     g_hash_table_destroy(fdata->dependent_frames);
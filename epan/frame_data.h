@@ -59,6 +59,7 @@ typedef enum {
    fields within the first 16 or 32 bytes, so they all fit in a cache
    line? */
 struct _color_filter; /* Forward */
+struct _proto_data_list; /* Forward */
 DIAG_OFF_PEDANTIC
 typedef struct _frame_data {
   guint32      num;          /**< Frame number */
@@ -69,7 +70,7 @@ typedef struct _frame_data {
   /* These two are pointers, meaning 64-bit on LP64 (64-bit UN*X) and
      LLP64 (64-bit Windows) platforms.  Put them here, one after the
      other, so they don't require padding between them. */
-  GSList      *pfd;          /**< Per frame proto data */
+  struct _proto_data_list *pfd; /**< Per frame proto data */
   GHashTable  *dependent_frames;     /**< A hash table of frames which this one depends on */
   const struct _color_filter *color_filter;  /**< Per-packet matching color_filter_t object */
   guint16      subnum;       /**< subframe number, for protocols that require this */
@@ -402,19 +402,19 @@ static char *
 abs_time_to_ftrepr_dfilter(wmem_allocator_t *scope,
 			const nstime_t *nstime, bool use_utc)
 {
-	struct tm *tm;
+	struct tm tm_buf, *tm;
 	char datetime_format[128];
 	char nsecs_buf[32];
 
 	if (use_utc) {
-		tm = gmtime(&nstime->secs);
+		tm = ws_gmtime_r(&nstime->secs, &tm_buf);
 		if (tm != NULL)
 			strftime(datetime_format, sizeof(datetime_format), "\"%Y-%m-%d %H:%M:%S%%sZ\"", tm);
 		else
 			snprintf(datetime_format, sizeof(datetime_format), "Not representable");
 	}
 	else {
-		tm = localtime(&nstime->secs);
+		tm = ws_localtime_r(&nstime->secs, &tm_buf);
 		/* Displaying the timezone could be made into a preference. */
 		if (tm != NULL)
 			strftime(datetime_format, sizeof(datetime_format), "\"%Y-%m-%d %H:%M:%S%%s%z\"", tm);
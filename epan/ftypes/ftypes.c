@@ -1030,6 +1030,14 @@ fvalue_get_ipv6(fvalue_t *fv)
 	return fv->ftype->get_value.get_value_ipv6(fv);
 }
 
+/* Unlike fvalue_get_uinteger(), this includes the netmask. */
+const ipv4_addr_and_mask *
+fvalue_get_ipv4(fvalue_t *fv)
+{
+	ws_assert(fv->ftype->ftype == FT_IPv4);
+	return &fv->value.ipv4;
+}
+
 ft_bool_t
 fvalue_eq(const fvalue_t *a, const fvalue_t *b)
 {
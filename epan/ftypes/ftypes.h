@@ -456,6 +456,9 @@ fvalue_get_floating(fvalue_t *fv);
 WS_DLL_PUBLIC const ipv6_addr_and_prefix *
 fvalue_get_ipv6(fvalue_t *fv);
 
+WS_DLL_PUBLIC const ipv4_addr_and_mask *
+fvalue_get_ipv4(fvalue_t *fv);
+
 ft_bool_t
 fvalue_eq(const fvalue_t *a, const fvalue_t *b);
 
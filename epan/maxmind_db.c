@@ -32,6 +32,7 @@ static mmdb_lookup_t mmdb_not_found;
 #include <epan/wmem_scopes.h>
 
 #include <epan/addr_resolv.h>
+#include <epan/mmdb_reader.h>
 #include <epan/uat.h>
 #include <epan/prefs.h>
 
@@ -83,6 +84,27 @@ static wmem_map_t *mmdb_ipv6_chunk;
 /* Child mmdbresolve process */
 static ws_pipe_t mmdbr_pipe; // Requires mutex
 
+/*
+ * In-process readers, one per database. If every database can be
+ * mapped, lookups are made directly and no mmdbresolve process is
+ * started.
+ */
+static GPtrArray *mmdb_readers; // mmdb_reader_t *
+
+// Results shared by the addresses that map to the same records, keyed
+// by an array holding each database's record (or MMDB_NO_RECORD).
+static GHashTable *mmdb_record_map;
+#define MMDB_NO_RECORD G_MAXUINT32
+
+static const char *co_iso_key[]     = {"country", "iso_code", NULL};
+static const char *co_name_key[]    = {"country", "names", "en", NULL};
+static const char *ci_name_key[]    = {"city", "names", "en", NULL};
+static const char *asn_o_key[]      = {"autonomous_system_organization", NULL};
+static const char *asn_key[]        = {"autonomous_system_number", NULL};
+static const char *l_lat_key[]      = {"location", "latitude", NULL};
+static const char *l_lon_key[]      = {"location", "longitude", NULL};
+static const char *l_accuracy_key[] = {"location", "accuracy_radius", NULL};
+
 /* UAT definitions. Copied from oids.c */
 typedef struct _maxmind_db_path_t {
     char* path;
@@ -109,6 +131,7 @@ static GPtrArray *mmdb_file_arr; // .mmdb files
 static gboolean resolve_synchronously = FALSE;
 
 static void mmdb_resolve_stop(void);
+static void mmdb_readers_close(void);
 
 // Hopefully scanning a few lines asynchronously has less overhead than
 // reading in a child thread.
@@ -372,6 +395,8 @@ static void mmdb_resolve_stop(void) {
     char *request;
     mmdb_response_t *response;
 
+    mmdb_readers_close();
+
     while (mmdbr_request_q && (request = (char *) g_async_queue_try_pop(mmdbr_request_q)) != NULL) {
         g_free(request);
     }
@@ -444,6 +469,155 @@ static void mmdb_resolve_stop(void) {
     }
 }
 
+static guint mmdb_records_hash(gconstpointer key) {
+    const guint32 *records = (const guint32 *) key;
+    guint hash = 0;
+
+    for (guint i = 0; i < mmdb_readers->len; i++) {
+        hash = hash * 31 + records[i];
+    }
+    return hash;
+}
+
+static gboolean mmdb_records_equal(gconstpointer a, gconstpointer b) {
+    return memcmp(a, b, mmdb_readers->len * sizeof(guint32)) == 0;
+}
+
+static void mmdb_readers_close(void) {
+    if (mmdb_record_map) {
+        g_hash_table_destroy(mmdb_record_map);
+        mmdb_record_map = NULL;
+    }
+    if (mmdb_readers) {
+        g_ptr_array_free(mmdb_readers, TRUE);
+        mmdb_readers = NULL;
+    }
+}
+
+/**
+ * Map every database for in-process lookups. Returns FALSE, leaving
+ * nothing open, if one of them can't be read.
+ */
+static gboolean mmdb_readers_open(void) {
+    GPtrArray *readers = g_ptr_array_new_with_free_func((GDestroyNotify) mmdb_reader_close);
+
+    for (guint i = 0; i < mmdb_file_arr->len; i++) {
+        const char *path = (const char *) g_ptr_array_index(mmdb_file_arr, i);
+        char *err_msg = NULL;
+        mmdb_reader_t *reader = mmdb_reader_open(path, &err_msg);
+
+        if (!reader) {
+            ws_debug("can't read %s in-process (%s), using mmdbresolve", path, err_msg);
+            g_free(err_msg);
+            g_ptr_array_free(readers, TRUE);
+            return FALSE;
+        }
+        g_ptr_array_add(readers, reader);
+    }
+
+    mmdb_readers = readers;
+    mmdb_record_map = g_hash_table_new_full(mmdb_records_hash, mmdb_records_equal, g_free, NULL);
+    return TRUE;
+}
+
+static const char *mmdb_value_string(const mmdb_reader_value_t *value) {
+    char *str = g_strndup((const char *) value->bytes, value->size);
+    const char *chunk = chunkify_string(str);
+
+    g_free(str);
+    return chunk;
+}
+
+static void mmdb_fill_lookup(const mmdb_reader_t *reader, guint32 record, mmdb_lookup_t *lookup) {
+    mmdb_reader_value_t value;
+
+    // Later databases override earlier ones, as with mmdbresolve.
+    if (mmdb_reader_get_value(reader, record, co_iso_key, &value) && value.type == MMDB_READER_TYPE_UTF8_STRING) {
+        lookup->found = TRUE;
+        lookup->country_iso = mmdb_value_string(&value);
+    }
+    if (mmdb_reader_get_value(reader, record, co_name_key, &value) && value.type == MMDB_READER_TYPE_UTF8_STRING) {
+        lookup->found = TRUE;
+        lookup->country = mmdb_value_string(&value);
+    }
+    if (mmdb_reader_get_value(reader, record, ci_name_key, &value) && value.type == MMDB_READER_TYPE_UTF8_STRING) {
+        lookup->found = TRUE;
+        lookup->city = mmdb_value_string(&value);
+    }
+    if (mmdb_reader_get_value(reader, record, asn_o_key, &value) && value.type == MMDB_READER_TYPE_UTF8_STRING) {
+        lookup->found = TRUE;
+        lookup->as_org = mmdb_value_string(&value);
+    }
+    if (mmdb_reader_get_value(reader, record, asn_key, &value) && value.type == MMDB_READER_TYPE_UINT &&
+            value.uint_value <= G_MAXUINT32) {
+        lookup->found = TRUE;
+        lookup->as_number = (guint32) value.uint_value;
+    }
+    if (mmdb_reader_get_value(reader, record, l_lat_key, &value) &&
+            (value.type == MMDB_READER_TYPE_DOUBLE || value.type == MMDB_READER_TYPE_FLOAT)) {
+        lookup->found = TRUE;
+        lookup->latitude = value.double_value;
+    }
+    if (mmdb_reader_get_value(reader, record, l_lon_key, &value) &&
+            (value.type == MMDB_READER_TYPE_DOUBLE || value.type == MMDB_READER_TYPE_FLOAT)) {
+        lookup->found = TRUE;
+        lookup->longitude = value.double_value;
+    }
+    if (mmdb_reader_get_value(reader, record, l_accuracy_key, &value) && value.type == MMDB_READER_TYPE_UINT &&
+            value.uint_value <= G_MAXUINT16) {
+        lookup->found = TRUE;
+        lookup->accuracy = (guint16) value.uint_value;
+    }
+}
+
+/**
+ * Look an address up in every mapped database. Either addr4 or addr6
+ * is set. Lookups are answered right away, so unlike with mmdbresolve
+ * the first pass already sees every result.
+ */
+static mmdb_lookup_t *mmdb_readers_lookup(const ws_in4_addr *addr4, const ws_in6_addr *addr6) {
+    guint32 *records = g_newa(guint32, mmdb_readers->len);
+    gboolean any_found = FALSE;
+    mmdb_lookup_t *lookup;
+
+    for (guint i = 0; i < mmdb_readers->len; i++) {
+        const mmdb_reader_t *reader = (const mmdb_reader_t *) g_ptr_array_index(mmdb_readers, i);
+        gboolean found = addr4 ? mmdb_reader_lookup_ipv4(reader, addr4, &records[i]) :
+                                 mmdb_reader_lookup_ipv6(reader, addr6, &records[i]);
+        if (found) {
+            any_found = TRUE;
+        } else {
+            records[i] = MMDB_NO_RECORD;
+        }
+    }
+
+    if (!any_found) {
+        return &mmdb_not_found;
+    }
+
+    lookup = (mmdb_lookup_t *) g_hash_table_lookup(mmdb_record_map, records);
+    if (lookup) {
+        return lookup;
+    }
+
+    lookup = wmem_new(wmem_epan_scope(), mmdb_lookup_t);
+    init_lookup(lookup);
+    for (guint i = 0; i < mmdb_readers->len; i++) {
+        if (records[i] != MMDB_NO_RECORD) {
+            mmdb_fill_lookup((const mmdb_reader_t *) g_ptr_array_index(mmdb_readers, i), records[i], lookup);
+        }
+    }
+    if (!lookup->found) {
+        lookup = &mmdb_not_found;
+    }
+    g_hash_table_insert(mmdb_record_map, g_memdup2(records, mmdb_readers->len * sizeof(guint32)), lookup);
+    return lookup;
+}
+
+static gboolean mmdb_resolve_active(void) {
+    return mmdb_readers != NULL || mmdbr_pipe_valid();
+}
+
 /**
  * Start an mmdbresolve process.
  */
@@ -484,6 +658,10 @@ static void mmdb_resolve_start(void) {
         return;
     }
 
+    if (mmdb_readers_open()) {
+        return;
+    }
+
     GPtrArray *args = g_ptr_array_new();
     char *mmdbresolve = get_executable_path("mmdbresolve");
     g_ptr_array_add(args, mmdbresolve);
@@ -649,11 +827,11 @@ void maxmind_db_pref_cleanup(void)
 void maxmind_db_pref_apply(void)
 {
     if (gbl_resolv_flags.maxmind_geoip) {
-        if (!mmdbr_pipe_valid()) {
+        if (!mmdb_resolve_active()) {
             mmdb_resolve_start();
         }
     } else {
-        if (mmdbr_pipe_valid()) {
+        if (mmdb_resolve_active()) {
             mmdb_resolve_stop();
         }
     }
@@ -735,7 +913,10 @@ maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
 
     mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
 
-    if (!result) {
+    if (!result && mmdb_readers) {
+        result = mmdb_readers_lookup(addr, NULL);
+        wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
+    } else if (!result) {
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
 
@@ -762,7 +943,10 @@ maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
 
     mmdb_lookup_t * result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
 
-    if (!result) {
+    if (!result && mmdb_readers) {
+        result = mmdb_readers_lookup(NULL, addr);
+        wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
+    } else if (!result) {
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
 
@@ -0,0 +1,586 @@
+/* mmdb_reader.c
+ * In-process reader for MaxMind DB (.mmdb) files
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#define WS_LOG_DOMAIN  LOG_DOMAIN_MMDB
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/mmdb_reader.h>
+
+#include <wsutil/pint.h>
+#include <wsutil/wslog.h>
+
+/*
+ * A MaxMind DB file is a binary search tree over the address bits,
+ * followed by 16 zero bytes, a data section holding the records the
+ * tree points to, and a metadata map following a marker at the end of
+ * the file.
+ */
+static const guint8 mmdb_metadata_marker[] = "\xAB\xCD\xEFMaxMind.com";
+#define MMDB_METADATA_MARKER_LEN    (sizeof mmdb_metadata_marker - 1)
+#define MMDB_METADATA_MAX_SIZE      (128 * 1024)
+#define MMDB_DATA_SECTION_SEPARATOR 16
+
+/* Bound nesting so that a corrupt file can't exhaust the stack. */
+#define MMDB_MAX_DEPTH              32
+
+/* Data field types, as encoded in the control byte. */
+enum {
+    MMDB_TYPE_EXTENDED = 0,
+    MMDB_TYPE_POINTER = 1,
+    MMDB_TYPE_UTF8_STRING = 2,
+    MMDB_TYPE_DOUBLE = 3,
+    MMDB_TYPE_BYTES = 4,
+    MMDB_TYPE_UINT16 = 5,
+    MMDB_TYPE_UINT32 = 6,
+    MMDB_TYPE_MAP = 7,
+    MMDB_TYPE_INT32 = 8,
+    MMDB_TYPE_UINT64 = 9,
+    MMDB_TYPE_UINT128 = 10,
+    MMDB_TYPE_ARRAY = 11,
+    MMDB_TYPE_CONTAINER = 12,
+    MMDB_TYPE_END_MARKER = 13,
+    MMDB_TYPE_BOOLEAN = 14,
+    MMDB_TYPE_FLOAT = 15
+};
+
+/* Pointers in the data section and in the metadata are relative to the
+ * start of their own section. */
+typedef struct {
+    const guint8 *base;
+    guint32 len;
+} mmdb_section_t;
+
+struct _mmdb_reader_t {
+    GMappedFile *mapped;
+    const guint8 *tree;
+    guint32 node_count;
+    guint record_size;          /* Bits per record: 24, 28 or 32 */
+    guint node_size;            /* Bytes per node */
+    guint ip_version;
+    guint32 ipv4_start_node;    /* Node for ::/96 in an IPv6 tree */
+    mmdb_section_t data;
+    char *database_type;
+};
+
+static guint64
+mmdb_read_uint(const guint8 *p, guint32 size)
+{
+    guint64 value = 0;
+    guint32 i;
+
+    for (i = 0; i < size; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static double
+mmdb_read_double(const guint8 *p)
+{
+    union { guint64 u; double d; } value;
+
+    value.u = pntoh64(p);
+    return value.d;
+}
+
+static double
+mmdb_read_float(const guint8 *p)
+{
+    union { guint32 u; float f; } value;
+
+    value.u = pntoh32(p);
+    return value.f;
+}
+
+/*
+ * Decode the control byte(s) at offset. For pointers, *size is the
+ * pointer's target. *payload is set to the offset following the
+ * control bytes.
+ */
+static gboolean
+mmdb_decode_ctrl(const mmdb_section_t *sec, guint32 offset, guint *type,
+        guint32 *size, guint32 *payload)
+{
+    const guint8 *p;
+    guint8 ctrl;
+    guint32 extra;
+
+    if (offset >= sec->len) {
+        return FALSE;
+    }
+    p = sec->base + offset;
+    ctrl = *p++;
+    offset++;
+    *type = ctrl >> 5;
+
+    if (*type == MMDB_TYPE_POINTER) {
+        guint ptr_size = ((ctrl >> 3) & 0x3) + 1;
+        guint32 value = ctrl & 0x7;
+
+        if (offset + ptr_size > sec->len) {
+            return FALSE;
+        }
+        switch (ptr_size) {
+            case 1:
+                value = (value << 8) | p[0];
+                break;
+            case 2:
+                value = ((value << 16) | pntoh16(p)) + 2048;
+                break;
+            case 3:
+                value = ((value << 24) | pntoh24(p)) + 526336;
+                break;
+            default:
+                value = pntoh32(p);
+                break;
+        }
+        *size = value;
+        *payload = offset + ptr_size;
+        return TRUE;
+    }
+
+    if (*type == MMDB_TYPE_EXTENDED) {
+        if (offset >= sec->len) {
+            return FALSE;
+        }
+        *type = 7 + *p++;
+        offset++;
+        if (*type <= MMDB_TYPE_MAP || *type > MMDB_TYPE_FLOAT) {
+            return FALSE;
+        }
+    }
+
+    *size = ctrl & 0x1f;
+    if (*size >= 29) {
+        extra = *size - 28;
+        if (offset + extra > sec->len) {
+            return FALSE;
+        }
+        switch (extra) {
+            case 1:
+                *size = 29 + p[0];
+                break;
+            case 2:
+                *size = 285 + pntoh16(p);
+                break;
+            default:
+                *size = 65821 + pntoh24(p);
+                break;
+        }
+        offset += extra;
+    }
+    *payload = offset;
+    return TRUE;
+}
+
+/*
+ * Decode the value at offset, following a pointer if there is one.
+ * *next is set to the offset of the following value; for maps and
+ * arrays, that's their first entry.
+ */
+static gboolean
+mmdb_decode_value(const mmdb_section_t *sec, guint32 offset,
+        mmdb_reader_value_t *value, guint32 *next)
+{
+    guint type;
+    guint32 size, payload, after;
+    gboolean followed = FALSE;
+
+    if (!mmdb_decode_ctrl(sec, offset, &type, &size, &payload)) {
+        return FALSE;
+    }
+    after = payload;
+    if (type == MMDB_TYPE_POINTER) {
+        /* Pointers can't point to pointers. */
+        if (!mmdb_decode_ctrl(sec, size, &type, &size, &payload) ||
+                type == MMDB_TYPE_POINTER) {
+            return FALSE;
+        }
+        followed = TRUE;
+    }
+
+    memset(value, 0, sizeof(*value));
+    value->size = size;
+    switch (type) {
+        case MMDB_TYPE_MAP:
+            value->type = MMDB_READER_TYPE_MAP;
+            break;
+        case MMDB_TYPE_ARRAY:
+            value->type = MMDB_READER_TYPE_ARRAY;
+            break;
+        case MMDB_TYPE_BOOLEAN:
+            if (size > 1) {
+                return FALSE;
+            }
+            value->type = MMDB_READER_TYPE_BOOLEAN;
+            value->boolean = size != 0;
+            value->size = 0;
+            break;
+        default:
+            if (payload + size > sec->len || payload + size < payload) {
+                return FALSE;
+            }
+            switch (type) {
+                case MMDB_TYPE_UTF8_STRING:
+                    value->type = MMDB_READER_TYPE_UTF8_STRING;
+                    value->bytes = sec->base + payload;
+                    break;
+                case MMDB_TYPE_BYTES:
+                    value->type = MMDB_READER_TYPE_BYTES;
+                    value->bytes = sec->base + payload;
+                    break;
+                case MMDB_TYPE_DOUBLE:
+                    if (size != 8) {
+                        return FALSE;
+                    }
+                    value->type = MMDB_READER_TYPE_DOUBLE;
+                    value->double_value = mmdb_read_double(sec->base + payload);
+                    break;
+                case MMDB_TYPE_FLOAT:
+                    if (size != 4) {
+                        return FALSE;
+                    }
+                    value->type = MMDB_READER_TYPE_FLOAT;
+                    value->double_value = mmdb_read_float(sec->base + payload);
+                    break;
+                case MMDB_TYPE_UINT16:
+                case MMDB_TYPE_UINT32:
+                case MMDB_TYPE_UINT64:
+                case MMDB_TYPE_UINT128:
+                    if (size > (type == MMDB_TYPE_UINT16 ? 2u : type == MMDB_TYPE_UINT32 ? 4u :
+                                type == MMDB_TYPE_UINT64 ? 8u : 16u)) {
+                        return FALSE;
+                    }
+                    value->type = MMDB_READER_TYPE_UINT;
+                    if (size > 8) {
+                        value->uint_value = mmdb_read_uint(sec->base + payload + size - 8, 8);
+                    } else {
+                        value->uint_value = mmdb_read_uint(sec->base + payload, size);
+                    }
+                    break;
+                case MMDB_TYPE_INT32:
+                    if (size > 4) {
+                        return FALSE;
+                    }
+                    value->type = MMDB_READER_TYPE_INT32;
+                    value->int_value = (gint32)(guint32)mmdb_read_uint(sec->base + payload, size);
+                    break;
+                default:
+                    /* Data cache containers and end markers don't appear in records. */
+                    return FALSE;
+            }
+            payload += size;
+            break;
+    }
+
+    if (next) {
+        if (type == MMDB_TYPE_MAP || type == MMDB_TYPE_ARRAY) {
+            *next = payload;
+        } else {
+            /* After a pointer, carry on after the pointer itself. */
+            *next = followed ? after : payload;
+        }
+    }
+    return TRUE;
+}
+
+/* Set *next to the offset following the value at offset. */
+static gboolean
+mmdb_skip_value(const mmdb_section_t *sec, guint32 offset, guint32 *next, guint depth)
+{
+    guint type;
+    guint32 size, payload, i, count;
+
+    if (depth > MMDB_MAX_DEPTH || !mmdb_decode_ctrl(sec, offset, &type, &size, &payload)) {
+        return FALSE;
+    }
+
+    switch (type) {
+        case MMDB_TYPE_POINTER:
+        case MMDB_TYPE_BOOLEAN:
+            *next = payload;
+            return TRUE;
+        case MMDB_TYPE_MAP:
+        case MMDB_TYPE_ARRAY:
+            count = type == MMDB_TYPE_MAP ? size * 2 : size;
+            for (i = 0; i < count; i++) {
+                if (!mmdb_skip_value(sec, payload, &payload, depth + 1)) {
+                    return FALSE;
+                }
+            }
+            *next = payload;
+            return TRUE;
+        default:
+            if (payload + size > sec->len || payload + size < payload) {
+                return FALSE;
+            }
+            *next = payload + size;
+            return TRUE;
+    }
+}
+
+/* Follow a path of map keys from the value at offset. */
+static gboolean
+mmdb_get_path(const mmdb_section_t *sec, guint32 offset, const char * const *path,
+        mmdb_reader_value_t *value)
+{
+    mmdb_reader_value_t key;
+    guint32 entry, i;
+    size_t key_len;
+    gboolean found;
+
+    for (; *path != NULL; path++) {
+        if (!mmdb_decode_value(sec, offset, value, &entry) ||
+                value->type != MMDB_READER_TYPE_MAP) {
+            return FALSE;
+        }
+        key_len = strlen(*path);
+        found = FALSE;
+        for (i = 0; i < value->size; i++) {
+            if (!mmdb_decode_value(sec, entry, &key, &entry) ||
+                    key.type != MMDB_READER_TYPE_UTF8_STRING) {
+                return FALSE;
+            }
+            if (key.size == key_len && memcmp(key.bytes, *path, key_len) == 0) {
+                offset = entry;
+                found = TRUE;
+                break;
+            }
+            if (!mmdb_skip_value(sec, entry, &entry, 0)) {
+                return FALSE;
+            }
+        }
+        if (!found) {
+            return FALSE;
+        }
+    }
+
+    return mmdb_decode_value(sec, offset, value, NULL);
+}
+
+static inline guint32
+mmdb_read_record(const mmdb_reader_t *reader, guint32 node, guint bit)
+{
+    const guint8 *p = reader->tree + (gsize)node * reader->node_size;
+
+    switch (reader->record_size) {
+        case 24:
+            return pntoh24(p + bit * 3);
+        case 28:
+            if (bit) {
+                return ((guint32)(p[3] & 0x0F) << 24) | pntoh24(p + 4);
+            }
+            return ((guint32)(p[3] & 0xF0) << 20) | pntoh24(p);
+        default:
+            return pntoh32(p + bit * 4);
+    }
+}
+
+/*
+ * Walk the tree from node, consuming address bits from depth on. This
+ * only reads the mapped file, so concurrent lookups need no locking.
+ */
+static gboolean
+mmdb_walk(const mmdb_reader_t *reader, const guint8 *addr, guint bits,
+        guint32 node, guint depth, guint32 *record)
+{
+    for (; depth < bits && node < reader->node_count; depth++) {
+        node = mmdb_read_record(reader, node, (addr[depth >> 3] >> (7 - (depth & 7))) & 1);
+    }
+
+    if (node <= reader->node_count) {
+        /* No data, or a malformed tree deeper than the address. */
+        return FALSE;
+    }
+
+    node -= reader->node_count + MMDB_DATA_SECTION_SEPARATOR;
+    if (node >= reader->data.len) {
+        return FALSE;
+    }
+    *record = node;
+    return TRUE;
+}
+
+static gboolean
+mmdb_get_metadata_uint(const mmdb_section_t *meta, const char *key, guint64 *value)
+{
+    const char *path[] = { key, NULL };
+    mmdb_reader_value_t val;
+
+    if (!mmdb_get_path(meta, 0, path, &val) || val.type != MMDB_READER_TYPE_UINT) {
+        return FALSE;
+    }
+    *value = val.uint_value;
+    return TRUE;
+}
+
+mmdb_reader_t *
+mmdb_reader_open(const char *path, char **err_msg)
+{
+    GError *err = NULL;
+    GMappedFile *mapped;
+    const guint8 *file, *marker = NULL, *p;
+    gsize file_len, search_len, tree_size;
+    mmdb_section_t meta;
+    mmdb_reader_value_t val;
+    guint64 node_count, record_size, ip_version, major_version;
+    static const char *db_type_path[] = { "database_type", NULL };
+    mmdb_reader_t *reader;
+
+    mapped = g_mapped_file_new(path, FALSE, &err);
+    if (!mapped) {
+        *err_msg = g_strdup(err->message);
+        g_error_free(err);
+        return NULL;
+    }
+    file = (const guint8 *)g_mapped_file_get_contents(mapped);
+    file_len = g_mapped_file_get_length(mapped);
+    if (file_len < MMDB_METADATA_MARKER_LEN || file_len > G_MAXUINT32) {
+        *err_msg = g_strdup("not a MaxMind DB file");
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    /* The metadata marker is in the last 128 KiB; use the last one. */
+    search_len = MIN(file_len, MMDB_METADATA_MAX_SIZE);
+    for (p = file + file_len - search_len; p + MMDB_METADATA_MARKER_LEN <= file + file_len; p++) {
+        if (*p == mmdb_metadata_marker[0] &&
+                memcmp(p, mmdb_metadata_marker, MMDB_METADATA_MARKER_LEN) == 0) {
+            marker = p;
+        }
+    }
+    if (!marker) {
+        *err_msg = g_strdup("not a MaxMind DB file");
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    meta.base = marker + MMDB_METADATA_MARKER_LEN;
+    meta.len = (guint32)(file + file_len - meta.base);
+    if (!mmdb_get_metadata_uint(&meta, "binary_format_major_version", &major_version) ||
+            major_version != 2 ||
+            !mmdb_get_metadata_uint(&meta, "node_count", &node_count) ||
+            !mmdb_get_metadata_uint(&meta, "record_size", &record_size) ||
+            !mmdb_get_metadata_uint(&meta, "ip_version", &ip_version)) {
+        *err_msg = g_strdup("unsupported or invalid metadata");
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    if ((record_size != 24 && record_size != 28 && record_size != 32) ||
+            (ip_version != 4 && ip_version != 6) || node_count > G_MAXUINT32) {
+        *err_msg = g_strdup("unsupported record size or IP version");
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    tree_size = (gsize)node_count * (gsize)(record_size / 4);
+    if (tree_size + MMDB_DATA_SECTION_SEPARATOR > (gsize)(marker - file)) {
+        *err_msg = g_strdup("search tree is larger than the file");
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    reader = g_new0(mmdb_reader_t, 1);
+    reader->mapped = mapped;
+    reader->tree = file;
+    reader->node_count = (guint32)node_count;
+    reader->record_size = (guint)record_size;
+    reader->node_size = (guint)record_size / 4;
+    reader->ip_version = (guint)ip_version;
+    reader->data.base = file + tree_size + MMDB_DATA_SECTION_SEPARATOR;
+    reader->data.len = (guint32)(marker - reader->data.base);
+
+    if (mmdb_get_path(&meta, 0, db_type_path, &val) && val.type == MMDB_READER_TYPE_UTF8_STRING) {
+        reader->database_type = g_strndup((const char *)val.bytes, val.size);
+    } else {
+        reader->database_type = g_strdup("");
+    }
+
+    /* IPv4 addresses live under ::/96 in IPv6 trees. */
+    if (reader->ip_version == 6) {
+        guint32 node = 0;
+        guint depth;
+
+        for (depth = 0; depth < 96 && node < reader->node_count; depth++) {
+            node = mmdb_read_record(reader, node, 0);
+        }
+        reader->ipv4_start_node = node;
+    }
+
+    ws_debug("opened %s: %s, %u nodes, %u-bit records, IPv%u", path,
+            reader->database_type, reader->node_count, reader->record_size, reader->ip_version);
+    return reader;
+}
+
+void
+mmdb_reader_close(mmdb_reader_t *reader)
+{
+    if (!reader) {
+        return;
+    }
+    g_mapped_file_unref(reader->mapped);
+    g_free(reader->database_type);
+    g_free(reader);
+}
+
+const char *
+mmdb_reader_get_database_type(const mmdb_reader_t *reader)
+{
+    return reader->database_type;
+}
+
+gboolean
+mmdb_reader_lookup_ipv4(const mmdb_reader_t *reader, const ws_in4_addr *addr, guint32 *record)
+{
+    guint8 addr_bytes[4];
+
+    memcpy(addr_bytes, addr, sizeof addr_bytes);
+    if (reader->ip_version == 4) {
+        return mmdb_walk(reader, addr_bytes, 32, 0, 0, record);
+    }
+
+    /* If ::/96 maps to a single record, the walk ends right away. */
+    return mmdb_walk(reader, addr_bytes, 32, reader->ipv4_start_node, 0, record);
+}
+
+gboolean
+mmdb_reader_lookup_ipv6(const mmdb_reader_t *reader, const ws_in6_addr *addr, guint32 *record)
+{
+    if (reader->ip_version == 4) {
+        return FALSE;
+    }
+    return mmdb_walk(reader, addr->bytes, 128, 0, 0, record);
+}
+
+gboolean
+mmdb_reader_get_value(const mmdb_reader_t *reader, guint32 record,
+        const char * const *path, mmdb_reader_value_t *value)
+{
+    return mmdb_get_path(&reader->data, record, path, value);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,112 @@
+/** @file
+ *
+ * In-process reader for MaxMind DB (.mmdb) files
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __MMDB_READER_H__
+#define __MMDB_READER_H__
+
+#include <glib.h>
+
+#include <wsutil/inet_ipv4.h>
+#include <wsutil/inet_ipv6.h>
+#include "ws_symbol_export.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*
+ * The database file is mapped into memory and never modified, so any
+ * number of threads can look up addresses in the same reader.
+ *
+ * See https://maxmind.github.io/MaxMind-DB/ for the file format.
+ */
+typedef struct _mmdb_reader_t mmdb_reader_t;
+
+typedef enum {
+    MMDB_READER_TYPE_NONE,
+    MMDB_READER_TYPE_UTF8_STRING,
+    MMDB_READER_TYPE_DOUBLE,
+    MMDB_READER_TYPE_BYTES,
+    MMDB_READER_TYPE_UINT,      /* uint16, uint32, uint64 and the low 64 bits of uint128 */
+    MMDB_READER_TYPE_INT32,
+    MMDB_READER_TYPE_MAP,
+    MMDB_READER_TYPE_ARRAY,
+    MMDB_READER_TYPE_BOOLEAN,
+    MMDB_READER_TYPE_FLOAT
+} mmdb_reader_type_e;
+
+typedef struct _mmdb_reader_value_t {
+    mmdb_reader_type_e type;
+    guint32 size;               /* Bytes for strings, entries for maps and arrays */
+    const guint8 *bytes;        /* Strings and byte arrays; not NUL terminated */
+    guint64 uint_value;
+    gint32 int_value;
+    double double_value;        /* Doubles and floats */
+    gboolean boolean;
+} mmdb_reader_value_t;
+
+/** Map a database and check its metadata.
+ *
+ * @param path The .mmdb file
+ * @param err_msg Set to a g_allocated error message on failure
+ * @return The reader, or NULL on failure
+ */
+WS_DLL_LOCAL mmdb_reader_t *mmdb_reader_open(const char *path, char **err_msg);
+
+WS_DLL_LOCAL void mmdb_reader_close(mmdb_reader_t *reader);
+
+/** The database_type string from the metadata, e.g. "GeoLite2-City". */
+WS_DLL_LOCAL const char *mmdb_reader_get_database_type(const mmdb_reader_t *reader);
+
+/** Find the data record for an address.
+ *
+ * @param reader The database
+ * @param addr The address
+ * @param record Set to the record's offset in the data section if found
+ * @return TRUE if the address is in the database
+ */
+WS_DLL_LOCAL gboolean mmdb_reader_lookup_ipv4(const mmdb_reader_t *reader,
+        const ws_in4_addr *addr, guint32 *record);
+
+WS_DLL_LOCAL gboolean mmdb_reader_lookup_ipv6(const mmdb_reader_t *reader,
+        const ws_in6_addr *addr, guint32 *record);
+
+/** Get a value from a data record.
+ *
+ * @param reader The database
+ * @param record A record returned by mmdb_reader_lookup_ipv4() or
+ * mmdb_reader_lookup_ipv6()
+ * @param path NULL terminated list of map keys, e.g. { "country",
+ * "iso_code", NULL }
+ * @param value Set to the value, which points into the mapped file
+ * @return TRUE if the record has a value at that path
+ */
+WS_DLL_LOCAL gboolean mmdb_reader_get_value(const mmdb_reader_t *reader,
+        guint32 record, const char * const *path, mmdb_reader_value_t *value);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __MMDB_READER_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -40,10 +40,21 @@
 #include <epan/prefs.h>
 #include <epan/range.h>
 
+#include <wsutil/pint.h>
 #include <wsutil/str_util.h>
+#include <wsutil/time_util.h>
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 
+/* The cycle counter is used as the dissector profiling clock where available. */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAVE_PROF_RDTSC
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define HAVE_PROF_RDTSC
+#endif
+
 static gint proto_malformed = -1;
 static dissector_handle_t frame_handle = NULL;
 static dissector_handle_t file_handle = NULL;
@@ -82,9 +93,20 @@ struct data_source {
  *
  * "protocol" is the protocol associated with the dissector table. Used
  * for determining dependencies.
+ *
+ * "dense" is only used by FT_UINT8 and FT_UINT16 tables. It mirrors the
+ * hash table entries for values up to 0xFFFF, so that looking up one of
+ * those takes two array loads instead of a hash table lookup. It is made
+ * of pages of DTBL_DENSE_PAGE_SIZE entries; the page directory and the
+ * pages are only allocated once something is added in their range.
  */
+#define DTBL_DENSE_PAGE_SHIFT	8
+#define DTBL_DENSE_PAGE_SIZE	(1U << DTBL_DENSE_PAGE_SHIFT)
+#define DTBL_DENSE_NUM_PAGES	(0x10000U >> DTBL_DENSE_PAGE_SHIFT)
+
 struct dissector_table {
 	GHashTable	*hash_table;
+	dtbl_entry_t	***dense;
 	GSList		*dissector_handles;
 	const char	*ui_name;
 	ftenum_t	type;
@@ -157,11 +179,33 @@ destroy_depend_dissector_list(void *data)
 /*
  * A heuristics dissector list.
  */
+/*
+ * The signatures of the dissectors in a heuristic list compare bytes in
+ * a few 8-byte windows of the payload. The windows are fetched once per
+ * payload, and each signature is a mask and value for one of them.
+ */
+#define HEUR_MAX_SIG_WINDOWS	8
+
+struct heur_dtbl_signature {
+	guint	min_len;	/* minimum reported length */
+	guint	window;		/* window of the list holding the bytes */
+	guint	needed;		/* bytes of the window that must be captured */
+	guint64	mask;
+	guint64	value;
+};
+
 struct heur_dissector_list {
 	protocol_t	*protocol;
 	GSList		*dissectors;
+	guint		sig_window_offsets[HEUR_MAX_SIG_WINDOWS];
+	guint		num_sig_windows;
 };
 
+/* Incremented for every heuristic dissector added */
+static guint heur_registration_count = 0;
+
+static void heur_dissector_lists_reset(void);
+
 static GHashTable *heur_dissector_lists = NULL;
 
 /* Name hashtables for fast detection of duplicate names */
@@ -173,6 +217,7 @@ destroy_heuristic_dissector_entry(gpointer data)
 	heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)data;
 	g_free(hdtbl_entry->list_name);
 	g_free(hdtbl_entry->short_name);
+	g_free(hdtbl_entry->signature);
 	g_slice_free(heur_dtbl_entry_t, data);
 }
 
@@ -190,8 +235,14 @@ static void
 destroy_dissector_table(void *data)
 {
 	struct dissector_table *table = (struct dissector_table *)data;
+	guint i;
 
 	g_hash_table_destroy(table->hash_table);
+	if (table->dense != NULL) {
+		for (i = 0; i < DTBL_DENSE_NUM_PAGES; i++)
+			g_free(table->dense[i]);
+		g_free(table->dense);
+	}
 	g_slist_free(table->dissector_handles);
 	g_slice_free(struct dissector_table, data);
 }
@@ -266,6 +317,241 @@ static GSList *shutdown_routines = NULL;
 
 typedef void (*void_func_t)(void);
 
+/*
+ * Dissector profiling.
+ *
+ * While profiling is enabled, calls through dissector handles and calls
+ * of heuristic dissectors push a frame onto prof_stack. When a frame is
+ * popped, the ticks and wmem bytes spent since it was pushed are added
+ * to the dissector's inclusive figures, and the same less what its
+ * callees spent to its exclusive ones. The frame is popped in a FINALLY
+ * block, so a dissector that throws is charged for the time up to the
+ * throw and its caller's figures stay right.
+ *
+ * When profiling is disabled the only cost is the test of
+ * dissector_prof_enabled before each call.
+ */
+typedef struct {
+	dissector_prof_stats_t *stats;
+	guint64 start_ticks;
+	guint64 start_bytes;
+	guint64 child_ticks;
+	guint64 child_bytes;
+} prof_frame_t;
+
+static guint dissector_prof_enabled = 0;
+static GArray *prof_stack = NULL;
+static GHashTable *prof_stats_table = NULL;
+static guint64 prof_calib_ticks;
+static guint64 prof_calib_ns;
+
+static inline guint64
+prof_ticks(void)
+{
+#ifdef HAVE_PROF_RDTSC
+	return __rdtsc();
+#else
+	return ws_clock_get_monotonic_ns();
+#endif
+}
+
+static guint64
+prof_alloc_bytes(packet_info *pinfo)
+{
+	uint64_t pinfo_bytes = 0;
+	uint64_t file_bytes = 0;
+
+	wmem_get_allocation_stats(pinfo->pool, NULL, &pinfo_bytes);
+	wmem_get_allocation_stats(wmem_file_scope(), NULL, &file_bytes);
+	return pinfo_bytes + file_bytes;
+}
+
+static dissector_prof_stats_t *
+prof_stats_lookup(const char *name, protocol_t *protocol, gboolean heuristic)
+{
+	dissector_prof_stats_t *stats;
+	char *key;
+
+	/* Heuristic dissectors have a namespace of their own. */
+	key = g_strconcat(heuristic ? "h:" : "d:", name, NULL);
+	stats = (dissector_prof_stats_t *)g_hash_table_lookup(prof_stats_table, key);
+	if (stats != NULL) {
+		g_free(key);
+		return stats;
+	}
+
+	stats = g_new0(dissector_prof_stats_t, 1);
+	stats->name = key + 2;
+	stats->protocol = protocol ? proto_get_protocol_short_name(protocol) : NULL;
+	stats->heuristic = heuristic;
+	g_hash_table_insert(prof_stats_table, key, stats);
+	return stats;
+}
+
+static guint
+prof_enter(dissector_prof_stats_t *stats, packet_info *pinfo)
+{
+	prof_frame_t frame;
+
+	stats->calls++;
+	stats->active++;
+	frame.stats = stats;
+	frame.child_ticks = 0;
+	frame.child_bytes = 0;
+	frame.start_bytes = prof_alloc_bytes(pinfo);
+	frame.start_ticks = prof_ticks();
+	g_array_append_val(prof_stack, frame);
+
+	return prof_stack->len - 1;
+}
+
+/* Pop the frames at depth and above. */
+static void
+prof_leave(guint depth, packet_info *pinfo)
+{
+	guint64 now_ticks;
+	guint64 now_bytes;
+
+	if (prof_stack == NULL || prof_stack->len <= depth)
+		return;
+
+	now_ticks = prof_ticks();
+	now_bytes = prof_alloc_bytes(pinfo);
+	while (prof_stack->len > depth) {
+		prof_frame_t *frame = &g_array_index(prof_stack, prof_frame_t, prof_stack->len - 1);
+		dissector_prof_stats_t *stats = frame->stats;
+		guint64 ticks = now_ticks - frame->start_ticks;
+		guint64 bytes = now_bytes - frame->start_bytes;
+
+		stats->excl_ticks += ticks - MIN(ticks, frame->child_ticks);
+		stats->excl_bytes += bytes - MIN(bytes, frame->child_bytes);
+		/*
+		 * Only count the outermost of recursive calls, so that the
+		 * time isn't counted more than once.
+		 */
+		if (stats->active > 0 && --stats->active == 0) {
+			stats->incl_ticks += ticks;
+			stats->incl_bytes += bytes;
+		}
+		g_array_set_size(prof_stack, prof_stack->len - 1);
+
+		if (prof_stack->len > 0) {
+			frame = &g_array_index(prof_stack, prof_frame_t, prof_stack->len - 1);
+			frame->child_ticks += ticks;
+			frame->child_bytes += bytes;
+		}
+	}
+}
+
+static void
+prof_calibrate_start(void)
+{
+	prof_calib_ns = ws_clock_get_monotonic_ns();
+	prof_calib_ticks = prof_ticks();
+}
+
+void
+dissector_prof_enable(void)
+{
+	if (prof_stats_table == NULL) {
+		prof_stats_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		prof_stack = g_array_new(FALSE, FALSE, sizeof(prof_frame_t));
+	}
+	if (dissector_prof_enabled++ == 0)
+		prof_calibrate_start();
+}
+
+static void
+prof_stats_clear_active(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	((dissector_prof_stats_t *)value)->active = 0;
+}
+
+void
+dissector_prof_disable(void)
+{
+	if (dissector_prof_enabled == 0)
+		return;
+	if (--dissector_prof_enabled == 0) {
+		/* Forget the calls in progress; their callers won't profile them. */
+		g_array_set_size(prof_stack, 0);
+		g_hash_table_foreach(prof_stats_table, prof_stats_clear_active, NULL);
+	}
+}
+
+static void
+prof_stats_reset(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	dissector_prof_stats_t *stats = (dissector_prof_stats_t *)value;
+
+	stats->calls = 0;
+	stats->incl_ticks = 0;
+	stats->excl_ticks = 0;
+	stats->incl_bytes = 0;
+	stats->excl_bytes = 0;
+}
+
+void
+dissector_prof_reset(void)
+{
+	if (prof_stats_table == NULL)
+		return;
+	g_hash_table_foreach(prof_stats_table, prof_stats_reset, NULL);
+	prof_calibrate_start();
+}
+
+typedef struct {
+	dissector_prof_func func;
+	gpointer user_data;
+} prof_foreach_data_t;
+
+static void
+prof_stats_foreach(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	dissector_prof_stats_t *stats = (dissector_prof_stats_t *)value;
+	prof_foreach_data_t *foreach_data = (prof_foreach_data_t *)user_data;
+
+	if (stats->calls > 0)
+		foreach_data->func(stats, foreach_data->user_data);
+}
+
+void
+dissector_prof_foreach(dissector_prof_func func, gpointer user_data)
+{
+	prof_foreach_data_t foreach_data = { func, user_data };
+
+	if (prof_stats_table == NULL)
+		return;
+	g_hash_table_foreach(prof_stats_table, prof_stats_foreach, &foreach_data);
+}
+
+double
+dissector_prof_ticks_per_ns(void)
+{
+#ifdef HAVE_PROF_RDTSC
+	guint64 ns = ws_clock_get_monotonic_ns() - prof_calib_ns;
+	guint64 ticks = prof_ticks() - prof_calib_ticks;
+
+	if (prof_stats_table == NULL || ns == 0)
+		return 1.0;
+	return (double)ticks / (double)ns;
+#else
+	return 1.0;
+#endif
+}
+
+static void
+dissector_prof_cleanup(void)
+{
+	if (prof_stats_table != NULL) {
+		g_hash_table_destroy(prof_stats_table);
+		g_array_free(prof_stack, TRUE);
+		prof_stats_table = NULL;
+		prof_stack = NULL;
+	}
+	dissector_prof_enabled = 0;
+}
+
 /* Initialize all data structures used for dissection. */
 static void
 call_routine(gpointer routine, gpointer dummy _U_)
@@ -286,6 +572,8 @@ packet_cleanup(void)
 	g_hash_table_destroy(depend_dissector_lists);
 	g_hash_table_destroy(heur_dissector_lists);
 	g_hash_table_destroy(heuristic_short_names);
+	dissector_limit_clear();
+	dissector_prof_cleanup();
 	g_slist_foreach(shutdown_routines, &call_routine, NULL);
 	g_slist_free(shutdown_routines);
 	if (postdissectors) {
@@ -351,6 +639,10 @@ init_dissection(void)
 	/* Initialize the table of conversations. */
 	epan_conversation_init();
 
+	/* Start each capture with the heuristic dissectors in their
+	   initial order. */
+	heur_dissector_lists_reset();
+
 	/* Initialize protocol-specific variables. */
 	g_slist_foreach(init_routines, &call_routine, NULL);
 
@@ -669,6 +961,10 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 					       record_type);
 	}
 	ENDTRY;
+	if (G_UNLIKELY(dissector_prof_enabled)) {
+		/* Pop the frames of calls that were ended by exceptions. */
+		prof_leave(0, &edt->pi);
+	}
 	wtap_block_unref(rec->block);
 	rec->block = NULL;
 
@@ -743,6 +1039,10 @@ dissect_file(epan_dissect_t *edt, wtap_rec *rec,
 					       "[Malformed Record: Packet Length]");
 	}
 	ENDTRY;
+	if (G_UNLIKELY(dissector_prof_enabled)) {
+		/* Pop the frames of calls that were ended by exceptions. */
+		prof_leave(0, &edt->pi);
+	}
 	wtap_block_unref(rec->block);
 	rec->block = NULL;
 
@@ -766,6 +1066,7 @@ struct dissector_handle {
 	void		*dissector_func;
 	void		*dissector_data;
 	protocol_t	*protocol;
+	dissector_prof_stats_t *prof;	/* set while dissector profiling is used */
 };
 
 static void
@@ -829,6 +1130,73 @@ remove_last_layer(packet_info *pinfo, gboolean reduce_count)
 }
 
 
+static inline int
+call_dissector_func(dissector_handle_t handle, tvbuff_t *tvb,
+		    packet_info *pinfo, proto_tree *tree, void *data)
+{
+	int len;
+
+	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
+		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
+	}
+	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
+		len = ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
+	}
+	else {
+		ws_assert_not_reached();
+	}
+	return len;
+}
+
+static int
+call_dissector_func_profiled(dissector_handle_t handle, tvbuff_t *tvb,
+			     packet_info *pinfo, proto_tree *tree, void *data)
+{
+	guint depth;
+	volatile int len = 0;
+
+	if (handle->prof == NULL) {
+		const char *name = handle->name;
+
+		if (name == NULL)
+			name = handle->protocol ? proto_get_protocol_short_name(handle->protocol) : "(anonymous)";
+		handle->prof = prof_stats_lookup(name, handle->protocol, FALSE);
+	}
+
+	depth = prof_enter(handle->prof, pinfo);
+	TRY {
+		len = call_dissector_func(handle, tvb, pinfo, tree, data);
+	}
+	FINALLY {
+		prof_leave(depth, pinfo);
+	}
+	ENDTRY;
+
+	return len;
+}
+
+static int
+call_heur_dissector_profiled(heur_dtbl_entry_t *hdtbl_entry, tvbuff_t *tvb,
+			     packet_info *pinfo, proto_tree *tree, void *data)
+{
+	guint depth;
+	volatile int len = 0;
+
+	if (hdtbl_entry->prof == NULL)
+		hdtbl_entry->prof = prof_stats_lookup(hdtbl_entry->short_name, hdtbl_entry->protocol, TRUE);
+
+	depth = prof_enter(hdtbl_entry->prof, pinfo);
+	TRY {
+		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+	}
+	FINALLY {
+		prof_leave(depth, pinfo);
+	}
+	ENDTRY;
+
+	return len;
+}
+
 /* This function will return
  * old style dissector :
  *   length of the payload or 1 of the payload is empty
@@ -853,20 +1221,38 @@ call_dissector_through_handle(dissector_handle_t handle, tvbuff_t *tvb,
 			proto_get_protocol_short_name(handle->protocol);
 	}
 
-	if (handle->dissector_type == DISSECTOR_TYPE_SIMPLE) {
-		len = ((dissector_t)handle->dissector_func)(tvb, pinfo, tree, data);
-	}
-	else if (handle->dissector_type == DISSECTOR_TYPE_CALLBACK) {
-		len = ((dissector_cb_t)handle->dissector_func)(tvb, pinfo, tree, data, handle->dissector_data);
+	if (G_UNLIKELY(dissector_prof_enabled)) {
+		len = call_dissector_func_profiled(handle, tvb, pinfo, tree, data);
 	}
 	else {
-		ws_assert_not_reached();
+		len = call_dissector_func(handle, tvb, pinfo, tree, data);
 	}
 	pinfo->current_proto = saved_proto;
 
 	return len;
 }
 
+/*
+ * Protocols that can add, or lead to a dissector that adds, a field
+ * passed to dissector_limit_to_fields(), indexed by protocol ID.
+ * NULL if dissection isn't limited.
+ */
+static guint8 *limit_relevant_protos = NULL;
+static int     limit_num_protos = 0;
+
+static inline gboolean
+dissector_limit_allows(protocol_t *protocol)
+{
+	int proto_id;
+
+	if (limit_relevant_protos == NULL || protocol == NULL)
+		return TRUE;
+
+	proto_id = proto_get_id(protocol);
+	return proto_id >= 0 && proto_id < limit_num_protos &&
+	    limit_relevant_protos[proto_id];
+}
+
 /*
  * Call a dissector through a handle.
  * If the protocol for that handle isn't enabled, return 0 without
@@ -905,6 +1291,15 @@ call_dissector_work(dissector_handle_t handle, tvbuff_t *tvb, packet_info *pinfo
 		return 0;
 	}
 
+	if (!dissector_limit_allows(handle->protocol)) {
+		/*
+		 * Dissection is limited, and neither this protocol nor
+		 * anything it can call adds a wanted field; treat it as
+		 * if it were disabled.
+		 */
+		return 0;
+	}
+
 	saved_proto = pinfo->current_proto;
 	saved_can_desegment = pinfo->can_desegment;
 	saved_layers_len = wmem_list_count(pinfo->layers);
@@ -1101,6 +1496,64 @@ find_dissector_table(const char *name)
 	return dissector_table;
 }
 
+static inline gboolean
+dtbl_has_dense_index(dissector_table_t sub_dissectors)
+{
+	return sub_dissectors->type == FT_UINT8 || sub_dissectors->type == FT_UINT16;
+}
+
+/* Update the dense index of a uint dissector table after the hash table
+   entry for "pattern" has been inserted or (with a NULL entry) removed. */
+static void
+dtbl_dense_set(dissector_table_t sub_dissectors, const guint32 pattern,
+	       dtbl_entry_t *dtbl_entry)
+{
+	dtbl_entry_t **page;
+
+	if (!dtbl_has_dense_index(sub_dissectors) || pattern > 0xFFFF)
+		return;
+
+	if (sub_dissectors->dense == NULL) {
+		if (dtbl_entry == NULL)
+			return;
+		sub_dissectors->dense = g_new0(dtbl_entry_t **, DTBL_DENSE_NUM_PAGES);
+	}
+	page = sub_dissectors->dense[pattern >> DTBL_DENSE_PAGE_SHIFT];
+	if (page == NULL) {
+		if (dtbl_entry == NULL)
+			return;
+		page = g_new0(dtbl_entry_t *, DTBL_DENSE_PAGE_SIZE);
+		sub_dissectors->dense[pattern >> DTBL_DENSE_PAGE_SHIFT] = page;
+	}
+	page[pattern & (DTBL_DENSE_PAGE_SIZE - 1)] = dtbl_entry;
+}
+
+static void
+dtbl_dense_add_func(gpointer key, gpointer value, gpointer user_data)
+{
+	dtbl_dense_set((dissector_table_t)user_data, GPOINTER_TO_UINT(key),
+		       (dtbl_entry_t *)value);
+}
+
+/* Rebuild the dense index of a uint dissector table, after entries have
+   been removed from the hash table in bulk. */
+static void
+dtbl_dense_rebuild(dissector_table_t sub_dissectors)
+{
+	guint i;
+
+	if (sub_dissectors->dense == NULL)
+		return;
+
+	for (i = 0; i < DTBL_DENSE_NUM_PAGES; i++) {
+		if (sub_dissectors->dense[i] != NULL)
+			memset(sub_dissectors->dense[i], 0,
+			       DTBL_DENSE_PAGE_SIZE * sizeof(dtbl_entry_t *));
+	}
+	g_hash_table_foreach(sub_dissectors->hash_table, dtbl_dense_add_func,
+			     sub_dissectors);
+}
+
 /* Find an entry in a uint dissector table. */
 static dtbl_entry_t *
 find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
@@ -1109,6 +1562,19 @@ find_uint_dtbl_entry(dissector_table_t sub_dissectors, const guint32 pattern)
 
 	case FT_UINT8:
 	case FT_UINT16:
+		/*
+		 * Most lookups are in these tables, and can be done with
+		 * the dense index.
+		 */
+		if (pattern <= 0xFFFF) {
+			dtbl_entry_t **page;
+
+			if (sub_dissectors->dense == NULL)
+				return NULL;
+			page = sub_dissectors->dense[pattern >> DTBL_DENSE_PAGE_SHIFT];
+			return page ? page[pattern & (DTBL_DENSE_PAGE_SIZE - 1)] : NULL;
+		}
+		break;
 	case FT_UINT24:
 	case FT_UINT32:
 		/*
@@ -1213,6 +1679,7 @@ dissector_add_uint(const char *name, const guint32 pattern, dissector_handle_t h
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	dtbl_dense_set(sub_dissectors, pattern, dtbl_entry);
 
 	/*
 	 * Now, if this table supports "Decode As", add this handle
@@ -1364,6 +1831,7 @@ dissector_delete_uint(const char *name, const guint32 pattern,
 		 */
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dtbl_dense_set(sub_dissectors, pattern, NULL);
 	}
 }
 
@@ -1404,7 +1872,8 @@ void dissector_delete_all(const char *name, dissector_handle_t handle)
 	dissector_table_t sub_dissectors = find_dissector_table(name);
 	ws_assert (sub_dissectors);
 
-	g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle);
+	if (g_hash_table_foreach_remove (sub_dissectors->hash_table, dissector_delete_all_check, handle))
+		dtbl_dense_rebuild(sub_dissectors);
 }
 
 static void
@@ -1413,7 +1882,8 @@ dissector_delete_from_table(gpointer key _U_, gpointer value, gpointer user_data
 	dissector_table_t sub_dissectors = (dissector_table_t) value;
 	ws_assert (sub_dissectors);
 
-	g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data);
+	if (g_hash_table_foreach_remove(sub_dissectors->hash_table, dissector_delete_all_check, user_data))
+		dtbl_dense_rebuild(sub_dissectors);
 	sub_dissectors->dissector_handles = g_slist_remove(sub_dissectors->dissector_handles, user_data);
 }
 
@@ -1459,6 +1929,7 @@ dissector_change_uint(const char *name, const guint32 pattern, dissector_handle_
 	/* do the table insertion */
 	g_hash_table_insert(sub_dissectors->hash_table,
 			     GUINT_TO_POINTER(pattern), (gpointer)dtbl_entry);
+	dtbl_dense_set(sub_dissectors, pattern, dtbl_entry);
 }
 
 /* Reset an entry in a uint dissector table to its initial value. */
@@ -1487,6 +1958,7 @@ dissector_reset_uint(const char *name, const guint32 pattern)
 	} else {
 		g_hash_table_remove(sub_dissectors->hash_table,
 				    GUINT_TO_POINTER(pattern));
+		dtbl_dense_set(sub_dissectors, pattern, NULL);
 	}
 }
 
@@ -2610,7 +3082,7 @@ register_dissector_table(const char *name, const char *ui_name, const int proto,
 
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
-	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors = g_slice_new0(struct dissector_table);
 	switch (type) {
 
 	case FT_UINT8:
@@ -2683,7 +3155,7 @@ dissector_table_t register_custom_dissector_table(const char *name,
 
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
-	sub_dissectors = g_slice_new(struct dissector_table);
+	sub_dissectors = g_slice_new0(struct dissector_table);
 	sub_dissectors->hash_func = hash_func;
 	sub_dissectors->hash_table = g_hash_table_new_full(hash_func,
 							       key_equal_func,
@@ -2851,6 +3323,10 @@ heur_dissector_add(const char *name, heur_dissector_t dissector, const char *dis
 	hdtbl_entry->short_name = g_strdup(internal_name);
 	hdtbl_entry->list_name = g_strdup(name);
 	hdtbl_entry->enabled   = (enable == HEURISTIC_ENABLE);
+	hdtbl_entry->registration_order = heur_registration_count++;
+	hdtbl_entry->signature = NULL;
+	memset(&hdtbl_entry->stats, 0, sizeof(hdtbl_entry->stats));
+	hdtbl_entry->prof = NULL;
 
 	/* do the table insertion */
 	g_hash_table_insert(heuristic_short_names, (gpointer)hdtbl_entry->short_name, hdtbl_entry);
@@ -2899,12 +3375,152 @@ heur_dissector_delete(const char *name, heur_dissector_t dissector, const int pr
 		proto_add_deregistered_data(found_hdtbl_entry->list_name);
 		g_hash_table_remove(heuristic_short_names, found_hdtbl_entry->short_name);
 		proto_add_deregistered_data(found_hdtbl_entry->short_name);
+		if (found_hdtbl_entry->signature)
+			proto_add_deregistered_data(found_hdtbl_entry->signature);
 		proto_add_deregistered_slice(sizeof(heur_dtbl_entry_t), found_hdtbl_entry);
 		sub_dissectors->dissectors = g_slist_delete_link(sub_dissectors->dissectors,
 		    found_entry);
 	}
 }
 
+void
+heur_dissector_set_signature(const char *internal_name, const heur_signature_t *signature)
+{
+	heur_dtbl_entry_t          *hdtbl_entry;
+	heur_dissector_list_t       sub_dissectors;
+	struct heur_dtbl_signature *sig;
+	guint                       i, pos;
+
+	hdtbl_entry = find_heur_dissector_by_unique_short_name(internal_name);
+	if (hdtbl_entry == NULL) {
+		ws_warning("Heuristic dissector \"%s\" doesn't exist", internal_name);
+		return;
+	}
+	sub_dissectors = find_heur_dissector_list(hdtbl_entry->list_name);
+	ws_assert(sub_dissectors != NULL);
+	DISSECTOR_ASSERT(signature->len <= 8);
+
+	sig = g_new0(struct heur_dtbl_signature, 1);
+	sig->min_len = signature->min_len;
+
+	if (signature->len > 0) {
+		/* Find a window that holds the bytes, or add one. */
+		for (i = 0; i < sub_dissectors->num_sig_windows; i++) {
+			if (sub_dissectors->sig_window_offsets[i] <= signature->offset &&
+			    signature->offset + signature->len <= sub_dissectors->sig_window_offsets[i] + 8)
+				break;
+		}
+		if (i == sub_dissectors->num_sig_windows) {
+			if (i == HEUR_MAX_SIG_WINDOWS) {
+				ws_warning("Too many signature windows in heuristic list \"%s\", ignoring the signature of \"%s\"",
+					   hdtbl_entry->list_name, internal_name);
+				g_free(sig);
+				return;
+			}
+			sub_dissectors->sig_window_offsets[i] = signature->offset;
+			sub_dissectors->num_sig_windows++;
+		}
+		sig->window = i;
+		pos = signature->offset - sub_dissectors->sig_window_offsets[i];
+		sig->needed = pos + signature->len;
+		for (i = 0; i < signature->len; i++) {
+			guint8 mask = signature->mask ? signature->mask[i] : 0xFF;
+			guint shift = 56 - 8 * (pos + i);
+
+			sig->mask |= (guint64)mask << shift;
+			sig->value |= (guint64)(signature->value[i] & mask) << shift;
+		}
+	}
+
+	g_free(hdtbl_entry->signature);
+	hdtbl_entry->signature = sig;
+}
+
+static void
+heur_dissector_reset_stats_func(gpointer data, gpointer user_data _U_)
+{
+	heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)data;
+
+	memset(&hdtbl_entry->stats, 0, sizeof(hdtbl_entry->stats));
+}
+
+static void
+heur_dissector_list_reset_stats(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)value;
+
+	g_slist_foreach(sub_dissectors->dissectors, heur_dissector_reset_stats_func, NULL);
+}
+
+void
+heur_dissector_reset_stats(void)
+{
+	g_hash_table_foreach(heur_dissector_lists, heur_dissector_list_reset_stats, NULL);
+}
+
+static gint
+heur_dissector_compare_registration_order(gconstpointer a, gconstpointer b)
+{
+	const heur_dtbl_entry_t *hdtbl_entry_a = (const heur_dtbl_entry_t *)a;
+	const heur_dtbl_entry_t *hdtbl_entry_b = (const heur_dtbl_entry_t *)b;
+
+	/* Dissectors are prepended when they're added. */
+	if (hdtbl_entry_a->registration_order == hdtbl_entry_b->registration_order)
+		return 0;
+	return hdtbl_entry_a->registration_order > hdtbl_entry_b->registration_order ? -1 : 1;
+}
+
+static void
+heur_dissector_list_reset(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)value;
+
+	sub_dissectors->dissectors = g_slist_sort(sub_dissectors->dissectors,
+	    heur_dissector_compare_registration_order);
+	g_slist_foreach(sub_dissectors->dissectors, heur_dissector_reset_stats_func, NULL);
+}
+
+/* Undo the reordering done by dissector_try_heuristic() and reset the
+   counters. */
+static void
+heur_dissector_lists_reset(void)
+{
+	g_hash_table_foreach(heur_dissector_lists, heur_dissector_list_reset, NULL);
+}
+
+/* Fetch the payload windows the signatures of a heuristic list look at.
+   "captured" is set to the number of bytes of each window present in
+   the tvb. */
+static void
+heur_load_sig_windows(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
+		      guint64 *windows, guint *captured)
+{
+	guint  captured_len = tvb_captured_length(tvb);
+	guint8 bytes[8];
+	guint  i, offset;
+
+	for (i = 0; i < sub_dissectors->num_sig_windows; i++) {
+		offset = sub_dissectors->sig_window_offsets[i];
+		captured[i] = offset < captured_len ? MIN(captured_len - offset, 8) : 0;
+		memset(bytes, 0, sizeof(bytes));
+		if (captured[i] > 0)
+			tvb_memcpy(tvb, bytes, offset, captured[i]);
+		windows[i] = pntoh64(bytes);
+	}
+}
+
+static inline gboolean
+heur_signature_matches(const struct heur_dtbl_signature *sig, guint reported_len,
+		       const guint64 *windows, const guint *captured)
+{
+	if (reported_len < sig->min_len)
+		return FALSE;
+	if (sig->needed == 0)
+		return TRUE;
+	return captured[sig->window] >= sig->needed &&
+	    (windows[sig->window] & sig->mask) == sig->value;
+}
+
 gboolean
 dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			packet_info *pinfo, proto_tree *tree, heur_dtbl_entry_t **heur_dtbl_entry, void *data)
@@ -2913,13 +3529,15 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 	const char        *saved_curr_proto;
 	const char        *saved_heur_list_name;
 	GSList            *entry;
-	GSList            *prev_entry = NULL;
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
 	heur_dtbl_entry_t *hdtbl_entry;
 	int                proto_id;
 	int                len;
 	guint              saved_tree_count = tree ? tree->tree_data->count : 0;
+	guint64            sig_windows[HEUR_MAX_SIG_WINDOWS];
+	guint              sig_captured[HEUR_MAX_SIG_WINDOWS];
+	guint              reported_len;
 
 	/* can_desegment is set to 2 by anyone which offers this api/service.
 	   then everytime a subdissector is called it is decremented by one.
@@ -2943,6 +3561,10 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 	DISSECTOR_ASSERT(saved_layers_len < PINFO_LAYER_MAX_RECURSION_DEPTH);
 
+	if (sub_dissectors->num_sig_windows > 0)
+		heur_load_sig_windows(sub_dissectors, tvb, sig_windows, sig_captured);
+	reported_len = tvb_reported_length(tvb);
+
 	for (entry = sub_dissectors->dissectors; entry != NULL;
 	    entry = g_slist_next(entry)) {
 		/* XXX - why set this now and above? */
@@ -2957,6 +3579,24 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			continue;
 		}
 
+		if (!dissector_limit_allows(hdtbl_entry->protocol)) {
+			/*
+			 * Nothing this dissector adds is wanted.
+			 */
+			continue;
+		}
+
+		if (hdtbl_entry->signature != NULL &&
+		    !heur_signature_matches(hdtbl_entry->signature, reported_len,
+					    sig_windows, sig_captured)) {
+			/*
+			 * The payload can't be for this dissector.
+			 */
+			hdtbl_entry->stats.skipped++;
+			continue;
+		}
+		hdtbl_entry->stats.calls++;
+
 		if (hdtbl_entry->protocol != NULL) {
 			proto_id = proto_get_id(hdtbl_entry->protocol);
 			/* do NOT change this behavior - wslua uses the protocol short name set here in order
@@ -2973,7 +3613,10 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 
 		pinfo->heur_list_name = hdtbl_entry->list_name;
 
-		len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
+		if (G_UNLIKELY(dissector_prof_enabled))
+			len = call_heur_dissector_profiled(hdtbl_entry, tvb, pinfo, tree, data);
+		else
+			len = (hdtbl_entry->dissector)(tvb, pinfo, tree, data);
 		if (hdtbl_entry->protocol != NULL &&
 			(len == 0 || (tree && saved_tree_count == tree->tree_data->count))) {
 			/*
@@ -2997,16 +3640,16 @@ dissector_try_heuristic(heur_dissector_list_t sub_dissectors, tvbuff_t *tvb,
 			}
 
 			*heur_dtbl_entry = hdtbl_entry;
+			hdtbl_entry->stats.accepted++;
 
 			/* Bubble the matched entry to the top for faster search next time. */
-			if (prev_entry != NULL) {
+			if (prefs.heur_adaptive_order && entry != sub_dissectors->dissectors) {
 				sub_dissectors->dissectors = g_slist_remove_link(sub_dissectors->dissectors, entry);
 				sub_dissectors->dissectors = g_slist_concat(entry, sub_dissectors->dissectors);
 			}
 			status = TRUE;
 			break;
 		}
-		prev_entry = entry;
 	}
 
 	pinfo->current_proto = saved_curr_proto;
@@ -3163,7 +3806,7 @@ register_heur_dissector_list(const char *name, const int proto)
 
 	/* Create and register the dissector table for this name; returns */
 	/* a pointer to the dissector table. */
-	sub_dissectors = g_slice_new(struct heur_dissector_list);
+	sub_dissectors = g_slice_new0(struct heur_dissector_list);
 	sub_dissectors->protocol  = (proto == -1) ? NULL : find_protocol_by_id(proto);
 	sub_dissectors->dissectors = NULL;	/* initially empty */
 	g_hash_table_insert(heur_dissector_lists, (gpointer)name,
@@ -3282,6 +3925,7 @@ new_dissector_handle(enum dissector_e type, void *dissector, const int proto, co
 	handle->dissector_func	= dissector;
 	handle->dissector_data	= cb_data;
 	handle->protocol	= find_protocol_by_id(proto);
+	handle->prof		= NULL;
 
 	if (handle->description == NULL) {
 		/*
@@ -3499,6 +4143,7 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	const char        *saved_heur_list_name;
 	guint16            saved_can_desegment;
 	guint              saved_layers_len = 0;
+	int                len;
 
 	DISSECTOR_ASSERT(heur_dtbl_entry);
 
@@ -3537,7 +4182,11 @@ void call_heur_dissector_direct(heur_dtbl_entry_t *heur_dtbl_entry, tvbuff_t *tv
 	pinfo->heur_list_name = heur_dtbl_entry->list_name;
 
 	/* call the dissector, in case of failure call data handle (might happen with exported PDUs) */
-	if (!(*heur_dtbl_entry->dissector)(tvb, pinfo, tree, data)) {
+	if (G_UNLIKELY(dissector_prof_enabled))
+		len = call_heur_dissector_profiled(heur_dtbl_entry, tvb, pinfo, tree, data);
+	else
+		len = (*heur_dtbl_entry->dissector)(tvb, pinfo, tree, data);
+	if (!len) {
 		call_dissector_work(data_handle, tvb, pinfo, tree, TRUE, NULL);
 
 		/*
@@ -3609,6 +4258,194 @@ depend_dissector_list_t find_depend_dissector_list(const char* name)
 	return (depend_dissector_list_t)g_hash_table_lookup(depend_dissector_lists, name);
 }
 
+/*
+ * Dissection limited to a set of fields.
+ *
+ * The protocols worth calling are the ones that own one of the fields,
+ * plus everything that can call one of those, directly or not. The
+ * callers of a protocol are taken from the dependencies registered
+ * with register_depend_dissector() and from the dissector tables,
+ * whose protocol can call every handle added to them.
+ */
+static void
+limit_add_caller(GHashTable *callers, int parent_id, int child_id)
+{
+	GSList *parents;
+
+	if (parent_id < 0 || child_id < 0 || parent_id == child_id)
+		return;
+
+	parents = (GSList *)g_hash_table_lookup(callers, GINT_TO_POINTER(child_id));
+	g_hash_table_insert(callers, GINT_TO_POINTER(child_id),
+	    g_slist_prepend(parents, GINT_TO_POINTER(parent_id)));
+}
+
+static void
+limit_add_depend_callers(gpointer key, gpointer value, gpointer user_data)
+{
+	depend_dissector_list_t sub_dissectors = (depend_dissector_list_t)value;
+	GHashTable *callers = (GHashTable *)user_data;
+	int         parent_id = proto_get_id_by_short_name((const char *)key);
+	GSList     *entry;
+
+	for (entry = sub_dissectors->dissectors; entry != NULL; entry = g_slist_next(entry)) {
+		limit_add_caller(callers, parent_id,
+		    proto_get_id_by_short_name((const char *)entry->data));
+	}
+}
+
+static void
+limit_add_table_callers(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	dissector_table_t sub_dissectors = (dissector_table_t)value;
+	GHashTable       *callers = (GHashTable *)user_data;
+	GHashTableIter    iter;
+	gpointer          entry_value;
+	dtbl_entry_t     *dtbl_entry;
+	GSList           *entry;
+	int               parent_id;
+
+	if (sub_dissectors->protocol == NULL)
+		return;
+	parent_id = proto_get_id(sub_dissectors->protocol);
+
+	g_hash_table_iter_init(&iter, sub_dissectors->hash_table);
+	while (g_hash_table_iter_next(&iter, NULL, &entry_value)) {
+		dtbl_entry = (dtbl_entry_t *)entry_value;
+		if (dtbl_entry->current != NULL && dtbl_entry->current->protocol != NULL)
+			limit_add_caller(callers, parent_id, proto_get_id(dtbl_entry->current->protocol));
+	}
+
+	for (entry = sub_dissectors->dissector_handles; entry != NULL; entry = g_slist_next(entry)) {
+		dissector_handle_t handle = (dissector_handle_t)entry->data;
+
+		if (handle->protocol != NULL)
+			limit_add_caller(callers, parent_id, proto_get_id(handle->protocol));
+	}
+}
+
+static void
+limit_add_heur_callers(gpointer key _U_, gpointer value, gpointer user_data)
+{
+	heur_dissector_list_t sub_dissectors = (heur_dissector_list_t)value;
+	GHashTable       *callers = (GHashTable *)user_data;
+	GSList           *entry;
+	int               parent_id;
+
+	if (sub_dissectors->protocol == NULL)
+		return;
+	parent_id = proto_get_id(sub_dissectors->protocol);
+
+	for (entry = sub_dissectors->dissectors; entry != NULL; entry = g_slist_next(entry)) {
+		heur_dtbl_entry_t *hdtbl_entry = (heur_dtbl_entry_t *)entry->data;
+
+		if (hdtbl_entry->protocol != NULL)
+			limit_add_caller(callers, parent_id, proto_get_id(hdtbl_entry->protocol));
+	}
+}
+
+static void
+limit_free_callers(gpointer key _U_, gpointer value, gpointer user_data _U_)
+{
+	g_slist_free((GSList *)value);
+}
+
+gboolean
+dissector_limit_to_fields(const int *hfids, guint num_hfids)
+{
+	GHashTable *callers;
+	GHashTable *relevant;
+	GArray     *pending;
+	GHashTableIter iter;
+	gpointer    key;
+	GSList     *parent;
+	int         proto_frame;
+	int         proto_id;
+	int         max_id;
+	gboolean    known = TRUE;
+	guint       i;
+
+	dissector_limit_clear();
+
+	proto_frame = proto_get_id_by_filter_name("frame");
+
+	callers = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_hash_table_foreach(depend_dissector_lists, limit_add_depend_callers, callers);
+	g_hash_table_foreach(dissector_tables, limit_add_table_callers, callers);
+	g_hash_table_foreach(heur_dissector_lists, limit_add_heur_callers, callers);
+
+	relevant = g_hash_table_new(g_direct_hash, g_direct_equal);
+	pending = g_array_new(FALSE, FALSE, sizeof(int));
+	g_array_append_val(pending, proto_frame);
+	for (i = 0; i < num_hfids; i++) {
+		if (proto_registrar_is_protocol(hfids[i]))
+			proto_id = hfids[i];
+		else
+			proto_id = proto_registrar_get_parent(hfids[i]);
+
+		if (proto_id != proto_frame &&
+		    !g_hash_table_contains(callers, GINT_TO_POINTER(proto_id))) {
+			/*
+			 * Nothing says how this protocol is reached
+			 * (e.g. expert info or a postdissector), so we
+			 * can't tell what to keep.
+			 */
+			known = FALSE;
+			break;
+		}
+		g_array_append_val(pending, proto_id);
+	}
+
+	while (known && pending->len > 0) {
+		proto_id = g_array_index(pending, int, pending->len - 1);
+		g_array_set_size(pending, pending->len - 1);
+		if (!g_hash_table_add(relevant, GINT_TO_POINTER(proto_id)))
+			continue;
+		parent = (GSList *)g_hash_table_lookup(callers, GINT_TO_POINTER(proto_id));
+		for (; parent != NULL; parent = g_slist_next(parent)) {
+			int parent_id = GPOINTER_TO_INT(parent->data);
+
+			if (!g_hash_table_contains(relevant, parent->data))
+				g_array_append_val(pending, parent_id);
+		}
+	}
+
+	if (known) {
+		max_id = 0;
+		g_hash_table_iter_init(&iter, relevant);
+		while (g_hash_table_iter_next(&iter, &key, NULL))
+			max_id = MAX(max_id, GPOINTER_TO_INT(key));
+
+		limit_num_protos = max_id + 1;
+		limit_relevant_protos = (guint8 *)g_malloc0(limit_num_protos);
+		g_hash_table_iter_init(&iter, relevant);
+		while (g_hash_table_iter_next(&iter, &key, NULL))
+			limit_relevant_protos[GPOINTER_TO_INT(key)] = 1;
+		ws_debug("dissection limited to %u protocols", g_hash_table_size(relevant));
+	}
+
+	g_array_free(pending, TRUE);
+	g_hash_table_destroy(relevant);
+	g_hash_table_foreach(callers, limit_free_callers, NULL);
+	g_hash_table_destroy(callers);
+
+	return known;
+}
+
+void
+dissector_limit_clear(void)
+{
+	g_free(limit_relevant_protos);
+	limit_relevant_protos = NULL;
+	limit_num_protos = 0;
+}
+
+gboolean
+dissector_limit_active(void)
+{
+	return limit_relevant_protos != NULL;
+}
+
 /*
  * Dumps the "layer type"/"decode as" associations to stdout, similar
  * to the proto_registrar_dump_*() routines.
@@ -458,6 +458,16 @@ struct heur_dissector_list;
 typedef struct heur_dissector_list *heur_dissector_list_t;
 
 
+/** Counters kept for every heuristic dissector. */
+typedef struct heur_dtbl_stats {
+	guint64 calls;     /**< Number of payloads the dissector was called for */
+	guint64 accepted;  /**< Number of payloads the dissector accepted */
+	guint64 skipped;   /**< Number of payloads its signature ruled out */
+} heur_dtbl_stats_t;
+
+struct heur_dtbl_signature;
+struct dissector_prof_stats;
+
 typedef struct heur_dtbl_entry {
 	heur_dissector_t dissector;
 	protocol_t *protocol; /* this entry's protocol */
@@ -465,8 +475,24 @@ typedef struct heur_dtbl_entry {
 	const gchar *display_name;     /* the string used to present heuristic to user */
 	gchar *short_name;     /* string used for "internal" use to uniquely identify heuristic */
 	gboolean enabled;
+	guint registration_order; /* used to restore the initial order of the list */
+	struct heur_dtbl_signature *signature; /* set by heur_dissector_set_signature() */
+	heur_dtbl_stats_t stats;
+	struct dissector_prof_stats *prof; /* set while dissector profiling is used */
 } heur_dtbl_entry_t;
 
+/** A cheap test that a payload has to pass before a heuristic dissector
+ *  is called for it. The signature must never reject a payload that the
+ *  dissector would accept.
+ */
+typedef struct heur_signature {
+	guint min_len;          /**< Minimum reported length of the payload */
+	guint offset;           /**< Offset of the bytes to compare */
+	guint len;              /**< Number of bytes to compare, 0 to 8 */
+	const guint8 *value;    /**< Expected bytes, after masking */
+	const guint8 *mask;     /**< Mask applied to the bytes, or NULL to compare all bits */
+} heur_signature_t;
+
 /** A protocol uses this function to register a heuristic sub-dissector list.
  *  Call this in the parent dissectors proto_register function.
  *
@@ -548,6 +574,21 @@ WS_DLL_PUBLIC heur_dtbl_entry_t* find_heur_dissector_by_unique_short_name(const
 WS_DLL_PUBLIC void heur_dissector_add(const char *name, heur_dissector_t dissector,
     const char *display_name, const char *internal_name, const int proto, heuristic_enable_e enable);
 
+/** Give a heuristic dissector a signature. Payloads that don't match
+ *  the signature are not passed to the dissector. The signatures of a
+ *  heuristic list are checked together, so that the payload bytes they
+ *  look at are only fetched once.
+ *  Call this after heur_dissector_add().
+ *
+ * @param internal_name the internal name of the heuristic, e.g. "http_tcp"
+ * @param signature the signature; it is copied
+ */
+WS_DLL_PUBLIC void heur_dissector_set_signature(const char *internal_name,
+    const heur_signature_t *signature);
+
+/** Reset the counters of all heuristic dissectors. */
+WS_DLL_PUBLIC void heur_dissector_reset_stats(void);
+
 /** Remove a sub-dissector from a heuristic dissector list.
  *  Call this in the prefs_reinit function of the sub-dissector.
  *
@@ -691,6 +732,69 @@ WS_DLL_PUBLIC gboolean deregister_depend_dissector(const char* parent, const cha
  */
 WS_DLL_PUBLIC depend_dissector_list_t find_depend_dissector_list(const char* name);
 
+/** Limit dissection to the protocols that can add one of the given
+ *  fields: the protocols owning them and every protocol that can lead,
+ *  through the dependencies, dissector tables and heuristic lists, to one
+ *  of those.
+ *  Other dissectors are treated as disabled until dissector_limit_clear()
+ *  is called.
+ *
+ *   @param hfids The fields that are wanted
+ *   @param num_hfids The number of fields
+ *   @return TRUE if dissection was limited, FALSE if one of the fields
+ *   belongs to a protocol that nothing is known to call, in which case
+ *   dissection is left unrestricted.
+ */
+extern gboolean dissector_limit_to_fields(const int *hfids, guint num_hfids);
+
+/** Stop limiting dissection. */
+extern void dissector_limit_clear(void);
+
+/** Return TRUE if dissection is currently limited. */
+WS_DLL_PUBLIC gboolean dissector_limit_active(void);
+
+/** Profile of one dissector, accumulated while dissector profiling is
+ *  enabled. Dissector handles with the same name share a profile;
+ *  anonymous handles are named after their protocol.
+ *  Inclusive figures cover the dissector and everything it called,
+ *  exclusive ones only the dissector itself. Times are in ticks of the
+ *  profiling clock; see dissector_prof_ticks_per_ns().
+ */
+typedef struct dissector_prof_stats {
+	const char *name;       /**< Handle name, or protocol short name */
+	const char *protocol;   /**< Protocol short name, or NULL */
+	gboolean heuristic;     /**< TRUE for a heuristic dissector */
+	guint64 calls;          /**< Number of times the dissector was called */
+	guint64 incl_ticks;     /**< Time spent in the dissector and its callees */
+	guint64 excl_ticks;     /**< Time spent in the dissector itself */
+	guint64 incl_bytes;     /**< wmem bytes allocated by the dissector and its callees */
+	guint64 excl_bytes;     /**< wmem bytes allocated by the dissector itself */
+	guint active;           /**< Calls in progress; internal */
+} dissector_prof_stats_t;
+
+typedef void (*dissector_prof_func)(const dissector_prof_stats_t *stats, gpointer user_data);
+
+/** Start profiling dissectors. Calls nest; profiling stops when
+ *  dissector_prof_disable() has been called as often as this.
+ */
+WS_DLL_PUBLIC void dissector_prof_enable(void);
+
+/** Undo one dissector_prof_enable(). */
+WS_DLL_PUBLIC void dissector_prof_disable(void);
+
+/** Clear the profiles of all dissectors. */
+WS_DLL_PUBLIC void dissector_prof_reset(void);
+
+/** Call func for the profile of every dissector that has been called
+ *  while profiling was enabled.
+ */
+WS_DLL_PUBLIC void dissector_prof_foreach(dissector_prof_func func, gpointer user_data);
+
+/** Return the number of profiling clock ticks per nanosecond, measured
+ *  since profiling was last enabled or reset.
+ */
+WS_DLL_PUBLIC double dissector_prof_ticks_per_ns(void);
+
 
 /* Do all one-time initialization. */
 extern void dissect_init(void);
@@ -149,7 +149,7 @@ typedef struct _packet_info {
   gint16 src_win_scale;        /**< Rcv.Wind.Shift src applies when sending segments; -1 unknown; -2 disabled */
   gint16 dst_win_scale;        /**< Rcv.Wind.Shift dst applies when sending segments; -1 unknown; -2 disabled */
 
-  GSList* proto_data;          /**< Per packet proto data */
+  struct _proto_data_list *proto_data; /**< Per packet proto data */
 
   GSList* frame_end_routines;
 
@@ -3784,6 +3784,40 @@ prefs_register_modules(void)
             "of cache entries to maintain. A 0 means no limit.",
             10, &prefs.ignore_dup_frames_cache_entries);
 
+    prefs_register_uint_preference(protocols_module, "reassembly_cache_size",
+            "Memory for reassembled data (MB)",
+            "The payloads of completed reassemblies are kept so that packets can be "
+            "dissected again. If this is set, the payloads that were used least "
+            "recently are moved to a temporary file, and read back when needed, "
+            "to keep the rest within this many megabytes. A 0 means no limit.",
+            10, &prefs.reassembly_cache_size);
+
+    prefs_register_bool_preference(protocols_module, "heur_adaptive_order",
+                                   "Try recently successful heuristic dissectors first",
+                                   "When a heuristic dissector recognizes a payload, move it to the front "
+                                   "of its list so that it is tried first for the following payloads. "
+                                   "The initial order is restored for every capture file.",
+                                   &prefs.heur_adaptive_order);
+
+    register_string_like_preference(protocols_module, "field_index",
+            "Fields to index for display filtering",
+            "A comma separated list of fields whose values are recorded for every "
+            "frame when a capture file is read. Display filters that only use "
+            "these fields are then applied without dissecting the packets again. "
+            "Integer, address, string and protocol fields can be indexed. Leave "
+            "empty to disable the index.",
+            &prefs.field_index_fields, PREF_STRING, NULL, TRUE);
+
+    prefs_register_bool_preference(protocols_module, "limit_dissection_to_filter",
+                                   "Only dissect protocols used by the filters",
+                                   "When TShark or sharkd applies a filter without printing the protocol "
+                                   "tree or columns, skip the dissectors that can't lead to a field used "
+                                   "by the filter or printed with -e. Lower layers only reassemble data "
+                                   "for a wanted protocol, so reassembly fields such as tcp.reassembled_in "
+                                   "can differ, and protocols reached through undeclared dependencies can "
+                                   "be missed.",
+                                   &prefs.limit_dissection_to_filter);
+
     /* Obsolete preferences
      * These "modules" were reorganized/renamed to correspond to their GUI
      * configuration screen within the preferences dialog
@@ -4219,6 +4253,11 @@ pre_init_prefs(void)
     prefs.display_byte_fields_with_spaces = FALSE;
     prefs.ignore_dup_frames = FALSE;
     prefs.ignore_dup_frames_cache_entries = 10000;
+    prefs.reassembly_cache_size = 0;
+    g_free(prefs.field_index_fields);
+    prefs.field_index_fields = g_strdup("");
+    prefs.heur_adaptive_order = TRUE;
+    prefs.limit_dissection_to_filter = FALSE;
 
     /* set the default values for the io graph dialog */
     prefs.gui_io_graph_automatic_update = TRUE;
@@ -208,6 +208,10 @@ typedef struct _e_prefs {
   gboolean     strict_conversation_tracking_heuristics;
   gboolean     ignore_dup_frames;
   guint        ignore_dup_frames_cache_entries;
+  guint        reassembly_cache_size;
+  gchar       *field_index_fields;
+  gboolean     heur_adaptive_order;
+  gboolean     limit_dissection_to_filter;
   gboolean     filter_expressions_old;  /* TRUE if old filter expressions preferences were loaded. */
   gboolean     gui_update_enabled;
   software_update_channel_e gui_update_channel;
@@ -31,6 +31,7 @@
 #include <wsutil/filesystem.h>
 #include <wsutil/utf8_entities.h>
 #include <wsutil/str_util.h>
+#include <wsutil/time_util.h>
 #include <wsutil/ws_assert.h>
 #include <ftypes/ftypes.h>
 
@@ -424,25 +425,21 @@ write_fields_proto_tree(output_fields_t* fields, epan_dissect_t *edt, column_inf
 /* Indent to the correct level */
 static void print_indent(int level, FILE *fh)
 {
-    /* Use a buffer pre-filed with spaces */
+    /* Use a buffer pre-filed with spaces; it's written from more than
+       one thread, so it's never changed once it's filled. */
 #define MAX_INDENT 2048
     static char spaces[MAX_INDENT];
-    static gboolean inited = FALSE;
-    if (!inited) {
-        for (int n=0; n < MAX_INDENT; n++) {
-            spaces[n] = ' ';
-        }
-        inited = TRUE;
+    static gsize inited = 0;
+    if (g_once_init_enter(&inited)) {
+        memset(spaces, ' ', sizeof(spaces));
+        g_once_init_leave(&inited, 1);
     }
 
     if (fh == NULL) {
         return;
     }
 
-    /* Temp terminate at right length and write to fh. */
-    spaces[MIN(level*2, MAX_INDENT-1)] ='\0';
-    fputs(spaces, fh);
-    spaces[MIN(level*2, MAX_INDENT-1)] =' ';
+    fwrite(spaces, 1, MIN(level*2, MAX_INDENT-1), fh);
 }
 
 /* Write out a tree's data, and any child nodes, as PDML */
@@ -719,10 +716,10 @@ static void
 write_json_index(json_dumper *dumper, epan_dissect_t *edt)
 {
     char ts[30];
-    struct tm * timeinfo;
+    struct tm tm, *timeinfo;
     gchar* str;
 
-    timeinfo = localtime(&edt->pi.abs_ts.secs);
+    timeinfo = ws_localtime_r(&edt->pi.abs_ts.secs, &tm);
     if (timeinfo != NULL) {
         strftime(ts, sizeof(ts), "%Y-%m-%d", timeinfo);
     } else {
@@ -1788,7 +1785,7 @@ print_escaped_xml(FILE *fh, const char *unescaped_string)
 
 #define ESCAPED_BUFFER_SIZE 256
 #define ESCAPED_BUFFER_LIMIT (ESCAPED_BUFFER_SIZE - (int)sizeof("&quot;"))
-    static char temp_buffer[ESCAPED_BUFFER_SIZE];
+    char        temp_buffer[ESCAPED_BUFFER_SIZE];
     gint        offset = 0;
 
     if (fh == NULL || unescaped_string == NULL) {
@@ -1903,7 +1900,7 @@ pdml_write_field_hex_value(write_pdml_data *pdata, field_info *fi)
 
     if (pd) {
         /* Used fixed buffer where can, otherwise temp malloc */
-        static gchar str_static[129];
+        gchar str_static[129];
         gchar *str = str_static;
         gchar* str_heap = NULL;
         if (fi->length > 64) {
@@ -2286,6 +2283,24 @@ gboolean output_fields_has_cols(output_fields_t* fields)
     return fields->includes_col_fields;
 }
 
+void output_fields_append_hfids(output_fields_t* fields, GArray *hfids)
+{
+    gsize i;
+    int hfid;
+
+    ws_assert(fields);
+    ws_assert(hfids);
+
+    if (fields->fields == NULL)
+        return;
+
+    for (i = 0; i < fields->fields->len; i++) {
+        hfid = proto_registrar_get_id_byname((const gchar *)g_ptr_array_index(fields->fields, i));
+        if (hfid != -1)
+            g_array_append_val(hfids, hfid);
+    }
+}
+
 void write_fields_preamble(output_fields_t* fields, FILE *fh)
 {
     gsize i;
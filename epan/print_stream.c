@@ -286,14 +286,17 @@ static gboolean
 print_line_color_text(print_stream_t *self, int indent, const char *line, const color_t *fg, const color_t *bg)
 {
     static char spaces[MAX_INDENT];
+    static gsize spaces_inited = 0;
     size_t ret;
     output_text *output = (output_text *)self->data;
     unsigned int num_spaces;
     gboolean emit_color = output->isatty && (fg != NULL || bg != NULL);
 
-    /* should be space, if NUL -> initialize */
-    if (!spaces[0])
+    /* Streams can be printed to from more than one thread. */
+    if (g_once_init_enter(&spaces_inited)) {
         memset(spaces, ' ', sizeof(spaces));
+        g_once_init_leave(&spaces_inited, 1);
+    }
 
     if (emit_color) {
         switch (output->color_type) {
@@ -364,6 +364,10 @@ static expert_field ei_string_trailing_characters = EI_INIT;
 static void register_string_errors(void);
 
 static int proto_register_field_init(header_field_info *hfinfo, const int parent);
+static int proto_register_field_id(header_field_info *hfinfo, const int parent);
+static void proto_register_field_name(header_field_info *hfinfo);
+static void tmp_fld_check_assert(header_field_info *hfinfo);
+static void proto_complete_field_registration(protocol_t *protocol);
 
 /* special-case header field used within proto.c */
 static header_field_info hfi_text_only =
@@ -385,6 +389,7 @@ struct _protocol {
 	                                   can be added to a dissector table, but use the
 	                                   parent_proto_id for things like enable/disable */
 	GList      *heur_list;          /* Heuristic dissectors associated with this protocol */
+	GPtrArray  *pending_fields;     /* Fields registered lazily and not yet entered in the name map */
 };
 
 /* List of all protocols */
@@ -447,6 +452,16 @@ static header_field_info *same_name_hfinfo;
 /* Hash table protocol aliases. const char * -> const char * */
 static GHashTable *gpa_protocol_aliases = NULL;
 
+/*
+ * TRUE if fields named after their protocol are only checked and entered
+ * in gpa_name_map when something first looks up a name they could have;
+ * they get their IDs, and can be added to trees, right away.
+ */
+static gboolean lazy_field_registration = FALSE;
+
+/* Number of protocols with fields not yet entered in gpa_name_map */
+static guint protocols_with_pending_fields = 0;
+
 /*
  * We're called repeatedly with the same field name when sorting a column.
  * Cache our last gpa_name_map hit for faster lookups.
@@ -668,11 +683,15 @@ proto_cleanup_base(void)
 			if (protocol->fields) {
 				g_ptr_array_free(protocol->fields, TRUE);
 			}
+			if (protocol->pending_fields) {
+				g_ptr_array_free(protocol->pending_fields, TRUE);
+			}
 			g_list_free(protocol->heur_list);
 		}
 		protocols = g_list_remove(protocols, protocol);
 		g_free(protocol);
 	}
+	protocols_with_pending_fields = 0;
 
 	if (proto_names) {
 		g_hash_table_destroy(proto_names);
@@ -987,7 +1006,41 @@ initialize_prefix(gpointer k, gpointer v, gpointer u _U_) {
 /** Initialize every remaining uninitialized prefix. */
 void
 proto_initialize_all_prefixes(void) {
-	g_hash_table_foreach_remove(prefixes, initialize_prefix, NULL);
+	GList *list;
+
+	if (prefixes)
+		g_hash_table_foreach_remove(prefixes, initialize_prefix, NULL);
+
+	/* Anything that wants every field wants the lazily registered ones too. */
+	for (list = protocols; list != NULL && protocols_with_pending_fields != 0; list = g_list_next(list))
+		proto_complete_field_registration((protocol_t *)list->data);
+}
+
+/*
+ * Complete the registration of the lazily registered fields that could
+ * be named field_name, i.e. those of the protocols whose filter names
+ * are field_name or one of its prefixes ending before a dot; a field is
+ * only registered lazily if it's named after its protocol.
+ */
+static void
+proto_complete_field_registration_for_name(const char *field_name)
+{
+	char       *name = g_strdup(field_name);
+	char       *dot  = name;
+	protocol_t *protocol;
+
+	for (;;) {
+		dot = strchr(dot, '.');
+		if (dot)
+			*dot = '\0';
+		protocol = (protocol_t *)g_hash_table_lookup(proto_filter_names, name);
+		if (protocol && protocol->pending_fields)
+			proto_complete_field_registration(protocol);
+		if (!dot)
+			break;
+		*dot++ = '.';
+	}
+	g_free(name);
 }
 
 /* Finds a record in the hfinfo array by name.
@@ -1009,6 +1062,12 @@ proto_registrar_get_byname(const char *field_name)
 		return last_hfinfo;
 	}
 
+	/* Another protocol may already have registered a field with this
+	 * name, so finish the protocols it could belong to before looking
+	 * it up; otherwise their fields wouldn't be chained to it. */
+	if (protocols_with_pending_fields != 0)
+		proto_complete_field_registration_for_name(field_name);
+
 	hfinfo = (header_field_info *)g_hash_table_lookup(gpa_name_map, field_name);
 
 	if (hfinfo) {
@@ -7857,6 +7916,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->can_toggle = TRUE;
 	protocol->parent_proto_id = -1;
 	protocol->heur_list = NULL;
+	protocol->pending_fields = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -7916,6 +7976,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 
 	protocol->parent_proto_id = parent_proto;
 	protocol->heur_list = NULL;
+	protocol->pending_fields = NULL;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -7952,6 +8013,8 @@ proto_deregister_protocol(const char *short_name)
 	if (protocol == NULL)
 		return FALSE;
 
+	proto_complete_field_registration(protocol);
+
 	g_hash_table_remove(proto_names, protocol->name);
 	g_hash_table_remove(proto_short_names, (gpointer)short_name);
 	g_hash_table_remove(proto_filter_names, (gpointer)protocol->filter_name);
@@ -8382,16 +8445,68 @@ proto_set_cant_toggle(const int proto_id)
 	protocol->can_toggle = FALSE;
 }
 
+/* Is the field's name its protocol's filter name or one starting with it? */
+static gboolean
+field_named_for_protocol(const header_field_info *hfi, const protocol_t *proto)
+{
+	size_t len = strlen(proto->filter_name);
+
+	return hfi->abbrev != NULL &&
+	       strncmp(hfi->abbrev, proto->filter_name, len) == 0 &&
+	       (hfi->abbrev[len] == '\0' || hfi->abbrev[len] == '.');
+}
+
 static int
 proto_register_field_common(protocol_t *proto, header_field_info *hfi, const int parent)
 {
 	if (proto != NULL) {
 		g_ptr_array_add(proto->fields, hfi);
+
+		/*
+		 * Leave checking the field and entering its name until
+		 * something looks up a name it could have; see
+		 * proto_complete_field_registration_for_name().
+		 */
+		if (lazy_field_registration && field_named_for_protocol(hfi, proto)) {
+			if (proto->pending_fields == NULL) {
+				proto->pending_fields = g_ptr_array_new();
+				protocols_with_pending_fields++;
+			}
+			g_ptr_array_add(proto->pending_fields, hfi);
+			return proto_register_field_id(hfi, parent);
+		}
 	}
 
 	return proto_register_field_init(hfi, parent);
 }
 
+/* Check the protocol's lazily registered fields and enter their names. */
+static void
+proto_complete_field_registration(protocol_t *protocol)
+{
+	GPtrArray *pending = protocol->pending_fields;
+	guint      i;
+
+	if (pending == NULL)
+		return;
+
+	protocol->pending_fields = NULL;
+	protocols_with_pending_fields--;
+	for (i = 0; i < pending->len; i++) {
+		header_field_info *hfinfo = (header_field_info *)g_ptr_array_index(pending, i);
+
+		tmp_fld_check_assert(hfinfo);
+		proto_register_field_name(hfinfo);
+	}
+	g_ptr_array_free(pending, TRUE);
+}
+
+void
+proto_set_lazy_field_registration(gboolean lazy)
+{
+	lazy_field_registration = lazy;
+}
+
 /* for use with static arrays only, since we don't allocate our own copies
 of the header_field_info struct contained within the hf_register_info struct */
 void
@@ -8445,6 +8560,7 @@ proto_deregister_field (const int parent, gint hf_id)
 	if (!proto || proto->fields == NULL) {
 		return;
 	}
+	proto_complete_field_registration(proto);
 
 	for (i = 0; i < proto->fields->len; i++) {
 		hfi = (header_field_info *)g_ptr_array_index(proto->fields, i);
@@ -9325,9 +9441,19 @@ register_string_errors(void)
 static int
 proto_register_field_init(header_field_info *hfinfo, const int parent)
 {
+	int id;
 
 	tmp_fld_check_assert(hfinfo);
 
+	id = proto_register_field_id(hfinfo, parent);
+	proto_register_field_name(hfinfo);
+	return id;
+}
+
+/* Give a field its ID. */
+static int
+proto_register_field_id(header_field_info *hfinfo, const int parent)
+{
 	hfinfo->parent         = parent;
 	hfinfo->same_name_next = NULL;
 	hfinfo->same_name_prev_id = -1;
@@ -9348,6 +9474,13 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 	gpa_hfinfo.len++;
 	hfinfo->id = gpa_hfinfo.len - 1;
 
+	return hfinfo->id;
+}
+
+/* Enter a field, which has its ID, in the name map. */
+static void
+proto_register_field_name(header_field_info *hfinfo)
+{
 	/* if we have real names, enter this field in the name tree */
 	if ((hfinfo->name[0] != 0) && (hfinfo->abbrev[0] != 0 )) {
 
@@ -9381,7 +9514,29 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 		/* GLIB 2.x - if it is already present
 		 * the previous hfinfo with the same name is saved
 		 * to same_name_hfinfo by value destroy callback */
-		if (same_name_hfinfo) {
+		if (same_name_hfinfo && hfinfo->id < same_name_hfinfo->id) {
+			/* A lazily registered field entered after a
+			 * field with the same name that got its ID
+			 * later.  Put it where it would have gone if
+			 * it had been registered right away, so that
+			 * the list is in ID order and the hash keeps
+			 * the field with the highest ID.
+			 */
+			header_field_info *last_hfinfo_same_name = same_name_hfinfo;
+
+			same_name_next_hfinfo = last_hfinfo_same_name;
+			while (same_name_next_hfinfo->same_name_prev_id > hfinfo->id)
+				same_name_next_hfinfo = hfinfo_same_name_get_prev(same_name_next_hfinfo);
+
+			hfinfo->same_name_prev_id = same_name_next_hfinfo->same_name_prev_id;
+			if (hfinfo->same_name_prev_id != -1)
+				hfinfo_same_name_get_prev(hfinfo)->same_name_next = hfinfo;
+			hfinfo->same_name_next = same_name_next_hfinfo;
+			same_name_next_hfinfo->same_name_prev_id = hfinfo->id;
+
+			g_hash_table_insert(gpa_name_map, (gpointer) (last_hfinfo_same_name->abbrev), last_hfinfo_same_name);
+			same_name_hfinfo = hfinfo->same_name_next;
+		} else if (same_name_hfinfo) {
 			/* There's already a field with this name.
 			 * Put the current field *before* that field
 			 * in the list of fields with this name, Thus,
@@ -9399,17 +9554,15 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 
 			same_name_hfinfo->same_name_next = hfinfo;
 			hfinfo->same_name_prev_id = same_name_hfinfo->id;
+		}
 #ifdef ENABLE_CHECK_FILTER
-			while (same_name_hfinfo) {
-				if (_ftype_common(hfinfo->type) != _ftype_common(same_name_hfinfo->type))
-					ws_warning("'%s' exists multiple times with incompatible types: %s and %s", hfinfo->abbrev, ftype_name(hfinfo->type), ftype_name(same_name_hfinfo->type));
-				same_name_hfinfo = same_name_hfinfo->same_name_next;
-			}
-#endif
+		while (same_name_hfinfo) {
+			if (_ftype_common(hfinfo->type) != _ftype_common(same_name_hfinfo->type))
+				ws_warning("'%s' exists multiple times with incompatible types: %s and %s", hfinfo->abbrev, ftype_name(hfinfo->type), ftype_name(same_name_hfinfo->type));
+			same_name_hfinfo = same_name_hfinfo->same_name_next;
 		}
+#endif
 	}
-
-	return hfinfo->id;
 }
 
 void
@@ -9837,6 +9990,73 @@ proto_item_fill_label(field_info *fi, gchar *label_str)
 	}
 }
 
+/* Whether the label of a field depends on state outside its tree that
+ * dissection changes, or that's set up the first time it's used. */
+static gboolean
+label_uses_shared_state(const header_field_info *hfinfo)
+{
+	switch (hfinfo->type) {
+		case FT_ETHER:
+		case FT_IPv4:
+		case FT_IPv6:
+		case FT_IPXNET:
+		case FT_FCWWN:
+		case FT_EUI64:
+		case FT_OID:
+		case FT_REL_OID:
+			/* Resolved names */
+			return TRUE;
+
+		case FT_FLOAT:
+		case FT_DOUBLE:
+			return FIELD_DISPLAY(hfinfo->display) == BASE_CUSTOM;
+
+		case FT_FRAMENUM:
+			return FALSE;
+
+		default:
+			break;
+	}
+
+	if (!FT_IS_INTEGER(hfinfo->type))
+		return FALSE;
+
+	if (hfinfo->display & BASE_EXT_STRING)
+		return TRUE;
+
+	switch (FIELD_DISPLAY(hfinfo->display)) {
+		case BASE_CUSTOM:
+		case BASE_PT_UDP:
+		case BASE_PT_TCP:
+		case BASE_PT_DCCP:
+		case BASE_PT_SCTP:
+		case BASE_OUI:
+			return TRUE;
+
+		default:
+			return FALSE;
+	}
+}
+
+static void
+proto_tree_fill_shared_labels_node(proto_node *node, gpointer data _U_)
+{
+	field_info *fi = PNODE_FINFO(node);
+
+	if (fi && !fi->rep && label_uses_shared_state(fi->hfinfo)) {
+		ITEM_LABEL_NEW(PNODE_POOL(node), fi->rep);
+		proto_item_fill_label(fi, fi->rep->representation);
+	}
+
+	proto_tree_children_foreach(node, proto_tree_fill_shared_labels_node, NULL);
+}
+
+void
+proto_tree_fill_shared_labels(proto_tree *tree)
+{
+	proto_tree_children_foreach(tree, proto_tree_fill_shared_labels_node, NULL);
+}
+
 static void
 fill_label_boolean(field_info *fi, gchar *label_str)
 {
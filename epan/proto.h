@@ -2516,6 +2516,15 @@ proto_tree_add_debug_text(proto_tree *tree, const char *format,
 WS_DLL_PUBLIC void
 proto_item_fill_label(field_info *finfo, gchar *label_str);
 
+/** Fill in, now, the labels of the items in a tree that would otherwise
+ * be formatted from state outside the tree: resolved names, custom
+ * formatting functions and extended value strings. The tree can then be
+ * printed on another thread while this one goes on dissecting, and it
+ * gets the labels it would have had if it were printed right away.
+ @param tree the tree whose items to label */
+WS_DLL_PUBLIC void
+proto_tree_fill_shared_labels(proto_tree *tree);
+
 /** Fill the given display_label_str with the string representation of a field
  * formatted according to its type and field display specifier.
  * Used to display custom columns and packet diagram values.
@@ -2583,9 +2592,20 @@ typedef void (*prefix_initializer_t)(const char* match);
 WS_DLL_PUBLIC void
 proto_register_prefix(const char *prefix,  prefix_initializer_t initializer);
 
-/** Initialize every remaining uninitialized prefix. */
+/** Initialize every remaining uninitialized prefix, and finish
+    registering every field registered lazily. */
 WS_DLL_PUBLIC void proto_initialize_all_prefixes(void);
 
+/** Register fields lazily from now on. Fields named after their protocol
+    get their IDs, and can be added to trees, right away, but aren't checked
+    or entered in the table of field names until something looks up a name
+    one of them could have. This saves startup time for programs that look up
+    only a few fields by name; errors in a field's registration show up only
+    when it's looked up. Programs that list every field have to call
+    proto_initialize_all_prefixes() first.
+ @param lazy TRUE to register fields lazily */
+WS_DLL_PUBLIC void proto_set_lazy_field_registration(gboolean lazy);
+
 /** Register a header_field array.
  @param parent the protocol handle from proto_register_protocol()
  @param hf the hf_register_info array
@@ -10,6 +10,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <epan/wmem_scopes.h>
@@ -26,73 +28,176 @@ typedef struct _proto_data {
   void *proto_data;
 } proto_data_t;
 
+/* An entry in the hash table form of the list; entries added with
+   p_add_proto_data() with the same protocol and key as an existing
+   one hide it until they're removed. */
+typedef struct _proto_data_node {
+  proto_data_t pd;
+  struct _proto_data_node *hidden;
+} proto_data_node_t;
+
+/* The protocol data for a packet or frame. Most have only a handful of
+   entries, which are kept in an array sorted by protocol and key, with
+   the most recently added of any duplicates first; past
+   PROTO_DATA_MAX_SORTED entries it's replaced by a hash table. */
+typedef struct _proto_data_list {
+  wmem_allocator_t  *scope;
+  guint              count;
+  guint              size;
+  proto_data_t      *items;
+  wmem_map_t        *map;
+} proto_data_list_t;
+
+#define PROTO_DATA_INITIAL_SIZE  4
+#define PROTO_DATA_MAX_SORTED   32
+
 static gint
-p_compare(gconstpointer a, gconstpointer b)
+p_compare(const proto_data_t *ap, int proto, guint32 key)
+{
+  if (ap->proto != proto)
+    return ap->proto > proto ? 1 : -1;
+  if (ap->key != key)
+    return ap->key > key ? 1 : -1;
+  return 0;
+}
+
+static guint
+p_hash(gconstpointer k)
+{
+  const proto_data_t *pd = (const proto_data_t *)k;
+
+  return ((guint)pd->proto * 2654435761U) ^ pd->key;
+}
+
+static gboolean
+p_equal(gconstpointer a, gconstpointer b)
 {
   const proto_data_t *ap = (const proto_data_t *)a;
   const proto_data_t *bp = (const proto_data_t *)b;
 
-  if (ap -> proto > bp -> proto) {
-    return 1;
-  } else if (ap -> proto == bp -> proto) {
-    if (ap->key > bp->key){
-      return 1;
-    } else if (ap -> key == bp -> key) {
-      return 0;
-    }
-    return -1;
-  } else {
-    return -1;
-  }
+  return ap->proto == bp->proto && ap->key == bp->key;
 }
 
-void
-p_add_proto_data(wmem_allocator_t *tmp_scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
+static proto_data_list_t **
+p_get_list_ptr(wmem_allocator_t *scope, struct _packet_info* pinfo)
 {
-  proto_data_t     *p1;
-  GSList          **proto_list;
-  wmem_allocator_t *scope;
-
-  if (tmp_scope == pinfo->pool) {
-    scope = tmp_scope;
-    proto_list = &pinfo->proto_data;
-  } else if (tmp_scope == wmem_file_scope()) {
-    scope = wmem_file_scope();
-    proto_list = &pinfo->fd->pfd;
+  if (scope == pinfo->pool) {
+    return &pinfo->proto_data;
+  } else if (scope == wmem_file_scope()) {
+    return &pinfo->fd->pfd;
   } else {
     DISSECTOR_ASSERT(!"invalid wmem scope");
   }
+  return NULL;
+}
 
-  p1 = wmem_new(scope, proto_data_t);
+/* Find the first entry that isn't less than (proto, key). */
+static guint
+p_lower_bound(const proto_data_list_t *list, int proto, guint32 key)
+{
+  guint lo = 0, hi = list->count, mid;
+
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (p_compare(&list->items[mid], proto, key) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static proto_data_t *
+p_find(proto_data_list_t *list, int proto, guint32 key)
+{
+  proto_data_t  temp;
+  guint         i;
+
+  if (list == NULL)
+    return NULL;
+
+  if (list->map) {
+    temp.proto = proto;
+    temp.key = key;
+    return (proto_data_t *)wmem_map_lookup(list->map, &temp);
+  }
+
+  i = p_lower_bound(list, proto, key);
+  if (i < list->count && p_compare(&list->items[i], proto, key) == 0)
+    return &list->items[i];
+  return NULL;
+}
 
-  p1->proto = proto;
-  p1->key = key;
-  p1->proto_data = proto_data;
+static void
+p_insert_node(proto_data_list_t *list, int proto, guint32 key, void *proto_data)
+{
+  proto_data_node_t *node;
 
-  /* Add it to the GSLIST */
-  *proto_list = g_slist_prepend(*proto_list, p1);
+  node = wmem_new(list->scope, proto_data_node_t);
+  node->pd.proto = proto;
+  node->pd.key = key;
+  node->pd.proto_data = proto_data;
+  node->hidden = (proto_data_node_t *)wmem_map_insert(list->map, &node->pd, node);
+}
+
+/* Move the entries into a hash table, oldest first so that the newest
+   of any duplicates ends up on top. */
+static void
+p_make_map(proto_data_list_t *list)
+{
+  guint  i;
+
+  list->map = wmem_map_new(list->scope, p_hash, p_equal);
+  for (i = list->count; i-- > 0; )
+    p_insert_node(list, list->items[i].proto, list->items[i].key, list->items[i].proto_data);
+  wmem_free(list->scope, list->items);
+  list->items = NULL;
+  list->size = 0;
 }
 
 void
-p_set_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
+p_add_proto_data(wmem_allocator_t *tmp_scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
 {
-  proto_data_t  temp;
-  GSList       *item;
+  proto_data_list_t **list_ptr = p_get_list_ptr(tmp_scope, pinfo);
+  proto_data_list_t  *list = *list_ptr;
+  guint               i;
+
+  if (list == NULL) {
+    list = wmem_new0(tmp_scope, proto_data_list_t);
+    list->scope = tmp_scope;
+    *list_ptr = list;
+  }
 
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
+  if (list->map == NULL && list->count == PROTO_DATA_MAX_SORTED)
+    p_make_map(list);
 
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
+  if (list->map) {
+    p_insert_node(list, proto, key, proto_data);
+    list->count++;
+    return;
   }
 
-  if (item) {
-    proto_data_t *pd = (proto_data_t *)item->data;
+  if (list->count == list->size) {
+    list->size = list->size ? list->size * 2 : PROTO_DATA_INITIAL_SIZE;
+    list->items = (proto_data_t *)wmem_realloc(list->scope, list->items, list->size * sizeof(proto_data_t));
+  }
+
+  /* Put it ahead of any entries with the same protocol and key */
+  i = p_lower_bound(list, proto, key);
+  memmove(&list->items[i + 1], &list->items[i], (list->count - i) * sizeof(proto_data_t));
+  list->items[i].proto = proto;
+  list->items[i].key = key;
+  list->items[i].proto_data = proto_data;
+  list->count++;
+}
+
+void
+p_set_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key, void *proto_data)
+{
+  proto_data_t  *pd;
+
+  pd = p_find(*p_get_list_ptr(scope, pinfo), proto, key);
+  if (pd) {
     pd->proto_data = proto_data;
     return;
   }
@@ -103,24 +208,11 @@ p_set_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto,
 void *
 p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key)
 {
-  proto_data_t  temp, *p1;
-  GSList       *item;
+  proto_data_t  *pd;
 
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
-
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-  } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
-  }
-
-  if (item) {
-    p1 = (proto_data_t *)item->data;
-    return p1->proto_data;
+  pd = p_find(*p_get_list_ptr(scope, pinfo), proto, key);
+  if (pd) {
+    return pd->proto_data;
   }
 
   return NULL;
@@ -129,42 +221,70 @@ p_get_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto,
 void
 p_remove_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key)
 {
-  proto_data_t  temp;
-  GSList       *item;
-  GSList      **proto_list;
+  proto_data_list_t  *list = *p_get_list_ptr(scope, pinfo);
+  proto_data_t       *pd;
+  proto_data_node_t  *node;
+  guint               i;
 
-  temp.proto = proto;
-  temp.key = key;
-  temp.proto_data = NULL;
+  pd = p_find(list, proto, key);
+  if (pd == NULL)
+    return;
 
-  if (scope == pinfo->pool) {
-    item = g_slist_find_custom(pinfo->proto_data, &temp, p_compare);
-    proto_list = &pinfo->proto_data;
-  } else if (scope == wmem_file_scope()) {
-    item = g_slist_find_custom(pinfo->fd->pfd, &temp, p_compare);
-    proto_list = &pinfo->fd->pfd;
+  if (list->map) {
+    /* Uncover the entry this one was hiding, if any */
+    node = (proto_data_node_t *)pd;
+    if (node->hidden)
+      wmem_map_insert(list->map, &node->hidden->pd, node->hidden);
+    else
+      wmem_map_remove(list->map, pd);
   } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
+    i = (guint)(pd - list->items);
+    memmove(&list->items[i], &list->items[i + 1], (list->count - i - 1) * sizeof(proto_data_t));
   }
+  list->count--;
+}
+
+guint
+p_get_proto_data_count(wmem_allocator_t *scope, struct _packet_info* pinfo)
+{
+  proto_data_list_t  *list = *p_get_list_ptr(scope, pinfo);
 
-  if (item) {
-    *proto_list = g_slist_remove(*proto_list, item->data);
+  return list ? list->count : 0;
+}
+
+typedef struct {
+  guint                    index;
+  const proto_data_t      *found;
+} p_nth_data_t;
+
+static void
+p_nth_cb(gpointer key _U_, gpointer value, gpointer user_data)
+{
+  p_nth_data_t       *nth = (p_nth_data_t *)user_data;
+  proto_data_node_t  *node;
+
+  for (node = (proto_data_node_t *)value; node != NULL; node = node->hidden) {
+    if (nth->index-- == 0)
+      nth->found = &node->pd;
   }
 }
 
 gchar *
 p_get_proto_name_and_key(wmem_allocator_t *scope, struct _packet_info* pinfo, guint pfd_index){
-  proto_data_t  *temp;
+  proto_data_list_t  *list = *p_get_list_ptr(scope, pinfo);
+  p_nth_data_t        nth;
 
-  if (scope == pinfo->pool) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->proto_data, pfd_index);
-  } else if (scope == wmem_file_scope()) {
-    temp = (proto_data_t *)g_slist_nth_data(pinfo->fd->pfd, pfd_index);
+  DISSECTOR_ASSERT(list != NULL && pfd_index < list->count);
+
+  if (list->map) {
+    nth.index = pfd_index;
+    nth.found = NULL;
+    wmem_map_foreach(list->map, p_nth_cb, &nth);
   } else {
-    DISSECTOR_ASSERT(!"invalid wmem scope");
+    nth.found = &list->items[pfd_index];
   }
 
-  return wmem_strdup_printf(pinfo->pool, "[%s, key %u]",proto_get_protocol_name(temp->proto), temp->key);
+  return wmem_strdup_printf(pinfo->pool, "[%s, key %u]",proto_get_protocol_name(nth.found->proto), nth.found->key);
 }
 
 #define PROTO_DEPTH_KEY 0x3c233fb5 // printf "0x%02x%02x\n" ${RANDOM} ${RANDOM}
@@ -86,6 +86,16 @@ WS_DLL_PUBLIC void *p_get_proto_data(wmem_allocator_t *scope, struct _packet_inf
  */
 WS_DLL_PUBLIC void p_remove_proto_data(wmem_allocator_t *scope, struct _packet_info* pinfo, int proto, guint32 key);
 
+/**
+ * Get the number of entries in the protocol data list, including any
+ * hidden by a more recently added entry with the same protocol and key.
+ *
+ * @param scope The memory scope, either pinfo->pool or wmem_file_scope().
+ * @param pinfo This dissection's packet info.
+ * @return The number of entries.
+ */
+WS_DLL_PUBLIC guint p_get_proto_data_count(wmem_allocator_t *scope, struct _packet_info* pinfo);
+
 gchar *p_get_proto_name_and_key(wmem_allocator_t *scope, struct _packet_info* pinfo, guint pfd_index);
 
 /**
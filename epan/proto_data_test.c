@@ -0,0 +1,285 @@
+/* proto_data_test.c
+ * Per-packet and per-frame protocol data tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#undef G_DISABLE_ASSERT
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/packet.h>
+#include <epan/proto_data.h>
+#include <wiretap/wtap.h>
+#include <wsutil/filesystem.h>
+
+typedef struct {
+    frame_data fd;
+    packet_info pinfo;
+} test_packet_t;
+
+static void
+test_packet_init(test_packet_t *pkt)
+{
+    memset(pkt, 0, sizeof(*pkt));
+    pkt->pinfo.fd = &pkt->fd;
+    pkt->pinfo.pool = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+}
+
+static void
+test_packet_cleanup(test_packet_t *pkt)
+{
+    wmem_destroy_allocator(pkt->pinfo.pool);
+}
+
+static wmem_allocator_t *
+test_scope(test_packet_t *pkt, gboolean file_scope)
+{
+    return file_scope ? wmem_file_scope() : pkt->pinfo.pool;
+}
+
+static void
+test_proto_data_basic(gconstpointer user_data)
+{
+    gboolean file_scope = GPOINTER_TO_INT(user_data);
+    test_packet_t pkt;
+    wmem_allocator_t *scope;
+    int a = 1, b = 2, c = 3;
+
+    test_packet_init(&pkt);
+    scope = test_scope(&pkt, file_scope);
+
+    g_assert_null(p_get_proto_data(scope, &pkt.pinfo, 10, 0));
+    p_remove_proto_data(scope, &pkt.pinfo, 10, 0);
+
+    p_add_proto_data(scope, &pkt.pinfo, 10, 0, &a);
+    p_add_proto_data(scope, &pkt.pinfo, 10, 1, &b);
+    p_add_proto_data(scope, &pkt.pinfo, 11, 0, &c);
+    g_assert_true(p_get_proto_data(scope, &pkt.pinfo, 10, 0) == &a);
+    g_assert_true(p_get_proto_data(scope, &pkt.pinfo, 10, 1) == &b);
+    g_assert_true(p_get_proto_data(scope, &pkt.pinfo, 11, 0) == &c);
+    g_assert_null(p_get_proto_data(scope, &pkt.pinfo, 11, 1));
+    g_assert_null(p_get_proto_data(scope, &pkt.pinfo, 9, 0));
+
+    /* The other scope is separate. */
+    g_assert_null(p_get_proto_data(test_scope(&pkt, !file_scope), &pkt.pinfo, 10, 0));
+
+    p_set_proto_data(scope, &pkt.pinfo, 10, 1, &c);
+    g_assert_true(p_get_proto_data(scope, &pkt.pinfo, 10, 1) == &c);
+    g_assert_cmpuint(p_get_proto_data_count(scope, &pkt.pinfo), ==, 3);
+
+    p_remove_proto_data(scope, &pkt.pinfo, 10, 0);
+    g_assert_null(p_get_proto_data(scope, &pkt.pinfo, 10, 0));
+    g_assert_true(p_get_proto_data(scope, &pkt.pinfo, 10, 1) == &c);
+    g_assert_cmpuint(p_get_proto_data_count(scope, &pkt.pinfo), ==, 2);
+
+    test_packet_cleanup(&pkt);
+}
+
+/*
+ * Compare against a model of the original implementation, a list with
+ * the most recently added entries first, with enough keys that the
+ * data changes form along the way.
+ */
+#define MODEL_OPS   20000
+#define MODEL_PROTOS 6
+#define MODEL_KEYS  12
+
+typedef struct {
+    int proto;
+    guint32 key;
+    void *data;
+} model_entry_t;
+
+static model_entry_t *
+model_find(GArray *model, int proto, guint32 key)
+{
+    for (guint i = 0; i < model->len; i++) {
+        model_entry_t *entry = &g_array_index(model, model_entry_t, i);
+        if (entry->proto == proto && entry->key == key)
+            return entry;
+    }
+    return NULL;
+}
+
+static void
+test_proto_data_model(gconstpointer user_data)
+{
+    gboolean file_scope = GPOINTER_TO_INT(user_data);
+    test_packet_t pkt;
+    wmem_allocator_t *scope;
+    GArray *model;
+    GRand *rand;
+    model_entry_t entry, *found;
+    guint8 values[256];
+
+    test_packet_init(&pkt);
+    scope = test_scope(&pkt, file_scope);
+    model = g_array_new(FALSE, FALSE, sizeof(model_entry_t));
+    rand = g_rand_new_with_seed(43);
+
+    for (int i = 0; i < MODEL_OPS; i++) {
+        int proto = g_rand_int_range(rand, 1, MODEL_PROTOS + 1);
+        guint32 key = g_rand_int_range(rand, 0, MODEL_KEYS);
+        void *data = &values[g_rand_int_range(rand, 0, (gint32)G_N_ELEMENTS(values))];
+        guint32 op = g_rand_int_range(rand, 0, 10);
+
+        /* Adds and sets outnumber removes, so the list grows from the
+         * sorted array into the hash table along the way. */
+        if (op < 3) {
+            p_add_proto_data(scope, &pkt.pinfo, proto, key, data);
+            entry.proto = proto;
+            entry.key = key;
+            entry.data = data;
+            g_array_prepend_val(model, entry);
+        } else if (op < 5) {
+            p_set_proto_data(scope, &pkt.pinfo, proto, key, data);
+            found = model_find(model, proto, key);
+            if (found) {
+                found->data = data;
+            } else {
+                entry.proto = proto;
+                entry.key = key;
+                entry.data = data;
+                g_array_prepend_val(model, entry);
+            }
+        } else if (op < 7) {
+            p_remove_proto_data(scope, &pkt.pinfo, proto, key);
+            found = model_find(model, proto, key);
+            if (found)
+                g_array_remove_index(model, (guint)(found - (model_entry_t *)(void *)model->data));
+        } else {
+            found = model_find(model, proto, key);
+            g_assert_true(p_get_proto_data(scope, &pkt.pinfo, proto, key) == (found ? found->data : NULL));
+        }
+        g_assert_cmpuint(p_get_proto_data_count(scope, &pkt.pinfo), ==, model->len);
+    }
+
+    for (int proto = 1; proto <= MODEL_PROTOS; proto++) {
+        for (guint32 key = 0; key < MODEL_KEYS; key++) {
+            found = model_find(model, proto, key);
+            g_assert_true(p_get_proto_data(scope, &pkt.pinfo, proto, key) == (found ? found->data : NULL));
+        }
+    }
+
+    g_rand_free(rand);
+    g_array_free(model, TRUE);
+    test_packet_cleanup(&pkt);
+}
+
+/*
+ * Time the lookups made when frames are dissected again, for frames
+ * with a few entries and with a deep stack's worth; each pass looks
+ * up every entry of every frame a few times, as TCP, TLS and HTTP/2
+ * do.
+ */
+#define PERF_FRAMES     1000
+#define PERF_PASSES     20
+#define PERF_LOOKUPS    3
+
+static void
+proto_data_perf(guint entries)
+{
+    test_packet_t *pkts = g_new(test_packet_t, PERF_FRAMES);
+    guint64 found = 0;
+    gdouble elapsed;
+    guint lookups;
+
+    for (guint f = 0; f < PERF_FRAMES; f++) {
+        test_packet_init(&pkts[f]);
+        for (guint e = 0; e < entries; e++) {
+            p_add_proto_data(wmem_file_scope(), &pkts[f].pinfo, 100 + e / 4, e % 4, GUINT_TO_POINTER(e + 1));
+        }
+    }
+
+    g_test_timer_start();
+    for (guint pass = 0; pass < PERF_PASSES; pass++) {
+        for (guint f = 0; f < PERF_FRAMES; f++) {
+            for (guint e = 0; e < entries; e++) {
+                for (guint l = 0; l < PERF_LOOKUPS; l++) {
+                    found += GPOINTER_TO_UINT(p_get_proto_data(wmem_file_scope(), &pkts[f].pinfo, 100 + e / 4, e % 4)) != 0;
+                }
+            }
+        }
+    }
+    elapsed = g_test_timer_elapsed();
+
+    lookups = PERF_PASSES * PERF_FRAMES * entries * PERF_LOOKUPS;
+    g_assert_cmpuint(found, ==, lookups);
+    g_test_minimized_result(elapsed * 1e9 / lookups,
+                            "%u entries per frame: %.1f ns per lookup",
+                            entries, elapsed * 1e9 / lookups);
+
+    for (guint f = 0; f < PERF_FRAMES; f++) {
+        test_packet_cleanup(&pkts[f]);
+    }
+    g_free(pkts);
+}
+
+static void
+test_proto_data_perf(void)
+{
+    proto_data_perf(4);
+    proto_data_perf(16);
+    proto_data_perf(40);
+}
+
+int
+main(int argc, char **argv)
+{
+    static const struct packet_provider_funcs funcs;
+    epan_t *session;
+    int result;
+    char *err;
+
+    g_test_init(&argc, &argv, NULL);
+
+    err = configuration_init(argv[0], NULL);
+    if (err != NULL) {
+        fprintf(stderr, "Can't get pathname of directory containing the test program: %s.\n", err);
+        g_free(err);
+    }
+    wtap_init(FALSE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    /* Enters the file scope */
+    session = epan_new(NULL, &funcs);
+
+    g_test_add_data_func("/proto_data/packet/basic", GINT_TO_POINTER(FALSE), test_proto_data_basic);
+    g_test_add_data_func("/proto_data/frame/basic", GINT_TO_POINTER(TRUE), test_proto_data_basic);
+    g_test_add_data_func("/proto_data/packet/model", GINT_TO_POINTER(FALSE), test_proto_data_model);
+    g_test_add_data_func("/proto_data/frame/model", GINT_TO_POINTER(TRUE), test_proto_data_model);
+
+    if (g_test_perf()) {
+        g_test_add_func("/proto_data/lookup_perf", test_proto_data_perf);
+    }
+
+    result = g_test_run();
+
+    epan_free(session);
+    epan_cleanup();
+    wtap_cleanup();
+
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,179 @@
+/* proto_lazy_test.c
+ * Lazy field registration tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#undef G_DISABLE_ASSERT
+
+#include <stdio.h>
+#include <glib.h>
+
+#include <epan/epan.h>
+#include <epan/packet.h>
+#include <epan/proto.h>
+#include <wiretap/wtap.h>
+#include <wsutil/filesystem.h>
+
+static int proto_lazytest = -1;
+static int proto_lazytest_sub = -1;
+static int proto_lazyother = -1;
+
+static int hf_lazytest_a = -1;
+static int hf_lazytest_dup_8 = -1;
+static int hf_lazytest_dup_16 = -1;
+static int hf_lazyother_b = -1;
+static int hf_lazytest_sub_c = -1;
+static int hf_lazytest_shared = -1;
+static int hf_lazyother_shared = -1;
+
+static void
+register_test_protocols(void)
+{
+    static hf_register_info hf[] = {
+        { &hf_lazytest_a,
+          { "A", "lazytest.a", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_lazytest_dup_8,
+          { "Dup", "lazytest.dup", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_lazytest_dup_16,
+          { "Dup", "lazytest.dup", FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        /* Not named after its protocol, so it's registered right away. */
+        { &hf_lazyother_b,
+          { "B", "lazyother.b", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+        { &hf_lazytest_shared,
+          { "Shared", "lazytest.shared", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+    };
+    static hf_register_info hf_other[] = {
+        { &hf_lazyother_shared,
+          { "Shared", "lazytest.shared", FT_UINT16, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+    };
+    static hf_register_info hf_sub[] = {
+        { &hf_lazytest_sub_c,
+          { "C", "lazytest.sub.c", FT_UINT8, BASE_DEC, NULL, 0x0, NULL, HFILL }},
+    };
+
+    proto_lazytest = proto_register_protocol("Lazy Test", "LAZYTEST", "lazytest");
+    proto_register_field_array(proto_lazytest, hf, array_length(hf));
+    proto_lazytest_sub = proto_register_protocol("Lazy Test Sub", "LAZYTEST-SUB", "lazytest.sub");
+    proto_register_field_array(proto_lazytest_sub, hf_sub, array_length(hf_sub));
+    /* Gets a later ID than lazytest's own field of the same name, but
+     * is entered in the name map first. */
+    proto_lazyother = proto_register_protocol("Lazy Other", "LAZYOTHER", "lazyother");
+    proto_register_field_array(proto_lazyother, hf_other, array_length(hf_other));
+}
+
+static void
+test_lazy_ids(void)
+{
+    /* The fields can be added to trees before anything looks them up. */
+    g_assert_cmpint(hf_lazytest_a, >, 0);
+    g_assert_cmpint(hf_lazytest_dup_8, >, 0);
+    g_assert_cmpint(hf_lazytest_dup_16, >, 0);
+    g_assert_cmpint(hf_lazyother_b, >, 0);
+    g_assert_cmpint(hf_lazytest_sub_c, >, 0);
+    g_assert_cmpstr(proto_registrar_get_nth(hf_lazytest_a)->abbrev, ==, "lazytest.a");
+    g_assert_cmpint(proto_registrar_get_parent(hf_lazytest_a), ==, proto_lazytest);
+}
+
+static void
+test_lazy_lookup(void)
+{
+    header_field_info *hfinfo;
+
+    /* A field of another protocol with the same name was registered in
+     * full first; looking it up must still complete lazytest's fields,
+     * so this has to be the first lazytest lookup. */
+    g_assert_cmpint(hf_lazytest_shared, <, hf_lazyother_shared);
+    hfinfo = proto_registrar_get_byname("lazytest.shared");
+    g_assert_nonnull(hfinfo);
+    g_assert_cmpint(hfinfo->id, ==, hf_lazyother_shared);
+    g_assert_cmpint(hfinfo->same_name_prev_id, ==, hf_lazytest_shared);
+    g_assert_null(hfinfo->same_name_next);
+    hfinfo = proto_registrar_get_nth(hf_lazytest_shared);
+    g_assert_cmpint(hfinfo->same_name_prev_id, ==, -1);
+    g_assert_true(hfinfo->same_name_next == proto_registrar_get_nth(hf_lazyother_shared));
+
+    g_assert_cmpint(proto_registrar_get_id_byname("lazytest.a"), ==, hf_lazytest_a);
+    g_assert_cmpint(proto_registrar_get_id_byname("lazyother.b"), ==, hf_lazyother_b);
+    g_assert_cmpint(proto_registrar_get_id_byname("lazytest.sub.c"), ==, hf_lazytest_sub_c);
+    g_assert_cmpint(proto_registrar_get_id_byname("lazytest"), ==, proto_lazytest);
+    g_assert_cmpint(proto_registrar_get_id_byname("lazytest.nonexistent"), ==, -1);
+
+    /* Fields with the same name are linked as if registered up front. */
+    hfinfo = proto_registrar_get_byname("lazytest.dup");
+    g_assert_nonnull(hfinfo);
+    g_assert_cmpint(hfinfo->id, ==, hf_lazytest_dup_16);
+    g_assert_cmpint(hfinfo->same_name_prev_id, ==, hf_lazytest_dup_8);
+    g_assert_null(proto_registrar_get_nth(hf_lazytest_dup_8)->same_name_next->same_name_next);
+
+    /* So are the fields of protocols no one looked up yet. */
+    g_assert_cmpint(proto_registrar_get_id_byname("tcp.srcport"), >, 0);
+    g_assert_cmpint(proto_registrar_get_id_byname("ip.addr"), >, 0);
+}
+
+static void
+test_lazy_complete_perf(void)
+{
+    gdouble elapsed;
+
+    /* This is the work lazy registration saves at startup. */
+    g_test_timer_start();
+    proto_initialize_all_prefixes();
+    elapsed = g_test_timer_elapsed();
+
+    g_assert_cmpint(proto_registrar_get_id_byname("udp.port"), >, 0);
+    g_test_minimized_result(elapsed * 1e3,
+                            "completing lazy registration: %.1f ms", elapsed * 1e3);
+}
+
+int
+main(int argc, char **argv)
+{
+    int result;
+    char *err;
+
+    g_test_init(&argc, &argv, NULL);
+
+    err = configuration_init(argv[0], NULL);
+    if (err != NULL) {
+        fprintf(stderr, "Can't get pathname of directory containing the test program: %s.\n", err);
+        g_free(err);
+    }
+    wtap_init(FALSE);
+    proto_set_lazy_field_registration(TRUE);
+    if (!epan_init(NULL, NULL, FALSE))
+        return 2;
+    register_test_protocols();
+
+    g_test_add_func("/proto_lazy/ids", test_lazy_ids);
+    g_test_add_func("/proto_lazy/lookup", test_lazy_lookup);
+
+    if (g_test_perf()) {
+        g_test_add_func("/proto_lazy/complete_perf", test_lazy_complete_perf);
+    }
+
+    result = g_test_run();
+
+    epan_cleanup();
+    wtap_cleanup();
+
+    return result;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
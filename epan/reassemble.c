@@ -10,14 +10,18 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <string.h>
 
 #include <epan/packet.h>
 #include <epan/exceptions.h>
 #include <epan/reassemble.h>
 #include <epan/tvbuff-int.h>
+#include <epan/prefs.h>
 
+#include <wsutil/file_util.h>
 #include <wsutil/str_util.h>
+#include <wsutil/tempfile.h>
 #include <wsutil/ws_assert.h>
 
 /*
@@ -316,6 +320,370 @@ reassembled_key_free(gpointer ptr)
 	g_slice_free(reassembled_key, (reassembled_key *)ptr);
 }
 
+/*
+ * Cache of reassembled payloads.
+ *
+ * Completed reassemblies are kept for the life of the capture file, in
+ * the reassembled table or, for those done with fragment_add() and the
+ * like, in the fragment table, so that they can be found again when
+ * packets are dissected again.  With large file transfers that can add
+ * up to many times the size of the capture, so if the
+ * "protocols.reassembly_cache_size" preference sets a budget, the payloads that were used least recently
+ * are written to a temporary file and their tvbuffs freed until the rest
+ * fit in it.  An evicted payload is read back when its reassembly is next
+ * looked up, or when fragment_get_reassembled_data() is asked for it.
+ *
+ * A payload is never evicted while a dissection that looked it up might
+ * still refer to it: every lookup pins the entry until the packet scope
+ * of that dissection is freed.
+ */
+typedef struct _reassembly_cache_entry {
+	fragment_head *fd_head;	/**< NULL once the reassembly has been freed */
+	tvbuff_t *tvb;		/**< fd_head->tvb_data when we last saw it, NULL if evicted */
+	guint32 len;		/**< length of the payload */
+	gint64 spill_offset;	/**< offset of a copy in the spill file, -1 if none */
+	guint pins;		/**< number of dissections using it */
+	GList lru_link;		/**< link in the LRU list, if resident */
+} reassembly_cache_entry_t;
+
+static struct {
+	GQueue lru;			/* resident entries, most recently used first */
+	GHashTable *pins;		/* packet scope -> GPtrArray of pinned entries */
+	int spill_fd;			/* temporary file for evicted payloads, -1 if none */
+	char *spill_path;
+	gint64 spill_size;
+	guint spilled_entries;		/* entries with a copy in the spill file */
+	gboolean spill_failed;		/* stop evicting if we can't write */
+	reassembly_cache_stats_t stats;
+} reassembly_cache = { G_QUEUE_INIT, NULL, -1, NULL, 0, 0, FALSE, { 0 } };
+
+static void
+reassembly_cache_close_spill(void)
+{
+	if (reassembly_cache.spill_fd != -1) {
+		ws_close(reassembly_cache.spill_fd);
+		ws_unlink(reassembly_cache.spill_path);
+		g_free(reassembly_cache.spill_path);
+		reassembly_cache.spill_fd = -1;
+		reassembly_cache.spill_path = NULL;
+	}
+	reassembly_cache.spill_size = 0;
+	reassembly_cache.stats.spill_bytes = 0;
+	/* A new file may be writable where the old one wasn't. */
+	reassembly_cache.spill_failed = FALSE;
+}
+
+static void
+reassembly_cache_forget_spill(reassembly_cache_entry_t *entry)
+{
+	if (entry->spill_offset < 0)
+		return;
+	entry->spill_offset = -1;
+	reassembly_cache.spilled_entries--;
+	/* The file only grows, so start a new one once nothing is in it. */
+	if (reassembly_cache.spilled_entries == 0)
+		reassembly_cache_close_spill();
+}
+
+static void
+reassembly_cache_set_resident(reassembly_cache_entry_t *entry, tvbuff_t *tvb)
+{
+	entry->tvb = tvb;
+	entry->len = tvb_captured_length(tvb);
+	g_queue_push_head_link(&reassembly_cache.lru, &entry->lru_link);
+	reassembly_cache.stats.resident_bytes += entry->len;
+	reassembly_cache.stats.resident_count++;
+	if (reassembly_cache.stats.resident_bytes > reassembly_cache.stats.peak_resident_bytes)
+		reassembly_cache.stats.peak_resident_bytes = reassembly_cache.stats.resident_bytes;
+}
+
+static void
+reassembly_cache_clear_resident(reassembly_cache_entry_t *entry)
+{
+	g_queue_unlink(&reassembly_cache.lru, &entry->lru_link);
+	reassembly_cache.stats.resident_bytes -= entry->len;
+	reassembly_cache.stats.resident_count--;
+	entry->tvb = NULL;
+}
+
+static void
+reassembly_cache_free_entry(reassembly_cache_entry_t *entry)
+{
+	reassembly_cache_forget_spill(entry);
+	g_slice_free(reassembly_cache_entry_t, entry);
+}
+
+/*
+ * Called when a reassembly is freed, or its payload is taken away from
+ * it, to stop tracking its payload.
+ */
+static void
+reassembly_cache_release(fragment_head *fd_head)
+{
+	reassembly_cache_entry_t *entry = fd_head->cache_entry;
+
+	if (entry == NULL)
+		return;
+	fd_head->cache_entry = NULL;
+
+	if (entry->tvb)
+		reassembly_cache_clear_resident(entry);
+	else
+		reassembly_cache.stats.evicted_count--;
+	entry->fd_head = NULL;
+	if (entry->pins == 0)
+		reassembly_cache_free_entry(entry);
+}
+
+static bool
+reassembly_cache_unpin_all(wmem_allocator_t *scope, wmem_cb_event_t event _U_, void *user_data)
+{
+	GPtrArray *pinned = (GPtrArray *)user_data;
+	reassembly_cache_entry_t *entry;
+	guint i;
+
+	for (i = 0; i < pinned->len; i++) {
+		entry = (reassembly_cache_entry_t *)g_ptr_array_index(pinned, i);
+		entry->pins--;
+		if (entry->pins == 0 && entry->fd_head == NULL)
+			reassembly_cache_free_entry(entry);
+	}
+	g_hash_table_remove(reassembly_cache.pins, scope);
+	g_ptr_array_free(pinned, TRUE);
+
+	/* A new callback is registered for the next packet that pins anything. */
+	return false;
+}
+
+static void
+reassembly_cache_pin(reassembly_cache_entry_t *entry, const packet_info *pinfo)
+{
+	GPtrArray *pinned;
+
+	if (reassembly_cache.pins == NULL)
+		reassembly_cache.pins = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	pinned = (GPtrArray *)g_hash_table_lookup(reassembly_cache.pins, pinfo->pool);
+	if (pinned == NULL) {
+		pinned = g_ptr_array_new();
+		g_hash_table_insert(reassembly_cache.pins, pinfo->pool, pinned);
+		wmem_register_callback(pinfo->pool, reassembly_cache_unpin_all, pinned);
+	} else if (pinned->len > 0 &&
+		   g_ptr_array_index(pinned, pinned->len - 1) == entry) {
+		/* Looked up again by the same dissection */
+		return;
+	}
+	g_ptr_array_add(pinned, entry);
+	entry->pins++;
+}
+
+static gboolean
+reassembly_cache_write(const guint8 *data, guint32 len)
+{
+	GError *err = NULL;
+	guint32 done;
+	int written;
+
+	if (reassembly_cache.spill_fd == -1) {
+		reassembly_cache.spill_fd = create_tempfile(NULL, &reassembly_cache.spill_path, "wireshark_reassembly", NULL, &err);
+		if (reassembly_cache.spill_fd == -1) {
+			ws_warning("Can't create a file for evicted reassembled data: %s", err->message);
+			g_error_free(err);
+			return FALSE;
+		}
+	}
+
+	if (ws_lseek64(reassembly_cache.spill_fd, reassembly_cache.spill_size, SEEK_SET) != reassembly_cache.spill_size)
+		return FALSE;
+	for (done = 0; done < len; done += written) {
+		written = (int)ws_write(reassembly_cache.spill_fd, data + done, len - done);
+		if (written <= 0) {
+			ws_warning("Can't write evicted reassembled data to %s: %s", reassembly_cache.spill_path, g_strerror(errno));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Evict an entry: copy its payload to the spill file, unless it's
+ * already there, and free its tvbuff.
+ */
+static gboolean
+reassembly_cache_evict(reassembly_cache_entry_t *entry)
+{
+	fragment_head *fd_head = entry->fd_head;
+	fragment_item *fd_i;
+
+	/* Fragments may have subsets of the payload. */
+	for (fd_i = fd_head->next; fd_i; fd_i = fd_i->next) {
+		if (fd_i->tvb_data)
+			return FALSE;
+	}
+
+	if (entry->spill_offset < 0) {
+		if (!reassembly_cache_write(tvb_get_ptr(entry->tvb, 0, entry->len), entry->len)) {
+			reassembly_cache.spill_failed = TRUE;
+			return FALSE;
+		}
+		entry->spill_offset = reassembly_cache.spill_size;
+		reassembly_cache.spill_size += entry->len;
+		reassembly_cache.stats.spill_bytes = reassembly_cache.spill_size;
+		reassembly_cache.spilled_entries++;
+	}
+
+	reassembly_cache_clear_resident(entry);
+	tvb_free(fd_head->tvb_data);
+	fd_head->tvb_data = NULL;
+	reassembly_cache.stats.evicted_count++;
+	reassembly_cache.stats.evictions++;
+	return TRUE;
+}
+
+static void
+reassembly_cache_trim(void)
+{
+	guint64 budget = (guint64)prefs.reassembly_cache_size * 1024 * 1024;
+	reassembly_cache_entry_t *entry;
+	GList *link, *prev;
+
+	reassembly_cache.stats.budget = budget;
+	if (budget == 0 || reassembly_cache.spill_failed)
+		return;
+
+	for (link = reassembly_cache.lru.tail;
+	     link != NULL && reassembly_cache.stats.resident_bytes > budget;
+	     link = prev) {
+		prev = link->prev;
+		entry = (reassembly_cache_entry_t *)link->data;
+		if (entry->pins == 0)
+			reassembly_cache_evict(entry);
+		if (reassembly_cache.spill_failed)
+			break;
+	}
+}
+
+static void
+reassembly_cache_restore(reassembly_cache_entry_t *entry)
+{
+	fragment_head *fd_head = entry->fd_head;
+	guint8 *data;
+	guint32 done;
+	int nread;
+
+	data = (guint8 *)g_malloc(entry->len);
+	if (ws_lseek64(reassembly_cache.spill_fd, entry->spill_offset, SEEK_SET) != entry->spill_offset) {
+		g_free(data);
+		REPORT_DISSECTOR_BUG("Can't seek to evicted reassembled data in %s", reassembly_cache.spill_path);
+	}
+	for (done = 0; done < entry->len; done += nread) {
+		nread = (int)ws_read(reassembly_cache.spill_fd, data + done, entry->len - done);
+		if (nread <= 0) {
+			g_free(data);
+			REPORT_DISSECTOR_BUG("Can't read evicted reassembled data from %s", reassembly_cache.spill_path);
+		}
+	}
+
+	fd_head->tvb_data = tvb_new_real_data(data, entry->len, entry->len);
+	tvb_set_free_cb(fd_head->tvb_data, g_free);
+	reassembly_cache.stats.evicted_count--;
+	reassembly_cache.stats.restores++;
+	reassembly_cache_set_resident(entry, fd_head->tvb_data);
+}
+
+/*
+ * Note that a completed reassembly is being used by this dissection:
+ * start tracking its payload if we aren't already, read it back if it
+ * was evicted, and keep it until the dissection is done.
+ */
+static void
+reassembly_cache_use(fragment_head *fd_head, const packet_info *pinfo)
+{
+	reassembly_cache_entry_t *entry;
+
+	if (fd_head == NULL || !(fd_head->flags & FD_DEFRAGMENTED) ||
+	    (fd_head->flags & FD_SUBSET_TVB))
+		return;
+
+	entry = fd_head->cache_entry;
+	if (entry == NULL) {
+		if (fd_head->tvb_data == NULL)
+			return;
+		entry = g_slice_new0(reassembly_cache_entry_t);
+		entry->fd_head = fd_head;
+		entry->spill_offset = -1;
+		entry->lru_link.data = entry;
+		fd_head->cache_entry = entry;
+		reassembly_cache_set_resident(entry, fd_head->tvb_data);
+	} else if (entry->tvb == NULL && fd_head->tvb_data == NULL) {
+		reassembly_cache_restore(entry);
+	} else if (entry->tvb != fd_head->tvb_data) {
+		/* The payload was replaced; any copy we have is stale. */
+		reassembly_cache_release(fd_head);
+		reassembly_cache_use(fd_head, pinfo);
+		return;
+	} else {
+		g_queue_unlink(&reassembly_cache.lru, &entry->lru_link);
+		g_queue_push_head_link(&reassembly_cache.lru, &entry->lru_link);
+	}
+
+	if (pinfo->pool != NULL)
+		reassembly_cache_pin(entry, pinfo);
+	reassembly_cache_trim();
+}
+
+/*
+ * Look up a completed reassembly in the table of reassembled packets.
+ */
+static fragment_head *
+lookup_reassembled(reassembly_table *table, const packet_info *pinfo,
+		   const reassembled_key *key)
+{
+	fragment_head *fd_head;
+
+	fd_head = (fragment_head *)g_hash_table_lookup(table->reassembled_table, key);
+	reassembly_cache_use(fd_head, pinfo);
+	return fd_head;
+}
+
+tvbuff_t *
+fragment_get_reassembled_data(fragment_head *fd_head, const packet_info *pinfo)
+{
+	reassembly_cache_use(fd_head, pinfo);
+	return fd_head->tvb_data;
+}
+
+void
+reassembly_cache_get_stats(reassembly_cache_stats_t *stats)
+{
+	*stats = reassembly_cache.stats;
+	stats->budget = (guint64)prefs.reassembly_cache_size * 1024 * 1024;
+}
+
+static bool
+reassembled_tvb_free_cb(wmem_allocator_t *scope _U_, wmem_cb_event_t event _U_, void *user_data)
+{
+	tvb_free((tvbuff_t *)user_data);
+	return false;
+}
+
+/*
+ * Free the payload of a reassembly that's replaced or deleted while
+ * dissecting a packet.  The trees of packets dissected before this one
+ * may still refer to it, as tshark prints them while it dissects the
+ * next ones, so it's freed along with the packet scope of this
+ * dissection, which outlives theirs.
+ */
+static void
+reassembled_tvb_free(tvbuff_t *tvb, const packet_info *pinfo)
+{
+	if (pinfo->pool == NULL) {
+		tvb_free(tvb);
+		return;
+	}
+	wmem_register_callback(pinfo->pool, reassembled_tvb_free_cb, tvb);
+}
+
 /*
  * For a fragment hash table entry, free the associated fragments.
  * The entry value (fd_chain) is freed herein and the entry is freed
@@ -333,6 +701,7 @@ free_all_fragments(gpointer key_arg _U_, gpointer value, gpointer user_data _U_)
 	 */
 	fd_head = (fragment_head *)value;
 	if (fd_head != NULL) {
+		reassembly_cache_release(fd_head);
 		fd_i = fd_head->next;
 		if(fd_head->tvb_data && !(fd_head->flags&FD_SUBSET_TVB))
 			tvb_free(fd_head->tvb_data);
@@ -373,6 +742,7 @@ free_fd_head(fragment_head *fd_head)
 {
 	fragment_item *fd_i, *tmp;
 
+	reassembly_cache_release(fd_head);
 	if (fd_head->flags & FD_SUBSET_TVB)
 		fd_head->tvb_data = NULL;
 	if (fd_head->tvb_data)
@@ -426,6 +796,7 @@ reassembled_table_insert(GHashTable *reassembled_table, reassembled_key *key, fr
 			 * a new tvb's chain, but we might not be able to free
 			 * it yet if set_address_tvb() was used.
 			 */
+			reassembly_cache_release(old_fd_head);
 			old_fd_head->tvb_data = NULL;
 		}
 	}
@@ -575,6 +946,9 @@ lookup_fd_head(reassembly_table *table, const packet_info *pinfo,
 	/* Free the key */
 	table->free_temporary_key_func(key);
 
+	/* Reassemblies completed by fragment_add() and the like stay in
+	 * this table, so their payloads may have been evicted. */
+	reassembly_cache_use((fragment_head *)value, pinfo);
 	return (fragment_head *)value;
 }
 
@@ -623,6 +997,7 @@ fragment_delete(reassembly_table *table, const packet_info *pinfo,
 		return NULL;
 	}
 
+	reassembly_cache_release(fd_head);
 	fd_tvb_data=fd_head->tvb_data;
 	/* loop over all partial fragments and free any tvbuffs */
 	for(fd=fd_head->next;fd;){
@@ -660,7 +1035,7 @@ fragment_get_reassembled_id(reassembly_table *table, const packet_info *pinfo,
 	/* create key to search hash with */
 	key.frame = pinfo->num;
 	key.id = id;
-	fd_head = (fragment_head *)g_hash_table_lookup(table->reassembled_table, &key);
+	fd_head = lookup_reassembled(table, pinfo, &key);
 
 	return fd_head;
 }
@@ -897,6 +1272,7 @@ fragment_truncate(reassembly_table *table, const packet_info *pinfo,
 
 	DISSECTOR_ASSERT(fd_head->datalen > tot_len);
 
+	reassembly_cache_release(fd_head);
 	old_tvb_data=fd_head->tvb_data;
 	fd_head->tvb_data = tvb_clone_offset_len(old_tvb_data, 0, tot_len);
 	tvb_set_free_cb(fd_head->tvb_data, g_free);
@@ -1053,6 +1429,7 @@ fragment_reassembled(reassembly_table *table, fragment_head *fd_head,
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	reassembly_cache_use(fd_head, pinfo);
 }
 
 /*
@@ -1091,6 +1468,7 @@ fragment_reassembled_single(reassembly_table *table, fragment_head *fd_head,
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in = pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	reassembly_cache_use(fd_head, pinfo);
 }
 
 static void
@@ -1376,6 +1754,7 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	 * free all fragments
 	 */
 	/* store old data just in case */
+	reassembly_cache_release(fd_head);
 	old_tvb_data=fd_head->tvb_data;
 	data = (guint8 *) g_malloc(fd_head->datalen);
 	fd_head->tvb_data = tvb_new_real_data(data, fd_head->datalen, fd_head->datalen);
@@ -1510,6 +1889,7 @@ fragment_add_work(fragment_head *fd_head, tvbuff_t *tvb, const int offset,
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in=pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	reassembly_cache_use(fd_head, pinfo);
 
 	/* we don't throw until here to avoid leaking old_data and others */
 	if (fd_head->error) {
@@ -1776,7 +2156,7 @@ fragment_add_check_with_fallback(reassembly_table *table, tvbuff_t *tvb, const i
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		return (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		return lookup_reassembled(table, pinfo, &reass_key);
 	}
 
 	/* Looks up a key in the GHashTable, returning the original key and the associated value
@@ -1788,7 +2168,7 @@ fragment_add_check_with_fallback(reassembly_table *table, tvbuff_t *tvb, const i
 		/* Check if there is completed reassembly reachable from fallback frame */
 		reass_key.frame = fallback_frame;
 		reass_key.id = id;
-		fd_head = (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		fd_head = lookup_reassembled(table, pinfo, &reass_key);
 		if (fd_head != NULL) {
 			/* Found completely reassembled packet, hash it with current frame number */
 			reassembled_key *new_key = g_slice_new(reassembled_key);
@@ -1877,6 +2257,7 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 	}
 
 	/* store old data in case the fd_i->data pointers refer to it */
+	reassembly_cache_release(fd_head);
 	old_tvb_data=fd_head->tvb_data;
 	data = (guint8 *) g_malloc(size);
 	fd_head->tvb_data = tvb_new_real_data(data, size, size);
@@ -1914,7 +2295,7 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 		fd_i->tvb_data=NULL;
 	}
 	if (old_tvb_data)
-		tvb_free(old_tvb_data);
+		reassembled_tvb_free(old_tvb_data, pinfo);
 
 	/* mark this packet as defragmented.
 	 * allows us to skip any trailing fragments.
@@ -1922,6 +2303,7 @@ fragment_defragment_and_free (fragment_head *fd_head, const packet_info *pinfo)
 	fd_head->flags |= FD_DEFRAGMENTED;
 	fd_head->reassembled_in=pinfo->num;
 	fd_head->reas_in_layer_num = pinfo->curr_layer_num;
+	reassembly_cache_use(fd_head, pinfo);
 }
 
 /*
@@ -2342,7 +2724,7 @@ fragment_add_seq_check_work(reassembly_table *table, tvbuff_t *tvb,
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		return (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		return lookup_reassembled(table, pinfo, &reass_key);
 	}
 
 	fd_head = fragment_add_seq_common(table, tvb, offset, pinfo, id, data,
@@ -2471,7 +2853,7 @@ fragment_add_seq_single_move(reassembly_table *table, const packet_info *pinfo,
 			new_fh->next = NULL;
 			old_tvb_data = fragment_delete(table, pinfo, id+offset, data);
 			if (old_tvb_data)
-				tvb_free(old_tvb_data);
+				reassembled_tvb_free(old_tvb_data, pinfo);
 		}
 	}
 }
@@ -2498,7 +2880,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		fh = (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		fh = lookup_reassembled(table, pinfo, &reass_key);
 		return fh;
 	}
 	/* First let's figure out where we want to add our new fragment */
@@ -2510,7 +2892,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 		    fh && ((fh->frame + max_age) < pinfo->num)) {
 			old_tvb_data = fragment_delete(table, pinfo, id-frag_number, data);
 			if (old_tvb_data)
-				tvb_free(old_tvb_data);
+				reassembled_tvb_free(old_tvb_data, pinfo);
 			fh = NULL;
 		}
 		if (fh == NULL) {
@@ -2566,7 +2948,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 				if (new_fh->next == NULL) {
 					old_tvb_data = fragment_delete(table, pinfo, id-frag_number, data);
 					if (old_tvb_data)
-						tvb_free(old_tvb_data);
+						reassembled_tvb_free(old_tvb_data, pinfo);
 				}
 			} else {
 			/* Look forward and take off the next (this is
@@ -2585,7 +2967,7 @@ fragment_add_seq_single_work(reassembly_table *table, tvbuff_t *tvb,
 			    fh && ((fh->frame + max_age) < pinfo->num)) {
 				old_tvb_data = fragment_delete(table, pinfo, id-frag_number, data);
 				if (old_tvb_data)
-					tvb_free(old_tvb_data);
+					reassembled_tvb_free(old_tvb_data, pinfo);
 				fh = NULL;
 			}
 			if (fh != NULL) {
@@ -2769,6 +3151,7 @@ fragment_start_seq_check(reassembly_table *table, const packet_info *pinfo,
 		fd_head->flags = FD_BLOCKSEQUENCE|FD_DATALEN_SET;
 		fd_head->tvb_data = NULL;
 		fd_head->error = NULL;
+		fd_head->cache_entry = NULL;
 
 		insert_fd_head(table, fd_head, pinfo, id, data);
 	}
@@ -2792,7 +3175,7 @@ fragment_end_seq_next(reassembly_table *table, const packet_info *pinfo,
 	if (pinfo->fd->visited) {
 		reass_key.frame = pinfo->num;
 		reass_key.id = id;
-		return (fragment_head *)g_hash_table_lookup(table->reassembled_table, &reass_key);
+		return lookup_reassembled(table, pinfo, &reass_key);
 	}
 
 	fd_head = lookup_fd_head(table, pinfo, id, data, &orig_key);
@@ -2865,7 +3248,7 @@ process_reassembled_data(tvbuff_t *tvb, const int offset, packet_info *pinfo,
 			 * the tvbuff we were handed refers, so it'll get
 			 * cleaned up when that tvbuff is cleaned up.
 			 */
-			next_tvb = tvb_new_chain(tvb, fd_head->tvb_data);
+			next_tvb = tvb_new_chain(tvb, fragment_get_reassembled_data(fd_head, pinfo));
 
 			/* Add the defragmented data to the data source list. */
 			add_new_data_source(pinfo, next_tvb, name);
@@ -3137,6 +3520,8 @@ reassembly_table_init_reg_table(gpointer p, gpointer user_data _U_)
 static void
 reassembly_table_init_reg_tables(void)
 {
+	/* Try spilling again for the new file. */
+	reassembly_cache.spill_failed = FALSE;
 	g_list_foreach(reassembly_table_list, reassembly_table_init_reg_table, NULL);
 }
 
@@ -95,6 +95,7 @@ typedef struct _fragment_head {
 	 * an error, in which case it's the string for the error.
 	 */
 	const char *error;
+	struct _reassembly_cache_entry *cache_entry; /**< payload tracking, see reassembly_cache_get_stats() */
 } fragment_head;
 
 /*
@@ -562,6 +563,37 @@ extern void reassembly_tables_init(void);
 extern void
 reassembly_table_cleanup(void);
 
+/*
+ * Memory used by the payloads of completed reassemblies.  If the
+ * "protocols.reassembly_cache_size" preference is non-zero, the payloads
+ * that were used least recently are moved out of memory to a temporary
+ * file until the rest fit in that many megabytes, and read back when
+ * they're looked up again.
+ */
+typedef struct {
+	guint64 budget;			/**< bytes, or 0 if there's no limit */
+	guint64 resident_bytes;		/**< payload bytes in memory */
+	guint64 peak_resident_bytes;	/**< most payload bytes ever in memory at once */
+	guint resident_count;		/**< number of payloads in memory */
+	guint evicted_count;		/**< number of payloads in the temporary file only */
+	guint64 evictions;		/**< times a payload was moved out of memory */
+	guint64 restores;		/**< times a payload was read back */
+	guint64 spill_bytes;		/**< size of the temporary file */
+} reassembly_cache_stats_t;
+
+WS_DLL_PUBLIC void
+reassembly_cache_get_stats(reassembly_cache_stats_t *stats);
+
+/*
+ * Return the payload of a completed reassembly, reading it back if it was
+ * moved out of memory, and keep it until the dissection of this packet is
+ * done.  The lookup functions do this already; use it instead of
+ * fd_head->tvb_data when the fragment_head was kept from an earlier pass,
+ * e.g. in per-packet data.
+ */
+WS_DLL_PUBLIC tvbuff_t *
+fragment_get_reassembled_data(fragment_head *fd_head, const packet_info *pinfo);
+
 /* ===================== Streaming data reassembly helper ===================== */
 /**
  * Macro to help to define ett or hf items variables for reassembly (especially for streaming reassembly).
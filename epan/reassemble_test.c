@@ -38,6 +38,7 @@
 
 #include <epan/packet.h>
 #include <epan/packet_info.h>
+#include <epan/prefs.h>
 #include <epan/proto.h>
 #include <epan/tvbuff.h>
 #include <epan/reassemble.h>
@@ -3209,6 +3210,233 @@ test_fragment_add_check_duplicate_conflict(void)
  *
  *********************************************************************************/
 
+/**********************************************************************************
+ *
+ * Reassembled payload cache
+ *
+ *********************************************************************************/
+
+/* Three reassemblies of two 400 KB fragments each, with a 1 MB budget:
+ * completing the second and third evicts the least recently used one,
+ * and looking one up again reads it back.
+ */
+#define CACHE_FRAG_LEN (400*1024)
+
+static void
+test_fragment_add_check_cache_eviction(void)
+{
+    reassembly_cache_stats_t stats;
+    fragment_head *fd_head, *heads[3];
+    guint8 *big_data;
+    tvbuff_t *big_tvb;
+    guint32 i, id;
+
+    printf("Starting test test_fragment_add_check_cache_eviction\n");
+
+    big_data = (guint8 *)g_malloc(2*CACHE_FRAG_LEN);
+    for (i = 0; i < 2*CACHE_FRAG_LEN; i++) {
+        big_data[i] = (guint8)(i * 7);
+    }
+    big_tvb = tvb_new_real_data(big_data, 2*CACHE_FRAG_LEN, 2*CACHE_FRAG_LEN);
+    prefs.reassembly_cache_size = 1;
+
+    for (id = 0; id < 3; id++) {
+        pinfo.num = 2*id + 1;
+        fd_head=fragment_add_check(&test_reassembly_table, big_tvb, 0, &pinfo, 20+id,
+                                   NULL, 0, CACHE_FRAG_LEN, TRUE);
+        ASSERT_EQ_POINTER(NULL,fd_head);
+        pinfo.num = 2*id + 2;
+        fd_head=fragment_add_check(&test_reassembly_table, big_tvb, CACHE_FRAG_LEN, &pinfo, 20+id,
+                                   NULL, CACHE_FRAG_LEN, CACHE_FRAG_LEN, FALSE);
+        ASSERT_NE_POINTER(NULL,fd_head);
+        heads[id] = fd_head;
+    }
+
+    /* Only the last one fits. */
+    ASSERT_EQ_POINTER(NULL,heads[0]->tvb_data);
+    ASSERT_EQ_POINTER(NULL,heads[1]->tvb_data);
+    ASSERT_NE_POINTER(NULL,heads[2]->tvb_data);
+    reassembly_cache_get_stats(&stats);
+    ASSERT_EQ(1,stats.resident_count);
+    ASSERT_EQ(2,stats.evicted_count);
+    ASSERT_EQ(2,stats.evictions);
+    ASSERT_EQ(0,stats.restores);
+
+    /* Looking up the first one on a second pass reads it back and
+     * evicts the third. */
+    pinfo.fd->visited = 1;
+    pinfo.num = 2;
+    fd_head=fragment_add_check(&test_reassembly_table, big_tvb, CACHE_FRAG_LEN, &pinfo, 20,
+                               NULL, CACHE_FRAG_LEN, CACHE_FRAG_LEN, FALSE);
+    ASSERT_EQ_POINTER(heads[0],fd_head);
+    ASSERT_NE_POINTER(NULL,fd_head->tvb_data);
+    ASSERT_EQ(2*CACHE_FRAG_LEN,tvb_captured_length(fd_head->tvb_data));
+    ASSERT(memcmp(tvb_get_ptr(fd_head->tvb_data, 0, 2*CACHE_FRAG_LEN), big_data, 2*CACHE_FRAG_LEN) == 0);
+    ASSERT_EQ_POINTER(NULL,heads[2]->tvb_data);
+    reassembly_cache_get_stats(&stats);
+    ASSERT_EQ(1,stats.resident_count);
+    ASSERT_EQ(3,stats.evictions);
+    ASSERT_EQ(1,stats.restores);
+    /* Each payload was only written out once. */
+    ASSERT_EQ(3*2*CACHE_FRAG_LEN,stats.spill_bytes);
+
+    prefs.reassembly_cache_size = 0;
+    tvb_free(big_tvb);
+    g_free(big_data);
+}
+
+/* Some dissectors keep the fragment_head in per-packet data and pass it to
+ * process_reassembled_data() when the packet is dissected again, without
+ * looking it up. Its payload has to be read back all the same.
+ */
+static void
+test_fragment_add_check_cache_kept_head(void)
+{
+    reassembly_cache_stats_t stats;
+    fragment_head *fd_head, *heads[3];
+    guint8 *big_data;
+    tvbuff_t *big_tvb, *payload, *other;
+    guint64 restores;
+    guint32 i, id;
+
+    printf("Starting test test_fragment_add_check_cache_kept_head\n");
+
+    reassembly_cache_get_stats(&stats);
+    restores = stats.restores;
+
+    big_data = (guint8 *)g_malloc(2*CACHE_FRAG_LEN);
+    for (i = 0; i < 2*CACHE_FRAG_LEN; i++) {
+        big_data[i] = (guint8)(i * 13);
+    }
+    big_tvb = tvb_new_real_data(big_data, 2*CACHE_FRAG_LEN, 2*CACHE_FRAG_LEN);
+    prefs.reassembly_cache_size = 1;
+
+    for (id = 0; id < 3; id++) {
+        pinfo.num = 2*id + 1;
+        fd_head=fragment_add_check(&test_reassembly_table, big_tvb, 0, &pinfo, 30+id,
+                                   NULL, 0, CACHE_FRAG_LEN, TRUE);
+        ASSERT_EQ_POINTER(NULL,fd_head);
+        pinfo.num = 2*id + 2;
+        fd_head=fragment_add_check(&test_reassembly_table, big_tvb, CACHE_FRAG_LEN, &pinfo, 30+id,
+                                   NULL, CACHE_FRAG_LEN, CACHE_FRAG_LEN, FALSE);
+        ASSERT_NE_POINTER(NULL,fd_head);
+        heads[id] = fd_head;
+    }
+    ASSERT_EQ_POINTER(NULL,heads[0]->tvb_data);
+    ASSERT_EQ_POINTER(NULL,heads[1]->tvb_data);
+
+    /* Dissect the last fragment of the first one again with the kept head. */
+    pinfo.fd->visited = 1;
+    pinfo.num = 2;
+    pinfo.pool = wmem_allocator_new(WMEM_ALLOCATOR_SIMPLE);
+    payload = fragment_get_reassembled_data(heads[0], &pinfo);
+    ASSERT_NE_POINTER(NULL,payload);
+    ASSERT_EQ_POINTER(heads[0]->tvb_data,payload);
+    ASSERT_EQ(2*CACHE_FRAG_LEN,tvb_captured_length(payload));
+    ASSERT(memcmp(tvb_get_ptr(payload, 0, 2*CACHE_FRAG_LEN), big_data, 2*CACHE_FRAG_LEN) == 0);
+    reassembly_cache_get_stats(&stats);
+    ASSERT_EQ(restores+1,stats.restores);
+
+    /* While this packet is being dissected, the payload it uses stays
+     * even when reading back another one goes over the budget. */
+    other = fragment_get_reassembled_data(heads[1], &pinfo);
+    ASSERT_NE_POINTER(NULL,other);
+    ASSERT_EQ_POINTER(payload,heads[0]->tvb_data);
+    ASSERT_EQ_POINTER(NULL,heads[2]->tvb_data);
+    ASSERT(memcmp(tvb_get_ptr(payload, 0, 2*CACHE_FRAG_LEN), big_data, 2*CACHE_FRAG_LEN) == 0);
+
+    /* Once it's done, they can be evicted again. */
+    wmem_destroy_allocator(pinfo.pool);
+    pinfo.pool = NULL;
+    pinfo.num = 6;
+    payload = fragment_get_reassembled_data(heads[2], &pinfo);
+    ASSERT_NE_POINTER(NULL,payload);
+    ASSERT_EQ_POINTER(NULL,heads[0]->tvb_data);
+    ASSERT_EQ_POINTER(NULL,heads[1]->tvb_data);
+    reassembly_cache_get_stats(&stats);
+    ASSERT_EQ(1,stats.resident_count);
+    ASSERT_EQ(restores+3,stats.restores);
+
+    prefs.reassembly_cache_size = 0;
+    tvb_free(big_tvb);
+    g_free(big_data);
+}
+
+/* Reassemblies completed by fragment_add() stay in the fragment table,
+ * as with TCP, and count against the budget all the same; fragment_get()
+ * reads an evicted payload back.
+ */
+static void
+test_fragment_add_cache_eviction(void)
+{
+    reassembly_cache_stats_t stats;
+    fragment_head *fd_head, *heads[3];
+    guint8 *big_data;
+    tvbuff_t *big_tvb;
+    guint64 evictions, restores;
+    guint32 i, id;
+
+    printf("Starting test test_fragment_add_cache_eviction\n");
+
+    reassembly_cache_get_stats(&stats);
+    evictions = stats.evictions;
+    restores = stats.restores;
+
+    big_data = (guint8 *)g_malloc(2*CACHE_FRAG_LEN);
+    for (i = 0; i < 2*CACHE_FRAG_LEN; i++) {
+        big_data[i] = (guint8)(i * 11);
+    }
+    big_tvb = tvb_new_real_data(big_data, 2*CACHE_FRAG_LEN, 2*CACHE_FRAG_LEN);
+    prefs.reassembly_cache_size = 1;
+
+    for (id = 0; id < 3; id++) {
+        pinfo.num = 2*id + 1;
+        fd_head=fragment_add(&test_reassembly_table, big_tvb, 0, &pinfo, 40+id,
+                             NULL, 0, CACHE_FRAG_LEN, TRUE);
+        ASSERT_EQ_POINTER(NULL,fd_head);
+        pinfo.num = 2*id + 2;
+        fd_head=fragment_add(&test_reassembly_table, big_tvb, CACHE_FRAG_LEN, &pinfo, 40+id,
+                             NULL, CACHE_FRAG_LEN, CACHE_FRAG_LEN, FALSE);
+        ASSERT_NE_POINTER(NULL,fd_head);
+        heads[id] = fd_head;
+    }
+
+    ASSERT_EQ_POINTER(NULL,heads[0]->tvb_data);
+    ASSERT_EQ_POINTER(NULL,heads[1]->tvb_data);
+    ASSERT_NE_POINTER(NULL,heads[2]->tvb_data);
+    reassembly_cache_get_stats(&stats);
+    ASSERT_EQ(1,stats.resident_count);
+    ASSERT_EQ(evictions+2,stats.evictions);
+
+    /* On a second pass, the head found by fragment_get() has its
+     * payload back. */
+    pinfo.fd->visited = 1;
+    pinfo.num = 2;
+    fd_head=fragment_get(&test_reassembly_table, &pinfo, 40, NULL);
+    ASSERT_EQ_POINTER(heads[0],fd_head);
+    ASSERT_NE_POINTER(NULL,fd_head->tvb_data);
+    ASSERT_EQ_POINTER(fd_head->tvb_data,fragment_get_reassembled_data(fd_head, &pinfo));
+    ASSERT(memcmp(tvb_get_ptr(fd_head->tvb_data, 0, 2*CACHE_FRAG_LEN), big_data, 2*CACHE_FRAG_LEN) == 0);
+    ASSERT_EQ_POINTER(NULL,heads[2]->tvb_data);
+    reassembly_cache_get_stats(&stats);
+    ASSERT_EQ(restores+1,stats.restores);
+
+    /* So does the one fragment_add() returns. */
+    pinfo.num = 4;
+    fd_head=fragment_add(&test_reassembly_table, big_tvb, CACHE_FRAG_LEN, &pinfo, 41,
+                         NULL, CACHE_FRAG_LEN, CACHE_FRAG_LEN, FALSE);
+    ASSERT_EQ_POINTER(heads[1],fd_head);
+    ASSERT_NE_POINTER(NULL,fd_head->tvb_data);
+    ASSERT(memcmp(tvb_get_ptr(fd_head->tvb_data, 0, 2*CACHE_FRAG_LEN), big_data, 2*CACHE_FRAG_LEN) == 0);
+    reassembly_cache_get_stats(&stats);
+    ASSERT_EQ(1,stats.resident_count);
+    ASSERT_EQ(restores+2,stats.restores);
+
+    prefs.reassembly_cache_size = 0;
+    tvb_free(big_tvb);
+    g_free(big_data);
+}
+
 int
 main(int argc _U_, char **argv _U_)
 {
@@ -3251,6 +3479,9 @@ main(int argc _U_, char **argv _U_)
         test_fragment_add_check_duplicate_last,
 #endif
         test_fragment_add_check_duplicate_conflict,
+        test_fragment_add_check_cache_eviction,
+        test_fragment_add_check_cache_kept_head,
+        test_fragment_add_cache_eviction,
     };
 
     /* a tvbuff for testing with */
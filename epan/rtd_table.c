@@ -103,6 +103,48 @@ void reset_rtd_table(rtd_stat_table* table)
         memset(table->time_stats[i].rtd, 0, sizeof(timestat_t)*table->time_stats[i].num_timestat);
 }
 
+void* clone_rtd_table_data(void* tapdata)
+{
+    rtd_data_t* rtd_data = (rtd_data_t*)tapdata;
+    rtd_data_t* clone = g_new0(rtd_data_t, 1);
+    guint i;
+
+    clone->user_data = rtd_data->user_data;
+    clone->stat_table.num_rtds = rtd_data->stat_table.num_rtds;
+    clone->stat_table.time_stats = g_new0(rtd_timestat, clone->stat_table.num_rtds);
+    for (i = 0; i < clone->stat_table.num_rtds; i++)
+    {
+        clone->stat_table.time_stats[i].num_timestat = rtd_data->stat_table.time_stats[i].num_timestat;
+        clone->stat_table.time_stats[i].rtd = g_new0(timestat_t, clone->stat_table.time_stats[i].num_timestat);
+    }
+    return clone;
+}
+
+void merge_rtd_table_data(void* tapdata, void* shard)
+{
+    rtd_stat_table* table = &((rtd_data_t*)tapdata)->stat_table;
+    rtd_data_t* src = (rtd_data_t*)shard;
+    rtd_timestat *ts, *src_ts;
+    guint i, j;
+
+    for (i = 0; i < table->num_rtds; i++)
+    {
+        ts = &table->time_stats[i];
+        src_ts = &src->stat_table.time_stats[i];
+        for (j = 0; j < ts->num_timestat; j++)
+            time_stat_merge(&ts->rtd[j], &src_ts->rtd[j]);
+        /* A later instance may see responses to requests an earlier
+         * one counted as open; the unsigned sums still come out right. */
+        ts->open_req_num += src_ts->open_req_num;
+        ts->disc_rsp_num += src_ts->disc_rsp_num;
+        ts->req_dup_num += src_ts->req_dup_num;
+        ts->rsp_dup_num += src_ts->rsp_dup_num;
+    }
+
+    free_rtd_table(&src->stat_table);
+    g_free(src);
+}
+
 register_rtd_t* get_rtd_table_by_name(const char* name)
 {
     return (register_rtd_t*)wmem_tree_lookup_string(registered_rtd_tables, name, 0);
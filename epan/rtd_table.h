@@ -118,6 +118,21 @@ WS_DLL_PUBLIC void free_rtd_table(rtd_stat_table* table);
  */
 WS_DLL_PUBLIC void reset_rtd_table(rtd_stat_table* table);
 
+/** Create an empty RTD table with the same layout as another one. Used as
+ * the tap_clone_cb of RTD tap listeners.
+ *
+ * @param tapdata the rtd_data_t to copy the layout from
+ * @return a new rtd_data_t, freed by merge_rtd_table_data()
+ */
+WS_DLL_PUBLIC void* clone_rtd_table_data(void* tapdata);
+
+/** Add the statistics of a cloned RTD table to a table and free the clone.
+ *
+ * @param tapdata the rtd_data_t to merge into
+ * @param shard the rtd_data_t returned by clone_rtd_table_data()
+ */
+WS_DLL_PUBLIC void merge_rtd_table_data(void* tapdata, void* shard);
+
 /** Interator to walk RTD tables and execute func
  * Used for initialization
  *
@@ -19,14 +19,19 @@
 # include <netinet/in.h>
 #endif
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <glib.h>
 
 #include <epan/packet_info.h>
+#include <epan/epan_dissect.h>
 #include <epan/dfilter/dfilter.h>
 #include <epan/tap.h>
+#include <epan/wmem_scopes.h>
+#include <wsutil/strtoi.h>
 #include <wsutil/wslog.h>
+#include <wsutil/ws_assert.h>
 
 static gboolean tapping_is_active=FALSE;
 
@@ -86,15 +91,147 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	guint filter_index;	/* In tap_filters, if there is a code */
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
 	tap_draw_cb draw;
 	tap_finish_cb finish;
+	tap_clone_cb clone;
+	tap_merge_cb merge;
+	/* While tapping in parallel: one instance per worker thread (the
+	 * first one is tapdata itself) and the status each one returned. */
+	void **shards;
+	guint8 *shard_status;
 } tap_listener_t;
 
+#define TAP_SHARD_REDRAW	0x01
+#define TAP_SHARD_FAILED	0x02
+
 static tap_listener_t *tap_listener_queue=NULL;
 
+/* The filters of all the listeners, applied together to each packet so
+ * that a field which several of them test is only read once. Built when
+ * the first packet is tapped after a listener or filter changes. */
+static struct {
+	dfilter_multi_t *multi;
+	guint count;
+	guint64 *wanted;
+} tap_filters;
+
+/*
+ * Parallel tapping.
+ *
+ * Dissection isn't thread safe, so it stays on the calling thread; what
+ * moves to the worker threads are the packet routines of mergeable
+ * listeners. Packets are dissected into a window of epan_dissect_t's so
+ * that a packet's data stays valid until its listeners have run, and the
+ * packet scope isn't left until the whole window has been processed.
+ * Each worker feeds its own instance of every mergeable listener with a
+ * contiguous run of the packets in the window.
+ *
+ * The conversation, endpoint and RTD tables are mergeable. The others run
+ * on the calling thread as before: some SRT packet routines number new
+ * rows in tables shared by all instances, stats_tree nodes have global
+ * ids, and the I/O graph keeps its items in a QObject. The protocol
+ * hierarchy statistics don't use a tap listener at all.
+ */
+#define TAP_PARALLEL_WINDOW	256
+
+typedef struct {
+	tap_listener_t *tl;
+	packet_info *pinfo;
+	const void *tap_specific_data;
+	guint flags;
+} tap_job_t;
+
+typedef struct {
+	epan_dissect_t *edt;
+	wtap_rec rec;
+	Buffer buf;
+	GArray *jobs;		/* tap_job_t */
+	guint worker;
+} tap_parallel_slot_t;
+
+typedef struct {
+	GThread *thread;
+	GAsyncQueue *queue;	/* tap_parallel_slot_t */
+	guint index;
+} tap_parallel_worker_t;
+
+static struct {
+	guint num_workers;
+	tap_parallel_worker_t *workers;
+	tap_parallel_slot_t *slots;
+	guint num_slots;	/* Slots handed out since the last reset */
+	tap_parallel_slot_t *cur_slot;
+	gboolean holding_packet_scope;
+	GMutex lock;
+	GCond done;
+	guint pending;		/* Slots queued but not yet processed */
+} tap_parallel;
+
+/* Pushed to a worker's queue to make it exit. */
+static tap_parallel_slot_t tap_parallel_stop;
+
+static void tap_parallel_wait(void);
+
+static void
+tap_filters_reset(void)
+{
+	dfilter_multi_free(tap_filters.multi);
+	tap_filters.multi=NULL;
+	g_free(tap_filters.wanted);
+	tap_filters.wanted=NULL;
+	tap_filters.count=0;
+}
+
+static void
+tap_filters_build(void)
+{
+	tap_listener_t *tl;
+	GPtrArray *filters;
+
+	filters=g_ptr_array_new();
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->code){
+			tl->filter_index=filters->len;
+			g_ptr_array_add(filters, tl->code);
+		}
+	}
+	tap_filters.count=filters->len;
+	tap_filters.multi=dfilter_multi_new((dfilter_t * const *)filters->pdata, filters->len);
+	tap_filters.wanted=g_new0(guint64, DF_MULTI_MASK_WORDS(filters->len));
+	g_ptr_array_free(filters, TRUE);
+}
+
+/* Apply, once, the filters of the listeners that the queued packets
+ * will be passed to, and return which of them the packet passes. */
+static const guint64 *
+tap_filters_apply(epan_dissect_t *edt)
+{
+	tap_packet_t *tp;
+	tap_listener_t *tl;
+	guint i;
+
+	if(!tap_filters.multi){
+		tap_filters_build();
+	}
+
+	memset(tap_filters.wanted, 0, DF_MULTI_MASK_WORDS(tap_filters.count)*sizeof(guint64));
+	for(i=0;i<tap_packet_index;i++){
+		tp=&tap_packet_array[i];
+		for(tl=tap_listener_queue;tl;tl=tl->next){
+			if(tl->code && tl->packet && !tl->failed && tp->tap_id==tl->tap_id &&
+			    (!(tp->flags & TAP_PACKET_IS_ERROR_PACKET) || (tl->flags & TL_REQUIRES_ERROR_PACKETS))){
+				DF_MULTI_MASK_SET(tap_filters.wanted, tl->filter_index);
+			}
+		}
+	}
+
+	return dfilter_multi_apply_edt(tap_filters.multi, edt, tap_filters.wanted, 0);
+}
+
 static GSList *tap_plugins = NULL;
 
 #ifdef HAVE_PLUGINS
@@ -297,6 +434,24 @@ tap_queue_init(epan_dissect_t *edt)
 	tap_build_interesting (edt);
 }
 
+static void
+tap_listener_set_status(tap_listener_t *tl, tap_packet_status status)
+{
+	switch (status) {
+
+	case TAP_PACKET_DONT_REDRAW:
+		break;
+
+	case TAP_PACKET_REDRAW:
+		tl->needs_redraw=TRUE;
+		break;
+
+	case TAP_PACKET_FAILED:
+		tl->failed=TRUE;
+		break;
+	}
+}
+
 /* this function is called after a packet has been fully dissected to push the tapped
    data to all extensions that has callbacks registered.
 */
@@ -305,6 +460,8 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 {
 	tap_packet_t *tp;
 	tap_listener_t *tl;
+	tap_parallel_slot_t *slot = NULL;
+	const guint64 *passed;
 	guint i;
 
 	/* nothing to do, just return */
@@ -319,6 +476,18 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	if(tap_parallel.num_workers){
+		if(tap_parallel.cur_slot && tap_parallel.cur_slot->edt==edt){
+			slot=tap_parallel.cur_slot;
+		} else {
+			/* Not one of ours; the workers mustn't be
+			 * using the listeners while we call them. */
+			tap_parallel_wait();
+		}
+	}
+
+	passed=tap_filters_apply(edt);
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
@@ -350,7 +519,7 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					 */
 					guint flags = tl->flags;
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						if (!DF_MULTI_MASK_TEST(passed, tl->filter_index)){
 							/* The packet didn't
 							 * pass the filter. */
 							if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
@@ -360,28 +529,32 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 						}
 					}
 
-					/* So call the per-packet routine. */
-					tap_packet_status status;
+					if(slot && tl->shards){
+						/* Leave it to the worker. */
+						tap_job_t job;
 
-					status = tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags);
-
-					switch (status) {
-
-					case TAP_PACKET_DONT_REDRAW:
-						break;
-
-					case TAP_PACKET_REDRAW:
-						tl->needs_redraw=TRUE;
-						break;
-
-					case TAP_PACKET_FAILED:
-						tl->failed=TRUE;
-						break;
+						job.tl = tl;
+						job.pinfo = tp->pinfo;
+						job.tap_specific_data = tp->tap_specific_data;
+						job.flags = flags;
+						g_array_append_val(slot->jobs, job);
+						continue;
 					}
+
+					/* So call the per-packet routine. */
+					tap_listener_set_status(tl,
+					    tl->packet(tl->tapdata, tp->pinfo, edt, tp->tap_specific_data, flags));
 				}
 			}
 		}
 	}
+
+	if(slot && slot->jobs->len){
+		g_mutex_lock(&tap_parallel.lock);
+		tap_parallel.pending++;
+		g_mutex_unlock(&tap_parallel.lock);
+		g_async_queue_push(tap_parallel.workers[slot->worker].queue, slot);
+	}
 }
 
 
@@ -436,6 +609,8 @@ reset_tap_listeners(void)
 {
 	tap_listener_t *tl;
 
+	tap_parallel_end();
+
 	for(tl=tap_listener_queue;tl;tl=tl->next){
 		if(tl->reset){
 			tl->reset(tl->tapdata);
@@ -460,6 +635,11 @@ draw_tap_listeners(gboolean draw_all)
 	tap_listener_t *tl;
 
 	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->shards){
+			/* Worker threads are updating it; it'll be
+			 * redrawn once the results have been merged. */
+			continue;
+		}
 		if(tl->needs_redraw || draw_all){
 			if(tl->draw){
 				tl->draw(tl->tapdata);
@@ -576,6 +756,8 @@ register_tap_listener(const char *tapname, void *tapdata, const char *fstring,
 	tl->finish=finish;
 	tl->next=tap_listener_queue;
 
+	tap_filters_reset();
+
 	tap_listener_queue=tl;
 
 	return NULL;
@@ -608,6 +790,7 @@ set_tap_dfilter(void *tapdata, const char *fstring)
 	}
 
 	if(tl){
+		tap_filters_reset();
 		if(tl->code){
 			dfilter_free(tl->code);
 			tl->code=NULL;
@@ -640,6 +823,8 @@ tap_listeners_dfilter_recompile(void)
 	tap_listener_t *tl;
 	dfilter_t *code;
 
+	tap_filters_reset();
+
 	for(tl=tap_listener_queue;tl;tl=tl->next){
 		if(tl->code){
 			dfilter_free(tl->code);
@@ -668,6 +853,8 @@ remove_tap_listener(void *tapdata)
 		return;
 	}
 
+	tap_parallel_end();
+
 	if(tap_listener_queue->tapdata==tapdata){
 		tl=tap_listener_queue;
 		tap_listener_queue=tap_listener_queue->next;
@@ -685,9 +872,284 @@ remove_tap_listener(void *tapdata)
 			return;
 		}
 	}
+	tap_filters_reset();
 	free_tap_listener(tl);
 }
 
+gboolean
+set_tap_merge_funcs(void *tapdata, tap_clone_cb clone, tap_merge_cb merge)
+{
+	tap_listener_t *tl;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->tapdata==tapdata){
+			if(tl->shards){
+				/* Too late for this retap. */
+				return TRUE;
+			}
+			tl->clone=clone;
+			tl->merge=merge;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+static gpointer
+tap_parallel_worker(gpointer data)
+{
+	tap_parallel_worker_t *worker = (tap_parallel_worker_t *)data;
+	tap_parallel_slot_t *slot;
+	tap_job_t *job;
+	tap_packet_status status;
+	guint i;
+
+	while ((slot = (tap_parallel_slot_t *)g_async_queue_pop(worker->queue)) != &tap_parallel_stop) {
+		for(i=0;i<slot->jobs->len;i++){
+			job=&g_array_index(slot->jobs, tap_job_t, i);
+			if(job->tl->shard_status[worker->index] & TAP_SHARD_FAILED){
+				continue;
+			}
+			status=job->tl->packet(job->tl->shards[worker->index], job->pinfo,
+			    slot->edt, job->tap_specific_data, job->flags);
+			if(status==TAP_PACKET_REDRAW){
+				job->tl->shard_status[worker->index] |= TAP_SHARD_REDRAW;
+			} else if(status==TAP_PACKET_FAILED){
+				job->tl->shard_status[worker->index] |= TAP_SHARD_FAILED;
+			}
+		}
+
+		g_mutex_lock(&tap_parallel.lock);
+		if(--tap_parallel.pending==0){
+			g_cond_signal(&tap_parallel.done);
+		}
+		g_mutex_unlock(&tap_parallel.lock);
+	}
+	return NULL;
+}
+
+gboolean
+tap_parallel_begin(epan_t *session, gboolean create_proto_tree, guint num_threads)
+{
+	tap_listener_t *tl;
+	gboolean have_mergeable = FALSE;
+	guint i, j;
+
+	if(tap_parallel.num_workers){
+		return TRUE;
+	}
+
+	if(num_threads==0){
+		const char *env_threads=getenv("WIRESHARK_TAP_THREADS");
+
+		/* The environment can override the default, e.g. to
+		 * compare the results with those of a serial retap. */
+		if(env_threads==NULL || !ws_strtou32(env_threads, NULL, &num_threads)){
+			num_threads=g_get_num_processors();
+		}
+	}
+	if(num_threads<2){
+		return FALSE;
+	}
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(tl->clone && tl->merge && tl->packet && !tl->failed){
+			have_mergeable=TRUE;
+			break;
+		}
+	}
+	if(!have_mergeable){
+		return FALSE;
+	}
+
+	/* The calling thread does the dissection. */
+	tap_parallel.num_workers=num_threads-1;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(!(tl->clone && tl->merge && tl->packet) || tl->failed){
+			continue;
+		}
+		tl->shards=g_new(void *, tap_parallel.num_workers);
+		tl->shard_status=g_new0(guint8, tap_parallel.num_workers);
+		tl->shards[0]=tl->tapdata;
+		for(i=1;i<tap_parallel.num_workers;i++){
+			tl->shards[i]=tl->clone(tl->tapdata);
+		}
+	}
+
+	tap_parallel.slots=g_new0(tap_parallel_slot_t, TAP_PARALLEL_WINDOW);
+	for(i=0;i<TAP_PARALLEL_WINDOW;i++){
+		tap_parallel_slot_t *slot=&tap_parallel.slots[i];
+
+		slot->edt=epan_dissect_new(session, create_proto_tree, FALSE);
+		wtap_rec_init(&slot->rec);
+		ws_buffer_init(&slot->buf, 1514);
+		slot->jobs=g_array_new(FALSE, FALSE, sizeof(tap_job_t));
+		/* Give each worker a contiguous run of packets. */
+		slot->worker=i*tap_parallel.num_workers/TAP_PARALLEL_WINDOW;
+	}
+	tap_parallel.num_slots=0;
+	tap_parallel.cur_slot=NULL;
+	tap_parallel.pending=0;
+
+	tap_parallel.workers=g_new0(tap_parallel_worker_t, tap_parallel.num_workers);
+	for(j=0;j<tap_parallel.num_workers;j++){
+		tap_parallel_worker_t *worker=&tap_parallel.workers[j];
+		char *name=ws_strdup_printf("tap worker %u", j);
+
+		worker->index=j;
+		worker->queue=g_async_queue_new();
+		worker->thread=g_thread_new(name, tap_parallel_worker, worker);
+		g_free(name);
+	}
+
+	ws_debug("tapping with %u worker threads", tap_parallel.num_workers);
+	return TRUE;
+}
+
+static void
+tap_parallel_wait(void)
+{
+	g_mutex_lock(&tap_parallel.lock);
+	while(tap_parallel.pending){
+		g_cond_wait(&tap_parallel.done, &tap_parallel.lock);
+	}
+	g_mutex_unlock(&tap_parallel.lock);
+}
+
+void
+tap_parallel_sync(void)
+{
+	if(!tap_parallel.num_workers){
+		return;
+	}
+
+	tap_parallel_wait();
+
+	if(tap_parallel.holding_packet_scope){
+		tap_parallel.holding_packet_scope=FALSE;
+		wmem_leave_packet_scope();
+	}
+}
+
+epan_dissect_t *
+tap_parallel_next_frame(wtap_rec **rec, Buffer **buf)
+{
+	tap_parallel_slot_t *slot;
+	Buffer options_buf;
+	guint i;
+
+	ws_assert(tap_parallel.num_workers);
+
+	if(tap_parallel.num_slots==TAP_PARALLEL_WINDOW){
+		/* Recycle the window once the workers are done with it. */
+		tap_parallel_sync();
+		for(i=0;i<TAP_PARALLEL_WINDOW;i++){
+			epan_dissect_reset(tap_parallel.slots[i].edt);
+			g_array_set_size(tap_parallel.slots[i].jobs, 0);
+		}
+		tap_parallel.num_slots=0;
+	}
+	slot=&tap_parallel.slots[tap_parallel.num_slots++];
+
+	/* epan_dissect_run_with_taps() drops the block reference, so
+	 * the copy needs its own. */
+	options_buf=slot->rec.options_buf;
+	slot->rec=**rec;
+	slot->rec.options_buf=options_buf;
+	ws_buffer_clean(&slot->rec.options_buf);
+	ws_buffer_append_buffer(&slot->rec.options_buf, &(*rec)->options_buf);
+	if(slot->rec.block){
+		wtap_block_ref(slot->rec.block);
+	}
+	ws_buffer_clean(&slot->buf);
+	ws_buffer_append_buffer(&slot->buf, *buf);
+
+	*rec=&slot->rec;
+	*buf=&slot->buf;
+	tap_parallel.cur_slot=slot;
+	return slot->edt;
+}
+
+void
+tap_parallel_end(void)
+{
+	tap_listener_t *tl;
+	guint i;
+
+	if(!tap_parallel.num_workers){
+		return;
+	}
+
+	tap_parallel_sync();
+
+	for(i=0;i<tap_parallel.num_workers;i++){
+		g_async_queue_push(tap_parallel.workers[i].queue, &tap_parallel_stop);
+	}
+	for(i=0;i<tap_parallel.num_workers;i++){
+		g_thread_join(tap_parallel.workers[i].thread);
+		g_async_queue_unref(tap_parallel.workers[i].queue);
+	}
+	g_free(tap_parallel.workers);
+	tap_parallel.workers=NULL;
+
+	for(tl=tap_listener_queue;tl;tl=tl->next){
+		if(!tl->shards){
+			continue;
+		}
+		for(i=0;i<tap_parallel.num_workers;i++){
+			if(i>0){
+				tl->merge(tl->tapdata, tl->shards[i]);
+			}
+			if(tl->shard_status[i] & TAP_SHARD_REDRAW){
+				tl->needs_redraw=TRUE;
+			}
+			if(tl->shard_status[i] & TAP_SHARD_FAILED){
+				tl->failed=TRUE;
+			}
+		}
+		g_free(tl->shards);
+		tl->shards=NULL;
+		g_free(tl->shard_status);
+		tl->shard_status=NULL;
+	}
+
+	for(i=0;i<TAP_PARALLEL_WINDOW;i++){
+		tap_parallel_slot_t *slot=&tap_parallel.slots[i];
+
+		epan_dissect_free(slot->edt);
+		wtap_rec_cleanup(&slot->rec);
+		ws_buffer_free(&slot->buf);
+		g_array_free(slot->jobs, TRUE);
+	}
+	g_free(tap_parallel.slots);
+	tap_parallel.slots=NULL;
+	tap_parallel.cur_slot=NULL;
+	tap_parallel.num_slots=0;
+	tap_parallel.num_workers=0;
+}
+
+gboolean
+tap_parallel_active(void)
+{
+	return tap_parallel.num_workers != 0;
+}
+
+/*
+ * Called by epan_dissect_run_with_taps() before it leaves the packet
+ * scope. Returns TRUE if the scope must stay open because worker threads
+ * may still use memory allocated in it; tap_parallel_sync() leaves it.
+ */
+gboolean
+tap_parallel_hold_packet_scope(void)
+{
+	if(!tap_parallel.num_workers){
+		return FALSE;
+	}
+	tap_parallel.holding_packet_scope=TRUE;
+	return TRUE;
+}
+
 /*
  * Return TRUE if we have one or more tap listeners that require dissection,
  * FALSE otherwise.
@@ -708,6 +1170,26 @@ tap_listeners_require_dissection(void)
 
 }
 
+/*
+ * Return TRUE if every tap listener that requires dissection only looks
+ * at packets matching the given filter, FALSE otherwise.
+ */
+gboolean
+tap_listeners_filtered_by(const char *fstring)
+{
+	tap_listener_t *tap_queue = tap_listener_queue;
+
+	while(tap_queue) {
+		if(!(tap_queue->flags & TL_IS_DISSECTOR_HELPER) &&
+		    g_strcmp0(tap_queue->fstring, fstring) != 0)
+			return FALSE;
+
+		tap_queue = tap_queue->next;
+	}
+
+	return TRUE;
+}
+
 /*
  * Return TRUE if we have one or more tap listeners that require the columns,
  * FALSE otherwise.
@@ -797,6 +1279,8 @@ void tap_cleanup(void)
 	tap_dissector_t *elem_dl;
 	tap_dissector_t *head_dl = tap_dissector_list;
 
+	tap_parallel_end();
+
 	while(head_lq){
 		elem_lq = head_lq;
 		head_lq = head_lq->next;
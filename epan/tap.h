@@ -13,6 +13,7 @@
 
 #include <epan/epan.h>
 #include <epan/packet_info.h>
+#include <wiretap/wtap.h>
 #include "ws_symbol_export.h"
 
 #ifdef __cplusplus
@@ -34,6 +35,8 @@ typedef void (*tap_reset_cb)(void *tapdata);
 typedef tap_packet_status (*tap_packet_cb)(void *tapdata, packet_info *pinfo, epan_dissect_t *edt, const void *data, tap_flags_t flags);
 typedef void (*tap_draw_cb)(void *tapdata);
 typedef void (*tap_finish_cb)(void *tapdata);
+typedef void *(*tap_clone_cb)(void *tapdata);
+typedef void (*tap_merge_cb)(void *tapdata, void *shard);
 
 /**
  * Flags to indicate what a tap listener's packet routine requires.
@@ -242,12 +245,83 @@ WS_DLL_PUBLIC void tap_listeners_dfilter_recompile(void);
 /** this function removes a tap listener */
 WS_DLL_PUBLIC void remove_tap_listener(void *tapdata);
 
+/** This function makes a tap listener mergeable, which lets a retap feed
+ * packets to several copies of the listener on worker threads and combine
+ * the results at the end.
+ *
+ * @param tapdata    The tapdata the listener was registered with.
+ * @param tap_clone  void *(*clone)(void *tapdata)
+ *                   Returns a new instance with the same configuration as
+ *                   tapdata but no accumulated state.
+ * @param tap_merge  void (*merge)(void *tapdata, void *shard)
+ *                   Adds the state accumulated in a clone to tapdata and
+ *                   frees the clone.
+ *
+ * Each instance sees a disjoint subset of the packets, in order. The packet
+ * routine of a mergeable listener may run on a worker thread while later
+ * packets are being dissected, so it must only modify the tapdata it is
+ * passed and must only read pinfo, edt and the tap specific data; in
+ * particular it must not use wmem_packet_scope() or other global state.
+ *
+ * @return FALSE if no listener is registered with tapdata.
+ */
+WS_DLL_PUBLIC gboolean set_tap_merge_funcs(void *tapdata, tap_clone_cb tap_clone,
+    tap_merge_cb tap_merge);
+
+/** Start running mergeable tap listeners on worker threads. Packets must
+ * then be dissected with epan_dissect_run_with_taps() using the
+ * epan_dissect_t returned by tap_parallel_next_frame().
+ *
+ * @param session The epan session to dissect with.
+ * @param create_proto_tree TRUE if the listeners need a protocol tree.
+ * @param num_threads Total number of threads to use, including the
+ *                   calling one; 0 means the number in the
+ *                   WIRESHARK_TAP_THREADS environment variable, or one
+ *                   per processor if it isn't set.
+ * @return TRUE if parallel tapping was started. FALSE if there are no
+ *         mergeable listeners or only one thread is available, in which
+ *         case the caller should retap as usual.
+ */
+WS_DLL_PUBLIC gboolean tap_parallel_begin(epan_t *session, gboolean create_proto_tree,
+    guint num_threads);
+
+/** Get the dissection context for the next packet of a parallel retap.
+ * The record and its data are copied so that they outlive the caller's
+ * buffers; *rec and *buf are updated to point to the copies.
+ * This may wait for worker threads to finish earlier packets.
+ */
+WS_DLL_PUBLIC epan_dissect_t *tap_parallel_next_frame(wtap_rec **rec, Buffer **buf);
+
+/** Wait until the worker threads have processed all packets dissected so
+ * far. */
+WS_DLL_PUBLIC void tap_parallel_sync(void);
+
+/** Finish a parallel retap: wait for the worker threads, stop them and
+ * merge the results into each listener's tapdata. Removing or resetting
+ * tap listeners does this too, so a retap loop should check
+ * tap_parallel_active() for every packet rather than remember whether
+ * tap_parallel_begin() succeeded. */
+WS_DLL_PUBLIC void tap_parallel_end(void);
+
+/** Returns TRUE while a parallel retap is running. */
+WS_DLL_PUBLIC gboolean tap_parallel_active(void);
+
+/** Used by epan_dissect_run_with_taps() to keep the packet scope open
+ * while worker threads may still use it. */
+extern gboolean tap_parallel_hold_packet_scope(void);
+
 /**
  * Return TRUE if we have one or more tap listeners that require dissection,
  * FALSE otherwise.
  */
 WS_DLL_PUBLIC gboolean tap_listeners_require_dissection(void);
 
+/**
+ * Return TRUE if every tap listener that requires dissection only looks
+ * at packets matching the given filter, FALSE otherwise.
+ */
+WS_DLL_PUBLIC gboolean tap_listeners_filtered_by(const char *fstring);
+
 /**
  * Return TRUE if we have one or more tap listeners that require the columns,
  * FALSE otherwise.
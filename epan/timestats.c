@@ -56,6 +56,39 @@ time_stat_update(timestat_t *stats, const nstime_t *delta, packet_info *pinfo)
 	stats->num++;
 }
 
+/* Add the samples of a timestat_t struct for later packets to another one.
+ * Like time_stat_update(), this keeps the first frame with the minimum or
+ * maximum if there are several. */
+void
+time_stat_merge(timestat_t *stats, const timestat_t *later)
+{
+	if(later->num==0){
+		return;
+	}
+	if(stats->num==0){
+		*stats=*later;
+		return;
+	}
+
+	if( (later->min.secs<stats->min.secs)
+	||( (later->min.secs==stats->min.secs)
+	  &&(later->min.nsecs<stats->min.nsecs) ) ){
+		stats->min=later->min;
+		stats->min_num=later->min_num;
+	}
+
+	if( (later->max.secs>stats->max.secs)
+	||( (later->max.secs==stats->max.secs)
+	  &&(later->max.nsecs>stats->max.nsecs) ) ){
+		stats->max=later->max;
+		stats->max_num=later->max_num;
+	}
+
+	nstime_add(&stats->tot, &later->tot);
+
+	stats->num+=later->num;
+}
+
 /*
  * get_average - function
  *
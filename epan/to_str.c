@@ -20,6 +20,7 @@
 #include "to_str.h"
 #include "strutil.h"
 #include <wsutil/pint.h>
+#include <wsutil/time_util.h>
 #include <wsutil/utf8_entities.h>
 
 /*
@@ -94,15 +95,15 @@ get_zonename(struct tm *tmp)
 }
 
 static struct tm *
-get_fmt_broken_down_time(field_display_e fmt, const time_t *secs)
+get_fmt_broken_down_time(field_display_e fmt, const time_t *secs, struct tm *result)
 {
     switch (fmt) {
         case ABSOLUTE_TIME_UTC:
         case ABSOLUTE_TIME_DOY_UTC:
         case ABSOLUTE_TIME_NTP_UTC:
-            return gmtime(secs);
+            return ws_gmtime_r(secs, result);
         case ABSOLUTE_TIME_LOCAL:
-            return localtime(secs);
+            return ws_localtime_r(secs, result);
         default:
             break;
     }
@@ -159,7 +160,7 @@ char *
 abs_time_to_str_ex(wmem_allocator_t *scope, const nstime_t *abs_time, field_display_e fmt,
                     int flags)
 {
-    struct tm *tmp;
+    struct tm tm, *tmp;
     char buf_nsecs[32];
     const char *tzone_sep, *tzone_str;
 
@@ -177,7 +178,7 @@ abs_time_to_str_ex(wmem_allocator_t *scope, const nstime_t *abs_time, field_disp
         return wmem_strdup(scope, "NULL");
     }
 
-    tmp = get_fmt_broken_down_time(fmt, &abs_time->secs);
+    tmp = get_fmt_broken_down_time(fmt, &abs_time->secs, &tm);
     if (tmp == NULL) {
         return wmem_strdup(scope, "Not representable");
     }
@@ -1735,6 +1735,7 @@ void wslua_cleanup(void) {
         lua_close(L);
         L = NULL;
     }
+    wslua_cleanup_pools();
     init_routine_initialized = FALSE;
 }
 
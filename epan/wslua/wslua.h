@@ -675,6 +675,18 @@ extern int wslua_reg_attributes(lua_State *L, const wslua_attribute_table *t, gb
     } \
 }
 
+/*
+ * A free list for the structs behind userdata that is created and expired
+ * for every packet (FieldInfo, Tvb, TvbRange), so that they are recycled
+ * instead of going through the allocator each time.
+ */
+typedef struct _wslua_pool_t {
+    gsize size;
+    GPtrArray* free_list;
+} wslua_pool_t;
+
+#define WSLUA_POOL_INIT(type) { sizeof(type), NULL }
+
 #define WSLUA_CLASS_DECLARE(C) \
 extern C to##C(lua_State* L, int idx); \
 extern C check##C(lua_State* L, int idx); \
@@ -769,6 +781,7 @@ extern void UInt64_pack(lua_State* L, luaL_Buffer *b, gint idx, gboolean asLittl
 extern int UInt64_unpack(lua_State* L, const gchar *buff, gboolean asLittleEndian);
 extern guint64 getUInt64(lua_State *L, int i);
 
+extern Tvb alloc_Tvb(void);
 extern Tvb* push_Tvb(lua_State* L, tvbuff_t* tvb);
 extern int push_wsluaTvb(lua_State* L, Tvb t);
 extern gboolean push_TvbRange(lua_State* L, tvbuff_t* tvb, int offset, int len);
@@ -803,6 +816,9 @@ extern char* wslua_get_actual_filename(const char* fname);
 
 extern int wslua_bin2hex(lua_State* L, const guint8* data, const guint len, const gboolean lowercase, const gchar* sep);
 extern int wslua_hex2bin(lua_State* L, const char* data, const guint len, const gchar* sep);
+extern void* wslua_pool_alloc(wslua_pool_t* pool);
+extern void wslua_pool_free(wslua_pool_t* pool, void* p);
+extern void wslua_cleanup_pools(void);
 extern int luaopen_rex_pcre2(lua_State *L);
 
 extern const gchar* get_current_plugin_version(void);
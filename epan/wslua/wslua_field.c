@@ -33,15 +33,29 @@ WSLUA_CLASS_DEFINE(FieldInfo,FAIL_ON_NULL_OR_EXPIRED("FieldInfo"));
 
 static GPtrArray* outstanding_FieldInfo = NULL;
 
+/* FieldInfos are created for every field extracted from every packet, so they're recycled. */
+static wslua_pool_t FieldInfo_pool = WSLUA_POOL_INIT(struct _wslua_field_info);
+
 FieldInfo* push_FieldInfo(lua_State* L, field_info* f) {
-    FieldInfo fi = (FieldInfo) g_malloc(sizeof(struct _wslua_field_info));
+    FieldInfo fi = (FieldInfo) wslua_pool_alloc(&FieldInfo_pool);
     fi->ws_fi = f;
     fi->expired = FALSE;
     g_ptr_array_add(outstanding_FieldInfo,fi);
     return pushFieldInfo(L,fi);
 }
 
-CLEAR_OUTSTANDING(FieldInfo,expired,TRUE)
+/* Like CLEAR_OUTSTANDING(), but returns freed FieldInfos to the pool */
+void clear_outstanding_FieldInfo(void) {
+    while (outstanding_FieldInfo->len) {
+        FieldInfo fi = (FieldInfo)g_ptr_array_remove_index_fast(outstanding_FieldInfo,0);
+        if (fi) {
+            if (!fi->expired)
+                fi->expired = TRUE;
+            else
+                wslua_pool_free(&FieldInfo_pool, fi);
+        }
+    }
+}
 
 /* WSLUA_ATTRIBUTE FieldInfo_len RO The length of this field. */
 WSLUA_METAMETHOD FieldInfo__len(lua_State* L) {
@@ -65,6 +79,9 @@ WSLUA_METAMETHOD FieldInfo__unm(lua_State* L) {
     return 1;
 }
 
+/* Push the value of a field; returns the number of values pushed (0 or 1). */
+static int push_field_value(lua_State* L, field_info* ws_fi);
+
 /* WSLUA_ATTRIBUTE FieldInfo_value RO The value of this field. */
 WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
     /*
@@ -81,9 +98,13 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
        */
     FieldInfo fi = checkFieldInfo(L,1);
 
-    switch(fi->ws_fi->hfinfo->type) {
+    return push_field_value(L, fi->ws_fi);
+}
+
+static int push_field_value(lua_State* L, field_info* ws_fi) {
+    switch(ws_fi->hfinfo->type) {
         case FT_BOOLEAN:
-                lua_pushboolean(L,(int)fvalue_get_uinteger64(fi->ws_fi->value));
+                lua_pushboolean(L,(int)fvalue_get_uinteger64(ws_fi->value));
                 return 1;
         case FT_CHAR:
         case FT_UINT8:
@@ -91,67 +112,67 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
         case FT_UINT24:
         case FT_UINT32:
         case FT_FRAMENUM:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_uinteger(fi->ws_fi->value)));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_uinteger(ws_fi->value)));
                 return 1;
         case FT_INT8:
         case FT_INT16:
         case FT_INT24:
         case FT_INT32:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_sinteger(fi->ws_fi->value)));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_sinteger(ws_fi->value)));
                 return 1;
         case FT_FLOAT:
         case FT_DOUBLE:
-                lua_pushnumber(L,(lua_Number)(fvalue_get_floating(fi->ws_fi->value)));
+                lua_pushnumber(L,(lua_Number)(fvalue_get_floating(ws_fi->value)));
                 return 1;
         case FT_INT64: {
-                pushInt64(L,(Int64)(fvalue_get_sinteger64(fi->ws_fi->value)));
+                pushInt64(L,(Int64)(fvalue_get_sinteger64(ws_fi->value)));
                 return 1;
             }
         case FT_UINT64: {
-                pushUInt64(L,fvalue_get_uinteger64(fi->ws_fi->value));
+                pushUInt64(L,fvalue_get_uinteger64(ws_fi->value));
                 return 1;
             }
         case FT_ETHER: {
                 Address eth = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,eth,AT_ETHER,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,eth,AT_ETHER,ws_fi->length,ws_fi->ds_tvb,ws_fi->start);
                 pushAddress(L,eth);
                 return 1;
             }
         case FT_IPv4:{
                 Address ipv4 = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipv4,AT_IPv4,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipv4,AT_IPv4,ws_fi->length,ws_fi->ds_tvb,ws_fi->start);
                 pushAddress(L,ipv4);
                 return 1;
             }
         case FT_IPv6: {
                 Address ipv6 = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipv6,AT_IPv6,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipv6,AT_IPv6,ws_fi->length,ws_fi->ds_tvb,ws_fi->start);
                 pushAddress(L,ipv6);
                 return 1;
             }
         case FT_FCWWN: {
                 Address fcwwn = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,fcwwn,AT_FCWWN,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,fcwwn,AT_FCWWN,ws_fi->length,ws_fi->ds_tvb,ws_fi->start);
                 pushAddress(L,fcwwn);
                 return 1;
             }
         case FT_IPXNET:{
                 Address ipx = (Address)g_malloc(sizeof(address));
-                alloc_address_tvb(NULL,ipx,AT_IPX,fi->ws_fi->length,fi->ws_fi->ds_tvb,fi->ws_fi->start);
+                alloc_address_tvb(NULL,ipx,AT_IPX,ws_fi->length,ws_fi->ds_tvb,ws_fi->start);
                 pushAddress(L,ipx);
                 return 1;
             }
         case FT_ABSOLUTE_TIME:
         case FT_RELATIVE_TIME: {
                 NSTime nstime = (NSTime)g_malloc(sizeof(nstime_t));
-                *nstime = *fvalue_get_time(fi->ws_fi->value);
+                *nstime = *fvalue_get_time(ws_fi->value);
                 pushNSTime(L,nstime);
                 return 1;
             }
         case FT_STRING:
         case FT_STRINGZ:
         case FT_STRINGZPAD: {
-                gchar* repr = fvalue_to_string_repr(NULL, fi->ws_fi->value, FTREPR_DISPLAY, BASE_NONE);
+                gchar* repr = fvalue_to_string_repr(NULL, ws_fi->value, FTREPR_DISPLAY, BASE_NONE);
                 if (repr)
                 {
                     lua_pushstring(L, repr);
@@ -164,10 +185,10 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
                 return 1;
             }
         case FT_NONE:
-                if (fi->ws_fi->length > 0 && fi->ws_fi->rep) {
+                if (ws_fi->length > 0 && ws_fi->rep) {
                     /* it has a length, but calling fvalue_get() on an FT_NONE asserts,
                        so get the label instead (it's a FT_NONE, so a label is what it basically is) */
-                    lua_pushstring(L, fi->ws_fi->rep->representation);
+                    lua_pushstring(L, ws_fi->rep->representation);
                     return 1;
                 }
                 return 0;
@@ -178,15 +199,15 @@ WSLUA_METAMETHOD FieldInfo__call(lua_State* L) {
         case FT_OID:
             {
                 ByteArray ba = g_byte_array_new();
-                g_byte_array_append(ba, fvalue_get_bytes_data(fi->ws_fi->value),
-                                    (guint)fvalue_length2(fi->ws_fi->value));
+                g_byte_array_append(ba, fvalue_get_bytes_data(ws_fi->value),
+                                    (guint)fvalue_length2(ws_fi->value));
                 pushByteArray(L,ba);
                 return 1;
             }
         case FT_PROTOCOL:
             {
                 ByteArray ba = g_byte_array_new();
-                tvbuff_t* tvb = fvalue_get_protocol(fi->ws_fi->value);
+                tvbuff_t* tvb = fvalue_get_protocol(ws_fi->value);
                 guint8* raw;
                 if (tvb != NULL) {
                     raw = (guint8 *)tvb_memdup(NULL, tvb, 0, tvb_captured_length(tvb));
@@ -436,7 +457,7 @@ static int FieldInfo__gc(lua_State* L) {
         fi->expired = TRUE;
     else
         /* do NOT free fi->ws_fi */
-        g_free(fi);
+        wslua_pool_free(&FieldInfo_pool, fi);
 
     return 0;
 }
@@ -746,6 +767,62 @@ WSLUA_METAMETHOD Field__call (lua_State* L) {
     WSLUA_RETURN(items_found); /* All the values of this field */
 }
 
+WSLUA_CONSTRUCTOR Field_values(lua_State *L) {
+    /* Obtains the value of the first occurrence of each of the given fields in
+       the current packet, or nil for fields that aren't present.
+
+       This is equivalent to calling each `Field` and taking the `value` of the
+       first `FieldInfo`, but doesn't create any `FieldInfo` objects, so it's
+       much cheaper for scripts that read many fields from every packet.
+
+       [source,lua]
+       ----
+       local f_src = Field.new("ip.src")
+       local f_port = Field.new("udp.srcport")
+
+       local src, port = Field.values(f_src, f_port)
+       ----
+
+       @since 4.3.0
+     */
+    int n_fields = lua_gettop(L);
+    int i;
+
+    if (! lua_pinfo ) {
+        WSLUA_ERROR(Field_values,"Fields cannot be used outside dissectors or taps");
+        return 0;
+    }
+
+    luaL_checkstack(L, n_fields, "too many fields");
+
+    for (i = 1; i <= n_fields; i++) {
+        Field f = checkField(L,i);
+        header_field_info* in = f->hfi;
+        int pushed = 0;
+
+        if (! in) {
+            luaL_error(L,"invalid field");
+            return 0;
+        }
+
+        while (in && !pushed) {
+            GPtrArray* found = proto_get_finfo_ptr_array(lua_tree->tree, in->id);
+            if (found && found->len > 0) {
+                /* An FT_NONE without a length has no value; report it as nil. */
+                if (push_field_value(L, (field_info *) g_ptr_array_index(found,0)) == 0)
+                    lua_pushnil(L);
+                pushed = 1;
+            }
+            in = (in->same_name_prev_id != -1) ? proto_registrar_get_nth(in->same_name_prev_id) : NULL;
+        }
+
+        if (!pushed)
+            lua_pushnil(L);
+    }
+
+    WSLUA_RETURN(n_fields); /* One value per field, in the order they were given */
+}
+
 WSLUA_METAMETHOD Field__tostring(lua_State* L) {
     /* Obtain a string with the field filter name. */
     Field f = checkField(L,1);
@@ -785,6 +862,7 @@ WSLUA_ATTRIBUTES Field_attributes[] = {
 WSLUA_METHODS Field_methods[] = {
     WSLUA_CLASS_FNREG(Field,new),
     WSLUA_CLASS_FNREG(Field,list),
+    WSLUA_CLASS_FNREG(Field,values),
     { NULL, NULL }
 };
 
@@ -615,6 +615,47 @@ void wslua_register_class(lua_State *L, const wslua_class *cls_def)
     lua_setglobal(L, cls_def->name);
 }
 
+/* Free lists beyond this many entries are returned to the allocator. */
+#define WSLUA_POOL_MAX_FREE 4096
+
+/* Pools that have been used, so their free lists can be released. */
+static GSList* wslua_pools = NULL;
+
+void* wslua_pool_alloc(wslua_pool_t* pool) {
+    if (pool->free_list && pool->free_list->len) {
+        return g_ptr_array_remove_index_fast(pool->free_list, pool->free_list->len - 1);
+    }
+    return g_malloc(pool->size);
+}
+
+void wslua_pool_free(wslua_pool_t* pool, void* p) {
+    if (!p) return;
+
+    if (!pool->free_list) {
+        pool->free_list = g_ptr_array_new();
+        wslua_pools = g_slist_prepend(wslua_pools, pool);
+    }
+
+    if (pool->free_list->len < WSLUA_POOL_MAX_FREE) {
+        g_ptr_array_add(pool->free_list, p);
+    } else {
+        g_free(p);
+    }
+}
+
+void wslua_cleanup_pools(void) {
+    GSList* l;
+
+    for (l = wslua_pools; l; l = l->next) {
+        wslua_pool_t* pool = (wslua_pool_t*)l->data;
+        g_ptr_array_set_free_func(pool->free_list, g_free);
+        g_ptr_array_free(pool->free_list, TRUE);
+        pool->free_list = NULL;
+    }
+    g_slist_free(wslua_pools);
+    wslua_pools = NULL;
+}
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
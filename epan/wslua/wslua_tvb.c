@@ -65,6 +65,15 @@ WSLUA_CLASS_DEFINE(Tvb,FAIL_ON_NULL_OR_EXPIRED("Tvb"));
 static GPtrArray* outstanding_Tvb = NULL;
 static GPtrArray* outstanding_TvbRange = NULL;
 
+/* Tvbs and TvbRanges are created for every packet, so they're recycled. */
+static wslua_pool_t Tvb_pool = WSLUA_POOL_INIT(struct _wslua_tvb);
+static wslua_pool_t TvbRange_pool = WSLUA_POOL_INIT(struct _wslua_tvbrange);
+
+/* this is used to allocate Tvbs that are then pushed with push_wsluaTvb() */
+Tvb alloc_Tvb(void) {
+    return (Tvb)wslua_pool_alloc(&Tvb_pool);
+}
+
 /* this is used to push Tvbs that were created brand new by wslua code */
 int push_wsluaTvb(lua_State* L, Tvb t) {
     g_ptr_array_add(outstanding_Tvb,t);
@@ -83,7 +92,7 @@ static void free_Tvb(Tvb tvb) {
     } else {
         if (tvb->need_free)
             tvb_free(tvb->ws_tvb);
-        g_free(tvb);
+        wslua_pool_free(&Tvb_pool, tvb);
     }
 }
 
@@ -96,7 +105,7 @@ void clear_outstanding_Tvb(void) {
 
 /* this is used to push Tvbs that just point to pre-existing C-code Tvbs */
 Tvb* push_Tvb(lua_State* L, tvbuff_t* ws_tvb) {
-    Tvb tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    Tvb tvb = alloc_Tvb();
     tvb->ws_tvb = ws_tvb;
     tvb->expired = FALSE;
     tvb->need_free = FALSE;
@@ -349,7 +358,7 @@ static void free_TvbRange(TvbRange tvbr) {
         tvbr->tvb->expired = TRUE;
     } else {
         free_Tvb(tvbr->tvb);
-        g_free(tvbr);
+        wslua_pool_free(&TvbRange_pool, tvbr);
     }
 }
 
@@ -383,8 +392,8 @@ gboolean push_TvbRange(lua_State* L, tvbuff_t* ws_tvb, int offset, int len) {
         return FALSE;
     }
 
-    tvbr = (TvbRange)g_malloc(sizeof(struct _wslua_tvbrange));
-    tvbr->tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+    tvbr = (TvbRange)wslua_pool_alloc(&TvbRange_pool);
+    tvbr->tvb = alloc_Tvb();
     tvbr->tvb->ws_tvb = ws_tvb;
     tvbr->tvb->expired = FALSE;
     tvbr->tvb->need_free = FALSE;
@@ -410,7 +419,7 @@ WSLUA_METHOD TvbRange_tvb(lua_State *L) {
     }
 
     if (tvb_offset_exists(tvbr->tvb->ws_tvb,  tvbr->offset + tvbr->len -1 )) {
-        tvb = (Tvb)g_malloc(sizeof(struct _wslua_tvb));
+        tvb = alloc_Tvb();
         tvb->expired = FALSE;
         tvb->need_free = FALSE;
         tvb->ws_tvb = tvb_new_subset_length(tvbr->tvb->ws_tvb,tvbr->offset,tvbr->len);
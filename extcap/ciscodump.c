@@ -893,7 +893,7 @@ static int parse_line_asa(uint8_t* packet, unsigned* offset, char* line, uint32_
 }
 
 /* IOS: Reads response and parses buffer till prompt received */
-static int process_buffer_response_ios(ssh_channel channel, uint8_t* packet, FILE* fp, const uint32_t count, uint32_t *processed_packets)
+static int process_buffer_response_ios(ssh_channel channel, uint8_t* packet, pcapio_writer_t* fp, const uint32_t count, uint32_t *processed_packets)
 {
 	char line[SSH_READ_BLOCK_SIZE + 1];
 	uint32_t read_packets = 1;
@@ -927,7 +927,7 @@ static int process_buffer_response_ios(ssh_channel channel, uint8_t* packet, FIL
 							ws_debug("Error in libpcap_write_packet(): %s", g_strerror(err));
 							break;
 						}
-						fflush(fp);
+						pcapio_writer_flush(fp, NULL);
 						ws_debug("Dumped packet %u size: %u\n", *processed_packets, packet_size);
 						(*processed_packets)++;
 					}
@@ -957,7 +957,7 @@ static int process_buffer_response_ios(ssh_channel channel, uint8_t* packet, FIL
 }
 
 /* IOS: Queries buffer content and reads it */
-static void ssh_loop_read_ios(ssh_channel channel, FILE* fp, const uint32_t count)
+static void ssh_loop_read_ios(ssh_channel channel, pcapio_writer_t* fp, const uint32_t count)
 {
 	char line[SSH_READ_BLOCK_SIZE + 1];
 	uint8_t* packet;
@@ -1015,7 +1015,7 @@ static void ssh_loop_read_ios(ssh_channel channel, FILE* fp, const uint32_t coun
 }
 
 /* IOS-XE 16: Reads response and parses buffer till prompt received */
-static int process_buffer_response_ios_xe_16(ssh_channel channel, uint8_t* packet, FILE* fp, const uint32_t count, uint32_t *processed_packets)
+static int process_buffer_response_ios_xe_16(ssh_channel channel, uint8_t* packet, pcapio_writer_t* fp, const uint32_t count, uint32_t *processed_packets)
 {
 	char line[SSH_READ_BLOCK_SIZE + 1];
 	uint32_t read_packets = 1;
@@ -1047,7 +1047,7 @@ static int process_buffer_response_ios_xe_16(ssh_channel channel, uint8_t* packe
 							ws_debug("Error in libpcap_write_packet(): %s", g_strerror(err));
 							break;
 						}
-						fflush(fp);
+						pcapio_writer_flush(fp, NULL);
 						ws_debug("Dumped packet %u size: %u\n", *processed_packets, packet_size);
 						(*processed_packets)++;
 					}
@@ -1077,7 +1077,7 @@ static int process_buffer_response_ios_xe_16(ssh_channel channel, uint8_t* packe
 }
 
 /* IOS-XE 17: Reads response and parses buffer till prompt received */
-static int process_buffer_response_ios_xe_17(ssh_channel channel, uint8_t* packet, FILE* fp, const uint32_t count, uint32_t *processed_packets)
+static int process_buffer_response_ios_xe_17(ssh_channel channel, uint8_t* packet, pcapio_writer_t* fp, const uint32_t count, uint32_t *processed_packets)
 {
 	char line[SSH_READ_BLOCK_SIZE + 1];
 	uint32_t read_packets = 1;
@@ -1121,7 +1121,7 @@ static int process_buffer_response_ios_xe_17(ssh_channel channel, uint8_t* packe
 							ws_debug("Error in libpcap_write_packet(): %s", g_strerror(err));
 							break;
 						}
-						fflush(fp);
+						pcapio_writer_flush(fp, NULL);
 						ws_debug("Dumped packet %u size: %u\n", *processed_packets, packet_size);
 						(*processed_packets)++;
 					}
@@ -1145,7 +1145,7 @@ static int process_buffer_response_ios_xe_17(ssh_channel channel, uint8_t* packe
 }
 
 /* IOS-XE 16: Queries buffer content and reads it */
-static void ssh_loop_read_ios_xe_16(ssh_channel channel, FILE* fp, const uint32_t count)
+static void ssh_loop_read_ios_xe_16(ssh_channel channel, pcapio_writer_t* fp, const uint32_t count)
 {
 	char line[SSH_READ_BLOCK_SIZE + 1];
 	uint8_t* packet;
@@ -1203,7 +1203,7 @@ static void ssh_loop_read_ios_xe_16(ssh_channel channel, FILE* fp, const uint32_
 }
 
 /* IOS-XE 17: Queries buffer content and reads it */
-static void ssh_loop_read_ios_xe_17(ssh_channel channel, FILE* fp, const uint32_t count)
+static void ssh_loop_read_ios_xe_17(ssh_channel channel, pcapio_writer_t* fp, const uint32_t count)
 {
 	uint8_t* packet;
 	uint32_t processed_packets = 0;
@@ -1233,7 +1233,7 @@ static void ssh_loop_read_ios_xe_17(ssh_channel channel, FILE* fp, const uint32_
 }
 
 /* ASA: Reads response and parses buffer till prompt end of packet received */
-static int process_buffer_response_asa(ssh_channel channel, uint8_t* packet, FILE* fp, const uint32_t count, uint32_t *processed_packets, uint32_t *current_max)
+static int process_buffer_response_asa(ssh_channel channel, uint8_t* packet, pcapio_writer_t* fp, const uint32_t count, uint32_t *processed_packets, uint32_t *current_max)
 {
 	char line[SSH_READ_BLOCK_SIZE + 1];
 	uint32_t read_packets = 1;
@@ -1272,7 +1272,7 @@ static int process_buffer_response_asa(ssh_channel channel, uint8_t* packet, FIL
 							ws_debug("Error in libpcap_write_packet(): %s", g_strerror(err));
 							break;
 						}
-						fflush(fp);
+						pcapio_writer_flush(fp, NULL);
 						ws_debug("Dumped packet %u size: %u\n", *processed_packets, packet_size);
 						(*processed_packets)++;
 						packet_size = 0;
@@ -1304,7 +1304,7 @@ static int process_buffer_response_asa(ssh_channel channel, uint8_t* packet, FIL
 }
 
 /* ASA: Queries buffer content and reads it */
-static void ssh_loop_read_asa(ssh_channel channel, FILE* fp, const uint32_t count)
+static void ssh_loop_read_asa(ssh_channel channel, pcapio_writer_t* fp, const uint32_t count)
 {
 	char line[SSH_READ_BLOCK_SIZE + 1];
 	uint8_t* packet;
@@ -1356,7 +1356,7 @@ static void ssh_loop_read_asa(ssh_channel channel, FILE* fp, const uint32_t coun
 }
 
 
-static void ssh_loop_read(ssh_channel channel, FILE* fp, const uint32_t count _U_, CISCO_SW_TYPE sw_type)
+static void ssh_loop_read(ssh_channel channel, pcapio_writer_t* fp, const uint32_t count _U_, CISCO_SW_TYPE sw_type)
 {
 	ws_debug("Starting reading loop");
 	switch (sw_type) {
@@ -2131,7 +2131,8 @@ static int ssh_open_remote_connection(const ssh_params_t* ssh_params, const char
 {
 	ssh_session sshs;
 	ssh_channel channel;
-	FILE* fp = stdout;
+	FILE* file = stdout;
+	pcapio_writer_t* fp;
 	uint64_t bytes_written = 0;
 	int err;
 	int ret = EXIT_FAILURE;
@@ -2139,19 +2140,20 @@ static int ssh_open_remote_connection(const ssh_params_t* ssh_params, const char
 
 	if (g_strcmp0(fifo, "-")) {
 		/* Open or create the output file */
-		fp = fopen(fifo, "wb");
-		if (!fp) {
+		file = fopen(fifo, "wb");
+		if (!file) {
 			ws_warning("Error creating output file: %s", g_strerror(errno));
 			return EXIT_FAILURE;
 		}
 	}
+	fp = pcapio_writer_stdio(file);
 
 	if (!libpcap_write_file_header(fp, 1, PCAP_SNAPLEN, false, &bytes_written, &err)) {
 		ws_warning("Can't write pcap file header");
 		goto cleanup;
 	}
 
-	fflush(fp);
+	pcapio_writer_flush(fp, NULL);
 
 	ws_debug("Create first ssh session");
 	sshs = create_ssh_connection(ssh_params, &err_info);
@@ -2215,8 +2217,7 @@ static int ssh_open_remote_connection(const ssh_params_t* ssh_params, const char
 
 	ret = EXIT_SUCCESS;
 cleanup:
-	if (fp != stdout)
-		fclose(fp);
+	pcapio_writer_close(fp, NULL);
 
 	return ret;
 }
@@ -41,7 +41,7 @@
 #define DPAUXMON_VERSION_MINOR "1"
 #define DPAUXMON_VERSION_RELEASE "0"
 
-FILE* pcap_fp = NULL;
+pcapio_writer_t* pcap_fp = NULL;
 
 enum {
 	EXTCAP_BASE_OPTIONS_ENUM,
@@ -94,33 +94,35 @@ static int list_config(char *interface)
 	return EXIT_SUCCESS;
 }
 
-static int setup_dumpfile(const char* fifo, FILE** fp)
+static int setup_dumpfile(const char* fifo, pcapio_writer_t** fp)
 {
 	uint64_t bytes_written = 0;
 	int err;
+	FILE* file;
 
 	if (!g_strcmp0(fifo, "-")) {
-		*fp = stdout;
+		*fp = pcapio_writer_stdio(stdout);
 		return EXIT_SUCCESS;
 	}
 
-	*fp = fopen(fifo, "wb");
-	if (!(*fp)) {
+	file = fopen(fifo, "wb");
+	if (!file) {
 		ws_warning("Error creating output file: %s", g_strerror(errno));
 		return EXIT_FAILURE;
 	}
+	*fp = pcapio_writer_stdio(file);
 
 	if (!libpcap_write_file_header(*fp, 275, PCAP_SNAPLEN, false, &bytes_written, &err)) {
 		ws_warning("Can't write pcap file header");
 		return EXIT_FAILURE;
 	}
 
-        fflush(*fp);
+        pcapio_writer_flush(*fp, NULL);
 
 	return EXIT_SUCCESS;
 }
 
-static int dump_packet(FILE* fp, const char* buf, const uint32_t buflen, uint64_t ts_usecs)
+static int dump_packet(pcapio_writer_t* fp, const char* buf, const uint32_t buflen, uint64_t ts_usecs)
 {
 	uint64_t bytes_written = 0;
 	int err;
@@ -131,7 +133,7 @@ static int dump_packet(FILE* fp, const char* buf, const uint32_t buflen, uint64_
 		ret = EXIT_FAILURE;
 	}
 
-	fflush(fp);
+	pcapio_writer_flush(fp, NULL);
 
 	return ret;
 }
@@ -469,7 +471,7 @@ err_out:
 free_out:
 	nl_socket_free(sock);
 close_out:
-	fclose(pcap_fp);
+	pcapio_writer_close(pcap_fp, NULL);
 }
 
 int main(int argc, char *argv[])
@@ -37,6 +37,7 @@
 #include <epan/prefs.h>
 #include <epan/dfilter/dfilter.h>
 #include <epan/epan_dissect.h>
+#include <epan/field_index.h>
 #include <epan/tap.h>
 #include <epan/timestamp.h>
 #include <epan/strutil.h>
@@ -386,6 +387,9 @@ cf_close(capture_file *cf)
 
     dfilter_free(cf->rfcode);
     cf->rfcode = NULL;
+    field_index_free(cf->field_index);
+    cf->field_index = NULL;
+    cf_set_filter_frames(cf, NULL, NULL, 0);
     if (cf->provider.frames != NULL) {
         free_frame_data_sequence(cf->provider.frames);
         cf->provider.frames = NULL;
@@ -521,6 +525,10 @@ cf_read(capture_file *cf, gboolean reloading)
     /* Get the union of the flags for all tap listeners. */
     tap_flags = union_of_tap_listener_flags();
 
+    /* (Re)create the field index, if one is configured. */
+    field_index_free(cf->field_index);
+    cf->field_index = field_index_new_from_prefs();
+
     /*
      * Determine whether we need to create a protocol tree.
      * We do if:
@@ -532,11 +540,14 @@ cf_read(capture_file *cf, gboolean reloading)
      *    one of the tap listeners requires a protocol tree;
      *
      *    a postdissector wants field values or protocols on
-     *    the first pass.
+     *    the first pass;
+     *
+     *    we're building a field index.
      */
     create_proto_tree =
         (dfcode != NULL || have_filtering_tap_listeners() ||
-         (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+         (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+         cf->field_index != NULL);
 
     reset_tap_listeners();
 
@@ -702,6 +713,15 @@ cf_read(capture_file *cf, gboolean reloading)
     /* compute the time it took to load the file */
     compute_elapsed(cf, start_time);
 
+    if (cf->field_index != NULL) {
+        field_index_stats_t fi_stats;
+        field_index_get_stats(cf->field_index, &fi_stats);
+        ws_info("Field index: %u fields, %u frames, %" PRIu64 " values, "
+                "%zu bytes, built in %" PRId64 " us",
+                fi_stats.num_fields, fi_stats.num_frames, fi_stats.num_values,
+                fi_stats.memory_used, fi_stats.build_time);
+    }
+
     /* Set the file encapsulation type now; we don't know what it is until
        we've looked at all the packets, as we don't know until then whether
        there's more than one type (and thus whether it's
@@ -812,11 +832,14 @@ cf_continue_tail(capture_file *cf, volatile int to_read, wtap_rec *rec,
      *    one of the tap listeners requires a protocol tree;
      *
      *    a postdissector wants field values or protocols on
-     *    the first pass.
+     *    the first pass;
+     *
+     *    we're building a field index.
      */
     create_proto_tree =
         (dfcode != NULL || have_filtering_tap_listeners() ||
-         (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids());
+         (tap_flags & TL_REQUIRES_PROTO_TREE) || postdissectors_want_hfids() ||
+         cf->field_index != NULL);
 
     *err = 0;
 
@@ -1191,52 +1214,92 @@ cf_set_rfcode(capture_file *cf, dfilter_t *rfcode)
     cf->rfcode = rfcode;
 }
 
+/* How add_packet_to_packet_list() applies the display filter. */
+typedef enum {
+    FILTER_BY_DISSECTING,   /* Dissect the frame and apply the filter */
+    FILTER_BY_FIELD_INDEX,  /* Apply the filter to the field index */
+    FILTER_REJECT           /* The frame is known not to match */
+} filter_method_e;
+
+/*
+ * Add a frame to the packet list, dissecting it and applying the display
+ * filter to it. With FILTER_BY_FIELD_INDEX, the frame has already been
+ * dissected and the display filter only reads fields that are in the
+ * field index, so the filter is applied to the index instead. With
+ * FILTER_REJECT, the frame can't match the filter and isn't dissected.
+ */
 static void
 add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
         epan_dissect_t *edt, dfilter_t *dfcode, column_info *cinfo,
-        wtap_rec *rec, Buffer *buf, gboolean add_to_packet_list)
+        wtap_rec *rec, Buffer *buf, gboolean add_to_packet_list,
+        filter_method_e filter_method)
 {
+    gboolean first_pass = !fdata->visited;
+    gboolean dissected = FALSE;
+    bool     passed;
+
     frame_data_set_before_dissect(fdata, &cf->elapsed_time,
             &cf->provider.ref, cf->provider.prev_dis);
     cf->provider.prev_cap = fdata;
 
-    if (dfcode != NULL) {
-        epan_dissect_prime_with_dfilter(edt, dfcode);
-    }
+    if (filter_method == FILTER_REJECT) {
+        fdata->passed_dfilter = 0;
+    } else if (filter_method == FILTER_BY_FIELD_INDEX &&
+            field_index_filter_frame(cf->field_index, dfcode, fdata->num, &passed)) {
+        fdata->passed_dfilter = passed ? 1 : 0;
+
+        if (fdata->passed_dfilter && fdata->dependent_frames) {
+            /* See below. The dependencies were recorded on the first pass. */
+            g_hash_table_foreach(fdata->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+        }
+    } else {
+        if (dfcode != NULL) {
+            epan_dissect_prime_with_dfilter(edt, dfcode);
+        }
 #if 0
-    /* Prepare coloring rules, this ensures that display filter rules containing
-     * frame.color_rule references are still processed.
-     * TODO: actually detect that situation or maybe apply other optimizations? */
-    if (edt->tree && color_filters_used()) {
-        color_filters_prime_edt(edt);
-        fdata->need_colorize = 1;
-    }
+        /* Prepare coloring rules, this ensures that display filter rules containing
+         * frame.color_rule references are still processed.
+         * TODO: actually detect that situation or maybe apply other optimizations? */
+        if (edt->tree && color_filters_used()) {
+            color_filters_prime_edt(edt);
+            fdata->need_colorize = 1;
+        }
 #endif
 
-    if (!fdata->visited) {
-        /* This is the first pass, so prime the epan_dissect_t with the
-           hfids postdissectors want on the first pass. */
-        prime_epan_dissect_with_postdissector_wanted_hfids(edt);
-    }
+        if (first_pass) {
+            /* This is the first pass, so prime the epan_dissect_t with the
+               hfids postdissectors want on the first pass. */
+            prime_epan_dissect_with_postdissector_wanted_hfids(edt);
 
-    /* Dissect the frame. */
-    epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-            frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
-            fdata, cinfo);
+            if (cf->field_index != NULL && edt->tree != NULL) {
+                field_index_prime_edt(cf->field_index, edt);
+            }
+        }
 
-    /* If we don't have a display filter, set "passed_dfilter" to 1. */
-    if (dfcode != NULL) {
-        fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
+        /* Dissect the frame. */
+        epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
+                fdata, cinfo);
+        dissected = TRUE;
 
-        if (fdata->passed_dfilter && edt->pi.fd->dependent_frames) {
-            /* This frame passed the display filter but it may depend on other
-             * (potentially not displayed) frames.  Find those frames and mark them
-             * as depended upon.
-             */
-            g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+        if (first_pass && cf->field_index != NULL) {
+            field_index_add_frame(cf->field_index, fdata->num, edt->tree);
         }
-    } else
-        fdata->passed_dfilter = 1;
+
+        /* If we don't have a display filter, set "passed_dfilter" to 1. */
+        if (dfcode != NULL) {
+            fdata->passed_dfilter = dfilter_apply_edt(dfcode, edt) ? 1 : 0;
+
+            if (fdata->passed_dfilter && edt->pi.fd->dependent_frames) {
+                /* This frame passed the display filter but it may depend on other
+                 * (potentially not displayed) frames.  Find those frames and mark them
+                 * as depended upon.
+                 */
+                g_hash_table_foreach(edt->pi.fd->dependent_frames, find_and_mark_frame_depended_upon, cf->provider.frames);
+            }
+        } else
+            fdata->passed_dfilter = 1;
+    }
 
     if (fdata->passed_dfilter || fdata->ref_time)
         cf->displayed_count++;
@@ -1268,7 +1331,8 @@ add_packet_to_packet_list(frame_data *fdata, capture_file *cf,
         cf->last_displayed = fdata->num;
     }
 
-    epan_dissect_reset(edt);
+    if (dissected)
+        epan_dissect_reset(edt);
 }
 
 /*
@@ -1346,7 +1410,7 @@ read_record(capture_file *cf, wtap_rec *rec, Buffer *buf, dfilter_t *dfcode,
         /* When a redissection is in progress (or queued), do not process packets.
          * This will be done once all (new) packets have been scanned. */
         if (!cf->redissecting && cf->redissection_queued == RESCAN_NONE) {
-            add_packet_to_packet_list(fdata, cf, edt, dfcode, cinfo, rec, buf, TRUE);
+            add_packet_to_packet_list(fdata, cf, edt, dfcode, cinfo, rec, buf, TRUE, FILTER_BY_DISSECTING);
         }
     }
 
@@ -1533,6 +1597,25 @@ cf_merge_files_to_tempfile(gpointer pd_window, const char *temp_dir, char **out_
         return CF_OK;
 }
 
+void
+cf_set_filter_frames(capture_file *cf, const char *dftext,
+        const guint32 *frames, guint num_frames)
+{
+    g_free(cf->filter_frames_dfilter);
+    cf->filter_frames_dfilter = NULL;
+    if (cf->filter_frames != NULL) {
+        g_array_free(cf->filter_frames, TRUE);
+        cf->filter_frames = NULL;
+    }
+
+    if (dftext == NULL || frames == NULL)
+        return;
+
+    cf->filter_frames_dfilter = g_strdup(dftext);
+    cf->filter_frames = g_array_sized_new(FALSE, FALSE, sizeof(guint32), num_frames);
+    g_array_append_vals(cf->filter_frames, frames, num_frames);
+}
+
 cf_status_t
 cf_filter_packets(capture_file *cf, gchar *dftext, gboolean force)
 {
@@ -1696,6 +1779,10 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     gboolean    filtering_tap_listeners = FALSE;
     guint       tap_flags;
     gboolean    add_to_packet_list = FALSE;
+    gboolean    use_field_index = FALSE;
+    GArray     *filter_frames = NULL;
+    guint       next_filter_frame = 0;
+    filter_method_e filter_method;
     gboolean    compiled _U_;
     guint32     frames_count;
     gboolean    queued_rescan_type = RESCAN_NONE;
@@ -1808,12 +1895,48 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
             cinfo = &cf->cinfo;
         }
 
+        /* Field values may change with the new dissection state, so
+           rebuild the field index while redissecting. */
+        field_index_free(cf->field_index);
+        cf->field_index = field_index_new_from_prefs();
+        if (cf->field_index != NULL) {
+            create_proto_tree = TRUE;
+        }
+
         /* We need to redissect the packets so we have to discard our old
          * packet list store. */
         packet_list_clear();
         add_to_packet_list = TRUE;
     }
 
+    /*
+     * If we're only refiltering, no tap listener needs to see the packets
+     * and the display filter only reads indexed fields, apply the filter
+     * to the field index instead of dissecting the frames again.
+     */
+    if (!redissect && dfcode != NULL && !tap_listeners_require_dissection() &&
+            field_index_can_filter(cf->field_index, dfcode)) {
+        use_field_index = TRUE;
+        ws_debug("Filtering %u of %u frames with the field index",
+                field_index_num_frames(cf->field_index), cf->count);
+    }
+
+    /*
+     * If we were told which frames can match this display filter, and
+     * no tap listener looks at any other frames, hide the rest without
+     * dissecting them. That only holds for this filtering.
+     */
+    if (cf->filter_frames != NULL) {
+        if (!redissect && dfcode != NULL &&
+                g_strcmp0(cf->dfilter, cf->filter_frames_dfilter) == 0 &&
+                tap_listeners_filtered_by(cf->dfilter)) {
+            filter_frames = cf->filter_frames;
+            cf->filter_frames = NULL;
+            ws_debug("Filtering only %u of %u frames", filter_frames->len, cf->count);
+        }
+        cf_set_filter_frames(cf, NULL, NULL, 0);
+    }
+
     /* We don't yet know which will be the first and last frames displayed. */
     cf->first_displayed = 0;
     cf->last_displayed = 0;
@@ -1942,7 +2065,21 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
         /* Frame dependencies from the previous dissection/filtering are no longer valid. */
         fdata->dependent_of_displayed = 0;
 
-        if (!cf_read_record(cf, fdata, &rec, &buf))
+        filter_method = use_field_index ? FILTER_BY_FIELD_INDEX : FILTER_BY_DISSECTING;
+        if (filter_frames != NULL) {
+            while (next_filter_frame < filter_frames->len &&
+                    g_array_index(filter_frames, guint32, next_filter_frame) < framenum)
+                next_filter_frame++;
+            if (next_filter_frame >= filter_frames->len ||
+                    g_array_index(filter_frames, guint32, next_filter_frame) != framenum)
+                filter_method = FILTER_REJECT;
+        }
+
+        /* Frames that are rejected or in the field index aren't dissected,
+           so we don't need their data. */
+        if (filter_method != FILTER_REJECT &&
+                !(filter_method == FILTER_BY_FIELD_INDEX && framenum <= field_index_num_frames(cf->field_index)) &&
+                !cf_read_record(cf, fdata, &rec, &buf))
             break; /* error reading the frame */
 
         /* If the previous frame is displayed, and we haven't yet seen the
@@ -1955,7 +2092,7 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
 
         add_packet_to_packet_list(fdata, cf, &edt, dfcode,
                 cinfo, &rec, &buf,
-                add_to_packet_list);
+                add_to_packet_list, filter_method);
 
         /* If this frame is displayed, and this is the first frame we've
            seen displayed after the selected frame, remember this frame -
@@ -1981,6 +2118,8 @@ rescan_packets(capture_file *cf, const char *action, const char *action_item, gb
     epan_dissect_cleanup(&edt);
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
+    if (filter_frames != NULL)
+        g_array_free(filter_frames, TRUE);
 
     /* We are done redissecting the packet list. */
     cf->redissecting = FALSE;
@@ -2336,6 +2475,19 @@ retap_packet(capture_file *cf, frame_data *fdata, wtap_rec *rec, Buffer *buf,
 {
     retap_callback_args_t *args = (retap_callback_args_t *)argsp;
 
+    /* Removing or resetting a listener while retapping ends the parallel
+       retap, so check for every packet. */
+    if (tap_parallel_active()) {
+        /* The frame's tap data has to outlive this call, so dissect it
+           into a slot of the parallel tap window. */
+        epan_dissect_t *edt = tap_parallel_next_frame(&rec, &buf);
+
+        epan_dissect_run_with_taps(edt, cf->cd_t, rec,
+                frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
+                fdata, NULL);
+        return TRUE;
+    }
+
     epan_dissect_run_with_taps(&args->edt, cf->cd_t, rec,
             frame_tvbuff_new_buffer(&cf->provider, fdata, buf),
             fdata, args->cinfo);
@@ -2393,6 +2545,11 @@ cf_retap_packets(capture_file *cf)
 
     epan_dissect_init(&callback_args.edt, cf->epan, create_proto_tree, FALSE);
 
+    /* Run the packet callbacks of listeners that can merge their results
+       on worker threads.  The columns are shared, so not if they're needed. */
+    if (callback_args.cinfo == NULL)
+        tap_parallel_begin(cf->epan, create_proto_tree, 0);
+
     /* Iterate through the list of packets, dissecting all packets and
        re-running the taps. */
     packet_range_init(&range, cf);
@@ -2402,6 +2559,8 @@ cf_retap_packets(capture_file *cf)
             "all packets", TRUE, retap_packet,
             &callback_args, TRUE);
 
+    tap_parallel_end();
+
     packet_range_cleanup(&range);
     epan_dissect_cleanup(&callback_args.edt);
 
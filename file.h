@@ -399,6 +399,19 @@ void cf_set_rfcode(capture_file *cf, dfilter_t *rfcode);
  */
 cf_status_t cf_filter_packets(capture_file *cf, gchar *dfilter, gboolean force);
 
+/**
+ * Tell the next refiltering with a display filter which frames can match
+ * it, e.g. the frames of a followed stream. If no tap listener looks at
+ * other frames, the remaining frames are hidden without dissecting them.
+ *
+ * @param cf the capture file
+ * @param dfilter the display filter
+ * @param frames the frame numbers, in ascending order
+ * @param num_frames the number of frames
+ */
+void cf_set_filter_frames(capture_file *cf, const char *dfilter,
+        const guint32 *frames, guint num_frames);
+
 /**
  * Scan through all frame data and recalculate the ref time
  * without rereading the file.
@@ -37,6 +37,7 @@
 #include <wsutil/version_info.h>
 
 #include "randpkt_core/randpkt_core.h"
+#include "randpkt_core/randpkt_flow.h"
 
 /* Additional exit codes */
 #define INVALID_TYPE 2
@@ -105,6 +106,21 @@ usage(gboolean is_error)
     fprintf(output, "  -h, --help        display this help and exit.\n");
     fprintf(output, "  -v, --version     print version information and exit.\n");
     fprintf(output, "\n");
+    fprintf(output, "Flow options:\n");
+    fprintf(output, "  --flows <count>   write complete flows instead of random packets\n");
+    fprintf(output, "                    (default: 1000)\n");
+    fprintf(output, "  --duration <sec>  write flows for the given time, at the flow rate\n");
+    fprintf(output, "  --flow-rate <n>   new flows per second (default: 100)\n");
+    fprintf(output, "  --flow-size <n>   mean bytes sent by the server (default: 20000)\n");
+    fprintf(output, "  --flow-size-dist <fixed|exponential|pareto>\n");
+    fprintf(output, "                    flow size distribution (default: pareto)\n");
+    fprintf(output, "  --flow-mix <mix>  weights of each flow type\n");
+    fprintf(output, "                    (default: dns:30,http:30,tls:20,http2:20)\n");
+    fprintf(output, "  --loss <p>        fraction of segments retransmitted (default: 0.01)\n");
+    fprintf(output, "  --reorder <p>     fraction of segments out of order (default: 0.01)\n");
+    fprintf(output, "  --seed <seed>     random seed; the same seed gives the same file\n");
+    fprintf(output, "  --keylog <file>   write the TLS secrets to a key log file\n");
+    fprintf(output, "\n");
     fprintf(output, "Types:\n");
 
     /* Get the examples list */
@@ -147,9 +163,33 @@ main(int argc, char *argv[])
     int allrandom = FALSE;
     wtap_dumper *savedump;
     int ret = EXIT_SUCCESS;
+    gboolean flow_mode = FALSE;
+    double flow_duration = 0.0;
+    char *keylog_filename = NULL;
+    randpkt_flow_params flow_params;
+#define LONGOPT_FLOWS                LONGOPT_BASE_APPLICATION+1
+#define LONGOPT_DURATION             LONGOPT_BASE_APPLICATION+2
+#define LONGOPT_FLOW_RATE            LONGOPT_BASE_APPLICATION+3
+#define LONGOPT_FLOW_SIZE            LONGOPT_BASE_APPLICATION+4
+#define LONGOPT_FLOW_SIZE_DIST       LONGOPT_BASE_APPLICATION+5
+#define LONGOPT_FLOW_MIX             LONGOPT_BASE_APPLICATION+6
+#define LONGOPT_LOSS                 LONGOPT_BASE_APPLICATION+7
+#define LONGOPT_REORDER              LONGOPT_BASE_APPLICATION+8
+#define LONGOPT_SEED                 LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_KEYLOG               LONGOPT_BASE_APPLICATION+10
     static const struct ws_option long_options[] = {
         {"help", ws_no_argument, NULL, 'h'},
         {"version", ws_no_argument, NULL, 'v'},
+        {"flows", ws_required_argument, NULL, LONGOPT_FLOWS},
+        {"duration", ws_required_argument, NULL, LONGOPT_DURATION},
+        {"flow-rate", ws_required_argument, NULL, LONGOPT_FLOW_RATE},
+        {"flow-size", ws_required_argument, NULL, LONGOPT_FLOW_SIZE},
+        {"flow-size-dist", ws_required_argument, NULL, LONGOPT_FLOW_SIZE_DIST},
+        {"flow-mix", ws_required_argument, NULL, LONGOPT_FLOW_MIX},
+        {"loss", ws_required_argument, NULL, LONGOPT_LOSS},
+        {"reorder", ws_required_argument, NULL, LONGOPT_REORDER},
+        {"seed", ws_required_argument, NULL, LONGOPT_SEED},
+        {"keylog", ws_required_argument, NULL, LONGOPT_KEYLOG},
         {0, 0, 0, 0 }
     };
 
@@ -190,6 +230,8 @@ main(int argc, char *argv[])
 
     ws_init_version_info("Randpkt", NULL, NULL);
 
+    randpkt_flow_params_init(&flow_params);
+
     while ((opt = ws_getopt_long(argc, argv, "b:c:F:ht:rv", long_options, NULL)) != -1) {
         switch (opt) {
             case 'b':	/* max bytes */
@@ -233,6 +275,60 @@ main(int argc, char *argv[])
                 goto clean_exit;
                 break;
 
+            case LONGOPT_FLOWS:
+                flow_params.flow_count = get_positive_int(ws_optarg, "flow count");
+                flow_mode = TRUE;
+                break;
+
+            case LONGOPT_DURATION:
+                flow_duration = get_positive_double(ws_optarg, "duration");
+                flow_mode = TRUE;
+                break;
+
+            case LONGOPT_FLOW_RATE:
+                flow_params.flow_rate = get_positive_double(ws_optarg, "flow rate");
+                if (flow_params.flow_rate == 0.0) {
+                    cmdarg_err("The flow rate must be greater than zero");
+                    ret = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+
+            case LONGOPT_FLOW_SIZE:
+                flow_params.flow_size = get_positive_int(ws_optarg, "flow size");
+                break;
+
+            case LONGOPT_FLOW_SIZE_DIST:
+                if (!randpkt_flow_parse_size_dist(&flow_params, ws_optarg)) {
+                    ret = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+
+            case LONGOPT_FLOW_MIX:
+                if (!randpkt_flow_parse_mix(&flow_params, ws_optarg)) {
+                    ret = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+
+            case LONGOPT_LOSS:
+                flow_params.loss = get_positive_double(ws_optarg, "loss");
+                break;
+
+            case LONGOPT_REORDER:
+                flow_params.reorder = get_positive_double(ws_optarg, "reorder");
+                break;
+
+            case LONGOPT_SEED:
+                flow_params.seed = get_guint32(ws_optarg, "seed");
+                break;
+
+            case LONGOPT_KEYLOG:
+                g_free(keylog_filename);
+                keylog_filename = g_strdup(ws_optarg);
+                break;
+
             case '?':
                 switch(ws_optopt) {
                     case 'F':
@@ -263,6 +359,20 @@ main(int argc, char *argv[])
         file_type_subtype = wtap_pcapng_file_type_subtype();
     }
 
+    if (flow_mode) {
+        if (type || allrandom) {
+            cmdarg_err("Packet types can't be used with flows");
+            ret = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (flow_duration > 0.0) {
+            flow_params.flow_count = (guint64)(flow_duration * flow_params.flow_rate);
+        }
+        ret = randpkt_flow_generate(&flow_params, produce_filename,
+            file_type_subtype, keylog_filename);
+        goto clean_exit;
+    }
+
     if (!allrandom) {
         produce_type = randpkt_parse_type(type);
         g_free(type);
@@ -314,6 +424,7 @@ main(int argc, char *argv[])
     }
 
 clean_exit:
+    g_free(keylog_filename);
     wtap_cleanup();
     return ret;
 }
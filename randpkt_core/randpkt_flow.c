@@ -0,0 +1,1223 @@
+/*
+ * randpkt_flow.c
+ * ---------
+ * Creates deterministic traces of complete flows for dissection
+ * benchmarks. Unlike the random packets in randpkt_core.c, these are
+ * well-formed conversations: TCP handshakes, segmentation, retransmissions
+ * and out-of-order segments, DNS lookups, HTTP/1.1, and HTTP/1.1 or HTTP/2
+ * over TLS 1.3 with a keylog that decrypts them.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <config.h>
+#define WS_LOG_DOMAIN "randpkt"
+
+#include "randpkt_flow.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/pint.h>
+#include <wsutil/wsgcrypt.h>
+#include <wsutil/wslog.h>
+#include <wiretap/wtap.h>
+
+#include "ui/failure_message.h"
+
+#define WRITE_ERROR 2
+
+/* Captures start at a fixed time so that the same seed gives the same file */
+#define FLOW_EPOCH		1700000000
+
+#define FLOW_MSS		1448
+#define FLOW_MAX_SIZE		(64 * 1024 * 1024)
+#define FLOW_PARETO_ALPHA	1.5
+#define FLOW_FILLER_SIZE	65536
+
+#define TLS_MAX_RECORD		16384
+#define HTTP2_MAX_FRAME		16384
+
+#define ETH_HDR_LEN	14
+#define IP_HDR_LEN	20
+#define TCP_HDR_LEN	20
+#define UDP_HDR_LEN	8
+
+#define FLOW_PROTO_TCP	6
+#define FLOW_PROTO_UDP	17
+
+#define TCP_FIN	0x01
+#define TCP_SYN	0x02
+#define TCP_PSH	0x08
+#define TCP_ACK	0x10
+
+#define CLIENT	0
+#define SERVER	1
+
+static const char *flow_type_names[RANDPKT_FLOW_NUM_TYPES] = {
+	"dns",
+	"http",
+	"tls",
+	"http2"
+};
+
+static const char *size_dist_names[] = {
+	"fixed",
+	"exponential",
+	"pareto"
+};
+
+/* A generated flow, whose packets are waiting to be written */
+typedef struct {
+	GByteArray *data;
+	GArray *pkts;		/* flow_pkt, in time order */
+	guint next_pkt;
+} flow_t;
+
+typedef struct {
+	guint64 ts_us;		/* Since the start of the capture */
+	guint offset;		/* Into flow_t.data */
+	guint len;
+} flow_pkt;
+
+typedef struct {
+	const randpkt_flow_params *params;
+	GRand *rand;
+	FILE *keylog;
+	guint8 filler[FLOW_FILLER_SIZE];	/* Body content */
+	guint weight_total;
+	guint64 flow_num;
+} flow_gen_t;
+
+/* One TCP or UDP conversation between a client and a server */
+typedef struct {
+	flow_gen_t *gen;
+	flow_t *flow;
+	guint8 mac[2][6];
+	guint32 addr[2];
+	guint16 port[2];
+	guint32 seq[2];		/* Next sequence number to send */
+	guint16 ip_id[2];
+	guint64 now;		/* Current time in microseconds */
+	guint64 rtt;
+	guint64 gap;		/* Between back-to-back segments */
+	guint8 proto;
+} conn_t;
+
+/* A TLS 1.3 session using TLS_AES_128_GCM_SHA256 */
+typedef struct {
+	guint8 client_random[32];
+	guint8 key[2][16];
+	guint8 iv[2][12];
+	guint64 seq[2];
+} tls_session_t;
+
+/*
+ * Byte array helpers
+ */
+
+static void
+put8(GByteArray *ba, guint8 v)
+{
+	g_byte_array_append(ba, &v, 1);
+}
+
+static void
+put16(GByteArray *ba, guint16 v)
+{
+	guint8 b[2];
+	phton16(b, v);
+	g_byte_array_append(ba, b, 2);
+}
+
+static void
+put24(GByteArray *ba, guint32 v)
+{
+	guint8 b[3] = { (guint8)(v >> 16), (guint8)(v >> 8), (guint8)v };
+	g_byte_array_append(ba, b, 3);
+}
+
+static void
+put32(GByteArray *ba, guint32 v)
+{
+	guint8 b[4];
+	phton32(b, v);
+	g_byte_array_append(ba, b, 4);
+}
+
+static void
+put_bytes(GByteArray *ba, const void *data, guint len)
+{
+	g_byte_array_append(ba, (const guint8 *)data, len);
+}
+
+static void
+put_random(flow_gen_t *gen, GByteArray *ba, guint len)
+{
+	guint i;
+
+	for (i = 0; i < len; i++)
+		put8(ba, (guint8)g_rand_int_range(gen->rand, 0, 0x100));
+}
+
+/* Body content, taken from the filler block at a random offset */
+static void
+put_filler(flow_gen_t *gen, GByteArray *ba, guint64 len)
+{
+	guint offset = g_rand_int_range(gen->rand, 0, FLOW_FILLER_SIZE);
+
+	while (len > 0) {
+		guint chunk = (guint)MIN(len, (guint64)(FLOW_FILLER_SIZE - offset));
+		put_bytes(ba, &gen->filler[offset], chunk);
+		len -= chunk;
+		offset = 0;
+	}
+}
+
+/* Patch a 16 or 24 bit length at offset to cover everything after it */
+static void
+patch_len16(GByteArray *ba, guint offset)
+{
+	phton16(&ba->data[offset], (guint16)(ba->len - offset - 2));
+}
+
+static void
+patch_len24(GByteArray *ba, guint offset)
+{
+	guint32 len = ba->len - offset - 3;
+	ba->data[offset] = (guint8)(len >> 16);
+	ba->data[offset + 1] = (guint8)(len >> 8);
+	ba->data[offset + 2] = (guint8)len;
+}
+
+/*
+ * Packets
+ */
+
+static guint32
+cksum_add(guint32 sum, const guint8 *p, guint len)
+{
+	guint i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += pntoh16(&p[i]);
+	if (len & 1)
+		sum += p[len - 1] << 8;
+	return sum;
+}
+
+static guint16
+cksum_fold(guint32 sum)
+{
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return (guint16)~sum;
+}
+
+/* Add a packet to the flow at the connection's current time */
+static void
+add_packet(conn_t *conn, int dir, guint8 tcp_flags, guint32 seq, guint32 ack,
+	const guint8 *payload, guint payload_len)
+{
+	GByteArray *data = conn->flow->data;
+	guint l4_len = (conn->proto == FLOW_PROTO_TCP ? TCP_HDR_LEN : UDP_HDR_LEN) + payload_len;
+	flow_pkt pkt;
+	guint8 *p;
+	guint32 sum;
+
+	pkt.ts_us = conn->now;
+	pkt.offset = data->len;
+	pkt.len = ETH_HDR_LEN + IP_HDR_LEN + l4_len;
+	g_byte_array_set_size(data, data->len + pkt.len);
+	p = &data->data[pkt.offset];
+
+	/* Ethernet */
+	memcpy(p, conn->mac[!dir], 6);
+	memcpy(p + 6, conn->mac[dir], 6);
+	phton16(p + 12, 0x0800);
+	p += ETH_HDR_LEN;
+
+	/* IPv4 */
+	p[0] = 0x45;
+	p[1] = 0;
+	phton16(p + 2, (guint16)(IP_HDR_LEN + l4_len));
+	phton16(p + 4, conn->ip_id[dir]++);
+	phton16(p + 6, 0x4000);		/* Don't fragment */
+	p[8] = dir == CLIENT ? 64 : 57;
+	p[9] = conn->proto;
+	phton16(p + 10, 0);
+	phton32(p + 12, conn->addr[dir]);
+	phton32(p + 16, conn->addr[!dir]);
+	phton16(p + 10, cksum_fold(cksum_add(0, p, IP_HDR_LEN)));
+
+	/* Pseudo-header for the TCP or UDP checksum */
+	sum = cksum_add(0, p + 12, 8);
+	sum += conn->proto;
+	sum += l4_len;
+	p += IP_HDR_LEN;
+
+	phton16(p, conn->port[dir]);
+	phton16(p + 2, conn->port[!dir]);
+	if (conn->proto == FLOW_PROTO_TCP) {
+		phton32(p + 4, seq);
+		phton32(p + 8, (tcp_flags & TCP_ACK) ? ack : 0);
+		p[12] = (TCP_HDR_LEN / 4) << 4;
+		p[13] = tcp_flags;
+		phton16(p + 14, 0xffff);
+		phton16(p + 16, 0);
+		phton16(p + 18, 0);
+		memcpy(p + TCP_HDR_LEN, payload, payload_len);
+		phton16(p + 16, cksum_fold(cksum_add(sum, p, l4_len)));
+	} else {
+		phton16(p + 4, (guint16)l4_len);
+		phton16(p + 6, 0);
+		memcpy(p + UDP_HDR_LEN, payload, payload_len);
+		phton16(p + 6, cksum_fold(cksum_add(sum, p, l4_len)));
+	}
+
+	g_array_append_val(conn->flow->pkts, pkt);
+}
+
+static void
+conn_init(conn_t *conn, flow_gen_t *gen, flow_t *flow, guint64 start, guint8 proto, guint16 server_port)
+{
+	guint64 flow_num = gen->flow_num;
+
+	memset(conn, 0, sizeof *conn);
+	conn->gen = gen;
+	conn->flow = flow;
+	conn->proto = proto;
+	conn->now = start;
+
+	/* Clients in 10.0.0.0/8, servers in 198.18.0.0/15 */
+	conn->addr[CLIENT] = 0x0a000000 | (guint32)(g_rand_int(gen->rand) & 0x00ffffff);
+	conn->addr[SERVER] = 0xc6120000 | (guint32)(g_rand_int(gen->rand) & 0x0001ffff);
+	conn->port[CLIENT] = (guint16)g_rand_int_range(gen->rand, 32768, 61000);
+	conn->port[SERVER] = server_port;
+
+	/* Locally administered MAC addresses derived from the flow number */
+	conn->mac[CLIENT][0] = 0x02;
+	phton32(&conn->mac[CLIENT][2], (guint32)flow_num);
+	conn->mac[SERVER][0] = 0x02;
+	conn->mac[SERVER][1] = 0xff;
+	phton32(&conn->mac[SERVER][2], conn->addr[SERVER]);
+
+	conn->ip_id[CLIENT] = (guint16)g_rand_int(gen->rand);
+	conn->ip_id[SERVER] = (guint16)g_rand_int(gen->rand);
+	conn->seq[CLIENT] = g_rand_int(gen->rand);
+	conn->seq[SERVER] = g_rand_int(gen->rand);
+
+	/* Round trip times between 1 and 100 ms, spread evenly on a log scale */
+	conn->rtt = (guint64)(1000.0 * exp(g_rand_double(gen->rand) * log(100.0)));
+	/* Roughly 100 Mb/s to 1 Gb/s for full sized segments */
+	conn->gap = g_rand_int_range(gen->rand, 12, 120);
+}
+
+/*
+ * TCP
+ */
+
+static void
+tcp_handshake(conn_t *conn)
+{
+	add_packet(conn, CLIENT, TCP_SYN, conn->seq[CLIENT]++, 0, NULL, 0);
+	conn->now += conn->rtt;
+	add_packet(conn, SERVER, TCP_SYN|TCP_ACK, conn->seq[SERVER]++, conn->seq[CLIENT], NULL, 0);
+	conn->now += 50;
+	add_packet(conn, CLIENT, TCP_ACK, conn->seq[CLIENT], conn->seq[SERVER], NULL, 0);
+}
+
+/*
+ * Send data in MSS sized segments, acknowledging every second one. Some
+ * segments are sent in swapped order, and some are sent again after a
+ * round trip, as if they were lost after passing the capture point.
+ */
+static void
+tcp_send(conn_t *conn, int dir, const guint8 *data, guint len)
+{
+	const randpkt_flow_params *params = conn->gen->params;
+	guint n_segs = (len + FLOW_MSS - 1) / FLOW_MSS;
+	guint32 base = conn->seq[dir];
+	guint *order;
+	gboolean *received;
+	GArray *lost;
+	guint contig = 0;	/* Segments received in order */
+	guint unacked = 0;
+	guint i;
+
+	if (len == 0)
+		return;
+
+	order = g_new(guint, n_segs);
+	received = g_new0(gboolean, n_segs);
+	lost = g_array_new(FALSE, FALSE, sizeof(guint));
+
+	for (i = 0; i < n_segs; i++)
+		order[i] = i;
+	for (i = 0; i + 1 < n_segs; i += 2) {
+		if (g_rand_double(conn->gen->rand) < params->reorder) {
+			order[i] = i + 1;
+			order[i + 1] = i;
+		}
+	}
+
+	for (i = 0; i < n_segs; i++) {
+		guint seg = order[i];
+		guint off, seg_len;
+
+		off = seg * FLOW_MSS;
+		seg_len = MIN(FLOW_MSS, len - off);
+		conn->now += conn->gap;
+		add_packet(conn, dir, seg == n_segs - 1 ? TCP_PSH|TCP_ACK : TCP_ACK,
+			base + off, conn->seq[!dir], data + off, seg_len);
+
+		if (g_rand_double(conn->gen->rand) < params->loss) {
+			g_array_append_val(lost, seg);
+		} else {
+			received[seg] = TRUE;
+		}
+		while (contig < n_segs && received[contig])
+			contig++;
+
+		if (++unacked == 2) {
+			unacked = 0;
+			conn->now += 20;
+			add_packet(conn, !dir, TCP_ACK, conn->seq[!dir],
+				base + MIN(contig * FLOW_MSS, len), NULL, 0);
+		}
+	}
+
+	/* Retransmit after a round trip */
+	if (lost->len > 0) {
+		conn->now += conn->rtt;
+		for (i = 0; i < lost->len; i++) {
+			guint seg = g_array_index(lost, guint, i);
+			guint off = seg * FLOW_MSS;
+
+			conn->now += conn->gap;
+			add_packet(conn, dir, TCP_PSH|TCP_ACK, base + off, conn->seq[!dir],
+				data + off, MIN(FLOW_MSS, len - off));
+		}
+	}
+
+	conn->seq[dir] += len;
+	conn->now += conn->rtt / 2;
+	add_packet(conn, !dir, TCP_ACK, conn->seq[!dir], conn->seq[dir], NULL, 0);
+
+	g_array_free(lost, TRUE);
+	g_free(received);
+	g_free(order);
+}
+
+static void
+tcp_close(conn_t *conn)
+{
+	conn->now += 100;
+	add_packet(conn, CLIENT, TCP_FIN|TCP_ACK, conn->seq[CLIENT]++, conn->seq[SERVER], NULL, 0);
+	conn->now += conn->rtt;
+	add_packet(conn, SERVER, TCP_FIN|TCP_ACK, conn->seq[SERVER]++, conn->seq[CLIENT], NULL, 0);
+	conn->now += 50;
+	add_packet(conn, CLIENT, TCP_ACK, conn->seq[CLIENT], conn->seq[SERVER], NULL, 0);
+}
+
+/*
+ * TLS 1.3
+ */
+
+/* HKDF-Expand-Label from RFC 8446 with an empty context */
+static void
+hkdf_expand_label(const guint8 *secret, const char *label, guint8 *out, guint out_len)
+{
+	guint8 info[64];
+	guint label_len = (guint)strlen(label);
+
+	phton16(info, (guint16)out_len);
+	info[2] = (guint8)(6 + label_len);
+	memcpy(&info[3], "tls13 ", 6);
+	memcpy(&info[9], label, label_len);
+	info[9 + label_len] = 0;
+	hkdf_expand(GCRY_MD_SHA256, secret, 32, info, 10 + label_len, out, out_len);
+}
+
+/* Pick a new traffic secret for one direction, and log it */
+static void
+tls_new_secret(flow_gen_t *gen, tls_session_t *tls, int dir, const char *keylog_label)
+{
+	guint8 secret[32];
+	guint i;
+
+	for (i = 0; i < sizeof secret; i++)
+		secret[i] = (guint8)g_rand_int_range(gen->rand, 0, 0x100);
+
+	hkdf_expand_label(secret, "key", tls->key[dir], sizeof tls->key[dir]);
+	hkdf_expand_label(secret, "iv", tls->iv[dir], sizeof tls->iv[dir]);
+	tls->seq[dir] = 0;
+
+	if (gen->keylog) {
+		fprintf(gen->keylog, "%s ", keylog_label);
+		for (i = 0; i < sizeof tls->client_random; i++)
+			fprintf(gen->keylog, "%02x", tls->client_random[i]);
+		fprintf(gen->keylog, " ");
+		for (i = 0; i < sizeof secret; i++)
+			fprintf(gen->keylog, "%02x", secret[i]);
+		fprintf(gen->keylog, "\n");
+	}
+}
+
+/* Append data as encrypted records of the given inner content type */
+static void
+tls_encrypt(tls_session_t *tls, int dir, guint8 content_type, const guint8 *data, guint len, GByteArray *out)
+{
+	gcry_cipher_hd_t cipher;
+	guint8 *inner = (guint8 *)g_malloc(TLS_MAX_RECORD + 1);
+	guint off = 0;
+
+	if (gcry_cipher_open(&cipher, GCRY_CIPHER_AES128, GCRY_CIPHER_MODE_GCM, 0) != 0) {
+		g_free(inner);
+		return;
+	}
+	gcry_cipher_setkey(cipher, tls->key[dir], sizeof tls->key[dir]);
+
+	do {
+		guint chunk = MIN(len - off, TLS_MAX_RECORD);
+		guint8 header[5];
+		guint8 nonce[12];
+		guint rec_off;
+		int i;
+
+		memcpy(inner, data + off, chunk);
+		inner[chunk] = content_type;
+
+		header[0] = 0x17;	/* application_data */
+		phton16(&header[1], 0x0303);
+		phton16(&header[3], (guint16)(chunk + 1 + 16));
+
+		memcpy(nonce, tls->iv[dir], sizeof nonce);
+		for (i = 0; i < 8; i++)
+			nonce[4 + i] ^= (guint8)(tls->seq[dir] >> (56 - 8 * i));
+		tls->seq[dir]++;
+
+		put_bytes(out, header, sizeof header);
+		rec_off = out->len;
+		g_byte_array_set_size(out, out->len + chunk + 1 + 16);
+
+		gcry_cipher_reset(cipher);
+		gcry_cipher_setiv(cipher, nonce, sizeof nonce);
+		gcry_cipher_authenticate(cipher, header, sizeof header);
+		gcry_cipher_encrypt(cipher, &out->data[rec_off], chunk + 1, inner, chunk + 1);
+		gcry_cipher_gettag(cipher, &out->data[rec_off + chunk + 1], 16);
+
+		off += chunk;
+	} while (off < len);
+
+	gcry_cipher_close(cipher);
+	g_free(inner);
+}
+
+static void
+tls_put_change_cipher_spec(GByteArray *out)
+{
+	static const guint8 ccs[] = { 0x14, 0x03, 0x03, 0x00, 0x01, 0x01 };
+	put_bytes(out, ccs, sizeof ccs);
+}
+
+/* Run the handshake, leaving the session with the application traffic keys */
+static void
+tls_handshake(conn_t *conn, tls_session_t *tls, const char *server_name, const char *alpn)
+{
+	flow_gen_t *gen = conn->gen;
+	GByteArray *out = g_byte_array_new();
+	GByteArray *hs = g_byte_array_new();
+	guint8 session_id[32];
+	guint rec, msg, exts, ext, list;
+	guint i;
+
+	for (i = 0; i < sizeof tls->client_random; i++)
+		tls->client_random[i] = (guint8)g_rand_int_range(gen->rand, 0, 0x100);
+	for (i = 0; i < sizeof session_id; i++)
+		session_id[i] = (guint8)g_rand_int_range(gen->rand, 0, 0x100);
+
+	/* ClientHello */
+	put8(out, 0x16);
+	put16(out, 0x0301);
+	rec = out->len;
+	put16(out, 0);
+	put8(out, 1);
+	msg = out->len;
+	put24(out, 0);
+	put16(out, 0x0303);
+	put_bytes(out, tls->client_random, sizeof tls->client_random);
+	put8(out, sizeof session_id);
+	put_bytes(out, session_id, sizeof session_id);
+	put16(out, 2);
+	put16(out, 0x1301);		/* TLS_AES_128_GCM_SHA256 */
+	put8(out, 1);
+	put8(out, 0);
+	exts = out->len;
+	put16(out, 0);
+	/* server_name */
+	put16(out, 0x0000);
+	ext = out->len;
+	put16(out, 0);
+	list = out->len;
+	put16(out, 0);
+	put8(out, 0);
+	put16(out, (guint16)strlen(server_name));
+	put_bytes(out, server_name, (guint)strlen(server_name));
+	patch_len16(out, list);
+	patch_len16(out, ext);
+	/* supported_groups: x25519 */
+	put16(out, 0x000a);
+	put16(out, 4);
+	put16(out, 2);
+	put16(out, 0x001d);
+	/* signature_algorithms: rsa_pss_rsae_sha256 */
+	put16(out, 0x000d);
+	put16(out, 4);
+	put16(out, 2);
+	put16(out, 0x0804);
+	/* application_layer_protocol_negotiation */
+	put16(out, 0x0010);
+	ext = out->len;
+	put16(out, 0);
+	list = out->len;
+	put16(out, 0);
+	put8(out, (guint8)strlen(alpn));
+	put_bytes(out, alpn, (guint)strlen(alpn));
+	patch_len16(out, list);
+	patch_len16(out, ext);
+	/* supported_versions: TLS 1.3 */
+	put16(out, 0x002b);
+	put16(out, 3);
+	put8(out, 2);
+	put16(out, 0x0304);
+	/* key_share */
+	put16(out, 0x0033);
+	put16(out, 2 + 2 + 2 + 32);
+	put16(out, 2 + 2 + 32);
+	put16(out, 0x001d);
+	put16(out, 32);
+	put_random(gen, out, 32);
+	patch_len16(out, exts);
+	patch_len24(out, msg);
+	patch_len16(out, rec);
+
+	tcp_send(conn, CLIENT, out->data, out->len);
+	g_byte_array_set_size(out, 0);
+
+	/* ServerHello */
+	conn->now += conn->rtt / 2;
+	put8(out, 0x16);
+	put16(out, 0x0303);
+	rec = out->len;
+	put16(out, 0);
+	put8(out, 2);
+	msg = out->len;
+	put24(out, 0);
+	put16(out, 0x0303);
+	put_random(gen, out, 32);
+	put8(out, sizeof session_id);
+	put_bytes(out, session_id, sizeof session_id);
+	put16(out, 0x1301);
+	put8(out, 0);
+	exts = out->len;
+	put16(out, 0);
+	put16(out, 0x002b);
+	put16(out, 2);
+	put16(out, 0x0304);
+	put16(out, 0x0033);
+	put16(out, 2 + 2 + 32);
+	put16(out, 0x001d);
+	put16(out, 32);
+	put_random(gen, out, 32);
+	patch_len16(out, exts);
+	patch_len24(out, msg);
+	patch_len16(out, rec);
+	tls_put_change_cipher_spec(out);
+
+	tls_new_secret(gen, tls, CLIENT, "CLIENT_HANDSHAKE_TRAFFIC_SECRET");
+	tls_new_secret(gen, tls, SERVER, "SERVER_HANDSHAKE_TRAFFIC_SECRET");
+
+	/* EncryptedExtensions with the selected protocol, then Finished */
+	put8(hs, 8);
+	msg = hs->len;
+	put24(hs, 0);
+	exts = hs->len;
+	put16(hs, 0);
+	put16(hs, 0x0010);
+	ext = hs->len;
+	put16(hs, 0);
+	list = hs->len;
+	put16(hs, 0);
+	put8(hs, (guint8)strlen(alpn));
+	put_bytes(hs, alpn, (guint)strlen(alpn));
+	patch_len16(hs, list);
+	patch_len16(hs, ext);
+	patch_len16(hs, exts);
+	patch_len24(hs, msg);
+	put8(hs, 20);
+	put24(hs, 32);
+	put_random(gen, hs, 32);
+	tls_encrypt(tls, SERVER, 0x16, hs->data, hs->len, out);
+
+	tcp_send(conn, SERVER, out->data, out->len);
+	g_byte_array_set_size(out, 0);
+	g_byte_array_set_size(hs, 0);
+
+	/* Client Finished */
+	conn->now += conn->rtt / 2;
+	tls_put_change_cipher_spec(out);
+	put8(hs, 20);
+	put24(hs, 32);
+	put_random(gen, hs, 32);
+	tls_encrypt(tls, CLIENT, 0x16, hs->data, hs->len, out);
+	tcp_send(conn, CLIENT, out->data, out->len);
+
+	tls_new_secret(gen, tls, CLIENT, "CLIENT_TRAFFIC_SECRET_0");
+	tls_new_secret(gen, tls, SERVER, "SERVER_TRAFFIC_SECRET_0");
+
+	g_byte_array_free(hs, TRUE);
+	g_byte_array_free(out, TRUE);
+}
+
+/* Send application data, over TLS if tls isn't NULL */
+static void
+app_send(conn_t *conn, tls_session_t *tls, int dir, GByteArray *data)
+{
+	if (tls) {
+		GByteArray *records = g_byte_array_sized_new(data->len + data->len / 64 + 64);
+		tls_encrypt(tls, dir, 0x17, data->data, data->len, records);
+		tcp_send(conn, dir, records->data, records->len);
+		g_byte_array_free(records, TRUE);
+	} else {
+		tcp_send(conn, dir, data->data, data->len);
+	}
+}
+
+/*
+ * Flows
+ */
+
+static guint64
+flow_size(flow_gen_t *gen)
+{
+	const randpkt_flow_params *params = gen->params;
+	double u = g_rand_double(gen->rand);
+	double size;
+
+	switch (params->size_dist) {
+	case RANDPKT_FLOW_SIZE_EXPONENTIAL:
+		size = -(double)params->flow_size * log(1.0 - u);
+		break;
+	case RANDPKT_FLOW_SIZE_PARETO:
+		size = (double)params->flow_size * (FLOW_PARETO_ALPHA - 1) / FLOW_PARETO_ALPHA /
+			pow(1.0 - u, 1.0 / FLOW_PARETO_ALPHA);
+		break;
+	default:
+		size = (double)params->flow_size;
+		break;
+	}
+
+	if (size < 1.0)
+		return 1;
+	if (size > FLOW_MAX_SIZE)
+		return FLOW_MAX_SIZE;
+	return (guint64)size;
+}
+
+static void
+dns_put_name(GByteArray *ba, const char *name)
+{
+	gchar **labels = g_strsplit(name, ".", -1);
+	guint i;
+
+	for (i = 0; labels[i]; i++) {
+		put8(ba, (guint8)strlen(labels[i]));
+		put_bytes(ba, labels[i], (guint)strlen(labels[i]));
+	}
+	put8(ba, 0);
+	g_strfreev(labels);
+}
+
+static void
+flow_dns(flow_gen_t *gen, flow_t *flow, guint64 start)
+{
+	conn_t conn;
+	GByteArray *msg = g_byte_array_new();
+	gchar *name = g_strdup_printf("host%" G_GUINT64_FORMAT ".example.com", gen->flow_num);
+	guint16 id = (guint16)g_rand_int(gen->rand);
+	guint32 answer = 0xc6120000 | (guint32)(g_rand_int(gen->rand) & 0x0001ffff);
+
+	conn_init(&conn, gen, flow, start, FLOW_PROTO_UDP, 53);
+
+	put16(msg, id);
+	put16(msg, 0x0100);	/* Standard query, recursion desired */
+	put16(msg, 1);
+	put16(msg, 0);
+	put16(msg, 0);
+	put16(msg, 0);
+	dns_put_name(msg, name);
+	put16(msg, 1);		/* A */
+	put16(msg, 1);		/* IN */
+	add_packet(&conn, CLIENT, 0, 0, 0, msg->data, msg->len);
+
+	/* The response repeats the question and adds the answer */
+	conn.now += conn.rtt;
+	phton16(&msg->data[2], 0x8180);
+	phton16(&msg->data[6], 1);
+	put16(msg, 0xc00c);	/* Pointer to the name in the question */
+	put16(msg, 1);
+	put16(msg, 1);
+	put32(msg, 300);
+	put16(msg, 4);
+	put32(msg, answer);
+	add_packet(&conn, SERVER, 0, 0, 0, msg->data, msg->len);
+
+	g_free(name);
+	g_byte_array_free(msg, TRUE);
+}
+
+/* HTTP/1.1, in the clear or over TLS */
+static void
+flow_http(flow_gen_t *gen, flow_t *flow, guint64 start, gboolean use_tls)
+{
+	conn_t conn;
+	tls_session_t tls;
+	GByteArray *msg = g_byte_array_new();
+	gchar *host = g_strdup_printf("www%" G_GUINT64_FORMAT ".example.com", gen->flow_num);
+	guint64 size = flow_size(gen);
+	guint n_requests = g_rand_int_range(gen->rand, 1, 4);
+	guint i;
+
+	conn_init(&conn, gen, flow, start, FLOW_PROTO_TCP, use_tls ? 443 : 80);
+	tcp_handshake(&conn);
+	if (use_tls)
+		tls_handshake(&conn, &tls, host, "http/1.1");
+
+	for (i = 0; i < n_requests; i++) {
+		guint64 body_len = size / n_requests;
+		gchar *text;
+
+		text = g_strdup_printf("GET /object/%u HTTP/1.1\r\n"
+			"Host: %s\r\n"
+			"User-Agent: randpkt\r\n"
+			"Accept: */*\r\n"
+			"\r\n", i, host);
+		put_bytes(msg, text, (guint)strlen(text));
+		g_free(text);
+		conn.now += 200;
+		app_send(&conn, use_tls ? &tls : NULL, CLIENT, msg);
+		g_byte_array_set_size(msg, 0);
+
+		text = g_strdup_printf("HTTP/1.1 200 OK\r\n"
+			"Content-Type: application/octet-stream\r\n"
+			"Content-Length: %" G_GUINT64_FORMAT "\r\n"
+			"\r\n", body_len);
+		put_bytes(msg, text, (guint)strlen(text));
+		g_free(text);
+		put_filler(gen, msg, body_len);
+		conn.now += conn.rtt / 2;
+		app_send(&conn, use_tls ? &tls : NULL, SERVER, msg);
+		g_byte_array_set_size(msg, 0);
+	}
+
+	tcp_close(&conn);
+	g_free(host);
+	g_byte_array_free(msg, TRUE);
+}
+
+static void
+http2_put_frame_header(GByteArray *ba, guint32 len, guint8 type, guint8 flags, guint32 stream)
+{
+	put24(ba, len);
+	put8(ba, type);
+	put8(ba, flags);
+	put32(ba, stream);
+}
+
+/* A literal header field without indexing, with an indexed name (RFC 7541 6.2.2) */
+static void
+hpack_put_literal(GByteArray *ba, guint name_index, const char *value)
+{
+	if (name_index < 15) {
+		put8(ba, (guint8)name_index);
+	} else {
+		put8(ba, 0x0f);
+		put8(ba, (guint8)(name_index - 15));
+	}
+	put8(ba, (guint8)strlen(value));
+	put_bytes(ba, value, (guint)strlen(value));
+}
+
+/* HTTP/2 over TLS, with all requests sent at once on separate streams */
+static void
+flow_http2(flow_gen_t *gen, flow_t *flow, guint64 start)
+{
+	static const char preface[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+	conn_t conn;
+	tls_session_t tls;
+	GByteArray *msg = g_byte_array_new();
+	gchar *host = g_strdup_printf("www%" G_GUINT64_FORMAT ".example.com", gen->flow_num);
+	guint64 size = flow_size(gen);
+	guint n_requests = g_rand_int_range(gen->rand, 1, 6);
+	guint i;
+
+	conn_init(&conn, gen, flow, start, FLOW_PROTO_TCP, 443);
+	tcp_handshake(&conn);
+	tls_handshake(&conn, &tls, host, "h2");
+
+	put_bytes(msg, preface, (guint)strlen(preface));
+	http2_put_frame_header(msg, 0, 4, 0, 0);		/* SETTINGS */
+	for (i = 0; i < n_requests; i++) {
+		gchar *path = g_strdup_printf("/object/%u", i);
+		guint frame = msg->len;
+
+		http2_put_frame_header(msg, 0, 1, 0x05, 2 * i + 1);	/* HEADERS, END_STREAM|END_HEADERS */
+		put8(msg, 0x82);		/* :method: GET */
+		put8(msg, 0x87);		/* :scheme: https */
+		hpack_put_literal(msg, 4, path);	/* :path */
+		hpack_put_literal(msg, 1, host);	/* :authority */
+		msg->data[frame + 2] = (guint8)(msg->len - frame - 9);
+		g_free(path);
+	}
+	conn.now += 200;
+	app_send(&conn, &tls, CLIENT, msg);
+	g_byte_array_set_size(msg, 0);
+
+	http2_put_frame_header(msg, 0, 4, 0, 0);		/* SETTINGS */
+	http2_put_frame_header(msg, 0, 4, 0x01, 0);		/* SETTINGS, ACK */
+	for (i = 0; i < n_requests; i++) {
+		guint64 body_len = size / n_requests;
+		gchar *len_str = g_strdup_printf("%" G_GUINT64_FORMAT, body_len);
+		guint frame = msg->len;
+
+		http2_put_frame_header(msg, 0, 1, 0x04, 2 * i + 1);	/* HEADERS, END_HEADERS */
+		put8(msg, 0x88);		/* :status: 200 */
+		hpack_put_literal(msg, 28, len_str);	/* content-length */
+		msg->data[frame + 2] = (guint8)(msg->len - frame - 9);
+		g_free(len_str);
+
+		do {
+			guint chunk = (guint)MIN(body_len, HTTP2_MAX_FRAME);
+			body_len -= chunk;
+			http2_put_frame_header(msg, chunk, 0, body_len == 0 ? 0x01 : 0, 2 * i + 1);
+			put_filler(gen, msg, chunk);
+		} while (body_len > 0);
+	}
+	conn.now += conn.rtt / 2;
+	app_send(&conn, &tls, SERVER, msg);
+	g_byte_array_set_size(msg, 0);
+
+	http2_put_frame_header(msg, 0, 4, 0x01, 0);		/* SETTINGS, ACK */
+	conn.now += 200;
+	app_send(&conn, &tls, CLIENT, msg);
+
+	tcp_close(&conn);
+	g_free(host);
+	g_byte_array_free(msg, TRUE);
+}
+
+static flow_t *
+flow_new(flow_gen_t *gen, guint64 start)
+{
+	flow_t *flow = g_new0(flow_t, 1);
+	guint pick = g_rand_int_range(gen->rand, 0, gen->weight_total);
+	int type;
+
+	flow->data = g_byte_array_new();
+	flow->pkts = g_array_new(FALSE, FALSE, sizeof(flow_pkt));
+
+	for (type = 0; type < RANDPKT_FLOW_NUM_TYPES - 1; type++) {
+		if (pick < gen->params->weights[type])
+			break;
+		pick -= gen->params->weights[type];
+	}
+
+	switch (type) {
+	case RANDPKT_FLOW_DNS:
+		flow_dns(gen, flow, start);
+		break;
+	case RANDPKT_FLOW_HTTP:
+		flow_http(gen, flow, start, FALSE);
+		break;
+	case RANDPKT_FLOW_TLS:
+		flow_http(gen, flow, start, TRUE);
+		break;
+	default:
+		flow_http2(gen, flow, start);
+		break;
+	}
+	gen->flow_num++;
+
+	return flow;
+}
+
+static void
+flow_free(flow_t *flow)
+{
+	g_byte_array_free(flow->data, TRUE);
+	g_array_free(flow->pkts, TRUE);
+	g_free(flow);
+}
+
+static guint64
+flow_next_ts(const flow_t *flow)
+{
+	return g_array_index(flow->pkts, flow_pkt, flow->next_pkt).ts_us;
+}
+
+/*
+ * Active flows are kept in a binary heap ordered by the time of their next
+ * packet, so that packets from all flows are written in time order.
+ */
+static void
+heap_push(GPtrArray *heap, flow_t *flow)
+{
+	guint i = heap->len;
+
+	g_ptr_array_add(heap, flow);
+	while (i > 0) {
+		guint parent = (i - 1) / 2;
+		if (flow_next_ts((flow_t *)heap->pdata[parent]) <= flow_next_ts(flow))
+			break;
+		heap->pdata[i] = heap->pdata[parent];
+		i = parent;
+	}
+	heap->pdata[i] = flow;
+}
+
+static flow_t *
+heap_pop(GPtrArray *heap)
+{
+	flow_t *top = (flow_t *)heap->pdata[0];
+	flow_t *last = (flow_t *)heap->pdata[heap->len - 1];
+	guint i = 0;
+
+	g_ptr_array_set_size(heap, heap->len - 1);
+	if (heap->len == 0)
+		return top;
+
+	for (;;) {
+		guint child = 2 * i + 1;
+		if (child >= heap->len)
+			break;
+		if (child + 1 < heap->len &&
+		    flow_next_ts((flow_t *)heap->pdata[child + 1]) < flow_next_ts((flow_t *)heap->pdata[child]))
+			child++;
+		if (flow_next_ts(last) <= flow_next_ts((flow_t *)heap->pdata[child]))
+			break;
+		heap->pdata[i] = heap->pdata[child];
+		i = child;
+	}
+	heap->pdata[i] = last;
+
+	return top;
+}
+
+void randpkt_flow_params_init(randpkt_flow_params* params)
+{
+	memset(params, 0, sizeof *params);
+	params->seed = 1;
+	params->flow_count = 1000;
+	params->flow_rate = 100.0;
+	params->flow_size = 20000;
+	params->size_dist = RANDPKT_FLOW_SIZE_PARETO;
+	params->weights[RANDPKT_FLOW_DNS] = 30;
+	params->weights[RANDPKT_FLOW_HTTP] = 30;
+	params->weights[RANDPKT_FLOW_TLS] = 20;
+	params->weights[RANDPKT_FLOW_HTTP2] = 20;
+	params->loss = 0.01;
+	params->reorder = 0.01;
+}
+
+gboolean randpkt_flow_parse_mix(randpkt_flow_params* params, const char* mix)
+{
+	guint weights[RANDPKT_FLOW_NUM_TYPES] = { 0 };
+	gchar **entries = g_strsplit(mix, ",", -1);
+	gboolean ok = TRUE;
+	guint total = 0;
+	guint i;
+	int type;
+
+	for (i = 0; ok && entries[i]; i++) {
+		gchar **parts = g_strsplit(entries[i], ":", 2);
+		gchar *end;
+		guint64 weight;
+
+		ok = FALSE;
+		if (parts[0] && parts[1]) {
+			weight = g_ascii_strtoull(parts[1], &end, 10);
+			for (type = 0; type < RANDPKT_FLOW_NUM_TYPES; type++) {
+				if (g_strcmp0(parts[0], flow_type_names[type]) == 0 && *end == '\0' &&
+				    end != parts[1] && weight <= 1000000) {
+					weights[type] = (guint)weight;
+					total += (guint)weight;
+					ok = TRUE;
+				}
+			}
+		}
+		g_strfreev(parts);
+	}
+	g_strfreev(entries);
+
+	if (!ok || total == 0) {
+		fprintf(stderr, "randpkt: \"%s\" isn't a valid flow mix; use <type>:<weight>,... with types", mix);
+		for (type = 0; type < RANDPKT_FLOW_NUM_TYPES; type++)
+			fprintf(stderr, " %s", flow_type_names[type]);
+		fprintf(stderr, "\n");
+		return FALSE;
+	}
+
+	memcpy(params->weights, weights, sizeof weights);
+	return TRUE;
+}
+
+gboolean randpkt_flow_parse_size_dist(randpkt_flow_params* params, const char* name)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(size_dist_names); i++) {
+		if (g_strcmp0(name, size_dist_names[i]) == 0) {
+			params->size_dist = (randpkt_flow_size_dist)i;
+			return TRUE;
+		}
+	}
+	fprintf(stderr, "randpkt: \"%s\" isn't a flow size distribution; use fixed, exponential or pareto\n", name);
+	return FALSE;
+}
+
+int randpkt_flow_generate(const randpkt_flow_params* params, const char* produce_filename,
+	int file_type_subtype, const char* keylog_filename)
+{
+	flow_gen_t *gen;
+	GPtrArray *heap;
+	wtap_dumper *dump;
+	const char *filename;
+	wtap_rec rec;
+	guint64 next_start = 0;
+	guint64 started = 0;
+	int ret = EXIT_SUCCESS;
+	int err;
+	gchar *err_info;
+	int type;
+	guint i;
+
+	const wtap_dump_params dump_params = {
+		.encap = WTAP_ENCAP_ETHERNET,
+		.snaplen = WTAP_MAX_PACKET_SIZE_STANDARD,
+		.tsprec = WTAP_TSPREC_USEC,
+	};
+	if (strcmp(produce_filename, "-") == 0) {
+		dump = wtap_dump_open_stdout(file_type_subtype,
+			WTAP_UNCOMPRESSED, &dump_params, &err, &err_info);
+		filename = "the standard output";
+	} else {
+		dump = wtap_dump_open(produce_filename, file_type_subtype,
+			WTAP_UNCOMPRESSED, &dump_params, &err, &err_info);
+		filename = produce_filename;
+	}
+	if (!dump) {
+		cfile_dump_open_failure_message(produce_filename,
+			err, err_info, file_type_subtype);
+		return WRITE_ERROR;
+	}
+
+	gen = g_new0(flow_gen_t, 1);
+	gen->params = params;
+	gen->rand = g_rand_new_with_seed(params->seed);
+	for (type = 0; type < RANDPKT_FLOW_NUM_TYPES; type++)
+		gen->weight_total += params->weights[type];
+	for (i = 0; i < FLOW_FILLER_SIZE; i++)
+		gen->filler[i] = (guint8)g_rand_int_range(gen->rand, 0, 0x100);
+
+	if (keylog_filename) {
+		gen->keylog = ws_fopen(keylog_filename, "w");
+		if (!gen->keylog) {
+			open_failure_message(keylog_filename, errno, TRUE);
+			ret = WRITE_ERROR;
+			goto done;
+		}
+	}
+
+	wtap_rec_init(&rec);
+	rec.rec_type = REC_TYPE_PACKET;
+	rec.presence_flags = WTAP_HAS_TS;
+	rec.tsprec = WTAP_TSPREC_USEC;
+	rec.rec_header.packet_header.pkt_encap = WTAP_ENCAP_ETHERNET;
+
+	heap = g_ptr_array_new();
+	for (;;) {
+		flow_t *flow;
+		flow_pkt *pkt;
+
+		/* Start every flow that begins before the next packet. Flows
+		 * arrive as a Poisson process at the requested rate. */
+		while (started < params->flow_count &&
+		       (heap->len == 0 || next_start <= flow_next_ts((flow_t *)heap->pdata[0]))) {
+			flow = flow_new(gen, next_start);
+			if (flow->pkts->len > 0)
+				heap_push(heap, flow);
+			else
+				flow_free(flow);
+			started++;
+			next_start += (guint64)(-log(1.0 - g_rand_double(gen->rand)) / params->flow_rate * 1000000.0);
+		}
+		if (heap->len == 0)
+			break;
+
+		flow = heap_pop(heap);
+		pkt = &g_array_index(flow->pkts, flow_pkt, flow->next_pkt);
+
+		rec.ts.secs = FLOW_EPOCH + (time_t)(pkt->ts_us / 1000000);
+		rec.ts.nsecs = (int)(pkt->ts_us % 1000000) * 1000;
+		rec.rec_header.packet_header.caplen = pkt->len;
+		rec.rec_header.packet_header.len = pkt->len;
+		if (!wtap_dump(dump, &rec, &flow->data->data[pkt->offset], &err, &err_info)) {
+			cfile_write_failure_message(NULL, filename, err, err_info, 0,
+				wtap_dump_file_type_subtype(dump));
+			ret = WRITE_ERROR;
+			heap_push(heap, flow);
+			break;
+		}
+
+		if (++flow->next_pkt < flow->pkts->len)
+			heap_push(heap, flow);
+		else
+			flow_free(flow);
+	}
+
+	for (i = 0; i < heap->len; i++)
+		flow_free((flow_t *)heap->pdata[i]);
+	g_ptr_array_free(heap, TRUE);
+	wtap_rec_cleanup(&rec);
+
+done:
+	if (gen->keylog)
+		fclose(gen->keylog);
+	g_rand_free(gen->rand);
+	g_free(gen);
+
+	if (!wtap_dump_close(dump, NULL, &err, &err_info)) {
+		cfile_close_failure_message(filename, err, err_info);
+		ret = WRITE_ERROR;
+	}
+
+	return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
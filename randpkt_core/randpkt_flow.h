@@ -0,0 +1,67 @@
+/** @file
+ *
+ * randpkt_flow.h
+ * ---------
+ * Creates deterministic traces of complete flows (DNS, HTTP/1.1 and
+ * HTTP/1.1 or HTTP/2 over TLS 1.3) for dissection benchmarks.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __RANDPKT_FLOW_H__
+#define __RANDPKT_FLOW_H__
+
+#include <glib.h>
+
+typedef enum {
+	RANDPKT_FLOW_DNS,
+	RANDPKT_FLOW_HTTP,
+	RANDPKT_FLOW_TLS,	/* HTTP/1.1 over TLS */
+	RANDPKT_FLOW_HTTP2,	/* HTTP/2 over TLS */
+	RANDPKT_FLOW_NUM_TYPES
+} randpkt_flow_type;
+
+typedef enum {
+	RANDPKT_FLOW_SIZE_FIXED,
+	RANDPKT_FLOW_SIZE_EXPONENTIAL,
+	RANDPKT_FLOW_SIZE_PARETO
+} randpkt_flow_size_dist;
+
+typedef struct {
+	guint32                seed;
+	guint64                flow_count;
+	double                 flow_rate;	/* New flows per second */
+	guint64                flow_size;	/* Mean bytes sent by the server */
+	randpkt_flow_size_dist size_dist;
+	guint                  weights[RANDPKT_FLOW_NUM_TYPES];
+	double                 loss;		/* Fraction of segments retransmitted */
+	double                 reorder;		/* Fraction of segments delivered out of order */
+} randpkt_flow_params;
+
+/* Set the default parameters */
+void randpkt_flow_params_init(randpkt_flow_params* params);
+
+/* Parse a flow mix such as "dns:30,http:30,tls:20,http2:20" */
+gboolean randpkt_flow_parse_mix(randpkt_flow_params* params, const char* mix);
+
+/* Parse a flow size distribution name */
+gboolean randpkt_flow_parse_size_dist(randpkt_flow_params* params, const char* name);
+
+/* Write the flows to a file, and the TLS secrets to keylog_filename if it isn't NULL */
+int randpkt_flow_generate(const randpkt_flow_params* params, const char* produce_filename,
+	int file_type_subtype, const char* keylog_filename);
+
+#endif
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -76,8 +76,9 @@ typedef struct _ringbuf_data {
     gboolean      unlimited;           /**< TRUE if unlimited number of files */
 
     int           fd;                  /**< Current ringbuffer file descriptor */
-    FILE         *pdh;
-    char         *io_buffer;              /**< The IO buffer used to write to the file */
+    pcapio_writer_t *pdh;
+    unsigned      flush_latency_ms;    /**< Flush latency of the writer for each file */
+    unsigned      writer_flags;        /**< Flags of the writer for each file */
     gboolean      group_read_access;   /**< TRUE if files need to be opened with group read access */
     FILE         *name_h;              /**< write names of completed files to this handle */
     gchar        *compress_type;       /**< compress type */
@@ -283,7 +284,6 @@ ringbuf_init(const char *capfile_name, guint num_files, gboolean group_read_acce
     rb_data.unlimited = FALSE;
     rb_data.fd = -1;
     rb_data.pdh = NULL;
-    rb_data.io_buffer = NULL;
     rb_data.group_read_access = group_read_access;
     rb_data.name_h = NULL;
     rb_data.compress_type = compress_type;
@@ -403,32 +403,18 @@ ringbuf_current_filename(void)
 }
 
 /*
- * Calls ws_fdopen() for the current ringbuffer file
+ * Sets up a writer for the current ringbuffer file; the writers for the
+ * files switched to later are set up the same way
  */
-FILE *
-ringbuf_init_libpcap_fdopen(int *err)
+pcapio_writer_t *
+ringbuf_init_libpcap_fdopen(unsigned flush_latency_ms, unsigned flags, int *err)
 {
-    rb_data.pdh = ws_fdopen(rb_data.fd, "wb");
-    if (rb_data.pdh == NULL) {
-        if (err != NULL) {
-            *err = errno;
-        }
-    } else {
-        size_t buffsize = IO_BUF_SIZE;
-#ifdef HAVE_STRUCT_STAT_ST_BLKSIZE
-        ws_statb64 statb;
-
-        if (ws_fstat64(rb_data.fd, &statb) == 0) {
-            if (statb.st_blksize > IO_BUF_SIZE) {
-                buffsize = statb.st_blksize;
-            }
-        }
-#endif
-        /* Increase the size of the IO buffer */
-        rb_data.io_buffer = (char *)g_realloc(rb_data.io_buffer, buffsize);
-        setvbuf(rb_data.pdh, rb_data.io_buffer, _IOFBF, buffsize);
-    }
+    int dummy_err;
 
+    rb_data.flush_latency_ms = flush_latency_ms;
+    rb_data.writer_flags = flags;
+    rb_data.pdh = pcapio_writer_fdopen(rb_data.fd, 0, flush_latency_ms, flags,
+                                       err != NULL ? err : &dummy_err);
     return rb_data.pdh;
 }
 
@@ -436,22 +422,16 @@ ringbuf_init_libpcap_fdopen(int *err)
  * Switches to the next ringbuffer file
  */
 gboolean
-ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
+ringbuf_switch_file(pcapio_writer_t **pdh, gchar **save_file, int *save_file_fd, int *err)
 {
     int     next_file_index;
     rb_file *next_rfile = NULL;
 
     /* close current file */
 
-    if (fclose(rb_data.pdh) == EOF) {
-        if (err != NULL) {
-            *err = errno;
-        }
-        ws_close(rb_data.fd);  /* XXX - the above should have closed this already */
+    if (!pcapio_writer_close(rb_data.pdh, err)) {
         rb_data.pdh = NULL;    /* it's still closed, we just got an error while closing */
         rb_data.fd = -1;
-        g_free(rb_data.io_buffer);
-        rb_data.io_buffer = NULL;
         return FALSE;
     }
 
@@ -473,7 +453,7 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
         return FALSE;
     }
 
-    if (ringbuf_init_libpcap_fdopen(err) == NULL) {
+    if (ringbuf_init_libpcap_fdopen(rb_data.flush_latency_ms, rb_data.writer_flags, err) == NULL) {
         return FALSE;
     }
 
@@ -486,7 +466,7 @@ ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd, int *err)
 }
 
 /*
- * Calls fclose() for the current ringbuffer file
+ * Closes the current ringbuffer file
  */
 gboolean
 ringbuf_libpcap_dump_close(gchar **save_file, int *err)
@@ -495,18 +475,11 @@ ringbuf_libpcap_dump_close(gchar **save_file, int *err)
 
     /* close current file, if it's open */
     if (rb_data.pdh != NULL) {
-        if (fclose(rb_data.pdh) == EOF) {
-            if (err != NULL) {
-                *err = errno;
-            }
-            ws_close(rb_data.fd);
+        if (!pcapio_writer_close(rb_data.pdh, err)) {
             ret_val = FALSE;
         }
         rb_data.pdh = NULL;
         rb_data.fd  = -1;
-        g_free(rb_data.io_buffer);
-        rb_data.io_buffer = NULL;
-
     }
 
     if (rb_data.name_h != NULL) {
@@ -563,9 +536,9 @@ ringbuf_error_cleanup(void)
 
     /* try to close via wtap */
     if (rb_data.pdh != NULL) {
-        if (fclose(rb_data.pdh) == 0) {
-            rb_data.fd = -1;
-        }
+        /* The writer closes the file, even if that fails. */
+        pcapio_writer_close(rb_data.pdh, NULL);
+        rb_data.fd = -1;
         rb_data.pdh = NULL;
     }
 
@@ -582,9 +555,6 @@ ringbuf_error_cleanup(void)
             }
         }
     }
-    g_free(rb_data.io_buffer);
-    rb_data.io_buffer = NULL;
-
     if (rb_data.name_h != NULL) {
         if (EOF == fclose(rb_data.name_h)) {
             /* Can't really do much about this, can we? */
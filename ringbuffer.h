@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include "wiretap/wtap.h"
+#include "writecap/pcapio.h"
 
 #define RINGBUFFER_UNLIMITED_FILES 0
 /* Minimum number of ringbuffer files */
@@ -28,8 +29,9 @@ int ringbuf_init(const char *capture_name, guint num_files, gboolean group_read_
                  gboolean nametimenum);
 gboolean ringbuf_is_initialized(void);
 const gchar *ringbuf_current_filename(void);
-FILE *ringbuf_init_libpcap_fdopen(int *err);
-gboolean ringbuf_switch_file(FILE **pdh, gchar **save_file, int *save_file_fd,
+pcapio_writer_t *ringbuf_init_libpcap_fdopen(unsigned flush_latency_ms,
+                                            unsigned flags, int *err);
+gboolean ringbuf_switch_file(pcapio_writer_t **pdh, gchar **save_file, int *save_file_fd,
                              int *err);
 gboolean ringbuf_libpcap_dump_close(gchar **save_file, int *err);
 void ringbuf_free(void);
@@ -169,6 +169,10 @@ main(int argc, char *argv[])
      */
     wtap_init(TRUE);
 
+    /* We look up only the fields named in filters, columns and the like,
+       so don't check every field and enter its name up front. */
+    proto_set_lazy_field_registration(TRUE);
+
     /* Register all dissectors; we must do this before checking for the
        "-G" flag, as the "-G" flag dumps information registered by the
        dissectors, and we must do it before we read the preferences, in
@@ -208,6 +212,8 @@ main(int argc, char *argv[])
 
     ret = sharkd_loop(argc, argv);
 clean_exit:
+    field_index_free(cfile.field_index);
+    cfile.field_index = NULL;
     col_cleanup(&cfile.cinfo);
     free_filter_lists();
     codecs_cleanup();
@@ -283,6 +289,9 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
            with the hfids postdissectors want on the first pass. */
         prime_epan_dissect_with_postdissector_wanted_hfids(edt);
 
+        if (cf->field_index)
+            field_index_prime_edt(cf->field_index, edt);
+
         frame_data_set_before_dissect(&fdlocal, &cf->elapsed_time,
                 &cf->provider.ref, cf->provider.prev_dis);
         if (cf->provider.ref == &fdlocal) {
@@ -300,6 +309,9 @@ process_packet(capture_file *cf, epan_dissect_t *edt,
     }
 
     if (passed) {
+        if (edt && cf->field_index)
+            field_index_add_frame(cf->field_index, cf->count + 1, edt->tree);
+
         frame_data_set_after_dissect(&fdlocal, &cum_bytes);
         cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
 
@@ -346,6 +358,11 @@ load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
         {
             gboolean create_proto_tree;
 
+            /* Clients usually filter the same capture many times;
+               index the configured fields so that "frames" requests
+               don't have to dissect every frame again. */
+            cf->field_index = field_index_new_from_prefs();
+
             /*
              * Determine whether we need to create a protocol tree.
              * We do if:
@@ -355,10 +372,13 @@ load_cap_file(capture_file *cf, int max_packet_count, gint64 max_byte_count)
              *    we're going to apply a display filter;
              *
              *    a postdissector wants field values or protocols
-             *    on the first pass.
+             *    on the first pass;
+             *
+             *    we're building a field index.
              */
             create_proto_tree =
-                (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids());
+                (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() ||
+                 cf->field_index != NULL);
 
             /* We're not going to display the protocol tree on this pass,
                so it's not going to be "visible". */
@@ -450,6 +470,10 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
     epan_free(cf->epan);
     cf->epan = sharkd_epan_new(cf);
 
+    /* The previous file's index is no use for this one. */
+    field_index_free(cf->field_index);
+    cf->field_index = NULL;
+
     cf->state = FILE_READ_IN_PROGRESS;
 
     wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
@@ -490,6 +514,12 @@ sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *
     return cf_open(&cfile, fname, type, is_tempfile, err);
 }
 
+const field_index_t *
+sharkd_get_field_index(void)
+{
+    return cfile.field_index;
+}
+
 int
 sharkd_load_cap_file(void)
 {
@@ -563,8 +593,19 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
 
 int
 sharkd_retap(void)
+{
+    return sharkd_retap_frames(NULL, 0);
+}
+
+/*
+ * Run the tap listeners over the given frames, in ascending order, or
+ * over all frames if frames is NULL.
+ */
+int
+sharkd_retap_frames(const guint32 *frames, guint num_frames)
 {
     guint32          framenum;
+    guint            i;
     frame_data      *fdata;
     Buffer           buf;
     wtap_rec         rec;
@@ -599,8 +640,21 @@ sharkd_retap(void)
 
     reset_tap_listeners();
 
-    for (framenum = 1; framenum <= cfile.count; framenum++) {
+    /*
+     * Listeners that can be merged run their packet callbacks on
+     * worker threads; the columns are shared, so not if they're needed.
+     */
+    if (cinfo == NULL)
+        tap_parallel_begin(cfile.epan, create_proto_tree, 0);
+
+    if (frames == NULL)
+        num_frames = cfile.count;
+
+    for (i = 0; i < num_frames; i++) {
+        framenum = frames ? frames[i] : i + 1;
         fdata = sharkd_get_frame(framenum);
+        if (fdata == NULL)
+            break;
 
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
             break;
@@ -608,6 +662,18 @@ sharkd_retap(void)
         fdata->ref_time = FALSE;
         fdata->frame_ref_num = (framenum != 1) ? 1 : 0;
         fdata->prev_dis_num = framenum - 1;
+        /* Removing or resetting a listener ends the parallel retap. */
+        if (tap_parallel_active()) {
+            wtap_rec *recp = &rec;
+            Buffer *bufp = &buf;
+            epan_dissect_t *slot_edt = tap_parallel_next_frame(&recp, &bufp);
+
+            epan_dissect_run_with_taps(slot_edt, cfile.cd_t, recp,
+                    frame_tvbuff_new_buffer(&cfile.provider, fdata, bufp),
+                    fdata, NULL);
+            wtap_rec_reset(&rec);
+            continue;
+        }
         epan_dissect_run_with_taps(&edt, cfile.cd_t, &rec,
                 frame_tvbuff_new_buffer(&cfile.provider, fdata, &buf),
                 fdata, cinfo);
@@ -615,6 +681,8 @@ sharkd_retap(void)
         epan_dissect_reset(&edt);
     }
 
+    tap_parallel_end();
+
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
     epan_dissect_cleanup(&edt);
@@ -640,6 +708,8 @@ sharkd_filter(const char *dftext, guint8 **result)
     guint8  passed_bits;
 
     epan_dissect_t edt;
+    gboolean use_field_index;
+    bool index_passed;
 
     if (!dfilter_compile(dftext, &dfcode, NULL)) {
         return -1;
@@ -652,6 +722,10 @@ sharkd_filter(const char *dftext, guint8 **result)
     }
 
     frames_count = cfile.count;
+    use_field_index = field_index_can_filter(cfile.field_index, dfcode);
+
+    /* Nothing but the filter looks at the trees built here. */
+    epan_limit_dissection(NULL, dfcode, NULL);
 
     wtap_rec_init(&rec);
     ws_buffer_init(&buf, 1514);
@@ -668,6 +742,15 @@ sharkd_filter(const char *dftext, guint8 **result)
             passed_bits = 0;
         }
 
+        if (use_field_index &&
+                field_index_filter_frame(cfile.field_index, dfcode, framenum, &index_passed)) {
+            if (index_passed) {
+                passed_bits |= (1 << (framenum % 8));
+                prev_dis_num = framenum;
+            }
+            continue;
+        }
+
         if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, &rec, &buf, &err, &err_info))
             break;
 
@@ -699,6 +782,7 @@ sharkd_filter(const char *dftext, guint8 **result)
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
     epan_dissect_cleanup(&edt);
+    epan_clear_dissection_limit();
 
     dfilter_free(dfcode);
 
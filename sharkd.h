@@ -32,8 +32,10 @@ typedef void (*sharkd_dissect_func_t)(epan_dissect_t *edt, proto_tree *tree, str
 cf_status_t sharkd_cf_open(const char *fname, unsigned int type, gboolean is_tempfile, int *err);
 int sharkd_load_cap_file(void);
 int sharkd_retap(void);
+int sharkd_retap_frames(const guint32 *frames, guint num_frames);
 int sharkd_filter(const char *dftext, guint8 **result);
 frame_data *sharkd_get_frame(guint32 framenum);
+const field_index_t *sharkd_get_field_index(void);
 enum dissect_request_status {
   DISSECT_REQUEST_SUCCESS,
   DISSECT_REQUEST_NO_SUCH_FRAME,
@@ -399,6 +399,7 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"dumpconf",   "pref",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"follow",     "follow",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
         {"follow",     "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
+        {"follow",     "stream",     2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"frame",      "frame",      2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_MANDATORY},
         {"frame",      "proto",      2, JSMN_PRIMITIVE,    SHARKD_JSON_BOOLEAN,  SHARKD_OPTIONAL},
         {"frame",      "ref_frame",  2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
@@ -1128,6 +1129,11 @@ sharkd_session_process_info(void)
         sharkd_json_value_string("name", "Expert Information");
         sharkd_json_value_string("tap", "expert");
         json_dumper_end_object(&dumper);
+
+        json_dumper_begin_object(&dumper);
+        sharkd_json_value_string("name", "Dissector Profile");
+        sharkd_json_value_string("tap", "dissector-prof");
+        json_dumper_end_object(&dumper);
     }
     sharkd_json_array_close();
 
@@ -1225,10 +1231,14 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
  *   (o) filename - capture filename
  *   (o) filesize - capture filesize
  *   (o) columns  - array of column titles
+ *   (o) field_index - object with field index statistics:
+ *                  'fields', 'frames', 'values', 'strings', 'memory', 'build_time' (microseconds)
  */
 static void
 sharkd_session_process_status(void)
 {
+    const field_index_t *field_index = sharkd_get_field_index();
+
     sharkd_json_result_prologue(rpcid);
 
     sharkd_json_value_anyf("frames", "%u", cfile.count);
@@ -1260,6 +1270,21 @@ sharkd_session_process_status(void)
         sharkd_json_array_close();
     }
 
+    if (field_index)
+    {
+        field_index_stats_t stats;
+
+        field_index_get_stats(field_index, &stats);
+        sharkd_json_object_open("field_index");
+        sharkd_json_value_anyf("fields", "%u", stats.num_fields);
+        sharkd_json_value_anyf("frames", "%u", stats.num_frames);
+        sharkd_json_value_anyf("values", "%" PRIu64, stats.num_values);
+        sharkd_json_value_anyf("strings", "%u", stats.num_strings);
+        sharkd_json_value_anyf("memory", "%zu", stats.memory_used);
+        sharkd_json_value_anyf("build_time", "%" PRId64, stats.build_time);
+        sharkd_json_object_close();
+    }
+
     sharkd_json_result_epilogue();
 }
 
@@ -1871,6 +1896,66 @@ sharkd_session_free_tap_expert_cb(void *tapdata)
     g_free(etd);
 }
 
+static void
+sharkd_session_dissector_prof_cb(const dissector_prof_stats_t *stats, gpointer user_data)
+{
+    double ticks_per_ns = *(double *) user_data;
+
+    json_dumper_begin_object(&dumper);
+    sharkd_json_value_string("name", stats->name);
+    if (stats->protocol)
+        sharkd_json_value_string("proto", stats->protocol);
+    if (stats->heuristic)
+        sharkd_json_value_anyf("heur", "true");
+    sharkd_json_value_anyf("calls", "%" PRIu64, stats->calls);
+    sharkd_json_value_anyf("incl_ns", "%" PRIu64, (guint64) ((double) stats->incl_ticks / ticks_per_ns));
+    sharkd_json_value_anyf("excl_ns", "%" PRIu64, (guint64) ((double) stats->excl_ticks / ticks_per_ns));
+    sharkd_json_value_anyf("incl_bytes", "%" PRIu64, stats->incl_bytes);
+    sharkd_json_value_anyf("excl_bytes", "%" PRIu64, stats->excl_bytes);
+    json_dumper_end_object(&dumper);
+}
+
+/**
+ * sharkd_session_process_tap_dissector_prof_cb()
+ *
+ * Output dissector profile tap:
+ *
+ *   (m) tap                 - tap name
+ *   (m) type:dissector-prof - tap output type
+ *   (m) dissectors          - array of object with attributes:
+ *                  (m) name       - dissector handle name, or heuristic short name
+ *                  (o) proto      - protocol
+ *                  (o) heur       - true for a heuristic dissector
+ *                  (m) calls      - number of calls
+ *                  (m) incl_ns    - nanoseconds spent in the dissector and its callees
+ *                  (m) excl_ns    - nanoseconds spent in the dissector itself
+ *                  (m) incl_bytes - bytes allocated by the dissector and its callees
+ *                  (m) excl_bytes - bytes allocated by the dissector itself
+ */
+static void
+sharkd_session_process_tap_dissector_prof_cb(void *tapdata _U_)
+{
+    double ticks_per_ns = dissector_prof_ticks_per_ns();
+
+    json_dumper_begin_object(&dumper);
+
+    sharkd_json_value_string("tap", "dissector-prof");
+    sharkd_json_value_string("type", "dissector-prof");
+
+    sharkd_json_array_open("dissectors");
+    dissector_prof_foreach(sharkd_session_dissector_prof_cb, &ticks_per_ns);
+    sharkd_json_array_close();
+
+    json_dumper_end_object(&dumper);
+}
+
+static void
+sharkd_session_free_tap_dissector_prof_cb(void *tapdata)
+{
+    dissector_prof_disable();
+    g_free(tapdata);
+}
+
 /**
  * sharkd_session_process_tap_flow_cb()
  *
@@ -3383,6 +3468,7 @@ sharkd_session_eo_register_tap_listener(register_eo_t *eo, const char *tap_type,
  *                  for type:rtp-analyse see sharkd_session_process_tap_rtp_analyse_cb()
  *                  for type:eo see sharkd_session_process_tap_eo_cb()
  *                  for type:expert see sharkd_session_process_tap_expert_cb()
+ *                  for type:dissector-prof see sharkd_session_process_tap_dissector_prof_cb()
  *                  for type:rtd see sharkd_session_process_tap_rtd_cb()
  *                  for type:srt see sharkd_session_process_tap_srt_cb()
  *                  for type:flow see sharkd_session_process_tap_flow_cb()
@@ -3536,6 +3622,9 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
             ct_data->resolve_port = TRUE;
 
             tap_error = register_tap_listener(ct_tapname, &ct_data->hash, tap_filter, 0, NULL, tap_func, sharkd_session_process_tap_conv_cb, NULL);
+            if (!tap_error)
+                set_tap_merge_funcs(&ct_data->hash, clone_conversation_table_hash,
+                        !strncmp(tok_tap, "conv:", 5) ? merge_conversation_table_data : merge_endpoint_table_data);
 
             tap_data = &ct_data->hash;
             tap_free = sharkd_session_free_tap_conv_cb;
@@ -3596,6 +3685,8 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
             rtd_table_dissector_init(rtd, &rtd_data->stat_table, NULL, NULL);
 
             tap_error = register_tap_listener(get_rtd_tap_listener_name(rtd), rtd_data, tap_filter, 0, NULL, get_rtd_packet_func(rtd), sharkd_session_process_tap_rtd_cb, NULL);
+            if (!tap_error)
+                set_tap_merge_funcs(rtd_data, clone_rtd_table_data, merge_rtd_table_data);
 
             tap_data = rtd_data;
             tap_free = sharkd_session_free_tap_rtd_cb;
@@ -3681,6 +3772,22 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
             tap_data = rtp_req;
             tap_free = sharkd_session_process_tap_rtp_free_cb;
         }
+        else if (!strcmp(tok_tap, "dissector-prof"))
+        {
+            /* The profile is kept by epan; the listener only gets it drawn. */
+            tap_data = g_new0(int, 1);
+
+            tap_error = register_tap_listener("frame", tap_data, tap_filter, 0, NULL, NULL, sharkd_session_process_tap_dissector_prof_cb, NULL);
+
+            if (!tap_error)
+            {
+                dissector_prof_reset();
+                dissector_prof_enable();
+                tap_free = sharkd_session_free_tap_dissector_prof_cb;
+            }
+            else
+                tap_free = g_free;
+        }
         else if (!strcmp(tok_tap, "multicast"))
         {
             mcaststream_tapinfo_t *mcaststream_tapinfo;
@@ -3883,6 +3990,8 @@ sharkd_session_process_tap(char *buf, const jsmntok_t *tokens, int count)
  * Input:
  *   (m) follow  - follow protocol request (e.g. HTTP)
  *   (m) filter  - filter request (e.g. tcp.stream == 1)
+ *   (o) stream  - stream index the filter selects (e.g. 1); only the
+ *                 frames of that stream are dissected, if they're indexed
  *
  * Output object with attributes:
  *
@@ -3903,9 +4012,12 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
 {
     const char *tok_follow = json_find_attr(buf, tokens, count, "follow");
     const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
+    const char *tok_stream = json_find_attr(buf, tokens, count, "stream");
 
     register_follow_t *follower;
     GString *tap_error;
+    const guint32 *stream_frames = NULL;
+    guint num_stream_frames = 0;
 
     follow_info_t *follow_info;
     const char *host;
@@ -3937,7 +4049,18 @@ sharkd_session_process_follow(char *buf, const jsmntok_t *tokens, int count)
         return;
     }
 
-    sharkd_retap();
+    if (tok_stream)
+    {
+        guint32 stream;
+
+        if (ws_strtou32(tok_stream, NULL, &stream))
+            stream_frames = follow_get_stream_frames(follower, stream, &num_stream_frames);
+    }
+
+    if (stream_frames)
+        sharkd_retap_frames(stream_frames, num_stream_frames);
+    else
+        sharkd_retap();
 
     sharkd_json_result_prologue(rpcid);
 
@@ -4344,7 +4467,7 @@ sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const vo
         graph->num_items = idx + 1;
     }
 
-    update_succeeded = update_io_graph_item(graph->items, idx, pinfo, edt, graph->hf_index, graph->calc_type, graph->interval);
+    update_succeeded = update_io_graph_item(graph->items, idx, pinfo, edt, graph->hf_index, graph->calc_type, (guint64) graph->interval * 1000);
     /* XXX - TAP_PACKET_FAILED if the item couldn't be updated, with an error message? */
     return update_succeeded ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
 }
@@ -4917,6 +5040,9 @@ sharkd_session_process_complete(char *buf, const jsmntok_t *tokens, int count)
         void *field_cookie;
         int proto_id;
 
+        /* Finish registering the fields we registered lazily. */
+        proto_initialize_all_prefixes();
+
         sharkd_json_array_open("field");
 
         for (proto_id = proto_get_first_protocol(&proto_cookie); proto_id != -1; proto_id = proto_get_next_protocol(&proto_cookie))
@@ -49,6 +49,7 @@
  * (UNIX-like sends signals for this)
  */
 #define SP_QUIT         'Q'     /* "gracefully" capture quit message (SIGUSR1) */
+#define SP_TRIGGER      'G'     /* fire the pre-trigger buffering trigger (SIGUSR1) */
 
 /* Write a message, with a string body, to the recipient pipe in the
    standard format (1-byte message indicator, 3-byte message length
@@ -124,6 +124,11 @@ def cmd_text2pcap(program):
     return program('text2pcap')
 
 
+@pytest.fixture(scope='session')
+def cmd_randpkt(program):
+    return program('randpkt')
+
+
 @pytest.fixture(scope='session')
 def cmd_editcap(program):
     return program('editcap')
@@ -181,6 +186,7 @@ def features(cmd_tshark, make_env):
         have_gnutls='with GnuTLS' in tshark_v,
         have_pkcs11='and PKCS #11 support' in tshark_v,
         have_brotli='with brotli' in tshark_v,
+        have_maxminddb='with MaxMind' in tshark_v,
         have_plugins='binary plugins supported' in tshark_v,
     )
 
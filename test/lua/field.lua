@@ -9,8 +9,8 @@ local OTHER = "other"
 local n_frames = 1
 testlib.init({
     [FRAME] = n_frames,
-    [PER_FRAME] = n_frames*43,
-    [OTHER] = 16,
+    [PER_FRAME] = n_frames*48,
+    [OTHER] = 17,
 })
 
 ------------- helper funcs ------------
@@ -62,6 +62,7 @@ local f_udp_srcport = Field.new("udp.srcport")
 local f_udp_dstport = Field.new("udp.dstport")
 local f_dhcp_hw    = Field.new("dhcp.hw.mac_addr")
 local f_dhcp_opt   = Field.new("dhcp.option.type")
+local f_tcp_port   = Field.new("tcp.port")
 
 testlib.test(OTHER,"Field__tostring-1", tostring(f_frame_proto) == "frame.protocols")
 
@@ -80,6 +81,9 @@ testlib.test(OTHER,"Field.type-5", f_dhcp_opt.type == ftypes.UINT8)
 -- make sure can't create a FieldInfo outside tap
 testlib.test(OTHER,"Field__call-1",not pcall(makeFieldInfo,f_eth_src))
 
+-- make sure can't get field values outside tap
+testlib.test(OTHER,"Field.values-1",not pcall(Field.values,f_eth_src))
+
 local tap = Listener.new()
 
 --------------------------
@@ -107,6 +111,13 @@ function tap.packet(pinfo,tvb)
     testlib.test(PER_FRAME,"Field.type-9", f_udp_srcport.type == ftypes.UINT16)
     testlib.test(PER_FRAME,"Field.type-10", f_dhcp_opt.type == ftypes.UINT8)
 
+    local srcport, tcp_port, ip_src = Field.values(f_udp_srcport, f_tcp_port, f_ip_src)
+    testlib.test(PER_FRAME,"Field.values-2", srcport == f_udp_srcport()())
+    testlib.test(PER_FRAME,"Field.values-3", tcp_port == nil)
+    testlib.test(PER_FRAME,"Field.values-4", tostring(ip_src) == tostring(f_ip_src()()))
+    testlib.test(PER_FRAME,"Field.values-5", select("#", Field.values()) == 0)
+    testlib.test(PER_FRAME,"Field.values-6",not pcall(Field.values,f_udp_srcport,"ip.src"))
+
     testlib.testing(FRAME,"FieldInfo")
 
     local finfo_udp_srcport = f_udp_srcport()
@@ -0,0 +1,59 @@
+-- Field extraction throughput benchmark.
+--
+-- Not part of the test suite; run it manually against a capture, e.g.:
+--   tshark -X lua_script:test/lua/field_bench.lua -r capture.pcapng -q
+--
+-- Reads the same set of fields from every packet through Field objects and
+-- through Field.values, and reports the time taken by each.
+
+local field_names = {
+    "frame.len", "frame.number", "frame.time_relative", "frame.protocols",
+    "eth.src", "eth.dst", "eth.type",
+    "ip.src", "ip.dst", "ip.proto", "ip.ttl", "ip.len", "ip.id",
+    "tcp.srcport", "tcp.dstport", "tcp.seq", "tcp.ack", "tcp.len",
+    "udp.srcport", "udp.dstport", "udp.length",
+}
+
+local unpack = table.unpack or unpack
+
+local fields = {}
+for i, name in ipairs(field_names) do
+    fields[i] = Field.new(name)
+end
+
+local n_packets = 0
+local call_time = 0
+local values_time = 0
+
+local tap = Listener.new(nil, nil, true)
+
+function tap.packet(pinfo, tvb)
+    n_packets = n_packets + 1
+
+    local start = os.clock()
+    for _, field in ipairs(fields) do
+        local fi = field()
+        if fi then
+            local _ = fi.value
+        end
+    end
+    call_time = call_time + (os.clock() - start)
+
+    start = os.clock()
+    local _ = { Field.values(unpack(fields)) }
+    values_time = values_time + (os.clock() - start)
+end
+
+local function report(label, seconds)
+    if seconds > 0 then
+        print(string.format("  %-14s %10.3f s %12.0f packets/s", label, seconds, n_packets / seconds))
+    else
+        print(string.format("  %-14s %10.3f s", label, seconds))
+    end
+end
+
+function tap.draw()
+    print(string.format("Field extraction: %d fields, %d packets", #fields, n_packets))
+    report("Field()", call_time)
+    report("Field.values", values_time)
+end
@@ -11,7 +11,9 @@
 import glob
 import hashlib
 import os
+import signal
 import socket
+import struct
 import subprocess
 import subprocesstest
 from subprocesstest import cat_dhcp_command, cat_cap_file_command, count_output, grep_output, check_packet_count
@@ -304,6 +306,42 @@ def check_dumpcap_ringbuffer_stdin(cmd_dumpcap, cmd_capinfos, result_file):
     return check_dumpcap_ringbuffer_stdin_real
 
 
+def dhcp_pcap_rounds(capture_file, rounds, first_round=0):
+    '''The packets of dhcp.pcap repeated, one second apart, as a pcap stream.'''
+    with open(capture_file('dhcp.pcap'), 'rb') as f:
+        pcap = f.read()
+    endian = '<' if pcap[:4] == b'\xd4\xc3\xb2\xa1' else '>'
+    records = []
+    offset = 24
+    while offset < len(pcap):
+        ts_sec, ts_usec, caplen, origlen = struct.unpack(endian + 'IIII', pcap[offset:offset + 16])
+        records.append((caplen, origlen, pcap[offset + 16:offset + 16 + caplen]))
+        offset += 16 + caplen
+    out = [] if first_round else [pcap[:24]]
+    for i in range(first_round * len(records), (first_round + rounds) * len(records)):
+        caplen, origlen, data = records[i % len(records)]
+        out.append(struct.pack(endian + 'IIII', 1000000000 + i, 0, caplen, origlen) + data)
+    return b''.join(out)
+
+
+@pytest.fixture
+def check_dumpcap_trigger_stdin(cmd_dumpcap, cmd_capinfos, capture_file, result_file):
+    if sys.platform == 'win32':
+        pytest.skip('Test requires OS pipe support.')
+    def check_dumpcap_trigger_stdin_real(self, trigger_args, packets, discarded, env=None):
+        # 100 packets, DISCOVER, OFFER, REQUEST and ACK in turn, one second apart.
+        testout_file = result_file(testout_pcap)
+        capture_proc = subprocess.run((cmd_dumpcap,
+            '-i', '-',
+            '-w', testout_file,
+            ) + trigger_args,
+            input=dhcp_pcap_rounds(capture_file, 25), capture_output=True, env=env)
+        assert capture_proc.returncode == 0
+        check_packet_count(cmd_capinfos, packets, testout_file)
+        assert "Packets discarded without a trigger on interface '-': {}".format(discarded) in capture_proc.stderr.decode('utf-8', 'replace')
+    return check_dumpcap_trigger_stdin_real
+
+
 @pytest.fixture
 def check_dumpcap_pcapng_sections(cmd_dumpcap, cmd_tshark, cmd_capinfos, capture_file, result_file):
     if sys.platform == 'win32':
@@ -529,6 +567,44 @@ class TestTsharkCapture:
         '''Capture truncated packets using TShark'''
         check_capture_snapshot_len(self, cmd=cmd_tshark, env=test_env)
 
+    def test_tshark_capture_shm_buffer(self, cmd_tshark, test_env):
+        '''Dissect packets that Dumpcap hands to TShark in shared memory'''
+        if not sys.platform.startswith('linux'):
+            pytest.skip('Shared memory capture is only supported on Linux')
+        outputs = []
+        logs = []
+        for shm_args in ([], ['--shm-buffer', '1024']):
+            capture_cmd = capture_command(cmd_tshark,
+                '-i', '-',
+                '-T', 'fields',
+                '-e', 'frame.number',
+                '-e', 'frame.time_epoch',
+                '-e', 'frame.len',
+                '-e', 'dhcp.id',
+                '--log-level=info',
+                *shm_args,
+                shell=True
+            )
+            capture_proc = subprocesstest.check_run(cat_dhcp_command('cat100') + ' | ' + capture_cmd, shell=True, capture_output=True, env=test_env)
+            outputs.append(capture_proc.stdout)
+            logs.append(capture_proc.stderr)
+        assert count_output(outputs[0]) == 100
+        assert outputs[1] == outputs[0]
+        # Every packet came through the ring, none from the file.
+        assert 'from shared memory' not in logs[0]
+        assert 'Dissected 100 packets from shared memory' in logs[1]
+        assert 'not from shared memory' not in logs[1]
+
+    def test_tshark_capture_shm_buffer_ring(self, cmd_tshark, result_file, test_env):
+        '''Shared memory can't be used when switching capture files'''
+        if not sys.platform.startswith('linux'):
+            pytest.skip('Shared memory capture is only supported on Linux')
+        proc = subprocess.run((cmd_tshark, '-i', '-', '-P', '-w', result_file('shm-ring.pcapng'),
+                               '-b', 'filesize:100', '--shm-buffer', '1024'),
+                              capture_output=True, encoding='utf-8', env=test_env)
+        assert proc.returncode == 1
+        assert 'handed over in shared memory' in proc.stderr
+
 
 class TestDumpcapCapture:
     def test_dumpcap_capture_10_packets_to_file(self, cmd_dumpcap, check_capture_10_packets, base_env):
@@ -598,3 +674,60 @@ class TestDumpcapPcapngSections:
         if sys.byteorder == 'big':
             pytest.skip('this test is supported on little endian only')
         check_dumpcap_pcapng_sections(self, multi_input=True, multi_output=True, env=base_env)
+
+
+class TestDumpcapTrigger:
+    def test_dumpcap_trigger_pattern(self, check_dumpcap_trigger_stdin, base_env):
+        '''Write the second before each DHCP ACK'''
+        check_dumpcap_trigger_stdin(self, ('--pre-trigger', 'duration:1', '--trigger', 'pattern:35:01:05'),
+                                    packets=50, discarded=50, env=base_env)
+
+    def test_dumpcap_trigger_pattern_duration(self, check_dumpcap_trigger_stdin, base_env):
+        '''Write the two seconds before each DHCP ACK'''
+        check_dumpcap_trigger_stdin(self, ('--pre-trigger', 'duration:2', '--trigger', 'pattern:350105'),
+                                    packets=75, discarded=25, env=base_env)
+
+    def test_dumpcap_trigger_post_trigger(self, check_dumpcap_trigger_stdin, base_env):
+        '''Write each DHCP ACK and the second after it'''
+        check_dumpcap_trigger_stdin(self, ('--pre-trigger', 'duration:0', '--trigger', 'pattern:350105', '--post-trigger', '1'),
+                                    packets=49, discarded=51, env=base_env)
+
+    def test_dumpcap_trigger_filter(self, check_dumpcap_trigger_stdin, base_env):
+        '''Write each packet from a DHCP server'''
+        check_dumpcap_trigger_stdin(self, ('--pre-trigger', 'duration:0', '--trigger', 'filter:udp src port 67'),
+                                    packets=50, discarded=50, env=base_env)
+
+    def test_dumpcap_trigger_bad_filter(self, cmd_dumpcap, capture_file, base_env):
+        '''A trigger filter that doesn't compile is an error'''
+        capture_proc = subprocess.run((cmd_dumpcap, '-i', '-', '-w', os.devnull, '--trigger', 'filter:no such filter'),
+            input=dhcp_pcap_rounds(capture_file, 1), capture_output=True, env=base_env)
+        assert capture_proc.returncode != 0
+
+    def test_dumpcap_trigger_sigusr1(self, cmd_dumpcap, cmd_capinfos, capture_file, result_file, base_env):
+        '''Write the packets kept so far on SIGUSR1'''
+        if sys.platform == 'win32':
+            pytest.skip('Test requires SIGUSR1.')
+        testout_file = result_file(testout_pcap)
+        capture_proc = subprocess.Popen((cmd_dumpcap, '-i', '-', '-w', testout_file, '--pre-trigger', 'size:100',
+                                         '--log-level=info'),
+            stdin=subprocess.PIPE, stderr=subprocess.PIPE, env=base_env)
+        capture_proc.stdin.write(dhcp_pcap_rounds(capture_file, 2))
+        capture_proc.stdin.flush()
+
+        def wait_for_stderr(message):
+            for line in capture_proc.stderr:
+                if message in line:
+                    return
+            pytest.fail('dumpcap exited before logging "{}"'.format(message.decode()))
+
+        # Wait until dumpcap has read the packets.
+        wait_for_stderr(b'8 packets kept before a trigger.')
+        capture_proc.send_signal(signal.SIGUSR1)
+        wait_for_stderr(b'Trigger fired, writing 8 packets kept before it.')
+        # These come after the trigger, so they're kept and discarded.
+        capture_proc.stdin.write(dhcp_pcap_rounds(capture_file, 2, first_round=2))
+        capture_proc.stdin.close()
+        stderr = capture_proc.stderr.read().decode('utf-8', 'replace')
+        assert capture_proc.wait() == 0
+        check_packet_count(cmd_capinfos, 8, testout_file)
+        assert "Packets discarded without a trigger on interface '-': 8" in stderr
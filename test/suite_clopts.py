@@ -9,6 +9,7 @@
 '''Command line option tests'''
 
 import json
+import re
 import sys
 import os.path
 import subprocess
@@ -313,6 +314,42 @@ class TestTsharkZExpert:
         assert not grep_output(proc.stdout, 'Chats')
 
 
+class TestTsharkZHeur:
+    def test_tshark_z_heur_stat(self, cmd_tshark, capture_file, test_env):
+        proc = subprocesstest.run((cmd_tshark, '-q', '-z', 'heur,stat',
+            '-r', capture_file('netperfmeter.pcapng.gz')), capture_output=True, env=test_env)
+        assert proc.returncode == 0
+        assert grep_output(proc.stdout, 'Heuristic Dissector Statistics')
+
+    def test_tshark_heur_adaptive_order(self, cmd_tshark, capture_file, test_env):
+        # Trying heuristics in registration order must give the same result.
+        adaptive = subprocesstest.run((cmd_tshark,
+            '-r', capture_file('netperfmeter.pcapng.gz')), capture_output=True, env=test_env)
+        fixed = subprocesstest.run((cmd_tshark,
+            '-o', 'protocols.heur_adaptive_order:FALSE',
+            '-r', capture_file('netperfmeter.pcapng.gz')), capture_output=True, env=test_env)
+        assert adaptive.stdout == fixed.stdout
+
+
+class TestTsharkZDissectorProf:
+    def test_tshark_z_dissector_prof(self, cmd_tshark, capture_file, test_env):
+        proc = subprocesstest.run((cmd_tshark, '-q', '-z', 'dissector,prof',
+            '-r', capture_file('dhcp.pcap')), capture_output=True, env=test_env)
+        assert proc.returncode == 0
+        assert grep_output(proc.stdout, 'Dissector Profile')
+        # Every frame goes through the frame dissector once.
+        assert re.search(r'^  frame +4 ', proc.stdout, re.MULTILINE)
+        assert re.search(r'^  dhcp ', proc.stdout, re.MULTILINE)
+
+class TestTsharkZReassemblyCache:
+    def test_tshark_z_reassembly_cache(self, cmd_tshark, capture_file, test_env):
+        proc = subprocesstest.run((cmd_tshark, '-q', '-z', 'reassembly,cache',
+            '-r', capture_file('http-ooo.pcap')), capture_output=True, env=test_env)
+        assert proc.returncode == 0
+        assert grep_output(proc.stdout, 'Reassembly Cache')
+        assert re.search(r'^  Budget: +unlimited$', proc.stdout, re.MULTILINE)
+        assert re.search(r'^  Evictions: +0$', proc.stdout, re.MULTILINE)
+
 class TestTsharkExtcap:
     # dumpcap dependency has been added to run this test only with capture support
     def test_tshark_extcap_interfaces(self, cmd_tshark, cmd_dumpcap, test_env, home_path):
@@ -332,3 +369,19 @@ class TestTsharkExtcap:
         # Ensure tshark lists 2 interfaces in the preferences
         proc = subprocesstest.run((cmd_tshark, '-G', 'currentprefs'), capture_output=True, env=test_env)
         assert count_output(proc.stdout, 'extcap.sampleif.test') == 2
+
+class TestRandpktClopts:
+    def test_randpkt_seed_deterministic(self, cmd_randpkt, result_file, test_env):
+        '''The same seed creates the same file'''
+        outputs = []
+        for name in ('randpkt-seed-a.pcap', 'randpkt-seed-b.pcap'):
+            pcap_file = result_file(name)
+            subprocess.check_call((cmd_randpkt,
+                    '--flows', '50',
+                    '--seed', '42',
+                    '-F', 'pcap',
+                    pcap_file,
+                ), env=test_env)
+            with open(pcap_file, 'rb') as f:
+                outputs.append(f.read())
+        assert outputs[0] == outputs[1]
@@ -758,6 +758,34 @@ class TestDecryptHttp2:
         assert grep_output(stdout, 'nghttp2')
 
 
+class TestDecryptRandpktFlows:
+    def test_randpkt_flows_tls13(self, cmd_randpkt, cmd_tshark, features, result_file, test_env):
+        '''TLS 1.3 flows created by randpkt, using its key log'''
+        if not features.have_nghttp2:
+            pytest.skip('Requires nghttp2.')
+        pcap_file = result_file('randpkt-flows.pcap')
+        key_file = result_file('randpkt-flows.keys')
+        subprocess.check_call((cmd_randpkt,
+                '--flows', '40',
+                '--flow-mix', 'tls:1,http2:1',
+                '--flow-size', '4000',
+                '--seed', '7',
+                '--keylog', key_file,
+                '-F', 'pcap',
+                pcap_file,
+            ), env=test_env)
+        stdout = subprocess.check_output((cmd_tshark,
+                '-r', pcap_file,
+                '-o', 'tls.keylog_file: {}'.format(key_file),
+                '-Y', 'http.request or http2.type == 1',
+                '-Tfields',
+                '-e', 'http.request.uri',
+                '-e', 'http2.header.value',
+            ), encoding='utf-8', env=test_env)
+        assert grep_output(stdout, '/object/0')
+        assert count_output(stdout) >= 40
+
+
 class TestDecryptKerberos:
     def test_kerberos(self, cmd_tshark, dirs, features, capture_file, test_env):
         '''Kerberos'''
@@ -460,3 +460,42 @@ class TestDfilterTFSValueString:
         error = 'expected "True" or "False", not "Unset"'
         dfilter = 'frame.ignored == "Unset"'
         checkDFilterFail(dfilter, error)
+
+class TestDfilterOptimizer:
+    trace_file = "dhcp.pcap"
+
+    def test_fold_1(self, checkDFilterSucceed):
+        dfilter = "udp.dstport == 66 + 1"
+        checkDFilterSucceed(dfilter, "udp.dstport == 67")
+
+    def test_fold_2(self, checkDFilterCount):
+        dfilter = "udp.dstport == {70 - 4} + 1"
+        checkDFilterCount(dfilter, 2)
+
+    def test_fuse_1(self, checkDFilterSucceed):
+        dfilter = "eth.src == 00:08:74:ad:f1:9b"
+        checkDFilterSucceed(dfilter, "FIELD_ANY_EQ")
+
+    def test_fuse_2(self, checkDFilterCount):
+        dfilter = "eth.src == 00:08:74:ad:f1:9b"
+        checkDFilterCount(dfilter, 2)
+
+    def test_fuse_3(self, checkDFilterCount):
+        dfilter = "ip.dst == 192.168.0.0/24"
+        checkDFilterCount(dfilter, 2)
+
+    def test_fuse_4(self, checkDFilterCount):
+        dfilter = "ip.addr != 192.168.0.10"
+        checkDFilterCount(dfilter, 2)
+
+    def test_fuse_5(self, checkDFilterCount):
+        dfilter = "udp.srcport > 67 or udp.dstport <= 66"
+        checkDFilterCount(dfilter, 2)
+
+    def test_layer_1(self, checkDFilterCount):
+        dfilter = "ip.src#1 == 192.168.0.1 and ip.src == 192.168.0.1"
+        checkDFilterCount(dfilter, 2)
+
+    def test_layer_2(self, checkDFilterCount):
+        dfilter = "ip.src#1 == 0.0.0.0 or ip.src#1 == 192.168.0.1"
+        checkDFilterCount(dfilter, 4)
@@ -9,6 +9,7 @@
 '''File I/O tests'''
 
 import io
+import json
 import os.path
 import subprocess
 from subprocesstest import cat_dhcp_command, check_packet_count
@@ -68,6 +69,147 @@ class TestTsharkIO:
         check_io_4_packets(capture_file, result_file, cmd_tshark, cmd_capinfos, env=test_env)
 
 
+class TestTsharkFieldIndex:
+    def run_filter(self, cmd_tshark, capture_file, test_env, dfilter, field_index=None):
+        cmd = [cmd_tshark, '-r', capture_file('dns+icmp.pcapng.gz'), '-2', '-Y', dfilter,
+               '-T', 'fields', '-e', 'frame.number', '--print-timers']
+        if field_index is not None:
+            cmd += ['-o', 'protocols.field_index:' + field_index]
+        proc = subprocess.run(cmd, check=True, capture_output=True, encoding='utf-8', env=test_env)
+        frames = [int(line) for line in proc.stdout.splitlines()]
+        return frames, json.loads(proc.stderr).get('field_index')
+
+    @pytest.mark.parametrize('dfilter,expected', (
+        ('udp.srcport == 53', [3, 11, 17, 25, 27]),
+        ('ip.dst == 8.8.8.8', [4, 6, 8]),
+        ('ip.src == 192.168.43.1 && udp.dstport == 51677', [3]),
+        ('dns', [1, 2, 3, 10, 11, 16, 17, 24, 25, 26, 27]),
+        ('icmp && !(ip.src == 192.168.43.9)', [5, 7, 9, 14, 19, 21, 23, 29, 31, 33]),
+    ))
+    def test_tshark_field_index_matches(self, cmd_tshark, capture_file, test_env, dfilter, expected):
+        '''Filtering with a field index gives the same frames as without'''
+        field_index = 'udp.srcport,udp.dstport,ip.src,ip.dst,dns,icmp'
+        frames, stats = self.run_filter(cmd_tshark, capture_file, test_env, dfilter)
+        assert frames == expected
+        assert stats is None
+        frames, stats = self.run_filter(cmd_tshark, capture_file, test_env, dfilter, field_index)
+        assert frames == expected
+        # All of the frames were recorded in the index, and the second
+        # pass consulted it instead of dissecting them.
+        assert stats['frames'] == 33
+        assert stats['frames_filtered'] > 0
+
+    def test_tshark_field_index_unindexed_field(self, cmd_tshark, capture_file, test_env):
+        '''Filters reading fields that aren't indexed still work'''
+        frames, stats = self.run_filter(cmd_tshark, capture_file, test_env, 'frame.len > 100', 'udp.srcport')
+        assert frames == [3, 11, 17]
+        assert stats['frames_filtered'] == 0
+
+
+class TestTsharkLimitDissection:
+    def run_fields(self, cmd_tshark, capture_file, test_env, capture, dfilter, fields, limit):
+        cmd = [cmd_tshark, '-r', capture_file(capture), '-Y', dfilter, '-T', 'fields']
+        for field in fields:
+            cmd += ['-e', field]
+        cmd += ['-o', 'protocols.limit_dissection_to_filter:' + ('TRUE' if limit else 'FALSE')]
+        return subprocess.check_output(cmd, encoding='utf-8', env=test_env)
+
+    @pytest.mark.parametrize('capture,dfilter,fields', (
+        ('gitOverTCP.pcap', 'tcp.srcport == 9418', ('frame.number', 'tcp.len')),
+        ('http.pcap', 'http.request', ('frame.number', 'http.request.uri')),
+        ('dns+icmp.pcapng.gz', 'dns.qry.name', ('frame.number', 'dns.qry.name')),
+        ('dns+icmp.pcapng.gz', 'ip.src == 192.168.43.9', ('frame.number', 'udp.srcport')),
+        ('dns+icmp.pcapng.gz', 'icmp', ('frame.number', 'ip.dst')),
+        # DTLS is found by UDP's heuristics
+        ('dtls12-aes128ccm8.pcap', 'dtls.handshake', ('frame.number', 'dtls.handshake.type')),
+    ))
+    def test_tshark_limit_dissection_matches(self, cmd_tshark, capture_file, test_env, capture, dfilter, fields):
+        '''Limiting dissection to the filter's protocols gives the same fields'''
+        expected = self.run_fields(cmd_tshark, capture_file, test_env, capture, dfilter, fields, False)
+        limited = self.run_fields(cmd_tshark, capture_file, test_env, capture, dfilter, fields, True)
+        assert expected
+        assert limited == expected
+
+    def test_tshark_limit_dissection_expert(self, cmd_tshark, capture_file, test_env):
+        '''Filters on fields any protocol can add aren't limited'''
+        expected = self.run_fields(cmd_tshark, capture_file, test_env, 'http.pcap', '_ws.expert', ('frame.number',), False)
+        limited = self.run_fields(cmd_tshark, capture_file, test_env, 'http.pcap', '_ws.expert', ('frame.number',), True)
+        assert limited == expected
+
+    def run_limited(self, cmd_tshark, capture_file, test_env, dfilter, fields):
+        cmd = [cmd_tshark, '-r', capture_file('tls12-chacha20poly1305.pcap'), '-Y', dfilter,
+               '-T', 'fields', '-o', 'protocols.limit_dissection_to_filter:TRUE', '--log-level=debug']
+        for field in fields:
+            cmd += ['-e', field]
+        proc = subprocess.run(cmd, check=True, capture_output=True, encoding='utf-8', env=test_env)
+        # The limit was applied, not skipped.
+        assert 'dissection limited to' in proc.stderr
+        return [line.split('\t') for line in proc.stdout.splitlines()]
+
+    def test_tshark_limit_dissection_tcp_state(self, cmd_tshark, capture_file, test_env):
+        '''TCP keeps tracking its streams when TLS isn't dissected'''
+        fields = ('frame.number', 'tcp.stream', 'tcp.seq', 'tcp.ack', 'tcp.analysis.bytes_in_flight')
+        limited = self.run_limited(cmd_tshark, capture_file, test_env,
+                                   'tcp.srcport == 443 && tcp.len > 1400', fields)
+        # Seven connections, each with two full-sized segments from the server.
+        assert [(int(f[0]), int(f[1])) for f in limited] == [
+            (6, 0), (7, 0), (15, 1), (16, 1), (20, 2), (25, 2), (26, 2),
+            (34, 3), (35, 3), (43, 4), (44, 4), (52, 5), (53, 5), (61, 6), (62, 6),
+        ]
+        expected = self.run_fields(cmd_tshark, capture_file, test_env, 'tls12-chacha20poly1305.pcap',
+                                   'tcp.srcport == 443 && tcp.len > 1400', fields, False)
+        assert limited == [line.split('\t') for line in expected.splitlines()]
+
+    def test_tshark_limit_dissection_reassembly(self, cmd_tshark, capture_file, test_env):
+        '''TCP still reassembles segments for a wanted protocol above it'''
+        dfilter = 'tcp.srcport == 443 && tls.record.content_type == 23'
+        fields = ('frame.number', 'tcp.stream', 'tls.record.length')
+        limited = self.run_limited(cmd_tshark, capture_file, test_env, dfilter, fields)
+        # Each response spans three segments and is dissected in the last one.
+        assert limited == [
+            ['8', '0', '4256'], ['17', '1', '4250'], ['27', '2', '4143'], ['36', '3', '4154'],
+            ['45', '4', '4154'], ['54', '5', '4261'], ['63', '6', '4142'],
+        ]
+        expected = self.run_fields(cmd_tshark, capture_file, test_env, 'tls12-chacha20poly1305.pcap',
+                                   dfilter, fields, False)
+        assert limited == [line.split('\t') for line in expected.splitlines()]
+
+
+class TestCapinfosIO:
+    def test_capinfos_io_multiple_files_order(self, cmd_capinfos, capture_file, result_file, test_env):
+        '''Files processed in parallel are reported in command line order'''
+        good_file = capture_file('dhcp.pcap')
+        gz_file = capture_file('dns+icmp.pcapng.gz')
+        missing_file = result_file('missing.pcap')
+        bogus_file = result_file('bogus.pcap')
+        with open(bogus_file, 'w') as f:
+            f.write('This is not a capture file.\n' * 10)
+        truncated_file = result_file('truncated.pcap')
+        with open(good_file, 'rb') as f:
+            data = f.read()
+        with open(truncated_file, 'wb') as f:
+            f.write(data[:-10])
+
+        files = [good_file, missing_file, truncated_file, bogus_file, gz_file] * 3
+        # Merge the streams; stdout is flushed after each file, so anything
+        # reported out of order shows up here.
+        capinfos_proc = subprocess.run((cmd_capinfos, '-c', *files),
+            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, encoding='utf-8', env=test_env)
+        assert capinfos_proc.returncode == 2
+
+        reported = []
+        for line in capinfos_proc.stdout.splitlines():
+            for name in (good_file, gz_file, missing_file, bogus_file, truncated_file):
+                if name in line and (not reported or reported[-1] != name):
+                    reported.append(name)
+        assert reported == files
+        assert capinfos_proc.stdout.count('Number of packets:') == 9
+        assert capinfos_proc.stdout.count('(will continue anyway') == 3
+        # A truncated file's errors come right before its report.
+        output = capinfos_proc.stdout
+        assert output.index('An error occurred after reading 3 packets') < output.index('File name:           ' + truncated_file)
+
+
 class TestRawsharkIO:
     if sys.byteorder != 'little':
         pytest.skip('Requires a little endian system')
@@ -8,8 +8,10 @@
 #
 '''Name resolution tests'''
 
+import ipaddress
 import os.path
 import shutil
+import struct
 import subprocess
 from subprocesstest import grep_output
 import pytest
@@ -132,3 +134,164 @@ class TestNameResolution:
                 ), encoding='utf-8')
         assert '174.137.42.65\twww.wireshark.org' not in stdout
         assert 'fe80::6233:4bff:fe13:c558\tCrunch.local' in stdout
+
+
+class MMDBWriter:
+    '''Writes a minimal MaxMind DB file with 24-bit records.
+
+    Repeated strings are written as pointers so that readers have to
+    follow them.'''
+    def __init__(self, ip_version=6):
+        self.ip_version = ip_version
+        self.nodes = [[None, None]]
+        self.data = bytearray()
+        self.strings = {}
+
+    @staticmethod
+    def _ctrl(data_type, size):
+        if data_type <= 7:
+            first, ext = data_type << 5, b''
+        else:
+            first, ext = 0, bytes([data_type - 7])
+        if size < 29:
+            return bytes([first | size]) + ext
+        if size < 285:
+            return bytes([first | 29]) + ext + bytes([size - 29])
+        return bytes([first | 30]) + ext + (size - 285).to_bytes(2, 'big')
+
+    @staticmethod
+    def _pointer(offset):
+        if offset < 2048:
+            return bytes([0x20 | (offset >> 8), offset & 0xff])
+        offset -= 2048
+        return bytes([0x28 | (offset >> 16)]) + (offset & 0xffff).to_bytes(2, 'big')
+
+    def _write(self, buf, value, strings):
+        if isinstance(value, str):
+            encoded = value.encode('utf-8')
+            if strings is not None and encoded in strings:
+                buf += self._pointer(strings[encoded])
+                return
+            if strings is not None:
+                strings[encoded] = len(buf)
+            buf += self._ctrl(2, len(encoded)) + encoded
+        elif isinstance(value, dict):
+            buf += self._ctrl(7, len(value))
+            for key, item in value.items():
+                self._write(buf, key, strings)
+                self._write(buf, item, strings)
+        elif isinstance(value, list):
+            buf += self._ctrl(11, len(value))
+            for item in value:
+                self._write(buf, item, strings)
+        elif isinstance(value, float):
+            buf += self._ctrl(3, 8) + struct.pack('>d', value)
+        elif isinstance(value, int):
+            encoded = value.to_bytes((value.bit_length() + 7) // 8, 'big')
+            buf += self._ctrl(6, len(encoded)) + encoded
+        else:
+            raise TypeError(value)
+
+    def insert(self, network, record):
+        net = ipaddress.ip_network(network)
+        bits = int(net.network_address)
+        prefixlen = net.prefixlen
+        if net.version == 4 and self.ip_version == 6:
+            prefixlen += 96
+        total_bits = 128 if self.ip_version == 6 else 32
+        offset = len(self.data)
+        self._write(self.data, record, self.strings)
+        node = 0
+        for depth in range(prefixlen):
+            bit = (bits >> (total_bits - 1 - depth)) & 1
+            if depth == prefixlen - 1:
+                self.nodes[node][bit] = ('data', offset)
+            else:
+                if self.nodes[node][bit] is None:
+                    self.nodes.append([None, None])
+                    self.nodes[node][bit] = ('node', len(self.nodes) - 1)
+                node = self.nodes[node][bit][1]
+
+    def write(self, path):
+        node_count = len(self.nodes)
+        def record_value(record):
+            if record is None:
+                return node_count
+            if record[0] == 'node':
+                return record[1]
+            return node_count + 16 + record[1]
+        out = bytearray()
+        for left, right in self.nodes:
+            out += record_value(left).to_bytes(3, 'big') + record_value(right).to_bytes(3, 'big')
+        out += bytes(16) + self.data + b'\xab\xcd\xefMaxMind.com'
+        self._write(out, {
+            'binary_format_major_version': 2,
+            'binary_format_minor_version': 0,
+            'build_epoch': 1700000000,
+            'database_type': 'Wireshark-Test',
+            'description': {'en': 'Wireshark test database'},
+            'ip_version': self.ip_version,
+            'languages': ['en'],
+            'node_count': node_count,
+            'record_size': 24,
+        }, None)
+        with open(path, 'wb') as f:
+            f.write(out)
+
+
+@pytest.fixture
+def mmdb_env(features, conf_path, test_env):
+    if not features.have_maxminddb:
+        pytest.skip('Requires MaxMind DB support')
+    db_dir = os.path.join(conf_path, 'GeoIP')
+    os.makedirs(db_dir)
+    writer = MMDBWriter()
+    writer.insert('8.8.8.0/24', {
+        'city': {'names': {'en': 'Test City'}},
+        'country': {'iso_code': 'NL', 'names': {'en': 'Netherlands'}},
+        'location': {'accuracy_radius': 50, 'latitude': 52.5, 'longitude': 4.75},
+    })
+    writer.insert('4.2.2.0/24', {
+        'autonomous_system_number': 64496,
+        'autonomous_system_organization': 'Example AS',
+        'country': {'iso_code': 'US', 'names': {'en': 'United States'}},
+    })
+    writer.write(os.path.join(db_dir, 'test.mmdb'))
+    # uat.c replaces backslashes...
+    with open(os.path.join(conf_path, 'maxmind_db_paths'), 'w') as f:
+        f.write('"{}"\n'.format(db_dir.replace('\\', '\\x5c')))
+    return test_env
+
+
+class TestMaxMindDB:
+    def run_geoip(self, cmd_tshark, capture_file, env, *args):
+        return subprocess.check_output((cmd_tshark,
+                '-r', capture_file('dns+icmp.pcapng.gz'),
+                '-o', 'nameres.maxmind_geoip:TRUE',
+                ) + args, encoding='utf-8', env=env)
+
+    def test_maxmind_db_lookup(self, cmd_tshark, capture_file, mmdb_env):
+        '''Addresses are looked up in a generated database'''
+        stdout = self.run_geoip(cmd_tshark, capture_file, mmdb_env,
+                '-Y', 'frame.number == 5', '-T', 'fields',
+                '-e', 'ip.geoip.src_city', '-e', 'ip.geoip.src_country_iso',
+                '-e', 'ip.geoip.src_country')
+        assert stdout.strip() == 'Test City\tNL\tNetherlands'
+        stdout = self.run_geoip(cmd_tshark, capture_file, mmdb_env,
+                '-Y', 'frame.number == 18', '-T', 'fields',
+                '-e', 'ip.geoip.dst_asnum', '-e', 'ip.geoip.dst_org',
+                '-e', 'ip.geoip.dst_country_iso')
+        assert stdout.strip() == '64496\tExample AS\tUS'
+
+    def test_maxmind_db_location(self, cmd_tshark, capture_file, mmdb_env):
+        '''Coordinates are decoded exactly'''
+        stdout = self.run_geoip(cmd_tshark, capture_file, mmdb_env,
+                '-Y', 'ip.geoip.src_lat == 52.5 && ip.geoip.src_lon == 4.75',
+                '-T', 'fields', '-e', 'frame.number')
+        assert stdout.split() == ['5', '7', '9']
+
+    def test_maxmind_db_not_found(self, cmd_tshark, capture_file, mmdb_env):
+        '''Addresses outside the database have no geolocation'''
+        stdout = self.run_geoip(cmd_tshark, capture_file, mmdb_env,
+                '-Y', 'ip.geoip && !(ip.addr == 8.8.8.0/24 || ip.addr == 4.2.2.0/24)')
+        assert stdout == ''
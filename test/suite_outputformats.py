@@ -11,6 +11,7 @@
 import json
 import os.path
 import subprocess
+import sys
 from matchers import *
 import pytest
 
@@ -90,3 +91,77 @@ class TestOutputFormats:
         ''' Check that the option -j works with -Tek.'''
         check_outputformat("ek", extra_args=['-j', 'dhcp'], expected="dhcp-filter.ek",
             multiline=True, env=base_env)
+
+
+def drop_stream_indexes(obj):
+    '''Remove the fields that are numbered separately in each shard.'''
+    if isinstance(obj, dict):
+        return {k: drop_stream_indexes(v) for k, v in obj.items() if not k.endswith('.stream')}
+    if isinstance(obj, list):
+        return [drop_stream_indexes(v) for v in obj]
+    return obj
+
+
+@pytest.mark.skipif(sys.platform == 'win32', reason='--shards needs fork()')
+class TestOutputFormatsShards:
+    def test_outputformat_json_shards(self, cmd_tshark, capture_file, dirs, base_env):
+        '''Sharded json output is the same, in frame order.'''
+        tshark_proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+                                      '-T', 'json', '--shards', '2'],
+                                      check=True, capture_output=True, encoding='utf-8', env=base_env)
+        expected = json.loads(open(os.path.join(dirs.baseline_dir, 'dhcp.json')).read())
+        assert drop_stream_indexes(expected) == drop_stream_indexes(json.loads(tshark_proc.stdout))
+
+    def test_outputformat_fields_shards(self, cmd_tshark, capture_file, base_env):
+        '''Sharded fields output, including request/response matching, is the same.'''
+        fields_args = ['-r', capture_file('dns+icmp.pcapng.gz'), '-T', 'fields',
+                       '-e', 'frame.number', '-e', 'ip.src', '-e', 'udp.srcport',
+                       '-e', 'dns.id', '-e', 'dns.qry.name', '-e', 'dns.response_to']
+        single_proc = subprocess.run([cmd_tshark] + fields_args,
+                                     check=True, capture_output=True, encoding='utf-8', env=base_env)
+        sharded_proc = subprocess.run([cmd_tshark, '--shards', '3'] + fields_args,
+                                      check=True, capture_output=True, encoding='utf-8', env=base_env)
+        assert single_proc.stdout == sharded_proc.stdout
+
+    def test_outputformat_shards_conflict(self, cmd_tshark, capture_file, base_env):
+        '''--shards can't be combined with two-pass analysis.'''
+        tshark_proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+                                      '-2', '--shards', '2'],
+                                      capture_output=True, encoding='utf-8', env=base_env)
+        assert tshark_proc.returncode != 0
+        assert '--shards can\'t be used with -2' in tshark_proc.stderr
+
+
+class TestOutputFormatsFormatThreads:
+    @pytest.mark.parametrize('format_args', [['-V'], ['-T', 'pdml'], ['-T', 'json'], ['-T', 'jsonraw']])
+    def test_outputformat_format_threads(self, cmd_tshark, capture_file, base_env, format_args):
+        '''Packet details printed in formatter threads are the same, in frame order.'''
+        # Reassembled payloads are printed after later frames were dissected.
+        read_args = ['-r', capture_file('http-ooo.pcap'), '-o', 'tcp.reassemble_out_of_order:TRUE']
+        single_proc = subprocess.run([cmd_tshark] + read_args + format_args,
+                                     check=True, capture_output=True, encoding='utf-8', env=base_env)
+        threaded_proc = subprocess.run([cmd_tshark, '--format-threads', '3'] + read_args + format_args,
+                                       check=True, capture_output=True, encoding='utf-8', env=base_env)
+        assert single_proc.stdout == threaded_proc.stdout
+
+    def test_outputformat_format_threads_name_resolution(self, cmd_tshark, capture_file, conf_path, base_env):
+        '''Resolved names are the same when the packet details are printed in formatter threads.'''
+        # The labels with names are filled in before the packets are handed
+        # to the formatter threads.
+        with open(os.path.join(conf_path, 'hosts'), 'w') as hosts_file:
+            hosts_file.write('8.8.8.8\tformat-threads-8-8-8-8\n')
+        read_args = ['-r', capture_file('dns+icmp.pcapng.gz'), '-N', 'n', '-V']
+        single_proc = subprocess.run([cmd_tshark] + read_args,
+                                     check=True, capture_output=True, encoding='utf-8', env=base_env)
+        threaded_proc = subprocess.run([cmd_tshark, '--format-threads', '3'] + read_args,
+                                       check=True, capture_output=True, encoding='utf-8', env=base_env)
+        assert 'format-threads-8-8-8-8' in single_proc.stdout
+        assert single_proc.stdout == threaded_proc.stdout
+
+    def test_outputformat_format_threads_summary(self, cmd_tshark, capture_file, base_env):
+        '''--format-threads only applies to packet details.'''
+        tshark_proc = subprocess.run([cmd_tshark, '-r', capture_file('dhcp.pcap'),
+                                      '--format-threads', '2'],
+                                      capture_output=True, encoding='utf-8', env=base_env)
+        assert tshark_proc.returncode != 0
+        assert '--format-threads only applies to packet details' in tshark_proc.stderr
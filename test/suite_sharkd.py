@@ -536,6 +536,31 @@ class TestSharkd:
             }},
         ))
 
+    def test_sharkd_req_tap_dissector_prof(self, check_sharkd_session, capture_file):
+        matchProfile = MatchObject({
+            "name": MatchAny(str),
+            "calls": MatchAny(int),
+            "incl_ns": MatchAny(int),
+            "excl_ns": MatchAny(int),
+            "incl_bytes": MatchAny(int),
+            "excl_bytes": MatchAny(int),
+        })
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+             "params":{"file": capture_file('dhcp.pcap')}
+             },
+            {"jsonrpc":"2.0", "id":2, "method":"tap", "params":{"tap0": "dissector-prof"}},
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{
+                "taps":[{
+                    "tap":"dissector-prof",
+                    "type":"dissector-prof",
+                    "dissectors":MatchList(matchProfile),
+                }]
+            }},
+        ))
+
     def test_sharkd_req_tap_voip_calls(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -1103,6 +1128,28 @@ class TestSharkd:
             },
         ))
 
+    @pytest.mark.parametrize('capture,follow,stream', (
+        ('gitOverTCP.pcap', 'TCP', 0),
+        ('dhcp.pcap', 'UDP', 0),
+    ))
+    def test_sharkd_req_follow_stream_index(self, run_sharkd_session, capture_file, capture, follow, stream):
+        '''Following an indexed stream gives the same result as retapping all frames'''
+        filter = '{}.stream eq {}'.format(follow.lower(), stream)
+        outputs = run_sharkd_session([json.dumps(x) for x in (
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file(capture)}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"follow",
+            "params":{"follow": follow, "filter": filter}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"follow",
+            "params":{"follow": follow, "filter": filter, "stream": stream}
+            },
+        )])
+        assert len(outputs) == 3
+        assert outputs[1]['result']['payloads']
+        assert outputs[2]['result'] == outputs[1]['result']
+
     def test_sharkd_req_iograph_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -1474,3 +1521,38 @@ class TestSharkd:
             {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
             MatchAny(),
         ))
+
+    def test_sharkd_req_tap_parallel(self, cmd_sharkd, capture_file, base_env):
+        '''Conversation, endpoint and RTD tables are the same with and without parallel retap.'''
+        commands = (
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('sip-rtp.pcapng')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"tap",
+            "params":{"tap0": "conv:IPv4", "tap1": "conv:UDP", "tap2": "endpt:UDP", "tap3": "rtd:radius"}
+            },
+        )
+
+        def run_taps(tap_threads):
+            env = dict(base_env)
+            env['WIRESHARK_TAP_THREADS'] = tap_threads
+            sharkd_proc = subprocess.run((cmd_sharkd, '-'),
+                input='\n'.join(json.dumps(x) for x in commands),
+                capture_output=True, encoding='utf-8', env=env)
+            outputs = [json.loads(line) for line in sharkd_proc.stdout.splitlines() if line.strip()]
+            assert outputs[0]['result'] == {'status': 'OK'}
+            taps = {tap['tap']: tap for tap in outputs[1]['result']['taps']}
+            # Merged tables can list the entries in a different order.
+            for tap in taps.values():
+                if tap['type'] == 'conv':
+                    tap['convs'].sort(key=lambda x: json.dumps(x, sort_keys=True))
+                elif tap['type'] == 'host':
+                    tap['hosts'].sort(key=lambda x: json.dumps(x, sort_keys=True))
+            return taps
+
+        serial = run_taps('1')
+        # Enough packets for several workers, each with a run of its own.
+        parallel = run_taps('4')
+        assert serial['conv:IPv4']['convs']
+        assert serial['endpt:UDP']['hosts']
+        assert parallel == serial
@@ -547,3 +547,28 @@ class TestText2pcapOtherOptions:
         subprocess.check_call((cmd_text2pcap, "-F", "pcapng", "-N", "your-interface-name", testin_file, testout_file), env=base_env)
         stdout = subprocess.check_output((cmd_tshark, "-r", testout_file, "-Tfields", "-eframe.interface_name", "-c1"), encoding='utf-8', env=base_env)
         assert stdout.rstrip() == "your-interface-name"
+
+
+class TestText2pcapLargeInput:
+    def test_text2pcap_chunked_matches_scanner(self, cmd_tshark, cmd_text2pcap, capture_file, result_file, base_env):
+        '''Test that a hexdump read in parallel chunks matches one read from a pipe by the scanner'''
+        testin_file = result_file(testin_txt)
+        hexdump = subprocess.check_output((cmd_tshark,
+            '-r', capture_file('snakeoil-dtls.pcap'),
+            '-o', 'gui.column.format:"Time","%t"',
+            '-t', 'ad', '-P', '--hexdump', 'frames',
+        ), env=base_env)
+        # Make it span several chunks
+        repeat = 1 + (4 * 1024 * 1024) // len(hexdump)
+        with open(testin_file, 'wb') as f:
+            f.write(hexdump * repeat)
+
+        text2pcap_args = (cmd_text2pcap, '-F', 'pcap', '-t', '%Y-%m-%d %H:%M:%S.%f')
+        chunked_file = result_file('chunked.pcap')
+        scanned_file = result_file('scanned.pcap')
+        subprocess.run(text2pcap_args + (testin_file, chunked_file), check=True, capture_output=True, env=base_env)
+        with open(testin_file, 'rb') as f:
+            subprocess.run(text2pcap_args + ('-', scanned_file), input=f.read(), check=True, capture_output=True, env=base_env)
+
+        with open(chunked_file, 'rb') as chunked, open(scanned_file, 'rb') as scanned:
+            assert chunked.read() == scanned.read()
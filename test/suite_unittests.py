@@ -15,14 +15,38 @@ import pytest
 
 
 class TestUnitTests:
+    def test_unit_dfilter_multi_test(self, program, base_env):
+        '''dfilter_multi_test'''
+        subprocess.check_call(program('dfilter_multi_test'), env=base_env)
+
+    def test_unit_dissector_table_test(self, program, base_env):
+        '''dissector_table_test'''
+        subprocess.check_call(program('dissector_table_test'), env=base_env)
+
     def test_unit_exntest(self, program, base_env):
         '''exntest'''
         subprocess.check_call(program('exntest'), env=base_env)
 
+    def test_unit_io_graph_item_test(self, program, base_env):
+        '''io_graph_item_test'''
+        subprocess.check_call(program('io_graph_item_test'), env=base_env)
+
     def test_unit_oids_test(self, program, base_env):
         '''oids_test'''
         subprocess.check_call(program('oids_test'), env=base_env)
 
+    def test_unit_pcapio_test(self, program, base_env):
+        '''pcapio_test'''
+        subprocess.check_call(program('pcapio_test'), env=base_env)
+
+    def test_unit_proto_data_test(self, program, base_env):
+        '''proto_data_test'''
+        subprocess.check_call(program('proto_data_test'), env=base_env)
+
+    def test_unit_proto_lazy_test(self, program, base_env):
+        '''proto_lazy_test'''
+        subprocess.check_call(program('proto_lazy_test'), env=base_env)
+
     def test_unit_reassemble_test(self, program, base_env):
         '''reassemble_test'''
         subprocess.check_call(program('reassemble_test'), env=base_env)
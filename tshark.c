@@ -30,6 +30,8 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 
 #include <glib.h>
@@ -54,6 +56,7 @@
 #include <cli_main.h>
 #include <wsutil/version_info.h>
 #include <wiretap/wtap_opttypes.h>
+#include <wiretap/pcap-encap.h>
 
 #include "globals.h"
 #include <epan/timestamp.h>
@@ -85,6 +88,7 @@
 #include "ui/dissect_opts.h"
 #include "ui/ssl_key_export.h"
 #include "ui/failure_message.h"
+#include "ui/flow_shard.h"
 #if defined(HAVE_LIBSMI)
 #include "epan/oids.h"
 #endif
@@ -143,6 +147,10 @@
 #define LONGOPT_HEXDUMP                 LONGOPT_BASE_APPLICATION+7
 #define LONGOPT_SELECTED_FRAME          LONGOPT_BASE_APPLICATION+8
 #define LONGOPT_PRINT_TIMERS            LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_SHARDS                  LONGOPT_BASE_APPLICATION+10
+#define LONGOPT_SHARD_KEY               LONGOPT_BASE_APPLICATION+11
+#define LONGOPT_SHM_BUFFER              LONGOPT_BASE_APPLICATION+12
+#define LONGOPT_FORMAT_THREADS          LONGOPT_BASE_APPLICATION+13
 
 capture_file cfile;
 
@@ -157,6 +165,59 @@ static gboolean epan_auto_reset = FALSE;
 
 static guint32 selected_frame_number = 0;
 
+/*
+ * With --shards, the flows of the file are indexed first, and then one
+ * worker process per shard dissects the frames of its flows; see
+ * process_cap_file_sharded().
+ */
+static guint shard_count = 0;
+static flow_shard_index_t *shard_index = NULL;
+static guint shard_id;              /* In a worker, the shard it dissects */
+#ifndef _WIN32
+static flow_shard_key_e shard_key = FLOW_SHARD_KEY_5TUPLE;
+static int shard_pipe = -1;         /* In a worker, where frame output goes */
+#endif
+
+/*
+ * With --format-threads, packet details are printed in a pool of threads
+ * while the next packets are dissected. Each packet in flight has a slot
+ * of its own, holding its dissection and its output until the output has
+ * been written, in order; see format_slot_claim().
+ */
+#define FORMAT_SLOTS_PER_THREAD     4
+
+typedef enum {
+    FORMAT_SLOT_FREE,
+    FORMAT_SLOT_FORMATTING,
+    FORMAT_SLOT_FORMATTED
+} format_slot_state_e;
+
+typedef struct {
+    epan_dissect_t     *edt;
+    frame_data          fdata;
+    wtap_rec            rec;
+    Buffer              buf;        /* The packet data */
+    FILE               *out;        /* Scratch file for the output */
+    print_stream_t     *stream;     /* Text output to out */
+    json_dumper         dumper;     /* JSON output to out */
+    format_slot_state_e state;      /* Protected by format_mutex */
+    gboolean            success;
+} format_slot_t;
+
+static guint format_thread_count = 0;
+static GThreadPool *format_pool = NULL;
+static format_slot_t *format_slots = NULL;
+static guint format_slot_count = 0;
+static guint format_head;
+static guint format_in_flight;
+static GMutex format_mutex;
+static GCond format_cond;
+
+/* The frame tvbuffs of packets in slots get this provider, which has no
+   file to re-read their data from, so that tvbuffs cloned from them are
+   copies; the formatter threads mustn't read the file. */
+static const struct packet_provider_data format_tvb_provider;
+
 /*
  * The way the packet decode is to be written.
  */
@@ -215,6 +276,27 @@ static capture_options global_capture_opts;
 static capture_session global_capture_session;
 static info_data_t global_info_data;
 
+/*
+ * Size, in kB, of the shared memory in which dumpcap hands us packets,
+ * or 0 to read them from the capture file.
+ */
+static guint shm_buffer_kb = 0;
+
+/*
+ * TRUE if we're getting packets from shared memory for the current
+ * capture file, along with what we need to know about its interfaces
+ * to make records of them.
+ */
+static gboolean capture_from_shm;
+static gboolean shm_file_is_pcapng;
+static GArray *shm_if_info;
+static guint64 shm_packet_count;    /* packets dissected from shared memory */
+
+typedef struct {
+    int encap;
+    int tsprecision;
+} shm_if_info_t;
+
 #ifdef SIGINFO
 static gboolean infodelay;      /* if TRUE, don't print capture info in SIGINFO handler */
 static gboolean infoprint;      /* if TRUE, print capture info after clearing infodelay */
@@ -255,11 +337,13 @@ typedef enum {
 static process_file_status_t process_cap_file(capture_file *, char *, int, gboolean, int, gint64, int);
 
 static gboolean process_packet_single_pass(capture_file *cf,
-        epan_dissect_t *edt, gint64 offset, wtap_rec *rec, Buffer *buf,
+        epan_dissect_t *edt, gint64 offset, wtap_rec *rec, const guint8 *pd,
         guint tap_flags);
 static void show_print_file_io_error(void);
 static gboolean write_preamble(capture_file *cf);
 static gboolean print_packet(capture_file *cf, epan_dissect_t *edt);
+static gboolean print_packet_to(capture_file *cf, epan_dissect_t *edt,
+        print_stream_t *stream, FILE *fh, json_dumper *dumper);
 static gboolean write_finale(void);
 
 static void tshark_cmdarg_err(const char *msg_format, va_list ap);
@@ -334,6 +418,21 @@ print_elapsed_json(const char *cf_name, const char *dfilter)
         json_dumper_end_object(&dumper);
     }
     json_dumper_end_array(&dumper);
+    if (cfile.field_index) {
+        field_index_stats_t fi_stats;
+
+        field_index_get_stats(cfile.field_index, &fi_stats);
+        json_dumper_set_member_name(&dumper, "field_index");
+        json_dumper_begin_object(&dumper);
+        DUMP("fields", (gint64)fi_stats.num_fields);
+        DUMP("frames", (gint64)fi_stats.num_frames);
+        DUMP("values", (gint64)fi_stats.num_values);
+        DUMP("strings", (gint64)fi_stats.num_strings);
+        DUMP("memory_bytes", (gint64)fi_stats.memory_used);
+        DUMP("build", fi_stats.build_time);
+        DUMP("frames_filtered", (gint64)fi_stats.frames_filtered);
+        json_dumper_end_object(&dumper);
+    }
     json_dumper_end_object(&dumper);
     json_dumper_finish(&dumper);
 }
@@ -445,6 +544,8 @@ print_usage(FILE *output)
     fprintf(output, "                           print list of link-layer types of iface and exit\n");
     fprintf(output, "  --list-time-stamp-types  print list of timestamp types for iface and exit\n");
     fprintf(output, "  --update-interval        interval between updates with new packets (def: %dms)\n", DEFAULT_UPDATE_INTERVAL);
+    fprintf(output, "  --shm-buffer <kB>        get packets from dumpcap in shared memory of this size\n");
+    fprintf(output, "                           rather than by reading the capture file\n");
     fprintf(output, "\n");
     fprintf(output, "Capture stop conditions:\n");
     fprintf(output, "  -c <packet count>        stop after n packets (def: infinite)\n");
@@ -478,6 +579,13 @@ print_usage(FILE *output)
     fprintf(output, "Processing:\n");
     fprintf(output, "  -2                       perform a two-pass analysis\n");
     fprintf(output, "  -M <packet count>        perform session auto reset\n");
+#ifndef _WIN32
+    fprintf(output, "  --shards <count>         dissect in this many processes, each taking a share\n");
+    fprintf(output, "                           of the flows (requires -r with a file)\n");
+    fprintf(output, "  --shard-key 5-tuple|hosts\n");
+    fprintf(output, "                           what frames in the same shard have in common\n");
+    fprintf(output, "                           (def: 5-tuple)\n");
+#endif
     fprintf(output, "  -R <read filter>, --read-filter <read filter>\n");
     fprintf(output, "                           packet Read filter in Wireshark display filter syntax\n");
     fprintf(output, "                           (requires -2)\n");
@@ -570,6 +678,8 @@ print_usage(FILE *output)
     fprintf(output, "  --no-duplicate-keys      If -T json is specified, merge duplicate keys in an object\n");
     fprintf(output, "                           into a single key with as value a json array containing all\n");
     fprintf(output, "                           values\n");
+    fprintf(output, "  --format-threads <count> print packet details (-V, -T pdml|json|jsonraw) in this\n");
+    fprintf(output, "                           many threads while dissecting (requires -r)\n");
     fprintf(output, "  --elastic-mapping-filter <protocols> If -G elastic-mapping is specified, put only the\n");
     fprintf(output, "                           specified protocols within the mapping file\n");
     fprintf(output, "  --temp-dir <directory>   write temporary files to this directory\n");
@@ -876,6 +986,35 @@ must_do_dissection(dfilter_t *rfcode, dfilter_t *dfcode,
         tap_listeners_require_dissection() || dissect_color;
 }
 
+/*
+ * If we're only filtering packets or printing -e fields, and the user
+ * asked for it, dissect only the protocols the filters and the fields
+ * need.
+ */
+static void
+limit_dissection(dfilter_t *rfcode, dfilter_t *dfcode,
+        gchar *volatile pdu_export_arg)
+{
+    GArray *hfids;
+
+    if (pdu_export_arg || dissect_color)
+        return;
+
+    /* Anything other than -T fields without columns shows the whole
+       protocol tree, the columns, or the data sources. */
+    if (print_packet_info &&
+            (output_action != WRITE_FIELDS || print_hex ||
+             output_fields_has_cols(output_fields)))
+        return;
+
+    hfids = g_array_new(FALSE, FALSE, sizeof(int));
+    if (print_packet_info)
+        output_fields_append_hfids(output_fields, hfids);
+    if (epan_limit_dissection(rfcode, dfcode, hfids))
+        ws_debug("tshark: limiting dissection to the protocols used by the filters");
+    g_array_free(hfids, TRUE);
+}
+
 #ifdef HAVE_LIBPCAP
 /*
  * Check whether a purported *shark packet-matching expression (display
@@ -948,6 +1087,10 @@ main(int argc, char *argv[])
         {"hexdump", ws_required_argument, NULL, LONGOPT_HEXDUMP},
         {"selected-frame", ws_required_argument, NULL, LONGOPT_SELECTED_FRAME},
         {"print-timers", ws_no_argument, NULL, LONGOPT_PRINT_TIMERS},
+        {"shards", ws_required_argument, NULL, LONGOPT_SHARDS},
+        {"shard-key", ws_required_argument, NULL, LONGOPT_SHARD_KEY},
+        {"shm-buffer", ws_required_argument, NULL, LONGOPT_SHM_BUFFER},
+        {"format-threads", ws_required_argument, NULL, LONGOPT_FORMAT_THREADS},
         {0, 0, 0, 0}
     };
     gboolean             arg_error = FALSE;
@@ -968,6 +1111,7 @@ main(int argc, char *argv[])
     gboolean             capture_option_specified = FALSE;
     volatile int         max_packet_count = 0;
 #endif
+    gboolean             taps_requested = FALSE;
     volatile int         out_file_type = WTAP_FILE_TYPE_SUBTYPE_UNKNOWN;
     volatile gboolean    out_file_name_res = FALSE;
     volatile int         in_file_type = WTAP_TYPE_AUTO;
@@ -1207,6 +1351,10 @@ main(int argc, char *argv[])
      */
     wtap_init(TRUE);
 
+    /* We look up only the fields named in filters, columns and the like,
+       so don't check every field and enter its name up front. */
+    proto_set_lazy_field_registration(TRUE);
+
     /* Register all dissectors; we must do this before checking for the
        "-G" flag, as the "-G" flag dumps information registered by the
        dissectors, and we must do it before we read the preferences, in
@@ -1756,6 +1904,7 @@ main(int argc, char *argv[])
                     exit_status = WS_EXIT_INVALID_OPTION;
                     goto clean_exit;
                 }
+                taps_requested = TRUE;
                 break;
             case 'd':        /* Decode as rule */
             case 'K':        /* Kerberos keytab file */
@@ -1785,6 +1934,7 @@ main(int argc, char *argv[])
                     exit_status = WS_EXIT_INVALID_OPTION;
                     goto clean_exit;
                 }
+                taps_requested = TRUE;
                 break;
             case LONGOPT_EXPORT_TLS_SESSION_KEYS:   /* --export-tls-session-keys */
                 tls_session_keys_file = ws_optarg;
@@ -1838,6 +1988,46 @@ main(int argc, char *argv[])
             case LONGOPT_PRINT_TIMERS:
                 opt_print_timers = TRUE;
                 break;
+#ifndef _WIN32
+            case LONGOPT_SHARDS:
+                shard_count = get_positive_int(ws_optarg, "shard count");
+                if (shard_count > FLOW_SHARD_MAX_SHARDS) {
+                    cmdarg_err("The shard count must be at most %d.", FLOW_SHARD_MAX_SHARDS);
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+            case LONGOPT_SHARD_KEY:
+                if (strcmp(ws_optarg, "5-tuple") == 0) {
+                    shard_key = FLOW_SHARD_KEY_5TUPLE;
+                } else if (strcmp(ws_optarg, "hosts") == 0) {
+                    shard_key = FLOW_SHARD_KEY_HOSTS;
+                } else {
+                    cmdarg_err("\"%s\" isn't a valid shard key; it must be \"5-tuple\" or \"hosts\".", ws_optarg);
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
+#else
+            case LONGOPT_SHARDS:
+            case LONGOPT_SHARD_KEY:
+                cmdarg_err("Dissecting in shards isn't supported on Windows.");
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+#endif
+#if defined(HAVE_LIBPCAP) && !defined(_WIN32)
+            case LONGOPT_SHM_BUFFER:
+                shm_buffer_kb = get_positive_int(ws_optarg, "shared memory size");
+                break;
+#else
+            case LONGOPT_SHM_BUFFER:
+                cmdarg_err("Getting packets from dumpcap in shared memory isn't supported in this build.");
+                exit_status = WS_EXIT_INVALID_OPTION;
+                goto clean_exit;
+#endif
+            case LONGOPT_FORMAT_THREADS:
+                format_thread_count = get_positive_int(ws_optarg, "formatter thread count");
+                break;
             default:
             case '?':        /* Bad flag - print usage message */
                 switch(ws_optopt) {
@@ -2003,6 +2193,60 @@ main(int argc, char *argv[])
         goto clean_exit;
     }
 
+    if (shard_count > 1) {
+        ws_statb64 cf_stat;
+        const char *conflict = NULL;
+
+        /* Every worker reads the file from the start. */
+        if (cf_name == NULL || ws_stat64(cf_name, &cf_stat) != 0 || !S_ISREG(cf_stat.st_mode)) {
+            cmdarg_err("--shards requires a capture file to be read with -r.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (perform_two_pass_analysis)
+            conflict = "-2";
+        else if (epan_auto_reset)
+            conflict = "-M";
+        else if (output_file_name)
+            conflict = "-w";
+        else if (taps_requested || tls_session_keys_file)
+            conflict = "statistics or exports";
+        if (conflict) {
+            cmdarg_err("--shards can't be used with %s.", conflict);
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+
+    if (format_thread_count > 0) {
+        const char *conflict = NULL;
+
+        if (!print_details || print_summary || output_fields_num_fields(output_fields) != 0 ||
+                !((output_action == WRITE_TEXT && print_format == PR_FMT_TEXT) ||
+                  output_action == WRITE_XML || output_action == WRITE_JSON ||
+                  output_action == WRITE_JSON_RAW)) {
+            cmdarg_err("--format-threads only applies to packet details printed with -V, -T pdml, -T json or -T jsonraw.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (cf_name == NULL) {
+            cmdarg_err("--format-threads requires a capture file to be read with -r.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (perform_two_pass_analysis)
+            conflict = "-2";
+        else if (epan_auto_reset)
+            conflict = "-M";
+        else if (shard_count > 1)
+            conflict = "--shards";
+        if (conflict) {
+            cmdarg_err("--format-threads can't be used with %s.", conflict);
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+    }
+
 #ifdef HAVE_LIBPCAP
     if (caps_queries) {
         /* We're supposed to list the link-layer/timestamp types for an interface;
@@ -2136,6 +2380,15 @@ main(int argc, char *argv[])
                         exit_status = WS_EXIT_INVALID_OPTION;
                         goto clean_exit;
                     }
+                    /* The ring doesn't mark where dumpcap switched files,
+                       so packets of the next file would be dissected as
+                       part of the previous one. */
+                    if (shm_buffer_kb != 0) {
+                        cmdarg_err("Multiple capture files requested, but "
+                                "packets are to be handed over in shared memory.");
+                        exit_status = WS_EXIT_INVALID_OPTION;
+                        goto clean_exit;
+                    }
                 }
                 /* Currently, we don't support read or display filters when capturing
                    and saving the packets. */
@@ -2422,6 +2675,8 @@ main(int argc, char *argv[])
            starting the statistics taps. */
         do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
         ws_debug("tshark: do_dissection = %s", do_dissection ? "TRUE" : "FALSE");
+        if (do_dissection)
+            limit_dissection(rfcode, dfcode, pdu_export_arg);
 
         /* Process the packets in the file */
         ws_debug("tshark: invoking process_cap_file() to process the packets");
@@ -2594,6 +2849,8 @@ main(int argc, char *argv[])
            starting the statistics taps. */
         do_dissection = must_do_dissection(rfcode, dfcode, pdu_export_arg);
         ws_debug("tshark: do_dissection = %s", do_dissection ? "TRUE" : "FALSE");
+        if (do_dissection)
+            limit_dissection(rfcode, dfcode, pdu_export_arg);
 
         /* We're doing live capture; if the capture child is writing to a pipe,
            we can't do dissection, because that would mean two readers for
@@ -2829,11 +3086,30 @@ capture(void)
     fflush(stderr);
     g_string_free(str, TRUE);
 
+    /*
+     * If we're dissecting, and were asked to, have dumpcap hand us the
+     * packets in shared memory, so that we don't have to read them back
+     * from the file it writes.
+     */
+    if (shm_buffer_kb != 0 && do_dissection) {
+        char *err_str;
+
+        global_capture_session.shm = capture_shm_create((gsize)shm_buffer_kb * 1024, &err_str);
+        if (global_capture_session.shm == NULL) {
+            cmdarg_err("%s", err_str);
+            g_free(err_str);
+            return FALSE;
+        }
+    }
+
     ret = sync_pipe_start(&global_capture_opts, capture_comments,
             &global_capture_session, &global_info_data, NULL);
 
-    if (!ret)
+    if (!ret) {
+        capture_shm_free(global_capture_session.shm);
+        global_capture_session.shm = NULL;
         return FALSE;
+    }
 
     /*
      * Force synchronous resolution of IP addresses; we're doing only
@@ -2864,6 +3140,16 @@ capture(void)
         abort();
     }
     ENDTRY;
+
+    if (global_capture_session.shm != NULL) {
+        ws_info("Dissected %" G_GUINT64_FORMAT " packets from shared memory", shm_packet_count);
+    }
+    capture_shm_free(global_capture_session.shm);
+    global_capture_session.shm = NULL;
+    if (shm_if_info != NULL) {
+        g_array_free(shm_if_info, TRUE);
+        shm_if_info = NULL;
+    }
     return ret;
 }
 
@@ -2914,6 +3200,91 @@ capture_input_cfilter_error(capture_session *cap_session, guint i, const char *e
 }
 
 
+/*
+ * Work out whether we can get the packets of the capture file we just
+ * opened from shared memory rather than from the file. dumpcap has to be
+ * putting them there, and each interface has to have a link-layer type
+ * for which a record can be made from the packet alone, without the
+ * pseudo-header wiretap would have read from the file.
+ */
+static gboolean
+capture_shm_usable(capture_session *cap_session, capture_file *cf)
+{
+    wtapng_iface_descriptions_t *idb_inf;
+    wtapng_if_descr_mandatory_t *if_descr;
+    shm_if_info_t if_info;
+    gboolean usable;
+    guint i;
+
+    if (!capture_shm_producing(cap_session->shm))
+        return FALSE;
+
+    if (shm_if_info == NULL)
+        shm_if_info = g_array_new(FALSE, FALSE, sizeof(shm_if_info_t));
+    g_array_set_size(shm_if_info, 0);
+
+    idb_inf = wtap_file_get_idb_info(cf->provider.wth);
+    usable = idb_inf->interface_data->len != 0;
+    for (i = 0; usable && i < idb_inf->interface_data->len; i++) {
+        if_descr = (wtapng_if_descr_mandatory_t *)wtap_block_get_mandatory_data(
+                g_array_index(idb_inf->interface_data, wtap_block_t, i));
+        if (wtap_encap_requires_phdr(if_descr->wtap_encap) ||
+            if_descr->wtap_encap == WTAP_ENCAP_USB_LINUX_MMAPPED) {
+            usable = FALSE;
+            break;
+        }
+        if_info.encap = if_descr->wtap_encap;
+        if_info.tsprecision = if_descr->tsprecision;
+        g_array_append_val(shm_if_info, if_info);
+    }
+    g_free(idb_inf);
+
+    shm_file_is_pcapng =
+        wtap_file_type_subtype(cf->provider.wth) == wtap_pcapng_file_type_subtype();
+    return usable;
+}
+
+/* Make a record, as wiretap would have, for a packet from shared memory. */
+static gboolean
+capture_shm_fill_rec(wtap_rec *rec, const capture_shm_packet_t *pkt)
+{
+    const shm_if_info_t *if_info;
+
+    if (pkt->interface_id >= shm_if_info->len)
+        return FALSE;
+    if_info = &g_array_index(shm_if_info, shm_if_info_t, pkt->interface_id);
+
+    rec->rec_type = REC_TYPE_PACKET;
+    rec->block = wtap_block_create(WTAP_BLOCK_PACKET);
+    rec->presence_flags = WTAP_HAS_TS|WTAP_HAS_CAP_LEN;
+    rec->ts.secs = (time_t)pkt->ts_sec;
+    rec->ts.nsecs = (int)pkt->ts_nsec;
+    rec->tsprec = if_info->tsprecision;
+    rec->rec_header.packet_header.caplen = pkt->caplen;
+    rec->rec_header.packet_header.len = pkt->len;
+    rec->rec_header.packet_header.pkt_encap = if_info->encap;
+    if (shm_file_is_pcapng) {
+        rec->presence_flags |= WTAP_HAS_INTERFACE_ID;
+        rec->rec_header.packet_header.interface_id = pkt->interface_id;
+    } else {
+        rec->rec_header.packet_header.interface_id = 0;
+    }
+    memset(&rec->rec_header.packet_header.pseudo_header, 0,
+           sizeof(rec->rec_header.packet_header.pseudo_header));
+    switch (if_info->encap) {
+
+    case WTAP_ENCAP_ETHERNET:
+        /* dumpcap doesn't say whether there's an FCS. */
+        rec->rec_header.packet_header.pseudo_header.eth.fcs_len = -1;
+        break;
+
+    case WTAP_ENCAP_NETANALYZER:
+        rec->rec_header.packet_header.pseudo_header.eth.fcs_len = 4;
+        break;
+    }
+    return TRUE;
+}
+
 /* capture child tells us we have a new (or the first) capture file */
 static bool
 capture_input_new_file(capture_session *cap_session, gchar *new_file)
@@ -2968,6 +3339,14 @@ capture_input_new_file(capture_session *cap_session, gchar *new_file)
                 capture_opts->save_file = NULL;
                 return FALSE;
         }
+
+        if (cap_session->shm != NULL) {
+            capture_from_shm = capture_shm_usable(cap_session, cf);
+            if (!capture_from_shm) {
+                ws_info("Reading the packets of %s from the file, not from shared memory", new_file);
+                capture_shm_stop_reading(cap_session->shm);
+            }
+        }
     } else if (quiet && is_tempfile) {
         cf->state = FILE_READ_ABORTED;
         cf->filename = g_strdup(new_file);
@@ -3047,6 +3426,30 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
         wtap_rec_init(&rec);
         ws_buffer_init(&buf, 1514);
 
+        if (capture_from_shm) {
+            capture_shm_packet_t pkt;
+            const guint8 *pd;
+
+            /*
+             * dumpcap put the packets it's told us about, and maybe a
+             * few more, into shared memory; dissect them all there,
+             * and then give the room back.
+             */
+            while ((pd = capture_shm_peek(cap_session->shm, &pkt)) != NULL) {
+                if (capture_shm_fill_rec(&rec, &pkt)) {
+                    shm_packet_count++;
+                    reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+                    if (process_packet_single_pass(cf, edt, (gint64)pkt.file_offset,
+                                                   &rec, pd, tap_flags)) {
+                        packet_count++;
+                    }
+                    wtap_rec_reset(&rec);
+                }
+                capture_shm_release(cap_session->shm);
+            }
+            to_read = 0;
+        }
+
         while (to_read-- && cf->provider.wth) {
             wtap_cleareof(cf->provider.wth);
             ret = wtap_read(cf->provider.wth, &rec, &buf, &err, &err_info, &data_offset);
@@ -3057,8 +3460,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
                 wtap_close(cf->provider.wth);
                 cf->provider.wth = NULL;
             } else {
-                ret = process_packet_single_pass(cf, edt, data_offset, &rec, &buf,
-                        tap_flags);
+                ret = process_packet_single_pass(cf, edt, data_offset, &rec,
+                        ws_buffer_start_ptr(&buf), tap_flags);
             }
             if (ret != FALSE) {
                 /* packet successfully read and gone through the "Read Filter" */
@@ -3161,8 +3564,14 @@ capture_input_drops(capture_session *cap_session _U_, guint32 dropped, const cha
  * do the required cleanup.
  */
 static void
-capture_input_closed(capture_session *cap_session _U_, gchar *msg)
+capture_input_closed(capture_session *cap_session, gchar *msg)
 {
+    /* Dissect whatever's left in shared memory. */
+    if (capture_from_shm) {
+        capture_input_new_packets(cap_session, 0);
+        capture_from_shm = FALSE;
+    }
+
     if (msg != NULL && *msg != '\0')
         fprintf(stderr, "tshark: %s\n", msg);
 
@@ -3259,6 +3668,9 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
            hfids postdissectors want on the first pass. */
         prime_epan_dissect_with_postdissector_wanted_hfids(edt);
 
+        if (cf->field_index)
+            field_index_prime_edt(cf->field_index, edt);
+
         frame_data_set_before_dissect(&fdlocal, &cf->elapsed_time,
                 &cf->provider.ref, cf->provider.prev_dis);
         if (cf->provider.ref == &fdlocal) {
@@ -3286,6 +3698,9 @@ process_packet_first_pass(capture_file *cf, epan_dissect_t *edt,
     }
 
     if (passed) {
+        if (edt && cf->field_index)
+            field_index_add_frame(cf->field_index, framenum, edt->tree);
+
         frame_data_set_after_dissect(&fdlocal, &cum_bytes);
         cf->provider.prev_cap = cf->provider.prev_dis = frame_data_sequence_add(cf->provider.frames, &fdlocal);
 
@@ -3372,7 +3787,8 @@ typedef enum {
     PASS_SUCCEEDED,
     PASS_READ_ERROR,
     PASS_WRITE_ERROR,
-    PASS_INTERRUPTED
+    PASS_INTERRUPTED,
+    PASS_SHARD_ERROR    /* A shard worker failed and reported why */
 } pass_status_t;
 
 static pass_status_t
@@ -3395,6 +3811,12 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
     if (do_dissection) {
         gboolean create_proto_tree;
 
+        /* The field index lets the second pass skip dissecting frames
+           the display filter rejects. */
+        if (cf->dfcode != NULL) {
+            cf->field_index = field_index_new_from_prefs();
+        }
+
         /*
          * Determine whether we need to create a protocol tree.
          * We do if:
@@ -3404,10 +3826,13 @@ process_cap_file_first_pass(capture_file *cf, int max_packet_count,
          *    we're going to apply a display filter;
          *
          *    a postdissector wants field values or protocols
-         *    on the first pass.
+         *    on the first pass;
+         *
+         *    we're building a field index.
          */
         create_proto_tree =
-            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() || dissect_color);
+            (cf->rfcode != NULL || cf->dfcode != NULL || postdissectors_want_hfids() || dissect_color ||
+             cf->field_index != NULL);
 
         ws_debug("tshark: create_proto_tree = %s", create_proto_tree ? "TRUE" : "FALSE");
 
@@ -3601,6 +4026,8 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     guint           tap_flags;
     epan_dissect_t *edt = NULL;
     pass_status_t   status = PASS_SUCCEEDED;
+    gboolean        use_field_index = FALSE;
+    bool            index_passed;
 
     /*
      * Process whatever IDBs we haven't seen yet.  This will be all
@@ -3648,6 +4075,15 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
            ("print_packet_info" is true) and we're in verbose mode
            ("packet_details" is true). */
         edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+
+        /*
+         * If no tap listener needs to see every frame and the display
+         * filter only reads indexed fields, frames the filter rejects
+         * don't have to be dissected again.
+         */
+        use_field_index = (cf->dfcode != NULL && !tap_listeners_require_dissection() &&
+                field_index_can_filter(cf->field_index, cf->dfcode));
+        ws_debug("tshark: use_field_index = %s", use_field_index ? "TRUE" : "FALSE");
     }
 
     /*
@@ -3662,6 +4098,20 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
             break;
         }
         fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+        if (use_field_index && !fdata->dependent_of_displayed &&
+                field_index_filter_frame(cf->field_index, cf->dfcode, framenum, &index_passed) &&
+                !index_passed) {
+            /* The frame won't be printed or written; just keep the
+               time references up to date. */
+            frame_data_set_before_dissect(fdata, &cf->elapsed_time,
+                    &cf->provider.ref, cf->provider.prev_dis);
+            if (cf->provider.ref == fdata) {
+                ref_frame = *fdata;
+                cf->provider.ref = &ref_frame;
+            }
+            cf->provider.prev_cap = fdata;
+            continue;
+        }
         if (!wtap_seek_read(cf->provider.wth, fdata->file_off, &rec, &buf, err,
                     err_info)) {
             /* Error reading from the input file. */
@@ -3703,6 +4153,346 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     return status;
 }
 
+/*
+ * A frame that another shard dissects. It counts, and it's the previous
+ * captured frame of the next one; without a display filter every frame
+ * is displayed, so it's also the previous displayed frame.
+ */
+static void
+process_packet_other_shard(capture_file *cf, gint64 offset, wtap_rec *rec)
+{
+    frame_data fdata;
+
+    cf->count++;
+    frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
+
+    frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+            &cf->provider.ref, cf->provider.prev_dis);
+    if (cf->provider.ref == &fdata) {
+        ref_frame = fdata;
+        cf->provider.ref = &ref_frame;
+    }
+
+    if (cf->dfcode == NULL) {
+        frame_data_set_after_dissect(&fdata, &cum_bytes);
+        prev_dis_frame = fdata;
+        cf->provider.prev_dis = &prev_dis_frame;
+    }
+
+    prev_cap_frame = fdata;
+    cf->provider.prev_cap = &prev_cap_frame;
+
+    frame_data_destroy(&fdata);
+}
+
+#ifndef _WIN32
+/* Sent by a worker ahead of the output of each frame it printed. */
+typedef struct {
+    guint32 framenum;
+    guint32 len;
+} shard_record_t;
+
+static gboolean
+shard_write(int fd, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    ssize_t n;
+
+    while (len > 0) {
+        n = ws_write(fd, p, (unsigned int)len);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        p += n;
+        len -= n;
+    }
+    return TRUE;
+}
+
+/* Returns the number of bytes read, which is less than len only at the
+   end of the data or on an error. */
+static size_t
+shard_read(int fd, void *data, size_t len)
+{
+    char *p = (char *)data;
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < len) {
+        n = ws_read(fd, p + done, (unsigned int)(len - done));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += n;
+    }
+    return done;
+}
+
+/*
+ * In a worker the standard output is a scratch file holding the output
+ * of one frame; send that to the coordinator and start over.
+ */
+static gboolean
+shard_send_output(guint32 framenum)
+{
+    static char buf[65536];
+    shard_record_t record;
+    long len;
+    ssize_t n;
+
+    if (fflush(stdout) != 0 || (len = ftell(stdout)) < 0)
+        return FALSE;
+    record.framenum = framenum;
+    record.len = (guint32)len;
+    if (!shard_write(shard_pipe, &record, sizeof(record)))
+        return FALSE;
+
+    if (ws_lseek64(1, 0, SEEK_SET) < 0)
+        return FALSE;
+    while (len > 0) {
+        n = ws_read(1, buf, (unsigned int)MIN((size_t)len, sizeof(buf)));
+        if (n <= 0)
+            return FALSE;
+        if (!shard_write(shard_pipe, buf, n))
+            return FALSE;
+        len -= (long)n;
+    }
+    return fseek(stdout, 0, SEEK_SET) == 0;
+}
+#endif /* _WIN32 */
+
+/* Put the dumper in the state it's in after the first packet, without
+   writing anything, so that every packet starts with a separator. */
+static void
+json_dumper_skip_first_element(json_dumper *dumper)
+{
+    FILE *output_file = dumper->output_file;
+
+    dumper->output_file = NULL;
+    json_dumper_begin_object(dumper);
+    json_dumper_end_object(dumper);
+    dumper->output_file = output_file;
+}
+
+/*
+ * Formatting packets in the formatter threads.
+ *
+ * The slots are used in turn, as a ring; format_head is the oldest one
+ * in flight. Only the dissection thread claims, submits, writes and
+ * resets slots; the formatter threads just print them and mark them as
+ * formatted.
+ */
+static void
+format_packet(gpointer data, gpointer user_data)
+{
+    format_slot_t *slot = (format_slot_t *)data;
+    capture_file *cf = (capture_file *)user_data;
+    gboolean success;
+
+    success = print_packet_to(cf, slot->edt, slot->stream, slot->out, &slot->dumper);
+    if (fflush(slot->out) != 0)
+        success = FALSE;
+
+    g_mutex_lock(&format_mutex);
+    slot->success = success;
+    slot->state = FORMAT_SLOT_FORMATTED;
+    g_cond_broadcast(&format_cond);
+    g_mutex_unlock(&format_mutex);
+}
+
+static void
+format_slot_reset(format_slot_t *slot)
+{
+    epan_dissect_reset(slot->edt);
+    frame_data_destroy(&slot->fdata);
+    slot->state = FORMAT_SLOT_FREE;
+}
+
+/* Copy the output of the oldest slot to the standard output, and free
+   the slot. */
+static void
+format_slot_write_oldest(void)
+{
+    static char buf[65536];
+    format_slot_t *slot = &format_slots[format_head];
+    long len;
+    size_t n;
+
+    if (!slot->success || (len = ftell(slot->out)) < 0 ||
+            fseek(slot->out, 0, SEEK_SET) != 0) {
+        show_print_file_io_error();
+        exit(2);
+    }
+    while (len > 0) {
+        n = fread(buf, 1, MIN((size_t)len, sizeof(buf)), slot->out);
+        if (n == 0) {
+            show_print_file_io_error();
+            exit(2);
+        }
+        fwrite(buf, 1, n, stdout);
+        len -= (long)n;
+    }
+    /* The next packet overwrites this one's output; what's left of it
+       past the end of that is never read. */
+    fseek(slot->out, 0, SEEK_SET);
+
+    if (line_buffered)
+        fflush(stdout);
+    if (ferror(stdout)) {
+        show_print_file_io_error();
+        exit(2);
+    }
+
+    format_slot_reset(slot);
+    format_head = (format_head + 1) % format_slot_count;
+    format_in_flight--;
+}
+
+/*
+ * Write out the slots that have been formatted, oldest first, stopping
+ * at the first one that hasn't; if wait is TRUE, wait for all of them.
+ */
+static void
+format_slots_write(gboolean wait)
+{
+    format_slot_t *slot;
+
+    while (format_in_flight > 0) {
+        slot = &format_slots[format_head];
+        g_mutex_lock(&format_mutex);
+        if (wait) {
+            while (slot->state != FORMAT_SLOT_FORMATTED)
+                g_cond_wait(&format_cond, &format_mutex);
+        } else if (slot->state != FORMAT_SLOT_FORMATTED) {
+            g_mutex_unlock(&format_mutex);
+            return;
+        }
+        g_mutex_unlock(&format_mutex);
+        format_slot_write_oldest();
+    }
+}
+
+/* Get a slot to dissect the next packet into, waiting for the oldest
+   packet to be formatted and written out if they're all in flight. */
+static format_slot_t *
+format_slot_claim(void)
+{
+    format_slot_t *slot;
+
+    if (format_in_flight == format_slot_count) {
+        slot = &format_slots[format_head];
+        g_mutex_lock(&format_mutex);
+        while (slot->state != FORMAT_SLOT_FORMATTED)
+            g_cond_wait(&format_cond, &format_mutex);
+        g_mutex_unlock(&format_mutex);
+        format_slot_write_oldest();
+    }
+    return &format_slots[(format_head + format_in_flight) % format_slot_count];
+}
+
+/* Hand a dissected packet to the formatter threads. */
+static void
+format_slot_submit(format_slot_t *slot)
+{
+    /* The formatters mustn't look up names or call into dissectors, so
+       the labels that would need to are filled in now. */
+    proto_tree_fill_shared_labels(slot->edt->tree);
+
+    if (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW) {
+        slot->dumper = jdumper;
+        slot->dumper.output_file = slot->out;
+        /* Every packet after this one starts with a separator. */
+        json_dumper_skip_first_element(&jdumper);
+    }
+
+    slot->state = FORMAT_SLOT_FORMATTING;
+    format_in_flight++;
+    g_thread_pool_push(format_pool, slot, NULL);
+}
+
+static void
+format_pipeline_free(void)
+{
+    format_slot_t *slot;
+
+    if (format_pool != NULL) {
+        g_thread_pool_free(format_pool, FALSE, TRUE);
+        format_pool = NULL;
+    }
+    for (guint i = 0; i < format_slot_count; i++) {
+        slot = &format_slots[i];
+        if (slot->edt != NULL)
+            epan_dissect_free(slot->edt);
+        ws_buffer_free(&slot->buf);
+        /* Destroying the stream closes its file. */
+        if (slot->stream != NULL)
+            destroy_print_stream(slot->stream);
+        else if (slot->out != NULL)
+            fclose(slot->out);
+    }
+    g_free(format_slots);
+    format_slots = NULL;
+    format_slot_count = 0;
+}
+
+/*
+ * Start formatting packets in format_thread_count threads. Returns FALSE
+ * if they weren't started; the packets are then formatted as they're
+ * dissected.
+ */
+static gboolean
+format_pipeline_start(capture_file *cf)
+{
+    format_slot_t *slot;
+    GError *gerror = NULL;
+
+    /* Text going to a terminal is converted to its character set, and it
+       isn't produced faster than it's read anyway. */
+    if (output_action == WRITE_TEXT && ws_isatty(ws_fileno(stdout)))
+        return FALSE;
+
+    format_slot_count = format_thread_count * FORMAT_SLOTS_PER_THREAD;
+    format_slots = g_new0(format_slot_t, format_slot_count);
+    format_head = 0;
+    format_in_flight = 0;
+    for (guint i = 0; i < format_slot_count; i++) {
+        slot = &format_slots[i];
+        ws_buffer_init(&slot->buf, 1514);
+        slot->edt = epan_dissect_new(cf->epan, TRUE, TRUE);
+        slot->out = tmpfile();
+        if (slot->out == NULL) {
+            cmdarg_err("Couldn't create a scratch file for formatting packets: %s.",
+                    g_strerror(errno));
+            format_pipeline_free();
+            return FALSE;
+        }
+        if (output_action == WRITE_TEXT)
+            slot->stream = print_stream_text_stdio_new(slot->out);
+    }
+
+    format_pool = g_thread_pool_new(format_packet, cf, format_thread_count, TRUE, &gerror);
+    if (format_pool == NULL) {
+        cmdarg_err("Couldn't start the formatter threads: %s.", gerror->message);
+        g_error_free(gerror);
+        format_pipeline_free();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* Write out the packets still in flight, and stop the formatter threads. */
+static void
+format_pipeline_stop(void)
+{
+    if (format_pool == NULL)
+        return;
+    format_slots_write(TRUE);
+    format_pipeline_free();
+}
+
 static pass_status_t
 process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         int max_packet_count, gint64 max_byte_count,
@@ -3763,6 +4553,9 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
            ("print_packet_info" is true) and we're in verbose mode
            ("packet_details" is true). */
         edt = epan_dissect_new(cf->epan, create_proto_tree, print_packet_info && print_details);
+
+        if (format_thread_count > 0 && print_packet_info && !format_pipeline_start(cf))
+            ws_debug("tshark: formatting packets as they're dissected");
     }
 
     /*
@@ -3791,22 +4584,28 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
         ws_debug("tshark: processing packet #%d", framenum);
 
-        reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
+        if (shard_index != NULL &&
+                flow_shard_index_get(shard_index, framenum) != shard_id) {
+            /* Another worker dissects this one. */
+            process_packet_other_shard(cf, data_offset, &rec);
+        } else {
+            reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
 
-        if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
-            /* Either there's no read filtering or this packet passed the
-               filter, so, if we're writing to a capture file, write
-               this packet out. */
-            write_framenum++;
-            if (pdh != NULL) {
-                ws_debug("tshark: writing packet #%d to outfile as #%d",
-                        framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
-                    /* Error writing to the output file. */
-                    ws_debug("tshark: error writing to a capture file (%d)", *err);
-                    *err_framenum = framenum;
-                    status = PASS_WRITE_ERROR;
-                    break;
+            if (process_packet_single_pass(cf, edt, data_offset, &rec, ws_buffer_start_ptr(&buf), tap_flags)) {
+                /* Either there's no read filtering or this packet passed the
+                   filter, so, if we're writing to a capture file, write
+                   this packet out. */
+                write_framenum++;
+                if (pdh != NULL) {
+                    ws_debug("tshark: writing packet #%d to outfile as #%d",
+                            framenum, write_framenum);
+                    if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+                        /* Error writing to the output file. */
+                        ws_debug("tshark: error writing to a capture file (%d)", *err);
+                        *err_framenum = framenum;
+                        status = PASS_WRITE_ERROR;
+                        break;
+                    }
                 }
             }
         }
@@ -3827,6 +4626,14 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             *err = 0; /* This is not an error */
             break;
         }
+        if (shard_index != NULL &&
+                (guint32)framenum >= flow_shard_index_frame_count(shard_index)) {
+            /* That's every frame the coordinator indexed; it reports
+               anything that went wrong reading further. */
+            ws_debug("tshark: last indexed frame (%d) reached", framenum);
+            *err = 0;
+            break;
+        }
         wtap_rec_reset(&rec);
     }
     if (status == PASS_SUCCEEDED) {
@@ -3844,6 +4651,8 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         }
     }
 
+    format_pipeline_stop();
+
     if (edt)
         epan_dissect_free(edt);
 
@@ -3853,6 +4662,301 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     return status;
 }
 
+#ifndef _WIN32
+/*
+ * A worker: dissect the frames of one shard and send their output to
+ * the coordinator. Doesn't return.
+ */
+static void
+shard_worker(capture_file *cf, guint shard, int out_fd,
+        int max_packet_count, gint64 max_byte_count)
+{
+    FILE        *scratch;
+    int          err = 0;
+    gchar       *err_info = NULL;
+    volatile guint32 err_framenum;
+    pass_status_t status;
+
+    shard_id = shard;
+    shard_pipe = out_fd;
+
+    /* If the coordinator stops reading, writing to it should fail with
+       EPIPE rather than kill us. */
+    signal(SIGPIPE, SIG_IGN);
+
+    /* Collect the output of each frame in a scratch file. */
+    scratch = tmpfile();
+    if (scratch == NULL || dup2(fileno(scratch), 1) < 0) {
+        cmdarg_err("Shard %u couldn't create a scratch file: %s.", shard + 1, g_strerror(errno));
+        _exit(2);
+    }
+    fclose(scratch);
+
+    /* The workers can't share the coordinator's file offset. */
+    wtap_close(cf->provider.wth);
+    cf->provider.wth = wtap_open_offline(cf->filename, cf->open_type, &err, &err_info, FALSE);
+    if (cf->provider.wth == NULL) {
+        cfile_open_failure_message(cf->filename, err, err_info);
+        _exit(2);
+    }
+    wtap_set_cb_new_ipv4(cf->provider.wth, add_ipv4_name);
+    wtap_set_cb_new_ipv6(cf->provider.wth, (wtap_new_ipv6_callback_t) add_ipv6_name);
+    wtap_set_cb_new_secrets(cf->provider.wth, secrets_wtap_callback);
+
+    /* The coordinator writes the preamble and the finale; this just
+       gets the output state ready for the packets. */
+    if (!write_preamble(cf)) {
+        show_print_file_io_error();
+        _exit(2);
+    }
+    if (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW)
+        json_dumper_skip_first_element(&jdumper);
+    fflush(stdout);
+    fseek(stdout, 0, SEEK_SET);
+
+    status = process_cap_file_single_pass(cf, NULL, max_packet_count,
+            max_byte_count, 0, &err, &err_info, &err_framenum);
+    if (status == PASS_READ_ERROR)
+        cfile_read_failure_message(cf->filename, err, err_info);
+    fflush(stderr);
+    _exit(status == PASS_SUCCEEDED ? 0 : 2);
+}
+
+/*
+ * Copy the output of one frame from a worker to the standard output.
+ */
+static gboolean
+shard_copy_output(int fd, guint32 len, gboolean drop_separator)
+{
+    static char buf[65536];
+    size_t chunk, n;
+
+    while (len > 0) {
+        chunk = MIN(len, sizeof(buf));
+        n = shard_read(fd, buf, chunk);
+        if (n != chunk)
+            return FALSE;
+        len -= (guint32)n;
+        if (drop_separator && n > 0 && buf[0] == ',') {
+            fwrite(buf + 1, 1, n - 1, stdout);
+            drop_separator = FALSE;
+        } else {
+            fwrite(buf, 1, n, stdout);
+        }
+    }
+    return TRUE;
+}
+
+static void
+report_shard_split_flows(void)
+{
+    flow_shard_stats_t stats;
+    gchar **pairs;
+    guint max_pairs = 5;
+
+    flow_shard_index_get_stats(shard_index, &stats);
+    for (guint i = 0; i < shard_count; i++)
+        ws_debug("tshark: shard %u has %u frames", i + 1, stats.shard_frames[i]);
+
+    if (really_quiet)
+        return;
+
+    if (stats.split_host_pairs > 0) {
+        fprintf(stderr, "tshark: %u of %u host pairs have flows in more than one shard.\n",
+                stats.split_host_pairs, stats.host_pairs);
+        fprintf(stderr, "Protocols that relate flows to each other, such as FTP data connections\n"
+                "or SIP media streams, may not be dissected completely between:\n");
+        pairs = flow_shard_index_split_host_pairs(shard_index, max_pairs);
+        for (guint i = 0; pairs[i] != NULL; i++)
+            fprintf(stderr, "    %s\n", pairs[i]);
+        g_strfreev(pairs);
+        if (stats.split_host_pairs > max_pairs)
+            fprintf(stderr, "    and %u more\n", stats.split_host_pairs - max_pairs);
+        fprintf(stderr, "Use --shard-key hosts to keep the flows between two hosts together.\n");
+    }
+    if (stats.fragment_fallbacks > 0) {
+        fprintf(stderr, "tshark: %u IP fragments were sharded by host pair, as the first "
+                "fragment of their datagram wasn't found.\n", stats.fragment_fallbacks);
+    }
+}
+
+/*
+ * Dissect the file in shard_count worker processes. The coordinator
+ * reads the file once to index the flow of every frame, then forks the
+ * workers. Each of them reads the file again, dissecting the frames of
+ * its own shard and only counting the others, and sends the output of
+ * each frame back. The coordinator writes that out in frame order.
+ *
+ * The workers don't share any state, so anything numbered in the order
+ * it's seen, such as tcp.stream, is numbered per shard.
+ */
+static pass_status_t
+process_cap_file_sharded(capture_file *cf,
+        int max_packet_count, gint64 max_byte_count,
+        int max_write_packet_count,
+        int *err, gchar **err_info)
+{
+    wtap_rec        rec;
+    Buffer          buf;
+    gint64          data_offset;
+    int             framenum = 0;
+    guint32         frame_count, written = 0;
+    pid_t          *pids;
+    int            *pipes;
+    shard_record_t *records;
+    gboolean       *have_record, *done;
+    gboolean        drop_separator, finished = TRUE;
+    guint           shard, forked;
+    int             fds[2], wstatus;
+    pass_status_t   status = PASS_SUCCEEDED;
+
+    /* Index the flows. */
+    shard_index = flow_shard_index_new(shard_count, shard_key);
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    *err = 0;
+    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+        if (read_interrupted) {
+            status = PASS_INTERRUPTED;
+            break;
+        }
+        framenum++;
+        flow_shard_index_add(shard_index, &rec, ws_buffer_start_ptr(&buf));
+        wtap_rec_reset(&rec);
+
+        /* Stop where the workers will */
+        if (max_packet_count > 0 && framenum >= max_packet_count) {
+            *err = 0;
+            break;
+        }
+        if (max_byte_count != 0 && data_offset >= max_byte_count) {
+            *err = 0;
+            break;
+        }
+    }
+    ws_buffer_free(&buf);
+    wtap_rec_cleanup(&rec);
+    flow_shard_index_finish(shard_index);
+
+    /* After a read error, the frames before it are still dissected and
+       the error is reported at the end. */
+    frame_count = flow_shard_index_frame_count(shard_index);
+    if (status == PASS_INTERRUPTED || frame_count == 0)
+        goto out;
+
+    pids = g_new0(pid_t, shard_count);
+    pipes = g_new0(int, shard_count);
+    records = g_new0(shard_record_t, shard_count);
+    have_record = g_new0(gboolean, shard_count);
+    done = g_new0(gboolean, shard_count);
+
+    /* Don't let the workers inherit anything that's still buffered. */
+    fflush(stdout);
+    fflush(stderr);
+    for (forked = 0; forked < shard_count; forked++) {
+        if (pipe(fds) < 0) {
+            cmdarg_err("Couldn't create a pipe for shard %u: %s.", forked + 1, g_strerror(errno));
+            break;
+        }
+        pids[forked] = fork();
+        if (pids[forked] < 0) {
+            cmdarg_err("Couldn't start the worker for shard %u: %s.", forked + 1, g_strerror(errno));
+            ws_close(fds[0]);
+            ws_close(fds[1]);
+            break;
+        }
+        if (pids[forked] == 0) {
+            for (shard = 0; shard < forked; shard++)
+                ws_close(pipes[shard]);
+            ws_close(fds[0]);
+            shard_worker(cf, forked, fds[1], max_packet_count, max_byte_count);
+        }
+        ws_close(fds[1]);
+        pipes[forked] = fds[0];
+    }
+    if (forked < shard_count) {
+        status = PASS_SHARD_ERROR;
+        for (shard = 0; shard < forked; shard++)
+            kill(pids[shard], SIGTERM);
+    }
+
+    /* Merge. A worker sends its frames in order, so the next record
+       from the shard of a frame is either that frame's output or a
+       later one's, when the frame didn't pass the display filter. */
+    drop_separator = output_action == WRITE_JSON || output_action == WRITE_JSON_RAW;
+    for (guint32 num = 1; status == PASS_SUCCEEDED && num <= frame_count; num++) {
+        shard = flow_shard_index_get(shard_index, num);
+        if (done[shard])
+            continue;
+        if (!have_record[shard]) {
+            if (shard_read(pipes[shard], &records[shard], sizeof(shard_record_t)) != sizeof(shard_record_t)) {
+                /* The worker finished, or failed; its exit status says
+                   which. */
+                done[shard] = TRUE;
+                continue;
+            }
+            have_record[shard] = TRUE;
+        }
+        if (records[shard].framenum != num)
+            continue;
+        have_record[shard] = FALSE;
+
+        if (!shard_copy_output(pipes[shard], records[shard].len, drop_separator)) {
+            done[shard] = TRUE;
+            continue;
+        }
+        if (drop_separator) {
+            /* The first packet is out; the finale must close the array
+               after it. */
+            json_dumper_skip_first_element(&jdumper);
+            drop_separator = FALSE;
+        }
+        if (line_buffered)
+            fflush(stdout);
+        if (ferror(stdout)) {
+            show_print_file_io_error();
+            status = PASS_SHARD_ERROR;
+            break;
+        }
+        if (max_write_packet_count > 0 && ++written >= (guint32)max_write_packet_count) {
+            ws_debug("tshark: max_write_packet_count (%d) reached", max_write_packet_count);
+            finished = FALSE;
+            break;
+        }
+    }
+
+    /* Workers that still have output to send get EPIPE (they ignore
+       SIGPIPE) and stop. */
+    for (shard = 0; shard < forked; shard++)
+        ws_close(pipes[shard]);
+    for (shard = 0; shard < forked; shard++) {
+        while (waitpid(pids[shard], &wstatus, 0) < 0 && errno == EINTR)
+            ;
+        if (status == PASS_SUCCEEDED && finished && !read_interrupted &&
+                !(WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0))
+            status = PASS_SHARD_ERROR;
+    }
+    if (status == PASS_SUCCEEDED && read_interrupted)
+        status = PASS_INTERRUPTED;
+
+    g_free(pids);
+    g_free(pipes);
+    g_free(records);
+    g_free(have_record);
+    g_free(done);
+
+    report_shard_split_flows();
+
+out:
+    cf->count = frame_count;
+    if (status == PASS_SUCCEEDED && *err != 0)
+        status = PASS_READ_ERROR;
+    flow_shard_index_free(shard_index);
+    shard_index = NULL;
+    return status;
+}
+#endif /* _WIN32 */
+
 static process_file_status_t
 process_cap_file(capture_file *cf, char *save_file, int out_file_type,
         gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count,
@@ -3984,6 +5088,15 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
         first_pass_status = PASS_SUCCEEDED; /* There is no first pass */
 
         elapsed_start = g_get_monotonic_time();
+#ifndef _WIN32
+        if (shard_count > 1)
+            second_pass_status = process_cap_file_sharded(cf,
+                    max_packet_count,
+                    max_byte_count,
+                    max_write_packet_count,
+                    &err, &err_info);
+        else
+#endif
         second_pass_status = process_cap_file_single_pass(cf, pdh,
                 max_packet_count,
                 max_byte_count,
@@ -4042,6 +5155,7 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
                 break;
 
             case PASS_WRITE_ERROR:
+            case PASS_SHARD_ERROR:
                 /* Won't happen on the first pass. */
                 break;
 
@@ -4078,6 +5192,11 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
                 /* Not an error, so nothing to report. */
                 status = PROCESS_FILE_INTERRUPTED;
                 break;
+
+            case PASS_SHARD_ERROR:
+                /* The worker reported the error. */
+                status = PROCESS_FILE_ERROR;
+                break;
         }
     }
     if (save_file != NULL) {
@@ -4140,9 +5259,12 @@ out:
 
 static gboolean
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
-        wtap_rec *rec, Buffer *buf, guint tap_flags _U_)
+        wtap_rec *rec, const guint8 *pd, guint tap_flags _U_)
 {
-    frame_data      fdata;
+    frame_data      fdata_buf;
+    frame_data     *fdata = &fdata_buf;
+    format_slot_t  *slot = NULL;
+    wtap_rec       *dissect_rec = rec;
     column_info    *cinfo;
     gboolean        passed;
     wtap_block_t    block = NULL;
@@ -4156,7 +5278,18 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
        that all packets can be marked as 'passed'. */
     passed = TRUE;
 
-    frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
+    if (edt && format_pool != NULL) {
+        /* Dissect it in a slot of its own, where it stays until it's
+           been formatted, with a copy of its data. The record is only
+           copied shallowly; the formatters don't look at it. */
+        slot = format_slot_claim();
+        edt = slot->edt;
+        fdata = &slot->fdata;
+        slot->rec = *rec;
+        dissect_rec = &slot->rec;
+    }
+
+    frame_data_init(fdata, cf->count, rec, offset, cum_bytes);
 
     /* If we're going to print packet information, or we're going to
        run a read filter, or we're going to process taps, set up to
@@ -4187,25 +5320,31 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         else
             cinfo = NULL;
 
-        frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+        frame_data_set_before_dissect(fdata, &cf->elapsed_time,
                 &cf->provider.ref, cf->provider.prev_dis);
-        if (cf->provider.ref == &fdata) {
-            ref_frame = fdata;
+        if (cf->provider.ref == fdata) {
+            ref_frame = *fdata;
             cf->provider.ref = &ref_frame;
         }
 
         if (dissect_color) {
             color_filters_prime_edt(edt);
-            fdata.need_colorize = 1;
+            fdata->need_colorize = 1;
+        }
+
+        if (slot != NULL) {
+            ws_buffer_clean(&slot->buf);
+            ws_buffer_append(&slot->buf, pd, fdata->cap_len);
+            pd = ws_buffer_start_ptr(&slot->buf);
         }
 
         /* epan_dissect_run (and epan_dissect_reset) unref the block.
          * We need it later, e.g. in order to copy the options. */
         block = wtap_block_ref(rec->block);
         elapsed_start = g_get_monotonic_time();
-        epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-                frame_tvbuff_new_buffer(&cf->provider, &fdata, buf),
-                &fdata, cinfo);
+        epan_dissect_run_with_taps(edt, cf->cd_t, dissect_rec,
+                frame_tvbuff_new(slot ? &format_tvb_provider : &cf->provider, fdata, pd),
+                fdata, cinfo);
         tshark_elapsed.first_pass.dissect += g_get_monotonic_time() - elapsed_start;
 
         /* Run the filter if we have it. */
@@ -4217,15 +5356,29 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
     }
 
     if (passed) {
-        frame_data_set_after_dissect(&fdata, &cum_bytes);
+        frame_data_set_after_dissect(fdata, &cum_bytes);
 
         /* Process this packet. */
-        if (print_packet_info) {
+        if (slot != NULL) {
+            /* A formatter thread prints it, and it's written out after
+               the packets before it. */
+            format_slot_submit(slot);
+            format_slots_write(FALSE);
+        } else if (print_packet_info) {
             /* We're printing packet information; print the information for
                this packet. */
             ws_assert(edt);
             print_packet(cf, edt);
 
+#ifndef _WIN32
+            /* A worker hands the output over to the coordinator, which
+               writes it out in order. */
+            if (shard_pipe != -1 && !shard_send_output(fdata->num)) {
+                show_print_file_io_error();
+                _exit(2);
+            }
+#endif
+
             /* If we're doing "line-buffering", flush the standard output
                after every packet.  See the comment above, for the "-l"
                option, for an explanation of why we do that. */
@@ -4239,16 +5392,20 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         }
 
         /* this must be set after print_packet() [bug #8160] */
-        prev_dis_frame = fdata;
+        prev_dis_frame = *fdata;
         cf->provider.prev_dis = &prev_dis_frame;
     }
 
-    prev_cap_frame = fdata;
+    prev_cap_frame = *fdata;
     cf->provider.prev_cap = &prev_cap_frame;
 
     if (edt) {
-        epan_dissect_reset(edt);
-        frame_data_destroy(&fdata);
+        /* A slot that's been handed to the formatters is reset once its
+           output has been written. */
+        if (slot == NULL || !passed) {
+            epan_dissect_reset(edt);
+            frame_data_destroy(fdata);
+        }
         rec->block = block;
     }
     return passed;
@@ -4579,8 +5736,13 @@ print_columns(capture_file *cf, const epan_dissect_t *edt)
         return print_line(print_stream, 0, line_bufp);
 }
 
+/*
+ * Print a packet to the given stream, file and JSON dumper, which are
+ * the standard output's except in the formatter threads.
+ */
 static gboolean
-print_packet(capture_file *cf, epan_dissect_t *edt)
+print_packet_to(capture_file *cf, epan_dissect_t *edt, print_stream_t *stream,
+        FILE *fh, json_dumper *dumper)
 {
     if (print_summary || output_fields_has_cols(output_fields))
         /* Just fill in the columns. */
@@ -4594,10 +5756,10 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
                 return FALSE;
             if (print_details) {
                 if (!proto_tree_print(print_details ? print_dissections_expanded : print_dissections_none,
-                            print_hex, edt, output_only_tables, print_stream))
+                            print_hex, edt, output_only_tables, stream))
                     return FALSE;
                 if (!print_hex) {
-                    if (!print_line(print_stream, 0, separator))
+                    if (!print_line(stream, 0, separator))
                         return FALSE;
                 }
             }
@@ -4605,13 +5767,13 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
 
         case WRITE_XML:
             if (print_summary) {
-                write_psml_columns(edt, stdout, dissect_color);
-                return !ferror(stdout);
+                write_psml_columns(edt, fh, dissect_color);
+                return !ferror(fh);
             }
             if (print_details) {
-                write_pdml_proto_tree(output_fields, edt, &cf->cinfo, stdout, dissect_color);
-                printf("\n");
-                return !ferror(stdout);
+                write_pdml_proto_tree(output_fields, edt, &cf->cinfo, fh, dissect_color);
+                fputs("\n", fh);
+                return !ferror(fh);
             }
             break;
 
@@ -4621,9 +5783,9 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
                 ws_assert_not_reached();
             }
             if (print_details) {
-                write_fields_proto_tree(output_fields, edt, &cf->cinfo, stdout);
-                printf("\n");
-                return !ferror(stdout);
+                write_fields_proto_tree(output_fields, edt, &cf->cinfo, fh);
+                fputs("\n", fh);
+                return !ferror(fh);
             }
             break;
 
@@ -4632,8 +5794,8 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
                 ws_assert_not_reached();
             if (print_details) {
                 write_json_proto_tree(output_fields, print_dissections_expanded,
-                        print_hex, edt, &cf->cinfo, node_children_grouper, &jdumper);
-                return !ferror(stdout);
+                        print_hex, edt, &cf->cinfo, node_children_grouper, dumper);
+                return !ferror(fh);
             }
             break;
 
@@ -4642,15 +5804,15 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
                 ws_assert_not_reached();
             if (print_details) {
                 write_json_proto_tree(output_fields, print_dissections_none,
-                        TRUE, edt, &cf->cinfo, node_children_grouper, &jdumper);
-                return !ferror(stdout);
+                        TRUE, edt, &cf->cinfo, node_children_grouper, dumper);
+                return !ferror(fh);
             }
             break;
 
         case WRITE_EK:
             write_ek_proto_tree(output_fields, print_summary, print_hex,
-                    edt, &cf->cinfo, stdout);
-            return !ferror(stdout);
+                    edt, &cf->cinfo, fh);
+            return !ferror(fh);
 
         default:
             ws_assert_not_reached();
@@ -4658,17 +5820,23 @@ print_packet(capture_file *cf, epan_dissect_t *edt)
 
     if (print_hex) {
         if (print_summary || print_details) {
-            if (!print_line(print_stream, 0, ""))
+            if (!print_line(stream, 0, ""))
                 return FALSE;
         }
-        if (!print_hex_data(print_stream, edt, hexdump_source_option | hexdump_ascii_option))
+        if (!print_hex_data(stream, edt, hexdump_source_option | hexdump_ascii_option))
             return FALSE;
-        if (!print_line(print_stream, 0, separator))
+        if (!print_line(stream, 0, separator))
             return FALSE;
     }
     return TRUE;
 }
 
+static gboolean
+print_packet(capture_file *cf, epan_dissect_t *edt)
+{
+    return print_packet_to(cf, edt, print_stream, stdout, &jdumper);
+}
+
 static gboolean
 write_finale(void)
 {
@@ -4721,6 +5889,9 @@ cf_close(capture_file *cf)
         cf->filename = NULL;
     }
 
+    field_index_free(cf->field_index);
+    cf->field_index = NULL;
+
     /* We have no file open. */
     cf->state = FILE_CLOSED;
 }
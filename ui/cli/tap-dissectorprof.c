@@ -0,0 +1,134 @@
+/* tap-dissectorprof.c
+ * Per-dissector time and allocation profile
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_dissectorprof(void);
+
+static tap_packet_status
+dissectorprof_packet(void *dp _U_, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *dummy _U_, tap_flags_t flags _U_)
+{
+	/* The profile is kept by call_dissector_through_handle(). */
+	return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+dissectorprof_collect(const dissector_prof_stats_t *stats, gpointer user_data)
+{
+	g_ptr_array_add((GPtrArray *)user_data, (gpointer)stats);
+}
+
+static gint
+dissectorprof_compare_excl(gconstpointer a, gconstpointer b)
+{
+	const dissector_prof_stats_t *stats_a = *(const dissector_prof_stats_t * const *)a;
+	const dissector_prof_stats_t *stats_b = *(const dissector_prof_stats_t * const *)b;
+
+	if (stats_a->excl_ticks != stats_b->excl_ticks)
+		return stats_a->excl_ticks < stats_b->excl_ticks ? 1 : -1;
+	return g_strcmp0(stats_a->name, stats_b->name);
+}
+
+static void
+dissectorprof_draw(void *dp _U_)
+{
+	GPtrArray *profiles = g_ptr_array_new();
+	double ticks_per_us = dissector_prof_ticks_per_ns() * 1000.0;
+	guint64 total_ticks = 0;
+	guint i;
+
+	dissector_prof_foreach(dissectorprof_collect, profiles);
+	g_ptr_array_sort(profiles, dissectorprof_compare_excl);
+	for (i = 0; i < profiles->len; i++)
+		total_ticks += ((const dissector_prof_stats_t *)g_ptr_array_index(profiles, i))->excl_ticks;
+
+	printf("\n");
+	printf("=====================================================================================================\n");
+	printf("Dissector Profile:\n");
+	printf("  %-30s %12s %14s %14s %7s %12s %12s\n",
+	       "Dissector", "Calls", "Incl time(us)", "Excl time(us)", "Excl %", "Incl bytes", "Excl bytes");
+	printf("  Heuristic dissectors are marked with *\n");
+	for (i = 0; i < profiles->len; i++) {
+		const dissector_prof_stats_t *stats = (const dissector_prof_stats_t *)g_ptr_array_index(profiles, i);
+
+		printf("  %-29s%s %12" PRIu64 " %14.1f %14.1f %6.2f%% %12" PRIu64 " %12" PRIu64 "\n",
+		       stats->name, stats->heuristic ? "*" : " ", stats->calls,
+		       (double)stats->incl_ticks / ticks_per_us,
+		       (double)stats->excl_ticks / ticks_per_us,
+		       total_ticks ? 100.0 * (double)stats->excl_ticks / (double)total_ticks : 0.0,
+		       stats->incl_bytes, stats->excl_bytes);
+	}
+	printf("=====================================================================================================\n");
+
+	g_ptr_array_free(profiles, TRUE);
+}
+
+static void
+dissectorprof_finish(void *dp _U_)
+{
+	dissector_prof_disable();
+}
+
+static void
+dissectorprof_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString *error_string;
+
+	error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, dissectorprof_packet, dissectorprof_draw, dissectorprof_finish);
+	if (error_string) {
+		cmdarg_err("Couldn't register dissector,prof tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+
+	dissector_prof_reset();
+	dissector_prof_enable();
+}
+
+static stat_tap_ui dissectorprof_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"dissector,prof",
+	dissectorprof_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_dissectorprof(void)
+{
+	register_stat_tap_ui(&dissectorprof_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,108 @@
+/* tap-heurstat.c
+ * Heuristic dissector statistics
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_heurstat(void);
+
+static tap_packet_status
+heurstat_packet(void *phs _U_, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *dummy _U_, tap_flags_t flags _U_)
+{
+	/* The counters are kept by dissector_try_heuristic(). */
+	return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+heurstat_print_entry(const gchar *table_name _U_, heur_dtbl_entry_t *hdtbl_entry, gpointer user_data _U_)
+{
+	const heur_dtbl_stats_t *stats = &hdtbl_entry->stats;
+
+	if (stats->calls == 0 && stats->skipped == 0)
+		return;
+
+	printf("  %-30s %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %7.2f%%\n",
+	       hdtbl_entry->short_name, stats->calls, stats->accepted, stats->skipped,
+	       stats->calls ? 100.0 * (double)stats->accepted / (double)stats->calls : 0.0);
+}
+
+static void
+heurstat_print_table(const char *table_name, struct heur_dissector_list *table _U_, gpointer user_data _U_)
+{
+	printf("%s:\n", table_name);
+	heur_dissector_table_foreach(table_name, heurstat_print_entry, NULL);
+}
+
+static void
+heurstat_draw(void *phs _U_)
+{
+	printf("\n");
+	printf("===================================================================\n");
+	printf("Heuristic Dissector Statistics:\n");
+	printf("  %-30s %12s %12s %12s %8s\n", "Heuristic", "Calls", "Accepted", "Skipped", "Hit rate");
+	printf("  Skipped: payloads ruled out by the heuristic's signature\n");
+	dissector_all_heur_tables_foreach_table(heurstat_print_table, NULL, (GCompareFunc)g_strcmp0);
+	printf("===================================================================\n");
+}
+
+static void
+heurstat_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString *error_string;
+
+	heur_dissector_reset_stats();
+
+	error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, heurstat_packet, heurstat_draw, NULL);
+	if (error_string) {
+		cmdarg_err("Couldn't register heur,stat tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui heurstat_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"heur,stat",
+	heurstat_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_heurstat(void)
+{
+	register_stat_tap_ui(&heurstat_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
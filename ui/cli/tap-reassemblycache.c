@@ -0,0 +1,98 @@
+/* tap-reassemblycache.c
+ * Memory used by reassembled payloads
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include <epan/packet.h>
+#include <epan/reassemble.h>
+#include <epan/tap.h>
+#include <epan/stat_tap_ui.h>
+
+#include <wsutil/cmdarg_err.h>
+
+void register_tap_listener_reassemblycache(void);
+
+static tap_packet_status
+reassemblycache_packet(void *rc _U_, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *dummy _U_, tap_flags_t flags _U_)
+{
+	/* The statistics are kept by the reassembly code. */
+	return TAP_PACKET_DONT_REDRAW;
+}
+
+static void
+reassemblycache_draw(void *rc _U_)
+{
+	reassembly_cache_stats_t stats;
+
+	reassembly_cache_get_stats(&stats);
+
+	printf("\n");
+	printf("=====================================================================================================\n");
+	printf("Reassembly Cache:\n");
+	if (stats.budget)
+		printf("  Budget:                   %12" PRIu64 " bytes\n", stats.budget);
+	else
+		printf("  Budget:                   %12s\n", "unlimited");
+	printf("  Payloads in memory:       %12u\n", stats.resident_count);
+	printf("  Bytes in memory:          %12" PRIu64 "\n", stats.resident_bytes);
+	printf("  Peak bytes in memory:     %12" PRIu64 "\n", stats.peak_resident_bytes);
+	printf("  Payloads evicted:         %12u\n", stats.evicted_count);
+	printf("  Evictions:                %12" PRIu64 "\n", stats.evictions);
+	printf("  Reads from temporary file:%12" PRIu64 "\n", stats.restores);
+	printf("  Temporary file size:      %12" PRIu64 " bytes\n", stats.spill_bytes);
+	printf("=====================================================================================================\n");
+}
+
+static void
+reassemblycache_init(const char *opt_arg _U_, void *userdata _U_)
+{
+	GString *error_string;
+
+	error_string = register_tap_listener("frame", NULL, NULL, 0, NULL, reassemblycache_packet, reassemblycache_draw, NULL);
+	if (error_string) {
+		cmdarg_err("Couldn't register reassembly,cache tap: %s",
+			error_string->str);
+		g_string_free(error_string, TRUE);
+		exit(1);
+	}
+}
+
+static stat_tap_ui reassemblycache_ui = {
+	REGISTER_STAT_GROUP_GENERIC,
+	NULL,
+	"reassembly,cache",
+	reassemblycache_init,
+	0,
+	NULL
+};
+
+void
+register_tap_listener_reassemblycache(void)
+{
+	register_stat_tap_ui(&reassemblycache_ui, NULL);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 8
+ * tab-width: 8
+ * indent-tabs-mode: t
+ * End:
+ *
+ * vi: set shiftwidth=8 tabstop=8 noexpandtab:
+ * :indentSize=8:tabSize=8:noTabs=false:
+ */
@@ -0,0 +1,597 @@
+/* flow_shard.c
+ * Assign the frames of a capture file to shards by flow
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * The index is built by reading the headers of every frame, without
+ * dissecting anything, so that each of several processes dissecting the
+ * same file can tell which frames are its own. Frames of the same flow
+ * must go to the same shard for reassembly and decryption to work, so
+ * the shard is a hash of the flow key with the endpoints in a fixed
+ * order.
+ *
+ * Only the fragment of an IP datagram that starts at offset 0 has the
+ * transport header. The other fragments are looked up by source,
+ * destination, protocol and identification; fragments that turn up
+ * before the first one wait for flow_shard_index_finish(), and those
+ * whose first fragment never turns up are sharded by host pair.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <epan/etypes.h>
+#include <epan/ipproto.h>
+
+#include <wsutil/inet_addr.h>
+#include <wsutil/pint.h>
+#include <wsutil/wslog.h>
+
+#include "ui/flow_shard.h"
+
+typedef struct {
+    guint8 addr_len;
+    guint8 src[16];
+    guint8 dst[16];
+} host_pair_t;
+
+typedef struct {
+    host_pair_t hosts;      /* In the direction of the datagram */
+    guint8 proto;
+    guint32 id;
+} frag_key_t;
+
+typedef struct {
+    guint32 framenum;
+    frag_key_t key;
+} pending_frag_t;
+
+typedef struct {
+    host_pair_t hosts;
+    guint8 proto;
+    gboolean has_ports;
+    guint16 src_port;
+    guint16 dst_port;
+    gboolean fragment;      /* Part of a fragmented datagram */
+    gboolean first_fragment;
+    guint8 frag_proto;      /* What the fragments carry */
+    guint32 frag_id;
+} flow_t;
+
+struct flow_shard_index {
+    guint num_shards;
+    flow_shard_key_e key;
+    GByteArray *shards;     /* The shard of each frame */
+    GHashTable *host_pairs; /* host_pair_t -> guint64 mask of shards */
+    GHashTable *frags;      /* frag_key_t -> shard + 1 */
+    GArray *pending;        /* pending_frag_t */
+    guint32 non_ip_frames;
+    guint32 fragment_fallbacks;
+};
+
+#define FNV_OFFSET  G_GUINT64_CONSTANT(0xcbf29ce484222325)
+#define FNV_PRIME   G_GUINT64_CONSTANT(0x100000001b3)
+
+static guint64
+fnv_hash(guint64 hash, const guint8 *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/* The keys are zeroed before they're filled in, so padding hashes and
+ * compares the same. */
+static guint
+host_pair_hash(gconstpointer key)
+{
+    return (guint)fnv_hash(FNV_OFFSET, key, sizeof(host_pair_t));
+}
+
+static gboolean
+host_pair_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, sizeof(host_pair_t)) == 0;
+}
+
+static guint
+frag_key_hash(gconstpointer key)
+{
+    return (guint)fnv_hash(FNV_OFFSET, key, sizeof(frag_key_t));
+}
+
+static gboolean
+frag_key_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, sizeof(frag_key_t)) == 0;
+}
+
+flow_shard_index_t *
+flow_shard_index_new(guint num_shards, flow_shard_key_e key)
+{
+    flow_shard_index_t *index = g_new0(flow_shard_index_t, 1);
+
+    ws_assert(num_shards >= 1 && num_shards <= FLOW_SHARD_MAX_SHARDS);
+    index->num_shards = num_shards;
+    index->key = key;
+    index->shards = g_byte_array_new();
+    index->host_pairs = g_hash_table_new_full(host_pair_hash, host_pair_equal, g_free, g_free);
+    index->frags = g_hash_table_new_full(frag_key_hash, frag_key_equal, g_free, NULL);
+    index->pending = g_array_new(FALSE, FALSE, sizeof(pending_frag_t));
+    return index;
+}
+
+static gboolean
+parse_ipv4(const guint8 *pd, guint32 len, flow_t *flow)
+{
+    guint32 hdr_len;
+    guint16 frag;
+
+    if (len < 20)
+        return FALSE;
+    hdr_len = (pd[0] & 0x0f) * 4;
+    if (hdr_len < 20 || len < hdr_len)
+        return FALSE;
+
+    flow->hosts.addr_len = 4;
+    memcpy(flow->hosts.src, pd + 12, 4);
+    memcpy(flow->hosts.dst, pd + 16, 4);
+    flow->proto = pd[9];
+
+    frag = pntoh16(pd + 6);
+    if (frag & 0x3fff) {
+        /* More fragments, or an offset */
+        flow->fragment = TRUE;
+        flow->first_fragment = (frag & 0x1fff) == 0;
+        flow->frag_proto = flow->proto;
+        flow->frag_id = pntoh16(pd + 4);
+        if (!flow->first_fragment)
+            return TRUE;
+    }
+
+    pd += hdr_len;
+    len -= hdr_len;
+    switch (flow->proto) {
+    case IP_PROTO_TCP:
+    case IP_PROTO_UDP:
+    case IP_PROTO_DCCP:
+    case IP_PROTO_SCTP:
+    case IP_PROTO_UDPLITE:
+        if (len >= 4) {
+            flow->has_ports = TRUE;
+            flow->src_port = pntoh16(pd);
+            flow->dst_port = pntoh16(pd + 2);
+        }
+        break;
+    }
+    return TRUE;
+}
+
+static gboolean
+parse_ipv6(const guint8 *pd, guint32 len, flow_t *flow)
+{
+    guint32 ext_len;
+    guint16 frag;
+
+    if (len < 40)
+        return FALSE;
+
+    flow->hosts.addr_len = 16;
+    memcpy(flow->hosts.src, pd + 8, 16);
+    memcpy(flow->hosts.dst, pd + 24, 16);
+    flow->proto = pd[6];
+    pd += 40;
+    len -= 40;
+
+    /* Walk the extension headers to the transport header. */
+    for (;;) {
+        switch (flow->proto) {
+        case IP_PROTO_HOPOPTS:
+        case IP_PROTO_ROUTING:
+        case IP_PROTO_DSTOPTS:
+            if (len < 8)
+                return TRUE;
+            ext_len = (pd[1] + 1) * 8;
+            break;
+        case IP_PROTO_AH:
+            if (len < 8)
+                return TRUE;
+            ext_len = (pd[1] + 2) * 4;
+            break;
+        case IP_PROTO_FRAGMENT:
+            if (len < 8)
+                return TRUE;
+            frag = pntoh16(pd + 2);
+            flow->fragment = TRUE;
+            flow->first_fragment = (frag & 0xfff8) == 0;
+            flow->frag_proto = pd[0];
+            flow->frag_id = pntoh32(pd + 4);
+            if (!flow->first_fragment) {
+                flow->proto = pd[0];
+                return TRUE;
+            }
+            ext_len = 8;
+            break;
+        case IP_PROTO_TCP:
+        case IP_PROTO_UDP:
+        case IP_PROTO_DCCP:
+        case IP_PROTO_SCTP:
+        case IP_PROTO_UDPLITE:
+            if (len >= 4) {
+                flow->has_ports = TRUE;
+                flow->src_port = pntoh16(pd);
+                flow->dst_port = pntoh16(pd + 2);
+            }
+            return TRUE;
+        default:
+            return TRUE;
+        }
+        if (len < ext_len)
+            return TRUE;
+        flow->proto = pd[0];
+        pd += ext_len;
+        len -= ext_len;
+    }
+}
+
+static gboolean
+parse_packet(int encap, const guint8 *pd, guint32 len, flow_t *flow)
+{
+    guint32 offset;
+    guint16 ethertype;
+
+    memset(flow, 0, sizeof(*flow));
+
+    switch (encap) {
+    case WTAP_ENCAP_ETHERNET:
+        offset = 12;
+        if (len < offset + 2)
+            return FALSE;
+        ethertype = pntoh16(pd + offset);
+        while (ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_IEEE_802_1AD ||
+               ethertype == ETHERTYPE_QINQ_OLD) {
+            offset += 4;
+            if (len < offset + 2)
+                return FALSE;
+            ethertype = pntoh16(pd + offset);
+        }
+        offset += 2;
+        break;
+    case WTAP_ENCAP_SLL:
+        if (len < 16)
+            return FALSE;
+        ethertype = pntoh16(pd + 14);
+        offset = 16;
+        break;
+    case WTAP_ENCAP_SLL2:
+        if (len < 20)
+            return FALSE;
+        ethertype = pntoh16(pd);
+        offset = 20;
+        break;
+    case WTAP_ENCAP_NULL:
+    case WTAP_ENCAP_LOOP:
+        /* The address family of NULL is in the byte order of the host
+         * that captured it, and is numbered differently by different
+         * OSes; the IP version is enough. */
+        ethertype = 0;
+        offset = 4;
+        break;
+    case WTAP_ENCAP_RAW_IP:
+    case WTAP_ENCAP_RAW_IP4:
+    case WTAP_ENCAP_RAW_IP6:
+        ethertype = 0;
+        offset = 0;
+        break;
+    default:
+        return FALSE;
+    }
+
+    if (len <= offset)
+        return FALSE;
+    if (ethertype == 0) {
+        switch (pd[offset] >> 4) {
+        case 4:
+            ethertype = ETHERTYPE_IP;
+            break;
+        case 6:
+            ethertype = ETHERTYPE_IPv6;
+            break;
+        default:
+            return FALSE;
+        }
+    }
+
+    switch (ethertype) {
+    case ETHERTYPE_IP:
+        return parse_ipv4(pd + offset, len - offset, flow);
+    case ETHERTYPE_IPv6:
+        return parse_ipv6(pd + offset, len - offset, flow);
+    default:
+        return FALSE;
+    }
+}
+
+/* Put the endpoints in a fixed order, so both directions match. */
+static void
+host_pair_canonical(const host_pair_t *hosts, host_pair_t *canon)
+{
+    memset(canon, 0, sizeof(*canon));
+    canon->addr_len = hosts->addr_len;
+    if (memcmp(hosts->src, hosts->dst, hosts->addr_len) <= 0) {
+        memcpy(canon->src, hosts->src, hosts->addr_len);
+        memcpy(canon->dst, hosts->dst, hosts->addr_len);
+    } else {
+        memcpy(canon->src, hosts->dst, hosts->addr_len);
+        memcpy(canon->dst, hosts->src, hosts->addr_len);
+    }
+}
+
+static guint
+shard_of_hash(const flow_shard_index_t *index, guint64 hash)
+{
+    return (guint)((hash ^ (hash >> 32)) % index->num_shards);
+}
+
+static guint
+host_pair_shard(const flow_shard_index_t *index, const host_pair_t *hosts)
+{
+    host_pair_t canon;
+    guint64 hash;
+
+    host_pair_canonical(hosts, &canon);
+    hash = fnv_hash(FNV_OFFSET, canon.src, canon.addr_len);
+    hash = fnv_hash(hash, canon.dst, canon.addr_len);
+    return shard_of_hash(index, hash);
+}
+
+static guint
+flow_shard(const flow_shard_index_t *index, const flow_t *flow)
+{
+    const guint8 *a = flow->hosts.src, *b = flow->hosts.dst;
+    guint16 port_a = flow->src_port, port_b = flow->dst_port;
+    guint8 ports[5];
+    guint64 hash;
+    int cmp;
+
+    if (index->key == FLOW_SHARD_KEY_HOSTS || !flow->has_ports)
+        return host_pair_shard(index, &flow->hosts);
+
+    cmp = memcmp(a, b, flow->hosts.addr_len);
+    if (cmp > 0 || (cmp == 0 && port_a > port_b)) {
+        a = flow->hosts.dst;
+        b = flow->hosts.src;
+        port_a = flow->dst_port;
+        port_b = flow->src_port;
+    }
+    ports[0] = flow->proto;
+    ports[1] = port_a >> 8;
+    ports[2] = port_a & 0xff;
+    ports[3] = port_b >> 8;
+    ports[4] = port_b & 0xff;
+
+    hash = fnv_hash(FNV_OFFSET, a, flow->hosts.addr_len);
+    hash = fnv_hash(hash, b, flow->hosts.addr_len);
+    hash = fnv_hash(hash, ports, sizeof(ports));
+    return shard_of_hash(index, hash);
+}
+
+static void
+note_host_pair(flow_shard_index_t *index, const host_pair_t *hosts, guint shard)
+{
+    host_pair_t canon;
+    guint64 *mask;
+
+    host_pair_canonical(hosts, &canon);
+    mask = (guint64 *)g_hash_table_lookup(index->host_pairs, &canon);
+    if (mask == NULL) {
+        mask = g_new0(guint64, 1);
+        g_hash_table_insert(index->host_pairs, g_memdup2(&canon, sizeof(canon)), mask);
+    }
+    *mask |= G_GUINT64_CONSTANT(1) << shard;
+}
+
+static void
+frag_key_init(frag_key_t *key, const flow_t *flow)
+{
+    memset(key, 0, sizeof(*key));
+    key->hosts = flow->hosts;
+    key->proto = flow->frag_proto;
+    key->id = flow->frag_id;
+}
+
+void
+flow_shard_index_add(flow_shard_index_t *index, const wtap_rec *rec,
+                     const guint8 *pd)
+{
+    flow_t flow;
+    frag_key_t key;
+    pending_frag_t pending;
+    gpointer found;
+    guint8 shard = 0;
+
+    if (rec->rec_type != REC_TYPE_PACKET ||
+        !parse_packet(rec->rec_header.packet_header.pkt_encap, pd,
+                      rec->rec_header.packet_header.caplen, &flow)) {
+        index->non_ip_frames++;
+        g_byte_array_append(index->shards, &shard, 1);
+        return;
+    }
+
+    if (flow.fragment && index->key == FLOW_SHARD_KEY_5TUPLE) {
+        frag_key_init(&key, &flow);
+        if (flow.first_fragment) {
+            shard = flow_shard(index, &flow);
+            g_hash_table_replace(index->frags, g_memdup2(&key, sizeof(key)),
+                                 GUINT_TO_POINTER(shard + 1));
+        } else if ((found = g_hash_table_lookup(index->frags, &key)) != NULL) {
+            shard = GPOINTER_TO_UINT(found) - 1;
+        } else {
+            /* Placed, and counted, when the index is finished. */
+            pending.framenum = index->shards->len + 1;
+            pending.key = key;
+            g_array_append_val(index->pending, pending);
+            g_byte_array_append(index->shards, &shard, 1);
+            return;
+        }
+    } else {
+        shard = flow_shard(index, &flow);
+    }
+
+    note_host_pair(index, &flow.hosts, shard);
+    g_byte_array_append(index->shards, &shard, 1);
+}
+
+void
+flow_shard_index_finish(flow_shard_index_t *index)
+{
+    pending_frag_t *pending;
+    gpointer found;
+    guint shard;
+
+    for (guint i = 0; i < index->pending->len; i++) {
+        pending = &g_array_index(index->pending, pending_frag_t, i);
+        found = g_hash_table_lookup(index->frags, &pending->key);
+        if (found != NULL) {
+            shard = GPOINTER_TO_UINT(found) - 1;
+        } else {
+            shard = host_pair_shard(index, &pending->key.hosts);
+            index->fragment_fallbacks++;
+        }
+        index->shards->data[pending->framenum - 1] = (guint8)shard;
+        note_host_pair(index, &pending->key.hosts, shard);
+    }
+    g_array_set_size(index->pending, 0);
+    g_hash_table_remove_all(index->frags);
+}
+
+guint32
+flow_shard_index_frame_count(const flow_shard_index_t *index)
+{
+    return index->shards->len;
+}
+
+guint
+flow_shard_index_get(const flow_shard_index_t *index, guint32 framenum)
+{
+    if (framenum == 0 || framenum > index->shards->len)
+        return 0;
+    return index->shards->data[framenum - 1];
+}
+
+static gboolean
+mask_is_split(guint64 mask)
+{
+    return (mask & (mask - 1)) != 0;
+}
+
+void
+flow_shard_index_get_stats(const flow_shard_index_t *index,
+                           flow_shard_stats_t *stats)
+{
+    GHashTableIter iter;
+    gpointer value;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->frames = index->shards->len;
+    stats->non_ip_frames = index->non_ip_frames;
+    stats->fragment_fallbacks = index->fragment_fallbacks;
+    stats->host_pairs = g_hash_table_size(index->host_pairs);
+    for (guint i = 0; i < index->shards->len; i++)
+        stats->shard_frames[index->shards->data[i]]++;
+
+    g_hash_table_iter_init(&iter, index->host_pairs);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        if (mask_is_split(*(guint64 *)value))
+            stats->split_host_pairs++;
+    }
+}
+
+static void
+format_addr(const host_pair_t *hosts, const guint8 *addr, char *buf, size_t size)
+{
+    if (hosts->addr_len == 4)
+        ws_inet_ntop4(addr, buf, size);
+    else
+        ws_inet_ntop6(addr, buf, size);
+}
+
+static gint
+compare_strings(gconstpointer a, gconstpointer b)
+{
+    return g_strcmp0(*(const char * const *)a, *(const char * const *)b);
+}
+
+gchar **
+flow_shard_index_split_host_pairs(const flow_shard_index_t *index, guint max)
+{
+    GPtrArray *descriptions = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer key, value;
+    char src[WS_INET6_ADDRSTRLEN], dst[WS_INET6_ADDRSTRLEN];
+    const host_pair_t *hosts;
+    guint64 mask;
+    GString *str;
+
+    g_hash_table_iter_init(&iter, index->host_pairs);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        hosts = (const host_pair_t *)key;
+        mask = *(guint64 *)value;
+        if (!mask_is_split(mask))
+            continue;
+        format_addr(hosts, hosts->src, src, sizeof(src));
+        format_addr(hosts, hosts->dst, dst, sizeof(dst));
+        str = g_string_new(NULL);
+        g_string_printf(str, "%s <-> %s (shards", src, dst);
+        for (guint shard = 0; shard < index->num_shards; shard++) {
+            if (mask & (G_GUINT64_CONSTANT(1) << shard))
+                g_string_append_printf(str, " %u", shard + 1);
+        }
+        g_string_append_c(str, ')');
+        g_ptr_array_add(descriptions, g_string_free(str, FALSE));
+    }
+
+    /* The same order every time */
+    g_ptr_array_sort(descriptions, compare_strings);
+    if (descriptions->len > max) {
+        for (guint i = max; i < descriptions->len; i++)
+            g_free(g_ptr_array_index(descriptions, i));
+        g_ptr_array_set_size(descriptions, max);
+    }
+    g_ptr_array_add(descriptions, NULL);
+    return (gchar **)g_ptr_array_free(descriptions, FALSE);
+}
+
+void
+flow_shard_index_free(flow_shard_index_t *index)
+{
+    if (index == NULL)
+        return;
+    g_byte_array_free(index->shards, TRUE);
+    g_hash_table_destroy(index->host_pairs);
+    g_hash_table_destroy(index->frags);
+    g_array_free(index->pending, TRUE);
+    g_free(index);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
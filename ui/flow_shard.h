@@ -0,0 +1,112 @@
+/** @file
+ *
+ * flow_shard.h
+ * Assign the frames of a capture file to shards by flow
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FLOW_SHARD_H__
+#define __FLOW_SHARD_H__
+
+#include <glib.h>
+
+#include <wiretap/wtap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** The largest number of shards an index can have. */
+#define FLOW_SHARD_MAX_SHARDS 64
+
+/** What frames must have in common to end up in the same shard. */
+typedef enum {
+    FLOW_SHARD_KEY_5TUPLE,  /**< Addresses, ports and IP protocol */
+    FLOW_SHARD_KEY_HOSTS    /**< Addresses only */
+} flow_shard_key_e;
+
+typedef struct flow_shard_index flow_shard_index_t;
+
+typedef struct {
+    guint32 frames;                 /**< Frames in the index */
+    guint32 non_ip_frames;          /**< Frames without IP, all in shard 0 */
+    guint32 fragment_fallbacks;     /**< IP fragments sharded by host pair */
+    guint32 host_pairs;             /**< Distinct pairs of IP addresses */
+    guint32 split_host_pairs;       /**< Host pairs seen in more than one shard */
+    guint32 shard_frames[FLOW_SHARD_MAX_SHARDS]; /**< Frames in each shard */
+} flow_shard_stats_t;
+
+/**
+ * Create an empty index.
+ *
+ * @param num_shards The number of shards, from 1 to FLOW_SHARD_MAX_SHARDS.
+ * @param key How frames are grouped.
+ */
+flow_shard_index_t *flow_shard_index_new(guint num_shards, flow_shard_key_e key);
+
+/**
+ * Add the next frame of the file to the index. Only the link, IP and
+ * transport headers are looked at; frames that aren't IPv4 or IPv6 over
+ * a link layer known here, and records that aren't packets, go to
+ * shard 0.
+ *
+ * Both directions of a flow go to the same shard. With
+ * FLOW_SHARD_KEY_5TUPLE, an IP fragment goes with the fragment that
+ * carries the transport header, or by host pair if there isn't one.
+ *
+ * @param index The index.
+ * @param rec The record.
+ * @param pd The record data.
+ */
+void flow_shard_index_add(flow_shard_index_t *index, const wtap_rec *rec,
+                          const guint8 *pd);
+
+/**
+ * Called after the last frame has been added, to place the fragments
+ * that were seen before the first fragment of their datagram.
+ */
+void flow_shard_index_finish(flow_shard_index_t *index);
+
+/** The number of frames in the index. */
+guint32 flow_shard_index_frame_count(const flow_shard_index_t *index);
+
+/**
+ * The shard of a frame.
+ *
+ * @param index The index.
+ * @param framenum The frame number, starting at 1.
+ * @return The shard, or 0 for frames that aren't in the index.
+ */
+guint flow_shard_index_get(const flow_shard_index_t *index, guint32 framenum);
+
+/** Fill in statistics for the frames in the index. */
+void flow_shard_index_get_stats(const flow_shard_index_t *index,
+                                flow_shard_stats_t *stats);
+
+/**
+ * Describe the host pairs whose flows are in more than one shard.
+ * Protocols that relate flows to each other, such as the data
+ * connections of FTP or the media streams of SIP, may be dissected
+ * incompletely for these.
+ *
+ * @param index The index.
+ * @param max The maximum number of host pairs to describe.
+ * @return A NULL-terminated array of strings, to be freed with
+ * g_strfreev().
+ */
+gchar **flow_shard_index_split_host_pairs(const flow_shard_index_t *index,
+                                          guint max);
+
+/** Free an index. */
+void flow_shard_index_free(flow_shard_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FLOW_SHARD_H__ */
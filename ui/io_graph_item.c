@@ -263,3 +263,269 @@ double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val
     }
     return value;
 }
+
+/* Enough levels to cover any base level that fits in an int */
+#define IOG_PYRAMID_MAX_LEVELS 10
+
+struct _io_graph_pyramid_t {
+    int hf_index;
+    io_graph_item_unit_t item_unit;
+    guint64 resolution_us;          /* Resolution of levels[0] */
+    guint64 max_resolution_us;
+    int max_buckets;
+    /* levels[k] has a resolution of resolution_us * IOG_PYRAMID_FACTOR^k */
+    GArray *levels[IOG_PYRAMID_MAX_LEVELS];
+    /* Buckets of levels[k] below valid[k] are up to date. levels[0] always is. */
+    guint valid[IOG_PYRAMID_MAX_LEVELS];
+};
+
+/* Merge src into dst. Buckets are merged in time order. */
+static void
+merge_io_graph_item(io_graph_item_t *dst, const io_graph_item_t *src, enum ftenum ftype, io_graph_item_unit_t item_unit)
+{
+    if (src->frames == 0 && src->fields == 0 && nstime_is_zero(&src->time_tot)) {
+        return;
+    }
+
+    if (src->first_frame_in_invl &&
+        (dst->first_frame_in_invl == 0 || src->first_frame_in_invl < dst->first_frame_in_invl)) {
+        dst->first_frame_in_invl = src->first_frame_in_invl;
+    }
+    if (src->last_frame_in_invl > dst->last_frame_in_invl) {
+        dst->last_frame_in_invl = src->last_frame_in_invl;
+    }
+
+    if (src->fields) {
+        gboolean new_max, new_min;
+
+        if (dst->fields == 0) {
+            new_max = new_min = TRUE;
+        } else {
+            switch (ftype) {
+            case FT_FLOAT:
+                new_max = src->float_max > dst->float_max;
+                new_min = src->float_min < dst->float_min;
+                break;
+            case FT_RELATIVE_TIME:
+                new_max = nstime_cmp(&src->time_max, &dst->time_max) > 0;
+                new_min = nstime_cmp(&src->time_min, &dst->time_min) < 0;
+                break;
+            default:
+                new_max = src->double_max > dst->double_max;
+                new_min = src->double_min < dst->double_min;
+                break;
+            }
+        }
+
+        if (new_max) {
+            dst->int_max = src->int_max;
+            dst->float_max = src->float_max;
+            dst->double_max = src->double_max;
+            dst->time_max = src->time_max;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                dst->extreme_frame_in_invl = src->extreme_frame_in_invl;
+            }
+        }
+        if (new_min) {
+            dst->int_min = src->int_min;
+            dst->float_min = src->float_min;
+            dst->double_min = src->double_min;
+            dst->time_min = src->time_min;
+            if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                dst->extreme_frame_in_invl = src->extreme_frame_in_invl;
+            }
+        }
+        dst->int_tot += src->int_tot;
+        dst->float_tot += src->float_tot;
+        dst->double_tot += src->double_tot;
+        dst->fields += src->fields;
+    }
+
+    /* LOAD is spread over the intervals before the packet, so this is also
+     * set for buckets without frames. */
+    nstime_add(&dst->time_tot, &src->time_tot);
+
+    dst->frames += src->frames;
+    dst->bytes += src->bytes;
+}
+
+static enum ftenum
+pyramid_ftype(const io_graph_pyramid_t *pyramid)
+{
+    return pyramid->hf_index >= 0 ? proto_registrar_get_ftype(pyramid->hf_index) : FT_NONE;
+}
+
+/* Bring levels[level] up to date with the level below it. */
+static void
+io_graph_pyramid_build_level(io_graph_pyramid_t *pyramid, int level)
+{
+    GArray *lower = pyramid->levels[level - 1];
+    GArray *upper = pyramid->levels[level];
+    enum ftenum ftype = pyramid_ftype(pyramid);
+    guint len = (lower->len + IOG_PYRAMID_FACTOR - 1) / IOG_PYRAMID_FACTOR;
+    guint idx;
+
+    g_array_set_size(upper, len);
+    for (idx = pyramid->valid[level]; idx < len; idx++) {
+        io_graph_item_t *item = &g_array_index(upper, io_graph_item_t, idx);
+        guint child = idx * IOG_PYRAMID_FACTOR;
+        guint end = MIN(child + IOG_PYRAMID_FACTOR, lower->len);
+
+        reset_io_graph_items(item, 1);
+        for (; child < end; child++) {
+            merge_io_graph_item(item, &g_array_index(lower, io_graph_item_t, child), ftype, pyramid->item_unit);
+        }
+    }
+    pyramid->valid[level] = len;
+}
+
+/* Make levels[1] the base level. */
+static void
+io_graph_pyramid_compact(io_graph_pyramid_t *pyramid)
+{
+    int level;
+
+    io_graph_pyramid_build_level(pyramid, 1);
+    g_array_free(pyramid->levels[0], TRUE);
+    for (level = 0; level < IOG_PYRAMID_MAX_LEVELS - 1; level++) {
+        pyramid->levels[level] = pyramid->levels[level + 1];
+        pyramid->valid[level] = pyramid->valid[level + 1];
+    }
+    pyramid->levels[IOG_PYRAMID_MAX_LEVELS - 1] = g_array_new(FALSE, TRUE, sizeof(io_graph_item_t));
+    pyramid->valid[IOG_PYRAMID_MAX_LEVELS - 1] = 0;
+    pyramid->resolution_us *= IOG_PYRAMID_FACTOR;
+}
+
+io_graph_pyramid_t *
+io_graph_pyramid_new(int hf_index, io_graph_item_unit_t item_unit, guint64 resolution_us, guint64 max_resolution_us, int max_buckets)
+{
+    io_graph_pyramid_t *pyramid = g_new0(io_graph_pyramid_t, 1);
+    int level;
+
+    pyramid->hf_index = hf_index;
+    pyramid->item_unit = item_unit;
+    pyramid->resolution_us = MAX(resolution_us, 1);
+    pyramid->max_resolution_us = MAX(max_resolution_us, pyramid->resolution_us);
+    pyramid->max_buckets = max_buckets;
+    for (level = 0; level < IOG_PYRAMID_MAX_LEVELS; level++) {
+        pyramid->levels[level] = g_array_new(FALSE, TRUE, sizeof(io_graph_item_t));
+    }
+
+    return pyramid;
+}
+
+void
+io_graph_pyramid_free(io_graph_pyramid_t *pyramid)
+{
+    int level;
+
+    if (!pyramid) {
+        return;
+    }
+    for (level = 0; level < IOG_PYRAMID_MAX_LEVELS; level++) {
+        g_array_free(pyramid->levels[level], TRUE);
+    }
+    g_free(pyramid);
+}
+
+gboolean
+io_graph_pyramid_add_packet(io_graph_pyramid_t *pyramid, packet_info *pinfo, epan_dissect_t *edt)
+{
+    nstime_t time_delta = pinfo->rel_ts;
+    guint64 rel_us;
+    guint64 idx;
+    GArray *base;
+    guint64 scale;
+    int level;
+
+    if (time_delta.nsecs < 0) {
+        time_delta.secs--;
+        time_delta.nsecs += 1000000000;
+    }
+    if (time_delta.secs < 0) {
+        return FALSE;
+    }
+    rel_us = (guint64) time_delta.secs * 1000000 + time_delta.nsecs / 1000;
+
+    idx = rel_us / pyramid->resolution_us;
+    while (idx >= (guint64) pyramid->max_buckets) {
+        /* Only coarsen to resolutions that still divide the coarsest one */
+        guint64 next_resolution = pyramid->resolution_us * IOG_PYRAMID_FACTOR;
+        if (next_resolution > pyramid->max_resolution_us ||
+            pyramid->max_resolution_us % next_resolution != 0) {
+            return FALSE;
+        }
+        io_graph_pyramid_compact(pyramid);
+        idx = rel_us / pyramid->resolution_us;
+    }
+
+    base = pyramid->levels[0];
+    if (idx >= base->len) {
+        g_array_set_size(base, (guint) idx + 1);
+    }
+
+    /* LOAD updates every bucket back to the start, so invalidate all of them */
+    scale = IOG_PYRAMID_FACTOR;
+    for (level = 1; level < IOG_PYRAMID_MAX_LEVELS; level++) {
+        guint first = pyramid->item_unit == IOG_ITEM_UNIT_CALC_LOAD ? 0 : (guint) (idx / scale);
+        if (pyramid->valid[level] > first) {
+            pyramid->valid[level] = first;
+        }
+        scale *= IOG_PYRAMID_FACTOR;
+    }
+
+    return update_io_graph_item((io_graph_item_t *) base->data, (int) idx, pinfo, edt,
+                                pyramid->hf_index, pyramid->item_unit, pyramid->resolution_us);
+}
+
+guint64
+io_graph_pyramid_resolution(const io_graph_pyramid_t *pyramid)
+{
+    return pyramid->resolution_us;
+}
+
+gboolean
+io_graph_pyramid_has_interval(const io_graph_pyramid_t *pyramid, guint64 interval_us)
+{
+    return interval_us >= pyramid->resolution_us && interval_us % pyramid->resolution_us == 0;
+}
+
+int
+io_graph_pyramid_get_items(io_graph_pyramid_t *pyramid, guint64 interval_us, io_graph_item_unit_t item_unit, io_graph_item_t *items, int max_items)
+{
+    enum ftenum ftype = pyramid_ftype(pyramid);
+    guint64 resolution = pyramid->resolution_us;
+    guint64 per_item;
+    GArray *source;
+    int level = 0;
+    int num_items;
+    int idx;
+
+    if (!io_graph_pyramid_has_interval(pyramid, interval_us)) {
+        return 0;
+    }
+
+    /* Use the coarsest level that divides the interval */
+    while (level + 1 < IOG_PYRAMID_MAX_LEVELS &&
+           interval_us % (resolution * IOG_PYRAMID_FACTOR) == 0) {
+        level++;
+        resolution *= IOG_PYRAMID_FACTOR;
+        io_graph_pyramid_build_level(pyramid, level);
+    }
+
+    source = pyramid->levels[level];
+    per_item = interval_us / resolution;
+    num_items = (int) MIN((source->len + per_item - 1) / per_item, (guint64) max_items);
+
+    for (idx = 0; idx < num_items; idx++) {
+        guint64 child = idx * per_item;
+        guint64 end = MIN(child + per_item, source->len);
+
+        reset_io_graph_items(&items[idx], 1);
+        for (; child < end; child++) {
+            merge_io_graph_item(&items[idx], &g_array_index(source, io_graph_item_t, child), ftype, item_unit);
+        }
+    }
+
+    return num_items;
+}
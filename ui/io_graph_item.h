@@ -139,11 +139,11 @@ double get_io_graph_item(const io_graph_item_t *items, io_graph_item_unit_t val_
  * @param edt [in] Dissection information for advanced statistics. May be NULL.
  * @param hf_index [in] Header field index for advanced statistics.
  * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
- * @param interval [in] Timing interval in ms.
+ * @param interval_us [in] Timing interval in microseconds.
  * @return TRUE if the update was successful, otherwise FALSE.
  */
 static inline gboolean
-update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_dissect_t *edt, int hf_index, int item_unit, guint32 interval) {
+update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_dissect_t *edt, int hf_index, int item_unit, guint64 interval_us) {
     io_graph_item_t *item = &items[idx];
 
     /* Set the first and last frame num in current interval matching the target field+filter  */
@@ -317,7 +317,7 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                      * Handle current interval
                      */
                     pt = pinfo->rel_ts.secs * 1000000 + pinfo->rel_ts.nsecs / 1000;
-                    pt = pt % (interval * 1000);
+                    pt = pt % interval_us;
                     if (pt > t) {
                         pt = t;
                     }
@@ -336,8 +336,8 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
                         }
                         j--;
                         t -= pt;
-                        if (t > (guint64) interval * 1000) {
-                            pt = (guint64) interval * 1000;
+                        if (t > interval_us) {
+                            pt = interval_us;
                         } else {
                             pt = t;
                         }
@@ -396,6 +396,70 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
     return TRUE;
 }
 
+/*
+ * A multi-resolution aggregate of io_graph_item_t buckets.
+ *
+ * Packets are added to buckets at a fine base resolution. Each coarser level
+ * of the pyramid merges IOG_PYRAMID_FACTOR buckets of the level below it and
+ * is built on demand, so any interval that is a multiple of the base
+ * resolution can be read back without retapping.
+ *
+ * The base level is limited to a fixed number of buckets. When a packet
+ * falls beyond it, the pyramid is compacted by promoting the next coarser
+ * level to be the new base, as long as the resolution stays at or below
+ * the limit given when the pyramid was created.
+ */
+typedef struct _io_graph_pyramid_t io_graph_pyramid_t;
+
+#define IOG_PYRAMID_FACTOR 10
+
+/** Create a pyramid.
+ *
+ * @param hf_index [in] Header field index for advanced statistics.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @param resolution_us [in] Initial base resolution in microseconds.
+ * @param max_resolution_us [in] Coarsest base resolution compaction may
+ *                               reach, in microseconds.
+ * @param max_buckets [in] Maximum number of base buckets.
+ * @return A new pyramid. Free it with io_graph_pyramid_free().
+ */
+io_graph_pyramid_t *io_graph_pyramid_new(int hf_index, io_graph_item_unit_t item_unit, guint64 resolution_us, guint64 max_resolution_us, int max_buckets);
+
+void io_graph_pyramid_free(io_graph_pyramid_t *pyramid);
+
+/** Add a packet to the base level.
+ *
+ * @param pyramid [in,out] The pyramid.
+ * @param pinfo [in] Packet containing update information.
+ * @param edt [in] Dissection information for advanced statistics. May be NULL.
+ * @return TRUE if the packet was added, FALSE if it is out of range or
+ *         update_io_graph_item() failed.
+ */
+gboolean io_graph_pyramid_add_packet(io_graph_pyramid_t *pyramid, packet_info *pinfo, epan_dissect_t *edt);
+
+/** The current base resolution in microseconds. */
+guint64 io_graph_pyramid_resolution(const io_graph_pyramid_t *pyramid);
+
+/** Check whether an interval can be read from the pyramid.
+ *
+ * @param pyramid [in] The pyramid.
+ * @param interval_us [in] Interval in microseconds.
+ * @return TRUE if interval_us is a multiple of the base resolution.
+ */
+gboolean io_graph_pyramid_has_interval(const io_graph_pyramid_t *pyramid, guint64 interval_us);
+
+/** Read the buckets for an interval.
+ *
+ * @param pyramid [in,out] The pyramid. Coarser levels are built as needed.
+ * @param interval_us [in] Interval in microseconds. Must be accepted by
+ *                         io_graph_pyramid_has_interval().
+ * @param item_unit [in] The unit the items will be displayed in, which
+ *                       decides the frame that is kept for MIN and MAX.
+ * @param items [out] Array receiving the merged items.
+ * @param max_items [in] The number of items in the array.
+ * @return The number of items filled in.
+ */
+int io_graph_pyramid_get_items(io_graph_pyramid_t *pyramid, guint64 interval_us, io_graph_item_unit_t item_unit, io_graph_item_t *items, int max_items);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,202 @@
+/* io_graph_item_test.c
+ * I/O graph pyramid tests
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#undef G_DISABLE_ASSERT
+
+#include <string.h>
+#include <glib.h>
+
+#include <epan/packet_info.h>
+
+#include "ui/io_graph_item.h"
+
+#define TEST_MAX_ITEMS 250000
+
+typedef struct {
+    guint32 num;
+    guint32 len;
+    guint64 rel_us;
+} test_packet_t;
+
+static void
+add_packet(io_graph_pyramid_t *pyramid, const test_packet_t *pkt, gboolean expect_added)
+{
+    frame_data fd;
+    packet_info pinfo;
+
+    memset(&fd, 0, sizeof(fd));
+    memset(&pinfo, 0, sizeof(pinfo));
+    fd.pkt_len = pkt->len;
+    pinfo.fd = &fd;
+    pinfo.num = pkt->num;
+    pinfo.rel_ts.secs = (time_t) (pkt->rel_us / 1000000);
+    pinfo.rel_ts.nsecs = (int) (pkt->rel_us % 1000000) * 1000;
+
+    g_assert_cmpint(io_graph_pyramid_add_packet(pyramid, &pinfo, NULL), ==, expect_added);
+}
+
+/* Read an interval back and compare it with the packets counted directly. */
+static void
+check_interval(io_graph_pyramid_t *pyramid, const test_packet_t *pkts, guint num_pkts, guint64 interval_us)
+{
+    io_graph_item_t *items = g_new(io_graph_item_t, TEST_MAX_ITEMS);
+    io_graph_item_t *expected = g_new(io_graph_item_t, TEST_MAX_ITEMS);
+    int num_items, num_expected = 0;
+    guint i;
+
+    g_assert_true(io_graph_pyramid_has_interval(pyramid, interval_us));
+
+    reset_io_graph_items(expected, TEST_MAX_ITEMS);
+    for (i = 0; i < num_pkts; i++) {
+        guint64 idx = pkts[i].rel_us / interval_us;
+        io_graph_item_t *item;
+
+        g_assert_cmpuint(idx, <, TEST_MAX_ITEMS);
+        item = &expected[idx];
+        if (item->first_frame_in_invl == 0 || pkts[i].num < item->first_frame_in_invl) {
+            item->first_frame_in_invl = pkts[i].num;
+        }
+        item->last_frame_in_invl = MAX(item->last_frame_in_invl, pkts[i].num);
+        item->frames++;
+        item->bytes += pkts[i].len;
+        num_expected = MAX(num_expected, (int) idx + 1);
+    }
+
+    num_items = io_graph_pyramid_get_items(pyramid, interval_us, IOG_ITEM_UNIT_PACKETS, items, TEST_MAX_ITEMS);
+    g_assert_cmpint(num_items, >=, num_expected);
+    for (i = 0; i < (guint) num_items; i++) {
+        g_assert_cmpuint(items[i].frames, ==, expected[i].frames);
+        g_assert_cmpuint(items[i].bytes, ==, expected[i].bytes);
+        g_assert_cmpuint(items[i].first_frame_in_invl, ==, expected[i].first_frame_in_invl);
+        g_assert_cmpuint(items[i].last_frame_in_invl, ==, expected[i].last_frame_in_invl);
+    }
+
+    g_free(items);
+    g_free(expected);
+}
+
+static test_packet_t *
+random_packets(GRand *rand, guint num_pkts, guint64 max_us)
+{
+    test_packet_t *pkts = g_new(test_packet_t, num_pkts);
+    guint i;
+
+    for (i = 0; i < num_pkts; i++) {
+        pkts[i].num = i + 1;
+        pkts[i].len = (guint32) g_rand_int_range(rand, 60, 1515);
+        pkts[i].rel_us = (guint64) g_rand_double_range(rand, 0, (gdouble) max_us);
+    }
+    return pkts;
+}
+
+static void
+test_pyramid_merge(void)
+{
+    static const guint64 intervals[] = { 1, 10, 100, 1000, 7000, 20000, 100000, 150000 };
+    GRand *rand = g_rand_new_with_seed(1);
+    io_graph_pyramid_t *pyramid;
+    test_packet_t *pkts;
+    guint num_pkts = 5000;
+    guint i;
+
+    /* 200 ms at 1 us fits in the base level, so nothing is compacted. */
+    pkts = random_packets(rand, num_pkts, 200000);
+    pyramid = io_graph_pyramid_new(-1, IOG_ITEM_UNIT_PACKETS, 1, 1000000, TEST_MAX_ITEMS);
+
+    /* Read the coarser levels while packets are still coming in, so that
+     * they have to be brought up to date from the buckets that changed. */
+    for (i = 0; i < num_pkts; i++) {
+        add_packet(pyramid, &pkts[i], TRUE);
+        if (i == num_pkts / 2) {
+            check_interval(pyramid, pkts, i + 1, 1000);
+            check_interval(pyramid, pkts, i + 1, 100000);
+        }
+    }
+
+    g_assert_cmpuint(io_graph_pyramid_resolution(pyramid), ==, 1);
+    for (i = 0; i < G_N_ELEMENTS(intervals); i++) {
+        check_interval(pyramid, pkts, num_pkts, intervals[i]);
+    }
+
+    io_graph_pyramid_free(pyramid);
+    g_free(pkts);
+    g_rand_free(rand);
+}
+
+static void
+test_pyramid_compact(void)
+{
+    static const guint64 intervals[] = { 10000, 30000, 100000, 1000000 };
+    GRand *rand = g_rand_new_with_seed(2);
+    io_graph_pyramid_t *pyramid;
+    test_packet_t *pkts;
+    test_packet_t late;
+    guint num_pkts = 5000;
+    guint i;
+
+    /* 1000 buckets of 1 us only cover 1 ms, so packets spread over 5 s
+     * compact the base level to 10 ms, the coarsest resolution allowed. */
+    pkts = random_packets(rand, num_pkts, 5000000);
+    /* Start with packets that fit at the finest resolution. */
+    pkts[0].rel_us = 0;
+    pkts[1].rel_us = 999;
+    pyramid = io_graph_pyramid_new(-1, IOG_ITEM_UNIT_PACKETS, 1, 10000, 1000);
+
+    for (i = 0; i < num_pkts; i++) {
+        add_packet(pyramid, &pkts[i], TRUE);
+        if (i == 1) {
+            g_assert_cmpuint(io_graph_pyramid_resolution(pyramid), ==, 1);
+        }
+    }
+
+    g_assert_cmpuint(io_graph_pyramid_resolution(pyramid), ==, 10000);
+    g_assert_false(io_graph_pyramid_has_interval(pyramid, 1000));
+    g_assert_false(io_graph_pyramid_has_interval(pyramid, 15000));
+    for (i = 0; i < G_N_ELEMENTS(intervals); i++) {
+        check_interval(pyramid, pkts, num_pkts, intervals[i]);
+    }
+
+    /* Past 1000 buckets of 10 ms; compacting further isn't allowed. */
+    late.num = num_pkts + 1;
+    late.len = 100;
+    late.rel_us = 10000000;
+    add_packet(pyramid, &late, FALSE);
+    g_assert_cmpuint(io_graph_pyramid_resolution(pyramid), ==, 10000);
+    check_interval(pyramid, pkts, num_pkts, 100000);
+
+    io_graph_pyramid_free(pyramid);
+    g_free(pkts);
+    g_rand_free(rand);
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/io_graph_pyramid/merge", test_pyramid_merge);
+    g_test_add_func("/io_graph_pyramid/compact", test_pyramid_compact);
+
+    return g_test_run();
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
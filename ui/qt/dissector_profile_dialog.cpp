@@ -0,0 +1,168 @@
+/* dissector_profile_dialog.cpp
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "dissector_profile_dialog.h"
+
+#include <epan/tap.h>
+
+#include <QLineEdit>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QTreeWidgetItem>
+
+enum {
+    col_name_,
+    col_protocol_,
+    col_calls_,
+    col_incl_time_,
+    col_excl_time_,
+    col_incl_bytes_,
+    col_excl_bytes_
+};
+
+enum {
+    dissector_profile_row_type_ = 1000
+};
+
+class DissectorProfileTreeWidgetItem : public QTreeWidgetItem
+{
+public:
+    DissectorProfileTreeWidgetItem(QTreeWidget *parent, const dissector_prof_stats_t *stats, double ticks_per_us) :
+        QTreeWidgetItem(parent, dissector_profile_row_type_),
+        calls_(stats->calls),
+        incl_us_((double)stats->incl_ticks / ticks_per_us),
+        excl_us_((double)stats->excl_ticks / ticks_per_us),
+        incl_bytes_(stats->incl_bytes),
+        excl_bytes_(stats->excl_bytes)
+    {
+        QString name = stats->name;
+        if (stats->heuristic) {
+            name += QObject::tr(" (heuristic)");
+        }
+        setText(col_name_, name);
+        setText(col_protocol_, stats->protocol ? stats->protocol : "");
+        setText(col_calls_, QString::number(calls_));
+        setText(col_incl_time_, QString::number(incl_us_, 'f', 1));
+        setText(col_excl_time_, QString::number(excl_us_, 'f', 1));
+        setText(col_incl_bytes_, QString::number(incl_bytes_));
+        setText(col_excl_bytes_, QString::number(excl_bytes_));
+        for (int col = col_calls_; col <= col_excl_bytes_; col++) {
+            setTextAlignment(col, Qt::AlignRight);
+        }
+    }
+
+    bool operator< (const QTreeWidgetItem &other) const
+    {
+        if (other.type() != dissector_profile_row_type_) return QTreeWidgetItem::operator< (other);
+        const DissectorProfileTreeWidgetItem *other_row = static_cast<const DissectorProfileTreeWidgetItem *>(&other);
+
+        switch (treeWidget()->sortColumn()) {
+        case col_calls_:
+            return calls_ < other_row->calls_;
+        case col_incl_time_:
+            return incl_us_ < other_row->incl_us_;
+        case col_excl_time_:
+            return excl_us_ < other_row->excl_us_;
+        case col_incl_bytes_:
+            return incl_bytes_ < other_row->incl_bytes_;
+        case col_excl_bytes_:
+            return excl_bytes_ < other_row->excl_bytes_;
+        default:
+            break;
+        }
+
+        return QTreeWidgetItem::operator< (other);
+    }
+
+    QList<QVariant> rowData() const
+    {
+        return QList<QVariant>()
+                << text(col_name_) << text(col_protocol_) << calls_
+                << incl_us_ << excl_us_ << incl_bytes_ << excl_bytes_;
+    }
+
+private:
+    quint64 calls_;
+    double incl_us_;
+    double excl_us_;
+    quint64 incl_bytes_;
+    quint64 excl_bytes_;
+};
+
+DissectorProfileDialog::DissectorProfileDialog(QWidget &parent, CaptureFile &cf) :
+    TapParameterDialog(parent, cf),
+    ticks_per_us_(1000.0)
+{
+    setWindowSubtitle(tr("Dissector Profile"));
+    loadGeometry(parent.width() * 2 / 3, parent.height() * 3 / 4, "DissectorProfileDialog");
+
+    QStringList header_labels = QStringList()
+            << tr("Dissector") << tr("Protocol") << tr("Calls")
+            << tr("Incl. Time (\xC2\xB5s)") << tr("Excl. Time (\xC2\xB5s)")
+            << tr("Incl. Bytes") << tr("Excl. Bytes");
+    statsTreeWidget()->setHeaderLabels(header_labels);
+    for (int col = col_calls_; col <= col_excl_bytes_; col++) {
+        statsTreeWidget()->headerItem()->setTextAlignment(col, Qt::AlignRight);
+    }
+    statsTreeWidget()->sortByColumn(col_excl_time_, Qt::DescendingOrder);
+
+    // Every packet is profiled; a display filter wouldn't change that.
+    displayFilterLineEdit()->hide();
+    applyFilterButton()->hide();
+    setHint(tr("Times include the profiling overhead. Exclusive figures leave out the dissectors that were called."));
+}
+
+void DissectorProfileDialog::addProfile(const dissector_prof_stats_t *stats, gpointer dp_dlg_ptr)
+{
+    DissectorProfileDialog *dp_dlg = static_cast<DissectorProfileDialog *>(dp_dlg_ptr);
+
+    new DissectorProfileTreeWidgetItem(dp_dlg->statsTreeWidget(), stats, dp_dlg->ticks_per_us_);
+}
+
+void DissectorProfileDialog::fillTree()
+{
+    // The profile is kept by epan, so the listener only has to make
+    // retapPackets() dissect every packet.
+    if (!registerTapListener("frame",
+                             this,
+                             NULL,
+                             TL_REQUIRES_NOTHING,
+                             NULL,
+                             NULL,
+                             NULL)) {
+        reject();
+        return;
+    }
+
+    dissector_prof_reset();
+    dissector_prof_enable();
+    cap_file_.retapPackets();
+    ticks_per_us_ = dissector_prof_ticks_per_ns() * 1000.0;
+    dissector_prof_disable();
+    removeTapListeners();
+
+    statsTreeWidget()->setSortingEnabled(false);
+    statsTreeWidget()->clear();
+    dissector_prof_foreach(addProfile, this);
+    statsTreeWidget()->setSortingEnabled(true);
+
+    for (int col = 0; col < statsTreeWidget()->columnCount(); col++) {
+        statsTreeWidget()->resizeColumnToContents(col);
+    }
+}
+
+// This is how an item is represented for exporting.
+QList<QVariant> DissectorProfileDialog::treeItemData(QTreeWidgetItem *ti) const
+{
+    if (ti->type() == dissector_profile_row_type_) {
+        return static_cast<DissectorProfileTreeWidgetItem *>(ti)->rowData();
+    }
+
+    return QList<QVariant>();
+}
@@ -0,0 +1,37 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef DISSECTOR_PROFILE_DIALOG_H
+#define DISSECTOR_PROFILE_DIALOG_H
+
+#include "tap_parameter_dialog.h"
+
+#include <epan/packet.h>
+
+// Dissects the capture again with dissector profiling enabled and shows
+// the time and memory spent in each dissector.
+class DissectorProfileDialog : public TapParameterDialog
+{
+    Q_OBJECT
+
+public:
+    DissectorProfileDialog(QWidget &parent, CaptureFile &cf);
+
+private:
+    static void addProfile(const dissector_prof_stats_t *stats, gpointer dp_dlg_ptr);
+
+    virtual QList<QVariant> treeItemData(QTreeWidgetItem *ti) const;
+
+    double ticks_per_us_;
+
+private slots:
+    virtual void fillTree();
+};
+
+#endif // DISSECTOR_PROFILE_DIALOG_H
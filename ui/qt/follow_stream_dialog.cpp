@@ -13,6 +13,7 @@
 #include "main_application.h"
 #include "main_window.h"
 
+#include "file.h"
 #include "frame_tvbuff.h"
 #include "epan/follow.h"
 #include "epan/prefs.h"
@@ -1048,6 +1049,13 @@ bool FollowStreamDialog::follow(QString previous_filter, bool use_stream_index,
     beginRetapPackets();
     updateWidgets(true);
 
+    /* If the first pass indexed the stream's frames, only those need
+       to be dissected for the filter and the tap. */
+    guint num_stream_frames;
+    const guint32 *stream_frames = follow_get_stream_frames(follower_, stream_num, &num_stream_frames);
+    cf_set_filter_frames(cap_file_.capFile(), follow_filter.toUtf8().constData(),
+                         stream_frames, num_stream_frames);
+
     /* Run the display filter so it goes in effect - even if it's the
        same as the previous display filter. */
     emit updateFilter(follow_filter, TRUE);
@@ -1282,14 +1282,20 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
+    bool need_recalc = false;
 
     if (uat_model_ != NULL) {
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
+                // Intervals the tapped data can be merged to don't need a retap.
+                bool retap = iog->setInterval(interval);
                 if (iog->visible()) {
-                    need_retap = true;
+                    if (retap) {
+                        need_retap = true;
+                    } else {
+                        need_recalc = true;
+                    }
                 }
             }
         }
@@ -1297,6 +1303,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else if (need_recalc) {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1704,6 +1712,7 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
+    pyramid_(NULL),
     cur_idx_(-1)
 {
     Q_ASSERT(parent_ != NULL);
@@ -1729,6 +1738,7 @@ IOGraph::IOGraph(QCustomPlot *parent) :
 
 IOGraph::~IOGraph() {
     remove_tap_listener(this);
+    io_graph_pyramid_free(pyramid_);
     if (graph_) {
         parent_->removeGraph(graph_);
     }
@@ -2024,6 +2034,15 @@ void IOGraph::clearAllData()
 {
     cur_idx_ = -1;
     reset_io_graph_items(items_, max_io_items_);
+
+    // Tap at the finest resolution that fits; coarser intervals are then
+    // merged from it. LOAD spreads each value over every earlier bucket,
+    // so it's tapped at the current interval.
+    guint64 interval_us = (guint64) interval_ * 1000;
+    io_graph_pyramid_free(pyramid_);
+    pyramid_ = io_graph_pyramid_new(hf_index_, val_units_,
+                                    val_units_ == IOG_ITEM_UNIT_CALC_LOAD ? interval_us : 1,
+                                    interval_us, max_io_items_);
     if (graph_) {
         graph_->data()->clear();
     }
@@ -2050,6 +2069,10 @@ void IOGraph::recalcGraphData(capture_file *cap_file, bool enable_scaling)
         x_axis = bars_->keyAxis();
     }
 
+    if (pyramid_ && io_graph_pyramid_has_interval(pyramid_, (guint64) interval_ * 1000)) {
+        cur_idx_ = io_graph_pyramid_get_items(pyramid_, (guint64) interval_ * 1000, val_units_, items_, max_io_items_) - 1;
+    }
+
     if (moving_avg_period_ > 0 && cur_idx_ >= 0) {
         /* "Warm-up phase" - calculate average on some data not displayed;
          * just to make sure average on leftmost and rightmost displayed
@@ -2264,9 +2287,10 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+bool IOGraph::setInterval(int interval)
 {
     interval_ = interval;
+    return !pyramid_ || !io_graph_pyramid_has_interval(pyramid_, (guint64) interval_ * 1000);
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -2324,7 +2348,7 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         adv_edt = edt;
     }
 
-    if (!update_io_graph_item(iog->items_, idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
+    if (!iog->pyramid_ || !io_graph_pyramid_add_packet(iog->pyramid_, pinfo, adv_edt)) {
         return TAP_PACKET_DONT_REDRAW;
     }
 
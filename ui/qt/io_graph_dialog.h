@@ -67,7 +67,8 @@ public:
     const QString valueUnitField() { return vu_field_; }
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() { return moving_avg_period_; }
-    void setInterval(int interval);
+    // Returns true if the graph must be retapped to show the new interval.
+    bool setInterval(int interval);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() { return graph_; }
@@ -121,6 +122,9 @@ private:
 
     // Cached data. We should be able to change the Y axis without retapping as
     // much as is feasible.
+    // Tapped data at the finest resolution we can afford. items_ holds it
+    // merged to interval_.
+    io_graph_pyramid_t *pyramid_;
     io_graph_item_t items_[max_io_items_];
     int cur_idx_;
 };
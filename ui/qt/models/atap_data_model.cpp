@@ -123,6 +123,10 @@ bool ATapDataModel::enableTap()
     if (errorString)
         g_string_free(errorString, TRUE);
 
+    /* Lets retaps fill the table on several threads */
+    set_tap_merge_funcs(hash(), clone_conversation_table_hash,
+        _type == ATapDataModel::DATAMODEL_ENDPOINT ? merge_endpoint_table_data : merge_conversation_table_data);
+
     emit tapListenerChanged(true);
 
     return true;
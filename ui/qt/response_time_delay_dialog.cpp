@@ -245,6 +245,7 @@ void ResponseTimeDelayDialog::fillTree()
         reject(); // XXX Stay open instead?
         return;
     }
+    set_tap_merge_funcs(&rtd_data, clone_rtd_table_data, merge_rtd_table_data);
 
     statsTreeWidget()->setSortingEnabled(false);
 
@@ -2555,6 +2555,7 @@ void WiresharkMainWindow::setMenusForCaptureFile(bool force_disable)
      * still in progress.
      */
     main_ui_->actionStatisticsProtocolHierarchy->setEnabled(enable);
+    main_ui_->actionStatisticsDissectorProfile->setEnabled(enable);
     /*
      * "Export Specified Packets..." should be available only if
      * we can write the file out in at least one format.
@@ -2676,6 +2677,7 @@ void WiresharkMainWindow::setForCapturedPackets(bool have_captured_packets)
 
     main_ui_->actionStatisticsCaptureFileProperties->setEnabled(have_captured_packets);
     main_ui_->actionStatisticsProtocolHierarchy->setEnabled(have_captured_packets);
+    main_ui_->actionStatisticsDissectorProfile->setEnabled(have_captured_packets);
     main_ui_->actionStatisticsIOGraph->setEnabled(have_captured_packets);
 }
 
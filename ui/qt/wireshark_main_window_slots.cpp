@@ -106,6 +106,7 @@ DIAG_ON(frame-larger-than=)
 #include "decode_as_dialog.h"
 #include <ui/qt/widgets/display_filter_edit.h>
 #include "display_filter_expression_dialog.h"
+#include "dissector_profile_dialog.h"
 #include "dissector_tables_dialog.h"
 #include "endpoint_dialog.h"
 #include "expert_info_dialog.h"
@@ -3392,6 +3393,11 @@ void WiresharkMainWindow::connectStatisticsMenuActions()
         phd->show();
     });
 
+    connect(main_ui_->actionStatisticsDissectorProfile, &QAction::triggered, this, [=]() {
+        DissectorProfileDialog *dpd = new DissectorProfileDialog(*this, capture_file_);
+        dpd->show();
+    });
+
     connect(main_ui_->actionStatisticsConversations, &QAction::triggered, this, &WiresharkMainWindow::showConversationsDialog);
     connect(main_ui_->actionStatisticsEndpoints, &QAction::triggered, this, &WiresharkMainWindow::showEndpointsDialog);
 
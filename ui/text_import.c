@@ -107,6 +107,7 @@
 #include "text_import_scanner.h"
 #include "text_import_scanner_lex.h"
 #include "text_import_regex.h"
+#include "text_import_hexdump.h"
 
 /*--- Options --------------------------------------------------------------------*/
 
@@ -1544,6 +1545,66 @@ parse_token(token_t token, char *str)
     return IMPORT_SUCCESS;
 }
 
+/*----------------------------------------------------------------------
+ * Take a packet decoded by the parallel hexdump importer, as if the scanner
+ * had read an offset 0 line and the byte values that follow.
+ */
+static import_status_t
+write_hexdump_packet(const guint8 *data, guint32 len)
+{
+    guint32 n;
+
+    if (start_new_packet(FALSE) != IMPORT_SUCCESS)
+        return IMPORT_FAILURE;
+    packet_start = 0;
+    state = START_OF_LINE;
+
+    while (len > 0) {
+        n = MIN(len, info_p->max_frame_length - curr_offset);
+        memcpy(&packet_buf[curr_offset], data, n);
+        curr_offset += n;
+        data += n;
+        len -= n;
+        if (curr_offset >= info_p->max_frame_length) /* packet full */
+            if (start_new_packet(TRUE) != IMPORT_SUCCESS)
+                return IMPORT_FAILURE;
+    }
+    pkt_lnstart = packet_buf + curr_offset;
+
+    return IMPORT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------
+ * Import a hexdump, using the parallel importer for as much of it as it
+ * can handle and the scanner for the rest.
+ */
+static import_status_t
+import_hexdump(FILE *input_file)
+{
+    gint64 fallback_offset;
+
+    /* The scanner has to be able to pick up where the importer left off,
+     * and the importer only knows about hexadecimal offsets. */
+    if (offset_base == 16 && !info_p->hexdump.identify_ascii &&
+        info_p->max_frame_length > 0 && ws_ftell64(input_file) >= 0) {
+        if (text_import_hexdump(input_file, info_p->max_frame_length,
+                                append_to_preamble, write_hexdump_packet,
+                                &fallback_offset) != IMPORT_SUCCESS)
+            return IMPORT_FAILURE;
+        if (fallback_offset < 0)
+            return write_current_packet(FALSE);
+
+        ws_debug("Continuing with the scanner at offset %" PRId64, fallback_offset);
+        if (ws_fseek64(input_file, fallback_offset, SEEK_SET) != 0) {
+            report_failure("Can't seek in input: %s", g_strerror(errno));
+            return IMPORT_FAILURE;
+        }
+        state = info_p->num_packets_read > 0 ? START_OF_LINE : INIT;
+    }
+
+    return text_import_scan(input_file);
+}
+
 /*----------------------------------------------------------------------
  * Import a text file.
  */
@@ -1727,7 +1788,7 @@ text_import(text_import_info_t * const info)
     }
 
     if (info->mode == TEXT_IMPORT_HEXDUMP) {
-        status = text_import_scan(info->hexdump.import_text_FILE);
+        status = import_hexdump(info->hexdump.import_text_FILE);
         switch(status) {
         case (IMPORT_SUCCESS):
             ret = 0;
@@ -0,0 +1,553 @@
+/* text_import_hexdump.c
+ * Parallel importer for offset-prefixed hexdumps
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * The scanner in text_import_scanner.l hands text_import.c one token at
+ * a time, which is far too slow for hexdumps of several gigabytes.
+ *
+ * This importer reads the input in large chunks, each ending just before
+ * a line with offset 0, so that every chunk but the first begins with a
+ * new packet. The chunks are decoded by a thread pool and the results are
+ * handed back in input order.
+ *
+ * A chunk is decoded only if every line in it is interpreted the same
+ * way the scanner would interpret it:
+ *
+ *  - blank lines and comment lines are skipped;
+ *  - an offset line has an offset of 3 to 8 hex digits followed by ':',
+ *    a blank or a tab. Offset 0 starts a packet, any other offset must
+ *    continue the current packet at the expected position. As in the
+ *    scanner, a smaller offset discards values that were taken from the
+ *    text column of the previous line. Byte values follow the offset,
+ *    and the rest of the line after the first token that isn't a byte
+ *    value is ignored;
+ *  - any other line consists of text tokens, which go to the preamble.
+ *
+ * Anything else (directives, mail forwarding markers, bare carriage
+ * returns, text that the scanner would take for an offset, ...) makes
+ * the chunk fail, and the caller continues with the scanner from the
+ * start of that chunk.
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+#include <wsutil/file_util.h>
+#include <wsutil/report_message.h>
+
+#include "text_import_hexdump.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_HEXDUMP_SSE2
+#endif
+
+/* Large enough to amortize the hand-off, small enough to keep every
+ * processor busy on inputs of a few megabytes. */
+#define HEXDUMP_CHUNK_SIZE  (1024 * 1024)
+
+#define MIN_OFFSET_DIGITS   3
+#define MAX_OFFSET_DIGITS   8
+
+typedef enum {
+    HEXDUMP_TEXT,
+    HEXDUMP_PACKET
+} hexdump_event_type_t;
+
+typedef struct {
+    hexdump_event_type_t type;
+    guint offset;       /* Into text or bytes */
+    guint len;          /* Packet length */
+} hexdump_event_t;
+
+typedef struct {
+    GByteArray *input;
+    gint64      file_offset;
+    guint32     max_frame_length;
+
+    /* Results */
+    gboolean    ok;
+    GArray     *events;
+    GByteArray *bytes;  /* Packet data */
+    GByteArray *text;   /* NUL-terminated preamble tokens */
+    gboolean    done;
+} hexdump_chunk_t;
+
+static GMutex chunks_mutex;
+static GCond  chunks_cond;
+
+static inline gboolean
+is_blank(guchar c)
+{
+    return c == ' ' || c == '\t';
+}
+
+static gsize
+hex_run(const guchar *s, const guchar *end)
+{
+    const guchar *p = s;
+
+    while (p < end && g_ascii_isxdigit(*p))
+        p++;
+    return p - s;
+}
+
+/*
+ * If the line starting at s (after leading blanks) begins with an offset
+ * token, return the number of digits, otherwise 0. line_end points at the
+ * '\n' or the end of the input.
+ *
+ * The scanner takes the longest match, so "0010:" followed by anything but
+ * a blank or the end of the line is text, and two digits followed by a
+ * blank are a byte value; both are rejected here.
+ */
+static gsize
+offset_digits(const guchar *s, const guchar *line_end)
+{
+    gsize h = hex_run(s, line_end);
+    const guchar *sep = s + h;
+
+    if (h < MIN_OFFSET_DIGITS || h > MAX_OFFSET_DIGITS || sep >= line_end)
+        return 0;
+    if (is_blank(*sep))
+        return h;
+    if (*sep == ':' && (sep + 1 == line_end || is_blank(sep[1])))
+        return h;
+    return 0;
+}
+
+/*
+ * Return TRUE if the scanner would take the token as text. A trailing
+ * '\r' belongs to the token but may turn it into an offset at the end of
+ * the line, so it is disregarded.
+ */
+static gboolean
+token_is_text(const guchar *t, gsize n)
+{
+    gsize h;
+
+    if (n > 0 && t[n - 1] == '\r')
+        n--;
+    if (t[0] == '>')
+        return FALSE;
+    h = hex_run(t, t + n);
+    if (h == n)
+        return FALSE;
+    if (h + 1 == n && t[h] == ':')
+        return FALSE;
+    return TRUE;
+}
+
+#ifdef HAVE_HEXDUMP_SSE2
+/*
+ * Decode 16 byte values from 48 characters laid out as "hh " 16 times.
+ * Returns FALSE, having written nothing, if the input isn't laid out
+ * that way.
+ */
+static gboolean
+decode16_sse2(const guchar *src, guint8 *dst)
+{
+    const __m128i below_0 = _mm_set1_epi8('0' - 1);
+    const __m128i above_9 = _mm_set1_epi8('9' + 1);
+    const __m128i below_a = _mm_set1_epi8('a' - 1);
+    const __m128i above_f = _mm_set1_epi8('f' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i blank = _mm_set1_epi8(' ');
+    guint8 nibbles[48];
+    guint64 hex_mask = 0;
+    guint64 blank_mask = 0;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(src + 16 * i));
+        __m128i lower = _mm_or_si128(c, case_bit);
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, below_0), _mm_cmplt_epi8(c, above_9));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, below_a), _mm_cmplt_epi8(lower, above_f));
+        /* '0'-'9' are 0x30-0x39 and 'a'-'f'/'A'-'F' end in 1-6 */
+        __m128i value = _mm_add_epi8(_mm_and_si128(c, low_nibble), _mm_and_si128(alpha, nine));
+
+        hex_mask |= (guint64)(guint)_mm_movemask_epi8(_mm_or_si128(digit, alpha)) << (16 * i);
+        blank_mask |= (guint64)(guint)_mm_movemask_epi8(_mm_cmpeq_epi8(c, blank)) << (16 * i);
+        _mm_storeu_si128((__m128i *)(nibbles + 16 * i), value);
+    }
+
+    if (hex_mask != G_GUINT64_CONSTANT(0x6db6db6db6db) ||
+        blank_mask != G_GUINT64_CONSTANT(0x924924924924))
+        return FALSE;
+
+    for (i = 0; i < 16; i++)
+        dst[i] = (nibbles[3 * i] << 4) | nibbles[3 * i + 1];
+    return TRUE;
+}
+#endif
+
+/*
+ * Append the byte values following an offset to the chunk, stopping at
+ * the first token that isn't one. content_end is the end of the line
+ * without its "\r\n" or "\n".
+ */
+static guint
+decode_bytes(GByteArray *bytes, const guchar *p, const guchar *content_end)
+{
+    guint count = 0;
+    guint8 value;
+
+    for (;;) {
+        while (p < content_end && is_blank(*p))
+            p++;
+        if (p >= content_end)
+            break;
+#ifdef HAVE_HEXDUMP_SSE2
+        if (content_end - p >= 48) {
+            guint8 values[16];
+
+            if (decode16_sse2(p, values)) {
+                g_byte_array_append(bytes, values, 16);
+                count += 16;
+                p += 48;
+                continue;
+            }
+        }
+#endif
+        if (content_end - p < 2 || !g_ascii_isxdigit(p[0]) || !g_ascii_isxdigit(p[1]))
+            break;
+        if (p + 2 < content_end && !is_blank(p[2]))
+            break;
+        value = (g_ascii_xdigit_value(p[0]) << 4) | g_ascii_xdigit_value(p[1]);
+        g_byte_array_append(bytes, &value, 1);
+        count++;
+        p += 2;
+    }
+    return count;
+}
+
+static void
+end_packet(hexdump_chunk_t *chunk, gint packet_idx)
+{
+    hexdump_event_t *ev;
+
+    if (packet_idx < 0)
+        return;
+    ev = &g_array_index(chunk->events, hexdump_event_t, packet_idx);
+    ev->len = chunk->bytes->len - ev->offset;
+}
+
+static gboolean
+decode_chunk(hexdump_chunk_t *chunk)
+{
+    const guchar *p = chunk->input->data;
+    const guchar *end = p + chunk->input->len;
+    gint packet_idx = -1;
+    guint packet_start = 0;
+    guint32 total = 0;          /* Bytes in the current packet */
+    guint32 peak = 0;           /* Most bytes it has ever had */
+    gboolean text_in_packet = FALSE;
+
+    while (p < end) {
+        const guchar *eol = (const guchar *)memchr(p, '\n', end - p);
+        const guchar *line_end = eol ? eol : end;
+        const guchar *content_end = line_end;
+        const guchar *cr = (const guchar *)memchr(p, '\r', line_end - p);
+        const guchar *s = p;
+        gsize h;
+
+        if (cr) {
+            /* Only allowed as part of the line ending */
+            if (cr != line_end - 1 || !eol)
+                return FALSE;
+            content_end = cr;
+        }
+
+        while (s < content_end && is_blank(*s))
+            s++;
+
+        if (s == content_end) {
+            /* Blank line */
+        } else if (*s == '#') {
+            if (s == p && line_end - p >= 10 && memcmp(p, "#TEXT2PCAP", 10) == 0)
+                return FALSE;
+            /* The scanner only takes this for a comment if it ends in a newline */
+            if (!eol)
+                return FALSE;
+        } else if ((h = offset_digits(s, line_end)) != 0) {
+            guint32 offset = 0;
+            gsize i;
+
+            for (i = 0; i < h; i++)
+                offset = (offset << 4) | g_ascii_xdigit_value(s[i]);
+
+            if (offset == 0) {
+                hexdump_event_t ev = { HEXDUMP_PACKET, chunk->bytes->len, 0 };
+
+                end_packet(chunk, packet_idx);
+                packet_idx = chunk->events->len;
+                g_array_append_val(chunk->events, ev);
+                packet_start = chunk->bytes->len;
+                total = peak = 0;
+                text_in_packet = FALSE;
+            } else if (packet_idx < 0 || text_in_packet) {
+                return FALSE;
+            } else if (offset != total) {
+                /* Once the packet has been split, the scanner's notion of
+                 * the current position is relative to the split. */
+                if (offset > total || peak >= chunk->max_frame_length)
+                    return FALSE;
+                g_byte_array_set_size(chunk->bytes, packet_start + offset);
+                total = offset;
+            }
+
+            total += decode_bytes(chunk->bytes, s + h + 1, content_end);
+            peak = MAX(peak, total);
+        } else {
+            const guchar *tok = s;
+
+            while (tok < line_end) {
+                const guchar *tok_end = tok;
+                hexdump_event_t ev = { HEXDUMP_TEXT, chunk->text->len, 0 };
+
+                while (tok_end < line_end && !is_blank(*tok_end))
+                    tok_end++;
+                /* A lone "\r" is part of the line ending */
+                if (!(tok_end - tok == 1 && *tok == '\r')) {
+                    if (!token_is_text(tok, tok_end - tok))
+                        return FALSE;
+                    g_byte_array_append(chunk->text, tok, (guint)(tok_end - tok));
+                    g_byte_array_append(chunk->text, (const guint8 *)"", 1);
+                    g_array_append_val(chunk->events, ev);
+                    if (packet_idx >= 0)
+                        text_in_packet = TRUE;
+                }
+                tok = tok_end;
+                while (tok < line_end && is_blank(*tok))
+                    tok++;
+            }
+        }
+
+        p = eol ? eol + 1 : end;
+    }
+
+    end_packet(chunk, packet_idx);
+    return TRUE;
+}
+
+static void
+decode_chunk_job(gpointer data, gpointer user_data _U_)
+{
+    hexdump_chunk_t *chunk = (hexdump_chunk_t *)data;
+    gboolean ok = decode_chunk(chunk);
+
+    g_mutex_lock(&chunks_mutex);
+    chunk->ok = ok;
+    chunk->done = TRUE;
+    g_cond_broadcast(&chunks_cond);
+    g_mutex_unlock(&chunks_mutex);
+}
+
+static void
+free_chunk(hexdump_chunk_t *chunk)
+{
+    g_byte_array_free(chunk->input, TRUE);
+    g_array_free(chunk->events, TRUE);
+    g_byte_array_free(chunk->bytes, TRUE);
+    g_byte_array_free(chunk->text, TRUE);
+    g_free(chunk);
+}
+
+/*
+ * Return the position of the last line in the buffer that starts a packet,
+ * or 0 if there is none. Only complete lines are considered.
+ */
+static guint
+find_last_packet_start(const guchar *data, guint len)
+{
+    const guchar *end = data + len;
+    guint i;
+
+    for (i = len; i > 0; i--) {
+        const guchar *s = data + i;
+        const guchar *line_end;
+        gsize h, j;
+
+        if (data[i - 1] != '\n')
+            continue;
+        line_end = (const guchar *)memchr(s, '\n', end - s);
+        if (!line_end)
+            continue;
+        while (s < line_end && is_blank(*s))
+            s++;
+        h = offset_digits(s, line_end);
+        for (j = 0; j < h && s[j] == '0'; j++)
+            ;
+        if (h != 0 && j == h)
+            return i;
+    }
+    return 0;
+}
+
+/*
+ * Read the next chunk, which ends where the last packet that starts in it
+ * begins, or at the end of the input. The remainder is kept in pending.
+ */
+static hexdump_chunk_t *
+read_chunk(FILE *fp, GByteArray **pending, gboolean *eof, gint64 *file_offset,
+           guint32 max_frame_length, gboolean *err)
+{
+    GByteArray *buf = *pending;
+    guint want = HEXDUMP_CHUNK_SIZE;
+    guint split;
+    hexdump_chunk_t *chunk;
+
+    for (;;) {
+        while (!*eof && buf->len < want) {
+            guint old_len = buf->len;
+            size_t nread;
+
+            g_byte_array_set_size(buf, want);
+            nread = fread(buf->data + old_len, 1, want - old_len, fp);
+            g_byte_array_set_size(buf, old_len + (guint)nread);
+            if (nread < want - old_len) {
+                if (ferror(fp)) {
+                    report_failure("Error reading input: %s", g_strerror(errno));
+                    *err = TRUE;
+                    return NULL;
+                }
+                *eof = TRUE;
+            }
+        }
+        if (*eof) {
+            split = buf->len;
+            break;
+        }
+        split = find_last_packet_start(buf->data, buf->len);
+        if (split > 0)
+            break;
+        /* One huge packet, or no packets at all */
+        want *= 2;
+    }
+
+    if (split == 0)
+        return NULL;
+
+    *pending = g_byte_array_sized_new(HEXDUMP_CHUNK_SIZE);
+    g_byte_array_append(*pending, buf->data + split, buf->len - split);
+    g_byte_array_set_size(buf, split);
+
+    chunk = g_new0(hexdump_chunk_t, 1);
+    chunk->input = buf;
+    chunk->file_offset = *file_offset;
+    chunk->max_frame_length = max_frame_length;
+    chunk->events = g_array_new(FALSE, FALSE, sizeof(hexdump_event_t));
+    chunk->bytes = g_byte_array_sized_new(split / 3);
+    chunk->text = g_byte_array_new();
+    *file_offset += split;
+    return chunk;
+}
+
+static import_status_t
+replay_chunk(hexdump_chunk_t *chunk, text_import_hexdump_text_cb text_cb,
+             text_import_hexdump_packet_cb packet_cb)
+{
+    guint i;
+
+    for (i = 0; i < chunk->events->len; i++) {
+        hexdump_event_t *ev = &g_array_index(chunk->events, hexdump_event_t, i);
+        import_status_t status;
+
+        if (ev->type == HEXDUMP_TEXT)
+            status = text_cb((char *)chunk->text->data + ev->offset);
+        else
+            status = packet_cb(chunk->bytes->data + ev->offset, ev->len);
+        if (status != IMPORT_SUCCESS)
+            return status;
+    }
+    return IMPORT_SUCCESS;
+}
+
+import_status_t
+text_import_hexdump(FILE *fp, guint32 max_frame_length,
+                    text_import_hexdump_text_cb text_cb,
+                    text_import_hexdump_packet_cb packet_cb,
+                    gint64 *fallback_offset)
+{
+    GThreadPool *pool = NULL;
+    GQueue *chunks = g_queue_new();
+    GByteArray *pending = g_byte_array_sized_new(HEXDUMP_CHUNK_SIZE);
+    gint64 file_offset = ws_ftell64(fp);
+    gboolean eof = FALSE;
+    gboolean err = FALSE;
+    import_status_t status = IMPORT_SUCCESS;
+    int num_threads = (int) g_get_num_processors();
+    hexdump_chunk_t *chunk;
+
+    *fallback_offset = -1;
+
+    if (num_threads > 1) {
+        pool = g_thread_pool_new(decode_chunk_job, NULL, num_threads, TRUE, NULL);
+    }
+
+    for (;;) {
+        /* Limit how much decoded input is held waiting to be written. */
+        while (!eof && (int) g_queue_get_length(chunks) < 2 * num_threads) {
+            chunk = read_chunk(fp, &pending, &eof, &file_offset, max_frame_length, &err);
+            if (!chunk)
+                break;
+            g_queue_push_tail(chunks, chunk);
+            if (pool) {
+                g_thread_pool_push(pool, chunk, NULL);
+            }
+        }
+        if (err) {
+            status = IMPORT_FAILURE;
+            break;
+        }
+
+        chunk = (hexdump_chunk_t *)g_queue_pop_head(chunks);
+        if (!chunk)
+            break;
+
+        if (pool) {
+            g_mutex_lock(&chunks_mutex);
+            while (!chunk->done) {
+                g_cond_wait(&chunks_cond, &chunks_mutex);
+            }
+            g_mutex_unlock(&chunks_mutex);
+        } else {
+            decode_chunk_job(chunk, NULL);
+        }
+
+        if (!chunk->ok) {
+            *fallback_offset = chunk->file_offset;
+            free_chunk(chunk);
+            break;
+        }
+        status = replay_chunk(chunk, text_cb, packet_cb);
+        free_chunk(chunk);
+        if (status != IMPORT_SUCCESS)
+            break;
+    }
+
+    if (pool) {
+        /* Let the chunks that are already queued finish */
+        g_thread_pool_free(pool, FALSE, TRUE);
+    }
+    while ((chunk = (hexdump_chunk_t *)g_queue_pop_head(chunks)) != NULL) {
+        free_chunk(chunk);
+    }
+    g_queue_free(chunks);
+    g_byte_array_free(pending, TRUE);
+
+    return status;
+}
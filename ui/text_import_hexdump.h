@@ -0,0 +1,60 @@
+/** @file
+ *
+ * text_import_hexdump.h
+ * Parallel importer for offset-prefixed hexdumps
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __TEXT_IMPORT_HEXDUMP_H__
+#define __TEXT_IMPORT_HEXDUMP_H__
+
+#include <stdio.h>
+
+#include <glib.h>
+
+#include "text_import_scanner.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Called with each preamble token, in input order. */
+typedef import_status_t (*text_import_hexdump_text_cb)(char *str);
+
+/** Called with the bytes of each packet found, in input order. */
+typedef import_status_t (*text_import_hexdump_packet_cb)(const guint8 *data, guint32 len);
+
+/**
+ * Import a hexdump with hexadecimal offsets, splitting it at packet
+ * boundaries into chunks that are decoded in parallel. The callbacks
+ * are invoked from the calling thread in input order.
+ *
+ * Only the common layout is handled: offset lines, byte values
+ * separated by blanks, free text and comments. When a chunk contains
+ * anything else, nothing from that chunk onwards is passed to the
+ * callbacks and its position in the file is returned so that the
+ * scanner can continue from there.
+ *
+ * @param fp The input, which must be seekable.
+ * @param max_frame_length The length at which the caller splits packets.
+ * @param text_cb Called for preamble tokens.
+ * @param packet_cb Called for packets.
+ * @param[out] fallback_offset -1 if the whole input was imported,
+ * otherwise the file offset from which the scanner must continue.
+ * @return IMPORT_SUCCESS, or IMPORT_FAILURE on a read or callback error.
+ */
+import_status_t text_import_hexdump(FILE *fp, guint32 max_frame_length,
+                                    text_import_hexdump_text_cb text_cb,
+                                    text_import_hexdump_packet_cb packet_cb,
+                                    gint64 *fallback_offset);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __TEXT_IMPORT_HEXDUMP_H__ */
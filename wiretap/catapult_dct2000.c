@@ -58,6 +58,10 @@ typedef struct dct2000_file_externals
     time_t  start_secs;
     guint32 start_usecs;
 
+    /* Line being parsed by read/seek_read; kept per file so that
+       different files can be read from different threads. */
+    gchar linebuff[MAX_LINE_LENGTH+1];
+
     /*
      * The following information is needed only for dumping.
      *
@@ -352,7 +356,7 @@ catapult_dct2000_read(wtap *wth, wtap_rec *rec, Buffer *buf,
         int is_comment = FALSE;
         int is_sprint = FALSE;
         gint64 this_offset;
-        static gchar linebuff[MAX_LINE_LENGTH+1];
+        gchar *linebuff = file_externals->linebuff;
         gchar aal_header_chars[AAL_HEADER_CHARS];
         gchar context_name[MAX_CONTEXT_NAME];
         guint8 context_port = 0;
@@ -365,7 +369,7 @@ catapult_dct2000_read(wtap *wth, wtap_rec *rec, Buffer *buf,
 
         /* Read a new line from file into linebuff */
         if (!read_new_line(wth->fh, &line_length, linebuff,
-                           sizeof linebuff, err, err_info)) {
+                           sizeof file_externals->linebuff, err, err_info)) {
             if (*err != 0) {
                 return FALSE;  /* error */
             }
@@ -441,7 +445,7 @@ catapult_dct2000_seek_read(wtap *wth, gint64 seek_off,
 {
     int length;
     long dollar_offset, before_time_offset, after_time_offset;
-    static gchar linebuff[MAX_LINE_LENGTH+1];
+    gchar *linebuff;
     gchar aal_header_chars[AAL_HEADER_CHARS];
     gchar context_name[MAX_CONTEXT_NAME];
     guint8 context_port = 0;
@@ -457,6 +461,7 @@ catapult_dct2000_seek_read(wtap *wth, gint64 seek_off,
     /* Get wtap external structure for this wtap */
     dct2000_file_externals_t *file_externals =
         (dct2000_file_externals_t*)wth->priv;
+    linebuff = file_externals->linebuff;
 
     /* Reset errno */
     *err = errno = 0;
@@ -468,7 +473,7 @@ catapult_dct2000_seek_read(wtap *wth, gint64 seek_off,
 
     /* Re-read whole line (this really should succeed) */
     if (!read_new_line(wth->random_fh, &length, linebuff,
-                      sizeof linebuff, err, err_info)) {
+                      sizeof file_externals->linebuff, err, err_info)) {
         return FALSE;
     }
 
@@ -22,14 +22,20 @@ void register_eri_enb_log(void);
 
 #define MAX_LINE_LENGTH            131072
 
-static gboolean eri_enb_log_get_packet(FILE_T fh, wtap_rec* rec,
-	Buffer* buf, int* err _U_, gchar** err_info _U_)
+/* Per-file line buffer, so that different files can be read from
+   different threads. */
+typedef struct {
+	char line[MAX_LINE_LENGTH];
+} eri_enb_log_t;
+
+static gboolean eri_enb_log_get_packet(eri_enb_log_t *eri_enb_log, FILE_T fh,
+	wtap_rec* rec, Buffer* buf, int* err _U_, gchar** err_info _U_)
 {
-	static char line[MAX_LINE_LENGTH];
+	char *line = eri_enb_log->line;
 	/* Read in a line */
 	gint64 pos_before = file_tell(fh);
 
-	while (file_gets(line, sizeof(line), fh) != NULL)
+	while (file_gets(line, sizeof(eri_enb_log->line), fh) != NULL)
 	{
 		nstime_t packet_time;
 		gint length;
@@ -80,7 +86,8 @@ static gboolean eri_enb_log_read(wtap* wth, wtap_rec* rec, Buffer* buf,
 {
 	*data_offset = file_tell(wth->fh);
 
-	return eri_enb_log_get_packet(wth->fh, rec, buf, err, err_info);
+	return eri_enb_log_get_packet((eri_enb_log_t *)wth->priv, wth->fh,
+	    rec, buf, err, err_info);
 }
 
 /* Used to read packets in random-access fashion */
@@ -92,7 +99,8 @@ static gboolean eri_enb_log_seek_read(wtap* wth, gint64 seek_off,
 		return FALSE;
 	}
 
-	return eri_enb_log_get_packet(wth->random_fh, rec, buf, err, err_info);
+	return eri_enb_log_get_packet((eri_enb_log_t *)wth->priv, wth->random_fh,
+	    rec, buf, err, err_info);
 }
 
 wtap_open_return_val
@@ -117,6 +125,7 @@ eri_enb_log_open(wtap *wth, int *err, gchar **err_info)
 	if (file_seek(wth->fh, 0, SEEK_SET, err) == -1)
 		return WTAP_OPEN_ERROR;
 
+	wth->priv = g_new(eri_enb_log_t, 1);
 	wth->file_type_subtype = eri_enb_log_file_type_subtype;
 	wth->file_encap = WTAP_ENCAP_ERI_ENB_LOG;
 	wth->file_tsprec = WTAP_TSPREC_NSEC;
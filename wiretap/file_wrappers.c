@@ -203,6 +203,9 @@ struct wtap_reader {
 #ifdef USE_LZ4
     LZ4F_dctx *lz4_dctx;
 #endif
+    /* observer of the raw data read from the file */
+    wtap_raw_data_callback_t raw_data_cb;
+    void *raw_data_cb_data;
 };
 
 /* Current read offset within a buffer. */
@@ -274,6 +277,8 @@ buf_read(FILE_T state, struct wtap_reader_buf *buf)
     }
     if (ret == 0)
         state->eof = TRUE;
+    else if (state->raw_data_cb)
+        state->raw_data_cb(state->raw_pos, read_ptr, (size_t)ret, state->raw_data_cb_data);
     state->raw_pos += ret;
     buf->avail += (guint)ret;
     return 0;
@@ -1593,6 +1598,13 @@ file_tell_raw(FILE_T stream)
     return stream->raw_pos;
 }
 
+void
+file_set_raw_data_callback(FILE_T stream, wtap_raw_data_callback_t cb, void *user_data)
+{
+    stream->raw_data_cb = cb;
+    stream->raw_data_cb_data = user_data;
+}
+
 int
 file_fstat(FILE_T stream, ws_statb64 *statb, int *err)
 {
@@ -42,9 +42,17 @@ typedef enum packet_direction_t
 typedef struct {
     time_t	start_secs;
     guint32	start_usecs;
+    gint	first_packet_offset;
+
+    /* Transient data used while parsing a line; kept per file so that
+       different files can be read from different threads. */
+    gchar	linebuff[MAX_LINE_LENGTH + 1];
+    /* Protocol name of the packet that the packet was captured at */
+    gchar	protocol_name[MAX_PROTOCOL_NAME+1];
+    /* Optional string parameter giving info required for the protocol dissector */
+    gchar	protocol_parameters[MAX_PROTOCOL_PAR_STRING+1];
 } log3gpp_t;
 
-gint first_packet_offset;
 gchar firstline[MAX_FIRST_LINE_LENGTH];
 gchar secondline[MAX_TIMESTAMP_LINE_LENGTH];
 gint secondline_length = 0;
@@ -54,12 +62,6 @@ gint secondline_length = 0;
 
 /* 'Magic number' at start of 3gpp log files. */
 static const gchar log3gpp_magic[] = "3GPP protocols transcript";
-
-/* Protocol name of the packet that the packet was captured at */
-static gchar protocol_name[MAX_PROTOCOL_NAME+1];
-
-/* Optional string parameter giving info required for the protocol dissector */
-static gchar protocol_parameters[MAX_PROTOCOL_PAR_STRING+1];
 /************************************************************/
 /* Functions called from wiretap core                       */
 static gboolean log3gpp_read( wtap* wth, wtap_rec* rec, Buffer* buf,
@@ -75,12 +77,12 @@ static gboolean read_new_line(FILE_T fh, gint* length,
     gchar* buf, size_t bufsize, int* err,
     gchar** err_info);
 
-static gboolean parse_line(char* linebuff, gint line_length, gint *seconds, gint *useconds,
+static gboolean parse_line(log3gpp_t *log3gpp, gint line_length, gint *seconds, gint *useconds,
                            long *data_offset,
                            gint *data_chars,
                            packet_direction_t *direction,
                            gboolean *is_text_data);
-static int write_stub_header(guchar *frame_buffer, char *timestamp_string,
+static int write_stub_header(log3gpp_t *log3gpp, guchar *frame_buffer, char *timestamp_string,
                              packet_direction_t direction);
 static guchar hex_from_char(gchar c);
 /*not used static gchar char_from_hex(guchar hex);*/
@@ -116,6 +118,7 @@ log3gpp_open(wtap *wth, int *err, gchar **err_info _U_)
     /* Buffer to hold a single text line read from the file */
     static gchar linebuff[MAX_LINE_LENGTH];
     gint firstline_length = 0;
+    gint first_packet_offset;
 
     /* Clear errno before reading from the file */
     errno = 0;
@@ -175,6 +178,7 @@ log3gpp_open(wtap *wth, int *err, gchar **err_info _U_)
     log3gpp = g_new(log3gpp_t, 1);
     log3gpp->start_secs = timestamp;
     log3gpp->start_usecs = usecs;
+    log3gpp->first_packet_offset = first_packet_offset;
     wth->priv = (void *)log3gpp;
 
     /************************************************************/
@@ -218,11 +222,11 @@ gboolean log3gpp_read(wtap* wth, wtap_rec* rec, Buffer* buf,
     int* err, gchar** err_info, gint64* data_offset)
 {
     gint64 offset = file_tell(wth->fh);
-    static gchar linebuff[MAX_LINE_LENGTH + 1];
     long dollar_offset;
     packet_direction_t direction;
     gboolean is_text_data;
     log3gpp_t *log3gpp = (log3gpp_t *)wth->priv;
+    gchar *linebuff = log3gpp->linebuff;
 
     /* Search for a line containing a usable packet */
     while (1)
@@ -233,7 +237,7 @@ gboolean log3gpp_read(wtap* wth, wtap_rec* rec, Buffer* buf,
         /* Are looking for first packet after 2nd line */
         if (file_tell(wth->fh) == 0)
         {
-            this_offset += (gint64)first_packet_offset +1+1;
+            this_offset += (gint64)log3gpp->first_packet_offset +1+1;
         }
 
         /* Clear errno before reading from the file */
@@ -241,7 +245,7 @@ gboolean log3gpp_read(wtap* wth, wtap_rec* rec, Buffer* buf,
 
         /* Read a new line from file into linebuff */
         if (!read_new_line(wth->fh, &line_length, linebuff,
-            sizeof linebuff, err, err_info)) {
+            sizeof log3gpp->linebuff, err, err_info)) {
             if (*err != 0) {
                 return FALSE;  /* error */
             }
@@ -250,7 +254,7 @@ gboolean log3gpp_read(wtap* wth, wtap_rec* rec, Buffer* buf,
         }
 
         /* Try to parse the line as a frame record */
-        if (parse_line(linebuff, line_length, &seconds, &useconds,
+        if (parse_line(log3gpp, line_length, &seconds, &useconds,
                        &dollar_offset,
                        &data_chars,
                        &direction,
@@ -289,14 +293,14 @@ gboolean log3gpp_read(wtap* wth, wtap_rec* rec, Buffer* buf,
               /* Get buffer pointer ready */
               ws_buffer_assure_space(buf,
                                   strlen(timestamp_string)+1 + /* timestamp */
-                                  strlen(protocol_name)+1 +    /* Protocol name */
+                                  strlen(log3gpp->protocol_name)+1 +    /* Protocol name */
                                   1 +                          /* direction */
                                   (size_t)(data_chars/2));
 
               frame_buffer = ws_buffer_start_ptr(buf);
               /*********************/
               /* Write stub header */
-              stub_offset = write_stub_header(frame_buffer, timestamp_string,
+              stub_offset = write_stub_header(log3gpp, frame_buffer, timestamp_string,
                                               direction);
 
               /* Binary data length is half bytestring length + stub header */
@@ -317,14 +321,14 @@ gboolean log3gpp_read(wtap* wth, wtap_rec* rec, Buffer* buf,
               /* Get buffer pointer ready */
               ws_buffer_assure_space(buf,
                                   strlen(timestamp_string)+1 + /* timestamp */
-                                  strlen(protocol_name)+1 +    /* Protocol name */
+                                  strlen(log3gpp->protocol_name)+1 +    /* Protocol name */
                                   1 +                          /* direction */
                                   data_chars);
               frame_buffer = ws_buffer_start_ptr(buf);
 
               /*********************/
               /* Write stub header */
-              stub_offset = write_stub_header(frame_buffer, timestamp_string,
+              stub_offset = write_stub_header(log3gpp, frame_buffer, timestamp_string,
                                               direction);
 
               /* Binary data length is bytestring length + stub header */
@@ -355,11 +359,11 @@ log3gpp_seek_read(wtap *wth, gint64 seek_off,
                     int *err, gchar **err_info)
 {
     long dollar_offset;
-    static gchar linebuff[MAX_LINE_LENGTH + 1];
     packet_direction_t direction;
     int seconds, useconds, data_chars;
     gboolean is_text_data;
     log3gpp_t* log3gpp = (log3gpp_t*)wth->priv;
+    gchar *linebuff = log3gpp->linebuff;
     int length = 0;
     guchar *frame_buffer;
 
@@ -374,12 +378,12 @@ log3gpp_seek_read(wtap *wth, gint64 seek_off,
 
     /* Re-read whole line (this really should succeed) */
     if (!read_new_line(wth->random_fh, &length, linebuff,
-        sizeof linebuff, err, err_info)) {
+        sizeof log3gpp->linebuff, err, err_info)) {
         return FALSE;
     }
 
     /* Try to parse this line again (should succeed as re-reading...) */
-    if (parse_line(linebuff, length, &seconds, &useconds,
+    if (parse_line(log3gpp, length, &seconds, &useconds,
                    &dollar_offset,
                    &data_chars,
                    &direction,
@@ -409,11 +413,11 @@ log3gpp_seek_read(wtap *wth, gint64 seek_off,
         /* Write stub header */
         ws_buffer_assure_space(buf,
                                strlen(timestamp_string)+1 + /* timestamp */
-                               strlen(protocol_name)+1 +    /* Protocol name */
+                               strlen(log3gpp->protocol_name)+1 +    /* Protocol name */
                                1 +                          /* direction */
                                data_chars);
         frame_buffer = ws_buffer_start_ptr(buf);
-        stub_offset = write_stub_header(frame_buffer, timestamp_string,
+        stub_offset = write_stub_header(log3gpp, frame_buffer, timestamp_string,
                                         direction);
 
         if (!is_text_data)
@@ -452,7 +456,7 @@ log3gpp_seek_read(wtap *wth, gint64 seek_off,
 
 /**********************************************************************/
 /* Read a new line from the file, starting at offset.                 */
-/* - writes data to static var linebuff                               */
+/* - writes data to the caller's linebuff                             */
 /* - on return 'offset' will point to the next position to read from  */
 /* - return TRUE if this read is successful                           */
 /**********************************************************************/
@@ -493,11 +497,14 @@ read_new_line(FILE_T fh, gint* length,
 /* - data position and length                                         */
 /* Return TRUE if this packet looks valid and can be displayed        */
 /**********************************************************************/
-gboolean parse_line(gchar* linebuff, gint line_length, gint *seconds, gint *useconds,
+gboolean parse_line(log3gpp_t *log3gpp, gint line_length, gint *seconds, gint *useconds,
                     long *data_offset, gint *data_chars,
                     packet_direction_t *direction,
                     gboolean *is_text_data)
 {
+    gchar *linebuff = log3gpp->linebuff;
+    gchar *protocol_name = log3gpp->protocol_name;
+    gchar *protocol_parameters = log3gpp->protocol_parameters;
     int  n = 0;
     int  protocol_chars = 0;
     int  prot_option_chars = 0;
@@ -678,7 +685,7 @@ gboolean parse_line(gchar* linebuff, gint line_length, gint *seconds, gint *usec
 /*****************************************************************/
 /* Write the stub info to the data buffer while reading a packet */
 /*****************************************************************/
-int write_stub_header(guchar *frame_buffer, char *timestamp_string,
+int write_stub_header(log3gpp_t *log3gpp, guchar *frame_buffer, char *timestamp_string,
                       packet_direction_t direction)
 {
     int stub_offset = 0;
@@ -688,16 +695,16 @@ int write_stub_header(guchar *frame_buffer, char *timestamp_string,
     stub_offset += (int)(strlen(timestamp_string) + 1);
 
     /* Protocol name */
-    (void) g_strlcpy((char*)&frame_buffer[stub_offset], protocol_name, MAX_PROTOCOL_NAME+1);
-    stub_offset += (int)(strlen(protocol_name) + 1);
+    (void) g_strlcpy((char*)&frame_buffer[stub_offset], log3gpp->protocol_name, MAX_PROTOCOL_NAME+1);
+    stub_offset += (int)(strlen(log3gpp->protocol_name) + 1);
 
     /* Direction */
     frame_buffer[stub_offset] = direction;
     stub_offset++;
 
     /* Option string (might be string of length 0) */
-    (void) g_strlcpy((char*)&frame_buffer[stub_offset], protocol_parameters,MAX_PROTOCOL_PAR_STRING+1);
-    stub_offset += (int)(strlen(protocol_parameters) + 1);
+    (void) g_strlcpy((char*)&frame_buffer[stub_offset], log3gpp->protocol_parameters,MAX_PROTOCOL_PAR_STRING+1);
+    stub_offset += (int)(strlen(log3gpp->protocol_parameters) + 1);
     return stub_offset;
 }
 
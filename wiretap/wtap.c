@@ -1643,6 +1643,13 @@ void wtap_set_cb_new_secrets(wtap *wth, wtap_new_secrets_callback_t add_new_secr
 	}
 }
 
+void wtap_set_cb_raw_data(wtap *wth, wtap_raw_data_callback_t cb, void *user_data) {
+	if (!wth || !wth->fh)
+		return;
+
+	file_set_raw_data_callback(wth->fh, cb, user_data);
+}
+
 void
 wtapng_process_dsb(wtap *wth, wtap_block_t dsb)
 {
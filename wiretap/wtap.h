@@ -1852,6 +1852,17 @@ typedef void (*wtap_new_sysdig_meta_event_callback_t)(uint32_t mev_type, const u
 WS_DLL_PUBLIC
 void wtap_set_cb_new_sysdig_meta_event(wtap *wth, wtap_new_sysdig_meta_event_callback_t add_new_sysdig_meta_event);
 
+/**
+ * Set callback function to see the raw (still compressed, if the file is)
+ * bytes of the file as the sequential reader reads them from disk.
+ * Bytes read before the callback was set aren't passed, a range is
+ * passed again if the reader seeks back over it, and a range the
+ * reader seeks past is never passed.
+ */
+typedef void (*wtap_raw_data_callback_t)(gint64 offset, const guint8 *data, size_t len, void *user_data);
+WS_DLL_PUBLIC
+void wtap_set_cb_raw_data(wtap *wth, wtap_raw_data_callback_t cb, void *user_data);
+
 /** Read the next record in the file, filling in *phdr and *buf.
  *
  * @wth a wtap * returned by a call that opened a file for reading.
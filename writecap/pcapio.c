@@ -26,6 +26,7 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#define _GNU_SOURCE     /* O_DIRECT */
 #include <config.h>
 
 #include <stdbool.h>
@@ -39,11 +40,17 @@
 #endif
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #endif
 
 #include <glib.h>
 
 #include <wsutil/epochs.h>
+#include <wsutil/file_util.h>
 
 #include "pcapio.h"
 
@@ -169,16 +176,438 @@ struct ws_option {
 #define ISB_USRDELIV      8
 #define ADD_PADDING(x) ((((x) + 3) >> 2) << 2)
 
+/*
+ * Output writers.
+ *
+ * A stdio writer hands every piece of a record to fwrite().
+ *
+ * A segment writer copies records into a ring of page-aligned segments
+ * and has a thread write the full ones, as many as are waiting in one
+ * writev() or pwritev() call, while the next one is filled. Records are
+ * only copied, so writing one never waits for the output unless all of
+ * the segments are waiting to be written. With PCAPIO_WRITER_DIRECT,
+ * a regular file on Linux is written with O_DIRECT, bypassing the page
+ * cache; that needs each write to be a multiple of the page size at a
+ * page-aligned offset, so a flush writes the last partial page without
+ * O_DIRECT and keeps it to be written again, whole, later.
+ */
+#define PCAPIO_WRITER_SEGMENTS  4
+
+struct pcapio_writer {
+        FILE     *file;                 /* stdio writer, or NULL */
+        char     *io_buffer;            /* stdio buffer we allocated, if any */
+#ifndef _WIN32
+        int       fd;
+        bool      seekable;             /* Written with pwritev() at offsets */
+        bool      direct;               /* Opened with O_DIRECT */
+        size_t    align;                /* Page size */
+        size_t    segment_size;
+        uint8_t  *segs[PCAPIO_WRITER_SEGMENTS];
+        size_t    seg_len[PCAPIO_WRITER_SEGMENTS];
+        unsigned  fill;                 /* Segment being filled */
+        size_t    fill_len;
+        int64_t   pending_since;        /* When data was first put in the segment being filled, or 0 */
+        int64_t   flush_latency;        /* In microseconds */
+
+        /* Shared with the writer thread */
+        GThread  *thread;
+        GMutex    mutex;
+        GCond     cond;
+        unsigned  first_queued;         /* Oldest segment waiting to be written */
+        unsigned  queued;               /* Segments waiting or being written */
+        uint64_t  offset;               /* File offset of first_queued */
+        bool      stop;
+        int       err;                  /* First write error; writes fail after it */
+#endif
+};
+
+pcapio_writer_t *
+pcapio_writer_stdio(FILE *pfile)
+{
+        pcapio_writer_t *w = g_new0(pcapio_writer_t, 1);
+
+        w->file = pfile;
+#ifndef _WIN32
+        w->fd = -1;
+#endif
+        return w;
+}
+
+#ifndef _WIN32
+/* Write all of a list of buffers, at an offset if the file is seekable. */
+static bool
+writer_write_iov(pcapio_writer_t *w, struct iovec *iov, int iovcnt,
+                 uint64_t offset, int *err)
+{
+        ssize_t nwritten;
+
+        while (iovcnt > 0) {
+#ifdef HAVE_PWRITEV
+                if (w->seekable)
+                        nwritten = pwritev(w->fd, iov, iovcnt, (off_t)offset);
+                else
+#endif
+                        nwritten = writev(w->fd, iov, iovcnt);
+                if (nwritten < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        *err = errno;
+                        return false;
+                }
+                if (nwritten == 0) {
+                        *err = 0;
+                        return false;
+                }
+                offset += (uint64_t)nwritten;
+                /* Skip what was written, for a short write. */
+                while (iovcnt > 0 && (size_t)nwritten >= iov->iov_len) {
+                        nwritten -= iov->iov_len;
+                        iov++;
+                        iovcnt--;
+                }
+                if (iovcnt > 0) {
+                        iov->iov_base = (uint8_t *)iov->iov_base + nwritten;
+                        iov->iov_len -= nwritten;
+                }
+        }
+        return true;
+}
+
+static gpointer
+writer_thread(gpointer data)
+{
+        pcapio_writer_t *w = (pcapio_writer_t *)data;
+        struct iovec iov[PCAPIO_WRITER_SEGMENTS];
+        unsigned first, count, i;
+        uint64_t offset, total;
+        int err = 0;
+        bool ok;
+
+        g_mutex_lock(&w->mutex);
+        for (;;) {
+                while (w->queued == 0 && !w->stop)
+                        g_cond_wait(&w->cond, &w->mutex);
+                if (w->queued == 0)
+                        break;
+
+                /* Write every segment that's waiting. */
+                first = w->first_queued;
+                count = w->queued;
+                offset = w->offset;
+                total = 0;
+                for (i = 0; i < count; i++) {
+                        unsigned seg = (first + i) % PCAPIO_WRITER_SEGMENTS;
+
+                        iov[i].iov_base = w->segs[seg];
+                        iov[i].iov_len = w->seg_len[seg];
+                        total += w->seg_len[seg];
+                }
+                g_mutex_unlock(&w->mutex);
+
+                ok = g_atomic_int_get(&w->err) != 0 ||
+                     writer_write_iov(w, iov, (int)count, offset, &err);
+
+                g_mutex_lock(&w->mutex);
+                if (!ok && w->err == 0)
+                        g_atomic_int_set(&w->err, err ? err : EIO);
+                w->first_queued = (first + count) % PCAPIO_WRITER_SEGMENTS;
+                w->queued -= count;
+                w->offset += total;
+                g_cond_broadcast(&w->cond);
+        }
+        g_mutex_unlock(&w->mutex);
+        return NULL;
+}
+
+/*
+ * Queue the first len bytes of the segment being filled for writing, and
+ * move on to the next segment, waiting for it to be written if need be.
+ */
+static void
+writer_queue_fill(pcapio_writer_t *w, size_t len)
+{
+        g_mutex_lock(&w->mutex);
+        w->seg_len[w->fill] = len;
+        w->queued++;
+        g_cond_broadcast(&w->cond);
+        while (w->queued == PCAPIO_WRITER_SEGMENTS)
+                g_cond_wait(&w->cond, &w->mutex);
+        g_mutex_unlock(&w->mutex);
+        w->fill = (w->fill + 1) % PCAPIO_WRITER_SEGMENTS;
+        w->fill_len = 0;
+        w->pending_since = 0;
+}
+
+/* Wait for every queued segment to be written. */
+static bool
+writer_wait_idle(pcapio_writer_t *w, int *err)
+{
+        int write_err;
+
+        g_mutex_lock(&w->mutex);
+        while (w->queued > 0)
+                g_cond_wait(&w->cond, &w->mutex);
+        write_err = w->err;
+        g_mutex_unlock(&w->mutex);
+        if (write_err != 0) {
+                *err = write_err;
+                return false;
+        }
+        return true;
+}
+
+static bool
+writer_append(pcapio_writer_t *w, const uint8_t *data, size_t data_length, int *err)
+{
+        size_t n;
+
+        if (g_atomic_int_get(&w->err) != 0) {
+                *err = g_atomic_int_get(&w->err);
+                return false;
+        }
+        while (data_length > 0) {
+                n = MIN(data_length, w->segment_size - w->fill_len);
+                memcpy(w->segs[w->fill] + w->fill_len, data, n);
+                if (w->pending_since == 0)
+                        w->pending_since = g_get_monotonic_time();
+                w->fill_len += n;
+                data += n;
+                data_length -= n;
+                if (w->fill_len == w->segment_size)
+                        writer_queue_fill(w, w->segment_size);
+        }
+        return true;
+}
+
+/* Write the last partial page, which O_DIRECT can't, at offset. */
+static bool
+writer_write_direct_tail(pcapio_writer_t *w, const uint8_t *data, size_t len,
+                         uint64_t offset, int *err)
+{
+        struct iovec iov;
+        int flags = fcntl(w->fd, F_GETFL);
+        bool ok;
+
+        if (flags == -1 || fcntl(w->fd, F_SETFL, flags & ~O_DIRECT) == -1) {
+                *err = errno;
+                return false;
+        }
+        iov.iov_base = (void *)data;
+        iov.iov_len = len;
+        ok = writer_write_iov(w, &iov, 1, offset, err);
+        if (fcntl(w->fd, F_SETFL, flags) == -1 && ok) {
+                *err = errno;
+                ok = false;
+        }
+        return ok;
+}
+#endif /* _WIN32 */
+
+pcapio_writer_t *
+pcapio_writer_fdopen(int fd, size_t segment_size, unsigned flush_latency_ms,
+                     unsigned flags, int *err)
+{
+        pcapio_writer_t *w;
+#ifndef _WIN32
+        ws_statb64 statb;
+        bool have_stat = ws_fstat64(fd, &statb) == 0;
+        long page_size = sysconf(_SC_PAGESIZE);
+        unsigned i;
+
+        w = g_new0(pcapio_writer_t, 1);
+        w->fd = fd;
+        w->align = page_size > 0 ? (size_t)page_size : 4096;
+        if (segment_size == 0)
+                segment_size = PCAPIO_WRITER_DEFAULT_SEGMENT_SIZE;
+        w->segment_size = (segment_size + w->align - 1) & ~(w->align - 1);
+        w->flush_latency = (int64_t)flush_latency_ms * 1000;
+#ifdef HAVE_PWRITEV
+        /* pwritev() keeps what's written independent of the file offset,
+           which the O_DIRECT tail handling needs; start at the current one. */
+        if (have_stat && S_ISREG(statb.st_mode)) {
+                off_t offset = lseek(fd, 0, SEEK_CUR);
+
+                if (offset != (off_t)-1) {
+                        w->seekable = true;
+                        w->offset = (uint64_t)offset;
+                }
+        }
+#ifdef O_DIRECT
+        if ((flags & PCAPIO_WRITER_DIRECT) && w->seekable &&
+            (w->offset & (w->align - 1)) == 0) {
+                int fl = fcntl(fd, F_GETFL);
+
+                /* Not every file system supports it; carry on without. */
+                if (fl != -1 && fcntl(fd, F_SETFL, fl | O_DIRECT) == 0)
+                        w->direct = true;
+        }
+#endif
+#endif
+        for (i = 0; i < PCAPIO_WRITER_SEGMENTS; i++) {
+                if (posix_memalign((void **)&w->segs[i], w->align, w->segment_size) != 0) {
+                        *err = ENOMEM;
+                        while (i-- > 0)
+                                free(w->segs[i]);
+                        g_free(w);
+                        return NULL;
+                }
+        }
+        g_mutex_init(&w->mutex);
+        g_cond_init(&w->cond);
+        w->thread = g_thread_new("pcapio writer", writer_thread, w);
+        return w;
+#else
+        size_t buffsize = IO_BUF_SIZE;
+
+        /* No segment writer here; use stdio with a large buffer. */
+        (void)segment_size;
+        (void)flush_latency_ms;
+        (void)flags;
+        w = g_new0(pcapio_writer_t, 1);
+        w->file = ws_fdopen(fd, "wb");
+        if (w->file == NULL) {
+                *err = errno;
+                g_free(w);
+                return NULL;
+        }
+        w->io_buffer = (char *)g_malloc(buffsize);
+        setvbuf(w->file, w->io_buffer, _IOFBF, buffsize);
+        return w;
+#endif
+}
+
+bool
+pcapio_writer_flush(pcapio_writer_t *w, int *err)
+{
+        int dummy_err;
+
+        if (err == NULL)
+                err = &dummy_err;
+        if (w->file != NULL) {
+                if (fflush(w->file) == EOF) {
+                        *err = errno;
+                        return false;
+                }
+                return true;
+        }
+#ifndef _WIN32
+        {
+                size_t len = w->fill_len;
+                size_t tail = 0;
+                unsigned prev;
+
+                if (w->direct) {
+                        /* O_DIRECT writes whole pages only. */
+                        tail = len & (w->align - 1);
+                        len -= tail;
+                }
+                prev = w->fill;
+                if (len > 0)
+                        writer_queue_fill(w, len);
+                if (!writer_wait_idle(w, err))
+                        return false;
+                if (tail > 0) {
+                        /* Keep the partial page at the start of the next
+                           segment, to be written again when it's whole. */
+                        if (w->fill != prev)
+                                memcpy(w->segs[w->fill], w->segs[prev] + len, tail);
+                        w->fill_len = tail;
+                        if (!writer_write_direct_tail(w, w->segs[w->fill], tail, w->offset, err)) {
+                                g_atomic_int_set(&w->err, *err ? *err : EIO);
+                                return false;
+                        }
+                }
+                w->pending_since = 0;
+        }
+#endif
+        return true;
+}
+
+bool
+pcapio_writer_flush_if_due(pcapio_writer_t *w, int *err)
+{
+        if (w->file != NULL)
+                return true;
+#ifndef _WIN32
+        if (w->pending_since == 0 ||
+            g_get_monotonic_time() - w->pending_since < w->flush_latency)
+                return true;
+        if (w->direct) {
+                /* A partial page has to be written synchronously. */
+                return pcapio_writer_flush(w, err);
+        }
+        /* Have the thread write what we have, without waiting for it. */
+        writer_queue_fill(w, w->fill_len);
+        if (g_atomic_int_get(&w->err) != 0) {
+                *err = g_atomic_int_get(&w->err);
+                return false;
+        }
+#else
+        (void)err;
+#endif
+        return true;
+}
+
+bool
+pcapio_writer_close(pcapio_writer_t *w, int *err)
+{
+        bool ok = true;
+        int dummy_err;
+
+        if (err == NULL)
+                err = &dummy_err;
+        if (w->file != NULL) {
+                if (fclose(w->file) == EOF) {
+                        *err = errno;
+                        ok = false;
+                }
+                g_free(w->io_buffer);
+                g_free(w);
+                return ok;
+        }
+#ifndef _WIN32
+        {
+                unsigned i;
+
+                ok = pcapio_writer_flush(w, err);
+                g_mutex_lock(&w->mutex);
+                w->stop = true;
+                g_cond_broadcast(&w->cond);
+                g_mutex_unlock(&w->mutex);
+                g_thread_join(w->thread);
+                g_mutex_clear(&w->mutex);
+                g_cond_clear(&w->cond);
+                if (ws_close(w->fd) == -1 && ok) {
+                        *err = errno;
+                        ok = false;
+                }
+                for (i = 0; i < PCAPIO_WRITER_SEGMENTS; i++)
+                        free(w->segs[i]);
+                g_free(w);
+        }
+#endif
+        return ok;
+}
+
 /* Write to capture file */
 static bool
-write_to_file(FILE* pfile, const uint8_t* data, size_t data_length,
+write_to_file(pcapio_writer_t* pfile, const uint8_t* data, size_t data_length,
               uint64_t *bytes_written, int *err)
 {
         size_t nwritten;
 
-        nwritten = fwrite(data, data_length, 1, pfile);
+#ifndef _WIN32
+        if (pfile->file == NULL) {
+                if (!writer_append(pfile, data, data_length, err))
+                        return false;
+                (*bytes_written) += data_length;
+                return true;
+        }
+#endif
+
+        nwritten = fwrite(data, data_length, 1, pfile->file);
         if (nwritten != 1) {
-                if (ferror(pfile)) {
+                if (ferror(pfile->file)) {
                         *err = errno;
                 } else {
                         *err = 0;
@@ -196,7 +625,7 @@ write_to_file(FILE* pfile, const uint8_t* data, size_t data_length,
    Returns true on success, false on failure.
    Sets "*err" to an error code, or 0 for a short write, on failure*/
 bool
-libpcap_write_file_header(FILE* pfile, int linktype, int snaplen, bool ts_nsecs, uint64_t *bytes_written, int *err)
+libpcap_write_file_header(pcapio_writer_t* pfile, int linktype, int snaplen, bool ts_nsecs, uint64_t *bytes_written, int *err)
 {
         struct pcap_hdr file_hdr;
 
@@ -215,7 +644,7 @@ libpcap_write_file_header(FILE* pfile, int linktype, int snaplen, bool ts_nsecs,
 /* Write a record for a packet to a dump file.
    Returns true on success, false on failure. */
 bool
-libpcap_write_packet(FILE* pfile,
+libpcap_write_packet(pcapio_writer_t* pfile,
                      time_t sec, uint32_t usec,
                      uint32_t caplen, uint32_t len,
                      const uint8_t *pd,
@@ -247,7 +676,7 @@ pcapng_count_string_option(const char *option_value)
 }
 
 static bool
-pcapng_write_string_option(FILE* pfile,
+pcapng_write_string_option(pcapio_writer_t* pfile,
                            uint16_t option_type, const char *option_value,
                            uint64_t *bytes_written, int *err)
 {
@@ -279,7 +708,7 @@ pcapng_write_string_option(FILE* pfile,
 
 /* Write a pre-formatted pcapng block directly to the output file */
 bool
-pcapng_write_block(FILE* pfile,
+pcapng_write_block(pcapio_writer_t* pfile,
                    const uint8_t *data,
                    uint32_t length,
                    uint64_t *bytes_written,
@@ -308,7 +737,7 @@ pcapng_write_block(FILE* pfile,
 }
 
 bool
-pcapng_write_section_header_block(FILE* pfile,
+pcapng_write_section_header_block(pcapio_writer_t* pfile,
                                   GPtrArray *comments,
                                   const char *hw,
                                   const char *os,
@@ -381,7 +810,7 @@ pcapng_write_section_header_block(FILE* pfile,
 }
 
 bool
-pcapng_write_interface_description_block(FILE* pfile,
+pcapng_write_interface_description_block(pcapio_writer_t* pfile,
                                          const char *comment,  /* OPT_COMMENT        1 */
                                          const char *name,     /* IDB_NAME           2 */
                                          const char *descr,    /* IDB_DESCRIPTION    3 */
@@ -540,7 +969,7 @@ pcapng_write_interface_description_block(FILE* pfile,
 /* Write a record for a packet to a dump file.
    Returns true on success, false on failure. */
 bool
-pcapng_write_enhanced_packet_block(FILE* pfile,
+pcapng_write_enhanced_packet_block(pcapio_writer_t* pfile,
                                    const char *comment,
                                    time_t sec, uint32_t usec,
                                    uint32_t caplen, uint32_t len,
@@ -632,7 +1061,7 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
 }
 
 bool
-pcapng_write_interface_statistics_block(FILE* pfile,
+pcapng_write_interface_statistics_block(pcapio_writer_t* pfile,
                                         uint32_t interface_id,
                                         uint64_t *bytes_written,
                                         const char *comment,    /* OPT_COMMENT           1 */
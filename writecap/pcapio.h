@@ -12,19 +12,76 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#ifndef __WRITECAP_PCAPIO_H__
+#define __WRITECAP_PCAPIO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <glib.h>
+
+/* Output writers */
+
+typedef struct pcapio_writer pcapio_writer_t;
+
+/** Segment size used if 0 is passed to pcapio_writer_fdopen() */
+#define PCAPIO_WRITER_DEFAULT_SEGMENT_SIZE      (256 * 1024)
+
+/** Default for how long written data may stay in a segment writer */
+#define PCAPIO_WRITER_DEFAULT_FLUSH_LATENCY_MS  100
+
+/** Write regular files with O_DIRECT, where supported */
+#define PCAPIO_WRITER_DIRECT                    0x00000001
+
+/** Write through a stdio stream, which the writer then owns. */
+extern pcapio_writer_t *
+pcapio_writer_stdio(FILE *pfile);
+
+/** Write to a file descriptor, which the writer then owns.
+
+   Written data is gathered into page-aligned segments, which a thread
+   writes with writev() or pwritev() while the next is filled; it's only
+   guaranteed to have been written by pcapio_writer_flush(), or once it's
+   been waiting for flush_latency_ms when pcapio_writer_flush_if_due() is
+   called. Where that isn't available, this writes through stdio with a
+   large buffer.
+
+   Returns NULL, and sets "*err", on failure. */
+extern pcapio_writer_t *
+pcapio_writer_fdopen(int fd, size_t segment_size, unsigned flush_latency_ms,
+                     unsigned flags, int *err);
+
+/** Write out everything written so far, and wait for it to be written.
+   Returns true on success, false, and sets "*err" if err isn't NULL, on
+   failure. */
+extern bool
+pcapio_writer_flush(pcapio_writer_t *w, int *err);
+
+/** Start writing out what's been written, if the oldest of it has been
+   waiting for longer than the flush latency; call this often to bound
+   how long data stays in memory. */
+extern bool
+pcapio_writer_flush_if_due(pcapio_writer_t *w, int *err);
+
+/** Flush and close a writer, and its file, and free it. */
+extern bool
+pcapio_writer_close(pcapio_writer_t *w, int *err);
+
 /* Writing pcap files */
 
 /** Write the file header to a dump file.
    Returns true on success, false on failure.
    Sets "*err" to an error code, or 0 for a short write, on failure*/
 extern bool
-libpcap_write_file_header(FILE* pfile, int linktype, int snaplen,
+libpcap_write_file_header(pcapio_writer_t* pfile, int linktype, int snaplen,
                           bool ts_nsecs, uint64_t *bytes_written, int *err);
 
 /** Write a record for a packet to a dump file.
    Returns true on success, false on failure. */
 extern bool
-libpcap_write_packet(FILE* pfile,
+libpcap_write_packet(pcapio_writer_t* pfile,
                      time_t sec, uint32_t usec,
                      uint32_t caplen, uint32_t len,
                      const uint8_t *pd,
@@ -34,7 +91,7 @@ libpcap_write_packet(FILE* pfile,
 
 /* Write a pre-formatted pcapng block */
 extern bool
-pcapng_write_block(FILE* pfile,
+pcapng_write_block(pcapio_writer_t* pfile,
                   const uint8_t *data,
                   uint32_t block_total_length,
                   uint64_t *bytes_written,
@@ -44,7 +101,7 @@ pcapng_write_block(FILE* pfile,
  *
  */
 extern bool
-pcapng_write_section_header_block(FILE* pfile,  /**< Write information */
+pcapng_write_section_header_block(pcapio_writer_t* pfile,  /**< Write information */
                                   GPtrArray *comments,  /**< Comments on the section, Optinon 1 opt_comment
                                                          * UTF-8 strings containing comments that areassociated to the current block.
                                                          */
@@ -63,7 +120,7 @@ pcapng_write_section_header_block(FILE* pfile,  /**< Write information */
                                   );
 
 extern bool
-pcapng_write_interface_description_block(FILE* pfile,
+pcapng_write_interface_description_block(pcapio_writer_t* pfile,
                                          const char *comment,  /* OPT_COMMENT           1 */
                                          const char *name,     /* IDB_NAME              2 */
                                          const char *descr,    /* IDB_DESCRIPTION       3 */
@@ -78,7 +135,7 @@ pcapng_write_interface_description_block(FILE* pfile,
                                          int *err);
 
 extern bool
-pcapng_write_interface_statistics_block(FILE* pfile,
+pcapng_write_interface_statistics_block(pcapio_writer_t* pfile,
                                         uint32_t interface_id,
                                         uint64_t *bytes_written,
                                         const char *comment,   /* OPT_COMMENT           1 */
@@ -89,7 +146,7 @@ pcapng_write_interface_statistics_block(FILE* pfile,
                                         int *err);
 
 extern bool
-pcapng_write_enhanced_packet_block(FILE* pfile,
+pcapng_write_enhanced_packet_block(pcapio_writer_t* pfile,
                                    const char *comment,
                                    time_t sec, uint32_t usec,
                                    uint32_t caplen, uint32_t len,
@@ -100,6 +157,8 @@ pcapng_write_enhanced_packet_block(FILE* pfile,
                                    uint64_t *bytes_written,
                                    int *err);
 
+#endif /* __WRITECAP_PCAPIO_H__ */
+
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
  *
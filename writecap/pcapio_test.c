@@ -0,0 +1,397 @@
+/* pcapio_test.c
+ * Capture file writer tests and throughput benchmark
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#undef G_DISABLE_ASSERT
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include <wsutil/file_util.h>
+
+#include "pcapio.h"
+
+#define TEST_SNAPLEN 65535
+
+typedef enum {
+    WRITER_STDIO,
+    WRITER_SEGMENT,
+    WRITER_SEGMENT_DIRECT
+} writer_type_e;
+
+static const char *writer_names[] = { "stdio", "segment", "segment+direct" };
+
+/* Open a writer of the given type on a file descriptor it then owns. */
+static pcapio_writer_t *
+test_writer_open(int fd, writer_type_e type, size_t segment_size,
+                 unsigned flush_latency_ms)
+{
+    pcapio_writer_t *w;
+    FILE *file;
+    int err = 0;
+
+    switch (type) {
+
+    case WRITER_STDIO:
+        file = ws_fdopen(fd, "wb");
+        g_assert_nonnull(file);
+        /* What dumpcap did before it had segment writers. */
+        setvbuf(file, NULL, _IOFBF, IO_BUF_SIZE);
+        w = pcapio_writer_stdio(file);
+        break;
+
+    case WRITER_SEGMENT:
+        w = pcapio_writer_fdopen(fd, segment_size, flush_latency_ms, 0, &err);
+        break;
+
+    default:
+        w = pcapio_writer_fdopen(fd, segment_size, flush_latency_ms,
+                                 PCAPIO_WRITER_DIRECT, &err);
+        break;
+    }
+    g_assert_cmpint(err, ==, 0);
+    g_assert_nonnull(w);
+    return w;
+}
+
+/*
+ * Write a pcap file header and packets of pseudo-random lengths and
+ * contents, the same for the same seed, optionally flushing every
+ * flush_every packets. Returns the number of bytes written.
+ */
+static guint64
+write_packets(pcapio_writer_t *w, guint32 seed, guint count,
+              guint flush_every)
+{
+    GRand *rand = g_rand_new_with_seed(seed);
+    guint8 pd[1514];
+    guint64 bytes_written = 0;
+    int err = 0;
+
+    g_assert_true(libpcap_write_file_header(w, 1, TEST_SNAPLEN, false,
+                                            &bytes_written, &err));
+    for (guint i = 0; i < count; i++) {
+        guint32 len = g_rand_int_range(rand, 42, (gint32)sizeof(pd) + 1);
+
+        for (guint32 j = 0; j < len; j++) {
+            pd[j] = (guint8)(i + j);
+        }
+        g_assert_true(libpcap_write_packet(w, 1700000000 + i, i % 1000000,
+                                           len, len, pd, &bytes_written, &err));
+        if (flush_every != 0 && (i + 1) % flush_every == 0) {
+            g_assert_true(pcapio_writer_flush(w, &err));
+        }
+    }
+    g_rand_free(rand);
+    return bytes_written;
+}
+
+static int
+open_temp_file(char **path)
+{
+    GError *error = NULL;
+    int fd = g_file_open_tmp("pcapio_test_XXXXXX.pcap", path, &error);
+
+    g_assert_no_error(error);
+    g_assert_cmpint(fd, >=, 0);
+    return fd;
+}
+
+static GBytes *
+read_file(const char *path)
+{
+    gchar *contents;
+    gsize length;
+    GError *error = NULL;
+
+    g_assert_true(g_file_get_contents(path, &contents, &length, &error));
+    g_assert_no_error(error);
+    return g_bytes_new_take(contents, length);
+}
+
+/* Write the same packets to a file with each writer, with and without flushes along the way. */
+static void
+test_pcapio_file(void)
+{
+    static const struct {
+        size_t segment_size;
+        guint flush_every;
+    } runs[] = {
+        { 0, 0 },
+        { 4096, 0 },        /* Many segments queued at once */
+        { 4096, 7 },        /* Flushes in the middle of segments */
+        { 1, 1 },           /* One page per segment, flushing each packet */
+    };
+    GBytes *expected = NULL;
+    guint64 expected_len = 0;
+
+    for (guint run = 0; run < G_N_ELEMENTS(runs); run++) {
+        for (writer_type_e type = WRITER_STDIO; type <= WRITER_SEGMENT_DIRECT; type++) {
+            char *path;
+            int fd = open_temp_file(&path);
+            pcapio_writer_t *w = test_writer_open(fd, type, runs[run].segment_size, 100);
+            guint64 len;
+            GBytes *contents;
+            int err = 0;
+
+            len = write_packets(w, 45, 3000, runs[run].flush_every);
+            if (runs[run].flush_every != 0) {
+                /* Everything flushed is in the file. */
+                g_assert_true(pcapio_writer_flush(w, &err));
+                contents = read_file(path);
+                g_assert_cmpuint(g_bytes_get_size(contents), ==, len);
+                g_bytes_unref(contents);
+            }
+            g_assert_true(pcapio_writer_close(w, &err));
+
+            contents = read_file(path);
+            g_test_message("%s, segment size %zu: %" G_GUINT64_FORMAT " bytes",
+                           writer_names[type], runs[run].segment_size, len);
+            if (expected == NULL) {
+                expected = g_bytes_ref(contents);
+                expected_len = len;
+            }
+            g_assert_cmpuint(len, ==, expected_len);
+            g_assert_true(g_bytes_equal(contents, expected));
+            g_bytes_unref(contents);
+            ws_unlink(path);
+            g_free(path);
+        }
+    }
+    g_bytes_unref(expected);
+}
+
+#ifndef _WIN32
+typedef struct {
+    int fd;
+    GByteArray *data;   /* NULL to discard what's read */
+    guint64 total;
+} pipe_reader_t;
+
+static gpointer
+pipe_reader_thread(gpointer user_data)
+{
+    pipe_reader_t *reader = (pipe_reader_t *)user_data;
+    guint8 buf[65536];
+    ssize_t n;
+
+    for (;;) {
+        n = read(reader->fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        if (reader->data)
+            g_byte_array_append(reader->data, buf, (guint)n);
+        reader->total += (guint64)n;
+    }
+    return NULL;
+}
+
+/* Write the same packets to a pipe with each writer. */
+static void
+test_pcapio_pipe(void)
+{
+    GByteArray *expected = NULL;
+
+    for (writer_type_e type = WRITER_STDIO; type <= WRITER_SEGMENT_DIRECT; type++) {
+        int fds[2];
+        pipe_reader_t reader;
+        GThread *thread;
+        pcapio_writer_t *w;
+        guint64 len;
+        int err = 0;
+
+        g_assert_cmpint(pipe(fds), ==, 0);
+        reader.fd = fds[0];
+        reader.data = g_byte_array_new();
+        reader.total = 0;
+        thread = g_thread_new("pipe reader", pipe_reader_thread, &reader);
+
+        /* O_DIRECT isn't used for pipes; the flag is ignored. */
+        w = test_writer_open(fds[1], type, 4096, 100);
+        len = write_packets(w, 46, 3000, 0);
+        g_assert_true(pcapio_writer_close(w, &err));
+        g_thread_join(thread);
+        close(fds[0]);
+
+        g_assert_cmpuint(reader.data->len, ==, len);
+        if (expected == NULL) {
+            expected = reader.data;
+        } else {
+            g_assert_cmpmem(reader.data->data, reader.data->len,
+                            expected->data, expected->len);
+            g_byte_array_free(reader.data, TRUE);
+        }
+    }
+    g_byte_array_free(expected, TRUE);
+}
+
+/* Wait up to a second for the reading end of a pipe to become readable. */
+static gboolean
+pipe_readable(int fd)
+{
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, 1000) == 1 && (pfd.revents & POLLIN);
+}
+
+/* Data reaches a pipe once the flush latency has passed, and not before. */
+static void
+test_pcapio_flush_latency(void)
+{
+    int fds[2];
+    pcapio_writer_t *w;
+    guint64 len;
+    guint8 buf[4096];
+    int err = 0;
+
+    g_assert_cmpint(pipe(fds), ==, 0);
+    w = test_writer_open(fds[1], WRITER_SEGMENT, 0, 20);
+    len = write_packets(w, 47, 1, 0);
+
+    /* Not due yet; nothing is written. */
+    g_assert_true(pcapio_writer_flush_if_due(w, &err));
+    {
+        struct pollfd pfd = { fds[0], POLLIN, 0 };
+        g_assert_cmpint(poll(&pfd, 1, 0), ==, 0);
+    }
+
+    g_usleep(40 * 1000);
+    g_assert_true(pcapio_writer_flush_if_due(w, &err));
+    g_assert_true(pipe_readable(fds[0]));
+    g_assert_cmpint(read(fds[0], buf, sizeof(buf)), ==, (ssize_t)len);
+
+    g_assert_true(pcapio_writer_close(w, &err));
+    close(fds[0]);
+}
+#endif /* _WIN32 */
+
+/*
+ * Write throughput, as dumpcap writes: many packets, with a flush when
+ * due after each one, as its capture loop does. Small packets show the
+ * per-record overhead, large ones the per-byte cost.
+ */
+#define PERF_BYTES  (512 * 1024 * 1024)
+
+static void
+pcapio_perf(const char *target, int fd, writer_type_e type, guint32 packet_len)
+{
+    pcapio_writer_t *w = test_writer_open(fd, type, 0,
+                                          PCAPIO_WRITER_DEFAULT_FLUSH_LATENCY_MS);
+    guint8 *pd = g_malloc0(packet_len);
+    guint count = PERF_BYTES / (packet_len + 16);
+    guint64 bytes_written = 0;
+    gdouble elapsed;
+    int err = 0;
+
+    g_test_timer_start();
+    g_assert_true(libpcap_write_file_header(w, 1, TEST_SNAPLEN, false,
+                                            &bytes_written, &err));
+    for (guint i = 0; i < count; i++) {
+        g_assert_true(libpcap_write_packet(w, 1700000000, i, packet_len,
+                                           packet_len, pd, &bytes_written, &err));
+        g_assert_true(pcapio_writer_flush_if_due(w, &err));
+    }
+    g_assert_true(pcapio_writer_close(w, &err));
+    elapsed = g_test_timer_elapsed();
+
+    g_test_maximized_result(bytes_written / elapsed / 1e6,
+                            "%s, %s, %u byte packets: %.0f MB/s, %.0f packets/s",
+                            target, writer_names[type], packet_len,
+                            bytes_written / elapsed / 1e6, count / elapsed);
+    g_free(pd);
+}
+
+static void
+test_pcapio_file_perf(void)
+{
+    static const guint32 packet_lens[] = { 64, 1500 };
+
+    for (guint i = 0; i < G_N_ELEMENTS(packet_lens); i++) {
+        for (writer_type_e type = WRITER_STDIO; type <= WRITER_SEGMENT_DIRECT; type++) {
+            char *path;
+            int fd = open_temp_file(&path);
+
+            pcapio_perf("file", fd, type, packet_lens[i]);
+            ws_unlink(path);
+            g_free(path);
+        }
+    }
+}
+
+#ifndef _WIN32
+static void
+test_pcapio_pipe_perf(void)
+{
+    static const guint32 packet_lens[] = { 64, 1500 };
+
+    for (guint i = 0; i < G_N_ELEMENTS(packet_lens); i++) {
+        for (writer_type_e type = WRITER_STDIO; type <= WRITER_SEGMENT; type++) {
+            int fds[2];
+            pipe_reader_t reader;
+            GThread *thread;
+
+            g_assert_cmpint(pipe(fds), ==, 0);
+            reader.fd = fds[0];
+            reader.data = NULL;
+            reader.total = 0;
+            thread = g_thread_new("pipe reader", pipe_reader_thread, &reader);
+            pcapio_perf("pipe", fds[1], type, packet_lens[i]);
+            g_thread_join(thread);
+            close(fds[0]);
+        }
+    }
+}
+#endif /* _WIN32 */
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/pcapio/file", test_pcapio_file);
+#ifndef _WIN32
+    g_test_add_func("/pcapio/pipe", test_pcapio_pipe);
+    g_test_add_func("/pcapio/flush_latency", test_pcapio_flush_latency);
+#endif
+
+    if (g_test_perf()) {
+        g_test_add_func("/pcapio/file_perf", test_pcapio_file_perf);
+#ifndef _WIN32
+        g_test_add_func("/pcapio/pipe_perf", test_pcapio_pipe_perf);
+#endif
+    }
+
+    return g_test_run();
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,250 @@
+/* str_scan.c
+ * Scanning strings for the bytes that need special handling
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#include "str_scan.h"
+#include "str_scan_int.h"
+
+#include "ws_cpuid.h"
+
+size_t
+str_scan_ascii_span_portable(const uint8_t *ptr, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len && ptr[i] < 0x80; i++)
+        ;
+    return i;
+}
+
+size_t
+str_scan_printable_span_portable(const uint8_t *ptr, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len && ptr[i] >= 0x20 && ptr[i] < 0x7f; i++)
+        ;
+    return i;
+}
+
+size_t
+str_scan_unescaped_span_portable(const uint8_t *ptr, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (ptr[i] < 0x20 || ptr[i] == '"' || ptr[i] == '\\')
+            break;
+    }
+    return i;
+}
+
+/*
+ * See table 3-7 "Well-Formed UTF-8 Byte Sequences" in the conformance
+ * chapter of the Unicode Standard; only the second byte has a range
+ * that depends on the first one.
+ */
+size_t
+str_scan_utf8_char_len(const uint8_t *ptr, size_t len)
+{
+    uint8_t ch = ptr[0];
+    uint8_t lo = 0x80, hi = 0xbf;
+    size_t char_len, i;
+
+    if (ch < 0x80)
+        return 1;
+    if (ch < 0xc2 || ch > 0xf4)
+        return 0;
+
+    if (ch < 0xe0) {
+        char_len = 2;
+    } else if (ch < 0xf0) {
+        char_len = 3;
+        if (ch == 0xe0)
+            lo = 0xa0;
+        else if (ch == 0xed)
+            hi = 0x9f;
+    } else {
+        char_len = 4;
+        if (ch == 0xf0)
+            lo = 0x90;
+        else if (ch == 0xf4)
+            hi = 0x8f;
+    }
+
+    if (len < char_len)
+        return 0;
+    if (ptr[1] < lo || ptr[1] > hi)
+        return 0;
+    for (i = 2; i < char_len; i++) {
+        if ((ptr[i] & 0xc0) != 0x80)
+            return 0;
+    }
+    return char_len;
+}
+
+size_t
+str_scan_utf8_span_portable(const uint8_t *ptr, size_t len)
+{
+    size_t i = 0, char_len;
+
+    while (i < len) {
+        if (ptr[i] < 0x80) {
+            i++;
+            continue;
+        }
+        char_len = str_scan_utf8_char_len(ptr + i, len - i);
+        if (char_len == 0)
+            break;
+        i += char_len;
+    }
+    return i;
+}
+
+size_t
+str_scan_utf16_ascii_span_portable(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian)
+{
+    size_t i;
+    uint16_t unit;
+
+    for (i = 0; i < units; i++) {
+        if (big_endian)
+            unit = (src[2*i] << 8) | src[2*i + 1];
+        else
+            unit = src[2*i] | (src[2*i + 1] << 8);
+        if (unit >= 0x80)
+            break;
+        dst[i] = (uint8_t)unit;
+    }
+    return i;
+}
+
+static const str_scan_kernels str_scan_portable_kernels = {
+    str_scan_ascii_span_portable,
+    str_scan_printable_span_portable,
+    str_scan_unescaped_span_portable,
+    str_scan_utf8_span_portable,
+    str_scan_utf16_ascii_span_portable,
+};
+
+static const str_scan_kernels *
+str_scan_impl_kernels(ws_str_scan_impl impl)
+{
+    switch (impl) {
+
+    case WS_STR_SCAN_BEST:
+#ifdef HAVE_AVX2
+        if (ws_cpuid_avx2())
+            return &str_scan_avx2_kernels;
+#endif
+#ifdef STR_SCAN_SSE2
+        return &str_scan_sse2_kernels;
+#elif defined(STR_SCAN_NEON)
+        return &str_scan_neon_kernels;
+#else
+        return &str_scan_portable_kernels;
+#endif
+
+    case WS_STR_SCAN_PORTABLE:
+        return &str_scan_portable_kernels;
+
+    case WS_STR_SCAN_SSE2:
+#ifdef STR_SCAN_SSE2
+        return &str_scan_sse2_kernels;
+#else
+        return NULL;
+#endif
+
+    case WS_STR_SCAN_AVX2:
+#ifdef HAVE_AVX2
+        if (ws_cpuid_avx2())
+            return &str_scan_avx2_kernels;
+#endif
+        return NULL;
+
+    case WS_STR_SCAN_NEON:
+#ifdef STR_SCAN_NEON
+        return &str_scan_neon_kernels;
+#else
+        return NULL;
+#endif
+    }
+
+    return NULL;
+}
+
+static const str_scan_kernels *str_scan_active;
+
+static inline const str_scan_kernels *
+str_scan_get_kernels(void)
+{
+    static gsize initialized;
+
+    if (g_once_init_enter(&initialized)) {
+        str_scan_active = str_scan_impl_kernels(WS_STR_SCAN_BEST);
+        g_once_init_leave(&initialized, 1);
+    }
+    return str_scan_active;
+}
+
+bool
+ws_str_scan_select(ws_str_scan_impl impl)
+{
+    const str_scan_kernels *kernels = str_scan_impl_kernels(impl);
+
+    str_scan_get_kernels();
+    if (kernels == NULL)
+        return false;
+    str_scan_active = kernels;
+    return true;
+}
+
+size_t
+ws_ascii_span(const uint8_t *ptr, size_t len)
+{
+    return str_scan_get_kernels()->ascii_span(ptr, len);
+}
+
+size_t
+ws_printable_span(const uint8_t *ptr, size_t len)
+{
+    return str_scan_get_kernels()->printable_span(ptr, len);
+}
+
+size_t
+ws_unescaped_span(const uint8_t *ptr, size_t len)
+{
+    return str_scan_get_kernels()->unescaped_span(ptr, len);
+}
+
+size_t
+ws_utf8_span(const uint8_t *ptr, size_t len)
+{
+    return str_scan_get_kernels()->utf8_span(ptr, len);
+}
+
+size_t
+ws_utf16_ascii_span(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian)
+{
+    return str_scan_get_kernels()->utf16_ascii_span(dst, src, units, big_endian);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
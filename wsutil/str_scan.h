@@ -0,0 +1,77 @@
+/** @file
+ *
+ * Scanning strings for the bytes that need special handling, using SIMD
+ * instructions where the processor has them.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_STR_SCAN_H__
+#define __WS_STR_SCAN_H__
+
+#include <wireshark.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** Get the number of leading bytes that are ASCII, i.e. less than 0x80.
+ */
+WS_DLL_PUBLIC size_t ws_ascii_span(const uint8_t *ptr, size_t len);
+
+/** Get the number of leading bytes that are printable ASCII, i.e.
+ * between 0x20 and 0x7e.
+ */
+WS_DLL_PUBLIC size_t ws_printable_span(const uint8_t *ptr, size_t len);
+
+/** Get the number of leading bytes that never need a backslash escape:
+ * anything except control characters, '"' and '\\'.
+ */
+WS_DLL_PUBLIC size_t ws_unescaped_span(const uint8_t *ptr, size_t len);
+
+/** Get the number of leading bytes that are well-formed UTF-8, as
+ * defined by table 3-7 of the Unicode Standard. The span ends at a
+ * character boundary, so a character that is cut off by the end of
+ * the buffer is not included.
+ */
+WS_DLL_PUBLIC size_t ws_utf8_span(const uint8_t *ptr, size_t len);
+
+/** Convert the leading UTF-16 code units that are ASCII to single bytes.
+ *
+ * @param dst Where to put the converted bytes; there must be room for
+ * "units" of them.
+ * @param src The UTF-16 string.
+ * @param units The number of code units (not bytes) in "src".
+ * @param big_endian true if "src" is UTF-16BE, false if it's UTF-16LE.
+ * @return The number of code units converted, which is the number of
+ * bytes put into "dst".
+ */
+WS_DLL_PUBLIC size_t ws_utf16_ascii_span(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian);
+
+/** The implementations of the scanning routines. */
+typedef enum {
+    WS_STR_SCAN_BEST,       /**< The fastest one this processor supports */
+    WS_STR_SCAN_PORTABLE,   /**< Plain C, one byte at a time */
+    WS_STR_SCAN_SSE2,
+    WS_STR_SCAN_AVX2,
+    WS_STR_SCAN_NEON,
+} ws_str_scan_impl;
+
+/** Choose the implementation of the scanning routines, which is
+ * normally chosen at startup. This is meant for testing them against
+ * each other.
+ *
+ * @return false if this build or this processor doesn't support the
+ * implementation, in which case the current one is kept.
+ */
+WS_DLL_PUBLIC bool ws_str_scan_select(ws_str_scan_impl impl);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __WS_STR_SCAN_H__ */
@@ -0,0 +1,283 @@
+/* str_scan_avx2.c
+ * Scanning strings 32 bytes at a time with AVX2
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#ifdef HAVE_AVX2
+
+#include "str_scan_int.h"
+
+#include <immintrin.h>
+
+#include "bits_ctz.h"
+
+#define LOADU(p) _mm256_loadu_si256((const __m256i *)(const void *)(p))
+
+static size_t
+ascii_span_avx2(const uint8_t *ptr, size_t len)
+{
+    size_t i = 0;
+    uint32_t mask;
+
+    for (; i + 32 <= len; i += 32) {
+        mask = (uint32_t)_mm256_movemask_epi8(LOADU(ptr + i));
+        if (mask)
+            return i + ws_ctz(mask);
+    }
+    return i + str_scan_ascii_span_portable(ptr + i, len - i);
+}
+
+static size_t
+printable_span_avx2(const uint8_t *ptr, size_t len)
+{
+    const __m256i below = _mm256_set1_epi8(0x20 - 1);
+    const __m256i above = _mm256_set1_epi8(0x7f);
+    size_t i = 0;
+    __m256i v;
+    uint32_t mask;
+
+    /* Bytes with the high bit set are negative, so below 0x20. */
+    for (; i + 32 <= len; i += 32) {
+        v = LOADU(ptr + i);
+        mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpgt_epi8(v, below),
+                                                               _mm256_cmpgt_epi8(above, v)));
+        if (mask != 0xffffffff)
+            return i + ws_ctz(~mask);
+    }
+    return i + str_scan_printable_span_portable(ptr + i, len - i);
+}
+
+static size_t
+unescaped_span_avx2(const uint8_t *ptr, size_t len)
+{
+    const __m256i control = _mm256_set1_epi8(0x20 - 1);
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    size_t i = 0;
+    __m256i v, bad;
+    uint32_t mask;
+
+    for (; i + 32 <= len; i += 32) {
+        v = LOADU(ptr + i);
+        /* Unsigned v < 0x20 iff min(v, 0x1f) == v */
+        bad = _mm256_cmpeq_epi8(_mm256_min_epu8(v, control), v);
+        bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(v, quote));
+        bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(v, backslash));
+        mask = (uint32_t)_mm256_movemask_epi8(bad);
+        if (mask)
+            return i + ws_ctz(mask);
+    }
+    return i + str_scan_unescaped_span_portable(ptr + i, len - i);
+}
+
+/*
+ * UTF-8 validation with table lookups, as described in "Validating
+ * UTF-8 In Less Than One Instruction Per Byte" by John Keiser and
+ * Daniel Lemire, https://arxiv.org/abs/2010.03090
+ *
+ * The high nibble of each byte and the high and low nibbles of the
+ * byte before it are looked up in three tables, each giving the
+ * classes of error that the pair could be part of; a pair is invalid
+ * if a class is in all three. The third and fourth bytes of a
+ * character are checked separately, as they must be continuation
+ * bytes whatever the first one was.
+ */
+#define TOO_SHORT       (1 << 0)    /* 11______ 0_______, 11______ 11______ */
+#define TOO_LONG        (1 << 1)    /* 0_______ 10______ */
+#define OVERLONG_3      (1 << 2)    /* 11100000 100_____ */
+#define TOO_LARGE       (1 << 3)    /* 11110100 1001____, 11110100 101_____, 11110101+ 10______ */
+#define SURROGATE       (1 << 4)    /* 11101101 101_____ */
+#define OVERLONG_2      (1 << 5)    /* 1100000_ 10______ */
+#define TOO_LARGE_1000  (1 << 6)    /* 11110101+ 1000____ */
+#define OVERLONG_4      (1 << 6)    /* 11110000 1000____ */
+#define TWO_CONTS       (1 << 7)    /* 10______ 10______ */
+#define CARRY           (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+#define TABLE16(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+/* The 32 bytes that end n bytes before the end of input. */
+#define PREV(input, prev_input, n) \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev_input), (input), 0x21), 16 - (n))
+
+static inline __m256i
+high_nibbles(__m256i v)
+{
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+}
+
+static inline __m256i
+utf8_errors(__m256i input, __m256i prev_input)
+{
+    const __m256i byte_1_high = TABLE16(
+        /* 0_______ ________ */
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        /* 10______ ________ */
+        (char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS, (char)TWO_CONTS,
+        /* 1100____ ________ */
+        TOO_SHORT | OVERLONG_2,
+        /* 1101____ ________ */
+        TOO_SHORT,
+        /* 1110____ ________ */
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        /* 1111____ ________ */
+        (char)(TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4));
+    const __m256i byte_1_low = TABLE16(
+        /* ____0000 ________ */
+        (char)(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+        /* ____0001 ________ */
+        (char)(CARRY | OVERLONG_2),
+        /* ____001_ ________ */
+        (char)CARRY,
+        (char)CARRY,
+        /* ____0100 ________ */
+        (char)(CARRY | TOO_LARGE),
+        /* ____0101 ________ and up */
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        /* ____1101 ________ */
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        (char)(CARRY | TOO_LARGE | TOO_LARGE_1000));
+    const __m256i byte_2_high = TABLE16(
+        /* ________ 0_______ */
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        /* ________ 1000____ */
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+        /* ________ 1001____ */
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+        /* ________ 101_____ */
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+        (char)(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+        /* ________ 11______ */
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+    __m256i prev1, special, is_third, is_fourth, must_be_cont;
+
+    prev1 = PREV(input, prev_input, 1);
+    special = _mm256_and_si256(
+        _mm256_and_si256(_mm256_shuffle_epi8(byte_1_high, high_nibbles(prev1)),
+                         _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)))),
+        _mm256_shuffle_epi8(byte_2_high, high_nibbles(input)));
+
+    /* Only 111_____ two bytes back, or 1111____ three bytes back, end
+     * up with the high bit set. */
+    is_third = _mm256_subs_epu8(PREV(input, prev_input, 2), _mm256_set1_epi8(0xe0 - 0x80));
+    is_fourth = _mm256_subs_epu8(PREV(input, prev_input, 3), _mm256_set1_epi8(0xf0 - 0x80));
+    must_be_cont = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth), _mm256_set1_epi8((char)0x80));
+
+    /* TWO_CONTS is what the lookup says for a continuation byte after a
+     * continuation byte, which is exactly when it's an error not to be
+     * the third or fourth byte. */
+    return _mm256_xor_si256(must_be_cont, special);
+}
+
+/* Nonzero in the last three bytes if they start a character that
+ * doesn't end in this block. */
+static inline __m256i
+utf8_incomplete(__m256i input)
+{
+    const __m256i max_value = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xf0 - 1), (char)(0xe0 - 1), (char)(0xc0 - 1));
+
+    return _mm256_subs_epu8(input, max_value);
+}
+
+static size_t
+utf8_span_avx2(const uint8_t *ptr, size_t len)
+{
+    __m256i input, prev_input = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    size_t i = 0, good = 0;
+
+    /* Everything before "good" has been checked and it's at a character
+     * boundary; the plain C version finds exactly where it stops. */
+    for (; i + 32 <= len; i += 32) {
+        input = LOADU(ptr + i);
+        if (!_mm256_movemask_epi8(input)) {
+            /* All ASCII; fine unless the last block left a character
+             * unfinished. */
+            if (!_mm256_testz_si256(incomplete, incomplete))
+                break;
+        } else {
+            if (!_mm256_testz_si256(utf8_errors(input, prev_input), _mm256_set1_epi8(-1)))
+                break;
+            incomplete = utf8_incomplete(input);
+        }
+        prev_input = input;
+        if (_mm256_testz_si256(incomplete, incomplete)) {
+            good = i + 32;
+        } else {
+            /* Back up to the first byte of the unfinished character. */
+            good = i + 32 - 1;
+            while (ptr[good] < 0xc0)
+                good--;
+        }
+    }
+
+    return good + str_scan_utf8_span_portable(ptr + good, len - good);
+}
+
+static size_t
+utf16_ascii_span_avx2(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian)
+{
+    /* The bits of each 16-bit lane that must be clear for ASCII; a
+     * big-endian code unit has its bytes swapped in the lane. */
+    const __m256i non_ascii = _mm256_set1_epi16(big_endian ? (short)0x80ff : (short)0xff80);
+    size_t i = 0;
+    __m256i a, b, packed;
+
+    for (; i + 32 <= units; i += 32) {
+        a = LOADU(src + 2*i);
+        b = LOADU(src + 2*i + 32);
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), non_ascii))
+            break;
+        if (big_endian) {
+            a = _mm256_srli_epi16(a, 8);
+            b = _mm256_srli_epi16(b, 8);
+        }
+        /* Packing works within each 128-bit lane, so put the 64-bit
+         * quarters back in order afterwards. */
+        packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+        _mm256_storeu_si256((__m256i *)(void *)(dst + i), packed);
+    }
+    return i + str_scan_utf16_ascii_span_portable(dst + i, src + 2*i, units - i, big_endian);
+}
+
+const str_scan_kernels str_scan_avx2_kernels = {
+    ascii_span_avx2,
+    printable_span_avx2,
+    unescaped_span_avx2,
+    utf8_span_avx2,
+    utf16_ascii_span_avx2,
+};
+
+#endif /* HAVE_AVX2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,62 @@
+/** @file
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WS_STR_SCAN_INT_H__
+#define __WS_STR_SCAN_INT_H__
+
+#include "str_scan.h"
+
+/*
+ * SSE2 is part of x86-64, and NEON of AArch64, so those are used
+ * whenever we're built for them. AVX2 has to be checked for at run
+ * time, and its code has to be compiled with an extra flag.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STR_SCAN_SSE2 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define STR_SCAN_NEON 1
+#endif
+
+typedef struct {
+    size_t (*ascii_span)(const uint8_t *ptr, size_t len);
+    size_t (*printable_span)(const uint8_t *ptr, size_t len);
+    size_t (*unescaped_span)(const uint8_t *ptr, size_t len);
+    size_t (*utf8_span)(const uint8_t *ptr, size_t len);
+    size_t (*utf16_ascii_span)(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian);
+} str_scan_kernels;
+
+/*
+ * The plain C versions, which the others use for what's left over
+ * after the last whole vector.
+ */
+size_t str_scan_ascii_span_portable(const uint8_t *ptr, size_t len);
+size_t str_scan_printable_span_portable(const uint8_t *ptr, size_t len);
+size_t str_scan_unescaped_span_portable(const uint8_t *ptr, size_t len);
+size_t str_scan_utf8_span_portable(const uint8_t *ptr, size_t len);
+size_t str_scan_utf16_ascii_span_portable(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian);
+
+/* The length of the well-formed UTF-8 character at ptr, or 0 if there
+ * isn't one. */
+size_t str_scan_utf8_char_len(const uint8_t *ptr, size_t len);
+
+#ifdef STR_SCAN_SSE2
+extern const str_scan_kernels str_scan_sse2_kernels;
+#endif
+
+#ifdef HAVE_AVX2
+extern const str_scan_kernels str_scan_avx2_kernels;
+#endif
+
+#ifdef STR_SCAN_NEON
+extern const str_scan_kernels str_scan_neon_kernels;
+#endif
+
+#endif /* __WS_STR_SCAN_INT_H__ */
@@ -0,0 +1,222 @@
+/* str_scan_neon.c
+ * Scanning strings 16 bytes at a time with NEON
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#include "str_scan_int.h"
+
+#ifdef STR_SCAN_NEON
+
+#include <arm_neon.h>
+
+/*
+ * NEON has no equivalent of SSE's movemask, so when a vector has a byte
+ * that ends the span the plain C version finds which one it is.
+ */
+
+static size_t
+ascii_span_neon(const uint8_t *ptr, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        if (vmaxvq_u8(vld1q_u8(ptr + i)) >= 0x80)
+            break;
+    }
+    return i + str_scan_ascii_span_portable(ptr + i, len - i);
+}
+
+static size_t
+printable_span_neon(const uint8_t *ptr, size_t len)
+{
+    size_t i = 0;
+    uint8x16_t v;
+
+    for (; i + 16 <= len; i += 16) {
+        v = vld1q_u8(ptr + i);
+        if (vminvq_u8(v) < 0x20 || vmaxvq_u8(v) > 0x7e)
+            break;
+    }
+    return i + str_scan_printable_span_portable(ptr + i, len - i);
+}
+
+static size_t
+unescaped_span_neon(const uint8_t *ptr, size_t len)
+{
+    const uint8_t quote = '"', backslash = '\\';
+    size_t i = 0;
+    uint8x16_t v, bad;
+
+    for (; i + 16 <= len; i += 16) {
+        v = vld1q_u8(ptr + i);
+        bad = vcltq_u8(v, vdupq_n_u8(0x20));
+        bad = vorrq_u8(bad, vceqq_u8(v, vdupq_n_u8(quote)));
+        bad = vorrq_u8(bad, vceqq_u8(v, vdupq_n_u8(backslash)));
+        if (vmaxvq_u8(bad))
+            break;
+    }
+    return i + str_scan_unescaped_span_portable(ptr + i, len - i);
+}
+
+/*
+ * UTF-8 validation with table lookups, as described in "Validating
+ * UTF-8 In Less Than One Instruction Per Byte" by John Keiser and
+ * Daniel Lemire, https://arxiv.org/abs/2010.03090; see
+ * str_scan_avx2.c for how the tables work.
+ */
+#define TOO_SHORT       (1 << 0)
+#define TOO_LONG        (1 << 1)
+#define OVERLONG_3      (1 << 2)
+#define TOO_LARGE       (1 << 3)
+#define SURROGATE       (1 << 4)
+#define OVERLONG_2      (1 << 5)
+#define TOO_LARGE_1000  (1 << 6)
+#define OVERLONG_4      (1 << 6)
+#define TWO_CONTS       (1 << 7)
+#define CARRY           (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+static const uint8_t byte_1_high_table[16] = {
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    TOO_SHORT | OVERLONG_2,
+    TOO_SHORT,
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+static const uint8_t byte_1_low_table[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    CARRY | OVERLONG_2,
+    CARRY,
+    CARRY,
+    CARRY | TOO_LARGE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+    CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+
+static const uint8_t byte_2_high_table[16] = {
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+static const uint8_t incomplete_max_table[16] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1,
+};
+
+static inline uint8x16_t
+utf8_errors(uint8x16_t input, uint8x16_t prev_input)
+{
+    uint8x16_t prev1, special, is_third, is_fourth, must_be_cont;
+
+    prev1 = vextq_u8(prev_input, input, 16 - 1);
+    special = vandq_u8(
+        vandq_u8(vqtbl1q_u8(vld1q_u8(byte_1_high_table), vshrq_n_u8(prev1, 4)),
+                 vqtbl1q_u8(vld1q_u8(byte_1_low_table), vandq_u8(prev1, vdupq_n_u8(0x0f)))),
+        vqtbl1q_u8(vld1q_u8(byte_2_high_table), vshrq_n_u8(input, 4)));
+
+    is_third = vqsubq_u8(vextq_u8(prev_input, input, 16 - 2), vdupq_n_u8(0xe0 - 0x80));
+    is_fourth = vqsubq_u8(vextq_u8(prev_input, input, 16 - 3), vdupq_n_u8(0xf0 - 0x80));
+    must_be_cont = vandq_u8(vorrq_u8(is_third, is_fourth), vdupq_n_u8(0x80));
+
+    return veorq_u8(must_be_cont, special);
+}
+
+static size_t
+utf8_span_neon(const uint8_t *ptr, size_t len)
+{
+    const uint8x16_t incomplete_max = vld1q_u8(incomplete_max_table);
+    uint8x16_t input, prev_input = vdupq_n_u8(0);
+    bool incomplete = false;
+    size_t i = 0, good = 0;
+
+    /* Everything before "good" has been checked and it's at a character
+     * boundary; the plain C version finds exactly where it stops. */
+    for (; i + 16 <= len; i += 16) {
+        input = vld1q_u8(ptr + i);
+        if (vmaxvq_u8(input) < 0x80) {
+            /* All ASCII; fine unless the last block left a character
+             * unfinished. */
+            if (incomplete)
+                break;
+        } else {
+            if (vmaxvq_u8(utf8_errors(input, prev_input)))
+                break;
+            incomplete = vmaxvq_u8(vqsubq_u8(input, incomplete_max)) != 0;
+        }
+        prev_input = input;
+        if (!incomplete) {
+            good = i + 16;
+        } else {
+            /* Back up to the first byte of the unfinished character. */
+            good = i + 16 - 1;
+            while (ptr[good] < 0xc0)
+                good--;
+        }
+    }
+
+    return good + str_scan_utf8_span_portable(ptr + good, len - good);
+}
+
+static size_t
+utf16_ascii_span_neon(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian)
+{
+    size_t i = 0;
+    uint8x16x2_t v;
+    uint8x16_t low, high;
+
+    /* Loading pairs of bytes separates the low and high halves. */
+    for (; i + 16 <= units; i += 16) {
+        v = vld2q_u8(src + 2*i);
+        low = v.val[big_endian ? 1 : 0];
+        high = v.val[big_endian ? 0 : 1];
+        if (vmaxvq_u8(vorrq_u8(high, vandq_u8(low, vdupq_n_u8(0x80)))))
+            break;
+        vst1q_u8(dst + i, low);
+    }
+    return i + str_scan_utf16_ascii_span_portable(dst + i, src + 2*i, units - i, big_endian);
+}
+
+const str_scan_kernels str_scan_neon_kernels = {
+    ascii_span_neon,
+    printable_span_neon,
+    unescaped_span_neon,
+    utf8_span_neon,
+    utf16_ascii_span_neon,
+};
+
+#endif /* STR_SCAN_NEON */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
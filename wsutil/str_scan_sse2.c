@@ -0,0 +1,149 @@
+/* str_scan_sse2.c
+ * Scanning strings 16 bytes at a time with SSE2
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#include "str_scan_int.h"
+
+#ifdef STR_SCAN_SSE2
+
+#include <emmintrin.h>
+
+#include "bits_ctz.h"
+
+#define LOADU(p) _mm_loadu_si128((const __m128i *)(const void *)(p))
+
+static size_t
+ascii_span_sse2(const uint8_t *ptr, size_t len)
+{
+    size_t i = 0;
+    unsigned mask;
+
+    for (; i + 16 <= len; i += 16) {
+        mask = _mm_movemask_epi8(LOADU(ptr + i));
+        if (mask)
+            return i + ws_ctz(mask);
+    }
+    return i + str_scan_ascii_span_portable(ptr + i, len - i);
+}
+
+static size_t
+printable_span_sse2(const uint8_t *ptr, size_t len)
+{
+    const __m128i below = _mm_set1_epi8(0x20 - 1);
+    const __m128i above = _mm_set1_epi8(0x7f);
+    size_t i = 0;
+    __m128i v;
+    unsigned mask;
+
+    /* Bytes with the high bit set are negative, so below 0x20. */
+    for (; i + 16 <= len; i += 16) {
+        v = LOADU(ptr + i);
+        mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(v, below),
+                                               _mm_cmplt_epi8(v, above)));
+        if (mask != 0xffff)
+            return i + ws_ctz(~mask);
+    }
+    return i + str_scan_printable_span_portable(ptr + i, len - i);
+}
+
+static size_t
+unescaped_span_sse2(const uint8_t *ptr, size_t len)
+{
+    const __m128i control = _mm_set1_epi8(0x20 - 1);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    size_t i = 0;
+    __m128i v, bad;
+    unsigned mask;
+
+    for (; i + 16 <= len; i += 16) {
+        v = LOADU(ptr + i);
+        /* Unsigned v < 0x20 iff min(v, 0x1f) == v */
+        bad = _mm_cmpeq_epi8(_mm_min_epu8(v, control), v);
+        bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, quote));
+        bad = _mm_or_si128(bad, _mm_cmpeq_epi8(v, backslash));
+        mask = _mm_movemask_epi8(bad);
+        if (mask)
+            return i + ws_ctz(mask);
+    }
+    return i + str_scan_unescaped_span_portable(ptr + i, len - i);
+}
+
+/*
+ * Without a byte shuffle there's no cheap way to check multi-byte
+ * sequences 16 at a time, so this only skips runs of ASCII.
+ */
+static size_t
+utf8_span_sse2(const uint8_t *ptr, size_t len)
+{
+    size_t i = 0, char_len;
+    unsigned mask;
+
+    while (i + 16 <= len) {
+        mask = _mm_movemask_epi8(LOADU(ptr + i));
+        if (!mask) {
+            i += 16;
+            continue;
+        }
+        i += ws_ctz(mask);
+        char_len = str_scan_utf8_char_len(ptr + i, len - i);
+        if (char_len == 0)
+            return i;
+        i += char_len;
+    }
+    return i + str_scan_utf8_span_portable(ptr + i, len - i);
+}
+
+static size_t
+utf16_ascii_span_sse2(uint8_t *dst, const uint8_t *src, size_t units, bool big_endian)
+{
+    /* The bits of each 16-bit lane that must be clear for ASCII; a
+     * big-endian code unit has its bytes swapped in the lane. */
+    const __m128i non_ascii = _mm_set1_epi16(big_endian ? (short)0x80ff : (short)0xff80);
+    size_t i = 0;
+    __m128i a, b;
+
+    for (; i + 16 <= units; i += 16) {
+        a = LOADU(src + 2*i);
+        b = LOADU(src + 2*i + 16);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(_mm_or_si128(a, b), non_ascii),
+                                             _mm_setzero_si128())) != 0xffff)
+            break;
+        if (big_endian) {
+            a = _mm_srli_epi16(a, 8);
+            b = _mm_srli_epi16(b, 8);
+        }
+        _mm_storeu_si128((__m128i *)(void *)(dst + i), _mm_packus_epi16(a, b));
+    }
+    return i + str_scan_utf16_ascii_span_portable(dst + i, src + 2*i, units - i, big_endian);
+}
+
+const str_scan_kernels str_scan_sse2_kernels = {
+    ascii_span_sse2,
+    printable_span_sse2,
+    unescaped_span_sse2,
+    utf8_span_sse2,
+    utf16_ascii_span_sse2,
+};
+
+#endif /* STR_SCAN_SSE2 */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
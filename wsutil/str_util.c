@@ -17,6 +17,7 @@
 #include <ws_codepoints.h>
 
 #include <wsutil/to_str.h>
+#include <wsutil/str_scan.h>
 
 
 static const char hex[16] = { '0', '1', '2', '3', '4', '5', '6', '7',
@@ -482,7 +483,7 @@ escape_string_len(wmem_allocator_t *alloc, const char *string, ssize_t len,
 {
     char c, r;
     wmem_strbuf_t *buf;
-    size_t alloc_size;
+    size_t alloc_size, run;
     ssize_t i;
 
     if (len < 0)
@@ -498,6 +499,14 @@ escape_string_len(wmem_allocator_t *alloc, const char *string, ssize_t len,
         wmem_strbuf_append_c(buf, '"');
 
     for (i = 0; i < len; i++) {
+        /* Copy any run that can't need escaping a vector at a time. */
+        run = ws_unescaped_span((const uint8_t *)string + i, len - i);
+        if (run) {
+            wmem_strbuf_append_len(buf, string + i, run);
+            i += run;
+            if (i == len)
+                break;
+        }
         c = string[i];
         if ((escape_func(c, &r))) {
             wmem_strbuf_append_c(buf, '\\');
@@ -587,12 +596,15 @@ ws_strdup_underline(wmem_allocator_t *allocator, long offset, size_t len)
      */ \
     if (column+(nbytes+1) >= fmtbuf_len) { \
         /* \
-         * Double the buffer's size if it's not big enough. \
+         * Double the buffer's size until it's big enough. \
          * The size of the buffer starts at 128, so doubling its size \
-         * adds at least another 128 bytes, which is more than enough \
-         * for one more character plus a terminating '\0'. \
+         * once adds at least another 128 bytes, which is more than \
+         * enough for one more character plus a terminating '\0'; \
+         * a run of printable characters may need more. \
          */ \
-        fmtbuf_len *= 2; \
+        do { \
+            fmtbuf_len *= 2; \
+        } while (column+(nbytes+1) >= fmtbuf_len); \
         fmtbuf = (char *)wmem_realloc(allocator, fmtbuf, fmtbuf_len); \
     }
 
@@ -636,8 +648,22 @@ format_text_internal(wmem_allocator_t *allocator,
     FMTBUF_VARS;
     const unsigned char *stringend = string + len;
     unsigned char c;
+    size_t run;
 
     while (string < stringend) {
+        /*
+         * Copy any run of printable ASCII characters a vector at
+         * a time.
+         */
+        run = ws_printable_span(string, stringend - string);
+        if (run) {
+            FMTBUF_EXPAND(run);
+            memcpy(&fmtbuf[column], string, run);
+            column += (unsigned)run;
+            string += run;
+            continue;
+        }
+
         /*
          * Get the first byte of this character.
          */
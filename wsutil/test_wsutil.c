@@ -254,6 +254,191 @@ static void test_format_text_perf(void)
         "format_text_string(): u %.3f ms s %.3f ms", utime_ms, stime_ms);
 }
 
+#include "str_scan.h"
+#include "unicode-utils.h"
+
+/*
+ * The SIMD versions of the string scanning routines are compared with
+ * the plain C ones. Multi-byte sequences are placed so that they cross
+ * 16 and 32 byte vector boundaries, and the buffers are also cut off
+ * in the middle of them.
+ */
+static const ws_str_scan_impl str_scan_simd_impls[] = {
+    WS_STR_SCAN_SSE2,
+    WS_STR_SCAN_AVX2,
+    WS_STR_SCAN_NEON,
+};
+
+#define STR_SCAN_BUF_LEN 72
+
+typedef struct {
+    size_t ascii, printable, unescaped, utf8;
+    size_t utf16[2];
+    uint8_t utf16_out[2][STR_SCAN_BUF_LEN / 2];
+} str_scan_result;
+
+static void str_scan_run(str_scan_result *res, const uint8_t *buf, size_t len)
+{
+    res->ascii = ws_ascii_span(buf, len);
+    res->printable = ws_printable_span(buf, len);
+    res->unescaped = ws_unescaped_span(buf, len);
+    res->utf8 = ws_utf8_span(buf, len);
+    for (int be = 0; be < 2; be++) {
+        res->utf16[be] = ws_utf16_ascii_span(res->utf16_out[be], buf, len / 2, be);
+    }
+}
+
+static void str_scan_compare(const str_scan_result *want, const str_scan_result *have)
+{
+    g_assert_cmpuint(have->ascii, ==, want->ascii);
+    g_assert_cmpuint(have->printable, ==, want->printable);
+    g_assert_cmpuint(have->unescaped, ==, want->unescaped);
+    g_assert_cmpuint(have->utf8, ==, want->utf8);
+    for (int be = 0; be < 2; be++) {
+        g_assert_cmpuint(have->utf16[be], ==, want->utf16[be]);
+        g_assert_true(memcmp(have->utf16_out[be], want->utf16_out[be], want->utf16[be]) == 0);
+    }
+}
+
+/* Offsets at which a sequence crosses a vector boundary */
+static const size_t str_scan_boundary_offsets[] = { 0, 13, 14, 15, 29, 30, 31, 32, 61, 62, 63 };
+static const size_t str_scan_quad_offsets[] = { 13, 30 };
+
+/* Put seq in a buffer of ASCII at each of the offsets, or at every
+ * offset if there are none, and check it with every implementation
+ * this processor supports. */
+static void str_scan_check_seq(const uint8_t *seq, size_t seq_len,
+                               const size_t *offsets, size_t num_offsets)
+{
+    uint8_t buf[STR_SCAN_BUF_LEN];
+    str_scan_result want, have;
+    size_t off, lens[2];
+
+    if (offsets == NULL)
+        num_offsets = STR_SCAN_BUF_LEN - seq_len + 1;
+    for (size_t i = 0; i < num_offsets; i++) {
+        off = offsets ? offsets[i] : i;
+        memset(buf, 'a', sizeof(buf));
+        memcpy(buf + off, seq, seq_len);
+        lens[0] = sizeof(buf);
+        lens[1] = off + seq_len - 1;
+        for (int l = 0; l < 2; l++) {
+            ws_str_scan_select(WS_STR_SCAN_PORTABLE);
+            str_scan_run(&want, buf, lens[l]);
+            for (size_t impl = 0; impl < G_N_ELEMENTS(str_scan_simd_impls); impl++) {
+                if (!ws_str_scan_select(str_scan_simd_impls[impl]))
+                    continue;
+                str_scan_run(&have, buf, lens[l]);
+                str_scan_compare(&want, &have);
+            }
+        }
+    }
+    ws_str_scan_select(WS_STR_SCAN_BEST);
+}
+
+/* Bytes at the edges of the ranges in table 3-7 of the Unicode
+ * Standard, and the ones that must be escaped. */
+static const uint8_t str_scan_edge_bytes[] = {
+    0x00, 0x09, 0x1f, 0x20, 0x22, 0x41, 0x5c, 0x7e, 0x7f,
+    0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0, 0xc1, 0xc2, 0xdf,
+    0xe0, 0xe1, 0xec, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf3, 0xf4,
+    0xf5, 0xff,
+};
+
+static void test_str_scan_pairs(void)
+{
+    uint8_t seq[2];
+
+    for (unsigned i = 0; i < 0x10000; i++) {
+        seq[0] = i >> 8;
+        seq[1] = i & 0xff;
+        str_scan_check_seq(seq, sizeof(seq), str_scan_boundary_offsets,
+                           G_N_ELEMENTS(str_scan_boundary_offsets));
+    }
+}
+
+static void test_str_scan_edges(void)
+{
+    const size_t n = G_N_ELEMENTS(str_scan_edge_bytes);
+    uint8_t seq[4];
+
+    for (size_t a = 0; a < n; a++) {
+        for (size_t b = 0; b < n; b++) {
+            for (size_t c = 0; c < n; c++) {
+                for (size_t d = 0; d < n; d++) {
+                    seq[0] = str_scan_edge_bytes[a];
+                    seq[1] = str_scan_edge_bytes[b];
+                    seq[2] = str_scan_edge_bytes[c];
+                    seq[3] = str_scan_edge_bytes[d];
+                    str_scan_check_seq(seq, sizeof(seq), str_scan_quad_offsets,
+                                       G_N_ELEMENTS(str_scan_quad_offsets));
+                }
+            }
+        }
+    }
+}
+
+/* Every three byte sequence at every offset. */
+static void test_str_scan_triples(void)
+{
+    uint8_t seq[3];
+
+    for (unsigned i = 0; i < 0x1000000; i++) {
+        seq[0] = i >> 16;
+        seq[1] = (i >> 8) & 0xff;
+        seq[2] = i & 0xff;
+        str_scan_check_seq(seq, sizeof(seq), NULL, 0);
+    }
+}
+
+/* The string routines that use the scanning routines give the same
+ * results with each implementation. */
+static void test_str_scan_strings(void)
+{
+    static const char *pieces[] = {
+        "abc", " ", "\"", "\\", "\t", "\n", "\001", "\x7f",
+        u8"\u00e9", u8"\u20ac", u8"\U0001f600", u8"\ufeff",
+        "\xc0\x80", "\xe0\x9f\xbf", "\xed\xa0\x80", "\xf4\x90\x80\x80",
+        "\xe2\x82", "\xf0\x9f\x98", "\x80", "\xff",
+    };
+    GRand *rand = g_rand_new_with_seed(42);
+    GString *str = g_string_new(NULL);
+    char *want[3], *have[3];
+
+    for (int i = 0; i < 20000; i++) {
+        g_string_truncate(str, 0);
+        for (int j = g_rand_int_range(rand, 0, 40); j > 0; j--) {
+            if (g_rand_boolean(rand))
+                g_string_append(str, "The quick brown fox jumps over the lazy dog");
+            else
+                g_string_append(str, pieces[g_rand_int_range(rand, 0, G_N_ELEMENTS(pieces))]);
+        }
+
+        ws_str_scan_select(WS_STR_SCAN_PORTABLE);
+        want[0] = (char *)ws_utf8_make_valid(NULL, (const uint8_t *)str->str, str->len);
+        want[1] = format_text(NULL, str->str, str->len);
+        want[2] = ws_escape_string_len(NULL, str->str, str->len, true);
+        for (size_t impl = 0; impl < G_N_ELEMENTS(str_scan_simd_impls); impl++) {
+            if (!ws_str_scan_select(str_scan_simd_impls[impl]))
+                continue;
+            have[0] = (char *)ws_utf8_make_valid(NULL, (const uint8_t *)str->str, str->len);
+            have[1] = format_text(NULL, str->str, str->len);
+            have[2] = ws_escape_string_len(NULL, str->str, str->len, true);
+            for (int k = 0; k < 3; k++) {
+                g_assert_cmpstr(have[k], ==, want[k]);
+                wmem_free(NULL, have[k]);
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            wmem_free(NULL, want[k]);
+        }
+    }
+    ws_str_scan_select(WS_STR_SCAN_BEST);
+
+    g_string_free(str, TRUE);
+    g_rand_free(rand);
+}
+
 #include "to_str.h"
 
 static void test_word_to_hex(void)
@@ -837,6 +1022,14 @@ int main(int argc, char **argv)
         g_test_add_func("/str_util/format_text_perf", test_format_text_perf);
     }
 
+    g_test_add_func("/str_scan/pairs", test_str_scan_pairs);
+    g_test_add_func("/str_scan/edges", test_str_scan_edges);
+    g_test_add_func("/str_scan/strings", test_str_scan_strings);
+
+    if (g_test_slow()) {
+        g_test_add_func("/str_scan/triples", test_str_scan_triples);
+    }
+
     g_test_add_func("/to_str/word_to_hex", test_word_to_hex);
     g_test_add_func("/to_str/bytes_to_str", test_bytes_to_str);
     g_test_add_func("/to_str/bytes_to_str_punct", test_bytes_to_str_punct);
@@ -20,6 +20,7 @@
 #include <sys/resource.h>
 #else
 #include <windows.h>
+#include <psapi.h>
 #endif
 
 /* Test if the given year is a leap year */
@@ -174,6 +175,28 @@ void get_resource_usage(double *user_time, double *sys_time) {
 #endif /* _WIN32 */
 }
 
+uint64_t get_peak_memory_usage(void) {
+#ifndef _WIN32
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) != 0)
+		return 0;
+#ifdef __APPLE__
+	/* ru_maxrss is in bytes on macOS */
+	return (uint64_t)ru.ru_maxrss;
+#else
+	/* and in kilobytes elsewhere */
+	return (uint64_t)ru.ru_maxrss * 1024;
+#endif
+#else /* _WIN32 */
+	PROCESS_MEMORY_COUNTERS pmc;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return (uint64_t)pmc.PeakWorkingSetSize;
+#endif /* _WIN32 */
+}
+
 static double last_user_time = 0.0;
 static double last_sys_time = 0.0;
 
@@ -280,6 +303,29 @@ ws_clock_get_realtime(struct timespec *ts)
 #endif
 }
 
+uint64_t
+ws_clock_get_monotonic_ns(void)
+{
+#if defined(_WIN32)
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000 +
+		(uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000 / frequency.QuadPart;
+#else
+#if defined(HAVE_CLOCK_GETTIME)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+#endif
+	return (uint64_t)g_get_monotonic_time() * 1000;
+#endif
+}
+
 struct tm *
 ws_localtime_r(const time_t *timep, struct tm *result)
 {
@@ -56,6 +56,14 @@ void get_resource_usage(double *user_time, double *sys_time);
 WS_DLL_PUBLIC
 void log_resource_usage(bool reset_delta, const char *format, ...);
 
+/** Fetch the peak resident set size of the process.
+ *
+ * @return The largest amount of physical memory used by the process so far,
+ * in bytes, or 0 if it isn't available.
+ */
+WS_DLL_PUBLIC
+uint64_t get_peak_memory_usage(void);
+
 /**
  * Fetch the number of microseconds since midnight (0 hour), January 1, 1970.
  */
@@ -68,6 +76,13 @@ void ws_tzset(void);
 WS_DLL_PUBLIC
 struct timespec *ws_clock_get_realtime(struct timespec *ts);
 
+/**
+ * Fetch the value of a monotonic clock in nanoseconds, for measuring
+ * short intervals. The starting point is unspecified.
+ */
+WS_DLL_PUBLIC
+uint64_t ws_clock_get_monotonic_ns(void);
+
 WS_DLL_PUBLIC
 struct tm *ws_localtime_r(const time_t *timep, struct tm *result);
 
@@ -12,6 +12,8 @@
 
 #include "unicode-utils.h"
 
+#include "str_scan.h"
+
 int ws_utf8_seqlen[256] = {
     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 0x00...0x0f */
     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 0x10...0x1f */
@@ -47,10 +49,20 @@ utf_8_validate(const uint8_t *start, ssize_t length, const uint8_t **end)
 {
     const uint8_t *ptr = start;
     uint8_t ch;
-    size_t unichar_len, valid_bytes = 0;
+    size_t unichar_len, valid_bytes = 0, span;
 
     while (length > 0) {
 
+        /* Skip over the well-formed characters a vector at a time;
+         * what follows them, if anything, is an ill-formed one. */
+        span = ws_utf8_span(ptr, length);
+        valid_bytes += span;
+        ptr += span;
+        length -= span;
+        if (length == 0) {
+            break;
+        }
+
         ch = *ptr;
 
         if (ch < 0x80) {
@@ -42,6 +42,10 @@ struct _wmem_allocator_t {
     void                        *private_data;
     enum _wmem_allocator_type_t  type;
     bool                         in_scope;
+
+    /* Statistics, see wmem_get_allocation_stats() */
+    uint64_t                     alloc_count;
+    uint64_t                     alloc_bytes;
 };
 
 #ifdef __cplusplus
@@ -41,6 +41,9 @@ wmem_alloc(wmem_allocator_t *allocator, const size_t size)
         return NULL;
     }
 
+    allocator->alloc_count++;
+    allocator->alloc_bytes += size;
+
     return allocator->walloc(allocator->private_data, size);
 }
 
@@ -93,6 +96,9 @@ wmem_realloc(wmem_allocator_t *allocator, void *ptr, const size_t size)
 
     ws_assert(allocator->in_scope);
 
+    allocator->alloc_count++;
+    allocator->alloc_bytes += size;
+
     return allocator->wrealloc(allocator->private_data, ptr, size);
 }
 
@@ -142,6 +148,8 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     allocator->type      = real_type;
     allocator->callbacks = NULL;
     allocator->in_scope  = true;
+    allocator->alloc_count = 0;
+    allocator->alloc_bytes = 0;
 
     switch (real_type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -164,6 +172,17 @@ wmem_allocator_new(const wmem_allocator_type_t type)
     return allocator;
 }
 
+void
+wmem_get_allocation_stats(wmem_allocator_t *allocator, uint64_t *count, uint64_t *bytes)
+{
+    if (count) {
+        *count = allocator->alloc_count;
+    }
+    if (bytes) {
+        *bytes = allocator->alloc_bytes;
+    }
+}
+
 void
 wmem_init(void)
 {
@@ -203,6 +203,20 @@ WS_DLL_PUBLIC
 wmem_allocator_t *
 wmem_allocator_new(const wmem_allocator_type_t type);
 
+/** Get the number of allocations and reallocations made from an allocator
+ * since it was created, and the total number of bytes requested by them.
+ * Memory returned by wmem_free() or wmem_free_all() is not subtracted, so
+ * callers interested in a period of time should take the difference of two
+ * readings.
+ *
+ * @param allocator The allocator to get the statistics of.
+ * @param count If not NULL, set to the number of allocations.
+ * @param bytes If not NULL, set to the number of bytes requested.
+ */
+WS_DLL_PUBLIC
+void
+wmem_get_allocation_stats(wmem_allocator_t *allocator, uint64_t *count, uint64_t *bytes);
+
 /** Initialize the wmem subsystem. This must be called before any other wmem
  * function, usually at the very beginning of your program.
  */
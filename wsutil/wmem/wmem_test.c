@@ -43,6 +43,8 @@ wmem_allocator_force_new(const wmem_allocator_type_t type)
     allocator->type = type;
     allocator->callbacks = NULL;
     allocator->in_scope = true;
+    allocator->alloc_count = 0;
+    allocator->alloc_bytes = 0;
 
     switch (type) {
         case WMEM_ALLOCATOR_SIMPLE:
@@ -369,6 +371,35 @@ wmem_test_allocator_strict(void)
     wmem_test_allocator_jumbo(WMEM_ALLOCATOR_STRICT, &wmem_strict_check_canaries);
 }
 
+static void
+wmem_test_allocator_stats(void)
+{
+    wmem_allocator_t *allocator;
+    uint64_t          count, bytes;
+    void             *ptr;
+
+    allocator = wmem_allocator_new(WMEM_ALLOCATOR_BLOCK_FAST);
+
+    wmem_get_allocation_stats(allocator, &count, &bytes);
+    g_assert_cmpuint(count, ==, 0);
+    g_assert_cmpuint(bytes, ==, 0);
+
+    ptr = wmem_alloc(allocator, 8);
+    wmem_alloc(allocator, 0);
+    ptr = wmem_realloc(allocator, ptr, 24);
+    wmem_free(allocator, ptr);
+    wmem_get_allocation_stats(allocator, &count, &bytes);
+    g_assert_cmpuint(count, ==, 2);
+    g_assert_cmpuint(bytes, ==, 32);
+
+    wmem_free_all(allocator);
+    wmem_strdup(allocator, "ABC");
+    wmem_get_allocation_stats(allocator, &count, NULL);
+    g_assert_cmpuint(count, ==, 3);
+
+    wmem_destroy_allocator(allocator);
+}
+
 /* UTILITY TESTING FUNCTIONS (/wmem/utils/) */
 
 static void
@@ -1457,6 +1488,7 @@ main(int argc, char **argv)
     g_test_add_func("/wmem/allocator/simple",    wmem_test_allocator_simple);
     g_test_add_func("/wmem/allocator/strict",    wmem_test_allocator_strict);
     g_test_add_func("/wmem/allocator/callbacks", wmem_test_allocator_callbacks);
+    g_test_add_func("/wmem/allocator/stats",     wmem_test_allocator_stats);
 
     g_test_add_func("/wmem/utils/misc",    wmem_test_miscutls);
     g_test_add_func("/wmem/utils/strings", wmem_test_strutls);
@@ -53,7 +53,7 @@ ws_cpuid(uint32_t *CPUInfo, uint32_t selector)
 	/* https://docs.microsoft.com/en-us/cpp/intrinsics/cpuid-cpuidex */
 
 	CPUInfo[0] = CPUInfo[1] = CPUInfo[2] = CPUInfo[3] = 0;
-	__cpuid((int *) CPUInfo, selector);
+	__cpuidex((int *) CPUInfo, selector, 0);
 	/* XXX, how to check if it's supported on MSVC? just in case clear all flags above */
 	return true;
 }
@@ -128,7 +128,7 @@ ws_cpuid(uint32_t *CPUInfo _U_, int selector _U_)
 }
 #endif
 
-static int
+static inline int
 ws_cpuid_sse42(void)
 {
 	uint32_t CPUInfo[4];
@@ -139,3 +139,64 @@ ws_cpuid_sse42(void)
 	/* in ECX bit 20 toggled on */
 	return (CPUInfo[2] & (1 << 20));
 }
+
+/*
+ * Get the low 32 bits of extended control register 0, which say what
+ * register state the OS saves on a context switch; 0 if we can't tell.
+ * Only valid if CPUID says that OSXSAVE is enabled.
+ */
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <immintrin.h>
+
+static inline uint32_t
+ws_xgetbv0(void)
+{
+	return (uint32_t) _xgetbv(0);
+}
+#elif defined(__GNUC__) && defined(__x86_64__)
+static inline uint32_t
+ws_xgetbv0(void)
+{
+	uint32_t eax, edx;
+
+	/* The XGETBV opcode, for assemblers that don't know it */
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0"
+						: "=a" (eax),
+							"=d" (edx)
+						: "c" (0));
+	return eax;
+}
+#else
+static inline uint32_t
+ws_xgetbv0(void)
+{
+	return 0;
+}
+#endif
+
+static inline int
+ws_cpuid_avx2(void)
+{
+	uint32_t CPUInfo[4];
+	const uint32_t osxsave_avx = (1 << 27) | (1 << 28);
+
+	if (!ws_cpuid(CPUInfo, 0) || CPUInfo[0] < 7)
+		return 0;
+
+	if (!ws_cpuid(CPUInfo, 1))
+		return 0;
+
+	/* in ECX bits 27 (OSXSAVE) and 28 (AVX) toggled on */
+	if ((CPUInfo[2] & osxsave_avx) != osxsave_avx)
+		return 0;
+
+	/* and the OS saves the XMM and YMM registers */
+	if ((ws_xgetbv0() & 0x6) != 0x6)
+		return 0;
+
+	if (!ws_cpuid(CPUInfo, 7))
+		return 0;
+
+	/* in EBX bit 5 toggled on */
+	return (CPUInfo[1] & (1 << 5));
+}